@@ -24,6 +24,7 @@
 #include "ModelEditLanguage.h"
 #include "CPUMatrix.h" // used for SetNumThreads()
 #include "CommonMatrix.h"
+#include "ConvolutionEngine.h" // for ConvolutionEngineAutotuner
 #include "SGD.h"
 #include "MPIWrapper.h"
 #include "EnvironmentUtil.h"
@@ -536,7 +537,11 @@ int wmainWithBS(int argc, wchar_t* argv[]) // called from wmain which is a wrapp
     }  
 
     Globals::SetShareNodeValueMatrices(config(L"shareNodeValueMatrices", true));
+    Globals::SetMemoryArena(config(L"memoryArena", false));
+    Globals::SetRecurrentLoopOptimization(config(L"optimizeRecurrentLoops", false));
     Globals::SetGradientAccumulationOptimization(config(L"optimizeGradientAccumulation", true));
+    if (config(L"autotuneConvolution", false))
+        ConvolutionEngineAutotuner::Enable(config(L"convolutionAutotuneCache", L""));
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
@@ -688,7 +693,11 @@ int wmainOldCNTKConfig(int argc, wchar_t* argv[])
     } 
 
     Globals::SetShareNodeValueMatrices(config(L"shareNodeValueMatrices", true));
+    Globals::SetMemoryArena(config(L"memoryArena", false));
+    Globals::SetRecurrentLoopOptimization(config(L"optimizeRecurrentLoops", false));
     Globals::SetGradientAccumulationOptimization(config(L"optimizeGradientAccumulation", true));
+    if (config(L"autotuneConvolution", false))
+        ConvolutionEngineAutotuner::Enable(config(L"convolutionAutotuneCache", L""));
 
     TracingGPUMemoryAllocator::SetTraceLevel(config(L"traceGPUMemoryAllocations", 0));
 
@@ -661,6 +661,7 @@ namespace CNTK
     {
         friend class CompositeFunction;
         friend class Utils;
+        friend class Learners;
         friend class LearnerBase;
         friend class Variable;
         friend class Value;
@@ -670,6 +671,7 @@ namespace CNTK
         friend class BlockMomentumDistributedLearner;
         friend class Internal::VariableResolver;
         friend class Trainer;
+        friend class MappedModel;
 
         template <typename T, typename ...CtorArgTypes>
         friend inline std::shared_ptr<T> MakeSharedObject(CtorArgTypes&& ...ctorArgs);
@@ -2097,6 +2099,9 @@ private:
 
         CNTK_API static Variable Deserialize(const Dictionary& dictionary, const ::CNTK::DeviceDescriptor& device = DeviceDescriptor::UseDefaultDevice());
 
+        // 'mappedValues' are the values of Parameters and Constants by uid, for the dictionaries without one, see MappedModel.
+        static Variable Deserialize(const Dictionary& dictionary, const ::CNTK::DeviceDescriptor& device, const std::unordered_map<std::wstring, NDArrayViewPtr>& mappedValues);
+
         void SetOwner(const std::weak_ptr<Function>& ownerFunction);
 
         Variable CompositePreservingCopy(const std::shared_ptr<const Function>& composite) const;
@@ -3161,6 +3166,13 @@ namespace CNTK
         /// ONNX support limited subset of CNTK.
         ///
         ONNX,
+
+        ///
+        /// CNTK version 2 format with the values of Parameters and Constants stored as aligned raw blobs after the graph.
+        /// When loading on the CPU, the file is memory mapped and these values are used in place, so that loading is
+        /// nearly instant and processes loading the same file share its memory. Loading with CNTKv2 recognizes it, too.
+        ///
+        CNTKv2Mapped,
     };
 
 
@@ -4434,6 +4446,15 @@ namespace CNTK
         const Constant& noiseWeights, size_t numSamples, bool allowDuplicates=true, unsigned long seed = SentinelValueForAutoSelectRandomSeed,
         const std::wstring& name = L"");
 
+    ///
+    /// Create an instance of the CNTK built-in sampled softmax cross entropy loss for specified operands. Per minibatch, numSamples
+    /// classes are drawn with replacement in proportion to samplingWeights, and the softmax is computed over the label and these
+    /// classes only, with the logits corrected by the log of the expected number of draws of each class. weights are of shape
+    /// [inputs x classes]; when labels are sparse, their gradient only has the columns of the label and sampled classes.
+    ///
+    CNTK_API FunctionPtr SampledCrossEntropyWithSoftmax(const Variable& weights, const Variable& inputs, const Variable& labels, const Variable& samplingWeights,
+        size_t numSamples, unsigned long seed = SentinelValueForAutoSelectRandomSeed, const std::wstring& name = L"");
+
     ///
     /// Create an instance of the CNTK built-in Depth-to-Space operation for an operand and specified blockSize.
     ///
@@ -5086,6 +5107,9 @@ namespace CNTK
         TrainingParameterSchedule<double> gaussianNoiseInjectionStdDev = 0.0;
         double gradientClippingThresholdPerSample = std::numeric_limits<double>::infinity();
         bool gradientClippingWithTruncation = true;
+        // Update all parameters of the learner in one pass over a contiguous buffer of the learner's state, when they are dense on the CPU.
+        // The time per update is then reported to the progress writers.
+        bool fusedUpdate = false;
 
         Dictionary dictOptions;
     };
@@ -5164,6 +5188,25 @@ namespace CNTK
 
         virtual void SetNeedToUpdateMasterParameter() { NOT_IMPLEMENTED }
 
+        ///
+        /// Sets the loss scale that the gradients passed to Update() are multiplied with, see Trainer::SetLossScaling().
+        /// Learners that do not support loss scaling ignore this, see SupportsLossScaling().
+        ///
+        virtual void SetLossScale(double /*lossScale*/) {}
+
+        ///
+        /// Returns true if the learner undoes the loss scale set by SetLossScale() itself and implements SkipNextUpdate().
+        /// Otherwise the Trainer divides the gradients by the loss scale before passing them to Update(), and does not
+        /// allow dynamic loss scaling.
+        ///
+        virtual bool SupportsLossScaling() const { return false; }
+
+        ///
+        /// Makes the next Update() count its samples without applying the gradients. With dynamic loss scaling, the Trainer
+        /// calls this for all learners if the gradients of any of them overflowed.
+        ///
+        virtual void SkipNextUpdate() {}
+
         ///
         /// Returns current learning rate.
         ///
@@ -5395,6 +5438,21 @@ namespace CNTK
             m_learner->ResetSmoothedGradients();
         }
 
+        void SetLossScale(double lossScale) override
+        {
+            m_learner->SetLossScale(lossScale);
+        }
+
+        bool SupportsLossScaling() const override
+        {
+            return m_learner->SupportsLossScaling();
+        }
+
+        void SkipNextUpdate() override
+        {
+            m_learner->SkipNextUpdate();
+        }
+
         //
         // Returns the total number of samples needed for warmup.
         // After reaching this number of samples the learner switches to the distributed mode.
@@ -5607,6 +5665,88 @@ namespace CNTK
     ///
     CNTK_API EvaluatorPtr CreateEvaluator(const FunctionPtr& evaluationFunction, const std::vector<ProgressWriterPtr>& progressWriters = {});
 
+    ///
+    /// Configuration of an EvaluationEngine.
+    ///
+    struct EvaluationEngineConfig
+    {
+        ///
+        /// Number of worker contexts, i.e. the number of minibatches that are evaluated concurrently.
+        /// The workers share the parameters of the model; each of them has its own activations and MBLayouts.
+        ///
+        size_t numWorkers{ 1 };
+
+        ///
+        /// Dynamic batching: the maximum number of sequences of concurrent requests that are merged into one minibatch.
+        /// Values less than 2 switch dynamic batching off.
+        /// The sequence outputs of a merged minibatch are unpacked to split them by request, which fails
+        /// while Internal::SetAutomaticUnpackingOfPackedValues() disables automatic unpacking.
+        ///
+        size_t maxBatchSize{ 1 };
+
+        ///
+        /// Dynamic batching: the maximum time a request waits for other requests to be merged with.
+        ///
+        size_t maxBatchingDelayInMicroseconds{ 1000 };
+
+        ///
+        /// Number of most recently completed requests the latency percentiles are computed over.
+        ///
+        size_t latencyWindow{ 10000 };
+    };
+
+    ///
+    /// Request and latency statistics of an EvaluationEngine.
+    /// Latencies are measured from the submission of a request to the availability of its outputs.
+    ///
+    struct EvaluationEngineStatistics
+    {
+        size_t numRequests{ 0 };    // requests completed
+        size_t numMinibatches{ 0 }; // minibatches evaluated for them
+        double meanLatencyInMilliseconds{ 0 };
+        double latencyP50InMilliseconds{ 0 };
+        double latencyP90InMilliseconds{ 0 };
+        double latencyP99InMilliseconds{ 0 };
+        double maxLatencyInMilliseconds{ 0 };
+    };
+
+    ///
+    /// Evaluates a model for concurrent requests. Evaluate() and EvaluateAsync() can be called from any number of threads.
+    /// Requests are evaluated by a fixed number of worker contexts that share one copy of the model parameters,
+    /// so serving more requests concurrently does not multiply the memory needed for the parameters.
+    /// Optionally, small concurrent requests are merged into one minibatch, see EvaluationEngineConfig.
+    ///
+    class EvaluationEngine
+    {
+    public:
+        ///
+        /// Evaluates the model for the specified 'arguments' and returns the values of the requested 'outputs'.
+        /// The arguments and outputs are Variables of the model passed to CreateEvaluationEngine().
+        /// Output values that are null are allocated, others are overwritten.
+        ///
+        CNTK_API void Evaluate(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputs);
+
+        ///
+        /// Submits a request and returns without waiting for its outputs.
+        ///
+        CNTK_API virtual std::future<std::unordered_map<Variable, ValuePtr>> EvaluateAsync(const std::unordered_map<Variable, ValuePtr>& arguments, const std::vector<Variable>& outputs) = 0;
+
+        ///
+        /// Returns the statistics of the requests completed so far.
+        ///
+        CNTK_API virtual EvaluationEngineStatistics Statistics() const = 0;
+
+        ///
+        /// Completes the pending requests and stops the workers.
+        ///
+        CNTK_API virtual ~EvaluationEngine() {}
+    };
+
+    ///
+    /// Construct an EvaluationEngine for the specified model.
+    ///
+    CNTK_API EvaluationEnginePtr CreateEvaluationEngine(const FunctionPtr& model, const DeviceDescriptor& device = DeviceDescriptor::UseDefaultDevice(), const EvaluationEngineConfig& config = EvaluationEngineConfig());
+
     enum class DataUnit : unsigned int
     {
         ///Indiciate that the frequency of action is counted by sweep.
@@ -5655,11 +5795,37 @@ namespace CNTK
         ///
         CNTK_API void SaveCheckpoint(const std::wstring& filePath, Dictionary externalState = Dictionary());
 
+        ///
+        /// Same as SaveCheckpoint, but only takes a snapshot of the model and Trainer state in host memory before returning;
+        /// the files are written, synced to disk and renamed to their final names on a background thread.
+        /// At most one checkpoint is written at a time: the next call first waits for the pending one.
+        ///
+        CNTK_API void SaveCheckpointAsync(const std::wstring& filePath, Dictionary externalState = Dictionary());
+
+        ///
+        /// Wait until the checkpoint of the last SaveCheckpointAsync call is on disk. Errors of writing it are thrown here.
+        ///
+        CNTK_API void WaitForPendingCheckpoint();
+
         ///
         /// Restore the model and trainer state from a previously saved model and checkpoint from the specified file location
         ///
         CNTK_API Dictionary RestoreFromCheckpoint(const std::wstring& filePath);
 
+        ///
+        /// Enables loss scaling for training with Float16 parameters: the gradients are computed for the loss multiplied with
+        /// 'lossScale', so that small gradients do not flush to zero, and the learners divide them by it again.
+        /// With 'dynamic', a minibatch whose gradients overflowed is not applied by any learner and the loss scale is halved;
+        /// it is doubled after 'growthInterval' minibatches without overflow. This requires all learners to support loss
+        /// scaling, see Learner::SupportsLossScaling().
+        ///
+        CNTK_API void SetLossScaling(double lossScale, bool dynamic = true, size_t growthInterval = 2000);
+
+        ///
+        /// Returns the current loss scale, which is 1 unless loss scaling is enabled.
+        ///
+        double LossScale() const { return m_lossScale; }
+
         ///
         /// Model being trained by 'this' Trainer.
         ///
@@ -5730,11 +5896,14 @@ namespace CNTK
         bool TrainLocalMinibatch(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, bool sweepEnd, const DeviceDescriptor& computeDevice);
         bool TrainDistributedMinibatch(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, bool sweepEnd, const DeviceDescriptor& computeDevice);
 
+        void SaveCheckpoint(const std::wstring& modelFilePath, const Dictionary& externalState, bool asynchronous);
+
         void Save(const std::wstring& modelFilePath, const std::vector<DictionaryValue>& learnerState,
-            const Dictionary& externalState, const Dictionary& distributedState = {});
+            const Dictionary& externalState, const Dictionary& distributedState = {}, bool asynchronous = false);
 
         void UpdateTrainingProgress(size_t numSamples, const ValuePtr& loss, const ValuePtr& evalCriterion, const DeviceDescriptor& computeDevice);
         void AddProgressWriters(const std::vector<ProgressWriterPtr>& progressWriters);
+        void UpdateLossScale();
 
         FunctionPtr m_model;
         FunctionPtr m_combinedTrainingFunction;
@@ -5755,6 +5924,13 @@ namespace CNTK
         AccumulatorPtr m_aggregatedTrainingEvalCriterionValue;
 
         size_t m_prevDistributedTotalNumSamples;
+
+        std::shared_ptr<Microsoft::MSR::CNTK::AsyncCheckpointWriter> m_checkpointWriter; // created by the first SaveCheckpointAsync
+
+        double m_lossScale;
+        bool   m_dynamicLossScaling;
+        size_t m_lossScaleGrowthInterval;
+        size_t m_numMinibatchesSinceLossScaleChange;
     };
 
     ///
@@ -5986,6 +6162,13 @@ namespace CNTK
         ///
         Internal::Optional<bool> isMultithreaded;
 
+        ///
+        /// Specifies how many minibatches are prefetched ahead of GetNextMinibatch(), and the number of threads prefetching them.
+        /// A deeper prefetch absorbs hiccups of the deserialization at the cost of memory for the prefetched minibatches.
+        ///
+        size_t prefetchDepth{ 1 };
+        size_t numPrefetchThreads{ 1 };
+
         ///
         /// Deserializers to be used in the composite reader.
         ///
@@ -6267,6 +6450,15 @@ namespace CNTK
     ///
     CNTK_API DistributedCommunicatorPtr MPICommunicator(size_t packThresholdSizeInBytes = Internal::GetMPIPackThreshold(), bool useFP16AllReduce = false);
 
+    ///
+    /// Built-in MPI-based communicator for many workers per node, which aggregates the values on the CPU hierarchically:
+    /// the workers of each node reduce their values through shared memory, one worker per node all-reduces the sums
+    /// with the other nodes in a ring, and the workers of each node read the result back from shared memory.
+    /// The nodes are the hosts of the workers or, if ranksPerNode is not 0, blocks of ranksPerNode consecutive ranks
+    /// (e.g. to simulate several nodes on one host). Values aggregated with NCCL or GPUDirect RDMA are aggregated as by MPICommunicator().
+    ///
+    CNTK_API DistributedCommunicatorPtr HierarchicalMPICommunicator(size_t packThresholdSizeInBytes = Internal::GetMPIPackThreshold(), size_t ranksPerNode = 0);
+
     ///
     /// Distributed communicator that allows quantized aggregations.
     ///
@@ -6312,13 +6504,16 @@ namespace CNTK
         /// checkpointFrequencyInSamples: frequency in samples when to perform checkpointing.
         /// restoreFromCheckpointIfExists: if flag is set, the training session will try to restore before training.
         /// preserveAllCheckpoints: if flag is set, all checkpoints will be preserved.
+        /// asynchronous: if flag is set, periodic checkpoints are written to disk in the background while training
+        ///               continues, see Trainer::SaveCheckpointAsync.
         ///
         CNTK_API CheckpointConfig(
             const std::wstring& checkPointFileName,
             size_t checkpointFrequency = std::numeric_limits<size_t>::max(),
             DataUnit checkpointFrequencyUnit = DataUnit::Sample,
             bool restoreFromCheckpointIfExists = true,
-            bool preserveAllCheckpoints = false);
+            bool preserveAllCheckpoints = false,
+            bool asynchronous = false);
 
     private:
         friend class TrainingSession;
@@ -6327,6 +6522,7 @@ namespace CNTK
         const bool m_preserveAll;
         const size_t m_frequency;
         const DataUnit m_frequencyUnit;
+        const bool m_asynchronous;
     };
 
     ///
@@ -62,6 +62,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
     typedef std::shared_ptr<ComputationNodeBase> ComputationNodeBasePtr;
 
     struct GpuData;
+
+    class AsyncCheckpointWriter;
 }}}
 
 // TODO: The following should be reconciled with the equivalent code in the CNTK implementation
@@ -156,6 +158,7 @@ namespace CNTK
     class DeviceDescriptor;
     enum class PrimitiveOpType : unsigned int;
     enum class DataType : unsigned int;
+    enum class ModelFormat;
 
     struct MinibatchInfo;
     struct MinibatchData;
@@ -214,6 +217,9 @@ namespace CNTK
     class Evaluator;
     typedef std::shared_ptr<Evaluator> EvaluatorPtr;
 
+    class EvaluationEngine;
+    typedef std::shared_ptr<EvaluationEngine> EvaluationEnginePtr;
+
     class Trainer;
     typedef std::shared_ptr<Trainer> TrainerPtr;
 
@@ -303,6 +309,12 @@ namespace CNTK
         CNTK_API void UseSparseGradientAggregationInDataParallelSGD(bool enable);
         CNTK_API bool ShouldUseSparseGradientAggregationInDataParallelSGD();
 
+        CNTK_API void OptimizeRecurrentLoops(bool enable);
+        CNTK_API bool ShouldOptimizeRecurrentLoops();
+
+        CNTK_API void FuseElementwiseOperations(bool enable);
+        CNTK_API bool ShouldFuseElementwiseOperations();
+
         CNTK_API unsigned long GetRandomSeed();
         CNTK_API void SetFixedRandomSeed(unsigned long value);
         CNTK_API bool IsRandomSeedFixed();
@@ -312,6 +324,9 @@ namespace CNTK
         CNTK_API void EnableForwardValuesSharing();
         CNTK_API void DisableForwardValuesSharing();
 
+        CNTK_API void EnableMemoryArena();
+        CNTK_API void DisableMemoryArena();
+
         CNTK_API void EnableGradientAccumulationOptimization();
         CNTK_API void DisableGradientAccumulationOptimization();
 
@@ -327,9 +342,16 @@ namespace CNTK
         CNTK_API void EnableCPUEvalOptimization();
         CNTK_API void DisableCPUEvalOptimization();
 
+        // Time the CPU convolution engines on first use and keep the fastest per geometry, optionally remembered in cacheFilePath across runs.
+        CNTK_API void EnableConvolutionAutotuning(const std::wstring& cacheFilePath = L"");
+        CNTK_API void DisableConvolutionAutotuning();
+
         CNTK_API void SetMPIPackThreshold(size_t packThesholdInBytes);
         CNTK_API size_t GetMPIPackThreshold();
 
+        // Converts a model file between the CNTKv2 and CNTKv2Mapped formats, without loading its Function graph.
+        CNTK_API void ConvertModel(const std::wstring& sourceFilePath, const std::wstring& targetFilePath, ::CNTK::ModelFormat targetFormat);
+
         CNTK_API bool AreEquivalent(const ::CNTK::FunctionPtr& f1, const ::CNTK::FunctionPtr& f2);
         CNTK_API bool AreEquivalent(const ::CNTK::Variable& v1, const ::CNTK::Variable& v2, bool allowParameterAndConstantsEquivalence = false);
 
@@ -2,12 +2,22 @@
 
 #pragma once
 
+#include <cstddef>
+
+// F16C converts between FP32 and FP16 in hardware. GCC enables it with -mf16c, MSVC with /arch:AVX2.
+#if (defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(__CUDACC__)
+#define CNTK_F16C
+#include <immintrin.h>
+#endif
+
 namespace CNTK {
 
 // Host functions for converting between FP32 and FP16 formats
-// TODO: use f16c instructions if available
 inline void float16ToFloat(const unsigned short* src, float* res)
 {
+#ifdef CNTK_F16C
+    *res = _cvtsh_ss(*src);
+#else
     unsigned h = *src;
     unsigned sign = ((h >> 15) & 1);
     unsigned exponent = ((h >> 10) & 0x1f);
@@ -34,10 +44,14 @@ inline void float16ToFloat(const unsigned short* src, float* res)
     }
 
     *(unsigned*)res = ((sign << 31) | (exponent << 23) | mantissa);
+#endif
 }
 
 inline void floatToFloat16(float* src, unsigned short* dest)
 {
+#ifdef CNTK_F16C
+    *dest = _cvtss_sh(*src, _MM_FROUND_TO_NEAREST_INT);
+#else
     unsigned x = *(unsigned*)src;
     unsigned u = (x & 0x7fffffff), remainder, shift, lsb, lsb_s1, lsb_m1;
     unsigned short sign;
@@ -89,6 +103,33 @@ inline void floatToFloat16(float* src, unsigned short* dest)
     }
 
     *dest = (sign | (unsigned short)((exponent << 10) | mantissa));
+#endif
+}
+
+// Buffer versions of the above, 8 values at a time with F16C
+inline void float16ToFloat(const unsigned short* src, float* res, size_t count)
+{
+    size_t i = 0;
+#ifdef CNTK_F16C
+    for (; i < (count & ~(size_t)7); i += 8)
+        _mm256_storeu_ps(res + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+#endif
+    for (; i < count; i++)
+        float16ToFloat(src + i, res + i);
+}
+
+inline void floatToFloat16(const float* src, unsigned short* dest, size_t count)
+{
+    size_t i = 0;
+#ifdef CNTK_F16C
+    for (; i < (count & ~(size_t)7); i += 8)
+        _mm_storeu_si128((__m128i*)(dest + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for (; i < count; i++)
+    {
+        float f = src[i];
+        floatToFloat16(&f, dest + i);
+    }
 }
 
 }
\ No newline at end of file
@@ -77,6 +77,7 @@ namespace CNTK
         {PrimitiveOpType::Combine, L"Combine"},
         {PrimitiveOpType::RandomSample, L"RandomSample"},
         {PrimitiveOpType::RandomSampleInclusionFrequency, L"RandomSampleInclusionFrequency"},
+        {PrimitiveOpType::SampledCrossEntropyWithSoftmax, L"SampledCrossEntropyWithSoftmax"},
         {PrimitiveOpType::ROIPooling, L"ROIPooling"},
         {PrimitiveOpType::Logistic, L"Logistic"},
         {PrimitiveOpType::OptimizedRNNStack, L"OptimizedRNNStack"},
@@ -258,6 +259,7 @@ namespace CNTK
             return (OpType() == PrimitiveOpType::Dropout) ||
                    (OpType() == PrimitiveOpType::RandomSample) ||
                    (OpType() == PrimitiveOpType::RandomSampleInclusionFrequency) ||
+                   (OpType() == PrimitiveOpType::SampledCrossEntropyWithSoftmax) ||
                    (OpType() == PrimitiveOpType::RandomDistribution);
         }
 
@@ -732,7 +734,8 @@ namespace CNTK
         // Version 22: Add StraightThrough
         // Version 23: Add Tan and Atan.
         // Version 24: Add ConvolutionSequenceShape.
-        static const size_t s_serializationVersion = 24;
+        // Version 25: Add SampledCrossEntropyWithSoftmax.
+        static const size_t s_serializationVersion = 25;
     };
 
     std::vector<DictionaryValue> GetInputUids(const Function& f);
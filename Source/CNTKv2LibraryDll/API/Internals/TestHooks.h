@@ -0,0 +1,22 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include "CNTKLibrary.h"
+
+//
+// Functions that the unit tests of the library use to look into its internals.
+// They are exported, but they are not part of the API and this header is not shipped with it.
+//
+namespace CNTK
+{
+    namespace Internal
+    {
+        // The operation names of the nodes of the computation network that the Function was compiled into
+        // when it was first evaluated, e.g. to see which nodes were fused. Empty if it was not evaluated yet.
+        CNTK_API std::vector<std::wstring> ComputationNodeOperationNames(const FunctionPtr& rootFunction);
+    }
+}
@@ -236,6 +236,13 @@ namespace CNTK
 
                     opType = PrimitiveOpType::RandomSampleInclusionFrequency;
                 }
+                else if (node->OperationName() == OperationNameOf(SampledCrossEntropyWithSoftmaxNode))
+                {
+                    auto sampledCrossEntropyWithSoftmaxNode = node->As<SampledCrossEntropyWithSoftmaxNode<ElementType>>();
+                    primitiveFunctionConfigParameters[PrimitiveFunctionAttribute::AttributeNameNumSamples] = sampledCrossEntropyWithSoftmaxNode->GetNumSamples();
+
+                    opType = PrimitiveOpType::SampledCrossEntropyWithSoftmax;
+                }
                 else if (node->OperationName() == OperationNameOf(DropoutNode))
                 {
                     auto dropoutNode = node->As<DropoutNode<ElementType>>();
@@ -691,6 +698,21 @@ namespace CNTK
             computationNetwork->Save(modelFile);
         }
 
+        std::vector<std::wstring> ComputationNodeOperationNames(const FunctionPtr& rootFunction)
+        {
+            CompositeFunction* compositeFunction = dynamic_cast<CompositeFunction*>(rootFunction.get());
+            if (compositeFunction == nullptr)
+                InvalidArgument("Primitive (i.e. non-composite) Function '%S' has no computation network.", rootFunction->AsString().c_str());
+
+            std::vector<std::wstring> operationNames;
+            if (compositeFunction->m_computationNetwork != nullptr)
+            {
+                for (const auto& node : compositeFunction->m_computationNetwork->GetAllNodes())
+                    operationNames.push_back(node->OperationName());
+            }
+            return operationNames;
+        }
+
         LegacyModelDataType DetectLegacyModelDataType(const std::wstring& modelFile)
         {
             File fstream(modelFile, FileOptions::fileOptionsBinary | FileOptions::fileOptionsRead);
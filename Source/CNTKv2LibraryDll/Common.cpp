@@ -11,6 +11,7 @@
 #include <memory>
 #include <algorithm>
 #include <CPUMatrix.h> // For CPUMatrix::SetNumThreads
+#include "ConvolutionEngine.h"
 #include <thread>
 #include "GPUMatrix.h"
 #include "Globals.h"
@@ -161,6 +162,16 @@ namespace CNTK
             Microsoft::MSR::CNTK::Globals::SetShareNodeValueMatrices(/* enable = */ false);
         }
 
+        void EnableMemoryArena()
+        {
+            Microsoft::MSR::CNTK::Globals::SetMemoryArena(/* enable = */ true);
+        }
+
+        void DisableMemoryArena()
+        {
+            Microsoft::MSR::CNTK::Globals::SetMemoryArena(/* enable = */ false);
+        }
+
         void EnableGradientAccumulationOptimization()
         {
             Microsoft::MSR::CNTK::Globals::SetGradientAccumulationOptimization(/* enable = */ true);
@@ -225,7 +236,7 @@ namespace CNTK
             // optimization is only for float
             int flags = Microsoft::MSR::CNTK::CPUMatrix<float>::GetOptimizationFlags();
             flags |= Microsoft::MSR::CNTK::CPUMatrix<float>::OPT_EVAL_WITH_MKL;
-            Microsoft::MSR::CNTK::CPUMatrix<float>::SetOptimizationFlags(Microsoft::MSR::CNTK::CPUMatrix<float>::OPT_EVAL_WITH_MKL);
+            Microsoft::MSR::CNTK::CPUMatrix<float>::SetOptimizationFlags(flags);
         }
 
         void DisableCPUEvalOptimization()
@@ -235,6 +246,16 @@ namespace CNTK
             Microsoft::MSR::CNTK::CPUMatrix<float>::SetOptimizationFlags(flags);
         }
 
+        void EnableConvolutionAutotuning(const std::wstring& cacheFilePath)
+        {
+            Microsoft::MSR::CNTK::ConvolutionEngineAutotuner::Enable(cacheFilePath);
+        }
+
+        void DisableConvolutionAutotuning()
+        {
+            Microsoft::MSR::CNTK::ConvolutionEngineAutotuner::Disable();
+        }
+
         void SetMPIPackThreshold(size_t packThesholdInBytes)
         {
             Microsoft::MSR::CNTK::Globals::SetMPIPackThreshold(packThesholdInBytes);
@@ -625,6 +646,33 @@ namespace CNTK
             return s_useSparseGradientAggregationInDataParallelSGD;
         }
 
+        // Off by default: hoisting and fusing change the evaluation order, and thus the rounding, of existing recurrent models.
+        std::atomic<bool> s_optimizeRecurrentLoops(false);
+
+        void OptimizeRecurrentLoops(bool enable)
+        {
+            s_optimizeRecurrentLoops = enable;
+        }
+
+        bool ShouldOptimizeRecurrentLoops()
+        {
+            return s_optimizeRecurrentLoops;
+        }
+
+        // Off by default: the fused backward pass recomputes the chain, which makes training slower for chains of
+        // expensive ops such as Exp and Tanh.
+        std::atomic<bool> s_fuseElementwiseOperations(false);
+
+        void FuseElementwiseOperations(bool enable)
+        {
+            s_fuseElementwiseOperations = enable;
+        }
+
+        bool ShouldFuseElementwiseOperations()
+        {
+            return s_fuseElementwiseOperations;
+        }
+
         static std::atomic<bool> s_threadsAreSet(false);
         bool MaxNumCPUThreadsSet()
         {
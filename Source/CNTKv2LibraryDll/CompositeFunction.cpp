@@ -226,7 +226,8 @@ namespace CNTK
         return composite;
     }
 
-    /*static*/ FunctionPtr CompositeFunction::Deserialize(const Dictionary& dict, const CNTK::DeviceDescriptor& device)
+    /*static*/ FunctionPtr CompositeFunction::Deserialize(const Dictionary& dict, const CNTK::DeviceDescriptor& device,
+                                                         const std::unordered_map<std::wstring, NDArrayViewPtr>& mappedValues)
     {
         static const vector<std::wstring> s_requiredDictionaryKeys = { inputsKey, functionsKey };
 
@@ -237,7 +238,7 @@ namespace CNTK
         for (const auto& dictionaryValue : inputs)
         {
             const auto& dictionary = dictionaryValue.Value<Dictionary>();
-            const auto& inputVar = Variable::Deserialize(dictionary, device);
+            const auto& inputVar = Variable::Deserialize(dictionary, device, mappedValues);
 
             if (uidToInputMap.find(inputVar.Uid()) != uidToInputMap.end())
             {
@@ -903,6 +904,12 @@ namespace CNTK
                     ASSIGN_NEW_NODE(RandomSampleInclusionFrequencyNode, network->GetDeviceId(), internalNodeName, numSamples, allowDuplicates);
                     break;
                 }
+                case PrimitiveOpType::SampledCrossEntropyWithSoftmax:
+                {
+                    auto numSamples = functionConfig[PrimitiveFunctionAttribute::AttributeNameNumSamples].Value<size_t>();
+                    ASSIGN_NEW_NODE(SampledCrossEntropyWithSoftmaxNode, network->GetDeviceId(), internalNodeName, numSamples);
+                    break;
+                }
                 case PrimitiveOpType::Dropout:
                 {
                     auto dropoutRate = functionConfig[PrimitiveFunctionAttribute::AttributeNameDropoutRate].Value<double>();
@@ -1664,6 +1671,7 @@ namespace CNTK
         computationNetwork->SetTraceLevel(Internal::GetComputationNetworkTraceLevel());
         computationNetwork->SetTrackGapNans(GetCheckedMode());
         computationNetwork->SetIsV2Library(true);
+        computationNetwork->SetOptimizeRecurrentLoops(Internal::ShouldOptimizeRecurrentLoops());
         computationNetwork->CompileNetwork();
         // Set EvalTimeStamp of all nodes in the network as "outdated" to make sure that all nodes will be evaluated at least once.
         // During CompileNetwork(), nodes in the network might get different timestamp values because other threads could update the global timestamp value.
@@ -1776,6 +1784,36 @@ namespace CNTK
 
             std::tie(m_computationNetwork, m_variableToNodeMap) = CreateComputationNetwork<ElementType>(this->shared_from_this(), device, outputs, m_fullyDefinedArgumentsMap, m_inputsExcludedFromGradientComputation, /*useMangledNamesForComputationNodes =*/ false);
 
+            // Fuse chains of elementwise operations, except for the nodes whose values or gradients are requested.
+            // Outputs that are not requested now cannot be requested later on, see the check for m_allNetworkRoots below.
+            // Only the CPU computes fused operations in a single pass; elsewhere they would run op by op on temporaries.
+            if (Internal::ShouldFuseElementwiseOperations() && device.Type() == DeviceKind::CPU)
+            {
+                std::set<ComputationNodeBasePtr> nodesToKeep;
+                for (auto output : RootFunction()->RawOutputs())
+                    nodesToKeep.insert(m_variableToNodeMap.at(output));
+                for (auto output : outputs)
+                    nodesToKeep.insert(m_variableToNodeMap.at(output));
+                for (auto backpropRoot : backpropRoots)
+                    nodesToKeep.insert(m_variableToNodeMap.at(backpropRoot));
+
+                auto replacedNodes = m_computationNetwork->FuseElementwiseOperations(nodesToKeep);
+                if (!replacedNodes.empty())
+                {
+                    for (auto iter = m_variableToNodeMap.begin(); iter != m_variableToNodeMap.end();)
+                    {
+                        auto replaced = replacedNodes.find(iter->second);
+                        if (replaced == replacedNodes.end())
+                            ++iter;
+                        else if (replaced->second)
+                            (iter++)->second = replaced->second;
+                        else
+                            iter = m_variableToNodeMap.erase(iter);
+                    }
+                    m_computationNetwork->SetEvalTimeStampsOutdatedWithRegardToAll();
+                }
+            }
+
             // Record the timestamps of Parameters and Constants
             assert(m_lastRecordedTimeStamps.empty());
             auto functionParameters = Parameters();
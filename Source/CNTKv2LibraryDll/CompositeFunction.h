@@ -8,6 +8,7 @@
 #include "stdafx.h"
 #include "CNTKLibrary.h"
 #include "PrimitiveFunction.h"
+#include "TestHooks.h"
 #include "ComputationNetwork.h"
 #include "BackCompat.h"
 #include "Value.h"
@@ -52,6 +53,7 @@ namespace CNTK
         friend inline std::shared_ptr<T> MakeSharedObject(CtorArgTypes&& ...ctorArgs);
 
         friend void Internal::SaveAsLegacyModel(const FunctionPtr& rootFunction, const std::wstring& modelFile);
+        friend std::vector<std::wstring> Internal::ComputationNodeOperationNames(const FunctionPtr& rootFunction);
 
         friend void ComputeInputPerDimMeansAndInvStdDevs(const MinibatchSourcePtr& minibatchSource,
                                                          std::unordered_map<StreamInformation, std::pair<NDArrayViewPtr, NDArrayViewPtr>>& computedMeanAndInvStdDevs,
@@ -119,7 +121,9 @@ namespace CNTK
                                                      const std::unordered_map<Variable, Variable>& allPlaceholderReplacements,
                                                      const CNTK::DeviceDescriptor& device);
 
-        static FunctionPtr Deserialize(const Dictionary& dictionary, const CNTK::DeviceDescriptor& device);
+        // 'mappedValues' are the values of the Parameters and Constants of a model in the CNTKv2Mapped format, see MappedModel.
+        static FunctionPtr Deserialize(const Dictionary& dictionary, const CNTK::DeviceDescriptor& device,
+                                       const std::unordered_map<std::wstring, NDArrayViewPtr>& mappedValues = {});
 
         virtual const std::wstring& OpName() const override
         {
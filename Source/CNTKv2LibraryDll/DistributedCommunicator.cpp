@@ -34,6 +34,11 @@ namespace CNTK
         return std::make_shared<MPICommunicatorImpl>(packThresholdSizeInBytes, useFP16AllReduce);
     }
 
+    DistributedCommunicatorPtr HierarchicalMPICommunicator(size_t packThresholdSizeInBytes, size_t ranksPerNode)
+    {
+        return std::make_shared<MPICommunicatorImpl>(packThresholdSizeInBytes, /*useFP16AllReduce=*/false, /*useHierarchicalAllReduce=*/true, ranksPerNode);
+    }
+
     void DistributedCommunicator::Finalize()
     {
         auto mpi = MPIWrapper::GetInstance(false);
@@ -71,7 +76,7 @@ namespace CNTK
         return nullptr; // Make compiler happy.
     }
 
-    MPICommunicatorImpl::MPICommunicatorImpl(size_t packThresholdSizeInBytes, bool useFP16AllReduce)
+    MPICommunicatorImpl::MPICommunicatorImpl(size_t packThresholdSizeInBytes, bool useFP16AllReduce, bool useHierarchicalAllReduce, size_t ranksPerNode)
     {
         m_mpi = MPIWrapper::GetInstance();
         if (m_mpi == nullptr)
@@ -90,6 +95,8 @@ namespace CNTK
         }
         m_packThresholdSizeInBytes = packThresholdSizeInBytes;
         m_useFP16AllReduce = useFP16AllReduce;
+        m_useHierarchicalAllReduce = useHierarchicalAllReduce;
+        m_ranksPerNode = ranksPerNode;
     }
 
     void MPICommunicatorImpl::Initialize(const std::vector<NDArrayViewPtr>& values)
@@ -367,6 +374,11 @@ namespace CNTK
             m_nccl.reset(new NcclComm(DeviceDescriptor::UseDefaultDevice().Id(), m_mpi));
         }
 
+        if (m_useHierarchicalAllReduce && m_hierarchicalAllReduce == nullptr)
+        {
+            m_hierarchicalAllReduce.reset(new HierarchicalAllReduce(m_mpi, m_ranksPerNode));
+        }
+
         Initialize(valuesToAggregate);
 
         // We need to make sure no compuatation happens on the main CUDA stream.
@@ -386,6 +398,9 @@ namespace CNTK
         CopyDataFromGPUToCPU(valuesToAggregate);
 
         std::vector<MPI_Request> allReduceRequests;
+        // Values not reduced through asynchronous MPI (hierarchical, NCCL, GPUDirect) issue no request,
+        // so the index of a request is not the index of its value: map each request to its value.
+        std::vector<size_t> allReduceRequestValueIndices;
         for (auto i = 0; i < numValues; ++i)
         {
             auto inputValue = valuesToAggregate[i];
@@ -408,7 +423,18 @@ namespace CNTK
             void* inputData = (ShouldCopyDataToCPU(inputValue)) ? m_intermediateCPUBuffers[i].data.get() : GetDataBuffer(inputValue);
             void* outputData = (ShouldCopyDataToCPU(inputValue)) ? m_intermediateCPUBuffers[i].data.get() : GetDataBuffer(outputValue);
 
-            if (dataType == DataType::Float)
+            if (ShouldUseHierarchicalAllReduce(inputValue))
+            {
+                // Synchronous, so this value has no request to wait for: copy the aggregate back to the GPU right away.
+                if (dataType == DataType::Float)
+                    m_hierarchicalAllReduce->AllReduce(static_cast<float*>(inputData), static_cast<float*>(outputData), numElements);
+                else
+                    m_hierarchicalAllReduce->AllReduce(static_cast<double*>(inputData), static_cast<double*>(outputData), numElements);
+
+                if (ShouldCopyDataToCPU(inputValue))
+                    m_gpuDataTransferers[i]->CopyCPUToGPUAsync(outputData, GetBufferSize(outputValue), GetDataBuffer(outputValue));
+            }
+            else if (dataType == DataType::Float)
             {
                 if (ShouldUseFP16AllReduce(inputValue))
                 {
@@ -445,6 +471,8 @@ namespace CNTK
             }
             else
                 LogicError("MPICommunicator: Unknown DataType.");
+
+            allReduceRequestValueIndices.resize(allReduceRequests.size(), i);
         }
 
         if (m_nccl->IsSupported())
@@ -466,15 +494,16 @@ namespace CNTK
 
             numAllReduceRequestsCompleted++;
 
-            assert(idx < valuesToAggregate.size());
-            auto value = valuesToAggregate[idx];
+            assert(idx < allReduceRequestValueIndices.size());
+            auto valueIdx = allReduceRequestValueIndices[idx];
+            auto value = valuesToAggregate[valueIdx];
 
             if (ShouldCopyDataToCPU(value))
             {
-                auto view = valuesAfterAggregate[idx];
+                auto view = valuesAfterAggregate[valueIdx];
                 auto size = GetBufferSize(view);
-                auto& transferer = m_gpuDataTransferers[idx];
-                auto& buffer = m_intermediateCPUBuffers[idx];
+                auto& transferer = m_gpuDataTransferers[valueIdx];
+                auto& buffer = m_intermediateCPUBuffers[valueIdx];
                 transferer->CopyCPUToGPUAsync(buffer.data.get(), size, GetDataBuffer(view));
             }
         }
@@ -666,6 +695,14 @@ namespace CNTK
             (DataType::Float == viewPtr->GetDataType()));
     }
 
+    bool MPICommunicatorImpl::ShouldUseHierarchicalAllReduce(const NDArrayViewPtr& viewPtr)
+    {
+        // Only for values that are aggregated from CPU buffers; NCCL and GPUDirect RDMA reduce GPU values in place.
+        return (m_hierarchicalAllReduce != nullptr &&
+            (DataType::Float == viewPtr->GetDataType() || DataType::Double == viewPtr->GetDataType()) &&
+            (DeviceKind::CPU == viewPtr->Device().Type() || ShouldCopyDataToCPU(viewPtr)));
+    }
+
     void MPICommunicatorImpl::CopyDataFromGPUToCPU(std::vector<NDArrayViewPtr>& inputValues)
     {
         for (auto i = 0; i < inputValues.size(); ++i)
@@ -9,6 +9,7 @@
 #include "Constants.h"
 #include "NcclComm.h"
 #include "MPIWrapper.h"
+#include "HierarchicalAllReduce.h"
 #include <MatrixQuantizerImpl.h>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
@@ -23,7 +24,8 @@ namespace CNTK
     class MPICommunicatorImpl : public DistributedCommunicator, public std::enable_shared_from_this<MPICommunicatorImpl>
     {
     public:
-        MPICommunicatorImpl(size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES, bool useFP16AllReduce = false);
+        MPICommunicatorImpl(size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES, bool useFP16AllReduce = false,
+                            bool useHierarchicalAllReduce = false, size_t ranksPerNode = 0);
 
         virtual const std::unordered_set<DistributedWorkerDescriptor>& Workers() const override;
 
@@ -98,6 +100,11 @@ namespace CNTK
         // NcclComm
         std::unique_ptr<Microsoft::MSR::CNTK::NcclComm> m_nccl;
 
+        // Shared memory + ring all-reduce of the values aggregated on the CPU, created on first use
+        bool m_useHierarchicalAllReduce;
+        size_t m_ranksPerNode;
+        std::unique_ptr<HierarchicalAllReduce> m_hierarchicalAllReduce;
+
         std::vector<Buffer> m_intermediateSBCIndexCPUBuffers;
         std::vector<Buffer> m_intermediateSBCValueCPUBuffers;
     protected:
@@ -109,6 +116,8 @@ namespace CNTK
 
         bool ShouldUseFP16AllReduce(const NDArrayViewPtr& viewPtr);
 
+        bool ShouldUseHierarchicalAllReduce(const NDArrayViewPtr& viewPtr);
+
         size_t GetBufferSize(const NDArrayViewPtr& viewPtr)
         {
             return viewPtr->Shape().TotalSize() * DataTypeSize(viewPtr->GetDataType());
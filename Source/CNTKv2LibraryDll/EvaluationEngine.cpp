@@ -0,0 +1,462 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include "CNTKLibrary.h"
+#include "Utils.h"
+
+namespace CNTK
+{
+    void EvaluationEngine::Evaluate(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputs)
+    {
+        std::vector<Variable> outputVariables;
+        for (const auto& output : outputs)
+            outputVariables.push_back(output.first);
+
+        auto values = EvaluateAsync(arguments, outputVariables).get();
+        for (auto& output : outputs)
+        {
+            if (output.second)
+                output.second->CopyFrom(*values.at(output.first));
+            else
+                output.second = values.at(output.first);
+        }
+    }
+
+    // Each worker evaluates a clone of the model that shares the Parameters (and Constants) with the model,
+    // so the parameter matrices exist only once, while every clone compiles its own ComputationNetwork with
+    // its own MatrixPool and MBLayouts.
+    //
+    // With dynamic batching, at most one worker at a time collects requests for its next minibatch: it takes
+    // the oldest request and merges compatible requests into it, until the minibatch is full or the oldest
+    // request has waited for maxBatchingDelayInMicroseconds. Requests are compatible if they have the same
+    // arguments (dense, with a batch axis, of the same sample shape) and ask for the same outputs (with a batch axis).
+    class EvaluationEngineImpl final : public EvaluationEngine
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        struct Request
+        {
+            std::unordered_map<Variable, ValuePtr> m_arguments;
+            std::vector<Variable> m_outputs; // sorted by Uid, to compare requests
+            std::promise<std::unordered_map<Variable, ValuePtr>> m_result;
+            Clock::time_point m_arrival;
+
+            // Sequences of each argument, in the order of the sorted keys of m_arguments; only for requests that can be merged.
+            std::vector<std::pair<std::vector<NDArrayViewPtr>, std::vector<bool>>> m_sequences;
+            size_t m_numSequences; // 0 if the request cannot be merged with others
+        };
+        typedef std::shared_ptr<Request> RequestPtr;
+
+        struct Worker
+        {
+            FunctionPtr m_model;                              // clone of the model, sharing its parameters
+            std::unordered_map<Variable, Variable> m_inputs;  // argument of the model -> argument of the clone
+            std::unordered_map<Variable, Variable> m_outputs; // output of the model -> output of the clone
+            std::thread m_thread;
+        };
+
+    public:
+        EvaluationEngineImpl(const FunctionPtr& model, const DeviceDescriptor& device, const EvaluationEngineConfig& config)
+            : m_model(model), m_device(device), m_config(config), m_stop(false), m_collecting(false),
+              m_numRequests(0), m_numMinibatches(0)
+        {
+            if (!model)
+                InvalidArgument("EvaluationEngine: The model must not be null.");
+            if (config.numWorkers == 0)
+                InvalidArgument("EvaluationEngine: The number of workers must be at least 1.");
+
+            auto arguments = model->Arguments();
+            auto outputs = model->Outputs();
+            m_workers.resize(config.numWorkers);
+            for (auto& worker : m_workers)
+            {
+                worker.m_model = model->Clone(ParameterCloningMethod::Share);
+
+                // The clone has the structure of the model, hence the same order of arguments and outputs.
+                auto clonedArguments = worker.m_model->Arguments();
+                auto clonedOutputs = worker.m_model->Outputs();
+                if (clonedArguments.size() != arguments.size() || clonedOutputs.size() != outputs.size())
+                    LogicError("EvaluationEngine: The clone of the model '%S' has different arguments or outputs.", model->AsString().c_str());
+
+                for (size_t i = 0; i < arguments.size(); ++i)
+                {
+                    if (clonedArguments[i].Name() != arguments[i].Name() || clonedArguments[i].Shape() != arguments[i].Shape())
+                        LogicError("EvaluationEngine: Argument '%S' of the model does not match argument '%S' of its clone.", arguments[i].AsString().c_str(), clonedArguments[i].AsString().c_str());
+                    worker.m_inputs[arguments[i]] = clonedArguments[i];
+                }
+                for (size_t i = 0; i < outputs.size(); ++i)
+                    worker.m_outputs[outputs[i]] = clonedOutputs[i];
+            }
+
+            m_latencies.reserve(std::max<size_t>(config.latencyWindow, 1));
+            for (auto& worker : m_workers)
+                worker.m_thread = std::thread([this, &worker]() { Work(worker); });
+        }
+
+        ~EvaluationEngineImpl()
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_stop = true;
+            }
+            m_requestAvailable.notify_all();
+            for (auto& worker : m_workers)
+                worker.m_thread.join();
+        }
+
+        std::future<std::unordered_map<Variable, ValuePtr>> EvaluateAsync(const std::unordered_map<Variable, ValuePtr>& arguments, const std::vector<Variable>& outputs) override
+        {
+            const auto& anyWorker = m_workers.front();
+            for (const auto& argument : arguments)
+            {
+                if (anyWorker.m_inputs.find(argument.first) == anyWorker.m_inputs.end())
+                    InvalidArgument("EvaluationEngine: '%S' is not an argument of the model '%S'.", argument.first.AsString().c_str(), m_model->AsString().c_str());
+                if (!argument.second)
+                    InvalidArgument("EvaluationEngine: The value of argument '%S' must not be null.", argument.first.AsString().c_str());
+            }
+            for (const auto& output : outputs)
+            {
+                if (anyWorker.m_outputs.find(output) == anyWorker.m_outputs.end())
+                    InvalidArgument("EvaluationEngine: '%S' is not an output of the model '%S'.", output.AsString().c_str(), m_model->AsString().c_str());
+            }
+
+            auto request = std::make_shared<Request>();
+            request->m_arguments = arguments;
+            request->m_outputs = outputs;
+            std::sort(request->m_outputs.begin(), request->m_outputs.end(), [](const Variable& a, const Variable& b) { return a.Uid() < b.Uid(); });
+            request->m_numSequences = 0;
+            if (m_config.maxBatchSize > 1)
+                PrepareForMerging(*request);
+
+            auto result = request->m_result.get_future();
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                if (m_stop)
+                    LogicError("EvaluationEngine: Request submitted while the engine is being destroyed.");
+                request->m_arrival = Clock::now();
+                m_requests.push_back(request);
+            }
+            m_requestAvailable.notify_all();
+            return result;
+        }
+
+        EvaluationEngineStatistics Statistics() const override
+        {
+            std::vector<double> latencies;
+            EvaluationEngineStatistics statistics;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                latencies = m_latencies;
+                statistics.numRequests = m_numRequests;
+                statistics.numMinibatches = m_numMinibatches;
+            }
+
+            if (latencies.empty())
+                return statistics;
+
+            std::sort(latencies.begin(), latencies.end());
+            auto percentile = [&latencies](double p) { return latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))]; };
+            double sum = 0;
+            for (auto latency : latencies)
+                sum += latency;
+            statistics.meanLatencyInMilliseconds = sum / latencies.size();
+            statistics.latencyP50InMilliseconds = percentile(0.5);
+            statistics.latencyP90InMilliseconds = percentile(0.9);
+            statistics.latencyP99InMilliseconds = percentile(0.99);
+            statistics.maxLatencyInMilliseconds = latencies.back();
+            return statistics;
+        }
+
+    private:
+        // Checks whether the request can be merged with others, and if so, splits its arguments into sequences.
+        void PrepareForMerging(Request& request)
+        {
+            for (const auto& output : request.m_outputs)
+            {
+                if (!HasBatchAxis(output))
+                    return;
+            }
+
+            size_t numSequences = 0;
+            for (const auto& argument : SortedArguments(request))
+            {
+                const auto& variable = argument->first;
+                const auto& value = argument->second;
+                if (!HasBatchAxis(variable) || value->IsSparse())
+                    return;
+
+                auto sequences = value->UnpackVariableValue(variable, /*sequenceSegmentsAllowed =*/ true, m_device);
+                if (numSequences != 0 && sequences.first.size() != numSequences)
+                    return;
+
+                numSequences = sequences.first.size();
+                request.m_sequences.push_back(std::move(sequences));
+            }
+            request.m_numSequences = numSequences;
+        }
+
+        bool CanMerge(const Request& first, const Request& other) const
+        {
+            if (other.m_numSequences == 0 || other.m_outputs != first.m_outputs || other.m_arguments.size() != first.m_arguments.size())
+                return false;
+
+            for (const auto& argument : first.m_arguments)
+            {
+                auto otherArgument = other.m_arguments.find(argument.first);
+                if (otherArgument == other.m_arguments.end())
+                    return false;
+
+                const auto& value = argument.second;
+                const auto& otherValue = otherArgument->second;
+                size_t sampleRank = argument.first.Shape().Rank();
+                if (value->GetDataType() != otherValue->GetDataType() || value->Shape().SubShape(0, sampleRank) != otherValue->Shape().SubShape(0, sampleRank))
+                    return false;
+            }
+            return true;
+        }
+
+        void Work(Worker& worker)
+        {
+            std::vector<RequestPtr> batch;
+            while (NextBatch(batch))
+            {
+                try
+                {
+                    if (batch.size() == 1 || !EvaluateMerged(worker, batch))
+                    {
+                        for (const auto& request : batch)
+                            EvaluateSingle(worker, *request);
+                    }
+                }
+                catch (...)
+                {
+                    // The promises not fulfilled yet get the exception.
+                    for (const auto& request : batch)
+                    {
+                        try
+                        {
+                            request->m_result.set_exception(std::current_exception());
+                        }
+                        catch (const std::future_error&)
+                        {
+                        }
+                    }
+                }
+                batch.clear();
+            }
+        }
+
+        // Waits for the next request and collects the requests to merge with it. Returns false when the engine stops.
+        bool NextBatch(std::vector<RequestPtr>& batch)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_requestAvailable.wait(lock, [this]() { return (m_stop || !m_requests.empty()) && !m_collecting; });
+            if (m_requests.empty())
+                return false; // stopping, and all requests are done
+
+            batch.push_back(m_requests.front());
+            m_requests.pop_front();
+
+            const auto& first = *batch.front();
+            if (first.m_numSequences == 0)
+                return true;
+
+            m_collecting = true;
+            size_t numSequences = first.m_numSequences;
+            auto deadline = first.m_arrival + std::chrono::microseconds(m_config.maxBatchingDelayInMicroseconds);
+            for (;;)
+            {
+                for (auto request = m_requests.begin(); request != m_requests.end() && numSequences < m_config.maxBatchSize;)
+                {
+                    if (CanMerge(first, **request) && numSequences + (*request)->m_numSequences <= m_config.maxBatchSize)
+                    {
+                        numSequences += (*request)->m_numSequences;
+                        batch.push_back(*request);
+                        request = m_requests.erase(request);
+                    }
+                    else
+                        ++request;
+                }
+
+                if (numSequences >= m_config.maxBatchSize || m_stop || Clock::now() >= deadline)
+                    break;
+
+                m_requestAvailable.wait_until(lock, deadline);
+            }
+            m_collecting = false;
+            lock.unlock();
+
+            // Let the next worker collect.
+            m_requestAvailable.notify_all();
+            return true;
+        }
+
+        void EvaluateSingle(Worker& worker, Request& request)
+        {
+            std::unordered_map<Variable, ValuePtr> arguments;
+            for (const auto& argument : request.m_arguments)
+                arguments[worker.m_inputs.at(argument.first)] = argument.second;
+
+            std::unordered_map<Variable, ValuePtr> outputs;
+            for (const auto& output : request.m_outputs)
+                outputs[worker.m_outputs.at(output)] = nullptr;
+
+            worker.m_model->Evaluate(arguments, outputs, m_device);
+
+            // The values reference the storage of the network, which the next evaluation overwrites.
+            std::unordered_map<Variable, ValuePtr> result;
+            for (const auto& output : request.m_outputs)
+                result[output] = outputs.at(worker.m_outputs.at(output))->DeepClone(/*readOnly =*/ false);
+
+            Complete(request, std::move(result), 1);
+        }
+
+        // Evaluates the requests as one minibatch. Returns false if the outputs cannot be split between the requests,
+        // e.g. because the model aggregates over the batch axis; nothing has been completed then.
+        bool EvaluateMerged(Worker& worker, const std::vector<RequestPtr>& batch)
+        {
+            const auto& first = *batch.front();
+            auto sortedArguments = SortedArguments(first);
+
+            std::unordered_map<Variable, ValuePtr> arguments;
+            for (size_t i = 0; i < sortedArguments.size(); ++i)
+            {
+                const auto& variable = sortedArguments[i]->first;
+                std::vector<NDArrayViewPtr> sequences;
+                std::vector<bool> sequenceStartFlags;
+                for (const auto& request : batch)
+                {
+                    const auto& requestSequences = request->m_sequences[i];
+                    sequences.insert(sequences.end(), requestSequences.first.begin(), requestSequences.first.end());
+                    sequenceStartFlags.insert(sequenceStartFlags.end(), requestSequences.second.begin(), requestSequences.second.end());
+                }
+
+                auto sampleShape = sortedArguments[i]->second->Shape().SubShape(0, variable.Shape().Rank());
+                arguments[worker.m_inputs.at(variable)] = Value::Create(sampleShape, sequences, sequenceStartFlags, m_device, /*readOnly =*/ true, /*createNewCopy =*/ true);
+            }
+
+            std::unordered_map<Variable, ValuePtr> outputs;
+            for (const auto& output : first.m_outputs)
+                outputs[worker.m_outputs.at(output)] = nullptr;
+
+            worker.m_model->Evaluate(arguments, outputs, m_device);
+
+            // Split the outputs by sequences.
+            std::vector<std::unordered_map<Variable, ValuePtr>> results(batch.size());
+            for (const auto& output : first.m_outputs)
+            {
+                const auto& clonedOutput = worker.m_outputs.at(output);
+                const auto& value = outputs.at(clonedOutput);
+                if (clonedOutput.DynamicAxes().size() > 1)
+                {
+                    auto sequences = value->UnpackVariableValue(clonedOutput, /*sequenceSegmentsAllowed =*/ true, m_device);
+                    if (sequences.first.size() != TotalSequences(batch))
+                        return false;
+
+                    auto sampleShape = value->Shape().SubShape(0, clonedOutput.Shape().Rank());
+                    size_t offset = 0;
+                    for (size_t j = 0; j < batch.size(); ++j)
+                    {
+                        size_t end = offset + batch[j]->m_numSequences;
+                        std::vector<NDArrayViewPtr> requestSequences(sequences.first.begin() + offset, sequences.first.begin() + end);
+                        std::vector<bool> requestStartFlags(sequences.second.begin() + offset, sequences.second.begin() + end);
+                        results[j][output] = Value::Create(sampleShape, requestSequences, requestStartFlags, m_device, /*readOnly =*/ false, /*createNewCopy =*/ true);
+                        offset = end;
+                    }
+                }
+                else
+                {
+                    // Only the batch axis: slice the samples.
+                    auto data = value->Data();
+                    auto shape = data->Shape();
+                    if (shape.Rank() == 0 || shape[shape.Rank() - 1] != TotalSequences(batch))
+                        return false;
+
+                    std::vector<size_t> offset(shape.Rank(), 0);
+                    std::vector<size_t> extent = shape.Dimensions();
+                    for (size_t j = 0; j < batch.size(); ++j)
+                    {
+                        extent.back() = batch[j]->m_numSequences;
+                        results[j][output] = MakeSharedObject<Value>(data->SliceView(offset, extent, /*readOnly =*/ true)->DeepClone(m_device, /*readOnly =*/ false));
+                        offset.back() += extent.back();
+                    }
+                }
+            }
+
+            for (size_t j = 0; j < batch.size(); ++j)
+                Complete(*batch[j], std::move(results[j]), j == 0 ? 1 : 0);
+
+            return true;
+        }
+
+        void Complete(Request& request, std::unordered_map<Variable, ValuePtr>&& result, size_t numMinibatches)
+        {
+            double latency = std::chrono::duration<double, std::milli>(Clock::now() - request.m_arrival).count();
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_numMinibatches += numMinibatches;
+                if (m_latencies.size() < m_latencies.capacity())
+                    m_latencies.push_back(latency);
+                else
+                    m_latencies[m_numRequests % m_latencies.size()] = latency;
+                m_numRequests++;
+            }
+            request.m_result.set_value(std::move(result));
+        }
+
+        static bool HasBatchAxis(const Variable& variable)
+        {
+            const auto& axes = variable.DynamicAxes();
+            return std::find(axes.begin(), axes.end(), Axis::DefaultBatchAxis()) != axes.end();
+        }
+
+        // The arguments of a request in a fixed order, to match the sequences of different requests.
+        static std::vector<std::unordered_map<Variable, ValuePtr>::const_iterator> SortedArguments(const Request& request)
+        {
+            std::vector<std::unordered_map<Variable, ValuePtr>::const_iterator> arguments;
+            for (auto argument = request.m_arguments.begin(); argument != request.m_arguments.end(); ++argument)
+                arguments.push_back(argument);
+            std::sort(arguments.begin(), arguments.end(), [](const std::unordered_map<Variable, ValuePtr>::const_iterator& a, const std::unordered_map<Variable, ValuePtr>::const_iterator& b)
+            {
+                return a->first.Uid() < b->first.Uid();
+            });
+            return arguments;
+        }
+
+        static size_t TotalSequences(const std::vector<RequestPtr>& batch)
+        {
+            size_t numSequences = 0;
+            for (const auto& request : batch)
+                numSequences += request->m_numSequences;
+            return numSequences;
+        }
+
+        const FunctionPtr m_model;
+        const DeviceDescriptor m_device;
+        const EvaluationEngineConfig m_config;
+        std::vector<Worker> m_workers;
+
+        mutable std::mutex m_lock;
+        std::condition_variable m_requestAvailable;
+        std::deque<RequestPtr> m_requests;
+        bool m_stop;
+        bool m_collecting; // a worker is collecting requests for its next minibatch
+
+        // Statistics
+        std::vector<double> m_latencies; // ring buffer of the latencies of the last requests, in milliseconds
+        size_t m_numRequests;
+        size_t m_numMinibatches;
+    };
+
+    EvaluationEnginePtr CreateEvaluationEngine(const FunctionPtr& model, const DeviceDescriptor& device, const EvaluationEngineConfig& config)
+    {
+        return MakeSharedObject<EvaluationEngineImpl>(model, device, config);
+    }
+}
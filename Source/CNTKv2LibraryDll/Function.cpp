@@ -11,6 +11,7 @@
 #include "BlockFunction.h"
 #include "Utils.h"
 #include "UserFunctionFactory.h"
+#include "MappedModel.h"
 #include "TrainingNodes.h"
 #include "proto/onnx/ONNX.h"
 
@@ -484,12 +485,13 @@ namespace CNTK
 
     void Function::Save(const std::wstring& filepath, ModelFormat format, bool useExternalFilesToStoreParameters)
     {
+        if (useExternalFilesToStoreParameters && format != ModelFormat::ONNX)
+            fprintf(stderr, "Warning: useExternalFilesToStoreParameters only applies to ONNX format.\n");
+
         switch (format)
         {
         case ModelFormat::CNTKv2:
         {
-            if (useExternalFilesToStoreParameters)
-                fprintf(stderr, "Warning: useExternalFilesToStoreParameters only applies to ONNX format."); 
             Dictionary model = Serialize();
             auto stream = GetFstream(filepath, false);
             *stream << model;
@@ -502,6 +504,12 @@ namespace CNTK
             ONNXFormat::Save(RootFunction(), filepath, useExternalFilesToStoreParameters);
             break;
         }
+
+        case ModelFormat::CNTKv2Mapped:
+        {
+            MappedModel::Save(Serialize(), filepath);
+            break;
+        }
         }
     }
 
@@ -510,9 +518,20 @@ namespace CNTK
         switch (format)
         {
         case ModelFormat::CNTKv2:
+        case ModelFormat::CNTKv2Mapped:
         {
             auto stream = GetFstream(filepath, true);
-            if (!Internal::IsLegacyModel(*stream))
+            if (MappedModel::IsMappedModel(*stream))
+            {
+                std::unordered_map<std::wstring, NDArrayViewPtr> mappedValues;
+                auto model = MappedModel::Load(filepath, computeDevice, mappedValues);
+                return CompositeFunction::Deserialize(model, computeDevice, mappedValues);
+            }
+            else if (format == ModelFormat::CNTKv2Mapped)
+            {
+                InvalidArgument("The model file '%S' is not in the CNTKv2Mapped format.", filepath.c_str());
+            }
+            else if (!Internal::IsLegacyModel(*stream))
             {
                 Dictionary model;
                 *stream >> model;
@@ -550,10 +569,16 @@ namespace CNTK
         switch (format)
         {
         case ModelFormat::CNTKv2:
+        case ModelFormat::CNTKv2Mapped:
         {
             if (Internal::IsLegacyModel(buffer, length)) {
                 InvalidArgument("Loading a legacy model from byte array is not supported.");
             }
+            else if (MappedModel::IsMappedModel(buffer, length))
+            {
+                // the buffer belongs to the caller, so the values are copied out of it
+                return Function::Deserialize(MappedModel::LoadDictionary(buffer, length), computeDevice);
+            }
             else
             {
                 modelStreamBuffer buf(buffer, length);
@@ -577,6 +602,12 @@ namespace CNTK
 
     /*static*/ FunctionPtr Function::Load(std::istream& inputStream, const DeviceDescriptor& computeDevice)
     {
+        if (MappedModel::IsMappedModel(inputStream))
+        {
+            std::vector<char> buffer((std::istreambuf_iterator<char>(inputStream)), std::istreambuf_iterator<char>());
+            return Function::Deserialize(MappedModel::LoadDictionary(buffer.data(), buffer.size()), computeDevice);
+        }
+
         Dictionary model;
         inputStream >> model;
         return Function::Deserialize(model, computeDevice);
@@ -585,6 +616,12 @@ namespace CNTK
     void Function::Restore(const std::wstring& filepath)
     {
         auto stream = GetFstream(filepath, true);
+        if (MappedModel::IsMappedModel(*stream))
+        {
+            RestoreFromCheckpoint(MappedModel::LoadDictionary(filepath));
+            return;
+        }
+
         if (!Internal::IsLegacyModel(*stream))
         {
             Dictionary model;
@@ -2216,6 +2253,40 @@ namespace CNTK
         return BinaryOp(PrimitiveOpType::EditDistanceError, prediction, labels, std::move(additionalProperties), name);
     }
 
+    FunctionPtr SampledCrossEntropyWithSoftmax(const Variable& weights, const Variable& inputs, const Variable& labels, const Variable& samplingWeights, size_t numSamples, unsigned long seed, const std::wstring& name)
+    {
+        if (!weights.IsPlaceholder() && !inputs.IsPlaceholder())
+        {
+            auto weightsShape = weights.Shape();
+            auto inputsShape = inputs.Shape();
+            if (weightsShape.Rank() != 2)
+                InvalidArgument("SampledCrossEntropyWithSoftmax: weights must have two axes");
+            if (inputsShape.Rank() != 1)
+                InvalidArgument("SampledCrossEntropyWithSoftmax: inputs must be a vector");
+            if (weightsShape[0] == NDShape::InferredDimension)
+            {
+                // Same as in NCELoss: infer the first axis of the weights from the inputs through a function we will not use.
+                auto allZero = Constant(NDShape({ 1 }).AppendShape(inputsShape), 0.0f);
+                auto unused = Times(allZero, weights);
+            }
+        }
+
+        if (!labels.IsPlaceholder() && !labels.IsSparse())
+            Warning("SampledCrossEntropyWithSoftmax: label is not sparse; gradients will be dense and operations will be slow");
+
+        auto additionalProperties = Dictionary();
+        additionalProperties[PrimitiveFunctionAttribute::AttributeNameNumSamples] = numSamples;
+
+        if (seed == SentinelValueForAutoSelectRandomSeed)
+            seed = Internal::GenerateRandomSeed(true);
+
+        additionalProperties[PrimitiveFunctionAttribute::AttributeNameRngSeed] = size_t(seed);
+        additionalProperties[PrimitiveFunctionAttribute::AttributeNameRngOffset] = size_t(0);
+
+        std::vector<Variable> operands = { labels, inputs, weights, samplingWeights };
+        return AsComposite(MakeSharedObject<PrimitiveFunction>(PrimitiveOpType::SampledCrossEntropyWithSoftmax, operands, std::move(additionalProperties), name), name);
+    }
+
     FunctionPtr LatticeSequenceWithSoftmax(const Variable& labels, const Variable& prediction, const Variable& scaledLogLikelihood, const Variable& lattice, const std::wstring& symListPath, const std::wstring& phonePath, const std::wstring& stateListPath, const std::wstring& transProbPath, const std::wstring& latticeConfigPath, float hSmoothingWeight, float frameDropThresh, bool doReferenceAlign, bool seqGammarUsesMBR, float seqGammarAMF, float seqGammarLMF, float seqGammarBMMIFactor, float seqGammarWordPen, const std::wstring& name)
     {
         auto additionalProperties = Dictionary();
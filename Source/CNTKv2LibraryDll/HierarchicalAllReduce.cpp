@@ -0,0 +1,326 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "Basics.h"
+#include "HierarchicalAllReduce.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+#ifdef _WIN32
+#include "Windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::MSR::CNTK;
+
+namespace CNTK
+{
+    // The control block is at the start of the shared memory segment, and the slots are page aligned after it.
+    struct HierarchicalAllReduce::SharedControl
+    {
+        std::atomic<unsigned int> numArrived;
+        char padding[64];
+        std::atomic<unsigned int> generation;
+    };
+
+    static const size_t s_sharedControlSize = 4096;
+
+    static const int s_ringTag = 0x484152; // MPI tag of the messages between node leaders
+    static const size_t s_maxNodeNameLength = 256;
+
+    // Distinguishes the shared memory segments of the instances in a process.
+    static std::atomic<int> s_numInstances(0);
+
+    static int CurrentProcessId()
+    {
+#ifdef _WIN32
+        return (int)GetCurrentProcessId();
+#else
+        return (int)getpid();
+#endif
+    }
+
+    HierarchicalAllReduce::HierarchicalAllReduce(const MPIWrapperPtr& mpi, size_t ranksPerNode)
+        : m_mpi(mpi), m_localRank(0), m_nodeIndex(0), m_segment(nullptr), m_segmentSize(0), m_segmentHandle(nullptr)
+    {
+        const size_t numRanks = m_mpi->NumNodesInUse();
+        const size_t rank = m_mpi->CurrentNodeRank();
+
+        // The process id and instance of every worker, to name the shared memory segments after their node leaders
+        std::vector<int> processes(2 * numRanks, 0);
+        processes[2 * rank] = CurrentProcessId();
+        processes[2 * rank + 1] = s_numInstances++;
+        std::vector<int> process(processes.begin() + 2 * rank, processes.begin() + 2 * rank + 2);
+        m_mpi->Allgather(process.data(), 2, MPI_INT, processes.data(), 2, MPI_INT);
+
+        // The first rank on the node of each rank
+        std::vector<size_t> nodeLeaderOf(numRanks);
+        if (ranksPerNode > 0)
+        {
+            for (size_t r = 0; r < numRanks; r++)
+                nodeLeaderOf[r] = r - r % ranksPerNode;
+        }
+        else
+        {
+            std::vector<wchar_t> name(s_maxNodeNameLength, 0);
+            std::wstring nodeName = m_mpi->CurrentNodeName();
+            std::copy(nodeName.begin(), nodeName.begin() + std::min(nodeName.size(), s_maxNodeNameLength - 1), name.begin());
+
+            std::vector<wchar_t> names(s_maxNodeNameLength * numRanks, 0);
+            std::copy(name.begin(), name.end(), names.begin() + s_maxNodeNameLength * rank);
+            const int nameSize = (int)(s_maxNodeNameLength * sizeof(wchar_t));
+            m_mpi->Allgather(name.data(), nameSize, MPI_CHAR, names.data(), nameSize, MPI_CHAR);
+
+            for (size_t r = 0; r < numRanks; r++)
+            {
+                nodeLeaderOf[r] = r;
+                for (size_t q = 0; q < r; q++)
+                {
+                    if (std::equal(names.begin() + s_maxNodeNameLength * q, names.begin() + s_maxNodeNameLength * (q + 1), names.begin() + s_maxNodeNameLength * r))
+                    {
+                        nodeLeaderOf[r] = nodeLeaderOf[q];
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (size_t r = 0; r < numRanks; r++)
+        {
+            if (nodeLeaderOf[r] == r)
+            {
+                if (r == nodeLeaderOf[rank])
+                    m_nodeIndex = m_nodeLeaders.size();
+                m_nodeLeaders.push_back(r);
+            }
+
+            if (nodeLeaderOf[r] == nodeLeaderOf[rank])
+            {
+                if (r == rank)
+                    m_localRank = m_localRanks.size();
+                m_localRanks.push_back(r);
+            }
+        }
+
+        CreateSharedSegment(processes[2 * m_localRanks[0]], processes[2 * m_localRanks[0] + 1]);
+    }
+
+    HierarchicalAllReduce::~HierarchicalAllReduce()
+    {
+        ReleaseSharedSegment();
+    }
+
+    void HierarchicalAllReduce::CreateSharedSegment(int leaderProcessId, int leaderInstance)
+    {
+        static_assert(sizeof(SharedControl) <= s_sharedControlSize, "The control block does not fit before the slots.");
+        static_assert(ATOMIC_INT_LOCK_FREE == 2, "Barriers in shared memory need lock-free atomics.");
+
+        m_segmentName = "cntk_allreduce_" + std::to_string(leaderProcessId) + "_" + std::to_string(leaderInstance);
+        m_segmentSize = s_sharedControlSize + (m_localRanks.size() + 1) * ChunkSizeInBytes;
+
+        // The leader creates the segment before the other workers of its node open it, and (on Linux) removes its name
+        // once they have, so that it goes away with the last of them. This is collective over all workers, but a worker
+        // with the whole node to itself all-reduces its buffers directly with the other nodes and needs no segment.
+        std::string error;
+        const bool needsSegment = m_localRanks.size() > 1;
+        const bool isLeader = m_localRank == 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            if (needsSegment && isLeader == (pass == 0))
+            {
+#ifdef _WIN32
+                std::wstring name = L"Local\\" + std::wstring(m_segmentName.begin(), m_segmentName.end());
+                HANDLE mapping = isLeader ? CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)m_segmentSize >> 32), (DWORD)m_segmentSize, name.c_str())
+                                          : OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+                void* segment = mapping == NULL ? NULL : MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_segmentSize);
+                if (segment == NULL)
+                {
+                    error = msra::strfun::strprintf("HierarchicalAllReduce: Unable to map the shared memory segment '%s', error %x.", m_segmentName.c_str(), GetLastError());
+                    if (mapping != NULL)
+                        CloseHandle(mapping);
+                }
+                else
+                {
+                    m_segment = segment;
+                    m_segmentHandle = mapping;
+                }
+#else
+                std::string name = "/" + m_segmentName;
+                if (isLeader)
+                    shm_unlink(name.c_str()); // left over by a crashed process with the same id
+                int file = shm_open(name.c_str(), isLeader ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, S_IRUSR | S_IWUSR);
+                bool sized = file >= 0 && (!isLeader || ftruncate(file, (off_t)m_segmentSize) == 0);
+                void* segment = sized ? mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+                if (segment == MAP_FAILED)
+                    error = msra::strfun::strprintf("HierarchicalAllReduce: Unable to map the shared memory segment '%s': %s.", name.c_str(), strerror(errno));
+                else
+                    m_segment = segment;
+                if (file >= 0)
+                    close(file);
+#endif
+                if (isLeader && m_segment)
+                    new (m_segment) SharedControl();
+            }
+
+            m_mpi->WaitAll();
+        }
+
+#ifndef _WIN32
+        if (isLeader && m_segment)
+            shm_unlink(("/" + m_segmentName).c_str());
+#endif
+
+        int numFailures = error.empty() ? 0 : 1;
+        m_mpi->AllReduce(&numFailures, 1);
+        if (numFailures > 0)
+        {
+            ReleaseSharedSegment();
+            if (!error.empty())
+                RuntimeError("%s", error.c_str());
+            RuntimeError("HierarchicalAllReduce: %d workers were unable to map their shared memory segment.", numFailures);
+        }
+    }
+
+    void HierarchicalAllReduce::ReleaseSharedSegment()
+    {
+        if (m_segment == nullptr)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(m_segment);
+        CloseHandle(m_segmentHandle);
+#else
+        munmap(m_segment, m_segmentSize);
+#endif
+        m_segment = nullptr;
+        m_segmentHandle = nullptr;
+    }
+
+    void HierarchicalAllReduce::LocalBarrier()
+    {
+        auto control = static_cast<SharedControl*>(m_segment);
+        unsigned int generation = control->generation.load(std::memory_order_acquire);
+        if (control->numArrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_localRanks.size())
+        {
+            control->numArrived.store(0, std::memory_order_relaxed);
+            control->generation.fetch_add(1, std::memory_order_release);
+        }
+        else
+        {
+            // Nodes are often oversubscribed with workers, so do not hold on to the core.
+            while (control->generation.load(std::memory_order_acquire) == generation)
+                std::this_thread::yield();
+        }
+    }
+
+    template <typename ElemType>
+    ElemType* HierarchicalAllReduce::Slot(size_t localRank) const
+    {
+        return reinterpret_cast<ElemType*>(static_cast<char*>(m_segment) + s_sharedControlSize + localRank * ChunkSizeInBytes);
+    }
+
+    template <typename ElemType>
+    void HierarchicalAllReduce::ReduceLocalSlice(size_t count)
+    {
+        const size_t numLocalRanks = m_localRanks.size();
+        const size_t begin = count * m_localRank / numLocalRanks;
+        const size_t end = count * (m_localRank + 1) / numLocalRanks;
+
+        ElemType* result = Slot<ElemType>(numLocalRanks) + begin;
+        memcpy(result, Slot<ElemType>(0) + begin, (end - begin) * sizeof(ElemType));
+        for (size_t j = 1; j < numLocalRanks; j++)
+        {
+            const ElemType* slot = Slot<ElemType>(j) + begin;
+            for (size_t k = 0; k < end - begin; k++)
+                result[k] += slot[k];
+        }
+    }
+
+    template <typename ElemType>
+    void HierarchicalAllReduce::RingAllReduce(ElemType* data, size_t count)
+    {
+        const size_t numNodes = m_nodeLeaders.size();
+        const int next = (int)m_nodeLeaders[(m_nodeIndex + 1) % numNodes];
+        const int previous = (int)m_nodeLeaders[(m_nodeIndex + numNodes - 1) % numNodes];
+        const MPI_Datatype dataType = MPIWrapper::GetDataType(data);
+
+        // The data is split into a segment per node, which travels once around the ring to be reduced and once more to be gathered.
+        auto segmentBegin = [count, numNodes](size_t segment) { return count * segment / numNodes; };
+        auto segmentSize = [&](size_t segment) { return (int)(segmentBegin(segment + 1) - segmentBegin(segment)); };
+        auto exchange = [&](size_t sendSegment, ElemType* receiveBuffer, size_t receiveSegment)
+        {
+            MPI_Request requests[2];
+            m_mpi->Irecv(receiveBuffer, segmentSize(receiveSegment), dataType, previous, s_ringTag, &requests[0]) || MpiFail("HierarchicalAllReduce: MPI_Irecv");
+            m_mpi->Isend(data + segmentBegin(sendSegment), segmentSize(sendSegment), dataType, next, s_ringTag, &requests[1]) || MpiFail("HierarchicalAllReduce: MPI_Isend");
+            m_mpi->Waitall(2, requests, MPI_STATUSES_IGNORE) || MpiFail("HierarchicalAllReduce: MPI_Waitall");
+        };
+
+        m_ringBuffer.resize(((count + numNodes - 1) / numNodes) * sizeof(ElemType));
+        ElemType* received = reinterpret_cast<ElemType*>(m_ringBuffer.data());
+
+        // Reduce-scatter: afterwards, segment (nodeIndex + 1) holds the sum over all nodes.
+        for (size_t step = 0; step + 1 < numNodes; step++)
+        {
+            const size_t sendSegment = (m_nodeIndex + numNodes - step) % numNodes;
+            const size_t receiveSegment = (m_nodeIndex + 2 * numNodes - step - 1) % numNodes;
+            exchange(sendSegment, received, receiveSegment);
+
+            ElemType* target = data + segmentBegin(receiveSegment);
+            for (int k = 0; k < segmentSize(receiveSegment); k++)
+                target[k] += received[k];
+        }
+
+        // All-gather of the reduced segments
+        for (size_t step = 0; step + 1 < numNodes; step++)
+        {
+            const size_t sendSegment = (m_nodeIndex + 1 + numNodes - step) % numNodes;
+            const size_t receiveSegment = (m_nodeIndex + numNodes - step) % numNodes;
+            exchange(sendSegment, data + segmentBegin(receiveSegment), receiveSegment);
+        }
+    }
+
+    template <typename ElemType>
+    void HierarchicalAllReduce::AllReduce(const ElemType* inputData, ElemType* outputData, size_t numElements)
+    {
+        const size_t numLocalRanks = m_localRanks.size();
+        const bool acrossNodes = m_nodeLeaders.size() > 1;
+        const size_t chunkSize = ChunkSizeInBytes / sizeof(ElemType);
+        for (size_t offset = 0; offset < numElements; offset += chunkSize)
+        {
+            const size_t count = std::min(chunkSize, numElements - offset);
+            if (numLocalRanks == 1)
+            {
+                if (outputData != inputData)
+                    memcpy(outputData + offset, inputData + offset, count * sizeof(ElemType));
+                if (acrossNodes)
+                    RingAllReduce(outputData + offset, count);
+                continue;
+            }
+
+            memcpy(Slot<ElemType>(m_localRank), inputData + offset, count * sizeof(ElemType));
+            LocalBarrier();
+            ReduceLocalSlice<ElemType>(count);
+            LocalBarrier();
+            if (acrossNodes)
+            {
+                if (m_localRank == 0)
+                    RingAllReduce(Slot<ElemType>(numLocalRanks), count);
+                LocalBarrier();
+            }
+
+            // The slots are not written again before all workers of the node are through the first barrier of the next chunk.
+            memcpy(outputData + offset, Slot<ElemType>(numLocalRanks), count * sizeof(ElemType));
+        }
+    }
+
+    template void HierarchicalAllReduce::AllReduce<float>(const float* inputData, float* outputData, size_t numElements);
+    template void HierarchicalAllReduce::AllReduce<double>(const double* inputData, double* outputData, size_t numElements);
+}
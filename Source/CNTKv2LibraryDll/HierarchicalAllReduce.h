@@ -0,0 +1,83 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include "MPIWrapper.h"
+#include <string>
+#include <vector>
+
+namespace CNTK
+{
+    //
+    // Sum all-reduce of dense CPU buffers that is aware of which workers share a node, in three stages:
+    //   1. the workers of a node copy their buffers to a shared memory segment of the node, and each of them
+    //      sums a slice of all these buffers (reduce-scatter),
+    //   2. one leader per node all-reduces the sums of the nodes in a ring over MPI,
+    //   3. the workers of a node copy the result from the shared memory segment (broadcast).
+    // So only one worker per node sends data to other nodes, and only once per element. Buffers are processed in chunks,
+    // so the size of the segment is fixed. Every worker of the MPI communicator must call AllReduce() with the same
+    // number of elements in the same order, and the result is the same bits on all of them.
+    //
+    // The nodes are the hosts of the workers (by processor name) or, if ranksPerNode is not 0, blocks of ranksPerNode
+    // consecutive ranks; the latter allows simulating several nodes with processes on the same host.
+    //
+    class HierarchicalAllReduce
+    {
+    public:
+        HierarchicalAllReduce(const Microsoft::MSR::CNTK::MPIWrapperPtr& mpi, size_t ranksPerNode = 0);
+        ~HierarchicalAllReduce();
+
+        HierarchicalAllReduce(const HierarchicalAllReduce&) = delete;
+        HierarchicalAllReduce& operator=(const HierarchicalAllReduce&) = delete;
+
+        // inputData and outputData may be the same buffer.
+        template <typename ElemType>
+        void AllReduce(const ElemType* inputData, ElemType* outputData, size_t numElements);
+
+        size_t NumNodes() const { return m_nodeLeaders.size(); }
+        size_t NodeIndex() const { return m_nodeIndex; }
+        size_t NumLocalRanks() const { return m_localRanks.size(); }
+        size_t LocalRank() const { return m_localRank; }
+
+        // Size in bytes of the chunks that buffers are all-reduced in, and of each of the slots of the shared memory segment.
+        static const size_t ChunkSizeInBytes = 1 << 20;
+
+    private:
+        struct SharedControl;
+
+        void CreateSharedSegment(int leaderProcessId, int leaderInstance);
+        void ReleaseSharedSegment();
+
+        // Waits until all the workers of the node have called it.
+        void LocalBarrier();
+
+        template <typename ElemType>
+        ElemType* Slot(size_t localRank) const;
+
+        // Sums this worker's slice of the first 'count' elements of all slots into the result slot.
+        template <typename ElemType>
+        void ReduceLocalSlice(size_t count);
+
+        // Ring all-reduce of 'count' elements of 'data' among the leaders of the nodes.
+        template <typename ElemType>
+        void RingAllReduce(ElemType* data, size_t count);
+
+        Microsoft::MSR::CNTK::MPIWrapperPtr m_mpi;
+
+        std::vector<size_t> m_localRanks;   // global ranks of the workers of this node, ascending
+        size_t m_localRank;                 // index of this worker in m_localRanks
+        std::vector<size_t> m_nodeLeaders;  // global rank of the first worker of each node
+        size_t m_nodeIndex;                 // index of this worker's node in m_nodeLeaders
+
+        // The shared memory segment of the node: a SharedControl, a slot for the chunk of each local worker and one for the result.
+        std::string m_segmentName;
+        void* m_segment;
+        size_t m_segmentSize;
+        void* m_segmentHandle;
+
+        std::vector<char> m_ringBuffer;
+    };
+}
@@ -8,6 +8,7 @@
 #include "TensorView.h"
 #include "Utils.h"
 #include "Serialization.h"
+#include <chrono>
 
 #define DISPATCH_TO_TYPED_UPDATE_FUNCTION                                                                     \
     switch (gradientValue->GetDataType())                                                                     \
@@ -129,14 +130,16 @@ namespace CNTK
     }
 
     // Clipping gradients to prevent outliers,
+    // 'gradientScale' is the loss scale if the gradient is still scaled, see PreProcess().
     template <typename ElementType>
-    void LearnerBase::ClipGradient(Matrix<ElementType>& gradient, size_t actualMBSize) const
+    void LearnerBase::ClipGradient(Matrix<ElementType>& gradient, size_t actualMBSize, double gradientScale) const
     {
         if (m_additionalOptions.gradientClippingThresholdPerSample != numeric_limits<double>::infinity())
         {
             double gradientClippingThresholdPerSample = m_additionalOptions.gradientClippingThresholdPerSample;
             // when using compatible mode, no need to scale up the maxGradientPerMB as it is the mean gradient already
             double maxGradientPerMB = IsCompatibleMode() ? gradientClippingThresholdPerSample : gradientClippingThresholdPerSample * actualMBSize;
+            maxGradientPerMB *= gradientScale;
             if (m_additionalOptions.gradientClippingWithTruncation)
                 gradient.InplaceTruncate(ElementType(maxGradientPerMB));
             else
@@ -165,14 +168,24 @@ namespace CNTK
             Matrix<ElementType>::Scale((ElementType)1.0 / actualMBSize, *gradientMatrix);
         }
 
+        // undo the loss scaling, unless the learner does it in float; then clipping and L2 are scaled along
+        double gradientScale = 1;
+        if (m_lossScale != 1)
+        {
+            if (std::is_same<ElementType, half>::value && UnscalesHalfGradients())
+                gradientScale = m_lossScale;
+            else
+                Matrix<ElementType>::Scale((ElementType)(1.0 / m_lossScale), *gradientMatrix);
+        }
+
         // clipping gradients to prevent outliers
-        ClipGradient<ElementType>(*gradientMatrix, actualMBSize);
+        ClipGradient<ElementType>(*gradientMatrix, actualMBSize, gradientScale);
 
         // L2 regularizer
         if (m_additionalOptions.l2RegularizationWeight > 0)
         {
             // multiply by actualMBSize so that it's invariant to minibatch size since learning rate is per sample
-            const auto weight = m_additionalOptions.l2RegularizationWeight * (IsCompatibleMode() ? 1 : actualMBSize);
+            const auto weight = m_additionalOptions.l2RegularizationWeight * (IsCompatibleMode() ? 1 : actualMBSize) * gradientScale;
             const auto& parameterMatrix = parameterValue->GetWritableMatrix<ElementType>();
             Matrix<ElementType>::ScaleAndAdd(ElementType(weight), *parameterMatrix, *gradientMatrix);
         }
@@ -218,7 +231,11 @@ namespace CNTK
                              AdditionalLearningOptions additionalOptions)
                              : Learner(parameters, learningRateSchedule, additionalOptions),
                              m_noiseInjectionSeed(Internal::GenerateRandomSeed()),
-                             m_masterParameterUpdated(false)
+                             m_masterParameterUpdated(false),
+                             m_lossScale(1),
+                             m_skipNextUpdate(false),
+                             m_updateMilliseconds(0),
+                             m_updatesSinceReport(0)
     {
         if (parameters.empty())
             InvalidArgument("The parameters list specified to a Learner must not be empty.");
@@ -291,6 +308,10 @@ namespace CNTK
     {
         ReportTrainingParameterValue(m_learningRateSchedule, L"Learning rate");
 
+        // the skip only applies to this minibatch, whatever happens to it below
+        bool skipUpdate = m_skipNextUpdate;
+        m_skipNextUpdate = false;
+
         if (LearningRate(trainingSampleCount) == 0.0)
         {
             return false;
@@ -300,8 +321,25 @@ namespace CNTK
         if (trainingSampleCount == 0)
             InvalidArgument("Learner::Update() cannot perform an update with an empty minibatch.");
 
+        // with dynamic loss scaling, a minibatch whose gradients overflowed is counted but not applied
+        if (skipUpdate)
+        {
+            UpdateCounts(trainingSampleCount, sweepEnd);
+            return true;
+        }
+
+        const auto startTime = chrono::steady_clock::now();
+        auto elapsedMilliseconds = [&startTime]() { return chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count(); };
+
         UpdateOnMinibatch(trainingSampleCount);
 
+        if (m_additionalOptions.fusedUpdate && UpdateFused(gradientValues, trainingSampleCount))
+        {
+            UpdateCounts(trainingSampleCount, sweepEnd);
+            ReportUpdateTime(elapsedMilliseconds());
+            return true;
+        }
+
         bool needUpdateMasterParameter = !m_masterParameterUpdated;
         for (const auto& parameter : Parameters())
         {
@@ -355,16 +393,134 @@ namespace CNTK
         {
             m_masterParameterUpdated = true;
         }
+        UpdateCounts(trainingSampleCount, sweepEnd);
+
+        if (m_additionalOptions.fusedUpdate)
+            ReportUpdateTime(elapsedMilliseconds());
+
+        return true;
+    }
+
+    void LearnerBase::UpdateCounts(size_t trainingSampleCount, bool sweepEnd)
+    {
         m_sampleCount += trainingSampleCount;
         m_minibatchCount++;
         if (sweepEnd)
         {
             m_sweepCount++;
         }
+    }
 
+    bool LearnerBase::UpdateFused(const unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t trainingSampleCount)
+    {
+        // Sparse gradients have their own lazy updates, see NextLazyUpdateTimestamps(), and noise injection has
+        // its own pass anyway; Float16 parameters are updated through their float master copies.
+        const auto dataType = Parameters().front().GetDataType();
+        if ((dataType != DataType::Float && dataType != DataType::Double) ||
+            !m_lastUpdateTime.empty() ||
+            GetCurrentTrainingParameterValue(m_additionalOptions.gaussianNoiseInjectionStdDev) > 0)
+            return false;
+
+        for (const auto& parameter : Parameters())
+        {
+            const auto& gradientValue = gradientValues.at(parameter);
+            if (parameter.GetDataType() != dataType || gradientValue->GetDataType() != dataType ||
+                parameter.Value()->Device().Type() != DeviceKind::CPU || gradientValue->Device().Type() != DeviceKind::CPU ||
+                parameter.Value()->IsSparse() || gradientValue->IsSparse())
+                return false;
+        }
+
+        FusedLearnerStep step;
+        if (!GetFusedUpdateStep(trainingSampleCount, step))
+            return false;
+
+        // the same scaling as in PreProcess() and PostProcess()
+        const double mbScale = IsCompatibleMode() ? 1 : (double)trainingSampleCount;
+        step.gradientScale = (IsCompatibleMode() ? 1.0 / trainingSampleCount : 1.0) / m_lossScale;
+        step.clippingThreshold = m_additionalOptions.gradientClippingThresholdPerSample * mbScale;
+        step.clippingWithTruncation = m_additionalOptions.gradientClippingWithTruncation;
+        step.l2Weight = m_additionalOptions.l2RegularizationWeight * mbScale;
+        step.learningRate = LearningRate(trainingSampleCount);
+        if (m_additionalOptions.l1RegularizationWeight > 0)
+            step.l1Threshold = step.learningRate * m_additionalOptions.l1RegularizationWeight * mbScale;
+
+        if (dataType == DataType::Float)
+            UpdateFused<float>(gradientValues, step);
+        else
+            UpdateFused<double>(gradientValues, step);
         return true;
     }
 
+    template <typename ElementType>
+    void LearnerBase::UpdateFused(const unordered_map<Parameter, NDArrayViewPtr>& gradientValues, const FusedLearnerStep& step)
+    {
+        if (!m_fusedState)
+            AllocateFusedState<ElementType>();
+
+        vector<shared_ptr<Matrix<ElementType>>> matrices;
+        vector<Matrix<ElementType>*> parameterMatrices, gradientMatrices, smoothedGradientMatrices;
+        for (const auto& parameter : Parameters())
+        {
+            matrices.push_back(GetWritableMatrix<ElementType>(parameter.Value()));
+            parameterMatrices.push_back(matrices.back().get());
+            matrices.push_back(GetWritableMatrix<ElementType>(gradientValues.at(parameter)));
+            gradientMatrices.push_back(matrices.back().get());
+            matrices.push_back(GetWritableMatrix<ElementType>(m_smoothedGradientValues.at(parameter)));
+            smoothedGradientMatrices.push_back(matrices.back().get());
+        }
+
+        Matrix<ElementType>::FusedLearnerUpdate(step, parameterMatrices, gradientMatrices, smoothedGradientMatrices);
+
+        for (const auto& parameter : Parameters())
+        {
+#ifdef _DEBUG
+            if (HasNan(parameter.Value(), "TrainOneEpoch/UpdateWeights/Learner::Update(): "))
+                LogicError("%ls has NaNs in parameter values after parameter update.", parameter.Uid().c_str());
+#endif
+            auto paramRef = parameter;
+            paramRef.RecordValueUpdate();
+        }
+    }
+
+    template <typename ElementType>
+    void LearnerBase::AllocateFusedState()
+    {
+        // Each parameter's part is padded to a multiple of 64 bytes, so that the parts are equally aligned.
+        const size_t padding = 64 / sizeof(ElementType);
+        vector<size_t> offsets;
+        size_t totalSize = 0;
+        for (const auto& parameter : Parameters())
+        {
+            offsets.push_back(totalSize);
+            totalSize += (m_smoothedGradientValues.at(parameter)->Shape().TotalSize() + padding - 1) / padding * padding;
+        }
+
+        m_fusedState = MakeSharedObject<NDArrayView>(ElementType(0), NDShape({ totalSize }), DeviceDescriptor::CPUDevice());
+        auto buffer = m_fusedState->WritableDataBuffer<ElementType>();
+        size_t i = 0;
+        for (const auto& parameter : Parameters())
+        {
+            auto& smoothedGradientValue = m_smoothedGradientValues.at(parameter);
+            const auto& shape = smoothedGradientValue->Shape();
+            auto view = MakeSharedObject<NDArrayView>(AsDataType<ElementType>(), shape, buffer + offsets[i++], shape.TotalSize() * sizeof(ElementType), smoothedGradientValue->Device());
+            view->CopyFrom(*smoothedGradientValue);
+            smoothedGradientValue = view;
+        }
+    }
+
+    void LearnerBase::ReportUpdateTime(double milliseconds)
+    {
+        m_updateMilliseconds += milliseconds;
+        m_updatesSinceReport++;
+        if ((m_minibatchCount & (m_minibatchCount - 1)) != 0)
+            return;
+
+        for (auto& writer : m_progressWriters)
+            writer->Write(L"Learner update time per minibatch (ms)", m_updateMilliseconds / m_updatesSinceReport);
+        m_updateMilliseconds = 0;
+        m_updatesSinceReport = 0;
+    }
+
     template <typename ElementType>
     void LearnerBase::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                              const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount)
@@ -534,12 +690,135 @@ namespace CNTK
         }
     }
 
+    // When the gradients are sparse, some learners update their internal buffers in a sparse way
+    // and maintain some additional timestamps. We periodically perform some dense work to prevent 
+    // a) the timestamps overflowing and b) big differences between this implementation and an equivalent dense
+    // implementation due to numerical issues with floating point numbers.
+    // TODO: consider exposing this somehow so that it is easy to test by setting it to small value.
+    /* static */ const int LearnerBase::s_SyncInterval = 1 << 20;
+
+    int* LearnerBase::NextLazyUpdateTimestamps(const Parameter& parameter, size_t numCols, const DeviceDescriptor& device,
+                                               const function<void(int* timestamps, int currentTimestamp)>& flush, int& currentTimestamp)
+    {
+        // The timestamp is allocated here and initialized to 0, meaning that at time 0 everything was
+        // up to date. We also maintain a currentTime variable that is incremented with each update.
+        // When we perform the update, for every non-zero column we first use the timestamp and the 
+        // current time to apply all updates that a dense implementation would have applied to that column
+        // and then update the timestamp for that column with the current time. 
+        int* timestamps = nullptr;
+        currentTimestamp = 0;
+        const auto search = m_lastUpdateTime.find(parameter);
+        if (search == m_lastUpdateTime.end())
+        {
+            // create timestamps and current time
+            // NDArrayView only supports Float and Double and the following assert prevents surprises in non-standard platforms
+            static_assert(sizeof(int) <= sizeof(float), "Buffer for timestamps is not big enough on this platform");
+            const auto view = MakeSharedObject<NDArrayView>(float(0.0), NDShape({ numCols }), device);
+            const auto itBoolPair = m_lastUpdateTime.emplace(make_pair(parameter, view));
+            assert(itBoolPair.second); // insertion took place
+            timestamps = reinterpret_cast<int*>(const_cast<float*>(itBoolPair.first->second->DataBuffer<float>()));
+            m_currentTime[parameter] = 0;
+        }
+        else
+        {
+            // retrieve timestamps and current time
+            timestamps = reinterpret_cast<int*>(const_cast<float*>(search->second->DataBuffer<float>()));
+            currentTimestamp = m_currentTime[parameter];
+        }
+        if (currentTimestamp >= LearnerBase::s_SyncInterval)
+        {
+            // Once in a while sync the state and reset the timestamps and current time to 0
+            flush(timestamps, currentTimestamp);
+            m_currentTime[parameter] = currentTimestamp = 0;
+        }
+        currentTimestamp += 1;
+        m_currentTime[parameter] = currentTimestamp;
+        return timestamps;
+    }
+
+    void LearnerBase::FlushLazyUpdates(const function<void(const Parameter& parameter, int* timestamps, int currentTimestamp)>& flush)
+    {
+        for (const auto& parameter : Parameters())
+        {
+            const auto search = m_lastUpdateTime.find(parameter);
+            if (search == m_lastUpdateTime.end())
+                continue;
+            int* timestamps = reinterpret_cast<int*>(const_cast<float*>(search->second->DataBuffer<float>()));
+            flush(parameter, timestamps, m_currentTime[parameter]);
+            m_currentTime[parameter] = 0;
+        }
+    }
+
+    void LearnerBase::ResetLazyUpdateTimestamps()
+    {
+        for (const auto& parameter : Parameters())
+        {
+            const auto search = m_lastUpdateTime.find(parameter);
+            if (search == m_lastUpdateTime.end())
+                continue;
+            m_currentTime[parameter] = 0;
+            search->second->SetValue(0.0f);
+        }
+    }
+
+    template <typename ElementType>
+    static vector<ElementType> ConvertedTo(const vector<double>& values)
+    {
+        vector<ElementType> result;
+        for (auto value : values)
+            result.push_back(static_cast<ElementType>(value));
+        return result;
+    }
+
+    template <typename ElementType>
+    int* LearnerBase::NextLazyDecayTimestamps(const Parameter& parameter, const NDArrayViewPtr& gradientValue, Matrix<ElementType>& smoothedGradientMatrix,
+                                              vector<double> decays, vector<double> floors, int& currentTimestamp)
+    {
+        currentTimestamp = 0;
+        if (!gradientValue->IsSparse() || gradientValue->Device().Type() != DeviceKind::CPU)
+            return nullptr;
+
+        const auto& lazyDecays = m_lazyDecays[parameter] = make_pair(move(decays), move(floors));
+        const auto numCols = GetMatrix<ElementType>(gradientValue)->GetNumCols();
+        return NextLazyUpdateTimestamps(parameter, numCols, gradientValue->Device(), [&](int* timestamps, int time)
+        {
+            smoothedGradientMatrix.LazyUpdateFlushState(numCols, ConvertedTo<ElementType>(lazyDecays.first), ConvertedTo<ElementType>(lazyDecays.second), timestamps, time);
+        }, currentTimestamp);
+    }
+
+    void LearnerBase::FlushLazyDecays()
+    {
+        FlushLazyUpdates([&](const Parameter& parameter, int* timestamps, int currentTimestamp)
+        {
+            const auto& smoothedGradientValue = m_smoothedGradientValues.at(parameter);
+            const auto& lazyDecays = m_lazyDecays.at(parameter);
+            const auto numCols = GetMatrixShape(parameter)[1];
+            switch (smoothedGradientValue->GetDataType())
+            {
+            case DataType::Float:
+                GetWritableMatrix<float>(smoothedGradientValue)->LazyUpdateFlushState(numCols, ConvertedTo<float>(lazyDecays.first), ConvertedTo<float>(lazyDecays.second), timestamps, currentTimestamp);
+                break;
+            case DataType::Double:
+                GetWritableMatrix<double>(smoothedGradientValue)->LazyUpdateFlushState(numCols, ConvertedTo<double>(lazyDecays.first), ConvertedTo<double>(lazyDecays.second), timestamps, currentTimestamp);
+                break;
+            default:
+                LogicError("Unexpected parameter data type");
+            }
+        });
+    }
+
     /*virtual*/ void LearnerSGD::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                                         const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) /*override*/
     {
         DISPATCH_TO_TYPED_UPDATE_FUNCTION;
     }
 
+    /*virtual*/ bool LearnerSGD::GetFusedUpdateStep(size_t /*trainingSampleCount*/, FusedLearnerStep& step) const /*override*/
+    {
+        step.kind = FusedLearnerKind::SGD;
+        return true;
+    }
+
     template <typename ElementType>
     void LearnerSGD::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                             const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
@@ -583,6 +862,16 @@ namespace CNTK
         }
     }
 
+    /*virtual*/ bool LearnerMomentumSGD::GetFusedUpdateStep(size_t trainingSampleCount, FusedLearnerStep& step) const /*override*/
+    {
+        ReportTrainingParameterValue(m_momentumSchedule, L"Momentum");
+
+        step.kind = FusedLearnerKind::MomentumSGD;
+        step.momentum = MomentumValueForMB(trainingSampleCount);
+        step.unitGainFactor = UnitGainFactor<double>(trainingSampleCount);
+        return true;
+    }
+
     template <typename ElementType>
     void LearnerMomentumSGD::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                                     const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
@@ -631,6 +920,8 @@ namespace CNTK
         auto parameterMatrix = compoundMatrix->ColumnSlice(2 * gradientMatrix->GetNumCols(), gradientMatrix->GetNumCols());
 
         tempGradientMatrix.CastAssignValuesOf(*gradientMatrix);
+        if (m_lossScale != 1)
+            Matrix<float>::Scale(float(1.0 / m_lossScale), tempGradientMatrix);
 
         const auto learningRate = float(LearningRate(trainingSampleCount));
         const auto momentum = float(MomentumValueForMB(trainingSampleCount));
@@ -659,6 +950,14 @@ namespace CNTK
         }
     }
 
+    /*virtual*/ bool LearnerNesterov::GetFusedUpdateStep(size_t trainingSampleCount, FusedLearnerStep& step) const /*override*/
+    {
+        step.kind = FusedLearnerKind::Nesterov;
+        step.momentum = MomentumValueForMB(trainingSampleCount);
+        step.unitGainFactor = UnitGainFactor<double>(trainingSampleCount);
+        return true;
+    }
+
     template <typename ElementType>
     void LearnerNesterov::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                                  const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
@@ -683,6 +982,8 @@ namespace CNTK
         auto parameterMatrix = compoundMatrix->ColumnSlice(2 * gradientMatrix->GetNumCols(), gradientMatrix->GetNumCols());
 
         tempGradientMatrix.CastAssignValuesOf(*gradientMatrix);
+        if (m_lossScale != 1)
+            Matrix<float>::Scale(float(1.0 / m_lossScale), tempGradientMatrix);
 
         const auto learningRate = float(LearningRate(trainingSampleCount));
         const auto momentum = float(MomentumValueForMB(trainingSampleCount));
@@ -720,6 +1021,13 @@ namespace CNTK
         DISPATCH_TO_TYPED_UPDATE_FUNCTION;
     }
 
+    /*virtual*/ bool LearnerAdaGrad::GetFusedUpdateStep(size_t /*trainingSampleCount*/, FusedLearnerStep& step) const /*override*/
+    {
+        step.kind = FusedLearnerKind::AdaGrad;
+        step.needAveMultiplier = m_needAveMultiplier;
+        return true;
+    }
+
     template <typename ElementType>
     void LearnerAdaGrad::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
                                 const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
@@ -762,13 +1070,6 @@ namespace CNTK
         }
     }
 
-    // When the gradients are sparse, we update the corresponding internal buffers of adadelta in a sparse way
-    // and we maintain some additional timestamps. We periodically perform some dense work to prevent 
-    // a) the timestamps overflowing and b) big differences between this implementation and an equivalent dense
-    // implementation due to numerical issues with floating point numbers.
-    // TODO: consider exposing this somehow so that it is easy to test by setting it to small value.
-    /* static */ const int LearnerAdaDelta::s_SyncInterval = 1 << 20;
-
     template <typename GradType, typename AccumType>
     void LearnerAdaDelta::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue,
         const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount)
@@ -787,38 +1088,11 @@ namespace CNTK
         if (gradientValue->IsSparse())
         {
             // When the gradient is sparse (block sparse column) we maintain a timestamp for every column
-            // The timestamp is allocated here and initialized to 0, meaning that at time 0 everything was
-            // up to date. We also maintain a currentTime variable that is incremented with each update.
-            // When we perform the update, for every non-zero column we first use the timestamp and the 
-            // current time to apply all updates that a dense implementation would have applied to that column
-            // and then update the timestamp for that column with the current time. 
             const auto numCols = gradientMatrix->GetNumCols();
-            const auto search = m_lastUpdateTime.find(parameter);
-            if (search == m_lastUpdateTime.end())
-            {
-                // create timestamps and current time
-                // NDArrayView only supports Float and Double and the following assert prevents surprises in non-standard platforms
-                static_assert(sizeof(int) <= sizeof(float), "Buffer for timestamps is not big enough on this platform");
-                const auto view = MakeSharedObject<NDArrayView>(float(0.0), NDShape({ numCols }), gradientValue->Device());
-                const auto itBoolPair = m_lastUpdateTime.emplace(make_pair(parameter, view));
-                assert(itBoolPair.second); // insertion took place
-                timestamps = reinterpret_cast<int*>(const_cast<float*>(itBoolPair.first->second->DataBuffer<float>()));
-                m_currentTime[parameter] = 0;
-            }
-            else
+            timestamps = NextLazyUpdateTimestamps(parameter, numCols, gradientValue->Device(), [&](int* columnTimestamps, int time)
             {
-                // retrieve timestamps and current time
-                timestamps = reinterpret_cast<int*>(const_cast<float*>(search->second->DataBuffer<float>()));
-                currentTimestamp = m_currentTime[parameter];
-            }
-            if (currentTimestamp >= LearnerAdaDelta::s_SyncInterval)
-            {
-                // Once in a while sync the state and reset the timestamps and current time to 0
-                smoothedGradientMatrix->AdaDeltaFlushState(numCols, (AccumType)m_rho, timestamps, currentTimestamp);
-                m_currentTime[parameter] = currentTimestamp = 0;
-            }
-            currentTimestamp += 1;
-            m_currentTime[parameter] = currentTimestamp;
+                smoothedGradientMatrix->AdaDeltaFlushState(numCols, (AccumType)m_rho, columnTimestamps, time);
+            }, currentTimestamp);
         }
 
         smoothedGradientMatrix->template AdaDeltaUpdate<GradType>(*gradientMatrix, parameterMatrix, (AccumType)learningRate, (AccumType)m_rho, (AccumType)m_epsilon, timestamps, currentTimestamp);
@@ -828,13 +1102,8 @@ namespace CNTK
     {
         // Before checkpointing we need to sync the state so that our lazy implementation 
         // for sparse gradients with timestamps is transparent to the user
-        for (const auto& parameter : Parameters())
+        FlushLazyUpdates([&](const Parameter& parameter, int* timestamps, int currentTimestamp)
         {
-            const auto search = m_lastUpdateTime.find(parameter);
-            if (search == m_lastUpdateTime.end())
-                continue;
-            int* timestamps = reinterpret_cast<int*>(const_cast<float*>(search->second->DataBuffer<float>()));
-            int currentTimestamp = m_currentTime[parameter];
             const auto& smoothedGradientValue = m_smoothedGradientValues.at(parameter);
             if (parameter.GetDataType() == CNTK::DataType::Float)
             {
@@ -850,9 +1119,7 @@ namespace CNTK
             }
             else
                 LogicError("Unexpected parameter data type");
-
-            m_currentTime[parameter] = 0;
-        }
+        });
         return LearnerBase::CreateCheckpoint();
     }
 
@@ -861,14 +1128,7 @@ namespace CNTK
         LearnerBase::RestoreFromCheckpoint(checkpoint);
         // After restoring from a checkpoint we need to reset all timestamps and the current time for
         // parameters that have sparse gradients.
-        for (const auto& parameter : Parameters())
-        {
-            const auto search = m_lastUpdateTime.find(parameter);
-            if (search == m_lastUpdateTime.end())
-                continue;
-            m_currentTime[parameter] = 0;
-            search->second->SetValue(0.0f);
-        }
+        ResetLazyUpdateTimestamps();
     }
 
     /*static*/ const double LearnerFSAdaGrad::s_targetAdagradAvDenom = 1.0;
@@ -888,6 +1148,7 @@ namespace CNTK
 
     /*virtual*/ Dictionary LearnerFSAdaGrad::CreateCheckpoint() /*override*/
     {
+        FlushLazyDecays();
         auto dict = LearnerBase::CreateCheckpoint();
         dict[smoothedCountKey] = m_smoothedCount;
         return dict;
@@ -896,6 +1157,7 @@ namespace CNTK
     /*virtual*/ void LearnerFSAdaGrad::RestoreFromCheckpoint(const Dictionary& checkpoint) /*override*/
     {
         LearnerBase::RestoreFromCheckpoint(checkpoint);
+        ResetLazyUpdateTimestamps();
         m_smoothedCount = checkpoint[smoothedCountKey].Value<double>();
     }
 
@@ -927,7 +1189,7 @@ namespace CNTK
 
     template <typename ElementType>
     void LearnerFSAdaGrad::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
-                                  const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
+                                  const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount)
     {
         GET_WRITABLE_MATRICES;
 
@@ -936,8 +1198,12 @@ namespace CNTK
         const auto varMomentum = VarianceMomentumValueForMB(trainingSampleCount);
         const auto unitGainFactor = UnitGainFactor<ElementType>(trainingSampleCount);
 
+        // sparse gradients only update the columns they touch, the others just decay their state
+        int currentTimestamp;
+        const auto timestamps = NextLazyDecayTimestamps(parameter, gradientValue, *smoothedGradientMatrix, { varMomentum, momentum }, { 0, 0 }, currentTimestamp);
+
         smoothedGradientMatrix->FSAdagradUpdate(*gradientMatrix, *parameterMatrix, m_targetAdagradAvDenom_x_sqrtAdagradSqrFrames, learningRate,
-                                                momentum, varMomentum, unitGainFactor);
+                                                momentum, varMomentum, unitGainFactor, timestamps, currentTimestamp);
     }
 
     LearnerAdam::LearnerAdam(const vector<Parameter>& parameters,
@@ -966,6 +1232,7 @@ namespace CNTK
 
     /*virtual*/ Dictionary LearnerAdam::CreateCheckpoint() /*override*/
     {
+        FlushLazyDecays();
         auto dict = LearnerBase::CreateCheckpoint();
         dict[smoothedCountKey] = m_smoothedCount;
         return dict;
@@ -974,6 +1241,7 @@ namespace CNTK
     /*virtual*/ void LearnerAdam::RestoreFromCheckpoint(const Dictionary& checkpoint) /*override*/
     {
         LearnerBase::RestoreFromCheckpoint(checkpoint);
+        ResetLazyUpdateTimestamps();
         m_smoothedCount = checkpoint[smoothedCountKey].Value<double>();
     }
 
@@ -994,9 +1262,23 @@ namespace CNTK
         DISPATCH_TO_TYPED_UPDATE_FUNCTION;
     }
 
+    /*virtual*/ bool LearnerAdam::GetFusedUpdateStep(size_t trainingSampleCount, FusedLearnerStep& step) const /*override*/
+    {
+        step.kind = FusedLearnerKind::Adam;
+        step.momentum = MomentumValueForMB(trainingSampleCount);
+        step.varianceMomentum = VarianceMomentumValueForMB(trainingSampleCount);
+        step.unitGainFactor = UnitGainFactor<double>(trainingSampleCount);
+        step.epsilon = m_epsilon;
+        step.adamax = m_adamax;
+        // bias correction as in Matrix::AdamUpdate()
+        const double meanCorrection = 1 - pow(step.momentum, m_smoothedCount);
+        step.biasCorrection = m_adamax ? 1 / meanCorrection : sqrt(1 - pow(step.varianceMomentum, m_smoothedCount)) / meanCorrection;
+        return true;
+    }
+
     template <typename ElementType>
     void LearnerAdam::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue,
-        const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
+        const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount)
     {
         GET_WRITABLE_MATRICES;
 
@@ -1006,8 +1288,12 @@ namespace CNTK
 
         const auto varMomentum = VarianceMomentumValueForMB(trainingSampleCount);
 
+        // sparse gradients only update the columns they touch, the others just decay their state
+        int currentTimestamp;
+        const auto timestamps = NextLazyDecayTimestamps(parameter, gradientValue, *smoothedGradientMatrix, { varMomentum, momentum }, { 0, 0 }, currentTimestamp);
+
         smoothedGradientMatrix->AdamUpdate(*gradientMatrix, *parameterMatrix, m_smoothedCount, learningRate,
-                                           momentum, varMomentum, (ElementType)m_epsilon, unitGainFactor, m_adamax);
+                                           momentum, varMomentum, (ElementType)m_epsilon, unitGainFactor, m_adamax, timestamps, currentTimestamp);
     }
 
     LearnerRMSProp::LearnerRMSProp(const vector<Parameter>& parameters,
@@ -1057,8 +1343,22 @@ namespace CNTK
         DISPATCH_TO_TYPED_UPDATE_FUNCTION;
     }
 
+    /*virtual*/ bool LearnerRMSProp::GetFusedUpdateStep(size_t /*trainingSampleCount*/, FusedLearnerStep& step) const /*override*/
+    {
+        step.kind = FusedLearnerKind::RmsProp;
+        step.rmsGamma = m_gamma;
+        step.rmsInc = m_inc;
+        step.rmsDec = m_dec;
+        step.rmsMax = m_max;
+        step.rmsMin = m_min;
+        step.needAveMultiplier = m_needAveMultiplier;
+        step.initialized = m_smoothedCount > 1;
+        return true;
+    }
+
     /*virtual*/ Dictionary LearnerRMSProp::CreateCheckpoint() /*override*/
     {
+        FlushLazyDecays();
         auto dict = LearnerBase::CreateCheckpoint();
         dict[smoothedCountKey] = m_smoothedCount;
         return dict;
@@ -1067,6 +1367,7 @@ namespace CNTK
     /*virtual*/ void LearnerRMSProp::RestoreFromCheckpoint(const Dictionary& checkpoint) /*override*/
     {
         LearnerBase::RestoreFromCheckpoint(checkpoint);
+        ResetLazyUpdateTimestamps();
         m_smoothedCount = checkpoint[smoothedCountKey].Value<double>();
     }
 
@@ -1083,12 +1384,17 @@ namespace CNTK
 
     template <typename ElementType>
     void LearnerRMSProp::Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, 
-                                const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const
+                                const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount)
     {
         GET_WRITABLE_MATRICES;
 
         const auto learningRate = LearningRate(trainingSampleCount);
 
+        // sparse gradients only update the columns they touch; the others decay their variances and step sizes,
+        // and forget the sign of their last gradient. With m_needAveMultiplier, all columns are updated.
+        int currentTimestamp;
+        const auto timestamps = NextLazyDecayTimestamps(parameter, gradientValue, *smoothedGradientMatrix, { m_gamma, 0, m_dec }, { 0, 0, m_min }, currentTimestamp);
+
         const auto aveMultiplier = smoothedGradientMatrix->RmsProp(*gradientMatrix,
                                                                    ElementType(m_gamma),
                                                                    ElementType(m_inc),
@@ -1096,7 +1402,8 @@ namespace CNTK
                                                                    ElementType(m_dec),
                                                                    ElementType(m_min),
                                                                    m_needAveMultiplier,
-                                                                   m_smoothedCount > 1);
+                                                                   m_smoothedCount > 1,
+                                                                   timestamps, currentTimestamp);
 
         Matrix<ElementType>::ScaleAndAdd(ElementType(-learningRate / aveMultiplier), *gradientMatrix, *parameterMatrix);
     }
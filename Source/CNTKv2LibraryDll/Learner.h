@@ -10,6 +10,10 @@
 #include <numeric>
 #include <functional>
 
+namespace Microsoft { namespace MSR { namespace CNTK {
+    struct FusedLearnerStep;
+}}}
+
 namespace CNTK 
 {
     // An abstract base class at the root of the standard learners hierarchy
@@ -31,6 +35,12 @@ namespace CNTK
 
         virtual void SetNeedToUpdateMasterParameter() override { m_masterParameterUpdated = false; }
 
+        virtual void SetLossScale(double lossScale) override { m_lossScale = lossScale; }
+
+        virtual bool SupportsLossScaling() const override { return true; }
+
+        virtual void SkipNextUpdate() override { m_skipNextUpdate = true; }
+
     protected:
         LearnerBase(const std::vector<Parameter>& parameters,
             const LearningRateSchedule& learningRateSchedule,
@@ -43,6 +53,14 @@ namespace CNTK
         // Allows derived class may override this to perform per-minibatch update actions
         virtual void UpdateOnMinibatch(size_t /*trainingSampleCount*/) {}
 
+        // Returns true if the learner copies Float16 gradients to float and undoes the loss scaling there (see
+        // LearnerMomentumSGD::UpdateHalf()), where small gradients do not flush to zero. Otherwise PreProcess() does it.
+        virtual bool UnscalesHalfGradients() const { return false; }
+
+        // With AdditionalLearningOptions::fusedUpdate, fills in the optimizer part of the fused update of all parameters for this
+        // minibatch (see Matrix::FusedLearnerUpdate()). Returns false if the learner has no fused update; then Update() is used.
+        virtual bool GetFusedUpdateStep(size_t /*trainingSampleCount*/, Microsoft::MSR::CNTK::FusedLearnerStep& /*step*/) const { return false; }
+
         std::string LearnerType() const;
 
         // Returns current learning rate.
@@ -83,6 +101,9 @@ namespace CNTK
 
         bool m_masterParameterUpdated; // whether the master copy of parameters are updated
 
+        double m_lossScale; // the gradients are multiplied with this, see Trainer::SetLossScaling()
+        bool m_skipNextUpdate;
+
         mutable size_t m_noiseInjectionSeed;
 
         // The following four static protected methods expose private methods of NDArrayView class
@@ -100,7 +121,7 @@ namespace CNTK
         static Microsoft::MSR::CNTK::TensorView<ElementType>* GetWritableTensorView(const NDArrayViewPtr& arrayView);
 
         template <typename ElementType>
-        void ClipGradient(Microsoft::MSR::CNTK::Matrix<ElementType>& gradient, size_t actualMBSize) const;
+        void ClipGradient(Microsoft::MSR::CNTK::Matrix<ElementType>& gradient, size_t actualMBSize, double gradientScale = 1) const;
 
         // Performs additional preprocessing before calling the update method 
         // (gradient clipping and L2 regularization depending on the additional learning parameters).
@@ -119,12 +140,67 @@ namespace CNTK
         // Retrieves the shape of the matrix corresponding to the parameter value.
         static NDShape GetMatrixShape(const Parameter& parameter);
 
+        // If a gradient is sparse, a learner may skip updating the columns with zero gradients. Their updates are applied
+        // lazily when their gradient is non-zero, from a timestamp per column with the last time that column was updated.
+        // Returns the timestamps for the update about to be made, and its time in 'currentTimestamp'. Once every
+        // s_SyncInterval updates, 'flush' is called first to bring all columns up to date and reset the timestamps.
+        int* NextLazyUpdateTimestamps(const Parameter& parameter, size_t numCols, const DeviceDescriptor& device,
+                                      const std::function<void(int* timestamps, int currentTimestamp)>& flush, int& currentTimestamp);
+
+        // Brings all columns with lazy updates up to date, so that e.g. a checkpoint does not depend on the timestamps.
+        void FlushLazyUpdates(const std::function<void(const Parameter& parameter, int* timestamps, int currentTimestamp)>& flush);
+
+        // Resets the timestamps, e.g. after the state has been restored from a checkpoint that was flushed.
+        void ResetLazyUpdateTimestamps();
+
+        // Lazy updates of learners whose state only decays in columns with zero gradients (Adam, FSAdaGrad, RMSProp).
+        // Returns the timestamps for the update if the gradient is sparse on the CPU, and nullptr otherwise, as sparse
+        // gradients on the GPU update all columns. 'decays' and 'floors' describe how the state of this update decays
+        // per step, see Matrix::LazyUpdateFlushState().
+        template <typename ElementType>
+        int* NextLazyDecayTimestamps(const Parameter& parameter, const NDArrayViewPtr& gradientValue, Microsoft::MSR::CNTK::Matrix<ElementType>& smoothedGradientMatrix,
+                                     std::vector<double> decays, std::vector<double> floors, int& currentTimestamp);
+
+        // Brings the state of all columns with lazy updates of NextLazyDecayTimestamps() up to date.
+        void FlushLazyDecays();
+
+        // Once every s_SyncInterval updates we make sure all columns are up to date.
+        static const int s_SyncInterval;
+
+        // If a gradient is sparse, we will maintain a timestamp per column with the last time that column was updated
+        std::unordered_map<Parameter, NDArrayViewPtr> m_lastUpdateTime;
+        // If a gradient is sparse we will use the current time and the timestamp to determine how to apply a bunch of delayed updates for this column.
+        // This allows us to skip updating many columns when the gradients are sparse.
+        std::unordered_map<Parameter, int> m_currentTime;
+        // decays and floors of the last lazy update of each parameter, see NextLazyDecayTimestamps()
+        std::unordered_map<Parameter, std::pair<std::vector<double>, std::vector<double>>> m_lazyDecays;
+
     private:
         // Templatized update function, it invokes preprocess and postprocess using the provided
         // template parameter and also invokes virtual Update method implemented in one of the subclasses.
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount);
 
+        void UpdateCounts(size_t trainingSampleCount, bool sweepEnd);
+
+        // Updates all parameters at once if they are dense float or double values on the CPU, see GetFusedUpdateStep().
+        // Returns false if they cannot be, and nothing has been updated.
+        bool UpdateFused(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t trainingSampleCount);
+
+        template <typename ElementType>
+        void UpdateFused(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, const Microsoft::MSR::CNTK::FusedLearnerStep& step);
+
+        // Moves the smoothed gradients of all parameters into m_fusedState, one after the other, and replaces them by views into it.
+        template <typename ElementType>
+        void AllocateFusedState();
+
+        // Writes the average time of the updates since the last report to the progress writers, after 1, 2, 4, 8, ... minibatches.
+        void ReportUpdateTime(double milliseconds);
+
+        NDArrayViewPtr m_fusedState;
+        double m_updateMilliseconds;
+        size_t m_updatesSinceReport;
+
         // TODO: make these functions friends of NDViewArray and move to Utils?
         static bool HasNan(const NDArrayViewPtr& value, const char* name);
         static void Print(const NDArrayViewPtr& value, const char* msg);
@@ -152,6 +228,7 @@ namespace CNTK
     protected:
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
 
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
@@ -182,12 +259,15 @@ namespace CNTK
 
     protected:
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
 
         template <typename ElemType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
 
         void UpdateHalf(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
 
+        virtual bool UnscalesHalfGradients() const override { return true; }
+
         // returns current per-minibatch momentum value from the provided schedule.
         double MomentumValueForMB(const MomentumSchedule& schedule, size_t minibatchSize) const;
 
@@ -229,6 +309,7 @@ namespace CNTK
 
     protected:
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
 
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
@@ -247,6 +328,7 @@ namespace CNTK
         bool m_needAveMultiplier;
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
 
         template <typename ElementType>
         void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
@@ -262,18 +344,9 @@ namespace CNTK
             AdditionalLearningOptions additionalOptions);
 
     protected:
-        // If a gradient is sparse, we skip updating columns with zero gradients. This means some 
-        // columns will receive their updates when their gradient is non-zero. The only exception
-        // is that once every s_SyncInterval updates we will make sure all columns are up to date. 
-        static const int s_SyncInterval;
-
+        // If a gradient is sparse, we skip updating columns with zero gradients, see LearnerBase::NextLazyUpdateTimestamps().
         double m_rho;
         double m_epsilon;
-        // If a gradient is sparse, we will maintain a timestamp per column with the last time that column was updated
-        std::unordered_map<Parameter, NDArrayViewPtr> m_lastUpdateTime;
-        // If a gradient is sparse we will use the current time and the timestamp to determine how to apply a bunch of delayed updates for this column.
-        // This allows us to skip updating many columns when the gradients are sparse.
-        std::unordered_map<Parameter, int> m_currentTime;
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
 
@@ -304,10 +377,12 @@ namespace CNTK
     protected:
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t /*trainingSampleCount*/, Microsoft::MSR::CNTK::FusedLearnerStep& /*step*/) const override { return false; }
         virtual void UpdateOnMinibatch(size_t trainingSampleCount) override;
+        virtual bool UnscalesHalfGradients() const override { return false; } // updates Float16 gradients directly
 
         template <typename ElementType>
-        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
+        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount);
 
     private:
         static const double s_targetAdagradAvDenom;
@@ -345,10 +420,12 @@ namespace CNTK
     protected:
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
         virtual void UpdateOnMinibatch(size_t trainingSampleCount) override;
+        virtual bool UnscalesHalfGradients() const override { return false; } // updates Float16 gradients directly
 
         template <typename ElementType>
-        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
+        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount);
 
     private:
 
@@ -392,10 +469,11 @@ namespace CNTK
         double m_smoothedCount;
 
         virtual void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) override;
+        virtual bool GetFusedUpdateStep(size_t trainingSampleCount, Microsoft::MSR::CNTK::FusedLearnerStep& step) const override;
         virtual void UpdateOnMinibatch(size_t trainingSampleCount) override;
 
         template <typename ElementType>
-        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount) const;
+        void Update(const Parameter& parameter, const NDArrayViewPtr& gradientValue, const NDArrayViewPtr& smoothedGradientValue, size_t trainingSampleCount);
     };
 
 
@@ -412,6 +490,9 @@ namespace CNTK
         //virtual bool Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t trainingSampleCount, bool sweepEnd = false) override;
         virtual bool Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t trainingSampleCount, bool sweepEnd) override;
 
+        // the update function sees the gradients as they are, so the Trainer undoes the loss scaling
+        virtual bool SupportsLossScaling() const override { return false; }
+
     private:
         void ValidateInput(const std::vector<Parameter>& parameters, const std::vector<Variable>& gradients, FunctionPtr updateFunc);
 
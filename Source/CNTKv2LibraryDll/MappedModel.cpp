@@ -0,0 +1,487 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include "MappedModel.h"
+#include "BackCompat.h"
+#include "Serialization.h"
+#include "Utils.h"
+#include "fileutil.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace Microsoft::MSR::CNTK;
+
+namespace CNTK
+{
+    static const char s_mappedModelMagic[8] = { 'C', 'N', 'T', 'K', 'M', 'A', 'P', '\0' };
+
+    // Version history:
+    // 1 -- initial version.
+    static const uint32_t s_mappedModelVersion = 1;
+
+    // The blobs start on a page, so that each of them is aligned to a cache line in memory, too.
+    static const size_t s_blobsAlignment = 4096;
+    static const size_t s_blobAlignment = 64;
+
+    static const std::wstring mappedValueKey = L"mapped_value";
+    static const std::wstring offsetKey = L"offset";
+    static const std::wstring sizeKey = L"size";
+
+    struct MappedModelHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t modelOffset;
+        uint64_t modelSize;
+        uint64_t blobsOffset;
+        uint64_t blobsSize;
+    };
+
+    static_assert(sizeof(MappedModelHeader) == 48, "MappedModelHeader must not contain padding.");
+
+    static size_t AlignUp(size_t offset, size_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Copy-on-write memory mapping of a whole model file.
+    class MappedModelFile
+    {
+    public:
+        explicit MappedModelFile(const std::wstring& filePath);
+        ~MappedModelFile();
+
+        char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+
+        DISABLE_COPY_AND_MOVE(MappedModelFile);
+
+    private:
+        char* m_data;
+        size_t m_size;
+    };
+
+#ifdef _WIN32
+
+    MappedModelFile::MappedModelFile(const std::wstring& filePath)
+        : m_data(nullptr), m_size(0)
+    {
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            RuntimeError("Cannot open file '%S' for reading.", filePath.c_str());
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            auto error = GetLastError();
+            CloseHandle(file);
+            RuntimeError("Unable to retrieve the size of file '%ls', error %x.", filePath.c_str(), error);
+        }
+        m_size = (size_t)size.QuadPart;
+
+        // Copy-on-write, so that values over the mapping can be updated (e.g. when training) without changing the file.
+        // The view keeps the file and the mapping open.
+        HANDLE mapping = m_size == 0 ? NULL : CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping != NULL)
+            m_data = (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        auto error = GetLastError();
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        if (m_data == nullptr)
+            RuntimeError("Unable to memory map file '%ls', error %x.", filePath.c_str(), error);
+    }
+
+    MappedModelFile::~MappedModelFile()
+    {
+        UnmapViewOfFile(m_data);
+    }
+
+#else
+
+    MappedModelFile::MappedModelFile(const std::wstring& filePath)
+        : m_data(nullptr), m_size(0)
+    {
+        int file = open(ToLegacyString(ToUTF8(filePath)).c_str(), O_RDONLY);
+        if (file == -1)
+            RuntimeError("Cannot open file '%S' for reading.", filePath.c_str());
+
+        struct stat sb;
+        if (fstat(file, &sb) == -1)
+        {
+            auto error = errno;
+            close(file);
+            RuntimeError("Unable to retrieve the size of file '%ls': %s.", filePath.c_str(), strerror(error));
+        }
+        m_size = (size_t)sb.st_size;
+
+        // Private and writable, so that values over the mapping can be updated (e.g. when training) without changing the file.
+        // The mapping keeps the file open.
+        void* data = m_size == 0 ? MAP_FAILED : mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        auto error = errno;
+        close(file);
+        if (data == MAP_FAILED)
+            RuntimeError("Unable to memory map file '%ls': %s.", filePath.c_str(), strerror(error));
+        m_data = (char*)data;
+    }
+
+    MappedModelFile::~MappedModelFile()
+    {
+        munmap(m_data, m_size);
+    }
+
+#endif
+
+    static MappedModelHeader ReadHeader(const char* buffer, size_t bufferSize)
+    {
+        if (!MappedModel::IsMappedModel(buffer, bufferSize) || bufferSize < sizeof(MappedModelHeader))
+            RuntimeError("The model is not in the CNTKv2Mapped format.");
+
+        MappedModelHeader header;
+        memcpy(&header, buffer, sizeof(header));
+        if (header.version > s_mappedModelVersion)
+            RuntimeError("The CNTKv2Mapped model has version %u, but only versions up to %u are supported.", (unsigned int)header.version, (unsigned int)s_mappedModelVersion);
+
+        if (header.headerSize < sizeof(MappedModelHeader) ||
+            header.modelOffset < header.headerSize || header.modelSize > bufferSize || header.modelOffset > bufferSize - header.modelSize ||
+            header.blobsOffset < header.modelOffset + header.modelSize || header.blobsSize > bufferSize || header.blobsOffset > bufferSize - header.blobsSize)
+            RuntimeError("The CNTKv2Mapped model is truncated or corrupt.");
+
+        return header;
+    }
+
+    class MemoryStreamBuffer : public std::streambuf
+    {
+    public:
+        MemoryStreamBuffer(const char* buffer, size_t bufferSize)
+        {
+            char* begin = const_cast<char*>(buffer);
+            setg(begin, begin, begin + bufferSize);
+        }
+    };
+
+    static Dictionary ReadModelDictionary(const char* buffer, const MappedModelHeader& header)
+    {
+        MemoryStreamBuffer streamBuffer(buffer + header.modelOffset, header.modelSize);
+        std::istream stream(&streamBuffer);
+        Dictionary model;
+        stream >> model;
+        return model;
+    }
+
+    // The value of a Variable of the model, stored in a blob.
+    struct MappedValue
+    {
+        std::wstring uid;
+        DataType dataType;
+        NDShape shape;
+        const char* data;
+        size_t size;
+    };
+
+    static MappedValue GetMappedValue(const Dictionary& input, const char* buffer, const MappedModelHeader& header)
+    {
+        const auto& blob = input[mappedValueKey].Value<Dictionary>();
+        MappedValue value;
+        value.uid = input[uidKey].Value<std::wstring>();
+        value.dataType = DataType(blob[dataTypeKey].Value<size_t>());
+        value.shape = blob[shapeKey].Value<NDShape>();
+        value.size = blob[sizeKey].Value<size_t>();
+
+        auto offset = blob[offsetKey].Value<size_t>();
+        if (offset % s_blobAlignment != 0 || value.size > header.blobsSize || offset > header.blobsSize - value.size ||
+            value.size != value.shape.TotalSize() * DataTypeSize(value.dataType))
+            RuntimeError("The value of Variable '%S' in the CNTKv2Mapped model is truncated or corrupt.", value.uid.c_str());
+
+        value.data = buffer + header.blobsOffset + offset;
+        return value;
+    }
+
+    static Dictionary WithoutKey(const Dictionary& dictionary, const std::wstring& key)
+    {
+        Dictionary result;
+        for (const auto& entry : dictionary)
+        {
+            if (entry.first != key)
+                result[entry.first] = entry.second;
+        }
+        return result;
+    }
+
+    static const void* RawDataBuffer(const NDArrayView& value)
+    {
+        switch (value.GetDataType())
+        {
+        case DataType::Float:
+            return value.DataBuffer<float>();
+        case DataType::Double:
+            return value.DataBuffer<double>();
+        case DataType::Float16:
+            return value.DataBuffer<float16>();
+        case DataType::Int8:
+            return value.DataBuffer<int8_t>();
+        case DataType::Int16:
+            return value.DataBuffer<int16_t>();
+        default:
+            LogicError("Unsupported DataType %s", DataTypeName(value.GetDataType()));
+        }
+    }
+
+    /*static*/ bool MappedModel::IsMappedModel(const char* buffer, size_t bufferSize)
+    {
+        return bufferSize >= sizeof(s_mappedModelMagic) && memcmp(buffer, s_mappedModelMagic, sizeof(s_mappedModelMagic)) == 0;
+    }
+
+    /*static*/ bool MappedModel::IsMappedModel(std::istream& stream)
+    {
+        char buffer[sizeof(s_mappedModelMagic)];
+        const auto position = stream.tellg();
+        if (position != std::istream::pos_type(-1))
+        {
+            stream.read(buffer, sizeof(buffer));
+            auto bytesRead = (size_t)stream.gcount();
+            stream.clear();
+            stream.seekg(position);
+            return IsMappedModel(buffer, bytesRead);
+        }
+
+        // Streams over a memory buffer cannot seek, so the bytes read are put back into the stream buffer instead.
+        auto streamBuffer = stream.rdbuf();
+        size_t bytesRead = 0;
+        for (; bytesRead < sizeof(buffer); bytesRead++)
+        {
+            auto c = streamBuffer->sbumpc();
+            if (c == std::char_traits<char>::eof())
+                break;
+            buffer[bytesRead] = std::char_traits<char>::to_char_type(c);
+        }
+
+        for (size_t i = bytesRead; i > 0; i--)
+        {
+            if (streamBuffer->sputbackc(buffer[i - 1]) == std::char_traits<char>::eof())
+                RuntimeError("Cannot determine the format of a model from a stream that can neither seek nor put back what was read.");
+        }
+
+        return IsMappedModel(buffer, bytesRead);
+    }
+
+    /*static*/ void MappedModel::Save(const Dictionary& model, const std::wstring& filePath)
+    {
+        // The dense values of the Variables of the model are replaced by references to the blobs that follow it.
+        Dictionary mappedModel;
+        std::vector<std::pair<const NDArrayView*, size_t>> blobs;
+        size_t blobsSize = 0;
+        for (const auto& entry : model)
+        {
+            if (entry.first != inputsKey)
+            {
+                mappedModel[entry.first] = entry.second;
+                continue;
+            }
+
+            const auto& inputs = entry.second.Value<std::vector<DictionaryValue>>();
+            std::vector<DictionaryValue> mappedInputs;
+            mappedInputs.reserve(inputs.size());
+            for (const auto& inputValue : inputs)
+            {
+                const auto& input = inputValue.Value<Dictionary>();
+                if (!input.Contains(valueKey) || input[valueKey].Value<NDArrayView>().GetStorageFormat() != StorageFormat::Dense)
+                {
+                    mappedInputs.push_back(inputValue);
+                    continue;
+                }
+
+                const auto& value = input[valueKey].Value<NDArrayView>();
+                auto size = value.Shape().TotalSize() * DataTypeSize(value.GetDataType());
+                blobsSize = AlignUp(blobsSize, s_blobAlignment);
+
+                Dictionary blob;
+                blob[offsetKey] = blobsSize;
+                blob[sizeKey] = size;
+                blob[dataTypeKey] = static_cast<size_t>(value.GetDataType());
+                blob[shapeKey] = value.Shape();
+
+                Dictionary mappedInput = WithoutKey(input, valueKey);
+                mappedInput[mappedValueKey] = blob;
+                mappedInputs.push_back(mappedInput);
+
+                blobs.push_back({ &value, blobsSize });
+                blobsSize += size;
+            }
+            mappedModel[inputsKey] = mappedInputs;
+        }
+
+        std::ostringstream modelStream;
+        modelStream << mappedModel;
+        const auto modelBytes = modelStream.str();
+
+        MappedModelHeader header;
+        memcpy(header.magic, s_mappedModelMagic, sizeof(header.magic));
+        header.version = s_mappedModelVersion;
+        header.headerSize = sizeof(MappedModelHeader);
+        header.modelOffset = sizeof(MappedModelHeader);
+        header.modelSize = modelBytes.size();
+        header.blobsOffset = AlignUp(header.modelOffset + header.modelSize, s_blobsAlignment);
+        header.blobsSize = blobsSize;
+
+        // Written to a temporary file that then replaces the model file, so that processes that have mapped it keep their values.
+        // On Windows, a model file that is mapped cannot be replaced.
+        auto tempFilePath = filePath + L".tmp";
+        {
+            auto stream = GetFstream(tempFilePath, false);
+            size_t position = 0;
+            auto Write = [&](const void* data, size_t size)
+            {
+                stream->write((const char*)data, size);
+                position += size;
+            };
+            auto PadTo = [&](size_t offset)
+            {
+                static const char zeros[s_blobsAlignment] = {};
+                while (position < offset)
+                    Write(zeros, std::min(offset - position, sizeof(zeros)));
+            };
+
+            Write(&header, sizeof(header));
+            Write(modelBytes.data(), modelBytes.size());
+            for (const auto& blob : blobs)
+            {
+                const auto& value = *blob.first;
+                PadTo(header.blobsOffset + blob.second);
+                Write(RawDataBuffer(value), value.Shape().TotalSize() * DataTypeSize(value.GetDataType()));
+            }
+            PadTo(header.blobsOffset + header.blobsSize);
+
+            stream->flush();
+            if (stream->fail())
+                RuntimeError("Failed to write the model to file '%S'.", tempFilePath.c_str());
+        }
+        renameOrDie(tempFilePath, filePath);
+    }
+
+    /*static*/ void MappedModel::SetMappingOwner(const NDArrayViewPtr& value, const std::shared_ptr<void>& mapping)
+    {
+        switch (value->GetDataType())
+        {
+        case DataType::Float:
+            value->GetWritableMatrix<float>()->SetExternalBufferOwner(mapping);
+            break;
+        case DataType::Double:
+            value->GetWritableMatrix<double>()->SetExternalBufferOwner(mapping);
+            break;
+        case DataType::Float16:
+            value->GetWritableMatrix<half>()->SetExternalBufferOwner(mapping);
+            break;
+        case DataType::Int8:
+            value->GetWritableMatrix<char>()->SetExternalBufferOwner(mapping);
+            break;
+        case DataType::Int16:
+            value->GetWritableMatrix<short>()->SetExternalBufferOwner(mapping);
+            break;
+        default:
+            LogicError("Unsupported DataType %s", DataTypeName(value->GetDataType()));
+        }
+    }
+
+    /*static*/ Dictionary MappedModel::Load(const std::wstring& filePath, const DeviceDescriptor& device, std::unordered_map<std::wstring, NDArrayViewPtr>& values)
+    {
+        // Values on the CPU are views over the mapping, and their storage keeps it: their matrices are shared all over the
+        // process (e.g. with the ComputationNetwork of a Function, or with clones of it), so it is unmapped when the last
+        // of them is released. Every load maps the file again, so that updating the values of one load does not change
+        // those of another; until then, the pages of all the mappings of a file are the same ones in the page cache.
+        // Values on other devices are copied from the mapping, which is then not needed anymore.
+        const bool onCPU = device.Type() == DeviceKind::CPU;
+        auto file = std::make_shared<MappedModelFile>(filePath);
+
+        const auto header = ReadHeader(file->Data(), file->Size());
+        auto model = ReadModelDictionary(file->Data(), header);
+        if (!model.Contains(inputsKey))
+            return model;
+
+        for (const auto& inputValue : model[inputsKey].Value<std::vector<DictionaryValue>>())
+        {
+            const auto& input = inputValue.Value<Dictionary>();
+            if (!input.Contains(mappedValueKey))
+                continue;
+
+            auto mappedValue = GetMappedValue(input, file->Data(), header);
+            auto value = MakeSharedObject<NDArrayView>(mappedValue.dataType, mappedValue.shape, const_cast<char*>(mappedValue.data), mappedValue.size, DeviceDescriptor::CPUDevice());
+            if (onCPU)
+                SetMappingOwner(value, file);
+            values[mappedValue.uid] = onCPU ? value : value->DeepClone(device);
+        }
+        return model;
+    }
+
+    /*static*/ Dictionary MappedModel::LoadDictionary(const std::wstring& filePath)
+    {
+        MappedModelFile file(filePath);
+        return LoadDictionary(file.Data(), file.Size());
+    }
+
+    /*static*/ Dictionary MappedModel::LoadDictionary(const char* buffer, size_t bufferSize)
+    {
+        const auto header = ReadHeader(buffer, bufferSize);
+        auto model = ReadModelDictionary(buffer, header);
+        if (!model.Contains(inputsKey))
+            return model;
+
+        for (auto& inputValue : model[inputsKey].Value<std::vector<DictionaryValue>>())
+        {
+            const auto& input = inputValue.Value<Dictionary>();
+            if (!input.Contains(mappedValueKey))
+                continue;
+
+            auto mappedValue = GetMappedValue(input, buffer, header);
+            NDArrayView value(mappedValue.dataType, mappedValue.shape, (const void*)mappedValue.data, mappedValue.size, DeviceDescriptor::CPUDevice());
+            Dictionary inputWithValue = WithoutKey(input, mappedValueKey);
+            inputWithValue[valueKey] = value;
+            inputValue = inputWithValue;
+        }
+        return model;
+    }
+
+    namespace Internal
+    {
+        void ConvertModel(const std::wstring& sourceFilePath, const std::wstring& targetFilePath, ModelFormat targetFormat)
+        {
+            Dictionary model;
+            {
+                auto stream = GetFstream(sourceFilePath, true);
+                if (IsLegacyModel(*stream))
+                    InvalidArgument("ConvertModel: '%S' is a legacy model, which can only be converted by loading it with Function::Load() and saving it.", sourceFilePath.c_str());
+
+                if (MappedModel::IsMappedModel(*stream))
+                    model = MappedModel::LoadDictionary(sourceFilePath);
+                else
+                    *stream >> model;
+            }
+
+            switch (targetFormat)
+            {
+            case ModelFormat::CNTKv2:
+            {
+                auto stream = GetFstream(targetFilePath, false);
+                *stream << model;
+                stream->flush();
+                break;
+            }
+            case ModelFormat::CNTKv2Mapped:
+                MappedModel::Save(model, targetFilePath);
+                break;
+            default:
+                InvalidArgument("ConvertModel: Only models in the CNTKv2 and CNTKv2Mapped formats can be converted into each other.");
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include <istream>
+
+namespace CNTK
+{
+    //
+    // Model files in the CNTKv2Mapped format: the model Dictionary as in the CNTKv2 format, but with the dense values
+    // of its Parameters and Constants stored after it as raw blobs, each aligned to a cache line:
+    //
+    //   header | model Dictionary (protobuf) | padding to a page | blob | padding | blob | ...
+    //
+    // In the Dictionary, each of these Variables has a 'mapped_value' entry with the offset, size, data type and shape
+    // of its blob, in place of its 'value'. When loading on the CPU, the file is memory mapped copy-on-write and the
+    // values are NDArrayViews directly over the mapping: pages are only read from disk when first accessed, and all
+    // loads of the same file share them through the page cache (until their values are written to, e.g. when training).
+    //
+    class MappedModel
+    {
+    public:
+        static bool IsMappedModel(const char* buffer, size_t bufferSize);
+        static bool IsMappedModel(std::istream& stream);
+
+        // Writes the model Dictionary, as returned by Function::Serialize(), to filePath. The file is replaced, not overwritten,
+        // so the values of earlier loads of it are unchanged; on Windows, a file that values on the CPU were loaded from cannot be replaced.
+        static void Save(const Dictionary& model, const std::wstring& filePath);
+
+        // Returns the model Dictionary without the mapped values, which are returned by uid in 'values', on 'device'.
+        // If the values are on the CPU, they are views over a mapping of the file, which is kept for as long as any of them,
+        // or of the matrices that share their storage, is in use.
+        static Dictionary Load(const std::wstring& filePath, const DeviceDescriptor& device, std::unordered_map<std::wstring, NDArrayViewPtr>& values);
+
+        // Returns the model Dictionary with copies of all the values, as it is in the CNTKv2 format.
+        static Dictionary LoadDictionary(const std::wstring& filePath);
+        static Dictionary LoadDictionary(const char* buffer, size_t bufferSize);
+
+    private:
+        // Makes the storage of 'value', which is over 'mapping', keep the mapping.
+        static void SetMappingOwner(const NDArrayViewPtr& value, const std::shared_ptr<void>& mapping);
+    };
+}
@@ -637,6 +637,9 @@ namespace CNTK
             augmentedConfiguration[L"multiThreadedDeserialization"] = 
                 (configuration.isMultithreaded.IsInitialized()) ? configuration.isMultithreaded.Get() : defaultMultithreaded;
 
+            augmentedConfiguration[L"prefetchDepth"] = configuration.prefetchDepth;
+            augmentedConfiguration[L"prefetchThreads"] = configuration.numPrefetchThreads;
+
             augmentedConfiguration[L"deserializers"] = deserializers;
 
             return augmentedConfiguration;
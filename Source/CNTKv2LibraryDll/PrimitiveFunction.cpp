@@ -127,6 +127,7 @@ namespace CNTK
             (op == PrimitiveOpType::ReduceElements &&  anyOfAxesInReduction([](const Axis& axis) { return axis == Axis::AllAxes(); })) ||
             (op == PrimitiveOpType::SquaredError) ||
             (op == PrimitiveOpType::CrossEntropyWithSoftmax) ||
+            (op == PrimitiveOpType::SampledCrossEntropyWithSoftmax) ||
             (op == PrimitiveOpType::LatticeSequenceWithSoftmax) ||
             (op == PrimitiveOpType::EditDistanceError) ||
             (op == PrimitiveOpType::ClassificationError) ||
@@ -970,6 +971,30 @@ namespace CNTK
                             outputShape = {};
                             break;
                         }
+                        case PrimitiveOpType::SampledCrossEntropyWithSoftmax:
+                        {
+                            assert(m_inputs.size() == 4);
+                            auto numSamples = m_attributes[PrimitiveFunctionAttribute::AttributeNameNumSamples].Value<size_t>();
+                            if (numSamples == 0)
+                                InvalidArgument("SampledCrossEntropyWithSoftmax: Number of requested samples must be > 0.");
+
+                            // inputs are labels, inputs, weights [inputDim x numClasses] and samplingWeights [numClasses]
+                            let& labelsShape = m_inputs[0].Shape();
+                            let& inputsShape = m_inputs[1].Shape();
+                            let& weightsShape = m_inputs[2].Shape();
+                            let& samplingWeightsShape = m_inputs[3].Shape();
+                            if (labelsShape.Rank() != 1 || inputsShape.Rank() != 1 || weightsShape.Rank() != 2 || samplingWeightsShape.Rank() != 1)
+                                InvalidArgument("SampledCrossEntropyWithSoftmax: labels '%S', inputs '%S' and samplingWeights '%S' must be vectors, and weights '%S' a matrix.",
+                                                m_inputs[0].AsString().c_str(), m_inputs[1].AsString().c_str(), m_inputs[3].AsString().c_str(), m_inputs[2].AsString().c_str());
+
+                            auto compatible = [](size_t a, size_t b) { return a == NDShape::InferredDimension || b == NDShape::InferredDimension || a == b; };
+                            if (!compatible(weightsShape[0], inputsShape[0]) || !compatible(weightsShape[1], labelsShape[0]) || !compatible(samplingWeightsShape[0], labelsShape[0]))
+                                InvalidArgument("SampledCrossEntropyWithSoftmax: weights '%S' must be of shape [inputs x classes] for inputs '%S', labels '%S' and samplingWeights '%S'.",
+                                                m_inputs[2].AsString().c_str(), m_inputs[1].AsString().c_str(), m_inputs[0].AsString().c_str(), m_inputs[3].AsString().c_str());
+
+                            outputShape = {};
+                            break;
+                        }
                         case PrimitiveOpType::ForwardBackward:
                         {
                             assert(m_inputs.size() == 2);
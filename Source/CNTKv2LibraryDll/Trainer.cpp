@@ -10,6 +10,7 @@
 #include "PerformanceProfiler.h"
 #include "CompositeFunction.h"
 #include "Serialization.h"
+#include "AsyncCheckpointWriter.h"
 
 namespace
 {
@@ -17,6 +18,11 @@ namespace
     const std::wstring learnersPropertyName = L"Learners";
     const std::wstring externalStatePropertyName = L"ExternalState";
     const std::wstring distributedStatePropertyName = L"DistributedState";
+    const std::wstring lossScalingPropertyName = L"LossScaling";
+    const std::wstring lossScaleKey = L"lossScale";
+    const std::wstring dynamicLossScalingKey = L"dynamic";
+    const std::wstring lossScaleGrowthIntervalKey = L"growthInterval";
+    const std::wstring numMinibatchesSinceLossScaleChangeKey = L"numMinibatchesSinceChange";
 
     // Version history:
     // 0 -- a version number before the versioning was introduced for the trainer's checkpoints.
@@ -44,7 +50,11 @@ namespace CNTK
           m_distributed(false),
           m_aggregatedTrainingLossValue(std::make_shared<Accumulator>()),
           m_aggregatedTrainingEvalCriterionValue(),
-          m_prevDistributedTotalNumSamples(0)
+          m_prevDistributedTotalNumSamples(0),
+          m_lossScale(1),
+          m_dynamicLossScaling(false),
+          m_lossScaleGrowthInterval(0),
+          m_numMinibatchesSinceLossScaleChange(0)
     {
         std::vector<Variable> combinedFunctionArgs;
         if (m_model) // model is optional, since it may not be adding any information on top of lossFunction
@@ -212,7 +222,9 @@ namespace CNTK
         std::unordered_map<Parameter, NDArrayViewPtr> gradients;
         for (const auto& parameter : m_learnerParameters)
             gradients[parameter] = parameterGradients[parameter]->Data();
-        return m_parameterLearners->Update(gradients, m_prevMinibatchNumSamples, sweepEnd);
+        bool updated = m_parameterLearners->Update(gradients, m_prevMinibatchNumSamples, sweepEnd);
+        UpdateLossScale();
+        return updated;
     }
 
     bool Trainer::TrainDistributedMinibatch(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, bool sweepEnd, const DeviceDescriptor& computeDevice /*= DeviceDescriptor::UseDefaultDevice()*/)
@@ -251,6 +263,7 @@ namespace CNTK
 
         MinibatchInfo info{ arguments.empty(), sweepEnd, m_prevMinibatchNumSamples, trainingLoss, evalCriterion };
         bool updated = m_parameterLearners->Update(gradients, info);
+        UpdateLossScale(); // the learners see the aggregated gradients, so all workers agree on the loss scale
 
         // Here we update m_prevMinibatchNumSamples with aggregated value in the
         // case of distributed learner.
@@ -349,6 +362,49 @@ namespace CNTK
     }
 
 
+    void Trainer::SetLossScaling(double lossScale, bool dynamic, size_t growthInterval)
+    {
+        if (lossScale <= 0)
+            InvalidArgument("Trainer::SetLossScaling: The loss scale must be positive.");
+        if (dynamic && growthInterval == 0)
+            InvalidArgument("Trainer::SetLossScaling: The growth interval must be positive.");
+        if (dynamic)
+        {
+            // a learner that cannot skip an update would apply overflowing gradients
+            for (const auto& learner : m_parameterLearners->ParameterLearners())
+                if (!learner->SupportsLossScaling())
+                    InvalidArgument("Trainer::SetLossScaling: Dynamic loss scaling requires all learners to support loss scaling, see Learner::SupportsLossScaling().");
+        }
+
+        m_lossScale = lossScale;
+        m_dynamicLossScaling = dynamic;
+        m_lossScaleGrowthInterval = growthInterval;
+        m_numMinibatchesSinceLossScaleChange = 0;
+        m_parameterLearners->SetLossScale(m_lossScale, m_dynamicLossScaling);
+    }
+
+    // With dynamic loss scaling, halves the loss scale if the learners skipped the last minibatch because of overflowing
+    // gradients, and doubles it after m_lossScaleGrowthInterval minibatches without overflow.
+    void Trainer::UpdateLossScale()
+    {
+        if (!m_dynamicLossScaling)
+            return;
+
+        const double maxLossScale = 16777216; // 2^24, a bound for long runs without overflow
+        if (m_parameterLearners->GradientsOverflowed())
+        {
+            m_lossScale = std::max(m_lossScale / 2, 1.0);
+            m_numMinibatchesSinceLossScaleChange = 0;
+        }
+        else if (++m_numMinibatchesSinceLossScaleChange >= m_lossScaleGrowthInterval && m_lossScale < maxLossScale)
+        {
+            m_lossScale *= 2;
+            m_numMinibatchesSinceLossScaleChange = 0;
+        }
+        // this also resets the overflow state of the learners
+        m_parameterLearners->SetLossScale(m_lossScale, m_dynamicLossScaling);
+    }
+
     void Trainer::ExecuteForwardBackward(const std::unordered_map<Variable, ValuePtr>& arguments, std::unordered_map<Variable, ValuePtr>& outputsToFetch, const DeviceDescriptor& computeDevice, std::unordered_map<Variable, ValuePtr>& parameterGradients)
     {
 #ifndef  CNTK_UWP
@@ -382,12 +438,13 @@ namespace CNTK
 
         DataType aggregateDataType = m_aggregatedLossFunction->Output().GetDataType();
 
+        // the root gradient is the loss scale, which is 1 unless loss scaling is enabled
         if (aggregateDataType == DataType::Float)
-            m_rootGradientValue->Data()->SetValue(1.0f);
+            m_rootGradientValue->Data()->SetValue((float)m_lossScale);
         else if (aggregateDataType == DataType::Double)
-            m_rootGradientValue->Data()->SetValue(1.0);
+            m_rootGradientValue->Data()->SetValue(m_lossScale);
         else if (aggregateDataType == DataType::Float16)
-            m_rootGradientValue->Data()->SetValue(float16(1.0));
+            m_rootGradientValue->Data()->SetValue(float16((float)m_lossScale));
         else
             RuntimeError("DataType %s is not supported for root gradients", DataTypeName(aggregateDataType));
 
@@ -407,10 +464,30 @@ namespace CNTK
 
     void Trainer::SaveCheckpoint(const std::wstring& modelFilePath, Dictionary externalState)
     {
+        SaveCheckpoint(modelFilePath, externalState, /*asynchronous =*/ false);
+    }
+
+    void Trainer::SaveCheckpointAsync(const std::wstring& modelFilePath, Dictionary externalState)
+    {
+        SaveCheckpoint(modelFilePath, externalState, /*asynchronous =*/ true);
+    }
+
+    void Trainer::WaitForPendingCheckpoint()
+    {
+        if (m_checkpointWriter)
+            m_checkpointWriter->Wait();
+    }
+
+    void Trainer::SaveCheckpoint(const std::wstring& modelFilePath, const Dictionary& externalState, bool asynchronous)
+    {
+        // All workers create the writer at the same time, see RestoreFromCheckpoint().
+        if (asynchronous && !m_checkpointWriter)
+            m_checkpointWriter = std::make_shared<Microsoft::MSR::CNTK::AsyncCheckpointWriter>();
+
         auto learnersState = m_parameterLearners->CreateCheckpoint();
 
         if (!m_distributed)
-            return Save(modelFilePath, learnersState, externalState);
+            return Save(modelFilePath, learnersState, externalState, Dictionary(), asynchronous);
 
         auto compositeFunction = dynamic_cast<CompositeFunction*>(m_combinedTrainingFunction.get());
 
@@ -432,14 +509,15 @@ namespace CNTK
         }
 
         if (communicator->CurrentWorker().IsMain())
-            Save(modelFilePath, learnersState, externalState, aggregatedState);
+            Save(modelFilePath, learnersState, externalState, aggregatedState, asynchronous);
 
         // all workers need to sync up after saving model to avoid read-after-write hazard
         // i.e. one worker is in the middle of write while another tries to read
+        // (for asynchronous checkpoints, RestoreFromCheckpoint() waits for the write)
         communicator->Barrier();
     }
 
-    void Trainer::Save(const std::wstring& modelFilePath, const std::vector<DictionaryValue>& learnerState, const Dictionary& externalState, const Dictionary& distributedState)
+    void Trainer::Save(const std::wstring& modelFilePath, const std::vector<DictionaryValue>& learnerState, const Dictionary& externalState, const Dictionary& distributedState, bool asynchronous)
     {
         std::wstring tempModelFile = modelFilePath + L".tmp";
         Dictionary state;
@@ -448,6 +526,38 @@ namespace CNTK
         state[externalStatePropertyName] = externalState;
         state[distributedStatePropertyName] = distributedState;
 
+        // so that a resumed mixed-precision run does not start over from the initial loss scale
+        Dictionary lossScaling;
+        lossScaling[lossScaleKey] = m_lossScale;
+        lossScaling[dynamicLossScalingKey] = m_dynamicLossScaling;
+        lossScaling[lossScaleGrowthIntervalKey] = m_lossScaleGrowthInterval;
+        lossScaling[numMinibatchesSinceLossScaleChangeKey] = m_numMinibatchesSinceLossScaleChange;
+        state[lossScalingPropertyName] = lossScaling;
+
+        if (asynchronous)
+        {
+            // The dictionaries hold CPU copies of the parameters and the learner state (see DictionaryValue),
+            // i.e. they are a snapshot that the background thread serializes while training goes on.
+            auto model = std::make_shared<Dictionary>(m_combinedTrainingFunction->Serialize());
+            auto trainerState = std::make_shared<Dictionary>(std::move(state));
+            m_checkpointWriter->Submit({
+                { modelFilePath, [model](const std::wstring& fileName)
+                {
+                    {
+                        auto stream = GetFstream(fileName, false);
+                        *stream << *model;
+                        stream->flush();
+                    }
+                    fsyncOrDie(fileName);
+                } },
+                { GetTrainerStateCheckpointFilePath(modelFilePath), [trainerState](const std::wstring& fileName)
+                {
+                    trainerState->Save(fileName);
+                    fsyncOrDie(fileName);
+                } } });
+            return;
+        }
+
         m_combinedTrainingFunction->Save(tempModelFile);
         std::wstring trainerStateCheckpointFilePath = GetTrainerStateCheckpointFilePath(modelFilePath);
         std::wstring tempCheckpointFile = trainerStateCheckpointFilePath + L".tmp";
@@ -464,6 +574,14 @@ namespace CNTK
 
     Dictionary Trainer::RestoreFromCheckpoint(const std::wstring& modelFilePath)
     {
+        // The checkpoint may still be written by the main worker.
+        if (m_checkpointWriter)
+        {
+            m_checkpointWriter->Wait();
+            if (m_distributed)
+                MPICommunicator()->Barrier();
+        }
+
         // Restore the model's parameters
         m_combinedTrainingFunction->Restore(modelFilePath);
 
@@ -479,6 +597,17 @@ namespace CNTK
 
         m_parameterLearners->RestoreFromCheckpoint(learnerState);
 
+        // checkpoints written before loss scaling was added keep the current settings
+        if (checkpoint.Contains(lossScalingPropertyName))
+        {
+            const Dictionary& lossScaling = checkpoint[lossScalingPropertyName].Value<Dictionary>();
+            m_lossScale = lossScaling[lossScaleKey].Value<double>();
+            m_dynamicLossScaling = lossScaling[dynamicLossScalingKey].Value<bool>();
+            m_lossScaleGrowthInterval = lossScaling[lossScaleGrowthIntervalKey].Value<size_t>();
+            m_numMinibatchesSinceLossScaleChange = lossScaling[numMinibatchesSinceLossScaleChangeKey].Value<size_t>();
+            m_parameterLearners->SetLossScale(m_lossScale, m_dynamicLossScaling);
+        }
+
         if (!m_distributed)
         {
             return externalState;
@@ -35,12 +35,14 @@ namespace CNTK
         size_t checkpointFrequency,
         DataUnit checkpointFrequencyUnit,
         bool restoreFromCheckpointIfExists,
-        bool preserveAllCheckpoints) :
+        bool preserveAllCheckpoints,
+        bool asynchronous) :
         m_preserveAll(preserveAllCheckpoints),
         m_restore(restoreFromCheckpointIfExists),
         m_fileName(checkPointFileName),
         m_frequency(checkpointFrequency),
-        m_frequencyUnit(checkpointFrequencyUnit)
+        m_frequencyUnit(checkpointFrequencyUnit),
+        m_asynchronous(asynchronous)
     {
         if (m_fileName.empty())
         {
@@ -252,6 +254,9 @@ namespace CNTK
             }
         }
 
+        // The last periodic checkpoint must be on disk before the session is done.
+        Trainer()->WaitForPendingCheckpoint();
+
         // In case of incremental - save final checkpoint.
         // This is required only when we keep all existing checkpoints, otherwise 
         // The checkpoint was already saved with the proper name.
@@ -415,7 +420,12 @@ namespace CNTK
         wstring checkpointFile = m_checkpoint.m_fileName;
         if (m_checkpoint.m_preserveAll)
             checkpointFile += std::to_wstring(currentIndex);
-        Trainer()->SaveCheckpoint(checkpointFile, externalState);
+
+        // With asynchronous checkpoints OnCheckpointEnd() is called once the snapshot is taken, not when the files are on disk.
+        if (m_checkpoint.m_asynchronous)
+            Trainer()->SaveCheckpointAsync(checkpointFile, externalState);
+        else
+            Trainer()->SaveCheckpoint(checkpointFile, externalState);
         OnCheckpointEnd(currentIndex);
     }
 
@@ -1093,6 +1093,9 @@ namespace CNTK
         m_learners(learners),
         m_isDistributed(false),
         m_metricAggregatingLearner(nullptr),
+        m_lossScale(1),
+        m_dynamicLossScaling(false),
+        m_gradientsOverflowed(false),
         DoAggregateMetricsIfNeededLambda(nullptr)
     {
         if (learners.empty())
@@ -1178,10 +1181,87 @@ namespace CNTK
 
             learnerGradients[parameter] = value->second;
         }
+
+        // learners that do not support loss scaling get the gradients unscaled
+        if (m_lossScale == 1 || learner->SupportsLossScaling())
+            return;
+        for (const auto& gradient : learnerGradients)
+        {
+            if (!gradient.second) // empty minibatch of a distributed learner
+                continue;
+            switch (gradient.second->GetDataType())
+            {
+            case DataType::Float:
+                Matrix<float>::Scale((float)(1 / m_lossScale), *gradient.second->GetWritableMatrix<float>());
+                break;
+            case DataType::Double:
+                Matrix<double>::Scale(1 / m_lossScale, *gradient.second->GetWritableMatrix<double>());
+                break;
+            case DataType::Float16:
+                Matrix<half>::Scale((half)(float)(1 / m_lossScale), *gradient.second->GetWritableMatrix<half>());
+                break;
+            default:
+                NOT_IMPLEMENTED;
+            }
+        }
+    }
+
+    /*static*/ bool Learners::GradientsHaveNanOrInf(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues)
+    {
+        for (const auto& gradient : gradientValues)
+        {
+            if (!gradient.second) // empty minibatch of a distributed learner
+                continue;
+            bool hasNanOrInf;
+            switch (gradient.second->GetDataType())
+            {
+            case DataType::Float:
+                hasNanOrInf = gradient.second->GetMatrix<float>()->HasNanOrInf();
+                break;
+            case DataType::Double:
+                hasNanOrInf = gradient.second->GetMatrix<double>()->HasNanOrInf();
+                break;
+            case DataType::Float16:
+                hasNanOrInf = gradient.second->GetMatrix<half>()->HasNanOrInf();
+                break;
+            default:
+                NOT_IMPLEMENTED;
+            }
+            if (hasNanOrInf)
+                return true;
+        }
+        return false;
+    }
+
+    // With dynamic loss scaling, checks the gradients of all learners at once, so that a minibatch whose gradients
+    // overflowed is skipped by all learners, on all workers, and not applied in part.
+    void Learners::SkipUpdatesIfGradientsOverflowed(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues)
+    {
+        m_gradientsOverflowed = false;
+        if (!m_dynamicLossScaling)
+            return;
+
+        m_gradientsOverflowed = GradientsHaveNanOrInf(gradientValues);
+        if (m_isDistributed)
+        {
+            // an overflow on any worker makes the aggregated gradients overflow as well
+            auto communicator = dynamic_pointer_cast<DistributedLearner>(m_learners.front())->GetCommunicator();
+            auto overflowed = MakeSharedObject<NDArrayView>(m_gradientsOverflowed ? 1.0 : 0.0, DataType::Float, NDShape{}, DeviceDescriptor::CPUDevice());
+            communicator->AggregateInPlace({ overflowed }, communicator->Workers());
+            m_gradientsOverflowed = overflowed->AsScalar<float>() > 0;
+        }
+
+        if (m_gradientsOverflowed)
+        {
+            for (const auto& learner : m_learners)
+                learner->SkipNextUpdate();
+        }
     }
 
     bool Learners::Update(std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues, size_t sampleInMinibatch, bool sweepEnd)
     {
+        SkipUpdatesIfGradientsOverflowed(gradientValues);
+
         bool anyUpdatesPerformed = false;
         for (auto learner : m_learners)
         {
@@ -1204,6 +1284,8 @@ namespace CNTK
             minibatch.trainingLossValue->DeepClone(),
             minibatch.evalCriterionValue->DeepClone() };
 
+        SkipUpdatesIfGradientsOverflowed(gradientValues);
+
         bool metricAggregatorUpdated = false;
         bool anyUpdatesPerformed = false;
         size_t metricAggregatorIndex = 0;
@@ -657,15 +657,35 @@ namespace CNTK
             return m_isDistributed;
         }
 
+        void SetLossScale(double lossScale, bool dynamic)
+        {
+            m_lossScale = lossScale;
+            m_dynamicLossScaling = dynamic;
+            m_gradientsOverflowed = false;
+            for (const auto& l : m_learners)
+                l->SetLossScale(lossScale);
+        }
+
+        // true if the gradients of the last minibatch overflowed, so that none of the learners applied them, see Trainer::SetLossScaling()
+        bool GradientsOverflowed() const
+        {
+            return m_gradientsOverflowed;
+        }
+
         std::function<void(NDArrayViewPtr&, NDArrayViewPtr&)> DoAggregateMetricsIfNeededLambda;
         
     private:
         void GetLearnerGradients(LearnerPtr learner, const std::unordered_map<Parameter, NDArrayViewPtr>& allGradients, std::unordered_map<Parameter, NDArrayViewPtr>& learnerGradients);
         void CheckDistributedLearners();
+        void SkipUpdatesIfGradientsOverflowed(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues);
+        static bool GradientsHaveNanOrInf(const std::unordered_map<Parameter, NDArrayViewPtr>& gradientValues);
 
         std::vector<LearnerPtr> m_learners;
         bool m_isDistributed;
         LearnerPtr m_metricAggregatingLearner;
+        double m_lossScale; // undone here for the learners that do not support loss scaling
+        bool m_dynamicLossScaling;
+        bool m_gradientsOverflowed;
     };
 
     class Utils
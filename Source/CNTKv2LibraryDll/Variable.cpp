@@ -494,6 +494,11 @@ namespace CNTK
     }
 
     /*static*/ Variable Variable::Deserialize(const Dictionary& dict, const CNTK::DeviceDescriptor& device)
+    {
+        return Deserialize(dict, device, {});
+    }
+
+    /*static*/ Variable Variable::Deserialize(const Dictionary& dict, const CNTK::DeviceDescriptor& device, const std::unordered_map<std::wstring, NDArrayViewPtr>& mappedValues)
     {
         static const vector<std::wstring> s_requiredDictionaryKeys = { typeKey, uidKey, kindKey, dataTypeKey, dynamicAxisKey, isSparseKey, needsGradientKey, shapeKey };
 
@@ -544,11 +549,23 @@ namespace CNTK
 
         if (kind == VariableKind::Constant || kind == VariableKind::Parameter)
         {
-            auto& value = dict[valueKey].Value<NDArrayView>();
+            NDArrayViewPtr value;
+            auto mappedValue = mappedValues.find(uid);
+            if (mappedValue != mappedValues.end())
+            {
+                // already on the device, and on the CPU directly over the mapped model file
+                value = mappedValue->second;
+            }
+            else
+            {
+                auto& dictValue = dict[valueKey].Value<NDArrayView>();
+
+                // TODO: this copying here is redundant, value should be moved from the dictionary to the variable.
+                // Also, the correct device should be used upfront when deserializing NDArrayView.
+                value = dictValue.DeepClone(device, dictValue.IsReadOnly());
+            }
 
-            // TODO: this copying here is redundant, value should be moved from the dictionary to the variable.
-            // Also, the correct device should be used upfront when deserializing NDArrayView.
-            Variable var(shape, kind, dataType, value.DeepClone(device, value.IsReadOnly()), needsGradient, dynamicAxis, isSparse, name, uid);
+            Variable var(shape, kind, dataType, value, needsGradient, dynamicAxis, isSparse, name, uid);
             if (var.IsParameter())
                 return Parameter(var);
             else
@@ -129,6 +129,11 @@ void File::Init(const wchar_t* filename, int fileOptions)
     //  - "cmd|" reads from a pipe
     m_pcloseNeeded = false;
     m_seekable = false;
+    m_staging = false;
+#ifndef _WIN32
+    m_stagingBuffer = nullptr;
+    m_stagingSize = 0;
+#endif
     if (m_filename == L"-") // stdin/stdout
     {
         if (writing && reading)
@@ -159,6 +164,67 @@ void File::Init(const wchar_t* filename, int fileOptions)
                 });
 }
 
+// only used by CreateStagingFile()
+File::File()
+    : m_file(nullptr), m_pcloseNeeded(false), m_seekable(false), m_options(0), m_staging(true)
+{
+#ifndef _WIN32
+    m_stagingBuffer = nullptr;
+    m_stagingSize = 0;
+#endif
+}
+
+/*static*/ unique_ptr<File> File::CreateStagingFile(int fileOptions)
+{
+    if (!(fileOptions & fileOptionsBinary) || (fileOptions & (fileOptionsRead | fileOptionsAppend)))
+        LogicError("File: staging files can only be written in binary mode.");
+
+    unique_ptr<File> file(new File());
+    file->m_filename = L"<staging>";
+    file->m_options = fileOptions | fileOptionsWrite;
+#ifdef _WIN32
+    // No memory streams in the CRT. The file system cache keeps a temporary file in memory as long as there
+    // is enough of it, and the file is deleted when closed.
+    if (tmpfile_s(&file->m_file) != 0)
+        file->m_file = nullptr;
+#else
+    file->m_file = open_memstream(&file->m_stagingBuffer, &file->m_stagingSize);
+#endif
+    if (file->m_file == nullptr)
+        RuntimeError("File: cannot create staging file: %s", strerror(errno));
+    file->m_seekable = true;
+    return file;
+}
+
+void File::WriteStagedTo(const wstring& filename)
+{
+    if (!m_staging)
+        LogicError("File: WriteStagedTo() called for '%ls', which is not a staging file.", m_filename.c_str());
+
+    fflushOrDie(m_file);
+    FILE* f = fopenOrDie(filename, L"wb");
+#ifdef _WIN32
+    auto end = fgetpos(m_file);
+    fsetpos(m_file, 0);
+    vector<char> buffer(WRITE_BUFFER_SIZE);
+    for (uint64_t pos = 0; pos < end;)
+    {
+        size_t n = (size_t) min<uint64_t>(buffer.size(), end - pos);
+        freadOrDie(buffer.data(), 1, n, m_file);
+        fwriteOrDie(buffer.data(), 1, n, f);
+        pos += n;
+    }
+    fsetpos(m_file, end);
+#else
+    // fflush() updated m_stagingBuffer and m_stagingSize.
+    fwriteOrDie(m_stagingBuffer, 1, m_stagingSize, f);
+#endif
+    fflushOrDie(f);
+    fsyncOrDie(f);
+    if (fclose(f) != FCLOSE_SUCCESS)
+        RuntimeError("File: failed to close file at %ls", filename.c_str());
+}
+
 // determine the directory for a given pathname
 // (wstring only for now; feel free to make this a template if needed)
 /*static*/ wstring File::DirectoryPathOf(wstring path)
@@ -295,6 +361,9 @@ File::~File(void)
             RuntimeError("File: failed to close file at %S", m_filename.c_str());
         }
     }
+#ifndef _WIN32
+    free(m_stagingBuffer); // allocated by open_memstream()
+#endif
 }
 
 void File::Flush()
@@ -17,6 +17,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
     std::atomic<bool> Globals::m_enableShareNodeValueMatrices(true);
     std::atomic<bool> Globals::m_optimizeGradientAccumulation(true);
     std::atomic<bool> Globals::m_enableNodeTiming(false);
+    std::atomic<bool> Globals::m_useMemoryArena(false);
+    std::atomic<bool> Globals::m_optimizeRecurrentLoops(false);
     std::atomic<bool> Globals::m_useV2Aggregator(false);
     std::atomic<std::size_t> Globals::m_mpiPackThresholdInBytes(DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES);
 }}}
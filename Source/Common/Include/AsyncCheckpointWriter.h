@@ -0,0 +1,106 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// AsyncCheckpointWriter.h -- writes checkpoint files to disk on a background thread
+//
+
+#pragma once
+
+#include "Basics.h"
+#include "fileutil.h"
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Writes checkpoints on a background thread, so that training only waits for the snapshot of its state.
+//
+// A checkpoint consists of one or more files. Each file is written by a function of its own into '<file>.tmp',
+// which must also make sure that it is on disk (see File::WriteStagedTo() and fsyncOrDie()). Once all files
+// are written, they are renamed to their final names in the given order, so that a checkpoint file is either
+// complete or not there at all, even if the process dies while writing.
+//
+// At most one checkpoint is in flight: Submit() waits for the previous one. The memory for staged checkpoints
+// is therefore bounded by the size of one checkpoint, which the write functions own.
+// Errors of the background thread are rethrown by the next Wait() or Submit().
+class AsyncCheckpointWriter
+{
+public:
+    struct CheckpointFile
+    {
+        std::wstring m_fileName;
+        std::function<void(const std::wstring& tempFileName)> m_write;
+    };
+
+    AsyncCheckpointWriter()
+    {}
+
+    ~AsyncCheckpointWriter()
+    {
+        try
+        {
+            Wait();
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "AsyncCheckpointWriter: failed to write the last checkpoint: %s\n", e.what());
+        }
+    }
+
+    // 'onCompleted' is called on the background thread after all files are in place, e.g. to delete older checkpoints.
+    void Submit(std::vector<CheckpointFile> files, std::function<void()> onCompleted = nullptr)
+    {
+        Wait();
+        m_thread = std::thread([this, files, onCompleted]()
+        {
+            try
+            {
+                WriteCheckpoint(files);
+                if (onCompleted)
+                    onCompleted();
+            }
+            catch (...)
+            {
+                m_error = std::current_exception();
+            }
+        });
+    }
+
+    // Waits until the pending checkpoint, if any, is on disk.
+    void Wait()
+    {
+        if (m_thread.joinable())
+            m_thread.join();
+
+        if (m_error)
+        {
+            auto error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    static void WriteCheckpoint(const std::vector<CheckpointFile>& files)
+    {
+        for (const auto& file : files)
+            file.m_write(file.m_fileName + L".tmp");
+
+        for (const auto& file : files)
+        {
+            _wunlink(file.m_fileName.c_str()); // the return value is ignored here
+            renameOrDie(file.m_fileName + L".tmp", file.m_fileName);
+        }
+    }
+
+private:
+    std::thread m_thread;
+    std::exception_ptr m_error; // set by the background thread, read after joining it
+
+    DISABLE_COPY_AND_MOVE(AsyncCheckpointWriter);
+};
+
+}}}
@@ -10,5 +10,7 @@
 // The default threshold size to pack a gradient into a continuous buffer during aggregation for less MPI ops.
 const std::size_t DEFAULT_PACK_THRESHOLD_SIZE_IN_KB = 32 * 1024;
 const std::size_t DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES = DEFAULT_PACK_THRESHOLD_SIZE_IN_KB * 1024;
+// The default size of the fusion buckets in which gradients are aggregated while backprop is still running.
+const std::size_t DEFAULT_FUSION_BUCKET_SIZE_IN_KB = 16 * 1024;
 
 #endif
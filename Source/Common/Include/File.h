@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <memory>
 #include <stdint.h>
 #ifdef _WIN32
 #ifndef NOMINMAX
@@ -102,7 +103,13 @@ private:
     bool m_pcloseNeeded; // was opened with popen(), use pclose() when destructing
     bool m_seekable;     // this stream is seekable
     int m_options;       // FileOptions ored togther
+#ifndef _WIN32
+    char* m_stagingBuffer; // for files from CreateStagingFile(): the memory that open_memstream() writes to
+    size_t m_stagingSize;
+#endif
+    bool m_staging;
     void Init(const wchar_t* filename, int fileOptions);
+    File();
 
 public:
     File(const std::wstring& filename, int fileOptions);
@@ -110,6 +117,14 @@ public:
     File(const wchar_t* filename, int fileOptions);
     ~File();
 
+    // Creates a binary file for writing that is not backed by a named file on disk, to stage content
+    // in memory, e.g. a checkpoint that a background thread writes to disk later by WriteStagedTo().
+    static std::unique_ptr<File> CreateStagingFile(int fileOptions);
+
+    // For files from CreateStagingFile(): writes everything staged so far to 'filename' and syncs it to disk.
+    // Must not be called concurrently with writing to this File.
+    void WriteStagedTo(const std::wstring& filename);
+
     void Flush();
 
     bool CanSeek() const { return m_seekable; }
@@ -165,6 +180,20 @@ public:
             fput(m_file, val);
         return *this;
     }
+    // put an array of basic types; a single write in binary mode, same content as putting the elements one by one
+    template <typename T>
+    File& PutArray(const T* val, size_t count)
+    {
+        if (IsTextBased())
+        {
+            for (size_t i = 0; i < count; i++)
+                fputText(m_file, val[i]);
+        }
+        else if (count > 0)
+            fwriteOrDie(val, sizeof(T), count, m_file);
+        return *this;
+    }
+
     File& operator<<(const std::wstring& val);
     File& operator<<(const std::string& val);
     File& operator<<(FileMarker marker);
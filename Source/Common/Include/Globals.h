@@ -28,6 +28,12 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         static void SetShareNodeValueMatrices(bool enable) { m_enableShareNodeValueMatrices = enable; }
         static bool ShouldEnableShareNodeValueMatrices() { return m_enableShareNodeValueMatrices; }
 
+        static void SetMemoryArena(bool enable) { m_useMemoryArena = enable; }
+        static bool ShouldUseMemoryArena() { return m_useMemoryArena; }
+
+        static void SetRecurrentLoopOptimization(bool enable) { m_optimizeRecurrentLoops = enable; }
+        static bool ShouldOptimizeRecurrentLoops() { return m_optimizeRecurrentLoops; }
+
         static void SetNodeTiming(bool enable) { m_enableNodeTiming = enable; }
         static bool ShouldEnableNodeTiming() { return m_enableNodeTiming; }
 
@@ -40,6 +46,10 @@ namespace Microsoft { namespace MSR { namespace CNTK {
         static std::atomic<bool> m_forceConstantRandomSeed;
         static std::atomic<bool> m_optimizeGradientAccumulation;
         static std::atomic<bool> m_enableNodeTiming;
+        // Plan the shared matrices of each device as slots of one arena, see MatrixPool
+        static std::atomic<bool> m_useMemoryArena;
+        // Default of ComputationNetwork::SetOptimizeRecurrentLoops() for networks created after it is set
+        static std::atomic<bool> m_optimizeRecurrentLoops;
         static std::atomic<bool> m_useV2Aggregator;
         static std::atomic<std::size_t> m_mpiPackThresholdInBytes;
     };
@@ -137,6 +137,14 @@ void fprintfOrDie(FILE* f, const char* format, ...);
 
 void fflushOrDie(FILE* f);
 
+// ----------------------------------------------------------------------------
+// fsyncOrDie(): like fsync() but terminate with err msg in case of error
+// The path version syncs a file that has been written and closed already.
+// ----------------------------------------------------------------------------
+
+void fsyncOrDie(FILE* f);
+void fsyncOrDie(const std::wstring& pathname);
+
 // ----------------------------------------------------------------------------
 // filesize(): determine size of the file in bytes
 // ----------------------------------------------------------------------------
@@ -62,11 +62,15 @@ enum mbrclassdefinition // used to identify definition of class in minimum bayes
     // monophonestate = 2,
     monophone = 3, // pMBR?
 };
+class LatticeTestRunner;
+
 // ===========================================================================
 // lattice -- one lattice in memory
 // ===========================================================================
 class lattice
 {
+    friend class LatticeTestRunner;
+
 public: 
     struct header_v1_v2
     {
@@ -762,6 +766,22 @@ private:
                                   std::vector<double>& logEframescorrect, std::vector<double>& Eframescorrectbuf,
                                   double& logEframescorrecttotal) const;
 
+    // native CPU version of forwardbackwardlattice(), over a structure-of-arrays copy of the topology; returns false if the lattice is not sorted as required
+    bool cpuforwardbackwardlattice(const std::vector<float>& edgeacscores, std::vector<double>& logpps,
+                                   std::vector<double>& logalphas, std::vector<double>& logbetas,
+                                   const float lmf, const float wp, const float amf, const bool sMBRmode,
+                                   const_array_ref<size_t>& uids, const edgealignments& thisedgealignments,
+                                   std::vector<double>& logEframescorrect, std::vector<double>& Eframescorrectbuf,
+                                   double& logEframescorrecttotal, double& totalscore) const;
+
+    // edge-serial version of forwardbackwardlattice(), used when the lattice is not sorted as cpuforwardbackwardlattice() requires
+    double edgeserialforwardbackwardlattice(const std::vector<float>& edgeacscores, std::vector<double>& logpps,
+                                            std::vector<double>& logalphas, std::vector<double>& logbetas,
+                                            const float lmf, const float wp, const float amf, const bool sMBRmode,
+                                            const_array_ref<size_t>& uids, const edgealignments& thisedgealignments,
+                                            std::vector<double>& logEframescorrect, std::vector<double>& Eframescorrectbuf,
+                                            double& logEframescorrecttotal) const;
+
 public:
     // construct from a HTK lattice file
     void fromhtklattice(const std::wstring& path, const std::unordered_map<std::string, size_t>& unitmap);
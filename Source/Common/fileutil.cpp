@@ -458,6 +458,14 @@ void fsyncOrDie(FILE* f)
 #endif
 }
 
+void fsyncOrDie(const std::wstring& pathname)
+{
+    // Windows only flushes through a handle that is open for writing.
+    FILE* f = fopenOrDie(pathname, L"r+b");
+    fsyncOrDie(f);
+    fcloseOrDie(f);
+}
+
 // ----------------------------------------------------------------------------
 // fflushOrDie(): like fflush() but terminate with err msg in case of error
 // ----------------------------------------------------------------------------
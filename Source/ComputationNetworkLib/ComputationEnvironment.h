@@ -46,6 +46,12 @@ struct ComputationEnvironment
 
     bool isV2Library = false;
 
+    // recurrent loops are run with the execution plan from ComputationNetwork::OptimizeRecurrentLoops(); off by default, since it changes the rounding of existing models
+    bool optimizeRecurrentLoops = false;
+
+    // value of the root gradient in Backprop(); larger than 1 with loss scaling, which keeps small half gradients from flushing to zero
+    double lossScale = 1;
+
     // traceLevel
     int traceLevel = 0;
 
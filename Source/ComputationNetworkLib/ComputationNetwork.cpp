@@ -53,6 +53,24 @@ vector<MemRequestInfo<half>>& MatrixPool::GetMemRequestInfoVec<half>()
     return m_memRequestInfoHalfVec;
 }
 
+template <>
+map<DEVICEID_TYPE, shared_ptr<Matrix<float>>>& MatrixPool::GetArenas<float>()
+{
+    return m_arenasFloat;
+}
+
+template <>
+map<DEVICEID_TYPE, shared_ptr<Matrix<double>>>& MatrixPool::GetArenas<double>()
+{
+    return m_arenasDouble;
+}
+
+template <>
+map<DEVICEID_TYPE, shared_ptr<Matrix<half>>>& MatrixPool::GetArenas<half>()
+{
+    return m_arenasHalf;
+}
+
 // -----------------------------------------------------------------------
 // construction
 // -----------------------------------------------------------------------
@@ -120,12 +138,24 @@ void ComputationNetwork::Save(const wstring& fileName, const FileOptions fileFor
     renameOrDie(tmpFileName, fileName);
 }
 
-// TODO: how does the file distinguish float vs double nodes?
+// save into an open file, e.g. one from File::CreateStagingFile() that is written to disk later
+void ComputationNetwork::Save(File& fstream) const
+{
+    VerifyIsCompiled("Save");
+    SaveToFileImpl(fstream);
+}
+
 void ComputationNetwork::SaveToFileImpl(const wstring& fileName, const FileOptions fileFormat) const
 {
     File fstream(fileName, fileFormat | FileOptions::fileOptionsWrite);
     // Buffer writes in memory then flush to filesystem, which reduces number of small writes
     fstream.Setvbuf();
+    SaveToFileImpl(fstream);
+}
+
+// TODO: how does the file distinguish float vs double nodes?
+void ComputationNetwork::SaveToFileImpl(File& fstream) const
+{
     fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCN");
 
     // model version
@@ -725,6 +755,65 @@ void ComputationNetwork::SetSeqParam(ComputationNetworkPtr net,
     }
 }
 
+template <class ElemType, bool m_transpose>
+static bool SetInt8EvaluationForTimesNode(const ComputationNodeBasePtr& nodeBase, bool enable)
+{
+    auto node = dynamic_pointer_cast<TimesNodeBase<ElemType, m_transpose>>(nodeBase);
+    if (!node)
+        return false;
+    shared_ptr<QuantizedMultiplier<ElemType>> pQuantizedMultiplier;
+    if (enable)
+    {
+        // only products with a weight are worth quantizing; the weight is quantized once
+        bool isAConstant = dynamic_pointer_cast<LearnableParameter<ElemType>>(node->GetInputs()[0]) != nullptr;
+        bool isBConstant = !isAConstant && dynamic_pointer_cast<LearnableParameter<ElemType>>(node->GetInputs()[1]) != nullptr;
+        if (!isAConstant && !isBConstant)
+            return false;
+        pQuantizedMultiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(isAConstant, isBConstant);
+    }
+    node->SetQuantizedMultiplier(pQuantizedMultiplier);
+    return enable;
+}
+
+template <class ElemType>
+static bool SetInt8EvaluationForConvolutionNode(const ComputationNodeBasePtr& nodeBase, bool enable)
+{
+    auto node = dynamic_pointer_cast<ConvolutionNode<ElemType>>(nodeBase);
+    if (!node)
+        return false;
+    shared_ptr<QuantizedMultiplier<ElemType>> pQuantizedMultiplier;
+    if (enable)
+    {
+        // The forward pass of a transposed convolution is the backward pass of the engine, which is not quantized.
+        if (node->Transpose() || !dynamic_pointer_cast<LearnableParameter<ElemType>>(node->GetInputs()[0]))
+            return false;
+        // The engine computes (unrolled input)^T * kernel, so the weights are the right operand.
+        pQuantizedMultiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(false, true);
+    }
+    node->SetQuantizedMultiplier(pQuantizedMultiplier);
+    return enable;
+}
+
+/*static*/ void ComputationNetwork::SetInt8Evaluation(ComputationNetworkPtr net, const ComputationNodeBasePtr& rootNode, bool enable)
+{
+    size_t numQuantized = 0;
+    for (const auto& typeName : { OperationNameOf(TimesNode), OperationNameOf(TransposeTimesNode), OperationNameOf(ConvolutionNode) })
+    {
+        for (const auto& node : net->GetNodesWithType(typeName, rootNode))
+        {
+            if (node->GetDeviceId() != CPUDEVICE)
+                continue; // only the CPU has int8 kernels
+            bool quantized = SetInt8EvaluationForTimesNode<float, false>(node, enable) || SetInt8EvaluationForTimesNode<double, false>(node, enable) ||
+                             SetInt8EvaluationForTimesNode<float, true>(node, enable) || SetInt8EvaluationForTimesNode<double, true>(node, enable) ||
+                             SetInt8EvaluationForConvolutionNode<float>(node, enable) || SetInt8EvaluationForConvolutionNode<double>(node, enable);
+            if (quantized)
+                numQuantized++;
+        }
+    }
+    if (enable)
+        fprintf(stderr, "Evaluating %d matrix products in int8 (%s kernel).\n", (int)numQuantized, Int8MultiplyKernelName());
+}
+
 // -----------------------------------------------------------------------
 // unit test
 // -----------------------------------------------------------------------
@@ -59,10 +59,13 @@ public:
         m_randomSeedOffset(0),
         m_isCompiled(false),
         m_areMatricesAllocated(false),
+        m_planArenaAfterBackprop(false),
         m_pMBLayoutOfNetwork(make_shared<MBLayout>(1, 0, ComputationNodeBase::DefaultDynamicAxisName)),
         m_environment(make_shared<ComputationEnvironment>())
     {
         //m_pMBLayoutOfNetwork->SetAxisName(L"T");
+        // 'optimizeRecurrentLoops' in the config of BrainScript and SGD; the V2 library sets it per network
+        SetOptimizeRecurrentLoops(Globals::ShouldOptimizeRecurrentLoops());
     }
 
     ComputationNetwork(DEVICEID_TYPE deviceId) :
@@ -128,10 +131,12 @@ public:
 
     void Save(const std::wstring& fileName, const FileOptions fileFormat = FileOptions::fileOptionsBinary) const;
     void SaveEdited(const std::wstring& fileName, const FileOptions fileFormat = FileOptions::fileOptionsBinary);
+    void Save(File& fstream) const;
 
 private:
 
     void SaveToFileImpl(const std::wstring& fileName, const FileOptions fileFormat) const;
+    void SaveToFileImpl(File& fstream) const;
     
     static size_t GetModelVersion(File& fstream);
 
@@ -148,7 +153,9 @@ public:
     void PostForwardAndBackProp(const ComputationNodeBasePtr rootNode);
 
     // main entry point for backprop
-    void Backprop(const ComputationNodeBasePtr rootNode);
+    // If given, onGradientFinalized() is called for each parameter that needs a gradient as soon as backprop has
+    // finished accumulating into it, while the remaining nodes are still being processed.
+    void Backprop(const ComputationNodeBasePtr rootNode, const std::function<void(const ComputationNodeBasePtr&)>& onGradientFinalized = nullptr);
 
     template <class NODESET> // version that takes multiple nodes
     void TravserseInSortedGlobalEvalOrder(const NODESET& nodes, const std::function<void(const ComputationNodeBasePtr&)>& action)
@@ -183,6 +190,9 @@ public:
     template <class NODESET> // version that takes multiple nodes
     void ForwardProp(const NODESET& nodes)
     {
+        if (!m_planArenaAfterBackprop)
+            UpdateMemoryArena();
+
         TravserseInSortedGlobalEvalOrder(nodes, [](const ComputationNodeBasePtr& node) {
             PARTraversalFlowControlNode::ForwardProp(node, FrameRange(nullptr));
         });
@@ -273,6 +283,7 @@ public:
 
 private:
     void PrintMemorySharingStructure(const std::vector<ComputationNodeBasePtr>& nodes);
+    void UpdateMemoryArena();
     void ReleaseMatricesAfterEvalForChildren(ComputationNodeBasePtr n, std::unordered_map<ComputationNodeBasePtr, std::unordered_set<ComputationNodeBasePtr>>& parentsMap);
 
 public:
@@ -286,6 +297,8 @@ public:
 private:
     // The method below determines evaluation order, which is tricky in presence of recurrent loops.
     void FormRecurrentLoops();
+    // Sets up the per-step execution plan of the loops found by FormRecurrentLoops().
+    void OptimizeRecurrentLoops();
 
 public:
     // -----------------------------------------------------------------------
@@ -474,6 +487,7 @@ public:
     void AddFeatureNode(ComputationNodeBasePtr featureNode);
     //ComputationNodeBasePtr RemoveFeatureNode(ComputationNodeBasePtr featureNode);
     void SetLearnableNodesBelowLearningRateMultiplier(const float learningRateMultiplier, const ComputationNodeBasePtr& rootNode = nullptr);
+    std::map<ComputationNodeBasePtr, ComputationNodeBasePtr> FuseElementwiseOperations(const std::set<ComputationNodeBasePtr>& nodesToKeep);
 
     // -----------------------------------------------------------------------
     // node access
@@ -556,6 +570,9 @@ public:
                             const double& bMMIfactor = 0.0f,
                             const bool& sMBR = false);
     static void SetMaxTempMemSizeForCNN(ComputationNetworkPtr net, const ComputationNodeBasePtr& criterionNode, const size_t maxTempMemSizeInSamples);
+    // Evaluate the matrix products of Times, TransposeTimes and Convolution nodes with a constant (LearnableParameter) operand in int8 on CPU.
+    // Weights are quantized once per output channel, activations dynamically per sample. This is for inference only.
+    static void SetInt8Evaluation(ComputationNetworkPtr net, const ComputationNodeBasePtr& rootNode, bool enable);
 
     // -----------------------------------------------------------------------
     // node-group access
@@ -970,6 +987,21 @@ public:
     }
     bool GetIsV2Library() const { return m_environment->isV2Library; }
 
+    // runs recurrent loops with the plan from OptimizeRecurrentLoops() if enabled before CompileNetwork(), else node by node (the default,
+    // unless 'optimizeRecurrentLoops=true' is in the config, see Globals::SetRecurrentLoopOptimization())
+    void SetOptimizeRecurrentLoops(bool enable)
+    {
+        m_environment->optimizeRecurrentLoops = enable;
+    }
+    bool GetOptimizeRecurrentLoops() const { return m_environment->optimizeRecurrentLoops; }
+
+    // the gradients computed by Backprop() are multiplied with this, see SGD::UpdateWeights() for unscaling them
+    void SetLossScale(double lossScale)
+    {
+        m_environment->lossScale = lossScale;
+    }
+    double GetLossScale() const { return m_environment->lossScale; }
+
     void SetTraceLevel(int traceLevel)
     {
         m_environment->traceLevel = traceLevel;
@@ -1149,11 +1181,18 @@ protected:
         virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool);
         virtual bool IsOutOfDateWrtInputs() const override;
 
+    private:
+        bool UseOptimizedSteps() const;
+
     public:
         ComputationNodeBasePtr m_sourceNode; // one of the nodes of the loop   --TODO: What is the special meaning of this node? It seems to always be a delay node.
         int m_loopId;                        // unique loop id, index in m_allSEQNodes array
         int m_steppingDirection;             // +1 if left to right (t=0..T-1), -1 if rightt to left (t=T-1..0)
 
+        // execution plan set up by ComputationNetwork::OptimizeRecurrentLoops()
+        std::vector<std::function<void(const FrameRange&)>> m_hoistedForwardProps; // run once for all frames before the first step
+        std::vector<std::function<void(const FrameRange&)>> m_stepForwardProps;    // [i] replaces m_nestedNodes[i]->ForwardProp() in each step if set
+
         SEQTraversalFlowControlNode(int loopId, ComputationNodeBasePtr cur)
             : m_loopId(loopId),
               m_sourceNode(cur)
@@ -1212,6 +1251,9 @@ protected:
         // There is currently no other constructor for inner nested PAR-traversed sub-networks, but there will be.
         PARTraversalFlowControlNode(const std::vector<shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const std::list<ComputationNodeBasePtr>& allNodes);
         // Base::m_nestedNodes contains all top-level nodes, in evaluation order
+
+        // called by Backprop() for every leaf that needs a gradient, once its gradient is final; may be empty
+        std::function<void(const ComputationNodeBasePtr&)> m_onGradientFinalized;
     };
 
 public:
@@ -1272,6 +1314,7 @@ private:
     // cache for evaluation ordering:
     bool m_isCompiled; // CompileNetwork has been called
     bool m_areMatricesAllocated; // AllocateAllMatrices has been called
+    bool m_planArenaAfterBackprop; // the memory arena is planned after backprop rather than before forward prop, see UpdateMemoryArena()
 
     // cached network iterations
     std::map<const ComputationNodeBasePtr, std::list<ComputationNodeBasePtr>> m_evalOrders; // [out node] flat depth-first traversal starting from out node
@@ -9,8 +9,12 @@
 #include "ComputationNode.h"
 #include "ComputationNetwork.h"
 #include "RecurrentNodes.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
+#include "ReshapingNodes.h"
 #include <string>
 #include <set>
+#include <map>
 
 using namespace std;
 
@@ -124,4 +128,192 @@ static int DetermineLoopDirection(const std::vector<ComputationNodeBasePtr>& nes
     return steppingDirection;
 }
 
+// -----------------------------------------------------------------------
+// recurrent-loop optimization
+// -----------------------------------------------------------------------
+
+// A loop only contains the nodes that are part of the recurrence, so most of the work that does not depend on it
+// already runs outside the loop in PAR mode, e.g. W * x of an LSTM. Likewise, gradients into nodes outside the loop
+// are computed for all frames at once in EndBackprop(). What remains are patterns where a single node mixes both:
+//  - Times (W, RowStack (x, h)) where x is computed outside the loop. The product is split into the column stripes
+//    of W. The stripes for inputs from outside the loop are multiplied with all frames at once, directly into the
+//    output of the Times node, so that each step only adds the product with the recurrent inputs.
+//  - Sigmoid/Tanh/RectifiedLinear (Plus (a, b)) where nothing else uses the Plus node. Each step computes the
+//    non-linearity of the sum with a single fused tensor operation, and the Plus node does not compute its output.
+//    This is OK since back-propagation of neither node uses it (the non-linearities use their own output).
+// Back-propagation is not affected.
+// Other elementwise operations of a step, e.g. the products and sums of the LSTM cell state, are still run one node at
+// a time, and there are no per-step scratch buffers to reuse: each step writes into the frames of the node outputs.
+// The plan is stored in the SEQTraversalFlowControlNode and used by its ForwardProp(), see SetOptimizeRecurrentLoops().
+
+typedef std::function<void(const FrameRange&)> ForwardPropFunction;
+
+// hoist the product with the stacked inputs that are computed outside of the loop
+template <class ElemType>
+static bool HoistTimesOfRowStack(const ComputationNodeBasePtr& node, const set<ComputationNodeBasePtr>& loopNodes,
+                                 ForwardPropFunction& hoistedForwardProp, ForwardPropFunction& stepForwardProp)
+{
+    if (node->OperationName() != OperationNameOf(TimesNode) || node->NeedsDynamicValidation())
+        return false;
+    auto times   = dynamic_pointer_cast<ComputationNode<ElemType>>(node);
+    auto product = dynamic_pointer_cast<TimesNode<ElemType>>(node);
+    auto weights = dynamic_pointer_cast<ComputationNode<ElemType>>(node->Input(0));
+    auto stack   = node->Input(1);
+    if (!times || !product || !weights || loopNodes.find(weights) != loopNodes.end() || weights->HasMBLayout() ||
+        stack->OperationName() != OperationNameOf(RowStackNode) || loopNodes.find(stack) == loopNodes.end())
+        return false;
+
+    // only plain matrix products [M x K] * [K] -> [M] qualify
+    const auto& weightsShape = weights->GetSampleLayout();
+    if (weightsShape.GetRank() != 2 || stack->GetSampleLayout().GetRank() != 1 || times->GetSampleLayout().GetRank() != 1 ||
+        stack->GetSampleLayout()[0] != weightsShape[1] || times->GetSampleLayout()[0] != weightsShape[0] ||
+        stack->GetMBLayout() != times->GetMBLayout() || weights->Value().GetMatrixType() != DENSE)
+        return false;
+
+    struct Stripe
+    {
+        shared_ptr<ComputationNode<ElemType>> m_input;
+        size_t m_firstColumn; // of W
+        size_t m_numColumns;
+    };
+    vector<Stripe> hoistedStripes, stepStripes;
+    size_t firstColumn = 0;
+    for (size_t i = 0; i < stack->GetNumInputs(); i++)
+    {
+        auto input = dynamic_pointer_cast<ComputationNode<ElemType>>(stack->Input(i));
+        if (!input || input->GetSampleLayout().GetRank() != 1 || input->GetMBLayout() != stack->GetMBLayout())
+            return false;
+        Stripe stripe = { input, firstColumn, input->GetSampleLayout()[0] };
+        if (loopNodes.find(input) == loopNodes.end())
+            hoistedStripes.push_back(stripe);
+        else
+            stepStripes.push_back(stripe);
+        firstColumn += stripe.m_numColumns;
+    }
+    if (firstColumn != weightsShape[1] || hoistedStripes.empty() || stepStripes.empty())
+        return false;
+
+    hoistedForwardProp = [times, product, weights, hoistedStripes](const FrameRange& fr)
+    {
+        if (product->GetQuantizedMultiplier())
+            return;
+        auto result = times->ValueFor(fr);
+        for (size_t i = 0; i < hoistedStripes.size(); i++)
+        {
+            const auto& stripe = hoistedStripes[i];
+            Matrix<ElemType>::MultiplyAndWeightedAdd(1, weights->Value().ColumnSlice(stripe.m_firstColumn, stripe.m_numColumns), false,
+                                                     stripe.m_input->ValueFor(fr), false, i == 0 ? (ElemType)0 : (ElemType)1, result);
+        }
+    };
+    stepForwardProp = [times, product, weights, stepStripes](const FrameRange& fr)
+    {
+        if (product->GetQuantizedMultiplier()) // quantized products are not split
+        {
+            times->ForwardProp(fr);
+            return;
+        }
+        auto result = times->ValueFor(fr);
+        for (const auto& stripe : stepStripes)
+            Matrix<ElemType>::MultiplyAndWeightedAdd(1, weights->Value().ColumnSlice(stripe.m_firstColumn, stripe.m_numColumns), false,
+                                                     stripe.m_input->ValueFor(fr), false, 1, result);
+    };
+    return true;
+}
+
+// fuse a non-linearity with the Plus node that computes its input
+template <class ElemType>
+static bool FuseNonlinearityOfSum(const ComputationNodeBasePtr& node, const set<ComputationNodeBasePtr>& loopNodes,
+                                  const set<ComputationNodeBasePtr>& sharedNodes, ForwardPropFunction& stepForwardProp)
+{
+    ElementWiseOperator op;
+    if (node->OperationName() == OperationNameOf(SigmoidNode))
+        op = ElementWiseOperator::opSigmoidOfSum;
+    else if (node->OperationName() == OperationNameOf(TanhNode))
+        op = ElementWiseOperator::opTanhOfSum;
+    else if (node->OperationName() == OperationNameOf(RectifiedLinearNode))
+        op = ElementWiseOperator::opLinearRectifierOfSum;
+    else
+        return false;
+
+    auto nonlinearity = dynamic_pointer_cast<ComputationNode<ElemType>>(node);
+    auto sum = node->Input(0);
+    if (!nonlinearity || nonlinearity->NeedsDynamicValidation() ||
+        sum->OperationName() != OperationNameOf(PlusNode) || sum->NeedsDynamicValidation() ||
+        loopNodes.find(sum) == loopNodes.end() || sharedNodes.find(sum) != sharedNodes.end())
+        return false;
+    auto input0 = dynamic_pointer_cast<ComputationNode<ElemType>>(sum->Input(0));
+    auto input1 = dynamic_pointer_cast<ComputationNode<ElemType>>(sum->Input(1));
+    if (!input0 || !input1)
+        return false;
+
+    // same tensor rank as PlusNode::ForwardProp() would use
+    size_t rank = max(max(sum->GetSampleLayout().GetRank(), input0->GetSampleLayout().GetRank()), input1->GetSampleLayout().GetRank());
+    stepForwardProp = [nonlinearity, input0, input1, op, rank](const FrameRange& fr)
+    {
+        auto result = nonlinearity->ValueTensorFor(rank, fr);
+        result.DoBinaryOpOf(0, input0->ValueTensorFor(rank, fr.AllowBroadcast()), input1->ValueTensorFor(rank, fr.AllowBroadcast()), 1, op, ElementWiseOperator::opSum);
+    };
+    return true;
+}
+
+template <class ElemType>
+static void OptimizeLoopNode(const ComputationNodeBasePtr& node, const set<ComputationNodeBasePtr>& loopNodes, const set<ComputationNodeBasePtr>& sharedNodes,
+                             vector<ForwardPropFunction>& hoistedForwardProps, ForwardPropFunction& stepForwardProp,
+                             map<ComputationNodeBasePtr, ForwardPropFunction>& fusedNodes)
+{
+    ForwardPropFunction hoistedForwardProp;
+    if (HoistTimesOfRowStack<ElemType>(node, loopNodes, hoistedForwardProp, stepForwardProp))
+        hoistedForwardProps.push_back(hoistedForwardProp);
+    else if (FuseNonlinearityOfSum<ElemType>(node, loopNodes, sharedNodes, stepForwardProp))
+        fusedNodes[node->Input(0)] = [](const FrameRange&) {}; // computed by its consumer
+}
+
+void ComputationNetwork::OptimizeRecurrentLoops()
+{
+    if (m_allSEQNodes.empty() || !GetOptimizeRecurrentLoops())
+        return;
+
+    // nodes whose output is used by more than one node or from outside of the network cannot be fused into their consumer
+    map<ComputationNodeBasePtr, size_t> numConsumers;
+    for (const auto& node : GetEvalOrder(nullptr))
+        for (size_t i = 0; i < node->GetNumInputs(); i++)
+            numConsumers[node->Input(i)]++;
+    set<ComputationNodeBasePtr> sharedNodes;
+    for (const auto& iter : numConsumers)
+        if (iter.second > 1)
+            sharedNodes.insert(iter.first);
+    for (auto group : GetAllNodeGroups())
+        sharedNodes.insert(group->begin(), group->end());
+
+    for (auto& loop : m_allSEQNodes)
+    {
+        const auto& nestedNodes = loop->m_nestedNodes;
+        set<ComputationNodeBasePtr> loopNodes(nestedNodes.begin(), nestedNodes.end());
+        vector<ForwardPropFunction> stepForwardProps(nestedNodes.size());
+        map<ComputationNodeBasePtr, ForwardPropFunction> fusedNodes;
+        loop->m_hoistedForwardProps.clear();
+        for (size_t i = 0; i < nestedNodes.size(); i++)
+        {
+            const auto& node = nestedNodes[i];
+            if (node->Is<ComputationNode<float>>())
+                OptimizeLoopNode<float>(node, loopNodes, sharedNodes, loop->m_hoistedForwardProps, stepForwardProps[i], fusedNodes);
+            else if (node->Is<ComputationNode<double>>())
+                OptimizeLoopNode<double>(node, loopNodes, sharedNodes, loop->m_hoistedForwardProps, stepForwardProps[i], fusedNodes);
+            else if (node->Is<ComputationNode<half>>())
+                OptimizeLoopNode<half>(node, loopNodes, sharedNodes, loop->m_hoistedForwardProps, stepForwardProps[i], fusedNodes);
+        }
+        for (size_t i = 0; i < nestedNodes.size(); i++)
+        {
+            auto fused = fusedNodes.find(nestedNodes[i]);
+            if (fused != fusedNodes.end())
+                stepForwardProps[i] = fused->second;
+        }
+        loop->m_stepForwardProps = move(stepForwardProps);
+
+        if (TraceLevel() > 0 && (!loop->m_hoistedForwardProps.empty() || !fusedNodes.empty()))
+            fprintf(stderr, "OptimizeRecurrentLoops: %ls: %d matrix products partially hoisted out of the loop, %d non-linearities fused with their input.\n",
+                    loop->NodeName().c_str(), (int)loop->m_hoistedForwardProps.size(), (int)fusedNodes.size());
+    }
+}
+
 }}}
@@ -10,9 +10,12 @@
 #include "ComputationNetwork.h"
 #include "InputAndParamNodes.h"
 #include "TrainingNodes.h"
+#include "LinearAlgebraNodes.h"
+#include "NonlinearityNodes.h"
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 
 using namespace std;
 
@@ -339,6 +342,162 @@ ComputationNodeBasePtr ComputationNetwork::RemoveFeatureNode(ComputationNodeBase
 }
 #endif
 
+// -----------------------------------------------------------------------
+// fusion of elementwise operations
+// -----------------------------------------------------------------------
+
+// the elementwise operation computed by a node that can become part of a FusedElementwiseNode
+static bool GetFusableElementwiseOp(const ComputationNodeBasePtr& node, ElementWiseOperator& op)
+{
+    // Dropout is elementwise as well, but its random mask is not part of its inputs.
+    static const map<wstring, ElementWiseOperator> fusableOps =
+    {
+        { OperationNameOf(PlusNode),                  ElementWiseOperator::opSum                   },
+        { OperationNameOf(MinusNode),                 ElementWiseOperator::opDifference            },
+        { OperationNameOf(ElementTimesNode),          ElementWiseOperator::opElementwiseProduct    },
+        { OperationNameOf(NegateNode),                ElementWiseOperator::opNegate                },
+        { OperationNameOf(SigmoidNode),               ElementWiseOperator::opSigmoid               },
+        { OperationNameOf(StableSigmoidNode),         ElementWiseOperator::opStableSigmoid         },
+        { OperationNameOf(TanhNode),                  ElementWiseOperator::opTanh                  },
+        { OperationNameOf(RectifiedLinearNode),       ElementWiseOperator::opLinearRectifier       },
+        { OperationNameOf(ExponentialLinearUnitNode), ElementWiseOperator::opExponentialLinearUnit },
+        { OperationNameOf(ExpNode),                   ElementWiseOperator::opExp                   },
+        { OperationNameOf(LogNode),                   ElementWiseOperator::opLog                   },
+        { OperationNameOf(SqrtNode),                  ElementWiseOperator::opSqrt                  },
+        { OperationNameOf(ReciprocalNode),            ElementWiseOperator::opReciprocal            },
+        { OperationNameOf(AbsNode),                   ElementWiseOperator::opAbs                   },
+        { OperationNameOf(SinNode),                   ElementWiseOperator::opSin                   },
+        { OperationNameOf(CosineNode),                ElementWiseOperator::opCosine                },
+    };
+    auto iter = fusableOps.find(node->OperationName());
+    if (iter == fusableOps.end() || node->IsPartOfLoop() || node->NeedsDynamicValidation())
+        return false;
+    op = iter->second;
+    return true;
+}
+
+// collects the chain of operations computing 'node' into 'program', whose operands are stored as (isLeaf, index) pairs until the number of leaves is known
+template <class ElemType>
+static pair<bool, size_t> CollectFusableChain(const ComputationNodeBasePtr& node, const ComputationNodeBasePtr& root, const set<ComputationNodeBasePtr>& sharedNodes,
+                                               vector<ComputationNodeBasePtr>& leaves, vector<ComputationNodeBasePtr>& absorbedNodes,
+                                               vector<pair<ElementWiseOperator, vector<pair<bool, size_t>>>>& steps)
+{
+    ElementWiseOperator op;
+    bool isFused = GetFusableElementwiseOp(node, op) &&
+                   (node == root ||
+                    (sharedNodes.find(node) == sharedNodes.end() && node->Is<ComputationNode<ElemType>>() &&
+                     node->GetSampleLayout() == root->GetSampleLayout() && node->GetMBLayout() == root->GetMBLayout()));
+    if (!isFused)
+    {
+        auto iter = find(leaves.begin(), leaves.end(), node);
+        if (iter != leaves.end())
+            return make_pair(true, (size_t)(iter - leaves.begin()));
+        leaves.push_back(node);
+        return make_pair(true, leaves.size() - 1);
+    }
+
+    vector<pair<bool, size_t>> operands;
+    for (size_t i = 0; i < node->GetNumInputs(); i++)
+        operands.push_back(CollectFusableChain<ElemType>(node->Input(i), root, sharedNodes, leaves, absorbedNodes, steps));
+    if (node != root)
+        absorbedNodes.push_back(node);
+    steps.push_back(make_pair(op, operands));
+    return make_pair(false, steps.size() - 1);
+}
+
+// replaces the chain of elementwise operations that computes 'root' by a FusedElementwiseNode
+// Returns the new node, or nullptr if there is nothing to fuse.
+template <class ElemType>
+static shared_ptr<FusedElementwiseNode<ElemType>> CreateFusedElementwiseNode(const ComputationNodeBasePtr& root, const set<ComputationNodeBasePtr>& sharedNodes,
+                                                                              vector<ComputationNodeBasePtr>& leaves, vector<ComputationNodeBasePtr>& absorbedNodes)
+{
+    vector<pair<ElementWiseOperator, vector<pair<bool, size_t>>>> steps;
+    CollectFusableChain<ElemType>(root, root, sharedNodes, leaves, absorbedNodes, steps);
+    if (absorbedNodes.empty())
+        return nullptr;
+    for (const auto& leaf : leaves)
+    {
+        if (!leaf->Is<ComputationNode<ElemType>>() || (leaf->HasMBLayout() && leaf->GetMBLayout() != root->GetMBLayout()))
+            return nullptr;
+    }
+
+    FusedElementwiseProgram program;
+    program.numInputs = leaves.size();
+    for (const auto& step : steps)
+    {
+        FusedElementwiseStep fusedStep = { step.first, { -1, -1 } };
+        for (size_t k = 0; k < step.second.size(); k++)
+            fusedStep.operands[k] = (int)(step.second[k].first ? step.second[k].second : leaves.size() + step.second[k].second);
+        program.steps.push_back(fusedStep);
+    }
+    return New<FusedElementwiseNode<ElemType>>(root->GetDeviceId(), root->NodeName(), program);
+}
+
+// replaces chains of elementwise operations by FusedElementwiseNodes, which compute them in a single pass
+// Only nodes that are used by a single node and that are not needed by themselves become part of a chain,
+// i.e. not nodes in 'nodesToKeep' or node groups. Nodes in recurrent loops are not fused.
+// The network must be compiled, and is compiled again if anything changes. Returns a map from each
+// replaced node to the FusedElementwiseNode that now computes it, or to nullptr if it no longer exists.
+map<ComputationNodeBasePtr, ComputationNodeBasePtr> ComputationNetwork::FuseElementwiseOperations(const set<ComputationNodeBasePtr>& nodesToKeep)
+{
+    VerifyIsCompiled("FuseElementwiseOperations");
+
+    map<ComputationNodeBasePtr, size_t> numConsumers;
+    for (const auto& node : GetEvalOrder(nullptr))
+        for (size_t i = 0; i < node->GetNumInputs(); i++)
+            numConsumers[node->Input(i)]++;
+    set<ComputationNodeBasePtr> sharedNodes(nodesToKeep);
+    for (const auto& iter : numConsumers)
+        if (iter.second > 1)
+            sharedNodes.insert(iter.first);
+    for (auto group : GetAllNodeGroups())
+        sharedNodes.insert(group->begin(), group->end());
+
+    // consumers first, so that each chain is as long as possible
+    map<ComputationNodeBasePtr, ComputationNodeBasePtr> replacedNodes;
+    const auto& evalOrder = GetEvalOrder(nullptr);
+    vector<ComputationNodeBasePtr> nodes(evalOrder.rbegin(), evalOrder.rend());
+    for (const auto& root : nodes)
+    {
+        ElementWiseOperator op;
+        if (replacedNodes.find(root) != replacedNodes.end() || !GetFusableElementwiseOp(root, op))
+            continue;
+
+        vector<ComputationNodeBasePtr> leaves, absorbedNodes;
+        ComputationNodeBasePtr fusedNode;
+        if (root->Is<ComputationNode<float>>())
+            fusedNode = CreateFusedElementwiseNode<float>(root, sharedNodes, leaves, absorbedNodes);
+        else if (root->Is<ComputationNode<double>>())
+            fusedNode = CreateFusedElementwiseNode<double>(root, sharedNodes, leaves, absorbedNodes);
+        else if (root->Is<ComputationNode<half>>())
+            fusedNode = CreateFusedElementwiseNode<half>(root, sharedNodes, leaves, absorbedNodes);
+        if (!fusedNode)
+            continue;
+
+        InvalidateCompiledNetwork();
+        ChangeNodeInputs(root, fusedNode);
+        for (auto groupIter : GetAllNodeGroups())
+            replace(groupIter->begin(), groupIter->end(), root, fusedNode);
+        for (const auto& node : absorbedNodes)
+        {
+            node->DetachInputs();
+            RemoveNodeFromNet(node);
+            replacedNodes[node] = nullptr;
+        }
+        root->DetachInputs();
+        RemoveNodeFromNet(root);
+        replacedNodes[root] = fusedNode;
+        AddNodeToNetAndAttachInputs(fusedNode, leaves);
+
+        if (TraceLevel() > 0)
+            fprintf(stderr, "FuseElementwiseOperations: %ls: %d operations fused.\n", fusedNode->NodeName().c_str(), (int)absorbedNodes.size() + 1);
+    }
+
+    if (!replacedNodes.empty())
+        CompileNetwork();
+    return replacedNodes;
+}
+
 // sets m_learningRateMultiplier in all LearnableParameters feeding into the passed rootNode
 // Called from MEL
 void ComputationNetwork::SetLearnableNodesBelowLearningRateMultiplier(const float learningRateMultiplier, const ComputationNodeBasePtr& rootNode)
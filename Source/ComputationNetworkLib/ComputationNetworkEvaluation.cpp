@@ -41,6 +41,9 @@ void ComputationNetwork::ForwardProp(const ComputationNodeBasePtr rootNode)
 {
     VerifyIsCompiled("ForwardProp");
 
+    if (!m_planArenaAfterBackprop)
+        UpdateMemoryArena();
+
     // traverse all nodes in the pre-determined evaluation order
     GetNestedNetwork(rootNode)->ForwardProp(FrameRange(nullptr));
 }
@@ -53,17 +56,17 @@ void ComputationNetwork::PostForwardAndBackProp(const ComputationNodeBasePtr roo
     GetNestedNetwork(rootNode)->PostForwardAndBackProp();
 }
 
-// set the gradient matrix of a (root) node 1.0
+// set the gradient matrix of a (root) node to a scalar value, normally 1.0
 // Returns false if the node is not a ComputationNode<ElemType>; see Backprop() below for intended use.
 template <class ElemType>
-static bool SetRootGradientToScalarOne(ComputationNodeBasePtr nodep)
+static bool SetRootGradientToScalar(ComputationNodeBasePtr nodep, double value)
 {
     auto node = dynamic_pointer_cast<ComputationNode<ElemType>>(nodep);
     bool hasMatchingType = (node != nullptr);
     if (hasMatchingType)
     {
-        // reset the root gradient to 1
-        node->ResetGradient(1);
+        // reset the root gradient to the value
+        node->ResetGradient((ElemType)value);
     }
     return hasMatchingType;
 }
@@ -73,20 +76,38 @@ static bool SetRootGradientToScalarOne(ComputationNodeBasePtr nodep)
 //  - ForwardProp() for eval nodes
 //  - ForwardProp() for the training criterion (which will reuse computation results from the previous step)
 //  - Backprop() for the training criterion
-void ComputationNetwork::Backprop(const ComputationNodeBasePtr rootNode) // training criterion to compute the gradients for
+void ComputationNetwork::Backprop(const ComputationNodeBasePtr rootNode, // training criterion to compute the gradients for
+                                  const std::function<void(const ComputationNodeBasePtr&)>& onGradientFinalized)
 {
     if (!Environment().IsTraining())
         LogicError("Backprop: Requires network is to be in training mode.");
 
-    // initialize root gradient with a scalar value of 1.0
-    if (!SetRootGradientToScalarOne<float>(rootNode) && !SetRootGradientToScalarOne<double>(rootNode))
-        LogicError("Backprop: Training criterion is neither ComputationNode<float> nor ComputationNode<double>.");
+    // initialize root gradient with a scalar value of 1.0, or the loss scale
+    double rootGradient = Environment().lossScale;
+    if (!SetRootGradientToScalar<float>(rootNode, rootGradient) && !SetRootGradientToScalar<double>(rootNode, rootGradient) &&
+        !SetRootGradientToScalar<half>(rootNode, rootGradient))
+        LogicError("Backprop: Training criterion is neither ComputationNode<float>, ComputationNode<double> nor ComputationNode<half>.");
 
     // reset all gradients below rootNode to zero (actually, internally, this is lazy, but we don't care here)
     ZeroInputGradients(rootNode);
 
     // backpropagate through the network
-    GetNestedNetwork(rootNode)->Backprop(FrameRange(nullptr), true, true);
+    auto network = static_pointer_cast<PARTraversalFlowControlNode>(GetNestedNetwork(rootNode));
+    network->m_onGradientFinalized = onGradientFinalized;
+    network->Backprop(FrameRange(nullptr), true, true);
+    network->m_onGradientFinalized = nullptr;
+
+    if (m_planArenaAfterBackprop)
+        UpdateMemoryArena();
+}
+
+// In arena mode, the matrix pool plans its arena again once matrices have outgrown their slots, e.g. because the
+// minibatch has grown. Planning loses the values of all matrices in the pool, so it is done when none of them is
+// needed anymore: after backprop when training, otherwise before forward prop, and all nodes are computed again.
+void ComputationNetwork::UpdateMemoryArena()
+{
+    if (m_matrixPool.UpdateArena(TraceLevel() > 0))
+        SetEvalTimeStampsOutdatedWithRegardToAll();
 }
 
 void ComputationNetwork::FormNestedNetwork(const ComputationNodeBasePtr& rootNode)
@@ -194,6 +215,11 @@ ComputationNetwork::PARTraversalFlowControlNode::PARTraversalFlowControlNode(con
         // Extreme Tracing, part 2/4
         if (node->HasEnvironmentPtr() && node->Environment().ShouldDumpNode() && node->NeedsGradient())
             DumpNode(node, /*dumpGradient=*/true);
+
+        // All consumers of a leaf come later in evaluation order, hence its gradient is complete now.
+        // (Leaves are never part of a loop, so this does not need to look into SEQ nodes.)
+        if (m_onGradientFinalized && node->IsLeaf() && node->NeedsGradient())
+            m_onGradientFinalized(node);
     }
 }
 /*virtual*/ void ComputationNetwork::PARTraversalFlowControlNode::RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) /*override*/
@@ -281,14 +307,38 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     // Note: Currently, this is limited to linear-time loops. But nothing stops the iteration below to, e.g., be a 2D iteration over an image
     // if we implement an according FrameRangeIteration.
     FrameRangeIteration range(GetMBLayout(), m_steppingDirection);
-    for (auto t = range.begin(); t != range.end(); t++)
+    if (UseOptimizedSteps())
+    {
+        // run the loop with the plan from OptimizeRecurrentLoops(): first the parts that do not depend on the recurrence
+        // for all frames at once, then the steps, some of which have been replaced or fused with their consumer
+        for (auto& hoistedForwardProp : m_hoistedForwardProps)
+            hoistedForwardProp(FrameRange(GetMBLayout()));
+        for (auto t = range.begin(); t != range.end(); t++)
+        {
+            for (size_t i = 0; i < m_nestedNodes.size(); i++)
+            {
+                auto& node = m_nestedNodes[i];
+                node->BeginTiming(false /*backward*/);
+                if (m_stepForwardProps[i])
+                    m_stepForwardProps[i](t);
+                else
+                    node->ForwardProp(t);
+                node->EndTiming(false /*backward*/);
+                node->BumpEvalTimeStamp();
+            }
+        }
+    }
+    else
     {
-        for (auto& node : m_nestedNodes)
+        for (auto t = range.begin(); t != range.end(); t++)
         {
-            node->BeginTiming(false /*backward*/);
-            node->ForwardProp(t);
-            node->EndTiming(false /*backward*/);
-            node->BumpEvalTimeStamp();
+            for (auto& node : m_nestedNodes)
+            {
+                node->BeginTiming(false /*backward*/);
+                node->ForwardProp(t);
+                node->EndTiming(false /*backward*/);
+                node->BumpEvalTimeStamp();
+            }
         }
     }
 
@@ -389,6 +439,15 @@ static bool DumpNode(ComputationNodeBasePtr nodep, bool dumpGradient)
     }
 }
 
+// the plan from OptimizeRecurrentLoops() is not used while tracing, since fused nodes do not compute their own output
+bool ComputationNetwork::SEQTraversalFlowControlNode::UseOptimizedSteps() const
+{
+    if (m_stepForwardProps.size() != m_nestedNodes.size())
+        return false;
+    const auto& node = m_nestedNodes[0];
+    return node->HasEnvironmentPtr() && node->Environment().optimizeRecurrentLoops && !node->Environment().ShouldDumpNode();
+}
+
 // find if node is part of a recurrent loop; and return the loop id
 // If found then return a pointer to the list of nodes of this loop.
 /*static*/ shared_ptr<ComputationNetwork::SEQTraversalFlowControlNode> ComputationNetwork::FindInRecurrentLoops(const std::vector<std::shared_ptr<SEQTraversalFlowControlNode>>& recurrentInfo, const ComputationNodeBasePtr& node)
@@ -549,7 +608,7 @@ void ComputationNetwork::CompileNetwork()
     ValidateNetwork();
 
     // STEP: Optimize the network.
-    // :)
+    OptimizeRecurrentLoops();
 
     // STEP: Some final details.
     ResetEvalTimeStamps(); // invalidate all m_value fields. Really belongs into StartEvaluateMinibatchLoop()
@@ -1268,8 +1327,10 @@ void ComputationNetwork::AllocateAllMatrices(const std::vector<ComputationNodeBa
         }
     }
 
+    m_matrixPool.SetUseArena(Globals::ShouldUseMemoryArena());
     m_matrixPool.OptimizedMemoryAllocation(); 
     m_areMatricesAllocated = true;
+    m_planArenaAfterBackprop = trainRootNode != nullptr;
 
     // TO DO: At the time of AllocateAllMatrices we don't know the minibatch size. In theory one may allocate memory again once we start to receive
     // data from the reader (and the minibatch size is known). For some problems, minibatch size can change constantly, and there needs to be a 
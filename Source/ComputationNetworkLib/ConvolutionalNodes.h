@@ -677,7 +677,8 @@ public:
                 m_convEng = ConvolutionEngine<ElemType>::Create(geometry, m_deviceId, m_imageLayout,
                                                                 m_maxTempMemSizeInSamples, m_poolKind,
                                                                 ConvolutionEngineKind::All, NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
-                                                                false, recomputeConvGeometry);
+                                                                false, recomputeConvGeometry, m_pQuantizedMultiplier != nullptr);
+                m_convEng->SetQuantizedMultiplier(m_pQuantizedMultiplier);
             }
 
             if (Input(0)->GetSampleLayout().GetNumElements() != m_kernelShape.GetNumElements() * m_convEng->Geometry()->KernelCount())
@@ -733,7 +734,26 @@ public:
         ReleaseMatrixToPool(m_tempMatrixBackward, matrixPool);
     }
 
+    // quantized product for the forward pass; only used by GEMM-based CPU engines (null for full precision)
+    void SetQuantizedMultiplier(const shared_ptr<QuantizedMultiplier<ElemType>>& pQuantizedMultiplier)
+    {
+        bool quantizationChanged = (m_pQuantizedMultiplier != nullptr) != (pQuantizedMultiplier != nullptr);
+        m_pQuantizedMultiplier = pQuantizedMultiplier;
+        if (m_convEng != nullptr)
+        {
+            // the engine is chosen among those that support quantized products
+            if (quantizationChanged)
+                m_convEng = ConvolutionEngine<ElemType>::Create(std::const_pointer_cast<ConvolveGeometry>(m_convEng->Geometry()), m_deviceId, m_imageLayout,
+                                                                m_maxTempMemSizeInSamples, m_poolKind,
+                                                                ConvolutionEngineKind::All, NodeName(), Globals::ShouldForceDeterministicAlgorithms(),
+                                                                false, false, pQuantizedMultiplier != nullptr);
+            m_convEng->SetQuantizedMultiplier(pQuantizedMultiplier);
+        }
+    }
+
 private:
+    shared_ptr<QuantizedMultiplier<ElemType>> m_pQuantizedMultiplier;
+
     using TransformerNode::m_transforms;
     using ConvolutionNodeBase<ElemType>::ComputeFilterTransform;
 
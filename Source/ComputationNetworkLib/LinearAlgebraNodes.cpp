@@ -131,4 +131,181 @@ void EpochAccumulatorNode<ElemType>::Reset()
 
 template class EpochAccumulatorNode<float>;
 template class EpochAccumulatorNode<double>;
-template class EpochAccumulatorNode<half>;
\ No newline at end of file
+template class EpochAccumulatorNode<half>;
+
+// -----------------------------------------------------------------------
+// FusedElementwiseNode
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::ForwardProp(const FrameRange& fr)
+{
+    size_t rank = DetermineElementwiseTensorRank();
+    auto result = ValueTensorFor(rank, fr);
+    std::vector<TensorView<ElemType>> inputs;
+    for (size_t i = 0; i < GetNumInputs(); i++)
+        inputs.push_back(InputRef(i).ValueTensorFor(rank, fr.AllowBroadcast()));
+    result.DoFusedElementwiseOf(0, inputs, 1, m_program);
+}
+
+// same as ComputationNode::Backprop(), except that the gradients of all inputs are computed together
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop)
+{
+    if (this->NeedsGradient())
+        this->LazyZeroGradient(this); // set gradient to 0 if this is the first time
+
+    std::vector<size_t> inputIndices;
+    for (size_t i = 0; i < GetNumInputs(); i++)
+    {
+        const auto& child = Input(i);
+        if (child->NeedsGradient() &&
+            ((childrenInThisLoop  && child->IsPartOfLoop() == IsPartOfLoop()) ||
+             (childrenInOuterLoop && child->IsPartOfLoop() != IsPartOfLoop())))
+        {
+            if (!this->NeedsGradient())
+                LogicError("%ls %ls operation has m_needsGradient set to false but children require it.", NodeName().c_str(), OperationName().c_str());
+            child->LazyZeroGradient(this);
+            child->VerifyGradientOptimization(this);
+            inputIndices.push_back(i);
+        }
+    }
+    if (!inputIndices.empty())
+        BackpropToInputs(fr, inputIndices);
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::BackpropTo(const size_t inputIndex, const FrameRange& fr)
+{
+    BackpropToInputs(fr, std::vector<size_t>{ inputIndex });
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::BackpropToInputs(const FrameRange& fr, const std::vector<size_t>& inputIndices)
+{
+    size_t rank = DetermineElementwiseTensorRank();
+    auto gradient = GradientTensorFor(rank, fr);
+
+    // if reduction then mask the gaps of the gradient, and of the input values that the reduced gradient depends on
+    bool reducesInTime = false;
+    for (size_t i : inputIndices)
+        reducesInTime |= Input(i)->ReducesInTimeWrt(shared_from_this());
+    if (reducesInTime)
+    {
+        MaskMissingGradientColumnsToZero(fr);
+        for (size_t i = 0; i < GetNumInputs(); i++)
+            if (Input(i)->HasMBLayout())
+                Input(i)->MaskMissingValueColumnsToZero(fr);
+    }
+
+    std::vector<TensorView<ElemType>> inputs;
+    for (size_t i = 0; i < GetNumInputs(); i++)
+        inputs.push_back(InputRef(i).ValueTensorFor(rank, fr.AllowBroadcast()));
+
+    // Inputs that have the shape of the operation receive their gradient directly. All others receive the
+    // gradient w.r.t. the broadcast input in a temporary, which is then reduced into theirs. Both in one pass.
+    std::vector<TensorView<ElemType>> gradients;
+    gradients.reserve(inputIndices.size()); // pointers into it must remain valid
+    std::vector<TensorView<ElemType>*> gradientPointers(GetNumInputs(), nullptr);
+    std::vector<ElemType> betas(GetNumInputs(), 0);
+    for (size_t i : inputIndices)
+    {
+        if (InputBroadcasts(i))
+        {
+            m_gradientTemps[i]->Resize(Gradient().GetNumRows(), Gradient().GetNumCols());
+            gradients.push_back(DataTensorFor(m_gradientTemps[i], rank, fr));
+        }
+        else
+        {
+            gradients.push_back(Input(i)->GradientTensorFor(rank, fr));
+            betas[i] = Input(i)->IsGradientOptimized(this) ? 0 : 1;
+        }
+        gradientPointers[i] = &gradients.back();
+    }
+    TensorView<ElemType>::DoFusedElementwiseGradientOf(inputs, gradient, gradientPointers, betas, m_program);
+
+    for (size_t i : inputIndices)
+    {
+        if (!InputBroadcasts(i))
+            continue;
+        auto inputGradient = Input(i)->GradientTensorFor(rank, fr.AllowBroadcast());
+        if (Input(i)->IsGradientOptimized(this))
+            inputGradient.AssignCopyOf(*gradientPointers[i]);
+        else
+            inputGradient.AddCopyOf(*gradientPointers[i]);
+    }
+}
+
+template <class ElemType>
+bool FusedElementwiseNode<ElemType>::InputBroadcasts(size_t inputIndex) const
+{
+    return Input(inputIndex)->GetSampleLayout() != GetSampleLayout() ||
+           Input(inputIndex)->GetMBLayout() != GetMBLayout();
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::Validate(bool isFinalValidationPass)
+{
+    if (m_program.steps.empty() || m_program.numInputs != GetNumInputs())
+        InvalidArgument("%ls: The fused operations expect %d inputs, but the node has %d.",
+                        NodeDescription().c_str(), (int)m_program.numInputs, (int)GetNumInputs());
+    ValidateNaryZip(isFinalValidationPass, /*allowBroadcast=*/true, GetNumInputs());
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const
+{
+    Base::CopyTo(nodeP, newName, flags);
+    if (flags & CopyNodeFlags::copyNodeValue)
+    {
+        auto node = nodeP->As<FusedElementwiseNode<ElemType>>();
+        node->m_program = m_program;
+    }
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::Save(File& fstream) const
+{
+    Base::Save(fstream);
+    fstream << m_program.numInputs << m_program.steps.size();
+    for (const auto& step : m_program.steps)
+        fstream << (int)step.op << step.operands[0] << step.operands[1];
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::Load(File& fstream, size_t modelVersion)
+{
+    Base::Load(fstream, modelVersion);
+    size_t numSteps;
+    fstream >> m_program.numInputs >> numSteps;
+    m_program.steps.resize(numSteps);
+    for (auto& step : m_program.steps)
+    {
+        int op;
+        fstream >> op >> step.operands[0] >> step.operands[1];
+        step.op = (ElementWiseOperator)op;
+    }
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::RequestMatricesBeforeBackprop(MatrixPool& matrixPool)
+{
+    Base::RequestMatricesBeforeBackprop(matrixPool);
+    m_gradientTemps.resize(GetNumInputs());
+    for (size_t i = 0; i < GetNumInputs(); i++)
+        if (InputBroadcasts(i))
+            RequestMatrixFromPool(m_gradientTemps[i], matrixPool, GetSampleLayout().GetNumElements(), HasMBLayout());
+}
+
+template <class ElemType>
+void FusedElementwiseNode<ElemType>::ReleaseMatricesAfterBackprop(MatrixPool& matrixPool)
+{
+    Base::ReleaseMatricesAfterBackprop(matrixPool);
+    for (size_t i = 0; i < GetNumInputs(); i++)
+        if (InputBroadcasts(i))
+            ReleaseMatrixToPool(m_gradientTemps[i], matrixPool);
+}
+
+template class FusedElementwiseNode<float>;
+template class FusedElementwiseNode<double>;
+template class FusedElementwiseNode<half>;
@@ -1065,6 +1065,10 @@ public:
     size_t OutputRank() const { return m_outputRank; }
     int InferInputRankToMap() const { return m_inferInputRankToMap; }
 
+    // quantized product used for the dense forward pass on CPU (null for full precision)
+    const shared_ptr<QuantizedMultiplier<ElemType>>& GetQuantizedMultiplier() const { return m_pQuantizedMultiplier; }
+    void SetQuantizedMultiplier(const shared_ptr<QuantizedMultiplier<ElemType>>& pQuantizedMultiplier) { m_pQuantizedMultiplier = pQuantizedMultiplier; }
+
 protected: 
     shared_ptr<QuantizedMultiplier<ElemType>> m_pQuantizedMultiplier;
 
@@ -2048,4 +2052,60 @@ template class CastNode<float, half>;
 template class CastNode<float, double>;
 template class CastNode<double, half>;
 template class CastNode<double, float>;
+
+// -----------------------------------------------------------------------
+// FusedElementwiseNode (input0, input1, ...) -- a chain of elementwise operations computed in a single pass
+// This node is not meant to be created by users. ComputationNetwork::FuseElementwiseOperations() replaces
+// chains of elementwise nodes (Plus, ElementTimes, Sigmoid, ...) with it, so that the intermediate results
+// are neither written to memory nor kept around for back-propagation. The operations are described by a
+// FusedElementwiseProgram; the inputs may broadcast just like those of the nodes that were replaced.
+// Back-propagation recomputes the chain from the inputs and computes all input gradients in one pass.
+// The gradients of broadcasting inputs go through a temporary, from which they are reduced.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+class FusedElementwiseNode : public ComputationNode<ElemType> // note: variable number of inputs
+{
+    typedef ComputationNode<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"FusedElementwise"; }
+
+public:
+    DeclareConstructorFromConfig(FusedElementwiseNode);
+    FusedElementwiseNode(DEVICEID_TYPE deviceId, const wstring& name)
+        : Base(deviceId, name)
+    {
+    }
+    FusedElementwiseNode(DEVICEID_TYPE deviceId, const wstring& name, const FusedElementwiseProgram& program)
+        : Base(deviceId, name), m_program(program)
+    {
+    }
+
+    const FusedElementwiseProgram& GetProgram() const { return m_program; }
+
+    virtual void /*ComputationNode::*/ ForwardProp(const FrameRange& fr) override;
+    virtual void /*ComputationNode::*/ Backprop(const FrameRange& fr, bool childrenInThisLoop, bool childrenInOuterLoop) override;
+    virtual void /*ComputationNode::*/ BackpropTo(const size_t inputIndex, const FrameRange& fr) override;
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override;
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t /*childIndex*/) const override { return true; }
+    virtual ParentGradientOptimization ImplementsGradientOptimization(const ComputationNodeBase*) const override { return ParentGradientOptimization::Overwrite; }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override;
+    virtual void Save(File& fstream) const override;
+    virtual void Load(File& fstream, size_t modelVersion) override;
+
+    virtual void RequestMatricesBeforeBackprop(MatrixPool& matrixPool) override;
+    virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool) override;
+
+private:
+    // computes the gradients of the given inputs with as few passes over the data as possible
+    void BackpropToInputs(const FrameRange& fr, const std::vector<size_t>& inputIndices);
+    // an input broadcasts if its gradient must be reduced from the shape of the operation
+    bool InputBroadcasts(size_t inputIndex) const;
+
+    FusedElementwiseProgram m_program;
+    std::vector<shared_ptr<Matrix<ElemType>>> m_gradientTemps; // [i] gradient of broadcasting input i before the reduction
+};
+
 }}}
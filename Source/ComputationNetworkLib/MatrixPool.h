@@ -8,6 +8,7 @@
 #include <string>
 #include <stdexcept>
 #include <vector>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -32,8 +33,11 @@ struct MemRequestInfo
     int allocStep;                              // at what step counter memory allocation is requested 
     int releaseStep;                            // at what step counter memory release is requested  
     int memoryId;                               // integer indexing the memory buffer ID 
+    shared_ptr<Matrix<ElemType>> arenaMatrix;   // arena mode: the matrix assigned to pMatrixPtrs, nullptr if the request is not planned in the arena 
+    size_t arenaSize;                           // arena mode: number of elements reserved in the arena 
+    size_t arenaOffset;                         // arena mode: offset of the reserved elements in the arena 
     MemRequestInfo(DEVICEID_TYPE deviceId, shared_ptr<Matrix<ElemType>>*pMatrixPtr, size_t matrixSize, bool mbScale, bool isWorkSpace, int allocStep)
-        :deviceId(deviceId), matrixSize(matrixSize), mbScale(mbScale), isWorkSpace(isWorkSpace), allocStep(allocStep), releaseStep(INT_MAX), memoryId(-1)
+        :deviceId(deviceId), matrixSize(matrixSize), mbScale(mbScale), isWorkSpace(isWorkSpace), allocStep(allocStep), releaseStep(INT_MAX), memoryId(-1), arenaSize(0), arenaOffset(0)
     {
         pMatrixPtrs.push_back(pMatrixPtr);
     }
@@ -64,11 +68,26 @@ struct MemAllocInfo
 // MatrixPool -- class to support memory sharing
 // Despite the gather general name of this class, it is specifically designed to support the memory sharing of ComputationNodes.
 // Note: see #define SUPRESS_MEMSHARING below as for how to temporarily disable memory sharing altogether, for debugging
+//
+// Arena mode (SetUseArena()): the sizes of the requests are mostly unknown at OptimizedMemoryAllocation() time, so the
+// first minibatch runs on the shared matrices described above. After that, UpdateArena() plans the dense matrices of
+// each device as slots of one contiguous buffer, the arena: every request gets an offset such that requests with
+// overlapping lifetimes never overlap in memory (interval packing, see PlanArenaOffsets()). The slots are sized by
+// the observed matrix sizes. A matrix that has to grow beyond its slot, typically a minibatch-scaled one (mbScale)
+// when the minibatch grows, allocates its own buffer (see matrixFlagMayOutgrowBuffer), and the next UpdateArena()
+// plans the arena again with the new sizes, which may also be smaller than before.
+// Requests that are never released, e.g. the gradients of the parameters and the value of the training criterion,
+// are not planned in the arena: they are read after backprop, and SGD keeps pointers to them across minibatches.
 class MatrixPool
 {
 public:
     typedef const void* AliasNodePtr; // use as an identifier in place of ComputationNodeBasePtr to avoid include order issue
 
+    MatrixPool()
+        : m_stepCounter(0), m_useArena(false)
+    {
+    }
+
 protected:
     vector<MemRequestInfo<float>> m_memRequestInfoFloatVec; 
     vector<MemRequestInfo<double>> m_memRequestInfoDoubleVec;
@@ -79,6 +98,15 @@ protected:
     template <class ElemType>
     vector<MemRequestInfo<ElemType>>& GetMemRequestInfoVec();
 
+    // arena mode
+    bool m_useArena;
+    map<DEVICEID_TYPE, shared_ptr<Matrix<float>>> m_arenasFloat;
+    map<DEVICEID_TYPE, shared_ptr<Matrix<double>>> m_arenasDouble;
+    map<DEVICEID_TYPE, shared_ptr<Matrix<half>>> m_arenasHalf;
+
+    template <class ElemType>
+    map<DEVICEID_TYPE, shared_ptr<Matrix<ElemType>>>& GetArenas();
+
     // MatrixPool allows a bunch of node to share one matrix
 
     struct AliasInfo
@@ -156,6 +184,23 @@ public:
         return; 
     }
 
+    // must be set before OptimizedMemoryAllocation()
+    void SetUseArena(bool enable) { m_useArena = enable; }
+    bool UsesArena() const { return m_useArena; }
+
+    // Plans the arenas (again) if any matrix has outgrown its slot. Must only be called when none of the values in the pool
+    // are needed anymore, because planning loses them. Returns true if the arenas have been planned.
+    bool UpdateArena(bool verbose)
+    {
+        if (!m_useArena)
+            return false;
+
+        bool planned = UpdateArenaFunc<float>(verbose);
+        planned = UpdateArenaFunc<double>(verbose) || planned;
+        planned = UpdateArenaFunc<half>(verbose) || planned;
+        return planned;
+    }
+
     void SetAliasInfo(
         const unordered_map<AliasNodePtr, unordered_set<AliasNodePtr>>& groupMap,
         const unordered_map<AliasNodePtr, AliasNodePtr>& rootLookupMap)
@@ -382,12 +427,178 @@ private:
                             {
                                 *pOutMatrixPtr = matrixPtr;
                             }
+                            if (m_useArena && memInfo.releaseStep != INT_MAX)
+                                memInfo.arenaMatrix = matrixPtr;
                         }
                     }
                 }
             }
         }
     }
+    template <class ElemType>
+    bool UpdateArenaFunc(bool verbose)
+    {
+        vector<MemRequestInfo<ElemType>>& memInfoVec = GetMemRequestInfoVec<ElemType>();
+
+        bool needsPlanning = false;
+        for (auto& memInfo : memInfoVec)
+        {
+            if (!memInfo.arenaMatrix)
+                continue;
+
+            // A node may replace its matrix, e.g. by a sparse one. Such requests leave the arena for good.
+            bool replaced = memInfo.arenaMatrix->GetMatrixType() != DENSE;
+            for (auto pMatrixPtr : memInfo.pMatrixPtrs)
+                replaced = replaced || *pMatrixPtr != memInfo.arenaMatrix;
+            if (replaced)
+            {
+                if (memInfo.arenaMatrix->GetMatrixType() == DENSE)
+                {
+                    auto matrixPtr = make_shared<Matrix<ElemType>>(memInfo.deviceId);
+                    for (auto pMatrixPtr : memInfo.pMatrixPtrs)
+                    {
+                        if (*pMatrixPtr == memInfo.arenaMatrix)
+                            *pMatrixPtr = matrixPtr;
+                    }
+                }
+                memInfo.arenaMatrix = nullptr;
+                needsPlanning = true; // the content of the replaced matrix is gone
+                continue;
+            }
+
+            if (memInfo.arenaMatrix->BufferSize() > memInfo.arenaSize * sizeof(ElemType))
+                needsPlanning = true;
+        }
+
+        if (!needsPlanning)
+            return false;
+
+        // Slots are aligned like the buffers of the GPU memory allocator, so that kernels see the same alignment.
+        const size_t alignment = max<size_t>(1, 256 / sizeof(ElemType));
+        map<DEVICEID_TYPE, shared_ptr<Matrix<ElemType>>> arenas;
+        for (auto devId : m_deviceIDSet)
+        {
+            vector<MemRequestInfo<ElemType>*> requests;
+            for (auto& memInfo : memInfoVec)
+            {
+                if (memInfo.deviceId != devId || !memInfo.arenaMatrix)
+                    continue;
+
+                // A matrix outside of a slot, because it has outgrown it or because there is no plan yet, has its own
+                // buffer, which is as large as the matrix (or the matrices sharing it) has been since. The others get
+                // slots for their current size, so the arena shrinks along with the minibatch.
+                size_t bufferSize = memInfo.arenaMatrix->BufferSize() / sizeof(ElemType);
+                size_t size = bufferSize > memInfo.arenaSize ? bufferSize : memInfo.arenaMatrix->GetNumElements();
+                memInfo.arenaSize = (size + alignment - 1) / alignment * alignment;
+                requests.push_back(&memInfo);
+            }
+            if (requests.empty())
+                continue;
+
+            size_t arenaSize = PlanArenaOffsets(requests);
+            auto arena = arenaSize > 0 ? make_shared<Matrix<ElemType>>(arenaSize, 1, devId) : nullptr;
+            for (auto memInfo : requests)
+            {
+                auto matrixPtr = make_shared<Matrix<ElemType>>(devId);
+                if (memInfo->arenaSize > 0)
+                {
+                    size_t numRows = memInfo->arenaMatrix->GetNumRows();
+                    size_t numCols = memInfo->arenaMatrix->GetNumCols();
+                    matrixPtr->SetValue(memInfo->arenaSize, 1, devId, arena->Data() + memInfo->arenaOffset, matrixFlagDontOwnBuffer | matrixFlagMayOutgrowBuffer);
+                    if (numRows * numCols <= memInfo->arenaSize)
+                        matrixPtr->Resize(numRows, numCols);
+                }
+                for (auto pMatrixPtr : memInfo->pMatrixPtrs)
+                    *pMatrixPtr = matrixPtr;
+                memInfo->arenaMatrix = matrixPtr;
+            }
+            arenas[devId] = arena;
+
+            if (verbose)
+                PrintArenaPlan(devId, requests, arenaSize * sizeof(ElemType), sizeof(ElemType));
+        }
+
+        // The previous arenas are not referenced by any matrix anymore.
+        GetArenas<ElemType>() = arenas;
+        return true;
+    }
+
+    // Assigns offsets to the requests such that requests with overlapping lifetimes do not overlap in memory, and
+    // returns the size of the arena. Greedy by size: the largest request is placed first, each request goes into the
+    // smallest gap between the requests placed so far that are live at the same time, or behind them.
+    template <class ElemType>
+    size_t PlanArenaOffsets(vector<MemRequestInfo<ElemType>*>& requests)
+    {
+        std::stable_sort(requests.begin(), requests.end(), [](const MemRequestInfo<ElemType>* a, const MemRequestInfo<ElemType>* b)
+        {
+            return a->arenaSize > b->arenaSize;
+        });
+
+        size_t arenaSize = 0;
+        vector<MemRequestInfo<ElemType>*> placed;
+        vector<MemRequestInfo<ElemType>*> conflicts;
+        for (auto request : requests)
+        {
+            if (request->arenaSize == 0)
+                continue;
+
+            conflicts.clear();
+            vector<pair<int, int>> occupancy(1, make_pair(request->allocStep, request->releaseStep));
+            for (auto other : placed)
+            {
+                if (CheckOverlap(make_pair(other->allocStep, other->releaseStep), occupancy))
+                    conflicts.push_back(other);
+            }
+            std::sort(conflicts.begin(), conflicts.end(), [](const MemRequestInfo<ElemType>* a, const MemRequestInfo<ElemType>* b)
+            {
+                return a->arenaOffset < b->arenaOffset;
+            });
+
+            size_t offset = SIZE_MAX;
+            size_t smallestGap = SIZE_MAX;
+            size_t end = 0; // end of the conflicting requests seen so far
+            for (auto other : conflicts)
+            {
+                if (other->arenaOffset >= end + request->arenaSize && other->arenaOffset - end < smallestGap)
+                {
+                    offset = end;
+                    smallestGap = other->arenaOffset - end;
+                }
+                end = max(end, other->arenaOffset + other->arenaSize);
+            }
+            request->arenaOffset = offset != SIZE_MAX ? offset : end;
+            arenaSize = max(arenaSize, request->arenaOffset + request->arenaSize);
+            placed.push_back(request);
+        }
+        return arenaSize;
+    }
+
+    // Reports the planned arena against the peak of the simultaneously live matrices, which no plan can go below,
+    // and against the sum of all matrices, i.e. no sharing.
+    template <class ElemType>
+    void PrintArenaPlan(DEVICEID_TYPE devId, const vector<MemRequestInfo<ElemType>*>& requests, size_t arenaBytes, size_t elementSize)
+    {
+        map<int, long long> liveDelta; // change of the live size at each step
+        size_t totalSize = 0;
+        for (auto request : requests)
+        {
+            totalSize += request->arenaSize;
+            liveDelta[request->allocStep] += request->arenaSize;
+            if (request->releaseStep != INT_MAX)
+                liveDelta[request->releaseStep + 1] -= request->arenaSize;
+        }
+
+        long long live = 0, peakLive = 0;
+        for (const auto& delta : liveDelta)
+        {
+            live += delta.second;
+            peakLive = max(peakLive, live);
+        }
+
+        const double MB = 1024.0 * 1024.0;
+        fprintf(stderr, "MatrixPool: Planned arena of %.2f MB for %d matrices with %d-byte elements on device %d; peak of live matrices %.2f MB, all matrices %.2f MB.\n",
+                arenaBytes / MB, (int)requests.size(), (int)elementSize, (int)devId, peakLive * elementSize / MB, totalSize * elementSize / MB);
+    }
 };
 
 }}}
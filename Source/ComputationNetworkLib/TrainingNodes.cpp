@@ -103,11 +103,13 @@ template<class ElemType>
 void RandomSampleNodeBase<ElemType>::UpdateWeightsPrefixSum()
 {
     const Matrix<ElemType>& samplingWeights = Input(0)->ValueAsMatrix();
+    // copy the weights in one go instead of one element at a time, which is a device transfer each if they are on the GPU
+    unique_ptr<ElemType[]> weights(samplingWeights.CopyToArray());
     m_samplingWeightsPrefixSum.clear();
     double runningWeightsSum = 0;
     for (int iClass = 0; iClass < samplingWeights.GetNumRows(); iClass++)
     {
-        ElemType currentWeight = samplingWeights.GetValue(iClass, 0);
+        ElemType currentWeight = weights[iClass];
         if (currentWeight < 0)
             InvalidArgument("Sampling weights contain negative number %f.", (float)currentWeight);
 
@@ -307,6 +309,305 @@ template class RandomSampleInclusionFrequencyNode<float>;
 template class RandomSampleInclusionFrequencyNode<double>;
 template class RandomSampleInclusionFrequencyNode<half>;
 
+void WalkerAliasTable::Build(const std::vector<double>& weights)
+{
+    const size_t numClasses = weights.size();
+    double sumOfWeights = 0;
+    for (double weight : weights)
+    {
+        if (weight < 0)
+            InvalidArgument("Sampling weights contain negative number %f.", weight);
+        sumOfWeights += weight;
+    }
+    if (!(sumOfWeights > 0) || std::isinf(sumOfWeights))
+        InvalidArgument("Sampling weights must be finite and not all zero.");
+
+    // Vose's algorithm: the probabilities scaled by numClasses are split into those below 1 and the others. Each class below 1
+    // is filled up to 1 with its alias, a class above 1, whose remaining probability is reduced accordingly.
+    m_probabilities.resize(numClasses);
+    m_thresholds.resize(numClasses);
+    m_alias.resize(numClasses);
+    std::vector<size_t> small, large;
+    for (size_t i = 0; i < numClasses; i++)
+    {
+        m_probabilities[i] = weights[i] / sumOfWeights;
+        m_thresholds[i] = m_probabilities[i] * numClasses;
+        m_alias[i] = i;
+        (m_thresholds[i] < 1 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty())
+    {
+        size_t lessLikely = small.back();
+        size_t moreLikely = large.back();
+        small.pop_back();
+        m_alias[lessLikely] = moreLikely;
+        m_thresholds[moreLikely] -= 1 - m_thresholds[lessLikely];
+        if (m_thresholds[moreLikely] < 1)
+        {
+            large.pop_back();
+            small.push_back(moreLikely);
+        }
+    }
+    // the classes left over have a scaled probability of 1, up to rounding errors
+    for (size_t i : small)
+        m_thresholds[i] = 1;
+    for (size_t i : large)
+        m_thresholds[i] = 1;
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::Validate(bool isFinalValidationPass)
+{
+    Base::Validate(isFinalValidationPass);
+    m_pMBLayout = nullptr; // this node does not hold mini-batch data
+
+    if (m_sizeOfSampledSet == 0)
+        InvalidArgument("%ls: Number of requested samples is zero.", NodeDescription().c_str());
+
+    // the output weights can be inferred as for outputWeights' * input
+    size_t numClasses = Input(0)->GetSampleMatrixNumRows();
+    size_t inputDim = Input(1)->GetSampleMatrixNumRows();
+    if (numClasses != 0 && inputDim != 0)
+        Input(2)->ValidateInferInputDimsFrom(TensorShape(inputDim, numClasses));
+
+    if (isFinalValidationPass)
+    {
+        if (!Input(0)->HasMBLayout() || !Input(1)->HasMBLayout() || Input(2)->HasMBLayout() || Input(3)->HasMBLayout())
+            LogicError("%ls: The labels and the input must be minibatches, and the output weights and the sampling weights must not.", NodeDescription().c_str());
+        this->ValidateMBLayout(Input(0), Input(1));
+
+        if (Input(2)->GetAsMatrixNumRows() != inputDim || Input(2)->GetAsMatrixNumCols() != numClasses)
+            LogicError("%ls: The output weights must be a [%d x %d] matrix, a column for each of the classes of the labels, but they are [%d x %d].", NodeDescription().c_str(),
+                       (int)inputDim, (int)numClasses, (int)Input(2)->GetAsMatrixNumRows(), (int)Input(2)->GetAsMatrixNumCols());
+        if (Input(3)->GetSampleLayout().GetNumElements() != numClasses)
+            LogicError("%ls: The sampling weights must have as many elements as there are classes (%d).", NodeDescription().c_str(), (int)numClasses);
+    }
+
+    SetDims(TensorShape::Scalar(Environment().IsV2Library()), false);
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::UpdateSampler()
+{
+    // The sampler only depends on the sampling weights, typically a constant, so its O(numClasses) setup is not repeated for every minibatch.
+    auto& samplingWeightsNode = InputRef(3);
+    if (m_aliasTable.GetNumClasses() != 0 && m_samplingWeightsTimeStamp == samplingWeightsNode.GetEvalTimeStamp())
+        return;
+
+    const Matrix<ElemType>& samplingWeights = samplingWeightsNode.Value();
+    unique_ptr<ElemType[]> weights(samplingWeights.CopyToArray());
+    m_aliasTable.Build(std::vector<double>(weights.get(), weights.get() + samplingWeights.GetNumElements()));
+
+    // Log of the expected number of occurrences of each class in the sampled set. Labels of classes with a sampling weight of 0 get a very
+    // large logit, and thus almost no gradient.
+    std::vector<ElemType> logPrior(m_aliasTable.GetNumClasses());
+    for (size_t i = 0; i < logPrior.size(); i++)
+        logPrior[i] = (ElemType)log(std::max(m_sizeOfSampledSet * m_aliasTable.GetProbability(i), std::numeric_limits<double>::min()));
+
+    if (!m_logPrior)
+        m_logPrior = std::make_shared<Matrix<ElemType>>(Value().GetDeviceId());
+    m_logPrior->SetValue(1, logPrior.size(), Value().GetDeviceId(), logPrior.data());
+    m_samplingWeightsTimeStamp = samplingWeightsNode.GetEvalTimeStamp();
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::DrawSamples()
+{
+    // the samples are drawn on the CPU, and only their sparse one-hot vectors and log priors are moved to the device
+    boost::random::uniform_real_distribution<double> r(0, 1);
+    CPURNGHandle* cpuRNGHandle = dynamic_cast<CPURNGHandle*>(&GetRNGHandle(CPUDEVICE));
+
+    std::vector<CPUSPARSE_INDEX_TYPE> rowIndices(m_sizeOfSampledSet);
+    std::vector<CPUSPARSE_INDEX_TYPE> columnStarts(m_sizeOfSampledSet + 1);
+    std::vector<ElemType> ones(m_sizeOfSampledSet, (ElemType)1);
+    std::vector<ElemType> sampledLogPrior(m_sizeOfSampledSet);
+    for (size_t i = 0; i < m_sizeOfSampledSet; i++)
+    {
+        size_t sample = m_aliasTable.Draw(r(cpuRNGHandle->Generator()));
+        rowIndices[i] = (CPUSPARSE_INDEX_TYPE)sample;
+        columnStarts[i] = (CPUSPARSE_INDEX_TYPE)i;
+        sampledLogPrior[i] = (ElemType)log(std::max(m_sizeOfSampledSet * m_aliasTable.GetProbability(sample), std::numeric_limits<double>::min()));
+    }
+    columnStarts[m_sizeOfSampledSet] = (CPUSPARSE_INDEX_TYPE)m_sizeOfSampledSet;
+    UpdateRngOffset(GetRngOffset() + m_sizeOfSampledSet);
+
+    if (!m_sampleSelection)
+    {
+        m_sampleSelection = std::make_shared<Matrix<ElemType>>(0, 0, Value().GetDeviceId(), SPARSE, matrixFormatSparseCSC);
+        m_sampledLogPrior = std::make_shared<Matrix<ElemType>>(Value().GetDeviceId());
+    }
+    m_sampleSelection->SetMatrixFromCSCFormat(columnStarts.data(), rowIndices.data(), ones.data(), m_sizeOfSampledSet, m_aliasTable.GetNumClasses(), m_sizeOfSampledSet);
+    m_sampledLogPrior->SetValue(m_sizeOfSampledSet, 1, Value().GetDeviceId(), sampledLogPrior.data());
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::ForwardPropNonLooping()
+{
+    FrameRange fr(InputRef(0).GetMBLayout());
+    UpdateSampler();
+    DrawSamples();
+
+    auto labels = InputRef(0).MaskedValueFor(fr);
+    auto input = InputRef(1).MaskedValueFor(fr);
+    const auto& outputWeights = InputRef(2).ValueAsMatrix();
+
+    // Only the columns of the output weights of the sampled classes and of the labels are needed. The logits' gradients below hold the
+    // logits until they are computed.
+    auto& labelLogits = *m_labelLogitGradient;
+    auto& sampledLogits = *m_sampledLogitsGradient;
+    m_sampledWeights->AssignProductOf(outputWeights, false, *m_sampleSelection, false);
+    m_labelWeights->AssignProductOf(outputWeights, false, labels, false);
+
+    Matrix<ElemType>::InnerProduct(*m_labelWeights, input, labelLogits, true);
+    Matrix<ElemType>::MultiplyAndWeightedAdd(-1, *m_logPrior, false, labels, false, 1, labelLogits);
+    sampledLogits.AssignProductOf(*m_sampledWeights, true, input, false);
+    Matrix<ElemType>::ScaleAndAdd(-1, *m_sampledLogPrior, sampledLogits);
+
+    // log softmax over the label and the sampled classes of each frame
+    m_logits->Resize(m_sizeOfSampledSet + 1, input.GetNumCols());
+    m_logits->AssignToRowSliceValuesOf(labelLogits, 0, 1);
+    m_logits->AssignToRowSliceValuesOf(sampledLogits, 1, m_sizeOfSampledSet);
+    m_logits->InplaceLogSoftmax(true);
+
+    // flatten all gaps to zero, such that gaps will contribute zero to the sum
+    labelLogits.AssignRowSliceValuesOf(*m_logits, 0, 1);
+    MaskMissingColumnsToZero(labelLogits, InputRef(0).GetMBLayout(), fr);
+    Value().AssignSumOfElements(labelLogits);
+    Value() *= -1;
+#if NANCHECK
+    Value().HasNan("SampledCrossEntropyWithSoftmax");
+#endif
+
+    // The gradients w.r.t. the logits are softmax - 1 for the labels and softmax for the sampled classes. They are multiplied by the gradient
+    // of this node in BackpropToNonLooping().
+    m_logits->InplaceExp();
+    labelLogits.AssignRowSliceValuesOf(*m_logits, 0, 1);
+    labelLogits += (ElemType)-1;
+    sampledLogits.AssignRowSliceValuesOf(*m_logits, 1, m_sizeOfSampledSet);
+    MaskMissingColumnsToZero(labelLogits, InputRef(0).GetMBLayout(), fr);
+    MaskMissingColumnsToZero(sampledLogits, InputRef(0).GetMBLayout(), fr);
+    m_logitsGradientScaled = false;
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::BackpropToNonLooping(size_t inputIndex)
+{
+    if (inputIndex == 0 || inputIndex == 3)
+        InvalidArgument("%ls: The gradient can only be computed with respect to the input and the output weights.", NodeDescription().c_str());
+
+    FrameRange fr(InputRef(0).GetMBLayout());
+    if (!m_logitsGradientScaled)
+    {
+        Matrix<ElemType>::Scale(Gradient() /*1x1*/, *m_labelLogitGradient);
+        Matrix<ElemType>::Scale(Gradient() /*1x1*/, *m_sampledLogitsGradient);
+        m_logitsGradientScaled = true;
+    }
+
+    if (inputIndex == 1)
+    {
+        // sampledWeights * sampledLogitsGradient, plus labelWeights with each column scaled by the gradient of its label's logit
+        auto inputGradient = InputRef(1).GradientFor(fr);
+        Matrix<ElemType>::MultiplyAndAdd(*m_sampledWeights, false, *m_sampledLogitsGradient, false, inputGradient);
+        m_labelWeights->RowElementMultiplyWith(*m_labelLogitGradient); // m_labelWeights is not needed any more
+        inputGradient += *m_labelWeights;
+    }
+    else
+    {
+        auto labels = InputRef(0).ValueFor(fr);
+        auto input = InputRef(1).ValueFor(fr);
+
+        if (labels.GetMatrixType() == SPARSE &&
+            InputRef(2).GetPreferredGradientMatrixType() == UNDETERMINED &&
+            InputRef(2).Gradient().GetMatrixType() == DENSE)
+        {
+            // Both terms below are DENSE * SPARSE', so the gradient of the output weights only has the columns of the labels and the sampled
+            // classes. As in TimesNode, a new sparse matrix is allocated instead of switching the type in place, since switching in place
+            // may affect other nodes who share this matrix due to memory sharing.
+            auto& currentGradient = InputRef(2).Gradient();
+            InputRef(2).GradientPtrRef() = std::make_shared<Matrix<ElemType>>(currentGradient.GetNumRows(), currentGradient.GetNumCols(),
+                                                                              currentGradient.GetPreferredDeviceId(), SPARSE, matrixFormatSparseBlockCol);
+            InputRef(2).SetPreferredGradientMatrixType(SPARSE);
+        }
+        else if (labels.GetMatrixType() == DENSE && InputRef(2).GetPreferredGradientMatrixType() != DENSE)
+        {
+            if (InputRef(2).GetPreferredGradientMatrixType() == SPARSE)
+                InputRef(2).Gradient().SwitchToMatrixType(DENSE, matrixFormatDense, /*keepValues=*/true);
+            InputRef(2).SetPreferredGradientMatrixType(DENSE);
+        }
+
+        auto& weightsGradient = InputRef(2).Gradient();
+        // (input * sampledLogitsGradient') * sampleSelection'
+        m_weightsGradientTemp->AssignProductOf(input, false, *m_sampledLogitsGradient, true);
+        Matrix<ElemType>::MultiplyAndAdd(*m_weightsGradientTemp, false, *m_sampleSelection, true, weightsGradient);
+        // input with each column scaled by the gradient of its label's logit, times labels'
+        m_weightsGradientTemp->SetValue(input);
+        m_weightsGradientTemp->RowElementMultiplyWith(*m_labelLogitGradient);
+        Matrix<ElemType>::MultiplyAndAdd(*m_weightsGradientTemp, false, labels, true, weightsGradient);
+    }
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const
+{
+    Base::CopyTo(nodeP, newName, flags);
+    if (flags & CopyNodeFlags::copyNodeValue)
+    {
+        auto node = dynamic_pointer_cast<SampledCrossEntropyWithSoftmaxNode<ElemType>>(nodeP);
+        node->m_sizeOfSampledSet = m_sizeOfSampledSet;
+        node->SetRngState(GetRngSeed(), GetRngOffset());
+    }
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::Save(File& fstream) const
+{
+    Base::Save(fstream);
+    fstream << m_sizeOfSampledSet;
+    RngUser::Save(fstream);
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::Load(File& fstream, size_t modelVersion)
+{
+    Base::Load(fstream, modelVersion);
+    fstream >> m_sizeOfSampledSet;
+    RngUser::Load(fstream, modelVersion);
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::RequestMatricesBeforeForwardProp(MatrixPool& matrixPool)
+{
+    Base::RequestMatricesBeforeForwardProp(matrixPool);
+    RequestMatrixFromPool(m_sampledWeights, matrixPool);
+    RequestMatrixFromPool(m_labelWeights, matrixPool);
+    RequestMatrixFromPool(m_logits, matrixPool);
+    RequestMatrixFromPool(m_labelLogitGradient, matrixPool);
+    RequestMatrixFromPool(m_sampledLogitsGradient, matrixPool);
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::RequestMatricesBeforeBackprop(MatrixPool& matrixPool)
+{
+    Base::RequestMatricesBeforeBackprop(matrixPool);
+    RequestMatrixFromPool(m_weightsGradientTemp, matrixPool);
+}
+
+template <class ElemType>
+void SampledCrossEntropyWithSoftmaxNode<ElemType>::ReleaseMatricesAfterBackprop(MatrixPool& matrixPool)
+{
+    Base::ReleaseMatricesAfterBackprop(matrixPool);
+    ReleaseMatrixToPool(m_sampledWeights, matrixPool);
+    ReleaseMatrixToPool(m_labelWeights, matrixPool);
+    ReleaseMatrixToPool(m_logits, matrixPool);
+    ReleaseMatrixToPool(m_labelLogitGradient, matrixPool);
+    ReleaseMatrixToPool(m_sampledLogitsGradient, matrixPool);
+    ReleaseMatrixToPool(m_weightsGradientTemp, matrixPool);
+}
+
+template class SampledCrossEntropyWithSoftmaxNode<float>;
+template class SampledCrossEntropyWithSoftmaxNode<double>;
+template class SampledCrossEntropyWithSoftmaxNode<half>;
+
 template<class ElemType>
 void DropoutNode<ElemType>::Save(File& fstream) const
 {
@@ -1456,6 +1456,121 @@ private:
     double EstimateNumberOfTries();
 };
 
+// ------------------------------------------------------------------------------------------------------------------------------------------------
+// WalkerAliasTable
+// Draws classes with probabilities proportional to a vector of weights in O(1) per draw (Walker's alias method, built with Vose's algorithm
+// in O(numClasses)): class i is drawn from a uniform random number u as follows: i is the integer part of u * numClasses, and the result is
+// i if the fractional part is below the threshold of i, else the alias of i.
+// ------------------------------------------------------------------------------------------------------------------------------------------------
+class WalkerAliasTable
+{
+public:
+    // The weights must be >= 0 and not all 0.
+    void Build(const std::vector<double>& weights);
+
+    size_t GetNumClasses() const { return m_alias.size(); }
+
+    // Probability of drawing class i.
+    double GetProbability(size_t i) const { return m_probabilities[i]; }
+
+    // Maps a uniform random number in [0, 1) to a class.
+    size_t Draw(double u) const
+    {
+        double x = u * m_alias.size();
+        size_t i = std::min((size_t)x, m_alias.size() - 1);
+        return x - i < m_thresholds[i] ? i : m_alias[i];
+    }
+
+private:
+    std::vector<double> m_thresholds;
+    std::vector<size_t> m_alias;
+    std::vector<double> m_probabilities;
+};
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------
+// SampledCrossEntropyWithSoftmaxNode (labels, input, outputWeights, samplingWeights)
+// Sampled softmax: approximates CrossEntropyWithSoftmax(labels, outputWeights' * input) for a large number of classes by normalizing
+// over the label and a set of sizeOfSampledSet classes sampled for the whole minibatch, instead of over all classes. Each logit is corrected
+// by the log of the expected number of times its class occurs in the sampled set, i.e. the sum over all frames of
+//     -z_label + log(exp(z_label) + sum_s exp(z_s))   with   z_c = outputWeights[:,c]' * input - log(sizeOfSampledSet * q_c)
+// where q_c is the probability of sampling class c. Sampling is with replacement, and a sampled class that happens to be the label is not
+// removed from the set (as in the BrainScript and Python sampled softmax examples built from RandomSample).
+//
+// Only the logits of the labels and of the sampled classes are computed, so the cost of a minibatch grows with sizeOfSampledSet rather than
+// with the number of classes, apart from rebuilding the sampler whenever the sampling weights change. Sampling is done with a WalkerAliasTable.
+// If the labels are sparse, the gradient of the outputWeights is a sparse block column matrix with only the columns of the labels and the
+// sampled classes, as for the TimesNode of an embedding.
+//
+//  - Input(0) labels: one-hot vectors of dimension numClasses (typically sparse), one per frame
+//  - Input(1) input: hidden layer activity [inputDim x T]
+//  - Input(2) outputWeights: [inputDim x numClasses], a column per class
+//  - Input(3) samplingWeights: vector of numClasses weights >= 0 that the classes are sampled proportionally to (e.g. the unigram counts)
+//  - sizeOfSampledSet: number of classes sampled per minibatch
+// ------------------------------------------------------------------------------------------------------------------------------------------------
+template <class ElemType>
+class SampledCrossEntropyWithSoftmaxNode : public ComputationNodeNonLooping /*ComputationNode*/<ElemType>, public NumInputs<4>, public RngUser
+{
+    typedef ComputationNodeNonLooping<ElemType> Base; UsingComputationNodeMembersBoilerplate;
+    static const std::wstring TypeName() { return L"SampledCrossEntropyWithSoftmax"; }
+
+public:
+    SampledCrossEntropyWithSoftmaxNode(DEVICEID_TYPE deviceId, const wstring& name, size_t sizeOfSampledSet = 0)
+        : Base(deviceId, name), m_sizeOfSampledSet(sizeOfSampledSet), m_samplingWeightsTimeStamp(0), m_logitsGradientScaled(false)
+    {
+        SetRngState(CreateUniqId());
+    }
+
+    SampledCrossEntropyWithSoftmaxNode(const ScriptableObjects::IConfigRecordPtr configp)
+        : SampledCrossEntropyWithSoftmaxNode(configp->Get(L"deviceId"), L"<placeholder>", configp->Get(L"sizeOfSampledSet"))
+    {
+        AttachInputsFromConfig(configp, this->GetExpectedNumInputs());
+    }
+
+    virtual void /*ComputationNodeNonLooping::*/ ForwardPropNonLooping() override;
+    virtual void /*ComputationNodeNonLooping::*/ BackpropToNonLooping(size_t inputIndex) override;
+    virtual void /*ComputationNodeBase::*/ Validate(bool isFinalValidationPass) override;
+
+    virtual bool OutputUsedInComputingInputNodesGradients() const override { return false; }
+    virtual bool InputUsedInComputingInputNodesGradients(size_t childIndex) const override { return childIndex == 0 || childIndex == 1; }
+
+    // The classes are sampled anew for each minibatch.
+    virtual bool IsOutOfDateWrtInputs() const override { return true; }
+
+    virtual void CopyTo(ComputationNodeBasePtr nodeP, const std::wstring& newName, const CopyNodeFlags flags) const override;
+    virtual void Save(File& fstream) const override;
+    virtual void Load(File& fstream, size_t modelVersion) override;
+
+    virtual void RequestMatricesBeforeForwardProp(MatrixPool& matrixPool) override;
+    virtual void RequestMatricesBeforeBackprop(MatrixPool& matrixPool) override;
+    virtual void ReleaseMatricesAfterBackprop(MatrixPool& matrixPool) override;
+
+    size_t GetNumSamples() const { return m_sizeOfSampledSet; }
+
+protected:
+    // Rebuilds the alias table and the log of the expected number of occurrences of each class in the sampled set, if the sampling weights changed.
+    void UpdateSampler();
+
+    // Draws the classes of this minibatch into m_sampleSelection, a sparse [numClasses x sizeOfSampledSet] matrix of one-hot columns,
+    // and their log expected numbers of occurrences into m_sampledLogPrior.
+    void DrawSamples();
+
+    size_t m_sizeOfSampledSet;
+
+    WalkerAliasTable m_aliasTable;
+    uint64_t m_samplingWeightsTimeStamp;           // eval time stamp of the sampling weights that m_aliasTable was built from
+    shared_ptr<Matrix<ElemType>> m_logPrior;        // [1 x numClasses] log(sizeOfSampledSet * q_c)
+    shared_ptr<Matrix<ElemType>> m_sampledLogPrior; // [sizeOfSampledSet x 1] log(sizeOfSampledSet * q_c) of the sampled classes
+    shared_ptr<Matrix<ElemType>> m_sampleSelection; // [numClasses x sizeOfSampledSet] sparse one-hot columns of the sampled classes
+
+    shared_ptr<Matrix<ElemType>> m_sampledWeights;        // [inputDim x sizeOfSampledSet] columns of the outputWeights of the sampled classes
+    shared_ptr<Matrix<ElemType>> m_labelWeights;          // [inputDim x T] columns of the outputWeights of the labels
+    shared_ptr<Matrix<ElemType>> m_logits;                // [(1 + sizeOfSampledSet) x T] corrected logits of the label and of the sampled classes
+    shared_ptr<Matrix<ElemType>> m_labelLogitGradient;    // [1 x T] gradient of the criterion w.r.t. the logits of the labels
+    shared_ptr<Matrix<ElemType>> m_sampledLogitsGradient; // [sizeOfSampledSet x T] gradient of the criterion w.r.t. the logits of the sampled classes
+    shared_ptr<Matrix<ElemType>> m_weightsGradientTemp;
+    bool m_logitsGradientScaled;                          // whether the logits' gradients were multiplied by the gradient of this node
+};
+
 // -----------------------------------------------------------------------
 // ClassBasedCrossEntropyWithSoftmaxNode (labeldata(.,t), inputdata(.,t), embeddingMatrix, clsProbBeforeSoftmaxData(.,t))
 //  - Input(0) [4 x T] label in dense matrix in
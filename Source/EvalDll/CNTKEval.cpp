@@ -40,6 +40,7 @@ void CNTKEvalBase<ElemType>::Init(const std::string& config)
     CPUMatrix<ElemType>::SetNumThreads(nThreads);
 
     Globals::SetShareNodeValueMatrices(m_config(L"shareNodeValueMatrices", true));
+    Globals::SetMemoryArena(m_config(L"memoryArena", false));
 }
 
 
@@ -58,6 +59,13 @@ void CNTKEvalBase<ElemType>::CreateNetwork(const std::string& networkDescription
     {
         LogicError("Unable to construct network from description");
     }
+
+    // evalQuantization=int8 evaluates the products with weights in int8 on CPU (per model, default: none)
+    wstring quantization = config(L"evalQuantization", L"none");
+    if (quantization == L"int8")
+        ComputationNetwork::SetInt8Evaluation(this->m_net, nullptr, true);
+    else if (quantization != L"none")
+        InvalidArgument("evalQuantization: Unknown value '%ls', expected 'none' or 'int8'.", quantization.c_str());
 }
 
 
@@ -29,6 +29,8 @@ namespace Microsoft { namespace MSR { namespace CNTK {
 
 double logadd(double x, double y);
 
+template <class ElemType> class CPURNNExecutor;
+
 // To comply with BLAS libraries matrices are stored in ColMajor. However, by default C/C++/C# use RowMajor
 // conversion is need when passing data between CPUMatrix and C++ matrices
 template <class ElemType>
@@ -39,6 +41,7 @@ class MATH_API CPUMatrix : public BaseMatrix<ElemType>
     using Base::m_numCols;
     using Base::m_sliceViewOffset;
     using Base::HasExternalBuffer;
+    using Base::MayOutgrowExternalBuffer;
     using Base::SetBuffer;
     using Base::SetComputeDeviceId;
     using Base::SetSizeAllocated;
@@ -115,6 +118,14 @@ public:
 
     void AdaDeltaFlushTimestamps(size_t cols, ElemType rho, int* timestamps, int currentTimestamp);
 
+    // Brings the states of the lazy sparse updates (see CPUSparseMatrix::Adam()) up to date: state s is decayed by
+    // decays[s] per step, and kept at or above floors[s] if that is positive.
+    void LazyUpdateFlushTimestamps(size_t cols, const std::vector<ElemType>& decays, const std::vector<ElemType>& floors, int* timestamps, int currentTimestamp);
+
+    // Updates all 'parameters' with their 'gradients' and 'smoothedGradients' in one pass, see Matrix::FusedLearnerUpdate().
+    static void FusedLearnerUpdate(const FusedLearnerStep& step, const std::vector<CPUMatrix<ElemType>*>& parameters,
+                                   const std::vector<CPUMatrix<ElemType>*>& gradients, const std::vector<CPUMatrix<ElemType>*>& smoothedGradients);
+
     void Reshape(const size_t numRows, const size_t numCols);
 
 
@@ -300,6 +311,7 @@ public:
     ElemType SumOfAbsElements() const; // sum of all abs(elements)
     ElemType SumOfElements() const;    // sum of all elements
     CPUMatrix<ElemType>& AssignSumOfElements(const CPUMatrix<ElemType>& a);
+    bool HasNanOrInf() const;
 
     CPUMatrix<ElemType>& AssignOneHot(const CPUMatrix<ElemType>& a, vector<size_t>& shape, size_t axis);
     CPUMatrix<ElemType>& GatherFromTarget(const CPUMatrix<ElemType>& indices, const CPUMatrix<ElemType>& target, size_t row_elements);
@@ -435,6 +447,11 @@ public:
     void BatchNormalizationBackward(const CPUMatrix<ElemType>& in, CPUMatrix<ElemType>& grad, const CPUMatrix<StatType>& scale, double blendFactor, const CPUMatrix<StatType>& saveMean, const CPUMatrix<StatType>& saveInvStdDev,
                                     CPUMatrix<StatType>& scaleGrad, CPUMatrix<StatType>& biasGrad) const;
 
+    // RNN support functions
+    void RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const struct RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+
 public:
     // This functions do not depend on <ElemType>, i.e. you can call them on any <ElemType>
     static int SetNumThreads(int numThreads);
@@ -443,6 +460,8 @@ public:
     enum OptimizationFlag
     {
         OPT_EVAL_WITH_MKL = 1, // using Intel MKL functions for evaluation performance
+        OPT_PARALLEL_REDUCTION = 2, // multi-threaded and vectorized tensor reductions (results do not depend on the number of threads)
+        OPT_PARALLEL_CTC = 4, // CTC (AssignCTCScore) with utterances in parallel and vectorized over label states
     };
     static void SetOptimizationFlags(int flags);
     static int  GetOptimizationFlags();
@@ -504,6 +523,10 @@ public:
                      const SmallVector<size_t>& regularOpDims, const std::array<SmallVector<ptrdiff_t>, 2>& regularStrides,
                      const SmallVector<size_t>& reducingOpDims, const std::array<SmallVector<ptrdiff_t>, 2>& reducingStrides);
 
+    static void FusedTensorOp(const FusedElementwiseProgram& program, const std::vector<const CPUMatrix<ElemType>*>& inputs, const CPUMatrix<ElemType>* outputGradient,
+                              const std::vector<CPUMatrix<ElemType>*>& results, const std::vector<ElemType>& betas, ElemType alpha,
+                              const std::vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const std::vector<SmallVector<ptrdiff_t>>& regularStrides);
+
     static CPUMatrix<ElemType> Ones(const size_t rows, const size_t cols);
     static CPUMatrix<ElemType> Zeros(const size_t rows, const size_t cols);
     static CPUMatrix<ElemType> Eye(const size_t rows);
@@ -552,8 +575,7 @@ public:
         stream << s << format;
 
         stream << us.m_numRows << us.m_numCols;
-        for (size_t i = 0; i < us.GetNumElements(); ++i)
-            stream << us.Data()[i];
+        stream.PutArray(us.Data(), us.GetNumElements());
         stream.PutMarker(fileMarkerEndSection, std::wstring(L"EMAT"));
         return stream;
     }
@@ -597,6 +619,8 @@ private:
 
 private:
     static int m_optimizationFlags;
+
+    mutable std::shared_ptr<CPURNNExecutor<ElemType>> m_rnnExecutor; // for OptimizedRNNStack
 };
 
 typedef CPUMatrix<float> CPUSingleMatrix;
@@ -621,6 +645,11 @@ void CPUMatrixTensorOpImpl(ElemType beta, const CPUMatrix<ElemType>& a, const CP
     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, 4>& regularStrides,
     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, 4>& reducingStrides);
 
+template<typename ElemType>
+void CPUMatrixFusedTensorOpImpl(const FusedElementwiseProgram& program, const vector<const CPUMatrix<ElemType>*>& inputs, const CPUMatrix<ElemType>* outputGradient,
+    const vector<CPUMatrix<ElemType>*>& results, const vector<ElemType>& betas, ElemType alpha,
+    const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides);
+
 template<typename ElemType>
 void CPUMatrixTensorArgOpImpl(const CPUMatrix<ElemType>& a, CPUMatrix<ElemType>& o, ElementWiseOperator reductionOp,
     const array<size_t, 2>& offsets,
@@ -7,19 +7,8 @@
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
-// General conversion function with no performance optimization
-// this should only be used in CPU half precision
-// For performance on inference on CPU, user should convert fp16 model to fp32 first, unless MKL supports half precision
-template<typename SrcT, typename DstT>
-static void ConvertBuffer(DstT* dst, const SrcT* src, size_t count)
-{
-    for (size_t i = 0; i < count; i++)
-    {
-        dst[i] = (DstT)src[i];
-    }
-}
-
 // specialization to convert from half to float for computation, and then store in half
+// The conversions use F16C where available, see ConvertBuffer() in half.hpp.
 template <>
 void CPUMatrix<half>::MultiplyAndWeightedAdd(half alpha, const CPUMatrix<half>& a, const bool transposeA, const CPUMatrix<half>& b, const bool transposeB,
     half beta, CPUMatrix<half>& c, shared_ptr<QuantizedMultiplier<half>> pQuantizedMultiplier)
@@ -30,13 +19,13 @@ void CPUMatrix<half>::MultiplyAndWeightedAdd(half alpha, const CPUMatrix<half>&
 
     if (alpha != 0)
     {
-        ConvertBuffer<half, float>(af.Data(), a.Data(), a.GetNumElements());
-        ConvertBuffer<half, float>(bf.Data(), b.Data(), b.GetNumElements());
+        ConvertBuffer(af.Data(), a.Data(), a.GetNumElements());
+        ConvertBuffer(bf.Data(), b.Data(), b.GetNumElements());
     }
 
     if (beta != 0)
     {
-        ConvertBuffer<half, float>(cf.Data(), c.Data(), c.GetNumElements());
+        ConvertBuffer(cf.Data(), c.Data(), c.GetNumElements());
     }
 
     if (pQuantizedMultiplier)
@@ -44,7 +33,7 @@ void CPUMatrix<half>::MultiplyAndWeightedAdd(half alpha, const CPUMatrix<half>&
 
     CPUMatrix<float>::MultiplyAndWeightedAdd((float)alpha, af, transposeA, bf, transposeB, (float)beta, cf, nullptr);
 
-    ConvertBuffer<float, half>(c.Data(), cf.Data(), c.GetNumElements());
+    ConvertBuffer(c.Data(), cf.Data(), c.GetNumElements());
 }
 
 // specialization to RunTimeError for now due to omp implementation only support build-in type
@@ -115,7 +104,7 @@ void CPUMatrix<half>::AveragePoolingBackward(const CPUMatrix<int>& mpRowCol, con
 
 // explicit instantiations, due to CPUMatrix being too big and causing VS2015 cl crash.
 template class MATH_API CPUMatrix<half>;
-template<> int CPUMatrix<half>::m_optimizationFlags = 0;
+template<> int CPUMatrix<half>::m_optimizationFlags = CPUMatrix<half>::OPT_PARALLEL_REDUCTION;
 
 // instantiate templated methods
 template void CPUMatrix<float>::AdaDelta(CPUMatrix<float>& gradients, CPUMatrix<float>& functionValues, float learningRate, float rho, float epsilon);
@@ -11,6 +11,7 @@
 #include "File.h"
 
 #include "CPUMatrix.h"
+#include "CPURNN.h"
 #include "TensorOps.h"
 #include <assert.h>
 #include <stdexcept>
@@ -29,6 +30,10 @@
 #pragma warning(pop)
 #include <boost/random/uniform_real_distribution.hpp>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #ifdef _WIN32
 #define NOMINMAX
 #include "Windows.h"
@@ -878,11 +883,12 @@ void CPUMatrix<ElemType>::SetValue(const size_t numRows, const size_t numCols, E
     if (matrixFlags & matrixFlagDontOwnBuffer)
     {
         // free previous array allocation if any before overwriting
-        delete[] Buffer();
+        if (OwnBuffer())
+            delete[] Buffer();
 
         m_numRows = numRows;
         m_numCols = numCols;
-        SetBuffer(pArray, GetNumElements() * sizeof(ElemType), true);
+        SetBuffer(pArray, GetNumElements() * sizeof(ElemType), true, (matrixFlags & matrixFlagMayOutgrowBuffer) != 0);
         SetSizeAllocated(GetNumElements());
     }
     else
@@ -1510,6 +1516,316 @@ void CPUMatrix<ElemType>::AdaDeltaFlushTimestamps(size_t cols, ElemType rho, int
     }
 }
 
+template <class ElemType>
+void CPUMatrix<ElemType>::LazyUpdateFlushTimestamps(size_t cols, const std::vector<ElemType>& decays, const std::vector<ElemType>& floors, int* timestamps, int currentTimestamp)
+{
+    // Same as AdaDeltaFlushTimestamps() for any number of logical buffers, each with its own decay.
+    if (decays.size() != floors.size() || GetNumCols() < decays.size() * cols)
+        LogicError("LazyUpdateFlushTimestamps: The matrix does not have expected dimensions.");
+
+    auto rows = GetNumRows();
+    auto numStates = decays.size();
+#pragma omp parallel for
+    for (long col = 0; col < (long)cols; ++col)
+    {
+        auto steps = currentTimestamp - timestamps[col];
+        timestamps[col] = 0;
+        if (steps == 0)
+            continue;
+        for (size_t s = 0; s < numStates; s++)
+        {
+            ElemType decay = (ElemType)std::pow((double)decays[s], (double)steps);
+            ElemType* state = Data() + (s * cols + col) * rows;
+            for (size_t row = 0; row < rows; ++row)
+            {
+                state[row] *= decay;
+                if (floors[s] > (ElemType)0 && state[row] < floors[s])
+                    state[row] = floors[s];
+            }
+        }
+    }
+}
+
+// number of state buffers of the smoothed gradient of each parameter, in the layout of the optimizer's own update function
+static size_t FusedLearnerNumStates(FusedLearnerKind kind)
+{
+    switch (kind)
+    {
+    case FusedLearnerKind::SGD:         return 0;
+    case FusedLearnerKind::MomentumSGD:
+    case FusedLearnerKind::Nesterov:
+    case FusedLearnerKind::AdaGrad:     return 1;
+    case FusedLearnerKind::Adam:        return 2;
+    case FusedLearnerKind::RmsProp:     return 3;
+    default: LogicError("FusedLearnerUpdate: Unknown learner kind.");
+    }
+}
+
+// The elements of all parameters are split into chunks of at most this size, each within one parameter, which are the units of work of the threads.
+static const size_t s_fusedLearnerChunkSize = 16384;
+
+// Updates elements [begin, end) of one parameter with 'n' elements, see FusedLearnerUpdate().
+// 'gradientScale' includes the clipping by norm of this parameter. For AdaGrad and RmsProp with needAveMultiplier, the update is split
+// in two passes: the first one ('averagePass') stores the normalized gradient and returns the sum of the multipliers, the second one
+// applies it to the parameter with 'learningRate' divided by their average.
+template <class ElemType>
+static double FusedLearnerUpdateChunk(const FusedLearnerStep& step, ElemType* param, ElemType* grad, ElemType* state, size_t n, size_t begin, size_t end,
+                                      ElemType gradientScale, ElemType learningRate, bool averagePass)
+{
+    const bool truncate = step.clippingWithTruncation && step.clippingThreshold != std::numeric_limits<double>::infinity();
+    const ElemType threshold = (ElemType)step.clippingThreshold;
+    const ElemType l2Weight = (ElemType)step.l2Weight;
+    const bool needAveMultiplier = step.needAveMultiplier && (step.kind == FusedLearnerKind::AdaGrad || step.kind == FusedLearnerKind::RmsProp);
+
+    // mean gradient and loss scaling, clipping and L2 regularization, from the value of the parameter before the update
+    auto Preprocessed = [&](size_t i) -> ElemType
+    {
+        ElemType g = grad[i] * gradientScale;
+        if (truncate)
+            g = std::max(std::min(g, threshold), -threshold);
+        return g + l2Weight * param[i];
+    };
+
+    double aveMultiplier = 0;
+    if (needAveMultiplier && !averagePass)
+    {
+        // second pass, the gradient is already normalized
+        for (size_t i = begin; i < end; i++)
+            param[i] -= learningRate * grad[i];
+    }
+    else
+    {
+        switch (step.kind)
+        {
+        case FusedLearnerKind::SGD:
+        {
+            for (size_t i = begin; i < end; i++)
+                param[i] -= learningRate * Preprocessed(i);
+            break;
+        }
+        case FusedLearnerKind::MomentumSGD:
+        case FusedLearnerKind::Nesterov:
+        {
+            const ElemType momentum = (ElemType)step.momentum;
+            const ElemType gain = (ElemType)step.unitGainFactor * learningRate;
+            const bool nesterov = step.kind == FusedLearnerKind::Nesterov;
+            ElemType* smoothed = state;
+            for (size_t i = begin; i < end; i++)
+            {
+                ElemType g = gain * Preprocessed(i);
+                ElemType sg = momentum * smoothed[i] + g;
+                smoothed[i] = sg;
+                if (nesterov)
+                    param[i] -= momentum * sg + g;
+                else
+                    param[i] -= sg;
+            }
+            break;
+        }
+        case FusedLearnerKind::AdaGrad:
+        {
+            const ElemType floor = (ElemType)1e-16f;
+            ElemType* accumulated = state;
+            for (size_t i = begin; i < end; i++)
+            {
+                ElemType g = Preprocessed(i);
+                ElemType a = accumulated[i] + g * g;
+                accumulated[i] = a;
+                ElemType multiplier = (ElemType)1 / sqrt(a + floor);
+                if (needAveMultiplier)
+                {
+                    grad[i] = g * multiplier;
+                    aveMultiplier += (double)multiplier;
+                }
+                else
+                    param[i] -= learningRate * g * multiplier;
+            }
+            break;
+        }
+        case FusedLearnerKind::RmsProp:
+        {
+            const ElemType floor = (ElemType)1e-6f;
+            const ElemType gamma = (ElemType)step.rmsGamma;
+            const ElemType inc = (ElemType)step.rmsInc, dec = (ElemType)step.rmsDec, maxStep = (ElemType)step.rmsMax, minStep = (ElemType)step.rmsMin;
+            ElemType* avars = state;
+            ElemType* signs = state + n;
+            ElemType* steps = state + 2 * n;
+            for (size_t i = begin; i < end; i++)
+            {
+                ElemType g = Preprocessed(i);
+                if (!step.initialized)
+                {
+                    avars[i] = g * g;
+                    signs[i] = 0;
+                    steps[i] = (ElemType)0.02;
+                }
+                ElemType avar = gamma * avars[i] + ((ElemType)1 - gamma) * (g * g);
+                avars[i] = avar;
+                const int gradSign = ((ElemType)0 < g) - (g < (ElemType)0);
+                ElemType stepSize = signs[i] * gradSign > 0 ? std::min(steps[i] * inc, maxStep) : std::max(steps[i] * dec, minStep);
+                steps[i] = stepSize;
+                signs[i] = (ElemType)gradSign;
+                ElemType multiplier = stepSize / sqrt(avar + floor);
+                if (needAveMultiplier)
+                {
+                    grad[i] = g * multiplier;
+                    aveMultiplier += (double)multiplier;
+                }
+                else
+                    param[i] -= learningRate * g * multiplier;
+            }
+            break;
+        }
+        case FusedLearnerKind::Adam:
+        {
+            const ElemType momentum = (ElemType)step.momentum;
+            const ElemType varMomentum = (ElemType)step.varianceMomentum;
+            const ElemType unitGainFactor = (ElemType)step.unitGainFactor;
+            const ElemType epsilon = (ElemType)step.epsilon;
+            const ElemType biasCorrection = (ElemType)step.biasCorrection;
+            ElemType* smoothAda = state;
+            ElemType* smoothMom = state + n;
+            for (size_t i = begin; i < end; i++)
+            {
+                ElemType g = Preprocessed(i);
+                ElemType ada;
+                if (!step.adamax)
+                {
+                    ElemType adaSqr = varMomentum * smoothAda[i] + ((ElemType)1 - varMomentum) * g * g;
+                    smoothAda[i] = adaSqr;
+                    ada = sqrt(adaSqr);
+                }
+                else
+                    ada = smoothAda[i] = std::max(varMomentum * smoothAda[i], fabs_(g));
+                ElemType w = biasCorrection / (ada + epsilon);
+                ElemType mom = momentum * smoothMom[i] + unitGainFactor * g;
+                smoothMom[i] = mom;
+                param[i] -= mom * w * learningRate;
+            }
+            break;
+        }
+        default:
+            LogicError("FusedLearnerUpdate: Unknown learner kind.");
+        }
+        if (needAveMultiplier)
+            return aveMultiplier;
+    }
+
+    // L1 regularizer with proximal gradient descent method
+    if (step.l1Threshold > 0)
+    {
+        const ElemType l1Threshold = (ElemType)step.l1Threshold;
+        for (size_t i = begin; i < end; i++)
+        {
+            ElemType p = param[i];
+            param[i] = p > l1Threshold ? p - l1Threshold : (p < -l1Threshold ? p + l1Threshold : (ElemType)0);
+        }
+    }
+    return aveMultiplier;
+}
+
+// Updates all parameters of a learner in one parallel pass over chunks of all of them, instead of a pass per parameter and per operation
+// in the learner (scaling, clipping, regularization, the update itself). The loops over contiguous elements are meant to be vectorized.
+// Two additional passes may be needed: one before, over the gradients, to clip them by norm, and one after, over the parameters,
+// for AdaGrad and RmsProp with needAveMultiplier, whose update depends on the average of all the multipliers of a parameter.
+template <class ElemType>
+/*static*/ void CPUMatrix<ElemType>::FusedLearnerUpdate(const FusedLearnerStep& step, const vector<CPUMatrix<ElemType>*>& parameters,
+                                                       const vector<CPUMatrix<ElemType>*>& gradients, const vector<CPUMatrix<ElemType>*>& smoothedGradients)
+{
+    const size_t numParameters = parameters.size();
+    if (gradients.size() != numParameters || smoothedGradients.size() != numParameters)
+        LogicError("FusedLearnerUpdate: There must be one gradient and one smoothed gradient per parameter.");
+
+    const size_t numStates = FusedLearnerNumStates(step.kind);
+    for (size_t k = 0; k < numParameters; k++)
+    {
+        const auto& gradient = *gradients[k];
+        if (parameters[k]->GetNumRows() != gradient.GetNumRows() || parameters[k]->GetNumCols() != gradient.GetNumCols())
+            LogicError("FusedLearnerUpdate: The gradient must have the same dimensions as the parameter.");
+        if (numStates == 0)
+            continue;
+        auto& smoothedGradient = *smoothedGradients[k];
+        if (smoothedGradient.IsEmpty() || smoothedGradient.GetNumCols() < numStates * gradient.GetNumCols())
+        {
+            smoothedGradient.RequireSize(gradient.GetNumRows(), numStates * gradient.GetNumCols());
+            smoothedGradient.SetValue(0.0);
+        }
+        if (smoothedGradient.GetNumRows() != gradient.GetNumRows() || smoothedGradient.GetNumCols() != numStates * gradient.GetNumCols())
+            LogicError("FusedLearnerUpdate: The smoothed gradient does not have expected dimensions.");
+    }
+
+    struct Chunk
+    {
+        size_t parameter;
+        size_t begin;
+        size_t end;
+    };
+    vector<Chunk> chunks;
+    for (size_t k = 0; k < numParameters; k++)
+    {
+        const size_t n = parameters[k]->GetNumElements();
+        for (size_t begin = 0; begin < n; begin += s_fusedLearnerChunkSize)
+            chunks.push_back({ k, begin, std::min(begin + s_fusedLearnerChunkSize, n) });
+    }
+    const long numChunks = (long)chunks.size();
+
+    // sums of the chunks of each parameter
+    vector<double> chunkSums(chunks.size());
+    auto SumPerParameter = [&]()
+    {
+        vector<double> sums(numParameters, 0);
+        for (size_t c = 0; c < chunks.size(); c++)
+            sums[chunks[c].parameter] += chunkSums[c];
+        return sums;
+    };
+
+    vector<ElemType> gradientScales(numParameters, (ElemType)step.gradientScale);
+    if (!step.clippingWithTruncation && step.clippingThreshold != std::numeric_limits<double>::infinity())
+    {
+#pragma omp parallel for
+        for (long c = 0; c < numChunks; c++)
+        {
+            const ElemType* grad = gradients[chunks[c].parameter]->Data();
+            double sum = 0;
+            for (size_t i = chunks[c].begin; i < chunks[c].end; i++)
+                sum += (double)grad[i] * (double)grad[i];
+            chunkSums[c] = sum;
+        }
+        auto sumsOfSquares = SumPerParameter();
+        for (size_t k = 0; k < numParameters; k++)
+        {
+            double norm = step.gradientScale * sqrt(sumsOfSquares[k]);
+            if (norm > step.clippingThreshold)
+                gradientScales[k] = (ElemType)(step.gradientScale * step.clippingThreshold / norm);
+        }
+    }
+
+    const bool needAveMultiplier = step.needAveMultiplier && (step.kind == FusedLearnerKind::AdaGrad || step.kind == FusedLearnerKind::RmsProp);
+#pragma omp parallel for
+    for (long c = 0; c < numChunks; c++)
+    {
+        const auto& chunk = chunks[c];
+        const size_t k = chunk.parameter;
+        chunkSums[c] = FusedLearnerUpdateChunk<ElemType>(step, parameters[k]->Data(), gradients[k]->Data(), numStates > 0 ? smoothedGradients[k]->Data() : nullptr,
+                                                         parameters[k]->GetNumElements(), chunk.begin, chunk.end, gradientScales[k], (ElemType)step.learningRate, needAveMultiplier);
+    }
+
+    if (needAveMultiplier)
+    {
+        auto aveMultipliers = SumPerParameter();
+        for (size_t k = 0; k < numParameters; k++)
+            aveMultipliers[k] /= parameters[k]->GetNumElements();
+#pragma omp parallel for
+        for (long c = 0; c < numChunks; c++)
+        {
+            const auto& chunk = chunks[c];
+            const size_t k = chunk.parameter;
+            FusedLearnerUpdateChunk<ElemType>(step, parameters[k]->Data(), gradients[k]->Data(), smoothedGradients[k]->Data(), parameters[k]->GetNumElements(),
+                                              chunk.begin, chunk.end, gradientScales[k], (ElemType)(step.learningRate / aveMultipliers[k]), false);
+        }
+    }
+}
+
 template <class ElemType>
 void CPUMatrix<ElemType>::Reshape(const size_t numRows, const size_t numCols)
 {
@@ -1539,9 +1855,24 @@ void CPUMatrix<ElemType>::Resize(const size_t numRows, const size_t numCols, boo
     if (GetNumRows() == numRows && GetNumCols() == numCols)
         return;
 
+    size_t numElements = numRows * numCols;
+
+    // A slot of a memory arena is reshaped in place while it is large enough, otherwise the matrix leaves it.
+    if (HasExternalBuffer() && MayOutgrowExternalBuffer() && m_sob.unique())
+    {
+        if (numElements <= GetSizeAllocated())
+        {
+            m_sliceViewOffset = 0;
+            m_numRows         = numRows;
+            m_numCols         = numCols;
+            return;
+        }
+        SetBuffer(nullptr, 0); // not ours to free
+        SetSizeAllocated(0);
+    }
+
     VerifyResizable(__func__);
 
-    size_t numElements = numRows * numCols;
     if (numElements > GetSizeAllocated() ||                 // grow allocation
         (!growOnly && (numElements != GetSizeAllocated()))) // shrink allocation (not if 'growOnly')
     {
@@ -3263,6 +3594,25 @@ ElemType CPUMatrix<ElemType>::SumOfElements() const
     return sum;
 }
 
+// NaN and Inf are the values with all exponent bits set. The bits are tested instead of calling std::isfinite(),
+// which is not reliable under fast floating-point models and would convert every half to float.
+template <class ElemType>
+bool CPUMatrix<ElemType>::HasNanOrInf() const
+{
+    typedef typename std::conditional<sizeof(ElemType) == 8, uint64_t,
+            typename std::conditional<sizeof(ElemType) == 4, uint32_t, uint16_t>::type>::type BitsType;
+    const BitsType exponentMask = (BitsType)(sizeof(ElemType) == 8 ? 0x7ff0000000000000ull : sizeof(ElemType) == 4 ? 0x7f800000ull : 0x7c00ull);
+
+    const BitsType* bits = reinterpret_cast<const BitsType*>(Data());
+    long m = (long) GetNumElements();
+    int found = 0;
+#pragma omp parallel for reduction(| : found)
+    for (long i = 0; i < m; i++)
+        found |= (bits[i] & exponentMask) == exponentMask;
+
+    return found != 0;
+}
+
 template <class ElemType>
 CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignSumOfElements(const CPUMatrix<ElemType>& a)
 {
@@ -5131,6 +5481,30 @@ void CPUMatrix<ElemType>::BatchNormalizationBackward(const CPUMatrix<ElemType>&
     RuntimeError("Batch normalization training on CPU is not yet implemented.");
 }
 
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNForward(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& paramW, size_t xDim, size_t yDim, const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        m_rnnExecutor = std::make_shared<CPURNNExecutor<ElemType>>(xDim, yDim, rnnAttributes);
+    m_rnnExecutor->ForwardCore(paramW, inputX, *this, numSequencesForFrame, rnnAttributes, reserve, workspace);
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardData(const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& paramW, CPUMatrix<ElemType>& outputDX, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        LogicError("RNNBackwardData called, but RNN executor object is not yet initialized");
+    m_rnnExecutor->BackwardDataCore(*this, outputDY, paramW, outputDX, rnnAttributes, reserve, workspace);
+}
+
+template <class ElemType>
+void CPUMatrix<ElemType>::RNNBackwardWeights(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    if (!m_rnnExecutor)
+        LogicError("RNNBackwardWeights called, but RNN executor object is not yet initialized");
+    m_rnnExecutor->BackwardWeightsCore(inputX, outputY, dw, rnnAttributes, reserve, workspace);
+}
+
 
 #pragma region Static BLAS Functions
 
@@ -5213,11 +5587,7 @@ void CPUMatrix<ElemType>::MultiplyAndWeightedAdd(ElemType alpha, const CPUMatrix
     }
     else
     {
-        // TODO: support transpose product
-        if (mklTransA == CBLAS_TRANSPOSE::CblasTrans || mklTransB == CBLAS_TRANSPOSE::CblasTrans)
-            LogicError("Quantized multiplier currently doesn't support transpose.");
-
-        pQuantizedMultiplier->Multiply(m, n, k, a.Data(), b.Data(), c.Data());
+        pQuantizedMultiplier->MultiplyAndWeightedAdd(m, n, k, alpha, a.Data(), transposeA, b.Data(), transposeB, beta, c.Data());
     }
 }
 
@@ -6805,6 +7175,320 @@ void _assignCTCScore(
     }
 }
 
+// The functions below compute the same as _assignAlphaScore, _assignBetaScore, _assignTotalScore and _assignCTCScore,
+// but run the alpha and the beta recursion of every utterance as independent tasks, instead of synchronizing all
+// threads for every frame of every utterance. Within a frame, the label states of an utterance are contiguous in
+// alpha and beta, so the recursion over them is vectorized. Used if CPUMatrix::OPT_PARALLEL_CTC is set.
+
+// log(exp(LZERO) + exp(a0) + exp(a1) + exp(a2)), i.e. the result of LogAdd(LogAdd(LogAdd(LZERO, a2), a1), a0) in the recursions above
+template <class ElemType>
+static inline ElemType _ctcLogSumExp(ElemType a0, ElemType a1, ElemType a2)
+{
+    const ElemType lzero = (ElemType) LZERO;
+    ElemType m = a0 > lzero ? a0 : lzero;
+    m = a1 > m ? a1 : m;
+    m = a2 > m ? a2 : m;
+    return m + log_(exp_(lzero - m) + exp_(a0 - m) + exp_(a1 - m) + exp_(a2 - m));
+}
+
+// One frame of the recursion, over the label states [begin, end) of an utterance:
+//   cur[s] = log(exp(LZERO) + exp(p0[s]) + exp(p1[s]) + (skip[s] ? exp(p2[s]) : 0)) + emit[s]
+// where p0, p1 and p2 point to the states s, s-1 and s-2 (for alpha) or s, s+1 and s+2 (for beta) of the previous frame.
+template <class ElemType>
+static void _ctcRecursionStep(ElemType* cur, const ElemType* p0, const ElemType* p1, const ElemType* p2, const ElemType* skip, const ElemType* emit, size_t begin, size_t end)
+{
+    for (size_t s = begin; s < end; s++)
+        cur[s] = _ctcLogSumExp(p0[s], p1[s], skip[s] != (ElemType) 0 ? p2[s] : (ElemType) LZERO) + emit[s];
+}
+
+// exp(x) for x < LZERO is 0, as in _assignCTCScore
+template <class ElemType>
+static void _ctcExpOccupancies(ElemType* occupancies, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        occupancies[i] = occupancies[i] < LZERO ? (ElemType) 0 : (ElemType) exp_(occupancies[i]);
+}
+
+#ifdef __AVX2__
+// a * b + c and c - a * b (without requiring FMA)
+static inline __m256 _ctcMulAdd(__m256 a, __m256 b, __m256 c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+static inline __m256 _ctcNegMulAdd(__m256 a, __m256 b, __m256 c) { return _mm256_sub_ps(c, _mm256_mul_ps(a, b)); }
+
+// exp and log of 8 floats, with the polynomials of the Cephes library. _ctcExp() is 0 below -87.3 instead of a denormal.
+static inline __m256 _ctcExp(__m256 x)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 underflow = _mm256_cmp_ps(x, _mm256_set1_ps(-87.3f), _CMP_LT_OQ);
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.3f));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.3f));
+
+    // exp(x) = 2^n * exp(r), n = round(x / log(2)), r = x - n * log(2)
+    __m256 n = _mm256_floor_ps(_ctcMulAdd(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+    x = _ctcNegMulAdd(n, _mm256_set1_ps(0.693359375f), x);
+    x = _ctcNegMulAdd(n, _mm256_set1_ps(-2.12194440e-4f), x);
+
+    __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+    y = _ctcMulAdd(y, x, _mm256_set1_ps(1.3981999507E-3f));
+    y = _ctcMulAdd(y, x, _mm256_set1_ps(8.3334519073E-3f));
+    y = _ctcMulAdd(y, x, _mm256_set1_ps(4.1665795894E-2f));
+    y = _ctcMulAdd(y, x, _mm256_set1_ps(1.6666665459E-1f));
+    y = _ctcMulAdd(y, x, _mm256_set1_ps(5.0000001201E-1f));
+    y = _ctcMulAdd(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, one));
+
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(0x7f)), 23);
+    y = _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+    return _mm256_andnot_ps(underflow, y);
+}
+
+// for x > 0
+static inline __m256 _ctcLog(__m256 x)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    // x = m * 2^e with m in [0.5, 1)
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0x7e)));
+    __m256 m = _mm256_or_ps(_mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))), _mm256_set1_ps(0.5f));
+
+    // m in [sqrt(0.5), sqrt(2)), log(x) = log(m) + e * log(2)
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, small));
+    m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(m, small));
+
+    __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(-1.1514610310E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(1.1676998740E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(-1.2420140846E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(1.4249322787E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(-1.6668057665E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(2.0000714765E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(-2.4999993993E-1f));
+    y = _ctcMulAdd(y, m, _mm256_set1_ps(3.3333331174E-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+    y = _ctcMulAdd(e, _mm256_set1_ps(-2.12194440e-4f), y);
+    y = _ctcNegMulAdd(z, _mm256_set1_ps(0.5f), y);
+    return _ctcMulAdd(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(m, y));
+}
+
+template <>
+void _ctcRecursionStep<float>(float* cur, const float* p0, const float* p1, const float* p2, const float* skip, const float* emit, size_t begin, size_t end)
+{
+    const __m256 lzero = _mm256_set1_ps((float) LZERO);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t s = begin;
+    for (; s + 8 <= end; s += 8)
+    {
+        __m256 a0 = _mm256_loadu_ps(p0 + s);
+        __m256 a1 = _mm256_loadu_ps(p1 + s);
+        __m256 a2 = _mm256_blendv_ps(lzero, _mm256_loadu_ps(p2 + s), _mm256_cmp_ps(_mm256_loadu_ps(skip + s), zero, _CMP_NEQ_UQ));
+        __m256 m = _mm256_max_ps(_mm256_max_ps(a0, lzero), _mm256_max_ps(a1, a2));
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(_ctcExp(_mm256_sub_ps(lzero, m)), _ctcExp(_mm256_sub_ps(a0, m))),
+                                   _mm256_add_ps(_ctcExp(_mm256_sub_ps(a1, m)), _ctcExp(_mm256_sub_ps(a2, m))));
+        _mm256_storeu_ps(cur + s, _mm256_add_ps(_mm256_add_ps(m, _ctcLog(sum)), _mm256_loadu_ps(emit + s)));
+    }
+    for (; s < end; s++)
+        cur[s] = _ctcLogSumExp(p0[s], p1[s], skip[s] != 0 ? p2[s] : (float) LZERO) + emit[s];
+}
+
+template <>
+void _ctcExpOccupancies<float>(float* occupancies, size_t n)
+{
+    const __m256 lzero = _mm256_set1_ps((float) LZERO);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(occupancies + i);
+        _mm256_storeu_ps(occupancies + i, _mm256_andnot_ps(_mm256_cmp_ps(x, lzero, _CMP_LT_OQ), _ctcExp(x)));
+    }
+    for (; i < n; i++)
+        occupancies[i] = occupancies[i] < LZERO ? 0.0f : exp(occupancies[i]);
+}
+#endif
+
+// The label states of an utterance, see _assignAlphaScore for the parameters.
+template <class ElemType>
+struct _CTCUtterance
+{
+    size_t phoneNum;
+    std::vector<size_t> labels;         // phone id of every state, SIZE_MAX if none
+    std::vector<ElemType> alphaSkip;    // 1 if alpha can skip from the state s-2 to the state s
+    std::vector<ElemType> betaSkip;     // 1 if beta can skip from the state s+2 to the state s
+    std::vector<size_t> lastFrame;      // the last frame the state may be in under the delay constraint
+
+    _CTCUtterance(const ElemType* phoneSeq, const ElemType* phoneBound, size_t uttId, size_t phoneNum, size_t maxPhoneNum, size_t blankTokenId, int delayConstraint)
+        : phoneNum(phoneNum), labels(phoneNum, SIZE_MAX), alphaSkip(phoneNum, (ElemType) 0), betaSkip(phoneNum, (ElemType) 0), lastFrame(delayConstraint != -1 ? phoneNum : 0)
+    {
+        // the first and the last state are not used by the recursions
+        const ElemType* seq = phoneSeq + uttId * maxPhoneNum;
+        for (size_t s = 1; s + 1 < phoneNum; s++)
+            labels[s] = (size_t)(LONG64) seq[s];
+        for (size_t s = 1; s + 1 < phoneNum; s++)
+        {
+            if (s > 2 && labels[s] != blankTokenId && labels[s] != labels[s - 2])
+                alphaSkip[s] = (ElemType) 1;
+            if (s + 3 < phoneNum && labels[s] != blankTokenId && labels[s] != labels[s + 2])
+                betaSkip[s] = (ElemType) 1;
+            if (delayConstraint != -1)
+            {
+                size_t phoneBoundId_r = (size_t)(phoneBound[uttId * maxPhoneNum + s + 2]);
+                lastFrame[s] = labels[s] == blankTokenId ? phoneBoundId_r + delayConstraint - 1 : phoneBoundId_r + delayConstraint;
+            }
+        }
+    }
+
+    // log probabilities of the states at a frame
+    void GatherEmissions(const ElemType* probCol, std::vector<ElemType>& emit) const
+    {
+        for (size_t s = 1; s + 1 < phoneNum; s++)
+            emit[s] = labels[s] != SIZE_MAX ? probCol[labels[s]] : (ElemType) 0;
+    }
+
+    void ApplyDelayConstraint(ElemType* scoreCol, size_t t) const
+    {
+        if (lastFrame.empty())
+            return;
+        for (size_t s = 1; s + 1 < phoneNum; s++)
+        {
+            if (t > lastFrame[s])
+                scoreCol[s] = (ElemType) LZERO;
+        }
+    }
+};
+
+// Alpha recursion of one utterance over all its frames
+template <class ElemType>
+static void _assignAlphaScoreOfUtterance(const ElemType* prob, ElemType* alphaScore, const _CTCUtterance<ElemType>& utt, size_t frameNum,
+    size_t beginFrame, size_t chan, size_t numChannels, size_t maxPhoneNum, size_t totalPhoneNum)
+{
+    const size_t phoneNum = utt.phoneNum;
+    if (phoneNum < 3)
+        return;
+    std::vector<ElemType> emit(phoneNum);
+    for (size_t t = 0; t < frameNum; t++)
+    {
+        size_t timeId = (t + beginFrame) * numChannels + chan;
+        const ElemType* probCol = prob + timeId * totalPhoneNum;
+        ElemType* cur = alphaScore + maxPhoneNum * timeId;
+        if (t == 0)
+        {
+            for (size_t s = 1; s <= 2 && s + 1 < phoneNum; s++)
+                cur[s] = probCol[utt.labels[s]];
+            continue;
+        }
+
+        const ElemType* prev = cur - maxPhoneNum * numChannels;
+        utt.GatherEmissions(probCol, emit);
+        cur[1] = _ctcLogSumExp(prev[1], (ElemType) LZERO, (ElemType) LZERO) + emit[1];
+        _ctcRecursionStep(cur, prev, prev - 1, prev - 2, utt.alphaSkip.data(), emit.data(), 2, phoneNum - 1);
+        utt.ApplyDelayConstraint(cur, t);
+    }
+}
+
+// Beta recursion of one utterance over all its frames, followed by its total score
+template <class ElemType>
+static ElemType _assignBetaScoreOfUtterance(const ElemType* prob, ElemType* betaScore, const _CTCUtterance<ElemType>& utt, size_t frameNum,
+    size_t beginFrame, size_t chan, size_t numChannels, size_t maxPhoneNum, size_t totalPhoneNum)
+{
+    const size_t phoneNum = utt.phoneNum;
+    ElemType* beginCol = betaScore + maxPhoneNum * (beginFrame * numChannels + chan);
+    if (phoneNum >= 3)
+    {
+        std::vector<ElemType> emit(phoneNum);
+        for (size_t t = frameNum; t-- > 0;)
+        {
+            size_t timeId = (t + beginFrame) * numChannels + chan;
+            const ElemType* probCol = prob + timeId * totalPhoneNum;
+            ElemType* cur = betaScore + maxPhoneNum * timeId;
+            if (t == frameNum - 1)
+            {
+                for (size_t s = std::max((size_t) 1, phoneNum - 3); s + 1 < phoneNum; s++)
+                    cur[s] = probCol[utt.labels[s]];
+                continue;
+            }
+
+            const ElemType* next = cur + maxPhoneNum * numChannels;
+            utt.GatherEmissions(probCol, emit);
+            _ctcRecursionStep(cur, next, next + 1, next + 2, utt.betaSkip.data(), emit.data(), 1, phoneNum - 2);
+            cur[phoneNum - 2] = _ctcLogSumExp(next[phoneNum - 2], (ElemType) LZERO, (ElemType) LZERO) + emit[phoneNum - 2];
+            utt.ApplyDelayConstraint(cur, t);
+        }
+    }
+
+    beginCol[0] = LogAdd(beginCol[1], beginCol[2]);
+    return beginCol[0];
+}
+
+template <class ElemType>
+static void _assignCTCScoreParallel(
+    ElemType* CTCscore,
+    const ElemType* prob,
+    ElemType* alphaScore,
+    ElemType* betaScore,
+    const ElemType* phoneSeq,
+    const ElemType* phoneBound,
+    std::vector<ElemType>& totalScore,
+    const std::vector<size_t>& uttToChanInd,
+    const std::vector<size_t>& uttBeginFrame,
+    const std::vector<size_t>& uttFrameNum,
+    const std::vector<size_t>& uttPhoneNum,
+    const size_t numChannels,
+    const size_t maxPhoneNum,
+    const size_t totalPhoneNum,
+    const size_t blankTokenId,
+    const int delayConstraint)
+{
+    const size_t uttNum = uttFrameNum.size();
+
+    std::vector<_CTCUtterance<ElemType>> utts;
+    utts.reserve(uttNum);
+    for (size_t uttId = 0; uttId < uttNum; uttId++)
+        utts.emplace_back(phoneSeq, phoneBound, uttId, uttPhoneNum[uttId], maxPhoneNum, blankTokenId, delayConstraint);
+
+    // alpha and beta recursions, the longest utterances first
+    std::vector<size_t> order(uttNum);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return uttFrameNum[a] * uttPhoneNum[a] > uttFrameNum[b] * uttPhoneNum[b]; });
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int task = 0; task < (int) (2 * uttNum); task++)
+    {
+        size_t uttId = order[task / 2];
+        if (task % 2 == 0)
+            _assignAlphaScoreOfUtterance(prob, alphaScore, utts[uttId], uttFrameNum[uttId], uttBeginFrame[uttId], uttToChanInd[uttId], numChannels, maxPhoneNum, totalPhoneNum);
+        else
+            totalScore[uttId] = _assignBetaScoreOfUtterance(prob, betaScore, utts[uttId], uttFrameNum[uttId], uttBeginFrame[uttId], uttToChanInd[uttId], numChannels, maxPhoneNum, totalPhoneNum);
+    }
+
+    // derivative, over the frames of all utterances
+    std::vector<size_t> firstFrame(uttNum + 1, 0);
+    for (size_t uttId = 0; uttId < uttNum; uttId++)
+        firstFrame[uttId + 1] = firstFrame[uttId] + uttFrameNum[uttId];
+#pragma omp parallel for
+    for (int frame = 0; frame < (int) firstFrame[uttNum]; frame++)
+    {
+        size_t uttId = std::upper_bound(firstFrame.begin(), firstFrame.end(), (size_t) frame) - firstFrame.begin() - 1;
+        size_t t = frame - firstFrame[uttId];
+        const auto& utt = utts[uttId];
+        ElemType P_lx = totalScore[uttId];
+        size_t timeId = (t + uttBeginFrame[uttId]) * numChannels + uttToChanInd[uttId];
+        ElemType* CTCscoreCol = CTCscore + timeId * totalPhoneNum;
+        const ElemType* probCol = prob + timeId * totalPhoneNum;
+        const ElemType* alphaCol = alphaScore + maxPhoneNum * timeId;
+        const ElemType* betaCol = betaScore + maxPhoneNum * timeId;
+
+        for (size_t s = 1; s + 1 < utt.phoneNum; s++)
+        {
+            size_t phoneId = utt.labels[s];
+            if (phoneId != SIZE_MAX)
+            {
+                ElemType logoccu = alphaCol[s] + betaCol[s] - probCol[phoneId] - P_lx;
+                CTCscoreCol[phoneId] = LogAdd(CTCscoreCol[phoneId], logoccu);
+            }
+        }
+        _ctcExpOccupancies(CTCscoreCol, totalPhoneNum);
+    }
+}
+
 template<class ElemType>
 CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignCTCScore(
     const CPUMatrix<ElemType>& prob, CPUMatrix<ElemType>& alpha, CPUMatrix<ElemType>& beta,
@@ -6821,23 +7505,31 @@ CPUMatrix<ElemType>& CPUMatrix<ElemType>::AssignCTCScore(
         // Max number of phones in utterances in this minibatch
         size_t maxPhoneNum = phoneSeq.GetNumRows();
 
-        for (size_t t = 0; t < maxFrameNum; t++)
+        std::vector<ElemType> scores(uttNum);
+        if (!!(GetOptimizationFlags() & OPT_PARALLEL_CTC))
         {
-            _assignAlphaScore(prob.Data(), alpha.Data(), phoneSeq.Data(), phoneBoundary.Data(), uttToChanInd,
-                uttFrameNum, uttBeginFrame, uttPhoneNum, numParallelSequences, uttNum, t, maxPhoneNum, totalPhoneNum, blankTokenId, delayConstraint);
+            _assignCTCScoreParallel(Data(), prob.Data(), alpha.Data(), beta.Data(), phoneSeq.Data(), phoneBoundary.Data(), scores, uttToChanInd,
+                uttBeginFrame, uttFrameNum, uttPhoneNum, numParallelSequences, maxPhoneNum, totalPhoneNum, blankTokenId, delayConstraint);
         }
-
-        for (LONG64 t = maxFrameNum - 1; t >= 0; t--)
+        else
         {
-            _assignBetaScore(prob.Data(), beta.Data(), phoneSeq.Data(), phoneBoundary.Data(), uttToChanInd,
-                uttFrameNum, uttBeginFrame, uttPhoneNum, numParallelSequences, uttNum, t, maxPhoneNum, totalPhoneNum, blankTokenId, delayConstraint);
-        }
+            for (size_t t = 0; t < maxFrameNum; t++)
+            {
+                _assignAlphaScore(prob.Data(), alpha.Data(), phoneSeq.Data(), phoneBoundary.Data(), uttToChanInd,
+                    uttFrameNum, uttBeginFrame, uttPhoneNum, numParallelSequences, uttNum, t, maxPhoneNum, totalPhoneNum, blankTokenId, delayConstraint);
+            }
 
-        std::vector<ElemType> scores(uttNum);
-        _assignTotalScore(beta.Data(), scores, uttNum, uttToChanInd, uttBeginFrame, numParallelSequences, maxPhoneNum);
+            for (LONG64 t = maxFrameNum - 1; t >= 0; t--)
+            {
+                _assignBetaScore(prob.Data(), beta.Data(), phoneSeq.Data(), phoneBoundary.Data(), uttToChanInd,
+                    uttFrameNum, uttBeginFrame, uttPhoneNum, numParallelSequences, uttNum, t, maxPhoneNum, totalPhoneNum, blankTokenId, delayConstraint);
+            }
 
-        _assignCTCScore(Data(), prob.Data(), alpha.Data(), beta.Data(), phoneSeq.Data(), uttNum, uttToChanInd,
-            uttBeginFrame, uttPhoneNum, uttFrameNum, numParallelSequences, maxPhoneNum, totalPhoneNum);
+            _assignTotalScore(beta.Data(), scores, uttNum, uttToChanInd, uttBeginFrame, numParallelSequences, maxPhoneNum);
+
+            _assignCTCScore(Data(), prob.Data(), alpha.Data(), beta.Data(), phoneSeq.Data(), uttNum, uttToChanInd,
+                uttBeginFrame, uttPhoneNum, uttFrameNum, numParallelSequences, maxPhoneNum, totalPhoneNum);
+        }
 
         totalScore(0, 0) = 0.0;
         for (size_t utt = 0; utt < uttNum; utt++)
@@ -7167,6 +7859,15 @@ void CPUMatrix<ElemType>::TensorOp(ElemType beta, const CPUMatrix<ElemType>& a,
     CPUMatrixTensorOpImpl<ElemType>(beta, a, b, c, *this, alpha, op, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 }
 
+// compute a fused elementwise program in a single pass, see Matrix::FusedTensorOp()
+template <class ElemType>
+/*static*/ void CPUMatrix<ElemType>::FusedTensorOp(const FusedElementwiseProgram& program, const vector<const CPUMatrix<ElemType>*>& inputs, const CPUMatrix<ElemType>* outputGradient,
+                                                  const vector<CPUMatrix<ElemType>*>& results, const vector<ElemType>& betas, ElemType alpha,
+                                                  const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides)
+{
+    CPUMatrixFusedTensorOpImpl<ElemType>(program, inputs, outputGradient, results, betas, alpha, offsets, regularOpDims, regularStrides);
+}
+
 template <class ElemType>
 int CPUMatrix<ElemType>::Argmin() const
 {
@@ -27,4 +27,9 @@ void CPUMatrixTensorArgOpImpl(const CPUMatrix<double>& a, CPUMatrix<double>& o,
     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, 2>& regularStrides,
     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, 2>& reducingStrides);
 
+template
+void CPUMatrixFusedTensorOpImpl(const FusedElementwiseProgram& program, const vector<const CPUMatrix<double>*>& inputs, const CPUMatrix<double>* outputGradient,
+    const vector<CPUMatrix<double>*>& results, const vector<double>& betas, double alpha,
+    const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides);
+
 }}}
\ No newline at end of file
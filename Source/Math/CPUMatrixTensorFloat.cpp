@@ -27,4 +27,9 @@ void CPUMatrixTensorArgOpImpl(const CPUMatrix<float>& a, CPUMatrix<float>& o, El
     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, 2>& regularStrides,
     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, 2>& reducingStrides);
 
+template
+void CPUMatrixFusedTensorOpImpl(const FusedElementwiseProgram& program, const vector<const CPUMatrix<float>*>& inputs, const CPUMatrix<float>* outputGradient,
+    const vector<CPUMatrix<float>*>& results, const vector<float>& betas, float alpha,
+    const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides);
+
 }}}
\ No newline at end of file
@@ -27,4 +27,9 @@ void CPUMatrixTensorArgOpImpl(const CPUMatrix<half>& a, CPUMatrix<half>& o, Elem
     const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, 2>& regularStrides,
     const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, 2>& reducingStrides);
 
+template
+void CPUMatrixFusedTensorOpImpl(const FusedElementwiseProgram& program, const vector<const CPUMatrix<half>*>& inputs, const CPUMatrix<half>* outputGradient,
+    const vector<CPUMatrix<half>*>& results, const vector<half>& betas, half alpha,
+    const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides);
+
 }}}
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include "CPUMatrix.h"
 #include "TensorOps.h"
+#include <limits>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -287,6 +292,281 @@ struct TensorArgOpIteration<ElemType, N, -1>
     }
 };
 
+// -----------------------------------------------------------------------
+// parallel reductions
+// -----------------------------------------------------------------------
+
+// Reductions are parallelized in one of two ways:
+//  - If there are enough output elements, each thread computes a subset of the outputs. Each output
+//    is computed exactly as in the serial code, so results are bit-identical to the serial path.
+//  - Otherwise, the reduction range of each output is cut into blocks of a fixed size, the blocks are
+//    reduced in parallel, and the partial results are combined by pairwise summation.
+// Which one is used depends only on the tensor shapes, never on the number of threads, so that
+// results are deterministic across machines and thread settings.
+static const size_t ParallelReductionMinElements = 16384; // below this, OpenMP overhead dominates
+static const size_t ParallelReductionMinOutputs = 64;     // below this, split the reduction range instead
+static const size_t ParallelReductionBlockSize = 4096;    // number of input elements per block of a split reduction
+
+static inline size_t TensorOpNumElements(const SmallVector<size_t>& opDims)
+{
+    size_t numElements = 1;
+    for (size_t k = 0; k < opDims.size(); k++)
+        numElements *= opDims[k];
+    return numElements;
+}
+
+// compute the pointers for the output element with linear index 'index' (dimension 0 running fastest)
+template <class ElemType, size_t N>
+static inline array<ElemType*, N> TensorOpElementPointers(array<ElemType*, N> pointers, size_t index,
+                                                          const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides)
+{
+    for (size_t k = 0; k < regularOpDims.size(); k++)
+    {
+        ptrdiff_t coord = (ptrdiff_t)(index % regularOpDims[k]);
+        index /= regularOpDims[k];
+        for (size_t i = 0; i < N; i++) // N = a small constant, this will be unrolled
+            pointers[i] += coord * regularStrides[i][k];
+    }
+    return pointers;
+}
+
+// combine partial results as a balanced binary tree, in an order that only depends on their number
+template <typename ReductionOp>
+static inline double PairwiseReduction(std::vector<double>& partials, const ReductionOp& reductionOp)
+{
+    for (size_t stride = 1; stride < partials.size(); stride *= 2)
+        for (size_t i = 0; i + stride < partials.size(); i += 2 * stride)
+            partials[i] = reductionOp(partials[i], partials[i + stride]);
+    return partials[0];
+}
+
+// reduce one output element by cutting the outermost reduction index m into blocks that are reduced in parallel
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, int m>
+struct TensorOpBlockedReduction
+{
+    // number of iterations over index m that make up one block
+    static inline size_t BlockDim(const SmallVector<size_t>& reducingOpDims)
+    {
+        size_t innerElements = 1;
+        for (size_t i = 0; i < (size_t)m; i++)
+            innerElements *= reducingOpDims[i];
+        return max((size_t)1, ParallelReductionBlockSize / innerElements);
+    }
+
+    static inline size_t NumBlocks(const SmallVector<size_t>& reducingOpDims)
+    {
+        size_t blockDim = BlockDim(reducingOpDims);
+        return (reducingOpDims[(size_t)m] + blockDim - 1) / blockDim;
+    }
+
+    static inline ElemType Loop(const array<ElemType*, N>& pointers, const OPFN& opfn, const ReductionOp& reductionOp,
+                                const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+    {
+        size_t dim = reducingOpDims[(size_t)m];
+        size_t blockDim = BlockDim(reducingOpDims);
+        std::vector<double> partials(NumBlocks(reducingOpDims));
+#pragma omp parallel for
+        for (int b = 0; b < (int)partials.size(); b++)
+        {
+            size_t begin = b * blockDim;
+            SmallVector<size_t> blockOpDims(reducingOpDims);
+            blockOpDims[(size_t)m] = min(blockDim, dim - begin);
+            array<ElemType*, N> blockPointers = pointers;
+            for (size_t i = 0; i < N - 1; i++) // last pointer (result) is unused here
+                blockPointers[i] += (ptrdiff_t)begin * reducingStrides[i][(size_t)m];
+            partials[b] = TensorOpReduction<ElemType, OPFN, ReductionOp, N, m>::Loop(blockPointers, opfn, reductionOp, blockOpDims, reducingStrides);
+        }
+        return static_cast<ElemType>(PairwiseReduction(partials, reductionOp));
+    }
+};
+
+// loop over all output elements of a reduction with reduction index m and regular index k, in parallel if worth it
+template <class ElemType, typename OPFN, typename ReductionOp, size_t N, int m, int k>
+static void TensorOpWithReduction(ElemType beta, const array<ElemType*, N>& pointers, ElemType alpha, const OPFN& opfn, const ReductionOp& reductionOp,
+                                  const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                                  const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+{
+    if (!!(CPUMatrix<ElemType>::GetOptimizationFlags() & CPUMatrix<ElemType>::OPT_PARALLEL_REDUCTION))
+    {
+        size_t numOutputs = TensorOpNumElements(regularOpDims);
+        size_t reductionSize = TensorOpNumElements(reducingOpDims);
+        if (numOutputs * reductionSize >= ParallelReductionMinElements)
+        {
+            if (numOutputs >= ParallelReductionMinOutputs)
+            {
+#pragma omp parallel for
+                for (int j = 0; j < (int)numOutputs; j++)
+                    TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, m, -1 /*scalar*/>::Loop(beta, TensorOpElementPointers(pointers, j, regularOpDims, regularStrides), alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+                return;
+            }
+            else if (TensorOpBlockedReduction<ElemType, OPFN, ReductionOp, N, m>::NumBlocks(reducingOpDims) > 1)
+            {
+                for (size_t j = 0; j < numOutputs; j++)
+                {
+                    auto elementPointers = TensorOpElementPointers(pointers, j, regularOpDims, regularStrides);
+                    ElemType val = TensorOpBlockedReduction<ElemType, OPFN, ReductionOp, N, m>::Loop(elementPointers, opfn, reductionOp, reducingOpDims, reducingStrides);
+                    val *= alpha;
+                    auto* pout = elementPointers.back();
+                    if (beta != 0)
+                        val += beta * *pout;
+                    *pout = val;
+                }
+                return;
+            }
+        }
+    }
+    TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, m, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+}
+
+// Reduction of contiguous memory, used for the common case of summing up or taking the max/min over
+// the leading axis (e.g. the softmax normalizer). The aggregate is accumulated in 4 double lanes, which
+// are combined pairwise at the end. The AVX2 version and the portable version use the same lane
+// assignment and therefore give identical results.
+static inline double ContiguousReductionInit(ElementWiseOperator reductionOp)
+{
+    switch (reductionOp)
+    {
+    case ElementWiseOperator::opSum: return 0;
+    case ElementWiseOperator::opMax: return -std::numeric_limits<double>::infinity();
+    default:                         return std::numeric_limits<double>::infinity();
+    }
+}
+
+static inline double ContiguousReductionStep(double a, double b, ElementWiseOperator reductionOp)
+{
+    switch (reductionOp)
+    {
+    case ElementWiseOperator::opSum: return OpSum(a, b);
+    case ElementWiseOperator::opMax: return OpMax(a, b);
+    default:                         return OpMin(a, b);
+    }
+}
+
+// combine the lanes, then add the remaining elements [i, n)
+template <class ElemType>
+static inline double ContiguousReductionFinish(const double acc[4], const ElemType* p, size_t i, size_t n, ElementWiseOperator reductionOp)
+{
+    double aggregate = ContiguousReductionStep(ContiguousReductionStep(acc[0], acc[1], reductionOp), ContiguousReductionStep(acc[2], acc[3], reductionOp), reductionOp);
+    for (; i < n; i++)
+        aggregate = ContiguousReductionStep(aggregate, static_cast<double>(p[i]), reductionOp);
+    return aggregate;
+}
+
+template <class ElemType>
+static inline double ContiguousReductionKernel(const ElemType* p, size_t n, ElementWiseOperator reductionOp)
+{
+    const double init = ContiguousReductionInit(reductionOp);
+    double acc[4] = { init, init, init, init };
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (size_t j = 0; j < 4; j++)
+            acc[j] = ContiguousReductionStep(acc[j], static_cast<double>(p[i + j]), reductionOp);
+    return ContiguousReductionFinish(acc, p, i, n, reductionOp);
+}
+
+#ifdef __AVX2__
+static inline __m256d LoadAsDouble4(const float* p)  { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+static inline __m256d LoadAsDouble4(const double* p) { return _mm256_loadu_pd(p); }
+
+// note: _mm256_max_pd(a, b) and _mm256_min_pd(a, b) compute exactly OpMax(a, b) and OpMin(a, b), including NaN handling
+template <class ElemType>
+static inline double ContiguousReductionKernelAVX2(const ElemType* p, size_t n, ElementWiseOperator reductionOp)
+{
+    __m256d acc = _mm256_set1_pd(ContiguousReductionInit(reductionOp));
+    size_t i = 0;
+    switch (reductionOp)
+    {
+    case ElementWiseOperator::opSum:
+        for (; i + 4 <= n; i += 4)
+            acc = _mm256_add_pd(acc, LoadAsDouble4(p + i));
+        break;
+    case ElementWiseOperator::opMax:
+        for (; i + 4 <= n; i += 4)
+            acc = _mm256_max_pd(acc, LoadAsDouble4(p + i));
+        break;
+    default:
+        for (; i + 4 <= n; i += 4)
+            acc = _mm256_min_pd(acc, LoadAsDouble4(p + i));
+        break;
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return ContiguousReductionFinish(lanes, p, i, n, reductionOp);
+}
+
+template <>
+inline double ContiguousReductionKernel<float>(const float* p, size_t n, ElementWiseOperator reductionOp)
+{
+    return ContiguousReductionKernelAVX2(p, n, reductionOp);
+}
+
+template <>
+inline double ContiguousReductionKernel<double>(const double* p, size_t n, ElementWiseOperator reductionOp)
+{
+    return ContiguousReductionKernelAVX2(p, n, reductionOp);
+}
+#endif
+
+// sum/max/min over 'n' contiguous elements, in blocks of fixed size that are combined pairwise
+template <class ElemType>
+static inline double ContiguousReduction(const ElemType* p, size_t n, ElementWiseOperator reductionOp, bool parallel)
+{
+    size_t numBlocks = (n + ParallelReductionBlockSize - 1) / ParallelReductionBlockSize;
+    if (numBlocks <= 1)
+        return ContiguousReductionKernel(p, n, reductionOp);
+    std::vector<double> partials(numBlocks);
+#pragma omp parallel for if (parallel)
+    for (int b = 0; b < (int)numBlocks; b++)
+    {
+        size_t begin = b * ParallelReductionBlockSize;
+        partials[b] = ContiguousReductionKernel(p + begin, min(ParallelReductionBlockSize, n - begin), reductionOp);
+    }
+    return PairwiseReduction(partials, [reductionOp](double a, double b) { return ContiguousReductionStep(a, b, reductionOp); });
+}
+
+// unary sum/max/min reduction of a tensor over a single reduction axis that is contiguous in memory
+// Returns false if the operation does not have this form, or is too small to benefit.
+template <class ElemType>
+static bool TensorOpContiguousReduction(ElemType beta, const array<ElemType*, 2>& pointers, ElemType alpha, ElementWiseOperator reductionOp,
+                                        const SmallVector<size_t>& regularOpDims, const array<SmallVector<ptrdiff_t>, 2>& regularStrides,
+                                        const SmallVector<size_t>& reducingOpDims, const array<SmallVector<ptrdiff_t>, 2>& reducingStrides)
+{
+    if (reductionOp != ElementWiseOperator::opSum &&
+        reductionOp != ElementWiseOperator::opMax &&
+        reductionOp != ElementWiseOperator::opMin)
+        return false;
+    if (reducingOpDims.size() != 1 || reducingStrides[0][0] != 1)
+        return false;
+
+    size_t n = reducingOpDims[0];
+    size_t numOutputs = TensorOpNumElements(regularOpDims);
+    if (numOutputs * n < ParallelReductionMinElements)
+        return false;
+
+    auto reduceOne = [&](size_t j, bool parallel)
+    {
+        auto elementPointers = TensorOpElementPointers(pointers, j, regularOpDims, regularStrides);
+        ElemType val = static_cast<ElemType>(ContiguousReduction(elementPointers[0], n, reductionOp, parallel));
+        val *= alpha;
+        auto* pout = elementPointers[1];
+        if (beta != 0)
+            val += beta * *pout;
+        *pout = val;
+    };
+    if (numOutputs >= ParallelReductionMinOutputs)
+    {
+#pragma omp parallel for
+        for (int j = 0; j < (int)numOutputs; j++)
+            reduceOne(j, /*parallel=*/false);
+    }
+    else
+    {
+        for (size_t j = 0; j < numOutputs; j++)
+            reduceOne(j, /*parallel=*/true);
+    }
+    return true;
+}
+
 // -----------------------------------------------------------------------
 // map runtime parameters N to template parameters
 // -----------------------------------------------------------------------
@@ -301,9 +581,9 @@ static void TensorOpWithRegularLoop(ElemType beta, const array<ElemType*, N>& po
     switch (dims)
     {
     case 2:
-        return TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 1, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpWithReduction<ElemType, OPFN, ReductionOp, N, 1, k>(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 1:
-        return TensorOpIteration<ElemType, OPFN, ReductionOp, N, false /*vectorizable*/, 0, k>::Loop(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        return TensorOpWithReduction<ElemType, OPFN, ReductionOp, N, 0, k>(beta, pointers, alpha, opfn, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
     case 0:
     {
         // if all leading dimensions are 1, we can let the compiler do some unrolling
@@ -439,6 +719,13 @@ void CPUMatrixTensorOpImpl(ElemType beta, const CPUMatrix<ElemType>& a, CPUMatri
                               reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides)
 
     array<ElemType*, 2> pointers = {a.Data(), o.Data()};
+
+    // plain sum/max/min over a contiguous axis (e.g. ReduceSum(), ReduceMax()) has a vectorized implementation
+    if (op == ElementWiseOperator::opCopy &&
+        !!(CPUMatrix<ElemType>::GetOptimizationFlags() & CPUMatrix<ElemType>::OPT_PARALLEL_REDUCTION) &&
+        TensorOpContiguousReduction(beta, array<ElemType*, 2>{pointers[0] + offsets[0], pointers[1] + offsets[1]}, alpha, reductionOp, regularOpDims, regularStrides, reducingOpDims, reducingStrides))
+        return;
+
     switch (op)
     {
         ForAllUnaryOps(CaseUnaryTensorOp);
@@ -536,6 +823,17 @@ void CPUMatrixTensorArgOpImpl(const CPUMatrix<ElemType>& a, CPUMatrix<ElemType>&
         for (size_t i = 0; i < N; i++)
             pointers[i] += offsets[i];
 
+        // each output element is independent, so large arg reductions are distributed over threads by output element
+        size_t numOutputs = TensorOpNumElements(regularOpDims);
+        if (!!(CPUMatrix<ElemType>::GetOptimizationFlags() & CPUMatrix<ElemType>::OPT_PARALLEL_REDUCTION) &&
+            numOutputs > 1 && numOutputs * TensorOpNumElements(reducingOpDims) >= ParallelReductionMinElements)
+        {
+#pragma omp parallel for
+            for (int j = 0; j < (int)numOutputs; j++)
+                TensorArgOpIteration<ElemType, N, -1>::Loop(TensorOpElementPointers(pointers, j, regularOpDims, regularStrides), regularOpDims, regularStrides, reducingOpDims, reducingStrides, reductionOp);
+            return;
+        }
+
         switch (regularOpDims.size())
         {
             case 2:
@@ -553,4 +851,193 @@ void CPUMatrixTensorArgOpImpl(const CPUMatrix<ElemType>& a, CPUMatrix<ElemType>&
     }
 }
 
+// -----------------------------------------------------------------------
+// fused elementwise ops, see FusedElementwiseProgram
+// -----------------------------------------------------------------------
+
+static const size_t FusedTensorOpBlockSize = 256;               // elements along the first dimension that a thread computes all steps for
+static const size_t FusedTensorOpParallelMinElements = 16384;   // below this, OpenMP overhead dominates
+
+// apply 'op' to n elements; b is unused by unary ops
+// Called with n = 0, this only verifies the op code.
+template <class ElemType>
+static void FusedTensorOpBlock(ElementWiseOperator op, const ElemType* a, const ElemType* b, ElemType* r, size_t n)
+{
+#define CaseFusedUnaryTensorOp(oper)        \
+    case ElementWiseOperator::op##oper:     \
+        for (size_t j = 0; j < n; j++)      \
+            r[j] = Op##oper(a[j]);          \
+        return
+#define CaseFusedBinaryTensorOp(oper)       \
+    case ElementWiseOperator::op##oper:     \
+        for (size_t j = 0; j < n; j++)      \
+            r[j] = Op##oper(a[j], b[j]);    \
+        return
+
+    switch (op)
+    {
+        ForAllUnaryOps(CaseFusedUnaryTensorOp);
+        ForAllBinaryOps(CaseFusedBinaryTensorOp);
+    default:
+        LogicError("FusedTensorOp: Op code %d cannot be fused.", (int)op);
+    }
+}
+
+// compute all steps of 'program' and, with 'outputGradient', the gradients of all inputs, in a single pass over the tensors
+// The operation is split into blocks along the first dimension. For each block, all inputs and intermediate results are
+// kept in a per-thread buffer, so that memory is only touched for reading the inputs and writing the results.
+// Gradients recompute the intermediate results, and then propagate back through the steps in reverse order.
+template <class ElemType>
+void CPUMatrixFusedTensorOpImpl(const FusedElementwiseProgram& program, const vector<const CPUMatrix<ElemType>*>& inputs, const CPUMatrix<ElemType>* outputGradient,
+                                const vector<CPUMatrix<ElemType>*>& results, const vector<ElemType>& betas, ElemType alpha,
+                                const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides)
+{
+    const auto& steps = program.steps;
+    const size_t numInputs = program.numInputs;
+    const size_t numOperands = program.NumOperands();
+    const bool backprop = outputGradient != nullptr;
+    if (inputs.size() != numInputs || results.size() != (backprop ? numInputs : 1) || betas.size() != results.size() || steps.empty())
+        LogicError("FusedTensorOp: Inconsistent number of operands.");
+
+    // all operands, with offsets applied: inputs, output gradient (if any), results (null if not needed)
+    vector<ElemType*> pointers;
+    for (auto input : inputs)
+        pointers.push_back(input->Data());
+    if (backprop)
+        pointers.push_back(outputGradient->Data());
+    for (auto result : results)
+        pointers.push_back(result ? result->Data() : nullptr);
+    if (offsets.size() != pointers.size() || regularStrides.size() != pointers.size())
+        LogicError("FusedTensorOp: Inconsistent number of operands.");
+    for (size_t i = 0; i < pointers.size(); i++)
+        if (pointers[i])
+            pointers[i] += offsets[i];
+    const size_t firstResult = numInputs + (backprop ? 1 : 0);
+
+    // verify the program up front, since exceptions cannot leave the parallel region
+    vector<ElementWiseOperator> derivativeOps(2 * steps.size());
+    vector<FusedElementwiseDerivativeArg> derivativeArgs(2 * steps.size());
+    for (size_t s = 0; s < steps.size(); s++)
+    {
+        const auto& step = steps[s];
+        if (step.operands[0] < 0 || step.operands[0] >= (int)(numInputs + s) || step.operands[1] >= (int)(numInputs + s))
+            LogicError("FusedTensorOp: Step %d refers to an operand that is not computed yet.", (int)s);
+        FusedTensorOpBlock<ElemType>(step.op, nullptr, nullptr, nullptr, 0);
+        for (size_t k = 0; k < 2 && backprop && step.operands[k] >= 0; k++)
+            if (!FusedElementwiseDerivative(step.op, k, derivativeOps[2 * s + k], derivativeArgs[2 * s + k]))
+                LogicError("FusedTensorOp: Op code %d has no derivative.", (int)step.op);
+    }
+
+    // the first dimension is processed in blocks, all others (rows) are enumerated
+    const size_t rank = regularOpDims.size();
+    const size_t innerDim = rank > 0 ? regularOpDims[0] : 1;
+    const size_t numElements = TensorOpNumElements(regularOpDims);
+    if (numElements == 0)
+        return;
+    const size_t numRows = numElements / innerDim;
+    const size_t B = FusedTensorOpBlockSize;
+    const size_t blocksPerRow = (innerDim + B - 1) / B;
+    const ptrdiff_t numBlocks = (ptrdiff_t)(numRows * blocksPerRow);
+
+#pragma omp parallel if (numElements >= FusedTensorOpParallelMinElements && numBlocks > 1)
+    {
+        vector<ElemType> values(numOperands * B);                   // inputs and step results of the current block
+        vector<ElemType> gradients(backprop ? numOperands * B : 0); // gradients w.r.t. those
+        vector<ElemType> temp(backprop ? B : 0);
+        vector<bool> hasGradient(backprop ? numOperands : 0);
+        vector<ElemType*> blockPointers(pointers.size());
+        vector<ptrdiff_t> blockStrides(pointers.size());
+
+#pragma omp for schedule(static)
+        for (ptrdiff_t block = 0; block < numBlocks; block++)
+        {
+            const size_t row = block / blocksPerRow;
+            const size_t j0 = (block % blocksPerRow) * B;
+            const size_t n = min(B, innerDim - j0);
+            for (size_t i = 0; i < pointers.size(); i++)
+            {
+                if (!pointers[i])
+                    continue;
+                ptrdiff_t offset = 0;
+                for (size_t k = 1, index = row; k < rank; index /= regularOpDims[k], k++)
+                    offset += (ptrdiff_t)(index % regularOpDims[k]) * regularStrides[i][k];
+                blockStrides[i] = rank > 0 ? regularStrides[i][0] : 0;
+                blockPointers[i] = pointers[i] + offset + (ptrdiff_t)j0 * blockStrides[i];
+            }
+            auto Gather = [&](size_t i, ElemType* to)
+            {
+                const ElemType* from = blockPointers[i];
+                for (size_t j = 0; j < n; j++)
+                    to[j] = from[j * blockStrides[i]];
+            };
+            auto Scatter = [&](size_t i, const ElemType* from, ElemType beta, ElemType scale)
+            {
+                ElemType* to = blockPointers[i];
+                for (size_t j = 0; j < n; j++)
+                {
+                    ElemType& r = to[j * blockStrides[i]];
+                    r = beta == 0 ? (ElemType)(scale * from[j]) : (ElemType)(beta * r + scale * from[j]); // beta == 0: do not read the output
+                }
+            };
+
+            // forward: gather the inputs and compute all steps
+            for (size_t i = 0; i < numInputs; i++)
+                Gather(i, &values[i * B]);
+            for (size_t s = 0; s < steps.size(); s++)
+            {
+                const auto& step = steps[s];
+                FusedTensorOpBlock(step.op, &values[step.operands[0] * B], step.operands[1] >= 0 ? &values[step.operands[1] * B] : nullptr, &values[(numInputs + s) * B], n);
+            }
+            if (!backprop)
+            {
+                Scatter(firstResult, &values[(numOperands - 1) * B], betas[0], alpha);
+                continue;
+            }
+
+            // backward: propagate the output gradient through the steps in reverse order
+            // The first contribution to an operand's gradient is written, later ones are added.
+            fill(hasGradient.begin(), hasGradient.end(), false);
+            Gather(numInputs, &gradients[(numOperands - 1) * B]);
+            hasGradient[numOperands - 1] = true;
+            for (size_t s = steps.size(); s-- > 0;)
+            {
+                const auto& step = steps[s];
+                if (!hasGradient[numInputs + s]) // result not used
+                    continue;
+                const ElemType* gradient = &gradients[(numInputs + s) * B];
+                for (size_t k = 0; k < 2 && step.operands[k] >= 0; k++)
+                {
+                    const size_t operand = step.operands[k];
+                    const ElemType* arg = nullptr;
+                    switch (derivativeArgs[2 * s + k])
+                    {
+                    case FusedElementwiseDerivativeArg::output:       arg = &values[(numInputs + s) * B]; break;
+                    case FusedElementwiseDerivativeArg::operand:      arg = &values[operand * B]; break;
+                    case FusedElementwiseDerivativeArg::otherOperand: arg = &values[step.operands[1 - k] * B]; break;
+                    default: break;
+                    }
+                    ElemType* operandGradient = &gradients[operand * B];
+                    if (!hasGradient[operand])
+                        FusedTensorOpBlock(derivativeOps[2 * s + k], gradient, arg, operandGradient, n);
+                    else
+                    {
+                        FusedTensorOpBlock(derivativeOps[2 * s + k], gradient, arg, temp.data(), n);
+                        for (size_t j = 0; j < n; j++)
+                            operandGradient[j] += temp[j];
+                    }
+                    hasGradient[operand] = true;
+                }
+            }
+            for (size_t i = 0; i < numInputs; i++)
+            {
+                if (!pointers[firstResult + i])
+                    continue;
+                if (!hasGradient[i]) // input not used
+                    fill(&gradients[i * B], &gradients[i * B] + n, (ElemType)0);
+                Scatter(firstResult + i, &gradients[i * B], betas[i], 1);
+            }
+        }
+    }
+}
+
 }}}
\ No newline at end of file
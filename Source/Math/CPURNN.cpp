@@ -0,0 +1,510 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPURNN.cpp -- fused CPU implementation of the OptimizedRNNStack (LSTM/GRU/RNN) engine.
+//
+
+#include "stdafx.h"
+#include "CPURNN.h"
+#include "TensorOps.h"
+#include <algorithm>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// elementwise cell math is done in float for half, like the rest of the CPU half path
+template <class ElemType> struct RNNComputeType       { typedef ElemType type; };
+template <>               struct RNNComputeType<half> { typedef float    type; };
+
+// wrap a column-major buffer as a CPUMatrix, without taking ownership
+template <class ElemType>
+static CPUMatrix<ElemType> BufferView(const ElemType* p, size_t rows, size_t cols)
+{
+    return CPUMatrix<ElemType>(rows, cols, const_cast<ElemType*>(p), matrixFlagDontOwnBuffer);
+}
+
+// c = op(a) * op(b) + beta * c, on raw column-major buffers
+template <class ElemType>
+static void Gemm(ElemType beta, ElemType* c,
+                 const ElemType* a, size_t aRows, size_t aCols, bool transposeA,
+                 const ElemType* b, size_t bRows, size_t bCols, bool transposeB)
+{
+    size_t cRows = transposeA ? aCols : aRows;
+    size_t cCols = transposeB ? bRows : bCols;
+    if (cRows == 0 || cCols == 0)
+        return;
+    auto cView = BufferView(c, cRows, cCols);
+    CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, BufferView(a, aRows, aCols), transposeA, BufferView(b, bRows, bCols), transposeB, beta, cView);
+}
+
+template <class ElemType>
+CPURNNExecutor<ElemType>::CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes)
+    : m_xDim(xDim), m_yDim(yDim),
+      m_rnnAttributes(rnnAttributes),
+      m_numFrames(0), m_numColumns(0), m_maxSequences(0),
+      m_BackwardDataCalledYet(false)
+{
+    if      (m_rnnAttributes.m_recurrentOp == wstring(L"lstm"))    m_cellKind = CellKind::Lstm;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"gru"))     m_cellKind = CellKind::Gru;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnReLU")) m_cellKind = CellKind::RnnReLU;
+    else if (m_rnnAttributes.m_recurrentOp == wstring(L"rnnTanh")) m_cellKind = CellKind::RnnTanh;
+    else InvalidArgument("Unknown cell type '%ls'. Supported values are 'lstm', 'gru', 'rnnReLU', 'rnnTanh'.", m_rnnAttributes.m_recurrentOp.c_str());
+
+    if (m_yDim != NumDirections() * m_rnnAttributes.m_hiddenSize)
+        InvalidArgument("CPU RNN: Output leading dimension must be twice hidden size for bidirectional networks");
+
+    // same walk as RnnAttributes::GetNumParameters()
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    size_t offset = 0;
+    for (size_t layer = 0; layer < m_rnnAttributes.m_numLayers; layer++)
+    {
+        for (size_t dir = 0; dir < NumDirections(); dir++)
+        {
+            m_weightOffsets.push_back(offset);
+            offset += NumGates() * hiddenSize * (LayerInputDim(layer) + hiddenSize);
+        }
+    }
+    m_biasOffset = offset;
+    m_numParameters = m_biasOffset + m_rnnAttributes.m_numLayers * NumDirections() * 2 * NumGates() * hiddenSize;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::SetFrames(const vector<size_t>& numSequencesForFrame)
+{
+    m_numSequencesForFrame = numSequencesForFrame;
+    m_numFrames = numSequencesForFrame.size();
+    m_frameOffset.resize(m_numFrames);
+    m_numColumns = 0;
+    m_maxSequences = 0;
+    for (size_t t = 0; t < m_numFrames; t++)
+    {
+        if (t > 0 && numSequencesForFrame[t] > numSequencesForFrame[t - 1])
+            InvalidArgument("CPU RNN: sequences must be packed from longest to shortest.");
+        m_frameOffset[t] = m_numColumns;
+        m_numColumns += numSequencesForFrame[t];
+        m_maxSequences = max(m_maxSequences, numSequencesForFrame[t]);
+    }
+}
+
+template <class ElemType>
+size_t CPURNNExecutor<ElemType>::ReserveSizePerDirection() const
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t gatesSize = NumGates() * hiddenSize;
+    size_t size = hiddenSize + 2 * gatesSize; // h, gates, dGatesX
+    if (m_cellKind == CellKind::Lstm || m_cellKind == CellKind::Gru)
+        size += hiddenSize; // state
+    if (m_cellKind == CellKind::Gru)
+        size += gatesSize;  // dGatesH
+    return size * m_numColumns;
+}
+
+template <class ElemType>
+typename CPURNNExecutor<ElemType>::ReserveBlock CPURNNExecutor<ElemType>::GetReserveBlock(CPUMatrix<ElemType>& reserve, size_t layer, size_t dir) const
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t gatesSize = NumGates() * hiddenSize;
+    ElemType* p = reserve.Data() + (layer * NumDirections() + dir) * ReserveSizePerDirection();
+
+    ReserveBlock block;
+    block.h       = p; p += hiddenSize * m_numColumns;
+    block.gates   = p; p += gatesSize  * m_numColumns;
+    block.dGatesX = p; p += gatesSize  * m_numColumns;
+    block.state   = nullptr;
+    if (m_cellKind == CellKind::Lstm || m_cellKind == CellKind::Gru)
+    {
+        block.state = p; p += hiddenSize * m_numColumns;
+    }
+    block.dGatesH = block.dGatesX;
+    if (m_cellKind == CellKind::Gru)
+    {
+        block.dGatesH = p; p += gatesSize * m_numColumns;
+    }
+    return block;
+}
+
+// interleave the per-direction hidden outputs of a layer into y [numDirections*hiddenSize x numColumns]
+template <class ElemType>
+void CPURNNExecutor<ElemType>::AssembleLayerOutput(CPUMatrix<ElemType>& reserve, size_t layer, ElemType* y) const
+{
+    const size_t hiddenSize = m_rnnAttributes.m_hiddenSize;
+    const size_t yDim = NumDirections() * hiddenSize;
+    for (size_t dir = 0; dir < NumDirections(); dir++)
+    {
+        const ElemType* h = GetReserveBlock(reserve, layer, dir).h;
+#pragma omp parallel for
+        for (long j = 0; j < (long)m_numColumns; j++)
+            memcpy(y + j * yDim + dir * hiddenSize, h + j * hiddenSize, hiddenSize * sizeof(ElemType));
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardDirection(const CPUMatrix<ElemType>& weightsW, const ElemType* x, size_t layer, size_t dir, CPUMatrix<ElemType>& reserve, ElemType* scratch)
+{
+    typedef typename RNNComputeType<ElemType>::type T;
+
+    const size_t H = m_rnnAttributes.m_hiddenSize;
+    const size_t G = NumGates();
+    const size_t inputDim = LayerInputDim(layer);
+    const CellKind cellKind = m_cellKind;
+
+    const ElemType* w  = weightsW.Data() + WeightOffset(layer, dir);
+    const ElemType* r  = weightsW.Data() + RecurrentWeightOffset(layer, dir);
+    const ElemType* bW = weightsW.Data() + BiasOffset(layer, dir);
+    const ElemType* bR = weightsW.Data() + RecurrentBiasOffset(layer, dir);
+    ReserveBlock block = GetReserveBlock(reserve, layer, dir);
+
+    // input projection of all frames in one GEMM: gates = W' x + bW + bR
+    // (for GRU, the recurrent bias of the candidate gate is applied inside the cell since it is gated by r)
+    Gemm<ElemType>(0, block.gates, w, inputDim, G * H, /*transposeA=*/true, x, inputDim, m_numColumns, /*transposeB=*/false);
+    const size_t numBiasR = cellKind == CellKind::Gru ? 2 * H : G * H;
+#pragma omp parallel for
+    for (long j = 0; j < (long)m_numColumns; j++)
+    {
+        ElemType* g = block.gates + j * G * H;
+        for (size_t k = 0; k < G * H; k++)
+            g[k] = (ElemType)((T)g[k] + (T)bW[k] + (k < numBiasR ? (T)bR[k] : (T)0));
+    }
+
+    for (size_t step = 0; step < m_numFrames; step++)
+    {
+        const size_t t = FrameAt(dir, step);
+        const size_t n = m_numSequencesForFrame[t];
+        const size_t col = m_frameOffset[t];
+
+        // state carried over from the previously processed frame; sequences that start in this frame
+        // (only possible for the backward direction) begin with zero state
+        size_t numPrev = 0;
+        const ElemType* hPrev = nullptr;
+        const ElemType* sPrev = nullptr;
+        if (step > 0)
+        {
+            const size_t tPrev = FrameAt(dir, step - 1);
+            numPrev = min(m_numSequencesForFrame[tPrev], n);
+            hPrev = block.h + m_frameOffset[tPrev] * H;
+            if (block.state)
+                sPrev = block.state + m_frameOffset[tPrev] * H;
+        }
+
+        // recurrent projection: scratch [G*H x numPrev] = R' hPrev
+        if (numPrev > 0)
+            Gemm<ElemType>(0, scratch, r, H, G * H, /*transposeA=*/true, hPrev, H, numPrev, /*transposeB=*/false);
+
+#pragma omp parallel for
+        for (long j = 0; j < (long)n; j++)
+        {
+            const bool hasPrev = (size_t)j < numPrev;
+            const ElemType* gh = hasPrev ? scratch + j * G * H : nullptr;
+            ElemType* g = block.gates + (col + j) * G * H;
+            ElemType* h = block.h + (col + j) * H;
+            ElemType* s = block.state ? block.state + (col + j) * H : nullptr;
+
+            for (size_t u = 0; u < H; u++)
+            {
+                switch (cellKind)
+                {
+                case CellKind::Lstm:
+                {
+                    T i  = StableSigmoid((T)g[u]         + (gh ? (T)gh[u]         : (T)0));
+                    T f  = StableSigmoid((T)g[H + u]     + (gh ? (T)gh[H + u]     : (T)0));
+                    T cc = tanh_(        (T)g[2 * H + u] + (gh ? (T)gh[2 * H + u] : (T)0));
+                    T o  = StableSigmoid((T)g[3 * H + u] + (gh ? (T)gh[3 * H + u] : (T)0));
+                    T c  = f * (hasPrev ? (T)sPrev[j * H + u] : (T)0) + i * cc;
+                    g[u] = (ElemType)i; g[H + u] = (ElemType)f; g[2 * H + u] = (ElemType)cc; g[3 * H + u] = (ElemType)o;
+                    s[u] = (ElemType)c;
+                    h[u] = (ElemType)(o * tanh_(c));
+                    break;
+                }
+                case CellKind::Gru:
+                {
+                    T rg = StableSigmoid((T)g[u]     + (gh ? (T)gh[u]     : (T)0));
+                    T z  = StableSigmoid((T)g[H + u] + (gh ? (T)gh[H + u] : (T)0));
+                    T hh = (gh ? (T)gh[2 * H + u] : (T)0) + (T)bR[2 * H + u];
+                    T cc = tanh_((T)g[2 * H + u] + rg * hh);
+                    T hp = hasPrev ? (T)hPrev[j * H + u] : (T)0;
+                    g[u] = (ElemType)rg; g[H + u] = (ElemType)z; g[2 * H + u] = (ElemType)cc;
+                    s[u] = (ElemType)hh;
+                    h[u] = (ElemType)((1 - z) * cc + z * hp);
+                    break;
+                }
+                case CellKind::RnnReLU:
+                case CellKind::RnnTanh:
+                {
+                    T a = (T)g[u] + (gh ? (T)gh[u] : (T)0);
+                    T v = cellKind == CellKind::RnnReLU ? (a > 0 ? a : (T)0) : tanh_(a);
+                    g[u] = (ElemType)v;
+                    h[u] = (ElemType)v;
+                    break;
+                }
+                }
+            }
+        }
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::ForwardCore(const CPUMatrix<ElemType>& weightsW, const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY,
+                                           const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes,
+                                           CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+
+    if (weightsW.GetNumElements() != m_numParameters)
+        InvalidArgument("RNN needs %d parameters, but %d were allocated", (int)m_numParameters, (int)weightsW.GetNumElements());
+
+    SetFrames(numSequencesForFrame);
+    if (inputX.GetNumRows() != m_xDim || inputX.GetNumCols() != m_numColumns)
+        InvalidArgument("CPU RNN: input is [%d x %d], but [%d x %d] was expected.", (int)inputX.GetNumRows(), (int)inputX.GetNumCols(), (int)m_xDim, (int)m_numColumns);
+
+    const size_t H = m_rnnAttributes.m_hiddenSize;
+    const size_t yDim = NumDirections() * H;
+
+    // reserve: per-direction activations needed by the backward pass
+    // workspace: two layer-sized buffers, the per-frame recurrent projection, the two backward carries, and a ones vector
+    reserve.Resize(ReserveSizePerDirection() * m_rnnAttributes.m_numLayers * NumDirections(), 1);
+    workspace.Resize(2 * yDim * m_numColumns + (NumGates() + 2) * H * m_maxSequences + m_numColumns, 1);
+    outputY.RequireSize(m_yDim, m_numColumns);
+
+    ElemType* layerOutput = workspace.Data();
+    ElemType* scratch = layerOutput + 2 * yDim * m_numColumns;
+
+    const ElemType* x = inputX.Data();
+    for (size_t layer = 0; layer < m_rnnAttributes.m_numLayers; layer++)
+    {
+        for (size_t dir = 0; dir < NumDirections(); dir++)
+            ForwardDirection(weightsW, x, layer, dir, reserve, scratch);
+
+        // the layer input is no longer needed once both directions are done, so the output may overwrite it
+        ElemType* y = (layer + 1 == m_rnnAttributes.m_numLayers) ? outputY.Data() : layerOutput;
+        AssembleLayerOutput(reserve, layer, y);
+        x = y;
+    }
+    m_BackwardDataCalledYet = false;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardDirection(const CPUMatrix<ElemType>& weightsW, const ElemType* dy, size_t layer, size_t dir, CPUMatrix<ElemType>& reserve,
+                                                 ElemType* carryH, ElemType* carryC)
+{
+    typedef typename RNNComputeType<ElemType>::type T;
+
+    const size_t H = m_rnnAttributes.m_hiddenSize;
+    const size_t G = NumGates();
+    const size_t yDim = NumDirections() * H;
+    const CellKind cellKind = m_cellKind;
+
+    const ElemType* r = weightsW.Data() + RecurrentWeightOffset(layer, dir);
+    ReserveBlock block = GetReserveBlock(reserve, layer, dir);
+
+    // carryH/carryC hold the gradients w.r.t. h and c that flow into the frame being processed from the one
+    // processed after it in the forward pass; the last processed frame receives none
+    const size_t nLast = m_numSequencesForFrame[FrameAt(dir, m_numFrames - 1)];
+    fill(carryH, carryH + H * nLast, (ElemType)0);
+    fill(carryC, carryC + H * nLast, (ElemType)0);
+
+    for (size_t step = m_numFrames; step-- > 0;)
+    {
+        const size_t t = FrameAt(dir, step);
+        const size_t n = m_numSequencesForFrame[t];
+        const size_t col = m_frameOffset[t];
+
+        size_t numPrev = 0;
+        size_t nPrevFrame = 0;
+        const ElemType* hPrev = nullptr;
+        const ElemType* sPrev = nullptr;
+        if (step > 0)
+        {
+            const size_t tPrev = FrameAt(dir, step - 1);
+            nPrevFrame = m_numSequencesForFrame[tPrev];
+            numPrev = min(nPrevFrame, n);
+            hPrev = block.h + m_frameOffset[tPrev] * H;
+            if (block.state)
+                sPrev = block.state + m_frameOffset[tPrev] * H;
+        }
+
+#pragma omp parallel for
+        for (long j = 0; j < (long)n; j++)
+        {
+            const bool hasPrev = (size_t)j < numPrev;
+            const ElemType* dyj = dy + (col + j) * yDim + dir * H;
+            const ElemType* g = block.gates + (col + j) * G * H;
+            const ElemType* s = block.state ? block.state + (col + j) * H : nullptr;
+            const ElemType* h = block.h + (col + j) * H;
+            ElemType* dgx = block.dGatesX + (col + j) * G * H;
+            ElemType* dgh = block.dGatesH + (col + j) * G * H;
+            ElemType* ch = carryH + j * H;
+            ElemType* cs = carryC + j * H;
+
+            for (size_t u = 0; u < H; u++)
+            {
+                T dh = (T)dyj[u] + (T)ch[u];
+                switch (cellKind)
+                {
+                case CellKind::Lstm:
+                {
+                    T i = (T)g[u], f = (T)g[H + u], cc = (T)g[2 * H + u], o = (T)g[3 * H + u];
+                    T tc = tanh_((T)s[u]);
+                    T cp = hasPrev ? (T)sPrev[j * H + u] : (T)0;
+                    T dc = dh * o * (1 - tc * tc) + (T)cs[u];
+                    dgx[u]         = (ElemType)(dc * cc * i * (1 - i));
+                    dgx[H + u]     = (ElemType)(dc * cp * f * (1 - f));
+                    dgx[2 * H + u] = (ElemType)(dc * i * (1 - cc * cc));
+                    dgx[3 * H + u] = (ElemType)(dh * tc * o * (1 - o));
+                    cs[u] = (ElemType)(hasPrev ? dc * f : (T)0);
+                    ch[u] = (ElemType)0;
+                    break;
+                }
+                case CellKind::Gru:
+                {
+                    T rg = (T)g[u], z = (T)g[H + u], cc = (T)g[2 * H + u];
+                    T hp = hasPrev ? (T)hPrev[j * H + u] : (T)0;
+                    T dcc = dh * (1 - z) * (1 - cc * cc);
+                    T dr = dcc * (T)s[u] * rg * (1 - rg);
+                    T dz = dh * (hp - cc) * z * (1 - z);
+                    dgx[u] = dgh[u] = (ElemType)dr;
+                    dgx[H + u] = dgh[H + u] = (ElemType)dz;
+                    dgx[2 * H + u] = (ElemType)dcc;
+                    dgh[2 * H + u] = (ElemType)(dcc * rg);
+                    ch[u] = (ElemType)(hasPrev ? dh * z : (T)0);
+                    break;
+                }
+                case CellKind::RnnReLU:
+                case CellKind::RnnTanh:
+                {
+                    T v = (T)h[u];
+                    dgx[u] = (ElemType)(cellKind == CellKind::RnnReLU ? (v > 0 ? dh : (T)0) : dh * (1 - v * v));
+                    ch[u] = (ElemType)0;
+                    break;
+                }
+                }
+            }
+        }
+
+        // recurrent gradient into the previously processed frame: carryH[:, 0:numPrev] += R dGatesH
+        if (numPrev > 0)
+            Gemm<ElemType>(1, carryH, r, H, G * H, /*transposeA=*/false, block.dGatesH + col * G * H, G * H, numPrev, /*transposeB=*/false);
+
+        // sequences of the previous frame that have ended before this one receive no recurrent gradient
+        if (nPrevFrame > n)
+        {
+            fill(carryH + n * H, carryH + nPrevFrame * H, (ElemType)0);
+            fill(carryC + n * H, carryC + nPrevFrame * H, (ElemType)0);
+        }
+    }
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardDataCore(const CPUMatrix<ElemType>& outputY, const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& weightsW, CPUMatrix<ElemType>& dx,
+                                                const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+
+    if (!m_BackwardDataCalledYet)
+    {
+        if (outputDY.GetNumRows() != m_yDim || outputDY.GetNumCols() != m_numColumns || outputY.GetNumCols() != m_numColumns)
+            InvalidArgument("CPU RNN: output gradient does not match the output of the last forward pass.");
+
+        const size_t H = m_rnnAttributes.m_hiddenSize;
+        const size_t G = NumGates();
+        const size_t yDim = NumDirections() * H;
+
+        dx.RequireSize(m_xDim, m_numColumns);
+
+        // ping-pong buffers for the gradient w.r.t. the output of the layer below
+        ElemType* dyBuffers[2] = { workspace.Data(), workspace.Data() + yDim * m_numColumns };
+        ElemType* scratch = workspace.Data() + 2 * yDim * m_numColumns;
+        ElemType* carryH = scratch + G * H * m_maxSequences;
+        ElemType* carryC = carryH + H * m_maxSequences;
+
+        const ElemType* dy = outputDY.Data();
+        for (size_t layer = m_rnnAttributes.m_numLayers; layer-- > 0;)
+        {
+            for (size_t dir = 0; dir < NumDirections(); dir++)
+                BackwardDirection(weightsW, dy, layer, dir, reserve, carryH, carryC);
+
+            // gradient w.r.t. the layer input, summed over both directions: dX = W dGatesX
+            const size_t inputDim = LayerInputDim(layer);
+            ElemType* dInput = layer == 0 ? dx.Data() : dyBuffers[layer % 2];
+            for (size_t dir = 0; dir < NumDirections(); dir++)
+                Gemm<ElemType>(dir == 0 ? 0 : 1, dInput, weightsW.Data() + WeightOffset(layer, dir), inputDim, G * H, /*transposeA=*/false,
+                               GetReserveBlock(reserve, layer, dir).dGatesX, G * H, m_numColumns, /*transposeB=*/false);
+            dy = dInput;
+        }
+    }
+    m_BackwardDataCalledYet = true;
+}
+
+template <class ElemType>
+void CPURNNExecutor<ElemType>::BackwardWeightsCore(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& /*outputY: hidden outputs are kept in the reserve*/, CPUMatrix<ElemType>& dw,
+                                                   const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace)
+{
+    // test that the RNN shape is correct
+    if (!(m_rnnAttributes == rnnAttributes))
+        LogicError("RNN Layout has changed during processing");
+    if (!m_BackwardDataCalledYet)
+        LogicError("RNNBackwardWeights called before RNNBackwardData");
+    if (dw.GetNumElements() != m_numParameters)
+        InvalidArgument("RNN needs %d parameters, but %d were allocated", (int)m_numParameters, (int)dw.GetNumElements());
+
+    const size_t H = m_rnnAttributes.m_hiddenSize;
+    const size_t G = NumGates();
+    const size_t yDim = NumDirections() * H;
+
+    // like cuDNN, the weight gradients are accumulated into dw
+    ElemType* layerInput = workspace.Data();
+    ElemType* hPrevs = layerInput + yDim * m_numColumns;
+    ElemType* ones = workspace.Data() + workspace.GetNumElements() - m_numColumns;
+    fill(ones, ones + m_numColumns, (ElemType)1);
+
+    const ElemType* x = inputX.Data();
+    for (size_t layer = 0; layer < m_rnnAttributes.m_numLayers; layer++)
+    {
+        const size_t inputDim = LayerInputDim(layer);
+        if (layer > 0)
+        {
+            AssembleLayerOutput(reserve, layer - 1, layerInput);
+            x = layerInput;
+        }
+
+        for (size_t dir = 0; dir < NumDirections(); dir++)
+        {
+            ReserveBlock block = GetReserveBlock(reserve, layer, dir);
+
+            // dW += x dGatesX'
+            Gemm<ElemType>(1, dw.Data() + WeightOffset(layer, dir), x, inputDim, m_numColumns, /*transposeA=*/false, block.dGatesX, G * H, m_numColumns, /*transposeB=*/true);
+
+            // gather, for every column, the hidden state its recurrent projection was computed from (zero at sequence start)
+            for (size_t step = 0; step < m_numFrames; step++)
+            {
+                const size_t t = FrameAt(dir, step);
+                const size_t n = m_numSequencesForFrame[t];
+                ElemType* dst = hPrevs + m_frameOffset[t] * H;
+                size_t numPrev = 0;
+                if (step > 0)
+                {
+                    const size_t tPrev = FrameAt(dir, step - 1);
+                    numPrev = min(m_numSequencesForFrame[tPrev], n);
+                    memcpy(dst, block.h + m_frameOffset[tPrev] * H, numPrev * H * sizeof(ElemType));
+                }
+                fill(dst + numPrev * H, dst + n * H, (ElemType)0);
+            }
+
+            // dR += hPrev dGatesH'
+            Gemm<ElemType>(1, dw.Data() + RecurrentWeightOffset(layer, dir), hPrevs, H, m_numColumns, /*transposeA=*/false, block.dGatesH, G * H, m_numColumns, /*transposeB=*/true);
+
+            // dbW += dGatesX 1, dbR += dGatesH 1
+            Gemm<ElemType>(1, dw.Data() + BiasOffset(layer, dir),          block.dGatesX, G * H, m_numColumns, /*transposeA=*/false, ones, m_numColumns, 1, /*transposeB=*/false);
+            Gemm<ElemType>(1, dw.Data() + RecurrentBiasOffset(layer, dir), block.dGatesH, G * H, m_numColumns, /*transposeA=*/false, ones, m_numColumns, 1, /*transposeB=*/false);
+        }
+    }
+}
+
+template class CPURNNExecutor<float>;
+template class CPURNNExecutor<double>;
+template class CPURNNExecutor<half>;
+
+}}}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// CPURNN.h -- fused CPU implementation of the OptimizedRNNStack (LSTM/GRU/RNN) engine.
+//
+
+#pragma once
+
+#include "CPUMatrix.h"
+#include "RNNCommon.h"
+#include <vector>
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// CPURNNExecutor is the CPU counterpart of CuDnnRNNExecutor. It holds the configuration for one
+// OptimizedRNNStack and is attached to the CPUMatrix that receives the output, so that all calls
+// for the same RNN go through the same object.
+//
+// The parameters are consumed in the cuDNN layout produced by RnnAttributes::GetNumParameters(),
+// so that models can be moved freely between GPU and CPU:
+//  - for each layer, for each direction: W [inputDim x numGates*hiddenSize], then R [hiddenSize x numGates*hiddenSize]
+//  - then for each layer, for each direction: bW [numGates*hiddenSize], then bR [numGates*hiddenSize]
+// Gate order is (i, f, c, o) for LSTM and (r, z, h') for GRU, as in cuDNN.
+//
+// Data is expected in the "dense cuDNN packing" created by OptimizedRNNStackNode::PackSequencesForCuDNN():
+// frame t holds numSequencesForFrame[t] columns, sequences sorted from longest to shortest.
+//
+// The input projection of all frames is done as a single GEMM per layer and direction; only the
+// recurrent GEMM and the (fused) elementwise cell update are done per frame.
+// The reserve buffer holds everything that must survive between ForwardCore(), BackwardDataCore()
+// and BackwardWeightsCore(); the workspace is scratch memory.
+template <class ElemType>
+class CPURNNExecutor
+{
+public:
+    CPURNNExecutor(size_t xDim, size_t yDim, const RnnAttributes& rnnAttributes);
+
+    void ForwardCore(const CPUMatrix<ElemType>& weightsW, const CPUMatrix<ElemType>& inputX, CPUMatrix<ElemType>& outputY, const vector<size_t>& numSequencesForFrame, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void BackwardDataCore(const CPUMatrix<ElemType>& outputY, const CPUMatrix<ElemType>& outputDY, const CPUMatrix<ElemType>& weightsW, CPUMatrix<ElemType>& dx, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+    void BackwardWeightsCore(const CPUMatrix<ElemType>& inputX, const CPUMatrix<ElemType>& outputY, CPUMatrix<ElemType>& dw, const RnnAttributes& rnnAttributes, CPUMatrix<ElemType>& reserve, CPUMatrix<ElemType>& workspace);
+
+private:
+    enum class CellKind
+    {
+        Lstm,
+        Gru,
+        RnnReLU,
+        RnnTanh
+    };
+
+    size_t NumDirections() const { return m_rnnAttributes.m_bidirectional ? 2 : 1; }
+    size_t NumGates() const { return m_cellKind == CellKind::Lstm ? 4 : m_cellKind == CellKind::Gru ? 3 : 1; }
+    size_t LayerInputDim(size_t layer) const { return layer == 0 ? m_xDim : NumDirections() * m_rnnAttributes.m_hiddenSize; }
+
+    // offsets of the per-layer/per-direction parameter blocks (in elements)
+    size_t WeightOffset(size_t layer, size_t dir) const { return m_weightOffsets[layer * NumDirections() + dir]; }
+    size_t RecurrentWeightOffset(size_t layer, size_t dir) const { return WeightOffset(layer, dir) + LayerInputDim(layer) * NumGates() * m_rnnAttributes.m_hiddenSize; }
+    size_t BiasOffset(size_t layer, size_t dir) const { return m_biasOffset + (layer * NumDirections() + dir) * 2 * NumGates() * m_rnnAttributes.m_hiddenSize; }
+    size_t RecurrentBiasOffset(size_t layer, size_t dir) const { return BiasOffset(layer, dir) + NumGates() * m_rnnAttributes.m_hiddenSize; }
+
+    // per-layer/per-direction buffers inside the reserve
+    struct ReserveBlock
+    {
+        ElemType* h;        // [hiddenSize x numFrames] hidden output of this direction
+        ElemType* gates;    // [numGates*hiddenSize x numFrames] gate activations
+        ElemType* state;    // [hiddenSize x numFrames] LSTM cell state, or GRU recurrent candidate (R_h h + bR_h)
+        ElemType* dGatesX;  // [numGates*hiddenSize x numFrames] gradient w.r.t. the input projection
+        ElemType* dGatesH;  // [numGates*hiddenSize x numFrames] gradient w.r.t. the recurrent projection (aliases dGatesX except for GRU)
+    };
+    ReserveBlock GetReserveBlock(CPUMatrix<ElemType>& reserve, size_t layer, size_t dir) const;
+    size_t ReserveSizePerDirection() const;
+
+    void SetFrames(const vector<size_t>& numSequencesForFrame);
+    void AssembleLayerOutput(CPUMatrix<ElemType>& reserve, size_t layer, ElemType* y) const;
+    void ForwardDirection(const CPUMatrix<ElemType>& weightsW, const ElemType* x, size_t layer, size_t dir, CPUMatrix<ElemType>& reserve, ElemType* scratch);
+    void BackwardDirection(const CPUMatrix<ElemType>& weightsW, const ElemType* dy, size_t layer, size_t dir, CPUMatrix<ElemType>& reserve, ElemType* carryH, ElemType* carryC);
+
+    // frame at processing step 'step' of direction 'dir'
+    size_t FrameAt(size_t dir, size_t step) const { return dir == 0 ? step : m_numFrames - 1 - step; }
+
+private:
+    size_t m_xDim, m_yDim;
+    RnnAttributes m_rnnAttributes;
+    CellKind m_cellKind;
+
+    std::vector<size_t> m_weightOffsets; // per layer and direction
+    size_t m_biasOffset;
+    size_t m_numParameters;
+
+    // layout of the packed minibatch, set in ForwardCore()
+    std::vector<size_t> m_numSequencesForFrame;
+    std::vector<size_t> m_frameOffset; // first column of each frame
+    size_t m_numFrames;
+    size_t m_numColumns;
+    size_t m_maxSequences;
+
+    bool m_BackwardDataCalledYet;
+};
+
+}}}
@@ -1525,6 +1525,245 @@ void CPUSparseMatrix<ElemType>::AdaDelta(CPUMatrix<AccumType>& c, CPUMatrix<Accu
     }
 }
 
+// Lazy FSAdaGrad, see CPUMatrix::FSAdagrad() for the dense version.
+// Columns without a gradient are skipped. A dense update with a zero gradient would only decay their state
+// and move them along their momentum; the decay is caught up from the column's timestamp once it gets a gradient again.
+template <class ElemType>
+void CPUSparseMatrix<ElemType>::FSAdagrad(CPUMatrix<ElemType>& c, CPUMatrix<ElemType>& functionValues, ElemType learnRatePerSample, ElemType momentum,
+                                          ElemType adaWeight, ElemType adaMul, ElemType unitGainFactor, int* timestamps, int currentTimestamp)
+{
+    size_t numColsNeeded = 2 * GetNumCols();
+
+    if (c.IsEmpty() || (c.GetNumCols() < numColsNeeded))
+    {
+        c.RequireSize(GetNumRows(), numColsNeeded);
+        c.SetValue(0.0);
+    }
+
+    if (c.GetNumRows() != GetNumRows() || c.GetNumCols() != numColsNeeded)
+        LogicError("The matrix gradients does not have expected dimensions.");
+
+    if (GetFormat() != MatrixFormat::matrixFormatSparseBlockCol)
+        LogicError("Unsupported sparse format.");
+
+    if (!timestamps)
+        LogicError("FSAdagrad: Sparse gradients require timestamps.");
+
+    size_t n = GetNumElements();
+    ElemType* grad = Data();
+    ElemType* smoothAda = c.Data();
+    ElemType* smoothMom = c.Data() + n;
+    ElemType* val = functionValues.Data();
+    auto rows = GetNumRows();
+
+#pragma omp parallel for
+    for (auto blockid = 0; blockid < (int)GetBlockSize(); ++blockid)
+    {
+        auto col = GetBlockIds()[blockid] - GetBlockIdShift();
+        auto columnOffset = col * rows;
+        auto blockOffset = blockid * rows;
+        auto skippedSteps = currentTimestamp - 1 - timestamps[col];
+        ElemType adaDecay = adaWeight * (ElemType)std::pow((double)adaWeight, (double)skippedSteps);
+        ElemType momDecay = momentum * (ElemType)std::pow((double)momentum, (double)skippedSteps);
+        timestamps[col] = currentTimestamp;
+        for (size_t row = 0; row < rows; ++row)
+        {
+            size_t denseIndex = columnOffset + row;
+            ElemType g = grad[blockOffset + row];
+            ElemType adaSqr = adaDecay * smoothAda[denseIndex] + ((ElemType)1 - adaWeight) * g * g;
+            smoothAda[denseIndex] = adaSqr;
+            if (adaSqr != (ElemType)0)
+            {
+                ElemType w = adaMul / (ElemType)sqrt(adaSqr);
+                if (w > (ElemType)10)
+                    w = (ElemType)10;
+                g *= w;
+            }
+
+            if (momentum > (ElemType)0)
+            {
+                g = momDecay * smoothMom[denseIndex] + unitGainFactor * g;
+                smoothMom[denseIndex] = g;
+            }
+
+            val[denseIndex] -= learnRatePerSample * g;
+        }
+    }
+}
+
+// Lazy Adam, see CPUMatrix::Adam() for the dense version, and FSAdagrad() above for what is skipped.
+template <class ElemType>
+void CPUSparseMatrix<ElemType>::Adam(CPUMatrix<ElemType>& c, CPUMatrix<ElemType>& functionValues, ElemType learnRatePerSample, ElemType momentum,
+                                     ElemType adaWeight, ElemType adaMul, ElemType epsilon, ElemType unitGainFactor, bool adamax, int* timestamps, int currentTimestamp)
+{
+    size_t numColsNeeded = 2 * GetNumCols();
+
+    if (c.IsEmpty() || (c.GetNumCols() < numColsNeeded))
+    {
+        c.RequireSize(GetNumRows(), numColsNeeded);
+        c.SetValue(0.0);
+    }
+
+    if (c.GetNumRows() != GetNumRows() || c.GetNumCols() != numColsNeeded)
+        LogicError("The matrix gradients does not have expected dimensions.");
+
+    if (GetFormat() != MatrixFormat::matrixFormatSparseBlockCol)
+        LogicError("Unsupported sparse format.");
+
+    if (!timestamps)
+        LogicError("Adam: Sparse gradients require timestamps.");
+
+    size_t n = GetNumElements();
+    ElemType* grad = Data();
+    ElemType* smoothAda = c.Data();
+    ElemType* smoothMom = c.Data() + n;
+    ElemType* val = functionValues.Data();
+    auto rows = GetNumRows();
+
+#pragma omp parallel for
+    for (auto blockid = 0; blockid < (int)GetBlockSize(); ++blockid)
+    {
+        auto col = GetBlockIds()[blockid] - GetBlockIdShift();
+        auto columnOffset = col * rows;
+        auto blockOffset = blockid * rows;
+        auto skippedSteps = currentTimestamp - 1 - timestamps[col];
+        // with zero gradients, both the squares and their max (adamax) just decay by adaWeight per step
+        ElemType adaDecay = adaWeight * (ElemType)std::pow((double)adaWeight, (double)skippedSteps);
+        ElemType momDecay = momentum * (ElemType)std::pow((double)momentum, (double)skippedSteps);
+        timestamps[col] = currentTimestamp;
+        for (size_t row = 0; row < rows; ++row)
+        {
+            size_t denseIndex = columnOffset + row;
+            ElemType g = grad[blockOffset + row];
+            ElemType ada;
+            if (!adamax)
+            {
+                ElemType adaSqr = adaDecay * smoothAda[denseIndex] + ((ElemType)1 - adaWeight) * g * g;
+                smoothAda[denseIndex] = adaSqr;
+                ada = (ElemType)sqrt(adaSqr);
+            }
+            else
+                ada = smoothAda[denseIndex] = std::max(adaDecay * smoothAda[denseIndex], g < (ElemType)0 ? -g : g);
+
+            ElemType w = adaMul / (ada + epsilon);
+            g = momDecay * smoothMom[denseIndex] + unitGainFactor * g;
+            smoothMom[denseIndex] = g;
+            val[denseIndex] -= g * w * learnRatePerSample;
+        }
+    }
+}
+
+// Lazy RmsProp, see CPUMatrix::RmsProp() for the dense version. A zero gradient leaves a column's value alone,
+// so skipping it is exact once the decay of its variances and step sizes is caught up.
+// That does not hold for the average multiplier, which is taken over all columns; with needAveMultiplier,
+// all columns are updated as in the dense version.
+template <class ElemType>
+ElemType CPUSparseMatrix<ElemType>::RmsProp(CPUMatrix<ElemType>& c, ElemType RMS_GAMMA, ElemType RMS_WGT_INC, ElemType RMS_WGT_MAX, ElemType RMS_WGT_DEC, ElemType RMS_WGT_MIN,
+                                            const bool needAveMultiplier, const bool initialized, int* timestamps, int currentTimestamp)
+{
+    if (GetFormat() != MatrixFormat::matrixFormatSparseBlockCol)
+        LogicError("Unsupported sparse format.");
+
+    if (needAveMultiplier)
+    {
+        CPUMatrix<ElemType> denseGrad = CopyColumnSliceToDense(0, GetNumCols());
+        ElemType aveMultiplier = c.RmsProp(denseGrad, RMS_GAMMA, RMS_WGT_INC, RMS_WGT_MAX, RMS_WGT_DEC, RMS_WGT_MIN, needAveMultiplier, initialized);
+
+        // the scaled gradient goes back into the blocks, and all columns are up to date
+        auto rows = GetNumRows();
+        for (size_t blockid = 0; blockid < GetBlockSize(); ++blockid)
+        {
+            auto col = GetBlockIds()[blockid] - GetBlockIdShift();
+            memcpy(Data() + blockid * rows, denseGrad.Data() + col * rows, sizeof(ElemType) * rows);
+        }
+        if (timestamps)
+            std::fill(timestamps, timestamps + GetNumCols(), currentTimestamp);
+        return aveMultiplier;
+    }
+
+    if (!timestamps)
+        LogicError("RmsProp: Sparse gradients require timestamps.");
+
+    const ElemType floor = 1e-6f;
+
+    size_t n = GetNumElements();
+    ElemType* grad = Data();
+    auto rows = GetNumRows();
+    auto cols = GetNumCols();
+
+    if (c.IsEmpty() || c.GetNumCols() < cols * 3 || !initialized)
+    {
+        c.RequireSize(rows, cols * 3);
+        c.SetValue(0.0);
+        std::fill(c.Data() + 2 * n, c.Data() + 3 * n, ElemType(0.02)); // starting step size
+
+        // everything is fresh: the columns with a gradient start from its square (below), all others from zero
+        for (size_t col = 0; col < cols; col++)
+            timestamps[col] = currentTimestamp - 1;
+        for (size_t blockid = 0; blockid < GetBlockSize(); ++blockid)
+        {
+            auto col = GetBlockIds()[blockid] - GetBlockIdShift();
+            for (size_t row = 0; row < rows; ++row)
+            {
+                ElemType g = grad[blockid * rows + row];
+                c.Data()[col * rows + row] = g * g;
+            }
+        }
+    }
+
+    if (c.GetNumRows() != rows || c.GetNumCols() != cols * 3)
+        LogicError("The matrix gradients does not have expected dimensions.");
+
+    ElemType* avars = c.Data();         // accumulated variances for RMS scaling
+    ElemType* signs = c.Data() + n;     // sign of previous gradient
+    ElemType* steps = c.Data() + 2 * n; // current step size
+
+    const ElemType ONE_MINUS_GAMMA = ElemType(1.0) - RMS_GAMMA;
+    double aveMultiplier = 0;
+#pragma omp parallel for reduction(+ : aveMultiplier)
+    for (auto blockid = 0; blockid < (int)GetBlockSize(); ++blockid)
+    {
+        auto col = GetBlockIds()[blockid] - GetBlockIdShift();
+        auto columnOffset = col * rows;
+        auto blockOffset = blockid * rows;
+        auto skippedSteps = currentTimestamp - 1 - timestamps[col];
+        ElemType avarsDecay = RMS_GAMMA * (ElemType)std::pow((double)RMS_GAMMA, (double)skippedSteps);
+        ElemType stepsDecay = (ElemType)std::pow((double)RMS_WGT_DEC, (double)skippedSteps);
+        timestamps[col] = currentTimestamp;
+        for (size_t row = 0; row < rows; ++row)
+        {
+            size_t denseIndex = columnOffset + row;
+            ElemType g = grad[blockOffset + row];
+            if (skippedSteps > 0) // zero gradients have no sign and only shrink the step size
+            {
+                signs[denseIndex] = 0;
+                steps[denseIndex] = std::max(steps[denseIndex] * stepsDecay, RMS_WGT_MIN);
+            }
+
+            avars[denseIndex] = avarsDecay * avars[denseIndex] + ONE_MINUS_GAMMA * (g * g);
+            const int grad_sign = (ElemType(0) < g) - (g < ElemType(0));
+
+            if (signs[denseIndex] * (ElemType)grad_sign > (ElemType)0)
+                steps[denseIndex] = std::min(steps[denseIndex] * RMS_WGT_INC, RMS_WGT_MAX);
+            else
+                steps[denseIndex] = std::max(steps[denseIndex] * RMS_WGT_DEC, RMS_WGT_MIN);
+
+            ElemType a = steps[denseIndex] / (ElemType)sqrt(avars[denseIndex] + floor);
+            grad[blockOffset + row] *= a;
+            signs[denseIndex] = (ElemType)grad_sign;
+
+            if (needAveMultiplier)
+                aveMultiplier += (double)a;
+        }
+    }
+
+    size_t nz = NzCount();
+    if (needAveMultiplier && nz > 0)
+        return (ElemType)(aveMultiplier / nz);
+    else
+        return 1;
+}
+
 template <class ElemType>
 CPUSparseMatrix<ElemType>& CPUSparseMatrix<ElemType>::InplaceTruncateTop(const ElemType threshold)
 {
@@ -1933,5 +2172,6 @@ template void CPUSparseMatrix<short>::SetMatrixFromCSCFormat(const CPUSPARSE_IND
 
 template CPUSparseMatrix<int>::CPUSparseMatrix(const MatrixFormat, const size_t, const size_t, const size_t);
 template CPUSparseMatrix<int>::~CPUSparseMatrix();
+template int* CPUSparseMatrix<int>::Data() const;
 
 }}}
@@ -239,6 +239,16 @@ public:
     template<typename AccumType>
     void AdaDelta(CPUMatrix<AccumType>& c, CPUMatrix<AccumType>& functionValues, AccumType learningRate, AccumType rho, AccumType epsilon, int* timestamps, int currentTimestamp);
 
+    // Lazy variants for block sparse column gradients: only the columns with a gradient are updated. The decay of the
+    // state that a dense update would have applied to a column since its timestamp is caught up when the column is updated.
+    void FSAdagrad(CPUMatrix<ElemType>& c, CPUMatrix<ElemType>& functionValues, ElemType learnRatePerSample, ElemType momentum,
+                   ElemType adaWeight, ElemType adaMul, ElemType unitGainFactor, int* timestamps, int currentTimestamp);
+    void Adam(CPUMatrix<ElemType>& c, CPUMatrix<ElemType>& functionValues, ElemType learnRatePerSample, ElemType momentum,
+              ElemType adaWeight, ElemType adaMul, ElemType epsilon, ElemType unitGainFactor, bool adamax, int* timestamps, int currentTimestamp);
+    // with needAveMultiplier, this updates all columns and needs no timestamps
+    ElemType RmsProp(CPUMatrix<ElemType>& c, ElemType RMS_GAMMA, ElemType RMS_WGT_INC, ElemType RMS_WGT_MAX, ElemType RMS_WGT_DEC, ElemType RMS_WGT_MIN,
+                     const bool needAveMultiplier, const bool initialized, int* timestamps, int currentTimestamp);
+
 public:
     CPUSparseMatrix<ElemType>& InplaceTruncateTop(const ElemType threshold);
     CPUSparseMatrix<ElemType>& InplaceTruncateBottom(const ElemType threshold);
@@ -20,6 +20,8 @@
 #include <memory>
 #include <unordered_map>
 #include <map>
+#include <vector>
+#include <limits>
 
 #pragma warning( disable: 4251 )
 typedef unsigned char byte;
@@ -114,6 +116,7 @@ enum ElementWiseOperator
     opElementwiseProductWithReciprocalDerivative, opSqrOfDifference,
     opElementwiseProductWithExponentialLinearUnitDerivativeFromOutput,
     opElementwiseProductWithStraightThroughDerivative,
+    opSigmoidOfSum, opTanhOfSum, opLinearRectifierOfSum, // fused non-linearity of a sum, used for recurrent loops
     // binary ops for indexing
     // opIndex,
     // ternary
@@ -200,7 +203,10 @@ enum ElementWiseOperator
     Macro(ElementwiseProductWithSqrtDerivative);                             \
     Macro(SqrOfDifference);                                                  \
     Macro(ElementwiseProductWithExponentialLinearUnitDerivativeFromOutput);  \
-    Macro(ElementwiseProductWithStraightThroughDerivative); 
+    Macro(ElementwiseProductWithStraightThroughDerivative);                  \
+    Macro(SigmoidOfSum);                                                     \
+    Macro(TanhOfSum);                                                        \
+    Macro(LinearRectifierOfSum);
     //Macro(Index);
 
 #define ForAllTernaryOps(Macro)                         \
@@ -213,6 +219,108 @@ enum ElementWiseOperator
     Macro(ElementwiseProductWithPowExponentDerivative); \
     Macro(ElementwiseProductWithPowBaseDerivative);
 
+// -----------------------------------------------------------------------
+// FusedElementwiseProgram -- a chain of unary and binary elementwise ops that is computed in a single pass
+// Operands of a step are either inputs (0..numInputs-1) or results of earlier steps (numInputs + step index).
+// The result of the last step is the output. Every input must be used by some step.
+// Gradients are computed by recomputing the steps, and are available for ops with a FusedElementwiseDerivative().
+// -----------------------------------------------------------------------
+
+struct FusedElementwiseStep
+{
+    ElementWiseOperator op;
+    int operands[2]; // second is -1 for unary ops
+};
+
+struct FusedElementwiseProgram
+{
+    size_t numInputs = 0;
+    std::vector<FusedElementwiseStep> steps;
+
+    size_t NumOperands() const { return numInputs + steps.size(); }
+};
+
+// what the derivative op is applied to besides the incoming gradient
+enum class FusedElementwiseDerivativeArg
+{
+    none,        // unary op on the gradient, e.g. opNegate
+    output,      // the result of the step, e.g. for opSigmoid
+    operand,     // the operand that the gradient is computed for, e.g. for opAbs
+    otherOperand // the other operand of a binary op, e.g. for opElementwiseProduct
+};
+
+// derivative of a step w.r.t. its operand 'k', as an op that maps the incoming gradient to the operand's gradient
+// Returns false if 'op' cannot be back-propagated through.
+static inline bool FusedElementwiseDerivative(ElementWiseOperator op, size_t k, ElementWiseOperator& derivativeOp, FusedElementwiseDerivativeArg& arg)
+{
+    arg = FusedElementwiseDerivativeArg::none;
+    switch (op)
+    {
+    case opCopy:
+    case opSum:                   derivativeOp = opCopy; break;
+    case opNegate:                derivativeOp = opNegate; break;
+    case opDifference:            derivativeOp = k == 0 ? opCopy : opNegate; break;
+    case opElementwiseProduct:    derivativeOp = opElementwiseProduct;                                              arg = FusedElementwiseDerivativeArg::otherOperand; break;
+    case opSigmoid:
+    case opStableSigmoid:         derivativeOp = opElementwiseProductWithSigmoidDerivativeFromOutput;               arg = FusedElementwiseDerivativeArg::output; break;
+    case opTanh:                  derivativeOp = opElementwiseProductWithTanhDerivativeFromOutput;                  arg = FusedElementwiseDerivativeArg::output; break;
+    case opLinearRectifier:       derivativeOp = opElementwiseProductWithLinearRectifierDerivativeFromOutput;       arg = FusedElementwiseDerivativeArg::output; break;
+    case opExponentialLinearUnit: derivativeOp = opElementwiseProductWithExponentialLinearUnitDerivativeFromOutput; arg = FusedElementwiseDerivativeArg::output; break;
+    case opExp:                   derivativeOp = opElementwiseProduct;                                              arg = FusedElementwiseDerivativeArg::output; break;
+    case opLog:                   derivativeOp = opElementwiseProductWithLogDerivativeFromOutput;                   arg = FusedElementwiseDerivativeArg::output; break;
+    case opSqrt:                  derivativeOp = opElementwiseProductWithSqrtDerivative;                            arg = FusedElementwiseDerivativeArg::output; break;
+    case opReciprocal:            derivativeOp = opElementwiseProductWithReciprocalDerivative;                      arg = FusedElementwiseDerivativeArg::output; break;
+    case opAbs:                   derivativeOp = opElementwiseProductWithAbsDerivative;                             arg = FusedElementwiseDerivativeArg::operand; break;
+    case opSin:                   derivativeOp = opElementwiseProductWithSinDerivative;                             arg = FusedElementwiseDerivativeArg::operand; break;
+    case opCosine:                derivativeOp = opElementwiseProductWithCosDerivative;                             arg = FusedElementwiseDerivativeArg::operand; break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// FusedLearnerStep -- one learner update of many parameters at once, see Matrix::FusedLearnerUpdate()
+// Per element of each parameter p with gradient g, this computes what the learner's separate passes compute:
+//   g = gradientScale * g                   mean gradient and loss scaling
+//   g = clip(g, clippingThreshold)          by truncation, or by the Frobenius norm of the parameter's gradient
+//   g = g + l2Weight * p
+//   the optimizer update of p and its smoothed gradient, as in e.g. Matrix::AdamUpdate()
+//   p = softThreshold(p, l1Threshold)
+// -----------------------------------------------------------------------
+
+enum class FusedLearnerKind
+{
+    SGD,
+    MomentumSGD,
+    Nesterov,
+    AdaGrad,
+    RmsProp,
+    Adam
+};
+
+struct FusedLearnerStep
+{
+    FusedLearnerKind kind = FusedLearnerKind::SGD;
+
+    double gradientScale = 1;
+    double clippingThreshold = std::numeric_limits<double>::infinity();
+    bool clippingWithTruncation = true;
+    double l2Weight = 0;
+    double l1Threshold = 0;
+
+    double learningRate = 0;
+    double momentum = 0;            // MomentumSGD, Nesterov, Adam
+    double unitGainFactor = 1;      // MomentumSGD, Nesterov, Adam
+    double varianceMomentum = 0;    // Adam
+    double epsilon = 0;             // Adam
+    double biasCorrection = 1;      // Adam
+    bool adamax = false;            // Adam
+    bool needAveMultiplier = false; // AdaGrad, RmsProp
+    bool initialized = true;        // RmsProp, false to restart its state from this gradient
+    double rmsGamma = 0, rmsInc = 0, rmsDec = 0, rmsMax = 0, rmsMin = 0; // RmsProp
+};
+
 // -----------------------------------------------------------------------
 // various enums to describe
 // -----------------------------------------------------------------------
@@ -225,6 +333,7 @@ enum MatrixFlagBitPosition
     bitPosCompressed = 2,       // a compressed sparse format (CSC/CSR)
     bitPosDontOwnBuffer = 3,    // buffer is not owned by this matrix
     bitPosSetValueOnDevice = 4, // in a setValue situation, the copy from buffer is already on the device
+    bitPosMayOutgrowBuffer = 5, // the external buffer is a slot of a memory arena, which the matrix may leave
 };
 
 enum MatrixFormat
@@ -252,6 +361,7 @@ enum MatrixFlags
     matrixFlagNormal = 0,
     matrixFlagDontOwnBuffer = 1 << bitPosDontOwnBuffer,       // the matrix memory pointers are externally managed, don't allocate/free or attempt to copy to another location
     matrixFlagSetValueOnDevice = 1 << bitPosSetValueOnDevice, // SetValue() call has a buffer that is already on the device
+    matrixFlagMayOutgrowBuffer = 1 << bitPosMayOutgrowBuffer, // with matrixFlagDontOwnBuffer: the matrix is reshaped within the external buffer, and gets an own buffer when resized beyond it
 };
 
 // -----------------------------------------------------------------------
@@ -330,6 +440,7 @@ protected:
     void SetFormat(MatrixFormat format) { m_format = format; }
 
     bool HasExternalBuffer() const { return m_externalBuffer; }
+    bool MayOutgrowExternalBuffer() const { return m_mayOutgrowExternalBuffer; }
 
     DEVICEID_TYPE GetComputeDeviceId() const { return m_computeDevice; }
     void SetComputeDeviceId(const DEVICEID_TYPE computeId) const { m_computeDevice = computeId; }
@@ -347,7 +458,9 @@ protected:
     bool IsEmpty() const { return m_numRows == 0 || m_numCols == 0; }
 
     ElemType* Buffer() const { return m_pArray; }
-    void SetBuffer(ElemType* pArray, size_t alloc, bool external = false) { m_pArray = pArray; m_totalBufferSizeAllocated = alloc; m_externalBuffer = external; }
+    void SetBuffer(ElemType* pArray, size_t alloc, bool external = false, bool mayOutgrow = false) { m_pArray = pArray; m_totalBufferSizeAllocated = alloc; m_externalBuffer = external; m_mayOutgrowExternalBuffer = external && mayOutgrow; m_externalBufferOwner = nullptr; }
+
+    void SetExternalBufferOwner(const shared_ptr<void>& owner) { m_externalBufferOwner = owner; }
 
     size_t BufferSizeAllocated() const { return m_totalBufferSizeAllocated; }
     
@@ -396,6 +509,7 @@ protected:
     void ZeroInit(const MatrixFormat matrixFormat = matrixFormatDense, const DEVICEID_TYPE computeDevice = -1)
     {
         m_externalBuffer           = false;
+        m_mayOutgrowExternalBuffer = false;
         m_format                   = matrixFormat;
         m_computeDevice            = computeDevice;
         m_numRows                  = 0;
@@ -424,6 +538,8 @@ protected:
     MatrixFormat m_format;
     mutable DEVICEID_TYPE m_computeDevice; // current GPU device Id or CPUDEVICE
     bool m_externalBuffer; // is the buffer used by this matrix,
+    bool m_mayOutgrowExternalBuffer; // see matrixFlagMayOutgrowBuffer
+    shared_ptr<void> m_externalBufferOwner; // keeps the external buffer valid while the storage uses it, see BaseMatrix::SetExternalBufferOwner()
 
     // m_numRows and m_numCols should be removed
     size_t m_numRows;
@@ -495,7 +611,7 @@ public:
     {
         if (!m_sob.unique())
             LogicError("%s: Cannot migrate the matrix between devices because it is a view.", function);
-        else if (m_sob->HasExternalBuffer())
+        else if (m_sob->HasExternalBuffer() && !m_sob->MayOutgrowExternalBuffer()) // a matrix may leave its arena slot
             LogicError("%s: Cannot migrate the matrix between devices because it is externally owned.", function);
     }
 
@@ -521,6 +637,15 @@ public:
 
     bool OwnBuffer() const { return !HasExternalBuffer(); }
 
+    // Keeps 'owner' (e.g. the memory mapping of a file) alive for as long as the external buffer is the storage
+    // of this matrix or of any view or reference that shares the storage with it.
+    void SetExternalBufferOwner(const shared_ptr<void>& owner)
+    {
+        if (!m_sob->HasExternalBuffer())
+            LogicError("SetExternalBufferOwner: The matrix does not have an external buffer.");
+        m_sob->SetExternalBufferOwner(owner);
+    }
+
     bool IsEmpty() const { return m_numRows == 0 || m_numCols == 0; }
 
     size_t GetSizeAllocated() const { return m_sob->GetSizeAllocated(); }
@@ -537,6 +662,7 @@ protected:
     void SetFormat(MatrixFormat format) { m_sob->SetFormat(format); }
 
     bool HasExternalBuffer() const { return m_sob->HasExternalBuffer(); }
+    bool MayOutgrowExternalBuffer() const { return m_sob->MayOutgrowExternalBuffer(); }
 
     DEVICEID_TYPE GetComputeDeviceId() const { return m_sob->GetComputeDeviceId(); }
     void SetComputeDeviceId(const DEVICEID_TYPE computeId) const { m_sob->SetComputeDeviceId(computeId); }
@@ -551,7 +677,7 @@ protected:
     void SetSizeAllocated(size_t alloc) { m_sob->SetSizeAllocated(alloc); }
 
     ElemType* Buffer() const { return m_sob->Buffer(); }
-    void SetBuffer(ElemType* parray, size_t alloc, bool external = false) { m_sob->SetBuffer(parray, alloc, external); }
+    void SetBuffer(ElemType* parray, size_t alloc, bool external = false, bool mayOutgrow = false) { m_sob->SetBuffer(parray, alloc, external, mayOutgrow); }
 
     
     size_t GetBlockSize() const { return m_sob->GetBlockSize(); }
@@ -7,6 +7,17 @@
 #include "ConvolutionEngine.h"
 #include "CuDnnFactories.h"
 #include "MklDnnCommon.h"
+#include "CPUMatrix.h"
+#include "fileutil.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <tuple>
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -579,6 +590,8 @@ protected:
     using Base::m_maxTempMemSizeInSamples;
     using Base::m_poolIncludePad;
 
+    using Base::m_pQuantizedMultiplier;
+
     using Base::m_mpRowCol;
     using Base::m_mpRowIwht;
     using Base::m_mpRowRun;
@@ -614,7 +627,7 @@ protected:
     void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
     {
 #ifdef USE_MKL2017DNN
-        if (ForwardCoreMKL(in, kernel, out)) return;
+        if (!m_pQuantizedMultiplier && ForwardCoreMKL(in, kernel, out)) return;
 #endif
 
         size_t batchSize = in.GetNumCols();
@@ -656,7 +669,7 @@ protected:
             {
                 auto outSlice = out.ColumnSlice(start, 1);
                 outSlice.Reshape(mapOutSize, mapCount);
-                Mat::Multiply(unrolledInput, true, kern, false, outSlice);
+                Mat::MultiplyAndWeightedAdd(1, unrolledInput, true, kern, false, 0, outSlice, m_pQuantizedMultiplier);
             }
             else
             {
@@ -667,7 +680,7 @@ protected:
                     outTempSlice = outTempSlice.ColumnSlice(0, curBatchSize * mapCount);
                     outTempSlice.Reshape(mapOutSize * curBatchSize, mapCount);
                 }
-                Mat::Multiply(unrolledInput, true, kern, false, outTempSlice);
+                Mat::MultiplyAndWeightedAdd(1, unrolledInput, true, kern, false, 0, outTempSlice, m_pQuantizedMultiplier);
                 outTempSlice.Reshape(curBatchSize, mapOutSize * mapCount);
                 auto outSlice = out.ColumnSlice(start, curBatchSize);
                 outSlice.AssignTransposeOf(outTempSlice);
@@ -1151,12 +1164,1140 @@ public:
     }
 };
 
+//------------------------------------------------------------------
+// The CPU engines below work on the images directly instead of going through
+// the convolution maps or unrolling the input. They handle 2D convolutions with
+// full sharing, no dilation and feature maps only along the channel axis, where
+// every kernel spans all input channels of its group, so inputs are [W x H x C]
+// and outputs are [W' x H' x K] tensors in CHW layout.
+//------------------------------------------------------------------
+static bool IsPlain2DConvolution(const ConvolveGeometry& geometry)
+{
+    const auto& inT = geometry.InputShape();
+    const auto& kernT = geometry.KernelShape();
+    if (inT.GetRank() != 3 || kernT.GetRank() != 3)
+        return false;
+    if (find(begin(geometry.Sharing()), end(geometry.Sharing()), false) != end(geometry.Sharing()))
+        return false;
+    for (size_t i = 0; i < 3; i++)
+    {
+        if (geometry.GetDilation(i) != 1)
+            return false;
+    }
+    return geometry.GetMapCount(0) == 1 && geometry.GetMapCount(1) == 1 &&
+           kernT[2] * geometry.Groups() == inT[2] && geometry.OutputShape()[2] == geometry.GetMapCount(2);
+}
+
+// Transform matrices of the Winograd minimal filtering algorithm F(m x m, 3 x 3), which computes
+// m x m outputs of a 3x3 convolution from an (m + 2) x (m + 2) input tile:
+// Y = AT * [(G * g * GT) .* (BT * d * B)] * A.
+template <size_t TileSize>
+struct WinogradTransform;
+
+template <>
+struct WinogradTransform<2>
+{
+    static const size_t Alpha = 4;
+    static const float BT[4][4];
+    static const double G[4][3];
+    static const float AT[2][4];
+};
+
+const float WinogradTransform<2>::BT[4][4] =
+{
+    { 1,  0, -1,  0 },
+    { 0,  1,  1,  0 },
+    { 0, -1,  1,  0 },
+    { 0,  1,  0, -1 }
+};
+const double WinogradTransform<2>::G[4][3] =
+{
+    { 1,    0,   0   },
+    { 0.5,  0.5, 0.5 },
+    { 0.5, -0.5, 0.5 },
+    { 0,    0,   1   }
+};
+const float WinogradTransform<2>::AT[2][4] =
+{
+    { 1, 1,  1,  0 },
+    { 0, 1, -1, -1 }
+};
+
+template <>
+struct WinogradTransform<4>
+{
+    static const size_t Alpha = 6;
+    static const float BT[6][6];
+    static const double G[6][3];
+    static const float AT[4][6];
+};
+
+const float WinogradTransform<4>::BT[6][6] =
+{
+    { 4,  0, -5,  0, 1, 0 },
+    { 0, -4, -4,  1, 1, 0 },
+    { 0,  4, -4, -1, 1, 0 },
+    { 0, -2, -1,  2, 1, 0 },
+    { 0,  2, -1, -2, 1, 0 },
+    { 0,  4,  0, -5, 0, 1 }
+};
+const double WinogradTransform<4>::G[6][3] =
+{
+    {  1.0 / 4,  0,         0        },
+    { -1.0 / 6, -1.0 / 6,  -1.0 / 6  },
+    { -1.0 / 6,  1.0 / 6,  -1.0 / 6  },
+    {  1.0 / 24, 1.0 / 12,  1.0 / 6  },
+    {  1.0 / 24, -1.0 / 12, 1.0 / 6  },
+    {  0,        0,         1        }
+};
+const float WinogradTransform<4>::AT[4][6] =
+{
+    { 1, 1,  1, 1,  1, 0 },
+    { 0, 1, -1, 2, -2, 0 },
+    { 0, 1,  1, 4,  4, 0 },
+    { 0, 1, -1, 8, -8, 1 }
+};
+
+//------------------------------------------------------------------
+// Winograd convolution engine implementation.
+// This engine supports 2D 3x3 convolutions with unit stride and full sharing on the CPU
+// and implements them with the minimal filtering algorithms F(2x2,3x3) and F(4x4,3x3)
+// (Fast Algorithms for Convolutional Neural Networks; Lavin, Gray).
+// Input tiles and kernels are transformed so that the convolution becomes Alpha*Alpha
+// independent GEMMs over channels, which needs far less memory traffic than the 9 times
+// larger unrolled input of the GEMM engine.
+// Uses GEMM engine for the kernel gradients and reference engine for pooling operations.
+//------------------------------------------------------------------
+template <class ElemType>
+class WinogradConvolutionEngine : public GemmConvolutionEngine<ElemType>
+{
+public:
+    using Base = GemmConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+public:
+    WinogradConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad)
+    {
+        // F(4x4,3x3) does 4 times fewer multiplications than the direct convolution (F(2x2,3x3): 2.25 times),
+        // but wastes most of its larger tiles on small images.
+        const auto& outT = geometry->OutputShape();
+        m_tileSize = outT[0] >= 8 && outT[1] >= 8 ? 4 : 2;
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_deviceId;
+    using Base::m_imageLayout;
+    using Base::m_maxTempMemSizeInSamples;
+
+    void EnsureCompatible() override
+    {
+        if (m_imageLayout != ImageLayoutKind::CHW)
+            LogicError("Winograd convolution engine supports only CHW/cudnn layout.");
+        if (IsGpu(m_deviceId))
+            LogicError("Winograd convolution engine currently supports only CPU device.");
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
+    {
+        const auto& inT = m_geometry->InputShape();
+        const auto& outT = m_geometry->OutputShape();
+        Convolve(in, inT[0], inT[1], inT[2], m_geometry->GetLowerPad(0), m_geometry->GetLowerPad(1), kernel, /*flipKernel=*/false,
+                 out, outT[0], outT[1], outT[2], 0, workspace);
+    }
+
+    // Gradients of a 3x3 convolution with unit stride w.r.t. its input are a 3x3 convolution with unit stride
+    // of the source gradients, using the spatially flipped kernels with input and output channels swapped.
+    // An input cell at x was seen by the outputs x + lowerPad - 2 .. x + lowerPad, hence the padding of 2 - lowerPad.
+    void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace) override
+    {
+        const auto& inT = m_geometry->InputShape();
+        const auto& outT = m_geometry->OutputShape();
+        Convolve(srcGrad, outT[0], outT[1], outT[2], 2 - m_geometry->GetLowerPad(0), 2 - m_geometry->GetLowerPad(1), kernel, /*flipKernel=*/true,
+                 grad, inT[0], inT[1], inT[2], accumulateGradient ? 1 : 0, workspace);
+    }
+
+    // out = beta * out + convolution of in, where output cell (0, 0) sees the input cells starting at (-padW, -padH).
+    void Convolve(const Mat& in, size_t inW, size_t inH, size_t inC, int padW, int padH, const Mat& kernel, bool flipKernel,
+                  Mat& out, size_t outW, size_t outH, size_t outC, ElemType beta, Mat& workspace)
+    {
+        if (m_tileSize == 4)
+            Convolve<4>(in, inW, inH, inC, padW, padH, kernel, flipKernel, out, outW, outH, outC, beta, workspace);
+        else
+            Convolve<2>(in, inW, inH, inC, padW, padH, kernel, flipKernel, out, outW, outH, outC, beta, workspace);
+    }
+
+    // The convolution is done in 3 steps for every sub-batch, with P being the number of tiles in the sub-batch:
+    // 1. Gathering and transforming input tiles: [WHC x N] -> Alpha*Alpha times [P x C].
+    // 2. Multiplying with the transformed kernels: [P x C] * [C x K] -> [P x K] for each of the Alpha*Alpha tile cells.
+    // 3. Transforming the products back to output tiles and scattering them: Alpha*Alpha times [P x K] -> [W'H'K x N].
+    template <size_t TileSize>
+    void Convolve(const Mat& in, size_t inW, size_t inH, size_t inC, int padW, int padH, const Mat& kernel, bool flipKernel,
+                  Mat& out, size_t outW, size_t outH, size_t outC, ElemType beta, Mat& workspace)
+    {
+        const size_t alpha = WinogradTransform<TileSize>::Alpha;
+        size_t batchSize = in.GetNumCols();
+        size_t subBatchSize = m_maxTempMemSizeInSamples == 0 ? batchSize : min(batchSize, m_maxTempMemSizeInSamples);
+        size_t tilesW = (outW + TileSize - 1) / TileSize;
+        size_t tilesH = (outH + TileSize - 1) / TileSize;
+        size_t maxTileCount = tilesW * tilesH * subBatchSize;
+
+        // Reserve space for:
+        // 1. Transformed kernels.
+        // 2. Transformed input tiles.
+        // 3. Products to be transformed to output tiles.
+        size_t kernCellStride = GetCellStride(inC * outC);
+        size_t tilesOffset = alpha * alpha * kernCellStride;
+        workspace.Resize(1, tilesOffset + alpha * alpha * (GetCellStride(maxTileCount * inC) + GetCellStride(maxTileCount * outC)));
+
+        if (flipKernel)
+            TransformKernel<TileSize>(kernel.Data(), outC, inC, /*flip=*/true, kernCellStride, workspace.Data());
+        else
+            TransformKernel<TileSize>(kernel.Data(), inC, outC, /*flip=*/false, kernCellStride, workspace.Data());
+
+        for (size_t start = 0; start < batchSize; start += subBatchSize)
+        {
+            size_t curBatchSize = min(subBatchSize, batchSize - start);
+            size_t tileCount = tilesW * tilesH * curBatchSize;
+            size_t tilesCellStride = GetCellStride(tileCount * inC);
+            size_t productsCellStride = GetCellStride(tileCount * outC);
+            size_t productsOffset = tilesOffset + alpha * alpha * tilesCellStride;
+
+            TransformInput<TileSize>(in.Data() + start * in.GetNumRows(), curBatchSize, inW, inH, inC, padW, padH, tilesW, tilesH,
+                                     tilesCellStride, workspace.Data() + tilesOffset);
+
+            for (size_t cell = 0; cell < alpha * alpha; cell++)
+            {
+                auto tiles = workspace.ColumnSlice(tilesOffset + cell * tilesCellStride, tileCount * inC);
+                tiles.Reshape(tileCount, inC);
+                auto kern = workspace.ColumnSlice(cell * kernCellStride, inC * outC);
+                kern.Reshape(inC, outC);
+                auto products = workspace.ColumnSlice(productsOffset + cell * productsCellStride, tileCount * outC);
+                products.Reshape(tileCount, outC);
+                Mat::MultiplyAndWeightedAdd(1, tiles, false, kern, false, 0, products);
+            }
+
+            TransformOutput<TileSize>(workspace.Data() + productsOffset, curBatchSize, outW, outH, outC, tilesW, tilesH, beta,
+                                      productsCellStride, out.Data() + start * out.GetNumRows());
+        }
+    }
+
+    // The transforms read or write all Alpha*Alpha cells of a tile at once. Cells that are a multiple of the page size apart
+    // map to the same cache sets and evict each other, so the size of a cell is padded to avoid that.
+    static size_t GetCellStride(size_t cellSize)
+    {
+        const size_t cacheLine = 64 / sizeof(ElemType);
+        size_t stride = (cellSize + cacheLine - 1) / cacheLine * cacheLine;
+        return (stride * sizeof(ElemType)) % 4096 == 0 ? stride + cacheLine : stride;
+    }
+
+    // Transforms the 3x3 kernels of K maps over C channels: cell i of the transformed tile is the column-major [C x K] matrix at u + i * cellStride.
+    // With flip, the kernels are spatially flipped and the matrices are [K x C] instead.
+    // Blocks of kernels along a column are transformed together, which vectorizes and writes whole cache lines.
+    template <size_t TileSize>
+    static void TransformKernel(const ElemType* kernel, size_t mapInCount, size_t mapOutCount, bool flip, size_t cellStride, ElemType* u)
+    {
+        using Transform = WinogradTransform<TileSize>;
+        const size_t alpha = Transform::Alpha;
+        const size_t blockSize = 16;
+        size_t rows = flip ? mapOutCount : mapInCount;
+        size_t cols = flip ? mapInCount : mapOutCount;
+#pragma omp parallel for
+        for (int64_t col = 0; col < (int64_t)cols; col++)
+        {
+            for (size_t row0 = 0; row0 < rows; row0 += blockSize)
+            {
+                size_t count = min(blockSize, rows - row0);
+                ElemType w[3][3][blockSize];
+                for (size_t r = 0; r < count; r++)
+                {
+                    size_t k = flip ? row0 + r : col;
+                    size_t c = flip ? col : row0 + r;
+                    // cudnn layout uses row-major kernel weight matrix, i.e. kernels of the maps are contiguous.
+                    const ElemType* g = kernel + (k * mapInCount + c) * 9;
+                    for (size_t i = 0; i < 3; i++)
+                        for (size_t j = 0; j < 3; j++)
+                            w[i][j][r] = flip ? g[(2 - i) * 3 + 2 - j] : g[i * 3 + j];
+                }
+
+                ElemType t[alpha][3][blockSize];
+                for (size_t i = 0; i < alpha; i++)
+                {
+                    for (size_t j = 0; j < 3; j++)
+                    {
+                        for (size_t r = 0; r < count; r++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < 3; l++)
+                                sum += (ElemType)Transform::G[i][l] * w[l][j][r];
+                            t[i][j][r] = sum;
+                        }
+                    }
+                }
+                for (size_t i = 0; i < alpha; i++)
+                {
+                    for (size_t j = 0; j < alpha; j++)
+                    {
+                        ElemType* dst = u + (i * alpha + j) * cellStride + row0 + col * rows;
+                        for (size_t r = 0; r < count; r++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < 3; l++)
+                                sum += t[i][l][r] * (ElemType)Transform::G[j][l];
+                            dst[r] = sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Gathers the input tiles of all samples with zero padding and transforms them: cell i of the transformed
+    // tiles is the column-major [P x C] matrix at v + i * cellStride, where P = batchSize * tilesH * tilesW.
+    template <size_t TileSize>
+    static void TransformInput(const ElemType* in, size_t batchSize, size_t inW, size_t inH, size_t inC, int padW, int padH,
+                               size_t tilesW, size_t tilesH, size_t cellStride, ElemType* v)
+    {
+        using Transform = WinogradTransform<TileSize>;
+        const size_t alpha = Transform::Alpha;
+        size_t tileCount = batchSize * tilesH * tilesW;
+#pragma omp parallel for
+        for (int64_t plane = 0; plane < (int64_t)(batchSize * inC); plane++)
+        {
+            size_t sample = plane / inC;
+            size_t c = plane % inC;
+            const ElemType* src = in + plane * inW * inH;
+            for (size_t th = 0; th < tilesH; th++)
+            {
+                for (size_t tw = 0; tw < tilesW; tw++)
+                {
+                    int y0 = (int)(th * TileSize) - padH;
+                    int x0 = (int)(tw * TileSize) - padW;
+                    ElemType d[alpha][alpha];
+                    if (y0 >= 0 && x0 >= 0 && y0 + alpha <= inH && x0 + alpha <= inW)
+                    {
+                        for (size_t i = 0; i < alpha; i++)
+                            for (size_t j = 0; j < alpha; j++)
+                                d[i][j] = src[(y0 + i) * inW + x0 + j];
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < alpha; i++)
+                        {
+                            for (size_t j = 0; j < alpha; j++)
+                            {
+                                int y = y0 + (int)i;
+                                int x = x0 + (int)j;
+                                d[i][j] = (y >= 0 && x >= 0 && y < (int)inH && x < (int)inW) ? src[y * inW + x] : 0;
+                            }
+                        }
+                    }
+
+                    ElemType t[alpha][alpha];
+                    for (size_t i = 0; i < alpha; i++)
+                    {
+                        for (size_t j = 0; j < alpha; j++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < alpha; l++)
+                                sum += (ElemType)Transform::BT[i][l] * d[l][j];
+                            t[i][j] = sum;
+                        }
+                    }
+                    ElemType* dst = v + c * tileCount + (sample * tilesH + th) * tilesW + tw;
+                    for (size_t i = 0; i < alpha; i++)
+                    {
+                        for (size_t j = 0; j < alpha; j++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < alpha; l++)
+                                sum += t[i][l] * (ElemType)Transform::BT[j][l];
+                            dst[(i * alpha + j) * cellStride] = sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Transforms the products back to output tiles and writes out = beta * out + tile, cropping the tiles at the image border.
+    template <size_t TileSize>
+    static void TransformOutput(const ElemType* m, size_t batchSize, size_t outW, size_t outH, size_t outC,
+                                size_t tilesW, size_t tilesH, ElemType beta, size_t cellStride, ElemType* out)
+    {
+        using Transform = WinogradTransform<TileSize>;
+        const size_t alpha = Transform::Alpha;
+        size_t tileCount = batchSize * tilesH * tilesW;
+#pragma omp parallel for
+        for (int64_t plane = 0; plane < (int64_t)(batchSize * outC); plane++)
+        {
+            size_t sample = plane / outC;
+            size_t k = plane % outC;
+            ElemType* dst = out + plane * outW * outH;
+            for (size_t th = 0; th < tilesH; th++)
+            {
+                for (size_t tw = 0; tw < tilesW; tw++)
+                {
+                    const ElemType* src = m + k * tileCount + (sample * tilesH + th) * tilesW + tw;
+                    ElemType t[TileSize][alpha];
+                    for (size_t i = 0; i < TileSize; i++)
+                    {
+                        for (size_t j = 0; j < alpha; j++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < alpha; l++)
+                                sum += (ElemType)Transform::AT[i][l] * src[(l * alpha + j) * cellStride];
+                            t[i][j] = sum;
+                        }
+                    }
+                    size_t rows = min(TileSize, outH - th * TileSize);
+                    size_t cols = min(TileSize, outW - tw * TileSize);
+                    for (size_t i = 0; i < rows; i++)
+                    {
+                        ElemType* row = dst + (th * TileSize + i) * outW + tw * TileSize;
+                        for (size_t j = 0; j < cols; j++)
+                        {
+                            ElemType sum = 0;
+                            for (size_t l = 0; l < alpha; l++)
+                                sum += t[i][l] * (ElemType)Transform::AT[j][l];
+                            row[j] = beta == 0 ? sum : beta * row[j] + sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry)
+    {
+        const auto& kernT = geometry->KernelShape();
+        return deviceId < 0 && geometry->Groups() == 1 && IsPlain2DConvolution(*geometry) &&
+               kernT[0] == 3 && kernT[1] == 3 && geometry->GetStride(0) == 1 && geometry->GetStride(1) == 1;
+    }
+
+private:
+    size_t m_tileSize;
+};
+
+//------------------------------------------------------------------
+// Direct convolution engine implementation.
+// This engine supports 2D pointwise (1x1) and depthwise (one input channel per group)
+// convolutions on the CPU without unrolling the input:
+// a 1x1 convolution of a [W x H x C] image in CHW layout is a [WH x C] * [C x K] GEMM on the image itself,
+// and a depthwise convolution is computed plane by plane and output row by output row,
+// so that the row that all kernel taps are accumulated into stays in L1 cache.
+// Does not support pooling operations.
+//------------------------------------------------------------------
+template <class ElemType>
+class DirectConvolutionEngine : public ConvolutionEngine<ElemType>
+{
+public:
+    using Base = ConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+public:
+    DirectConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad)
+    {
+        const auto& inT = geometry->InputShape();
+        const auto& outT = geometry->OutputShape();
+        const auto& kernT = geometry->KernelShape();
+        m_inW = inT[0]; m_inH = inT[1]; m_inC = inT[2];
+        m_outW = outT[0]; m_outH = outT[1]; m_outC = outT[2];
+        m_kernW = kernT[0]; m_kernH = kernT[1];
+        m_strideW = (int)geometry->GetStride(0); m_strideH = (int)geometry->GetStride(1);
+        m_padW = geometry->GetLowerPad(0); m_padH = geometry->GetLowerPad(1);
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_deviceId;
+    using Base::m_imageLayout;
+
+    void EnsureCompatible() override
+    {
+        if (m_imageLayout != ImageLayoutKind::CHW)
+            LogicError("Direct convolution engine supports only CHW/cudnn layout.");
+        if (IsGpu(m_deviceId))
+            LogicError("Direct convolution engine currently supports only CPU device.");
+        if (!IsSupported(m_deviceId, m_geometry))
+            LogicError("Direct convolution engine supports only 1x1 and depthwise convolutions. Geometry: %s", ((string)*m_geometry).c_str());
+    }
+
+    void EnsureConvolutionInitialized() override
+    {
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
+    {
+        if (IsDepthwise())
+            DepthwiseForward(in.Data(), in.GetNumCols(), kernel.Data(), out.Data());
+        else
+            PointwiseForward(in, kernel, out, workspace);
+    }
+
+    void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace) override
+    {
+        if (IsDepthwise())
+            DepthwiseBackwardData(srcGrad.Data(), srcGrad.GetNumCols(), kernel.Data(), grad.Data(), accumulateGradient);
+        else
+            PointwiseBackwardData(srcGrad, kernel, grad, accumulateGradient, workspace);
+    }
+
+    void BackwardKernelCore(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool accumulateGradient, bool /*allowReuse*/, Mat& workspace) override
+    {
+        if (IsDepthwise())
+            DepthwiseBackwardKernel(srcGrad.Data(), in.Data(), in.GetNumCols(), kernelGrad.Data(), accumulateGradient);
+        else
+            PointwiseBackwardKernel(srcGrad, in, kernelGrad, accumulateGradient, workspace);
+    }
+
+    void EnsurePoolingInitialized() override
+    {
+    }
+
+    void ForwardPoolingCore(const Mat& /*in*/, Mat& /*out*/) override
+    {
+        LogicError("Direct convolution engine does not support pooling.");
+    }
+
+    void BackwardPoolingCore(const Mat& /*out*/, const Mat& /*srcGrad*/, const Mat& /*in*/, Mat& /*grad*/, bool /*accumulateGradient*/) override
+    {
+        LogicError("Direct convolution engine does not support pooling.");
+    }
+
+    void MaxUnpoolingCore(const Mat& /*out*/, const Mat& /*poolIn*/, Mat& /*in*/) override
+    {
+        LogicError("Direct convolution engine does not support pooling.");
+    }
+
+    bool IsDepthwise() const { return m_geometry->Groups() > 1; }
+
+    // Whether the output pixels of a 1x1 convolution are exactly the input pixels.
+    bool IsIdentityMapping() const
+    {
+        return m_strideW == 1 && m_strideH == 1 && m_padW == 0 && m_padH == 0 && m_outW == m_inW && m_outH == m_inH;
+    }
+
+    // Range [first, last) of outputs along an axis whose kernel tap at offset 'tap' falls into the input.
+    static void GetValidOutputRange(int tap, int pad, int stride, size_t inSize, size_t outSize, int& first, int& last)
+    {
+        int lo = pad - tap;
+        int hi = (int)inSize - 1 + pad - tap;
+        first = lo > 0 ? (lo + stride - 1) / stride : 0;
+        last = hi < 0 ? 0 : min((int)outSize, hi / stride + 1);
+    }
+
+    // The pointwise convolution multiplies each sample as [W'H' x C] matrix with the [C x K] kernel matrix.
+    // With strides or padding, the input pixels that the outputs see are gathered into a [W'H' x C] workspace first.
+    void PointwiseForward(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace)
+    {
+        size_t outPixels = m_outW * m_outH;
+        // cudnn layout uses row-major kernel weight matrix.
+        auto kern = kernel.ColumnSlice(0, kernel.GetNumCols());
+        kern.Reshape(m_inC, m_outC);
+        if (!IsIdentityMapping())
+            workspace.Resize(outPixels, m_inC);
+
+        for (size_t sample = 0; sample < in.GetNumCols(); sample++)
+        {
+            auto inSlice = in.ColumnSlice(sample, 1);
+            if (IsIdentityMapping())
+                inSlice.Reshape(outPixels, m_inC);
+            else
+            {
+                GatherPixels(inSlice.Data(), workspace.Data());
+                inSlice = workspace.ColumnSlice(0, m_inC);
+            }
+            auto outSlice = out.ColumnSlice(sample, 1);
+            outSlice.Reshape(outPixels, m_outC);
+            Mat::MultiplyAndWeightedAdd(1, inSlice, false, kern, false, 0, outSlice);
+        }
+    }
+
+    void PointwiseBackwardData(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace)
+    {
+        size_t outPixels = m_outW * m_outH;
+        auto kern = kernel.ColumnSlice(0, kernel.GetNumCols());
+        kern.Reshape(m_inC, m_outC);
+        if (!IsIdentityMapping())
+            workspace.Resize(outPixels, m_inC);
+
+        for (size_t sample = 0; sample < srcGrad.GetNumCols(); sample++)
+        {
+            auto srcGradSlice = srcGrad.ColumnSlice(sample, 1);
+            srcGradSlice.Reshape(outPixels, m_outC);
+            auto gradSlice = grad.ColumnSlice(sample, 1);
+            if (IsIdentityMapping())
+            {
+                gradSlice.Reshape(outPixels, m_inC);
+                Mat::MultiplyAndWeightedAdd(1, srcGradSlice, false, kern, true, accumulateGradient ? 1 : 0, gradSlice);
+            }
+            else
+            {
+                Mat::MultiplyAndWeightedAdd(1, srcGradSlice, false, kern, true, 0, workspace);
+                if (!accumulateGradient)
+                    gradSlice.SetValue(0);
+                ScatterAddPixels(workspace.Data(), gradSlice.Data());
+            }
+        }
+    }
+
+    void PointwiseBackwardKernel(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool accumulateGradient, Mat& workspace)
+    {
+        size_t outPixels = m_outW * m_outH;
+        auto kernGrad = kernelGrad.ColumnSlice(0, kernelGrad.GetNumCols());
+        kernGrad.Reshape(m_inC, m_outC);
+        if (!IsIdentityMapping())
+            workspace.Resize(outPixels, m_inC);
+
+        for (size_t sample = 0; sample < in.GetNumCols(); sample++)
+        {
+            auto inSlice = in.ColumnSlice(sample, 1);
+            if (IsIdentityMapping())
+                inSlice.Reshape(outPixels, m_inC);
+            else
+            {
+                GatherPixels(inSlice.Data(), workspace.Data());
+                inSlice = workspace.ColumnSlice(0, m_inC);
+            }
+            auto srcGradSlice = srcGrad.ColumnSlice(sample, 1);
+            srcGradSlice.Reshape(outPixels, m_outC);
+            Mat::MultiplyAndWeightedAdd(1, inSlice, true, srcGradSlice, false, sample > 0 || accumulateGradient ? 1 : 0, kernGrad);
+        }
+    }
+
+    // Copies the input pixels seen by the 1x1 kernels of a sample into a [W'H' x C] matrix, with zeros for padding.
+    void GatherPixels(const ElemType* in, ElemType* dst) const
+    {
+#pragma omp parallel for
+        for (int64_t c = 0; c < (int64_t)m_inC; c++)
+        {
+            const ElemType* src = in + c * m_inW * m_inH;
+            ElemType* dstPlane = dst + c * m_outW * m_outH;
+            for (size_t oy = 0; oy < m_outH; oy++)
+            {
+                int y = (int)oy * m_strideH - m_padH;
+                for (size_t ox = 0; ox < m_outW; ox++)
+                {
+                    int x = (int)ox * m_strideW - m_padW;
+                    bool inside = y >= 0 && y < (int)m_inH && x >= 0 && x < (int)m_inW;
+                    dstPlane[oy * m_outW + ox] = inside ? src[y * m_inW + x] : 0;
+                }
+            }
+        }
+    }
+
+    // Adds a [W'H' x C] matrix of pixel gradients to the input pixels that the 1x1 kernels see.
+    void ScatterAddPixels(const ElemType* src, ElemType* grad) const
+    {
+#pragma omp parallel for
+        for (int64_t c = 0; c < (int64_t)m_inC; c++)
+        {
+            const ElemType* srcPlane = src + c * m_outW * m_outH;
+            ElemType* dst = grad + c * m_inW * m_inH;
+            for (size_t oy = 0; oy < m_outH; oy++)
+            {
+                int y = (int)oy * m_strideH - m_padH;
+                if (y < 0 || y >= (int)m_inH)
+                    continue;
+                for (size_t ox = 0; ox < m_outW; ox++)
+                {
+                    int x = (int)ox * m_strideW - m_padW;
+                    if (x >= 0 && x < (int)m_inW)
+                        dst[y * m_inW + x] += srcPlane[oy * m_outW + ox];
+                }
+            }
+        }
+    }
+
+    // In a depthwise convolution output map k sees input channel k / (K / C) only.
+    void DepthwiseForward(const ElemType* in, size_t batchSize, const ElemType* kernel, ElemType* out) const
+    {
+        size_t multiplier = m_outC / m_inC;
+#pragma omp parallel for
+        for (int64_t plane = 0; plane < (int64_t)(batchSize * m_outC); plane++)
+        {
+            size_t sample = plane / m_outC;
+            size_t k = plane % m_outC;
+            const ElemType* src = in + (sample * m_inC + k / multiplier) * m_inW * m_inH;
+            const ElemType* kern = kernel + k * m_kernW * m_kernH;
+            ElemType* dst = out + plane * m_outW * m_outH;
+            for (size_t oy = 0; oy < m_outH; oy++)
+            {
+                ElemType* row = dst + oy * m_outW;
+                std::fill(row, row + m_outW, (ElemType)0);
+                for (size_t i = 0; i < m_kernH; i++)
+                {
+                    int y = (int)oy * m_strideH - m_padH + (int)i;
+                    if (y < 0 || y >= (int)m_inH)
+                        continue;
+                    const ElemType* srcRow = src + y * m_inW;
+                    for (size_t j = 0; j < m_kernW; j++)
+                    {
+                        int first, last;
+                        GetValidOutputRange((int)j, m_padW, m_strideW, m_inW, m_outW, first, last);
+                        int offset = (int)j - m_padW;
+                        ElemType w = kern[i * m_kernW + j];
+                        if (m_strideW == 1)
+                        {
+                            for (int ox = first; ox < last; ox++)
+                                row[ox] += w * srcRow[ox + offset];
+                        }
+                        else
+                        {
+                            for (int ox = first; ox < last; ox++)
+                                row[ox] += w * srcRow[ox * m_strideW + offset];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void DepthwiseBackwardData(const ElemType* srcGrad, size_t batchSize, const ElemType* kernel, ElemType* grad, bool accumulateGradient) const
+    {
+        size_t multiplier = m_outC / m_inC;
+#pragma omp parallel for
+        for (int64_t plane = 0; plane < (int64_t)(batchSize * m_inC); plane++)
+        {
+            size_t sample = plane / m_inC;
+            size_t c = plane % m_inC;
+            ElemType* dst = grad + plane * m_inW * m_inH;
+            if (!accumulateGradient)
+                std::fill(dst, dst + m_inW * m_inH, (ElemType)0);
+            for (size_t k = c * multiplier; k < (c + 1) * multiplier; k++)
+            {
+                const ElemType* src = srcGrad + (sample * m_outC + k) * m_outW * m_outH;
+                const ElemType* kern = kernel + k * m_kernW * m_kernH;
+                for (size_t oy = 0; oy < m_outH; oy++)
+                {
+                    const ElemType* srcRow = src + oy * m_outW;
+                    for (size_t i = 0; i < m_kernH; i++)
+                    {
+                        int y = (int)oy * m_strideH - m_padH + (int)i;
+                        if (y < 0 || y >= (int)m_inH)
+                            continue;
+                        ElemType* dstRow = dst + y * m_inW;
+                        for (size_t j = 0; j < m_kernW; j++)
+                        {
+                            int first, last;
+                            GetValidOutputRange((int)j, m_padW, m_strideW, m_inW, m_outW, first, last);
+                            int offset = (int)j - m_padW;
+                            ElemType w = kern[i * m_kernW + j];
+                            for (int ox = first; ox < last; ox++)
+                                dstRow[ox * m_strideW + offset] += w * srcRow[ox];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void DepthwiseBackwardKernel(const ElemType* srcGrad, const ElemType* in, size_t batchSize, ElemType* kernelGrad, bool accumulateGradient) const
+    {
+        size_t multiplier = m_outC / m_inC;
+#pragma omp parallel for
+        for (int64_t k = 0; k < (int64_t)m_outC; k++)
+        {
+            ElemType* dst = kernelGrad + k * m_kernW * m_kernH;
+            if (!accumulateGradient)
+                std::fill(dst, dst + m_kernW * m_kernH, (ElemType)0);
+            for (size_t sample = 0; sample < batchSize; sample++)
+            {
+                const ElemType* src = srcGrad + (sample * m_outC + k) * m_outW * m_outH;
+                const ElemType* inPlane = in + (sample * m_inC + k / multiplier) * m_inW * m_inH;
+                for (size_t i = 0; i < m_kernH; i++)
+                {
+                    for (size_t j = 0; j < m_kernW; j++)
+                    {
+                        int first, last;
+                        GetValidOutputRange((int)j, m_padW, m_strideW, m_inW, m_outW, first, last);
+                        int offset = (int)j - m_padW;
+                        ElemType sum = 0;
+                        for (size_t oy = 0; oy < m_outH; oy++)
+                        {
+                            int y = (int)oy * m_strideH - m_padH + (int)i;
+                            if (y < 0 || y >= (int)m_inH)
+                                continue;
+                            const ElemType* srcRow = src + oy * m_outW;
+                            const ElemType* inRow = inPlane + y * m_inW;
+                            for (int ox = first; ox < last; ox++)
+                                sum += srcRow[ox] * inRow[ox * m_strideW + offset];
+                        }
+                        dst[i * m_kernW + j] += sum;
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    static bool IsSupported(DEVICEID_TYPE deviceId, ConvolveGeometryPtr geometry)
+    {
+        if (deviceId >= 0 || !IsPlain2DConvolution(*geometry))
+            return false;
+        const auto& kernT = geometry->KernelShape();
+        if (geometry->Groups() == 1)
+            return kernT[0] == 1 && kernT[1] == 1;
+        // Depthwise: groups == C, each map sees one input channel.
+        return kernT[2] == 1;
+    }
+
+private:
+    size_t m_inW, m_inH, m_inC;
+    size_t m_outW, m_outH, m_outC;
+    size_t m_kernW, m_kernH;
+    int m_strideW, m_strideH;
+    int m_padW, m_padH;
+};
+
+//------------------------------------------------------------------
+// Autotuner state and cache file.
+// Each line of the cache file is: CPU signature, key, engine, maxTempMemSizeInSamples, time in milliseconds, separated by tabs.
+//------------------------------------------------------------------
+struct AutotuneDecision
+{
+    ConvolutionEngineKind kind;
+    size_t maxTempMemSizeInSamples;
+};
+
+struct AutotunerState
+{
+    std::mutex mutex;
+    std::atomic<bool> enabled{false};
+    std::wstring cacheFilePath;
+    std::map<std::string, AutotuneDecision> decisions;
+};
+
+static AutotunerState& GetAutotunerState()
+{
+    static AutotunerState state;
+    return state;
+}
+
+static const std::pair<ConvolutionEngineKind, const char*> s_autotunedEngineNames[] =
+{
+    { ConvolutionEngineKind::Reference, "Reference" },
+    { ConvolutionEngineKind::Gemm, "Gemm" },
+    { ConvolutionEngineKind::Winograd, "Winograd" },
+    { ConvolutionEngineKind::Direct, "Direct" },
+};
+
+static const char* AutotunedEngineName(ConvolutionEngineKind kind)
+{
+    for (const auto& e : s_autotunedEngineNames)
+    {
+        if (e.first == kind)
+            return e.second;
+    }
+    LogicError("Convolution engine kind %d cannot be autotuned.", (int)kind);
+}
+
+std::string ConvolutionEngineAutotuner::CpuSignature()
+{
+    char brand[49] = {};
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((unsigned int)regs[0] >= 0x80000004)
+    {
+        for (int i = 0; i < 3; i++)
+            __cpuid((int*)(brand + 16 * i), 0x80000002 + i);
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned int* regs = (unsigned int*)brand;
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+    {
+        for (unsigned int i = 0; i < 3; i++)
+            __get_cpuid(0x80000002 + i, regs + 4 * i, regs + 4 * i + 1, regs + 4 * i + 2, regs + 4 * i + 3);
+    }
+#endif
+    std::string model = brand;
+    // The brand string is padded with spaces.
+    model.erase(0, model.find_first_not_of(' '));
+    model.erase(model.find_last_not_of(' ') + 1);
+    if (model.empty())
+        model = "unknown CPU";
+    return msra::strfun::strprintf("%s, %d threads", model.c_str(), CPUMatrix<float>::GetMaxNumThreads());
+}
+
+void ConvolutionEngineAutotuner::Enable(const std::wstring& cacheFilePath)
+{
+    auto& state = GetAutotunerState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.decisions.clear();
+    state.cacheFilePath = cacheFilePath;
+    if (!cacheFilePath.empty() && fexists(cacheFilePath))
+    {
+        auto signature = CpuSignature();
+        FILE* f = fopenOrDie(cacheFilePath, L"r");
+        while (!feof(f))
+        {
+            auto fields = msra::strfun::split(fgetline(f), "\t");
+            if (fields.size() < 4 || fields[0] != signature)
+                continue;
+            for (const auto& e : s_autotunedEngineNames)
+            {
+                // Later lines win, the file may have been appended to by several runs.
+                if (fields[2] == e.second)
+                    state.decisions[fields[1]] = AutotuneDecision{ e.first, (size_t)std::stoull(fields[3]) };
+            }
+        }
+        fcloseOrDie(f);
+        if (GetMathLibTraceLevel() > 0)
+            fprintf(stderr, "Loaded %d convolution autotuning decisions from '%ls'.\n", (int)state.decisions.size(), cacheFilePath.c_str());
+    }
+    state.enabled = true;
+}
+
+void ConvolutionEngineAutotuner::Disable()
+{
+    GetAutotunerState().enabled = false;
+}
+
+bool ConvolutionEngineAutotuner::IsEnabled()
+{
+    return GetAutotunerState().enabled;
+}
+
+bool ConvolutionEngineAutotuner::Lookup(const std::string& key, ConvolutionEngineKind& kind, size_t& maxTempMemSizeInSamples)
+{
+    auto& state = GetAutotunerState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto iter = state.decisions.find(key);
+    if (iter == state.decisions.end())
+        return false;
+    kind = iter->second.kind;
+    maxTempMemSizeInSamples = iter->second.maxTempMemSizeInSamples;
+    return true;
+}
+
+void ConvolutionEngineAutotuner::Store(const std::string& key, ConvolutionEngineKind kind, size_t maxTempMemSizeInSamples, double milliseconds)
+{
+    auto& state = GetAutotunerState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.decisions[key] = AutotuneDecision{ kind, maxTempMemSizeInSamples };
+    if (state.cacheFilePath.empty())
+        return;
+    FILE* f = fopenOrDie(state.cacheFilePath, L"a");
+    fprintfOrDie(f, "%s\t%s\t%s\t%d\t%.3f\n", CpuSignature().c_str(), key.c_str(), AutotunedEngineName(kind), (int)maxTempMemSizeInSamples, milliseconds);
+    fcloseOrDie(f);
+}
+
+//------------------------------------------------------------------
+// Autotuned convolution engine implementation.
+// Owns one CPU engine per candidate (engine kind and maxTempMemSizeInSamples) and, for each operation and
+// minibatch-size bucket (the next power of two), either takes the decision known to ConvolutionEngineAutotuner or
+// times all candidates on the minibatch at hand and records the fastest.
+// Candidates run on a scratch output while tuning, so accumulation into the real output happens only once.
+// Does not support pooling operations.
+//------------------------------------------------------------------
+template <class ElemType>
+class AutotunedConvolutionEngine : public ConvolutionEngine<ElemType>
+{
+public:
+    using Base = ConvolutionEngine<ElemType>;
+    using typename Base::Mat;
+
+    struct Candidate
+    {
+        ConvolutionEngineKind kind;
+        size_t maxTempMemSizeInSamples;
+        std::unique_ptr<ConvolutionEngine<ElemType>> engine;
+    };
+
+public:
+    AutotunedConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples,
+                               std::vector<Candidate>&& candidates, const std::wstring& logPrefix)
+        : Base(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, PoolKind::None),
+        m_candidateEngines(GetCandidateEngines(candidates)), m_candidates(std::move(candidates)), m_logPrefix(logPrefix)
+    {
+        assert(m_candidates.size() > 1);
+    }
+
+protected:
+    using Base::m_geometry;
+    using Base::m_deviceId;
+    using Base::m_imageLayout;
+    using Base::m_maxTempMemSizeInSamples;
+    using Base::m_pQuantizedMultiplier;
+
+    enum Operation { ForwardOp, BackwardDataOp, BackwardKernelOp };
+    enum Precision { FullPrecision, Int16Precision, Int8Precision };
+
+    void EnsureCompatible() override
+    {
+        if (m_imageLayout != ImageLayoutKind::CHW)
+            LogicError("Autotuned convolution engine supports only CHW/cudnn layout.");
+        if (m_deviceId >= 0)
+            LogicError("Autotuned convolution engine supports only CPU device.");
+    }
+
+    void EnsureConvolutionInitialized() override
+    {
+    }
+
+    void ForwardCore(const Mat& in, const Mat& kernel, Mat& out, Mat& workspace) override
+    {
+        // Forward overwrites the output, so the candidates can be timed on it directly.
+        auto& engine = Select(ForwardOp, in.GetNumCols(), [&](ConvolutionEngine<ElemType>& candidate)
+        {
+            candidate.SetQuantizedMultiplier(m_pQuantizedMultiplier);
+            candidate.Forward(in, kernel, out, workspace);
+        });
+        engine.SetQuantizedMultiplier(m_pQuantizedMultiplier);
+        engine.Forward(in, kernel, out, workspace);
+    }
+
+    void BackwardDataCore(const Mat& srcGrad, const Mat& kernel, Mat& grad, bool accumulateGradient, Mat& workspace) override
+    {
+        auto& engine = Select(BackwardDataOp, srcGrad.GetNumCols(), [&](ConvolutionEngine<ElemType>& candidate)
+        {
+            EnsureScratch(grad);
+            candidate.BackwardData(srcGrad, kernel, *m_scratch, false, workspace);
+        });
+        engine.BackwardData(srcGrad, kernel, grad, accumulateGradient, workspace);
+    }
+
+    void BackwardKernelCore(const Mat& srcGrad, const Mat& in, Mat& kernelGrad, bool accumulateGradient, bool allowReuse, Mat& workspace) override
+    {
+        auto& engine = Select(BackwardKernelOp, srcGrad.GetNumCols(), [&](ConvolutionEngine<ElemType>& candidate)
+        {
+            EnsureScratch(kernelGrad);
+            candidate.BackwardKernel(srcGrad, in, *m_scratch, false, allowReuse, workspace);
+        });
+        engine.BackwardKernel(srcGrad, in, kernelGrad, accumulateGradient, allowReuse, workspace);
+    }
+
+    void EnsurePoolingInitialized() override
+    {
+    }
+
+    void ForwardPoolingCore(const Mat&, Mat&) override
+    {
+        LogicError("Autotuned convolution engine does not support pooling.");
+    }
+
+    void BackwardPoolingCore(const Mat&, const Mat&, const Mat&, Mat&, bool) override
+    {
+        LogicError("Autotuned convolution engine does not support pooling.");
+    }
+
+    void MaxUnpoolingCore(const Mat&, const Mat&, Mat&) override
+    {
+        LogicError("Autotuned convolution engine does not support pooling.");
+    }
+
+private:
+    // The engines among the candidates. A decision only applies to engines with the same candidates; e.g. quantized
+    // engines have no Winograd and direct candidates, and must not reuse or overwrite the decisions made with them.
+    static ConvolutionEngineKind GetCandidateEngines(const std::vector<Candidate>& candidates)
+    {
+        int engines = 0;
+        for (const auto& candidate : candidates)
+            engines |= (int)candidate.kind;
+        return (ConvolutionEngineKind)engines;
+    }
+
+    static size_t GetBucket(size_t batchSize)
+    {
+        size_t bucket = 1;
+        while (bucket < batchSize)
+            bucket *= 2;
+        return bucket;
+    }
+
+    // Precision of the products of the operation; only the forward pass runs quantized.
+    Precision GetPrecision(Operation op) const
+    {
+        if (op != ForwardOp || !m_pQuantizedMultiplier)
+            return FullPrecision;
+        return dynamic_cast<Int8QuantizedMultiplier<ElemType>*>(m_pQuantizedMultiplier.get()) ? Int8Precision : Int16Precision;
+    }
+
+    std::string GetKey(Operation op, size_t bucket, Precision precision) const
+    {
+        static const char* opNames[] = { "forward", "backwardData", "backwardKernel" };
+        static const char* precisionNames[] = { "", " int16", " int8" };
+        return msra::strfun::strprintf("%s%s %s minibatch %d maxTempMem %d engines %d %s",
+                                       sizeof(ElemType) == sizeof(float) ? "float" : "double", precisionNames[precision], opNames[op], (int)bucket,
+                                       (int)m_maxTempMemSizeInSamples, (int)m_candidateEngines, ((std::string)*m_geometry).c_str());
+    }
+
+    void EnsureScratch(const Mat& like)
+    {
+        if (!m_scratch)
+            m_scratch = std::make_unique<Mat>(m_deviceId);
+        m_scratch->Resize(like.GetNumRows(), like.GetNumCols());
+    }
+
+    template <class RunCandidate>
+    ConvolutionEngine<ElemType>& Select(Operation op, size_t batchSize, RunCandidate runCandidate)
+    {
+        size_t bucket = GetBucket(batchSize);
+        Precision precision = GetPrecision(op);
+        auto selected = m_selected.find(std::make_tuple(op, bucket, precision));
+        if (selected != m_selected.end())
+            return *m_candidates[selected->second].engine;
+
+        auto key = GetKey(op, bucket, precision);
+        size_t best = m_candidates.size();
+        ConvolutionEngineKind kind;
+        size_t maxTempMem;
+        if (ConvolutionEngineAutotuner::Lookup(key, kind, maxTempMem))
+        {
+            for (size_t i = 0; i < m_candidates.size(); i++)
+            {
+                if (m_candidates[i].kind == kind && m_candidates[i].maxTempMemSizeInSamples == maxTempMem)
+                    best = i;
+            }
+        }
+        if (best == m_candidates.size())
+        {
+            // Each candidate runs once to allocate its workspace and warm up, and is timed on the second run.
+            double bestTime = std::numeric_limits<double>::max();
+            for (size_t i = 0; i < m_candidates.size(); i++)
+            {
+                runCandidate(*m_candidates[i].engine);
+                auto start = std::chrono::high_resolution_clock::now();
+                runCandidate(*m_candidates[i].engine);
+                double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                if (GetMathLibTraceLevel() > 0)
+                    fprintf(stderr, "%lsautotuning %s: %s engine, maxTempMemSizeInSamples %d: %.3f ms.\n", m_logPrefix.c_str(), key.c_str(),
+                            AutotunedEngineName(m_candidates[i].kind), (int)m_candidates[i].maxTempMemSizeInSamples, time);
+                if (time < bestTime)
+                {
+                    bestTime = time;
+                    best = i;
+                }
+            }
+            ConvolutionEngineAutotuner::Store(key, m_candidates[best].kind, m_candidates[best].maxTempMemSizeInSamples, bestTime);
+            m_scratch.reset();
+        }
+        if (GetMathLibTraceLevel() > 0)
+            fprintf(stderr, "%lsusing %s convolution engine with maxTempMemSizeInSamples %d for %s.\n", m_logPrefix.c_str(),
+                    AutotunedEngineName(m_candidates[best].kind), (int)m_candidates[best].maxTempMemSizeInSamples, key.c_str());
+        m_selected[std::make_tuple(op, bucket, precision)] = best;
+        return *m_candidates[best].engine;
+    }
+
+private:
+    ConvolutionEngineKind m_candidateEngines;
+    std::vector<Candidate> m_candidates;
+    std::wstring m_logPrefix;
+    std::map<std::tuple<Operation, size_t, Precision>, size_t> m_selected; // (operation, minibatch-size bucket, precision) -> index into m_candidates
+    std::unique_ptr<Mat> m_scratch;
+};
+
 template <class ElemType>
 std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId,
                                                                                  ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind,
                                                                                  ConvolutionEngineKind enabledEngines, std::wstring logPrefix,
                                                                                  bool forceDeterministicAlgorithms, bool poolIncludePad,
-                                                                                 bool inputHasFreeDimension)
+                                                                                 bool inputHasFreeDimension, bool quantized)
 {
     if (!logPrefix.empty())
         logPrefix += L": ";
@@ -1189,8 +2330,76 @@ std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create
                                                                forceDeterministicAlgorithms, poolIncludePad, inputHasFreeDimension);
     }
 
+    // With autotuning, every CPU engine that supports the geometry is a candidate, the engines that unroll
+    // into a workspace also with smaller maxTempMemSizeInSamples. The fixed order below is used if there is only one.
+    // Only the GEMM-based engines run quantized products, so the Winograd and direct engines are skipped if quantized.
+    if (ConvolutionEngineAutotuner::IsEnabled() && deviceId < 0 && poolKind == PoolKind::None &&
+        (geometry->Groups() == 1 || geometry->InputShape().GetRank() < 4))
+    {
+        std::vector<size_t> maxTempMemOptions = { maxTempMemSizeInSamples };
+        for (size_t maxTempMem : { 1, 4, 16 })
+        {
+            if (maxTempMemSizeInSamples == 0 || maxTempMem < maxTempMemSizeInSamples)
+                maxTempMemOptions.push_back(maxTempMem);
+        }
+
+        std::vector<typename AutotunedConvolutionEngine<ElemType>::Candidate> candidates;
+        auto addCandidates = [&](ConvolutionEngineKind kind, const std::vector<size_t>& maxTempMems, std::function<ConvolutionEngine<ElemType>*(size_t)> create)
+        {
+            for (size_t maxTempMem : maxTempMems)
+                candidates.push_back({ kind, maxTempMem, std::unique_ptr<ConvolutionEngine<ElemType>>(create(maxTempMem)) });
+        };
+        if (!quantized && isEnabled(ConvolutionEngineKind::Winograd) && WinogradConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+        {
+            addCandidates(ConvolutionEngineKind::Winograd, maxTempMemOptions, [&](size_t maxTempMem)
+            {
+                return new WinogradConvolutionEngine<ElemType>(geometry, deviceId, imageLayout, maxTempMem, poolKind, poolIncludePad);
+            });
+        }
+        if (!quantized && isEnabled(ConvolutionEngineKind::Direct) && DirectConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+        {
+            // The direct engine does not use maxTempMemSizeInSamples.
+            addCandidates(ConvolutionEngineKind::Direct, { maxTempMemSizeInSamples }, [&](size_t maxTempMem)
+            {
+                return new DirectConvolutionEngine<ElemType>(geometry, deviceId, imageLayout, maxTempMem, poolKind, poolIncludePad);
+            });
+        }
+        if (isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry) &&
+            (geometry->Groups() == 1 || GemmConvolutionEngine<ElemType>::IsMklEnabled()))
+        {
+            addCandidates(ConvolutionEngineKind::Gemm, maxTempMemOptions, [&](size_t maxTempMem)
+            {
+                return new GemmConvolutionEngine<ElemType>(geometry, deviceId, imageLayout, maxTempMem, poolKind, poolIncludePad);
+            });
+        }
+        if (candidates.size() > 1)
+        {
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsusing autotuned convolution engine with %d candidates for geometry: %s.\n", logPrefix.c_str(), (int)candidates.size(), engStr.c_str());
+
+            return std::make_unique<AutotunedConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples,
+                                                                           std::move(candidates), logPrefix);
+        }
+    }
+
     if (geometry->Groups() == 1)
     {
+        if (!quantized && poolKind == PoolKind::None && isEnabled(ConvolutionEngineKind::Winograd) && WinogradConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+        {
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsusing Winograd convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+            return std::make_unique<WinogradConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad);
+        }
+
+        if (!quantized && poolKind == PoolKind::None && isEnabled(ConvolutionEngineKind::Direct) && DirectConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+        {
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsusing direct convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+            return std::make_unique<DirectConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad);
+        }
+
         if (isEnabled(ConvolutionEngineKind::Gemm) && GemmConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
         {
             if (GetMathLibTraceLevel() > 0)
@@ -1213,6 +2422,14 @@ std::unique_ptr<ConvolutionEngine<ElemType>> ConvolutionEngine<ElemType>::Create
         {
             RuntimeError("Group convolution, i.e. groups > 1, for 3-dimensional convolution or higher is not supported on the CPU. Please use GPU, if possible.");
         }
+        // Depthwise convolution does not need MKL.
+        if (!quantized && poolKind == PoolKind::None && isEnabled(ConvolutionEngineKind::Direct) && DirectConvolutionEngine<ElemType>::IsSupported(deviceId, geometry))
+        {
+            if (GetMathLibTraceLevel() > 0)
+                fprintf(stderr, "%lsusing direct convolution engine for geometry: %s.\n", logPrefix.c_str(), engStr.c_str());
+
+            return std::make_unique<DirectConvolutionEngine<ElemType>>(geometry, deviceId, imageLayout, maxTempMemSizeInSamples, poolKind, poolIncludePad);
+        }
         // For group convolution, MKL 2017 is required. If it is not enabled, we throw an error.
         if (GemmConvolutionEngine<ElemType>::IsMklEnabled())
         {
@@ -1237,7 +2454,7 @@ std::unique_ptr<ConvolutionEngine<half>> ConvolutionEngine<half>::Create(Convolv
     ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind,
     ConvolutionEngineKind enabledEngines, std::wstring logPrefix,
     bool forceDeterministicAlgorithms, bool poolIncludePad,
-    bool inputHasFreeDimension)
+    bool inputHasFreeDimension, bool /*quantized*/)
 {
     if (!logPrefix.empty())
         logPrefix += L": ";
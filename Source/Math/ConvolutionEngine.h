@@ -22,8 +22,10 @@ enum class ConvolutionEngineKind
     CuDnn     = 1 << 1, // cuDNN, works only for 2D/3D convos with full sharing.
     Legacy    = 1 << 2, // Legacy, for backwards compatibility. REVIEW alexeyk: implement sparse version and remove Legacy altogether.
     Gemm      = 1 << 3, // Uses convolution unrolling+GEMM technique. Works only for convos with full sharing.
+    Winograd  = 1 << 4, // Winograd F(2x2,3x3)/F(4x4,3x3), CPU only. Works only for 2D 3x3 convos with unit stride and full sharing.
+    Direct    = 1 << 5, // Direct convolution without unrolling, CPU only. Works only for 2D 1x1 and depthwise convos with full sharing.
 
-    All       = Reference | CuDnn | Legacy | Gemm
+    All       = Reference | CuDnn | Legacy | Gemm | Winograd | Direct
 };
 
 enum class PoolKind
@@ -33,6 +35,29 @@ enum class PoolKind
     Average
 };
 
+//-------------------------------------------------------------
+// Autotuning of the CPU convolution engines.
+// When enabled, Create() returns an engine that times every CPU engine supporting the geometry (and a few
+// maxTempMemSizeInSamples values for the engines that unroll into a workspace) on the first minibatch of each
+// minibatch-size bucket, separately for forward, backward data and backward kernel, and keeps the fastest.
+// Decisions are shared within the process and, if a cache file is given, appended to it together with the
+// CPU model, so that later runs on the same machine start with the best engines without tuning again.
+//-------------------------------------------------------------
+class MATH_API ConvolutionEngineAutotuner
+{
+public:
+    // Loads the decisions found in cacheFilePath for this CPU; new decisions are appended to it. An empty path keeps them in memory only.
+    static void Enable(const std::wstring& cacheFilePath = L"");
+    static void Disable();
+    static bool IsEnabled();
+
+    // CPU model and number of threads, the decisions in the cache file are only used for the same signature.
+    static std::string CpuSignature();
+
+    static bool Lookup(const std::string& key, ConvolutionEngineKind& kind, size_t& maxTempMemSizeInSamples);
+    static void Store(const std::string& key, ConvolutionEngineKind kind, size_t maxTempMemSizeInSamples, double milliseconds);
+};
+
 #pragma warning(push)
 #pragma warning(disable : 4251)
 
@@ -63,7 +88,8 @@ public:
                                                                ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind = PoolKind::None,
                                                                ConvolutionEngineKind enabledEngines = ConvolutionEngineKind::All,
                                                                std::wstring logPrefix = L"", bool forceDeterministicAlgorithms = false,
-                                                               bool poolIncludePad = false, bool inputHasFreeDimension = false);
+                                                               bool poolIncludePad = false, bool inputHasFreeDimension = false,
+                                                               bool quantized = false);
 
     DISABLE_COPY_AND_MOVE(ConvolutionEngine);
 
@@ -75,6 +101,12 @@ public:
 
     virtual bool ImplementsGradientOverwriteOptimization() const { return false; }
 
+    // Quantized product to use for the forward pass, for engines that are based on GEMM (null to use full precision).
+    void SetQuantizedMultiplier(const shared_ptr<QuantizedMultiplier<ElemType>>& pQuantizedMultiplier)
+    {
+        m_pQuantizedMultiplier = pQuantizedMultiplier;
+    }
+
 protected:
     ConvolutionEngine(ConvolveGeometryPtr geometry, DEVICEID_TYPE deviceId, ImageLayoutKind imageLayout, size_t maxTempMemSizeInSamples, PoolKind poolKind, bool poolIncludePad = false)
         : m_geometry(geometry), m_deviceId(deviceId), m_imageLayout(imageLayout), m_maxTempMemSizeInSamples(maxTempMemSizeInSamples), m_poolKind(poolKind), m_poolIncludePad(poolIncludePad)
@@ -107,6 +139,7 @@ protected:
     size_t m_maxTempMemSizeInSamples;
     PoolKind m_poolKind;
     bool m_poolIncludePad;
+    shared_ptr<QuantizedMultiplier<ElemType>> m_pQuantizedMultiplier;
 };
 
 #pragma warning(pop)
@@ -1238,13 +1238,13 @@ void GPUMatrix<ElemType>::SetValue(const size_t numRows, const size_t numCols, i
     if (matrixFlags & matrixFlagDontOwnBuffer)
     {
         // free the existing array if it used to be an owned array
-        if ( Buffer() != NULL)
+        if (Buffer() != NULL && OwnBuffer())
         {
             TracingGPUMemoryAllocator::Free<ElemType>(GetComputeDeviceId(), Buffer());
         }
         m_numRows = numRows;
         m_numCols = numCols;
-        SetBuffer(pArray, GetNumElements() * sizeof(ElemType), true);
+        SetBuffer(pArray, GetNumElements() * sizeof(ElemType), true, (matrixFlags & matrixFlagMayOutgrowBuffer) != 0);
         SetSizeAllocated(GetNumElements());
         SetFormat(matrixFormatDense);
         SetComputeDeviceId(deviceId);
@@ -1689,9 +1689,24 @@ void GPUMatrix<ElemType>::Resize(const size_t numRows, const size_t numCols, boo
     if (GetNumRows() == numRows && GetNumCols() == numCols)
         return;
 
+    size_t numElements = numRows * numCols;
+
+    // A slot of a memory arena is reshaped in place while it is large enough, otherwise the matrix leaves it.
+    if (HasExternalBuffer() && MayOutgrowExternalBuffer() && m_sob.unique())
+    {
+        if (numElements <= GetSizeAllocated())
+        {
+            m_sliceViewOffset = 0;
+            m_numRows = numRows;
+            m_numCols = numCols;
+            return;
+        }
+        SetBuffer(nullptr, 0); // not ours to free
+        SetSizeAllocated(0);
+    }
+
     VerifyResizable(__FUNCTION__);
 
-    size_t numElements = numRows * numCols;
     if (numElements > GetSizeAllocated() ||                     // grow allocation
         (!growOnly && numElements != GetSizeAllocated()))   // shrink allocation if not growOnly
     {
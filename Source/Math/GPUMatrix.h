@@ -133,6 +133,7 @@ class MATH_API GPUMatrix : public BaseMatrix<ElemType>
     using Base::m_numCols;
     using Base::m_sliceViewOffset;
     using Base::HasExternalBuffer;
+    using Base::MayOutgrowExternalBuffer;
     using Base::SetBuffer;
     using Base::SetComputeDeviceId;
     using Base::ZeroInit;
@@ -674,9 +675,7 @@ public:
 
         stream << us.m_numRows << us.m_numCols;
         ElemType* pArray = us.CopyToArray();
-        for (size_t i = 0; i < us.GetNumElements(); ++i)
-            stream << pArray[i];
-        
+        stream.PutArray(pArray, us.GetNumElements());
         delete[] pArray;
 
         stream.PutMarker(fileMarkerEndSection, std::wstring(L"EMAT"));
@@ -1326,12 +1326,28 @@ static void CopyToVector(const Matrix<ElemType>& source, vector<ElemType>& sourc
     assert(datap == sourceData.data() && datasz == sourceData.size()); // (make sure it used my buffer; a somewhat awkward API)
 }
 
+template <class DstT, class SrcT>
+static void ConvertBuffer(DstT* dst, const SrcT* src, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = (DstT)src[i];
+}
+
 template<>
 void Matrix<int>::AssignValuesOf(const Matrix<int>&) { NOT_IMPLEMENTED; }
 template<class ElemType, class ElemTypeOther>
 static void DoCastAssignValuesOf(Matrix<ElemType>& target, const Matrix<ElemTypeOther>& source)
 {
-    target; source;
+    // dense CPU matrices of the same size are converted in place, e.g. between half parameters and their
+    // float master copy in mixed-precision training; half <-> float uses the ConvertBuffer() of half.hpp
+    if (source.GetMatrixType() == MatrixType::DENSE && target.GetMatrixType() == MatrixType::DENSE &&
+        source.GetDeviceId() == CPUDEVICE && target.GetDeviceId() == CPUDEVICE &&
+        source.GetNumRows() == target.GetNumRows() && source.GetNumCols() == target.GetNumCols() && !source.IsEmpty())
+    {
+        ConvertBuffer(target.Data(), source.Data(), source.GetNumElements());
+        return;
+    }
+
     // this is implemented in a rather tedious way:
     //  - copy to a CPU-side STL vector
     //  - type-cast
@@ -1798,7 +1814,8 @@ ElemType Matrix<ElemType>::Adagrad(Matrix<ElemType>& gradients, const bool needA
 //  - the model itself
 template <class ElemType>
 void Matrix<ElemType>::FSAdagradUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>& functionValues, const double targetAdagradAvDenom_x_sqrtAdagradSqrFrames,
-                                       const double learnRatePerSample, const double meanMomentum, const double varMomentum, ElemType unitGainFactor)
+                                       const double learnRatePerSample, const double meanMomentum, const double varMomentum, ElemType unitGainFactor,
+                                       int* timestamps, int currentTimestamp)
 {
     DISPATCH_MATRIX_ON_FLAG(&gradients, &gradients,
         {
@@ -1813,7 +1830,12 @@ void Matrix<ElemType>::FSAdagradUpdate(Matrix<ElemType>& gradients, Matrix<ElemT
                                    (ElemType)targetAdagradAvDenom_x_sqrtAdagradSqrFrames, unitGainFactor);
             SetDataLocation(GPU);
         },
-        { NOT_IMPLEMENTED; },
+        {
+            gradients.m_CPUSparseMatrix->FSAdagrad(*m_CPUMatrix, *functionValues.m_CPUMatrix,
+                                                   (ElemType)learnRatePerSample, (ElemType)meanMomentum, (ElemType)varMomentum,
+                                                   (ElemType)targetAdagradAvDenom_x_sqrtAdagradSqrFrames, unitGainFactor, timestamps, currentTimestamp);
+            SetDataLocation(CPU);
+        },
         {
             gradients.m_GPUSparseMatrix->FSAdagrad(*m_GPUMatrix, *functionValues.m_GPUMatrix,
                                                    (ElemType)learnRatePerSample, (ElemType)meanMomentum, (ElemType)varMomentum,
@@ -1834,7 +1856,8 @@ void Matrix<ElemType>::FSAdagradUpdate(Matrix<ElemType>& gradients, Matrix<ElemT
 // varMomentum - /beta_2
 template <class ElemType>
 void Matrix<ElemType>::AdamUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>& functionValues, const double smoothedCount,
-    const double learnRatePerSample, const double meanMomentum, const double varMomentum, const double epsilon, ElemType unitGainFactor, bool adamax)
+    const double learnRatePerSample, const double meanMomentum, const double varMomentum, const double epsilon, ElemType unitGainFactor, bool adamax,
+    int* timestamps, int currentTimestamp)
 {
     // Bias correction
     let biasCorrection = adamax? (ElemType)(1. / (1- pow(meanMomentum, smoothedCount))) : (ElemType)(sqrt(1- pow(varMomentum, smoothedCount))/(1- pow(meanMomentum, smoothedCount)));
@@ -1852,7 +1875,12 @@ void Matrix<ElemType>::AdamUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>&
         biasCorrection, (ElemType)epsilon, unitGainFactor, adamax);
         SetDataLocation(GPU);
     },
-    { NOT_IMPLEMENTED; },
+    {
+        gradients.m_CPUSparseMatrix->Adam(*m_CPUMatrix, *functionValues.m_CPUMatrix,
+        (ElemType)learnRatePerSample, (ElemType)meanMomentum, (ElemType)varMomentum,
+        biasCorrection, (ElemType)epsilon, unitGainFactor, adamax, timestamps, currentTimestamp);
+        SetDataLocation(CPU);
+    },
     { gradients.m_GPUSparseMatrix->Adam(*m_GPUMatrix, *functionValues.m_GPUMatrix,
         (ElemType)learnRatePerSample, (ElemType)meanMomentum,
         (ElemType)varMomentum, biasCorrection, (ElemType)epsilon, unitGainFactor, adamax);
@@ -1869,14 +1897,15 @@ ElemType Matrix<ElemType>::RmsProp(Matrix<ElemType>& gradients,
                                    ElemType RMS_WGT_DEC,
                                    ElemType RMS_WGT_MIN,
                                    const bool needAveMultiplier,
-                                   const bool initialized)
+                                   const bool initialized,
+                                   int* timestamps, int currentTimestamp)
 {
     DecideAndMoveToRightDevice(*this, gradients);
 
     DISPATCH_MATRIX_ON_FLAG(&gradients, &gradients,
         { auto ret = m_CPUMatrix->RmsProp(*gradients.m_CPUMatrix, RMS_GAMMA, RMS_WGT_INC, RMS_WGT_MAX, RMS_WGT_DEC, RMS_WGT_MIN, needAveMultiplier, initialized); SetDataLocation(CPU); return ret; },
         { auto ret = m_GPUMatrix->RmsProp(*gradients.m_GPUMatrix, RMS_GAMMA, RMS_WGT_INC, RMS_WGT_MAX, RMS_WGT_DEC, RMS_WGT_MIN, needAveMultiplier, initialized); SetDataLocation(GPU); return ret; },
-        { NOT_IMPLEMENTED; },
+        { auto ret = gradients.m_CPUSparseMatrix->RmsProp(*m_CPUMatrix, RMS_GAMMA, RMS_WGT_INC, RMS_WGT_MAX, RMS_WGT_DEC, RMS_WGT_MIN, needAveMultiplier, initialized, timestamps, currentTimestamp); SetDataLocation(CPU); return ret; },
         { auto ret = gradients.m_GPUSparseMatrix->RmsProp(*m_GPUMatrix, RMS_GAMMA, RMS_WGT_INC, RMS_WGT_MAX, RMS_WGT_DEC, RMS_WGT_MIN, needAveMultiplier, initialized); SetDataLocation(GPU); return ret; });
     // Note: Since both 'this' and gradients are changed, we must call SetDataLocation() on 'this' as well.
 }
@@ -1909,6 +1938,40 @@ void Matrix<ElemType>::AdaDeltaFlushState(size_t cols, ElemType rho, int* timest
     { NOT_IMPLEMENTED; });
 }
 
+template <class ElemType>
+void Matrix<ElemType>::LazyUpdateFlushState(size_t cols, const std::vector<ElemType>& decays, const std::vector<ElemType>& floors, int* timestamps, int currentTimestamp)
+{
+    DecideAndMoveToRightDevice(*this, *this);
+
+    DISPATCH_MATRIX_ON_FLAG(this, this,
+    { m_CPUMatrix->LazyUpdateFlushTimestamps(cols, decays, floors, timestamps, currentTimestamp); SetDataLocation(CPU); },
+    { NOT_IMPLEMENTED; }, // GPU sparse gradients are applied to all columns
+    { NOT_IMPLEMENTED; },
+    { NOT_IMPLEMENTED; });
+}
+
+template <class ElemType>
+/*static*/ void Matrix<ElemType>::FusedLearnerUpdate(const FusedLearnerStep& step, const vector<Matrix<ElemType>*>& parameters,
+                                                    const vector<Matrix<ElemType>*>& gradients, const vector<Matrix<ElemType>*>& smoothedGradients)
+{
+    if (parameters.size() != gradients.size() || parameters.size() != smoothedGradients.size())
+        LogicError("FusedLearnerUpdate: There must be one gradient and one smoothed gradient per parameter.");
+
+    auto AsCPUMatrices = [](const vector<Matrix<ElemType>*>& matrices)
+    {
+        vector<CPUMatrix<ElemType>*> cpuMatrices;
+        for (auto m : matrices)
+        {
+            if (m->GetDeviceId() != CPUDEVICE || m->GetMatrixType() != DENSE)
+                LogicError("FusedLearnerUpdate: Only dense matrices on the CPU are supported.");
+            cpuMatrices.push_back(m->m_CPUMatrix.get());
+        }
+        return cpuMatrices;
+    };
+
+    CPUMatrix<ElemType>::FusedLearnerUpdate(step, AsCPUMatrices(parameters), AsCPUMatrices(gradients), AsCPUMatrices(smoothedGradients));
+}
+
 template <class ElemType>
 void Matrix<ElemType>::Reshape(const size_t numRows, const size_t numCols)
 {
@@ -5037,7 +5100,7 @@ void Matrix<ElemType>::RNNForward(const Matrix<ElemType> &inputX, const Matrix<E
 
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNForward(*(inputX.m_CPUMatrix), *(paramW.m_CPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNForward(*(inputX.m_GPUMatrix), *(paramW.m_GPUMatrix), xDim, yDim, numSequencesForFrame, rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -5052,7 +5115,7 @@ void Matrix<ElemType>::RNNBackwardData(const Matrix<ElemType>& outputDY, const M
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardData(*(outputDY.m_CPUMatrix), *(paramW.m_CPUMatrix), *(outputDX.m_CPUMatrix), rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardData(*(outputDY.m_GPUMatrix), *(paramW.m_GPUMatrix), *(outputDX.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -5067,7 +5130,7 @@ void Matrix<ElemType>::RNNBackwardWeights(const Matrix<ElemType>& inputX, const
     workspace._transferToDevice(GetDeviceId());
     DISPATCH_MATRIX_ON_FLAG(this,
                             this,
-                            NOT_IMPLEMENTED,
+                            m_CPUMatrix->RNNBackwardWeights(*(inputX.m_CPUMatrix), *(outputY.m_CPUMatrix), *(dw.m_CPUMatrix), rnnAttributes, *(reserve.m_CPUMatrix), *(workspace.m_CPUMatrix)),
                             m_GPUMatrix->RNNBackwardWeights(*(inputX.m_GPUMatrix), *(outputY.m_GPUMatrix), *(dw.m_GPUMatrix), rnnAttributes, *(reserve.m_GPUMatrix), *(workspace.m_GPUMatrix)),
                             NOT_IMPLEMENTED,
                             NOT_IMPLEMENTED);
@@ -5889,6 +5952,25 @@ size_t Matrix<ElemType>::CountNanInf() const
     return n;
 }
 
+template <class ElemType>
+bool Matrix<ElemType>::HasNanOrInf() const
+{
+    if (IsEmpty())
+        return false;
+
+    if (GetDeviceId() == CPUDEVICE && GetMatrixType() == MatrixType::DENSE)
+        return m_CPUMatrix->HasNanOrInf();
+
+    // otherwise NaN and Inf show in the sum; half is summed in float, as the sum of finite values may exceed its range
+    if (std::is_same<ElemType, half>::value && GetMatrixType() == MatrixType::DENSE)
+    {
+        Matrix<float> temp(GetNumRows(), GetNumCols(), GetDeviceId());
+        temp.CastAssignValuesOf(*this);
+        return !std::isfinite(temp.SumOfElements());
+    }
+    return !std::isfinite((double)SumOfElements());
+}
+
 // TODO: these are scalar operations--why are they in Matrix?
 template <class ElemType>
 ElemType Matrix<ElemType>::Exp10(ElemType num)
@@ -6316,6 +6398,30 @@ void Matrix<ElemType>::TensorArgOp(const Matrix<ElemType>& a, ElementWiseOperato
         NOT_IMPLEMENTED);
 }
 
+template <class ElemType>
+/*static*/ void Matrix<ElemType>::FusedTensorOp(const FusedElementwiseProgram& program, const vector<const Matrix<ElemType>*>& inputs, const Matrix<ElemType>* outputGradient,
+                                               const vector<Matrix<ElemType>*>& results, const vector<ElemType>& betas, ElemType alpha,
+                                               const vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const vector<SmallVector<ptrdiff_t>>& regularStrides)
+{
+    auto AsCPUMatrix = [](const Matrix<ElemType>* m) -> CPUMatrix<ElemType>*
+    {
+        if (!m)
+            return nullptr;
+        if (m->GetDeviceId() != CPUDEVICE || m->GetMatrixType() != DENSE)
+            LogicError("FusedTensorOp: Only dense matrices on the CPU are supported.");
+        return m->m_CPUMatrix.get();
+    };
+
+    vector<const CPUMatrix<ElemType>*> cpuInputs;
+    for (auto input : inputs)
+        cpuInputs.push_back(AsCPUMatrix(input));
+    vector<CPUMatrix<ElemType>*> cpuResults;
+    for (auto result : results)
+        cpuResults.push_back(AsCPUMatrix(result));
+
+    CPUMatrix<ElemType>::FusedTensorOp(program, cpuInputs, AsCPUMatrix(outputGradient), cpuResults, betas, alpha, offsets, regularOpDims, regularStrides);
+}
+
 //template class Matrix<short>;
 template class Matrix<float>;
 template class Matrix<double>;
@@ -165,6 +165,8 @@ public:
     MatrixType GetMatrixType() const override;
     MatrixFormat GetFormat() const override;
     bool OwnBuffer() const { return m_baseMatrix->OwnBuffer(); }
+    // Keeps 'owner' alive while the external buffer of the matrix is in use, see BaseMatrix::SetExternalBufferOwner().
+    void SetExternalBufferOwner(const std::shared_ptr<void>& owner) { m_baseMatrix->SetExternalBufferOwner(owner); }
     int GetDeviceId() const; // -1 if CPU, otherwise GPU CUDA device id
     DEVICEID_TYPE GetPreferredDeviceId() const { return m_preferredDeviceId; }; // -1 if CPU, otherwise GPU CUDA device id
     void SetPreferredDeviceId(DEVICEID_TYPE preferredDeviceId) { m_preferredDeviceId = preferredDeviceId; }
@@ -212,18 +214,29 @@ public:
     void NesterovAcceleratedMomentumSGDUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>& smoothedGradients, ElemType learnRatePerSample, ElemType momentum, ElemType unitGainFactor);
 
     ElemType Adagrad(Matrix<ElemType>& gradients, const bool needAveMultiplier);
+    // The timestamps are needed for sparse gradients on the CPU, which only update the columns they touch, see CPUSparseMatrix::Adam().
     void FSAdagradUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>& functionValues, const double targetAdagradAvDenom_x_sqrtAdagradSqrFrames,
-                         const double learnRatePerSample, const double meanMomentum, const double varMomentum, ElemType unitGainFactor);
+                         const double learnRatePerSample, const double meanMomentum, const double varMomentum, ElemType unitGainFactor,
+                         int* timestamps = nullptr, int currentTimestamp = 0);
 
     void AdamUpdate(Matrix<ElemType>& gradients, Matrix<ElemType>& functionValues, const double smoothedCount,
-        const double learnRatePerSample, const double meanMomentum, const double varMomentum, const double epsilon, ElemType unitGainFactor, bool adamax = false);
+        const double learnRatePerSample, const double meanMomentum, const double varMomentum, const double epsilon, ElemType unitGainFactor, bool adamax = false,
+        int* timestamps = nullptr, int currentTimestamp = 0);
 
-    ElemType RmsProp(Matrix<ElemType>& gradients, ElemType RMS_GAMMA, ElemType RMS_WGT_INC, ElemType RMS_WGT_MAX, ElemType RMS_WGT_DEC, ElemType RMS_WGT_MIN, const bool needAveMultiplier, const bool initialized);
+    ElemType RmsProp(Matrix<ElemType>& gradients, ElemType RMS_GAMMA, ElemType RMS_WGT_INC, ElemType RMS_WGT_MAX, ElemType RMS_WGT_DEC, ElemType RMS_WGT_MIN, const bool needAveMultiplier, const bool initialized,
+                     int* timestamps = nullptr, int currentTimestamp = 0);
 
     template<typename GradType>
     void AdaDeltaUpdate(Matrix<GradType>& gradients, Matrix<ElemType>& functionvalues, ElemType learningRatePerSample, ElemType rho, ElemType epsilon, int* timestamps, int currentTimestamp);
 
     void AdaDeltaFlushState(size_t stride, ElemType rho, int* timestamps, int currentTimestamp);
+    void LazyUpdateFlushState(size_t stride, const std::vector<ElemType>& decays, const std::vector<ElemType>& floors, int* timestamps, int currentTimestamp);
+
+    // One learner update of many parameters in a single pass over their values, gradients and smoothed gradients (dense CPU matrices only).
+    // Both the gradients and the smoothed gradients are overwritten. The smoothed gradients have the layout of the optimizer's own update
+    // function, e.g. two columns per parameter column for Adam; see FusedLearnerStep for what is computed.
+    static void FusedLearnerUpdate(const FusedLearnerStep& step, const std::vector<Matrix<ElemType>*>& parameters,
+                                   const std::vector<Matrix<ElemType>*>& gradients, const std::vector<Matrix<ElemType>*>& smoothedGradients);
 
     void Resize(const size_t numRows, const size_t numCols, const size_t numNZElemToReserve = 10000, bool growOnly = true, bool keepValue = false); // by default we only reallocate if need to grow
     void Resize(const Matrix<ElemType>& other) // TODO: Should this carry over numNZElemToReserve for sparse matrices?
@@ -519,6 +532,7 @@ public:
 
     bool HasNan(const char* name) const;
     size_t CountNanInf() const;
+    bool HasNanOrInf() const; // fast check, e.g. for overflowing gradients
 
     void Print(const char* matrixName, ptrdiff_t rowFirst, ptrdiff_t rowLast, ptrdiff_t colFirst, ptrdiff_t colLast) const;
     void Print(const char* matrixName = nullptr) const; // print whole matrix. can be expensive
@@ -659,6 +673,13 @@ public:
                      const SmallVector<size_t>& regularOpDims, const std::array<SmallVector<ptrdiff_t>, 2>& regularStrides,
                      const SmallVector<size_t>& reducingOpDims, const std::array<SmallVector<ptrdiff_t>, 2>& reducingStrides);
 
+    // fused elementwise ops (dense CPU matrices only), see TensorView::DoFusedElementwiseOf()
+    // Without 'outputGradient', results[0] = betas[0] * results[0] + alpha * program(inputs); otherwise 'results' are the input gradients.
+    // Operands (offsets and strides) are the inputs, then the output gradient if any, then the results.
+    static void FusedTensorOp(const FusedElementwiseProgram& program, const std::vector<const Matrix<ElemType>*>& inputs, const Matrix<ElemType>* outputGradient,
+                              const std::vector<Matrix<ElemType>*>& results, const std::vector<ElemType>& betas, ElemType alpha,
+                              const std::vector<size_t>& offsets, const SmallVector<size_t>& regularOpDims, const std::vector<SmallVector<ptrdiff_t>>& regularStrides);
+
 public:
     void Read(File& stream);
     void Write(File& stream) const;
@@ -0,0 +1,288 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+// QuantizedOperations.cpp -- int8 quantization and int8 x int8 -> int32 matrix product kernels.
+//
+
+#include "stdafx.h"
+#include "QuantizedOperations.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// -----------------------------------------------------------------------
+// quantization
+// Each row gets the symmetric scale absMax / 127; values are rounded to the nearest integer, halves away from zero,
+// in the scalar and the vectorized code alike.
+// -----------------------------------------------------------------------
+
+template <class ElemType>
+static void QuantizeRow(const ElemType* row, size_t rowLength, ptrdiff_t colStep, int8_t* quantized, float& scale)
+{
+    ElemType absoluteMax = 0;
+    for (size_t l = 0; l < rowLength; l++)
+        absoluteMax = std::max(absoluteMax, std::abs(row[l * colStep]));
+
+    scale = (float)absoluteMax / 127;
+    if (absoluteMax == 0)
+        return; // whole row is 0
+
+    ElemType quantizeFactor = 127 / absoluteMax;
+    for (size_t l = 0; l < rowLength; l++)
+    {
+        ElemType v = row[l * colStep] * quantizeFactor;
+        quantized[l] = (int8_t)std::max(-127, std::min(127, (int)(v + (v >= 0 ? 0.5f : -0.5f))));
+    }
+}
+
+#if defined(__AVX2__)
+
+// contiguous float rows, the common case of activations
+static void QuantizeRowAVX2(const float* row, size_t rowLength, int8_t* quantized, float& scale)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 absMax8 = _mm256_setzero_ps();
+    size_t l = 0;
+    for (; l + 8 <= rowLength; l += 8)
+        absMax8 = _mm256_max_ps(absMax8, _mm256_and_ps(_mm256_loadu_ps(row + l), absMask));
+    __m128 absMax4 = _mm_max_ps(_mm256_castps256_ps128(absMax8), _mm256_extractf128_ps(absMax8, 1));
+    absMax4 = _mm_max_ps(absMax4, _mm_movehl_ps(absMax4, absMax4));
+    absMax4 = _mm_max_ss(absMax4, _mm_shuffle_ps(absMax4, absMax4, 1));
+    float absoluteMax = _mm_cvtss_f32(absMax4);
+    for (; l < rowLength; l++)
+        absoluteMax = std::max(absoluteMax, std::fabs(row[l]));
+
+    scale = absoluteMax / 127;
+    if (absoluteMax == 0)
+        return; // whole row is 0
+
+    // 32 values at a time: round to int32 and pack with saturation to int8;
+    // the packs work within 128-bit lanes, which the final permutation undoes
+    const float quantizeFactor = 127 / absoluteMax;
+    const __m256 factor = _mm256_set1_ps(quantizeFactor);
+    const __m256i laneOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    // v + (v >= 0 ? 0.5f : -0.5f), truncated, as in the scalar code; _mm256_cvtps_epi32 would round halves to even
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    auto roundHalfAwayFromZero = [&](__m256 x)
+    {
+        __m256 v = _mm256_mul_ps(x, factor);
+        return _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_or_ps(half, _mm256_and_ps(v, signMask))));
+    };
+    l = 0;
+    for (; l + 32 <= rowLength; l += 32)
+    {
+        __m256i q0 = roundHalfAwayFromZero(_mm256_loadu_ps(row + l));
+        __m256i q1 = roundHalfAwayFromZero(_mm256_loadu_ps(row + l + 8));
+        __m256i q2 = roundHalfAwayFromZero(_mm256_loadu_ps(row + l + 16));
+        __m256i q3 = roundHalfAwayFromZero(_mm256_loadu_ps(row + l + 24));
+        __m256i q = _mm256_packs_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3));
+        q = _mm256_max_epi8(q, _mm256_set1_epi8(-127));
+        _mm256_storeu_si256((__m256i*)(quantized + l), _mm256_permutevar8x32_epi32(q, laneOrder));
+    }
+    for (; l < rowLength; l++)
+    {
+        float v = row[l] * quantizeFactor;
+        quantized[l] = (int8_t)std::max(-127, std::min(127, (int)(v + (v >= 0 ? 0.5f : -0.5f))));
+    }
+}
+
+#endif
+
+template <class ElemType>
+void QuantizeRowsToInt8(const ElemType* src, size_t numRows, size_t rowLength, ptrdiff_t rowStep, ptrdiff_t colStep, Int8QuantizedRows& dst)
+{
+    dst.numRows = numRows;
+    dst.rowLength = rowLength;
+    dst.stride = (rowLength + Int8QuantizedRows::Alignment - 1) / Int8QuantizedRows::Alignment * Int8QuantizedRows::Alignment;
+    dst.values.resize(numRows * dst.stride);
+    dst.scales.resize(numRows);
+    dst.source = nullptr;
+
+#pragma omp parallel for if (numRows * rowLength >= 65536)
+    for (int i = 0; i < (int)numRows; i++)
+    {
+        const ElemType* row = src + i * rowStep;
+        int8_t* quantized = &dst.values[i * dst.stride];
+#if defined(__AVX2__)
+        if (std::is_same<ElemType, float>::value && colStep == 1)
+            QuantizeRowAVX2((const float*)row, rowLength, quantized, dst.scales[i]);
+        else
+#endif
+            QuantizeRow(row, rowLength, colStep, quantized, dst.scales[i]);
+        if (dst.scales[i] == 0)
+            memset(quantized, 0, rowLength);
+        memset(quantized + rowLength, 0, dst.stride - rowLength); // padding
+    }
+}
+
+// -----------------------------------------------------------------------
+// dot product kernels
+// All kernels compute exact int32 dot products of rows padded to Int8QuantizedRows::Alignment.
+// -----------------------------------------------------------------------
+
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+
+const char* Int8MultiplyKernelName() { return "AVX512-VNNI"; }
+
+// acc += |a| * sign(b, a) == a * b, in groups of 4 bytes; dpbusd takes the unsigned |a| <= 127 as first operand
+static inline __m256i DotAccumulate(__m256i acc, __m256i absA, __m256i signedB)
+{
+    return _mm256_dpbusd_epi32(acc, absA, signedB);
+}
+
+#elif defined(__AVX2__)
+
+const char* Int8MultiplyKernelName() { return "AVX2"; }
+
+// acc += |a| * sign(b, a) == a * b, in groups of 4 bytes; the pairwise int16 sums of maddubs are at most 2 * 127 * 127 and cannot saturate
+static inline __m256i DotAccumulate(__m256i acc, __m256i absA, __m256i signedB)
+{
+    __m256i products = _mm256_maddubs_epi16(absA, signedB);
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(products, _mm256_set1_epi16(1)));
+}
+
+#else
+
+const char* Int8MultiplyKernelName() { return "generic"; }
+
+#endif
+
+#if defined(__AVX2__)
+
+static inline int32_t HorizontalSum(__m256i v)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// Dot products of Rows consecutive rows of a with Cols consecutive rows of b, into result[r + Rows * c].
+// Each loaded vector of a is used for Cols products and each vector of b for Rows products.
+template <size_t Rows, size_t Cols>
+static inline void DotProducts(const int8_t* a, const int8_t* b, size_t stride, int32_t* result)
+{
+    __m256i acc[Rows][Cols];
+    for (size_t r = 0; r < Rows; r++)
+        for (size_t c = 0; c < Cols; c++)
+            acc[r][c] = _mm256_setzero_si256();
+
+    for (size_t l = 0; l < stride; l += 32)
+    {
+        __m256i vb[Cols];
+        for (size_t c = 0; c < Cols; c++)
+            vb[c] = _mm256_loadu_si256((const __m256i*)(b + c * stride + l));
+        for (size_t r = 0; r < Rows; r++)
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(a + r * stride + l));
+            __m256i absA = _mm256_abs_epi8(va);
+            for (size_t c = 0; c < Cols; c++)
+                acc[r][c] = DotAccumulate(acc[r][c], absA, _mm256_sign_epi8(vb[c], va));
+        }
+    }
+
+    for (size_t r = 0; r < Rows; r++)
+        for (size_t c = 0; c < Cols; c++)
+            result[r + Rows * c] = HorizontalSum(acc[r][c]);
+}
+
+#else
+
+template <size_t Rows, size_t Cols>
+static inline void DotProducts(const int8_t* a, const int8_t* b, size_t stride, int32_t* result)
+{
+    for (size_t r = 0; r < Rows; r++)
+        for (size_t c = 0; c < Cols; c++)
+        {
+            int32_t sum = 0;
+            for (size_t l = 0; l < stride; l++)
+                sum += (int32_t)a[r * stride + l] * (int32_t)b[c * stride + l];
+            result[r + Rows * c] = sum;
+        }
+}
+
+#endif
+
+template <class ElemType>
+void Int8MultiplyAndWeightedAdd(const Int8QuantizedRows& a, const Int8QuantizedRows& b, ElemType alpha, ElemType beta, ElemType* c, size_t ldc)
+{
+    if (a.rowLength != b.rowLength || a.stride != b.stride)
+        LogicError("Int8MultiplyAndWeightedAdd: The inner dimensions of a and b must match.");
+
+    // The result is computed in tiles of TileRows rows of a by TileCols rows of b, so that the
+    // tile of a stays in cache while it is multiplied with the rows of b. Within a tile, blocks of
+    // 4 rows of a by 2 rows of b are computed at once.
+    const size_t TileRows = 64;
+    const size_t TileCols = 16;
+    const size_t m = a.numRows;
+    const size_t n = b.numRows;
+    const size_t stride = a.stride;
+    const size_t tilesM = (m + TileRows - 1) / TileRows;
+    const size_t tilesN = (n + TileCols - 1) / TileCols;
+
+    // stores the Rows x Cols block of dot products at (i, j)
+    auto store = [&](size_t i, size_t j, size_t rows, size_t cols, const int32_t* dots)
+    {
+        for (size_t cc = 0; cc < cols; cc++)
+            for (size_t r = 0; r < rows; r++)
+            {
+                ElemType& result = c[(i + r) + (j + cc) * ldc];
+                ElemType value = alpha * (ElemType)((double)a.scales[i + r] * b.scales[j + cc] * dots[r + rows * cc]);
+                result = beta == 0 ? value : value + beta * result;
+            }
+    };
+
+#pragma omp parallel for if (m * n * stride >= 65536)
+    for (int tile = 0; tile < (int)(tilesM * tilesN); tile++)
+    {
+        size_t iBegin = (tile % tilesM) * TileRows, iEnd = std::min(m, iBegin + TileRows);
+        size_t jBegin = (tile / tilesM) * TileCols, jEnd = std::min(n, jBegin + TileCols);
+        int32_t dots[8];
+        size_t j = jBegin;
+        for (; j + 2 <= jEnd; j += 2)
+        {
+            const int8_t* rowsB = &b.values[j * stride];
+            size_t i = iBegin;
+            for (; i + 4 <= iEnd; i += 4)
+            {
+                DotProducts<4, 2>(&a.values[i * stride], rowsB, stride, dots);
+                store(i, j, 4, 2, dots);
+            }
+            for (; i < iEnd; i++)
+            {
+                DotProducts<1, 2>(&a.values[i * stride], rowsB, stride, dots);
+                store(i, j, 1, 2, dots);
+            }
+        }
+        for (; j < jEnd; j++)
+        {
+            const int8_t* rowB = &b.values[j * stride];
+            size_t i = iBegin;
+            for (; i + 4 <= iEnd; i += 4)
+            {
+                DotProducts<4, 1>(&a.values[i * stride], rowB, stride, dots);
+                store(i, j, 4, 1, dots);
+            }
+            for (; i < iEnd; i++)
+            {
+                DotProducts<1, 1>(&a.values[i * stride], rowB, stride, dots);
+                store(i, j, 1, 1, dots);
+            }
+        }
+    }
+}
+
+template void QuantizeRowsToInt8<float>(const float* src, size_t numRows, size_t rowLength, ptrdiff_t rowStep, ptrdiff_t colStep, Int8QuantizedRows& dst);
+template void QuantizeRowsToInt8<double>(const double* src, size_t numRows, size_t rowLength, ptrdiff_t rowStep, ptrdiff_t colStep, Int8QuantizedRows& dst);
+template void Int8MultiplyAndWeightedAdd<float>(const Int8QuantizedRows& a, const Int8QuantizedRows& b, float alpha, float beta, float* c, size_t ldc);
+template void Int8MultiplyAndWeightedAdd<double>(const Int8QuantizedRows& a, const Int8QuantizedRows& b, double alpha, double beta, double* c, size_t ldc);
+
+}}}
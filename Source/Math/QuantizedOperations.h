@@ -3,17 +3,22 @@
 // Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
 //
 #pragma once
+#include "CommonMatrix.h" // for MATH_API
 #include "Quantizers.h"
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
-
 // Quantized product of two dense matrices A and B, where each matrix has its own quantizer.
 // This class handles quantization of both matrices, product and de-quantization of the result.
 // Other implementations should inherit from this class or extract common methods to the base class and inherit from the base.
 template <class ElemType>
 class QuantizedMultiplier
 {
+protected:
     // Quantizers for matrices A and B
     shared_ptr<QuantizerBase<ElemType, short>> m_pQuantizerA;
     shared_ptr<QuantizerBase<ElemType, short>> m_pQuantizerB;
@@ -40,9 +45,23 @@ public:
         QuantizedMultiplier(pQuantizerA, false, pQuantizerB, false)
     {
     };
+    virtual ~QuantizedMultiplier() {}
+
+    // C[m,n] = alpha * op(A)[m,k] * op(B)[k,n] + beta * C[m,n], where op(X) is X or X^T
+    // This is the entry point used by CPUMatrix::MultiplyAndWeightedAdd().
+    virtual void MultiplyAndWeightedAdd(int m, int n, int k, ElemType alpha, ElemType* A, bool transposeA, ElemType* B, bool transposeB, ElemType beta, ElemType* C)
+    {
+        // TODO: support transpose product
+        if (transposeA || transposeB)
+            LogicError("Quantized multiplier currently doesn't support transpose.");
+        if (alpha != 1 || beta != 0)
+            LogicError("Quantized multiplier currently doesn't support scaling or accumulation of the result.");
+
+        Multiply(m, n, k, A, B, C);
+    }
 
     // A[m,k]*B[k,n] = C[m,n]
-    void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C)
+    virtual void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C)
     {
         // Quantize
         if (!m_isAConstant || m_firstPass)
@@ -86,4 +105,91 @@ public:
     void SetIsBConstant(bool v) { m_isBConstant = v; }
 };
 
+// Rows of a matrix quantized to int8 with one symmetric scale per row, i.e. per output channel for
+// weights and per sample for activations. Quantized values are in [-127, 127], value = scale * quantized.
+// Each row is padded with zeros to a multiple of Alignment elements, so that kernels can always
+// process whole SIMD registers.
+struct Int8QuantizedRows
+{
+    static const size_t Alignment = 32;
+
+    size_t numRows = 0;
+    size_t rowLength = 0;
+    size_t stride = 0; // rowLength rounded up to Alignment
+    std::vector<int8_t> values;
+    std::vector<float> scales;
+    const void* source = nullptr; // data a constant operand was quantized from; null if it must be quantized on every call
+};
+
+// Quantize 'numRows' rows of length 'rowLength', where element l of row i is src[i * rowStep + l * colStep].
+template <class ElemType>
+MATH_API void QuantizeRowsToInt8(const ElemType* src, size_t numRows, size_t rowLength, ptrdiff_t rowStep, ptrdiff_t colStep, Int8QuantizedRows& dst);
+
+// c[i + j * ldc] = alpha * a.scales[i] * b.scales[j] * dot(row i of a, row j of b) + beta * c[i + j * ldc]
+// The dot products are computed exactly, with int32 accumulation.
+template <class ElemType>
+MATH_API void Int8MultiplyAndWeightedAdd(const Int8QuantizedRows& a, const Int8QuantizedRows& b, ElemType alpha, ElemType beta, ElemType* c, size_t ldc);
+
+// name of the instruction set used by Int8MultiplyAndWeightedAdd() ("AVX512-VNNI", "AVX2" or "generic")
+MATH_API const char* Int8MultiplyKernelName();
+
+// Quantized product for evaluation in int8, see ComputationNetwork::SetInt8Evaluation().
+// Constant operands (weights) are quantized per output channel once, on first use. The other
+// operand (activations) is quantized dynamically on every call, with one scale per sample.
+// Both operands may be transposed, so this can serve Times, TransposeTimes and the unrolled
+// GEMM of the convolution engine. Concurrent evaluations may share a multiplier: only the
+// quantized constant operands are kept in it, the others are quantized into buffers of the call.
+template <class ElemType>
+class Int8QuantizedMultiplier : public QuantizedMultiplier<ElemType>
+{
+    typedef QuantizedMultiplier<ElemType> Base;
+
+public:
+    Int8QuantizedMultiplier(bool isAConstant, bool isBConstant) :
+        Base(nullptr, isAConstant, nullptr, isBConstant)
+    {
+    }
+
+    virtual void MultiplyAndWeightedAdd(int m, int n, int k, ElemType alpha, ElemType* A, bool transposeA, ElemType* B, bool transposeB, ElemType beta, ElemType* C) override
+    {
+        // rows of op(A): element (i, l) of op(A) is A[i + l * m], or A[l + i * k] if transposed
+        auto rowsA = Quantize(m_constantRowsA, A, m, k, transposeA ? k : 1, transposeA ? 1 : m, this->m_isAConstant);
+        // columns of op(B): element (l, j) of op(B) is B[l + j * k], or B[j + l * n] if transposed
+        auto rowsB = Quantize(m_constantRowsB, B, n, k, transposeB ? 1 : k, transposeB ? n : 1, this->m_isBConstant);
+        Int8MultiplyAndWeightedAdd(*rowsA, *rowsB, alpha, beta, C, m);
+    }
+
+    virtual void Multiply(int m, int n, int k, ElemType* A, ElemType* B, ElemType* C) override
+    {
+        MultiplyAndWeightedAdd(m, n, k, 1, A, false, B, false, 0, C);
+    }
+
+private:
+    // Returns the rows of a constant operand from 'constantRows' if they were quantized from 'src' already,
+    // and otherwise quantizes them into new buffers, which replace 'constantRows' if the operand is constant.
+    std::shared_ptr<const Int8QuantizedRows> Quantize(std::shared_ptr<const Int8QuantizedRows>& constantRows, const ElemType* src, size_t numRows, size_t rowLength, ptrdiff_t rowStep, ptrdiff_t colStep, bool isConstant)
+    {
+        if (isConstant)
+        {
+            std::lock_guard<std::mutex> lock(m_constantRowsMutex);
+            if (constantRows && constantRows->source == src && constantRows->numRows == numRows && constantRows->rowLength == rowLength)
+                return constantRows; // already quantized
+        }
+
+        auto rows = std::make_shared<Int8QuantizedRows>();
+        QuantizeRowsToInt8(src, numRows, rowLength, rowStep, colStep, *rows);
+        if (isConstant)
+        {
+            rows->source = src;
+            std::lock_guard<std::mutex> lock(m_constantRowsMutex);
+            constantRows = rows;
+        }
+        return rows;
+    }
+
+    std::mutex m_constantRowsMutex;
+    std::shared_ptr<const Int8QuantizedRows> m_constantRowsA;
+    std::shared_ptr<const Int8QuantizedRows> m_constantRowsB;
+};
+
 }}}
\ No newline at end of file
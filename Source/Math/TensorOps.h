@@ -482,6 +482,9 @@ DefBinaryOp(ElementwiseProductWithCoshDerivative, a * sinh_(b)); // note: b = in
 DefBinaryOp(ElementwiseProductWithAsinhDerivative, a / sqrt_(1 + b * b)); // note: b = input for asinh()
 DefBinaryOp(ElementwiseProductWithAtanhDerivative, a / (1 - b * b)); // note: b = input for atanh()
 DefBinaryOp(ElementwiseProductWithStraightThroughDerivative, fabs_(b) <= (ElemType)1 ? a : (ElemType)0); // note: b = input for straightthrough()
+DefBinaryOp(SigmoidOfSum, Sigmoid((ElemType)(a + b)));
+DefBinaryOp(TanhOfSum, tanh_((ElemType)(a + b)));
+DefBinaryOp(LinearRectifierOfSum, a + b > 0 ? (ElemType)(a + b) : (ElemType)0);
 //DefBinaryOp(Index, IndexElement(a, b, i));  // note: this one uses the third argument
 
 #pragma pop_macro("DefBinaryOp")
@@ -62,13 +62,16 @@ static bool Matches(size_t d1, size_t d2)
     return d1 == 1 || d2 == 1 || d1 == d2;
 } // do two dimensions match?
 
-template <class ElemType, size_t N>
-static void PrepareTensorOperands(array<TensorShape, N> shapes, array<size_t, N>& offsets,
+// Operands are passed as arrays of N, or as vectors for a variable number of operands (fused ops).
+template <class ElemType, class Shapes, class Offsets, class Strides>
+static void PrepareTensorOperands(Shapes shapes, Offsets& offsets,
                                   SmallVector<size_t>& regularOpDims,
-                                  array<SmallVector<ptrdiff_t>, N>& regularStrides,
+                                  Strides& regularStrides,
                                   SmallVector<size_t>& reducingOpDims,
-                                  array<SmallVector<ptrdiff_t>, N>& reducingStrides)
+                                  Strides& reducingStrides)
 {
+    const size_t N = shapes.size();
+
     // massage TensorShapes
     // Note that TensorShapes here may be shapes are stored or shapes with stride magic applied.
 
@@ -239,7 +242,7 @@ void TensorView<ElemType>::DoUnaryOpOf(ElemType beta, const TensorView& a, ElemT
     array<size_t, 2> offsets;
     array<SmallVector<ptrdiff_t>, 2> regularStrides, reducingStrides;
     SmallVector<size_t> regularOpDims, reducingOpDims;
-    PrepareTensorOperands<ElemType, 2>(array<TensorShape, 2>{a.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    PrepareTensorOperands<ElemType>(array<TensorShape, 2>{a.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 
     // output cannot be input when reducing
     if (reducingOpDims.size() > 0)
@@ -258,7 +261,7 @@ void TensorView<ElemType>::DoBinaryOpOf(ElemType beta, const TensorView& a, cons
     array<size_t, 3> offsets;
     array<SmallVector<ptrdiff_t>, 3> regularStrides, reducingStrides;
     SmallVector<size_t> regularOpDims, reducingOpDims;
-    PrepareTensorOperands<ElemType, 3>(array<TensorShape, 3>{a.GetShape(), b.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    PrepareTensorOperands<ElemType>(array<TensorShape, 3>{a.GetShape(), b.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 
     // output cannot be input when reducing
     if (reducingOpDims.size() > 0)
@@ -276,7 +279,7 @@ void TensorView<ElemType>::DoTernaryOpOf(ElemType beta, const TensorView& a, con
     array<size_t, 4> offsets;
     array<SmallVector<ptrdiff_t>, 4> regularStrides, reducingStrides;
     SmallVector<size_t> regularOpDims, reducingOpDims;
-    PrepareTensorOperands<ElemType, 4>(array<TensorShape, 4>{a.GetShape(), b.GetShape(), c.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    PrepareTensorOperands<ElemType>(array<TensorShape, 4>{a.GetShape(), b.GetShape(), c.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 
     // output cannot be input when reducing
     if (reducingOpDims.size() > 0)
@@ -285,6 +288,165 @@ void TensorView<ElemType>::DoTernaryOpOf(ElemType beta, const TensorView& a, con
     GetSOB().TensorOp(beta, a.GetSOB(), b.GetSOB(), c.GetSOB(), alpha, op, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 }
 
+// -------------------------------------------------------------------
+// fused elementwise operations
+// -------------------------------------------------------------------
+
+// the single-pass implementation exists for dense CPU matrices only
+template <class ElemType>
+static bool CanFuseTensorOps(const vector<TensorView<ElemType>>& inputs, const TensorView<ElemType>& other)
+{
+    for (const auto& input : inputs)
+        if (input.GetSOB().GetDeviceId() != CPUDEVICE || input.GetSOB().GetMatrixType() != DENSE)
+            return false;
+    return other.GetSOB().GetDeviceId() == CPUDEVICE && other.GetSOB().GetMatrixType() == DENSE;
+}
+
+// dense temporary of the operation's shape, for running a program op by op
+template <class ElemType>
+static TensorView<ElemType> NewFusedTensorOpTemp(const TensorView<ElemType>& like)
+{
+    TensorShape shape(like.GetShape().GetDims());
+    auto sob = make_shared<Matrix<ElemType>>(shape.GetNumElements(), 1, like.GetSOB().GetDeviceId());
+    return TensorView<ElemType>(sob, shape);
+}
+
+// computes the steps of a program op by op; step 'lastStep' is written to 'result' if given
+template <class ElemType>
+static vector<TensorView<ElemType>> ComputeFusedTensorOpSteps(const vector<TensorView<ElemType>>& inputs, const FusedElementwiseProgram& program, const TensorView<ElemType>& like,
+                                                              TensorView<ElemType>* result, ElemType beta, ElemType alpha)
+{
+    vector<TensorView<ElemType>> operands(inputs);
+    for (size_t s = 0; s < program.steps.size(); s++)
+    {
+        const auto& step = program.steps[s];
+        bool isResult = result && s + 1 == program.steps.size();
+        auto value = isResult ? *result : NewFusedTensorOpTemp(like);
+        ElemType valueBeta  = isResult ? beta : (ElemType)0;
+        ElemType valueAlpha = isResult ? alpha : (ElemType)1;
+        if (step.operands[1] < 0)
+            value.DoUnaryOpOf(valueBeta, operands[step.operands[0]], valueAlpha, step.op, ElementWiseOperator::opSum);
+        else
+            value.DoBinaryOpOf(valueBeta, operands[step.operands[0]], operands[step.operands[1]], valueAlpha, step.op, ElementWiseOperator::opSum);
+        operands.push_back(value);
+    }
+    return operands;
+}
+
+template <class ElemType>
+void TensorView<ElemType>::DoFusedElementwiseOf(ElemType beta, const vector<TensorView>& inputs, ElemType alpha, const FusedElementwiseProgram& program)
+{
+    if (inputs.size() != program.numInputs || program.steps.empty())
+        LogicError("DoFusedElementwiseOf: %d inputs passed to a program of %d inputs and %d steps.", (int)inputs.size(), (int)program.numInputs, (int)program.steps.size());
+
+    if (!CanFuseTensorOps(inputs, *this))
+    {
+        ComputeFusedTensorOpSteps(inputs, program, *this, this, beta, alpha);
+        return;
+    }
+
+    vector<TensorShape> shapes;
+    vector<const Matrix<ElemType>*> inputSOBs;
+    for (const auto& input : inputs)
+    {
+        shapes.push_back(input.GetShape());
+        inputSOBs.push_back(&input.GetSOB());
+    }
+    shapes.push_back(GetShape());
+
+    vector<size_t> offsets(shapes.size());
+    vector<SmallVector<ptrdiff_t>> regularStrides(shapes.size()), reducingStrides(shapes.size());
+    SmallVector<size_t> regularOpDims, reducingOpDims;
+    PrepareTensorOperands<ElemType>(shapes, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    if (reducingOpDims.size() > 0)
+        LogicError("DoFusedElementwiseOf: The output cannot be reduced into.");
+
+    Matrix<ElemType>::FusedTensorOp(program, inputSOBs, nullptr, vector<Matrix<ElemType>*>{&GetSOB()}, vector<ElemType>{beta}, alpha, offsets, regularOpDims, regularStrides);
+}
+
+template <class ElemType>
+/*static*/ void TensorView<ElemType>::DoFusedElementwiseGradientOf(const vector<TensorView>& inputs, const TensorView& outputGradient,
+                                                                   const vector<TensorView*>& inputGradients, const vector<ElemType>& betas,
+                                                                   const FusedElementwiseProgram& program)
+{
+    if (inputs.size() != program.numInputs || inputGradients.size() != program.numInputs || betas.size() != program.numInputs || program.steps.empty())
+        LogicError("DoFusedElementwiseGradientOf: %d inputs passed to a program of %d inputs and %d steps.", (int)inputs.size(), (int)program.numInputs, (int)program.steps.size());
+
+    vector<TensorView> operands(inputs);
+    for (const auto& inputGradient : inputGradients)
+    {
+        if (inputGradient && inputGradient->GetShape() != outputGradient.GetShape())
+            LogicError("DoFusedElementwiseGradientOf: The input gradients must have the shape of the operation.");
+        if (inputGradient)
+            operands.push_back(*inputGradient);
+    }
+
+    if (!CanFuseTensorOps(operands, outputGradient))
+    {
+        // recompute the steps, and propagate the gradient back through them one op at a time
+        auto values = ComputeFusedTensorOpSteps<ElemType>(inputs, program, outputGradient, nullptr, 0, 0);
+        vector<TensorView> operandGradients;
+        vector<ElemType> operandBetas(betas);
+        for (size_t i = 0; i < inputs.size(); i++)
+            operandGradients.push_back(inputGradients[i] ? *inputGradients[i] : NewFusedTensorOpTemp(outputGradient));
+        for (size_t s = 0; s + 1 < program.steps.size(); s++)
+        {
+            operandGradients.push_back(NewFusedTensorOpTemp(outputGradient));
+            operandBetas.push_back(0);
+        }
+        operandGradients.push_back(outputGradient);
+
+        for (size_t s = program.steps.size(); s-- > 0;)
+        {
+            const auto& step = program.steps[s];
+            const auto& gradient = operandGradients[inputs.size() + s];
+            for (size_t k = 0; k < 2 && step.operands[k] >= 0; k++)
+            {
+                ElementWiseOperator derivativeOp;
+                FusedElementwiseDerivativeArg arg;
+                if (!FusedElementwiseDerivative(step.op, k, derivativeOp, arg))
+                    LogicError("DoFusedElementwiseGradientOf: Op code %d has no derivative.", (int)step.op);
+                size_t operand = step.operands[k];
+                if (arg == FusedElementwiseDerivativeArg::none)
+                    operandGradients[operand].DoUnaryOpOf(operandBetas[operand], gradient, 1, derivativeOp, ElementWiseOperator::opSum);
+                else
+                {
+                    size_t other = arg == FusedElementwiseDerivativeArg::output ? inputs.size() + s :
+                                   arg == FusedElementwiseDerivativeArg::operand ? operand : step.operands[1 - k];
+                    operandGradients[operand].DoBinaryOpOf(operandBetas[operand], gradient, values[other], 1, derivativeOp, ElementWiseOperator::opSum);
+                }
+                operandBetas[operand] = 1;
+            }
+        }
+        return;
+    }
+
+    // operands are the inputs, the output gradient, and the input gradients (a skipped one takes the shape of the output gradient)
+    vector<TensorShape> shapes;
+    vector<const Matrix<ElemType>*> inputSOBs;
+    vector<Matrix<ElemType>*> gradientSOBs;
+    for (const auto& input : inputs)
+    {
+        shapes.push_back(input.GetShape());
+        inputSOBs.push_back(&input.GetSOB());
+    }
+    shapes.push_back(outputGradient.GetShape());
+    for (const auto& inputGradient : inputGradients)
+    {
+        shapes.push_back(inputGradient ? inputGradient->GetShape() : outputGradient.GetShape());
+        gradientSOBs.push_back(inputGradient ? &inputGradient->GetSOB() : nullptr);
+    }
+
+    vector<size_t> offsets(shapes.size());
+    vector<SmallVector<ptrdiff_t>> regularStrides(shapes.size()), reducingStrides(shapes.size());
+    SmallVector<size_t> regularOpDims, reducingOpDims;
+    PrepareTensorOperands<ElemType>(shapes, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    if (reducingOpDims.size() > 0)
+        LogicError("DoFusedElementwiseGradientOf: The input gradients cannot be reduced into.");
+
+    Matrix<ElemType>::FusedTensorOp(program, inputSOBs, &outputGradient.GetSOB(), gradientSOBs, betas, 1, offsets, regularOpDims, regularStrides);
+}
+
 template <class ElemType>
 void TensorView<ElemType>::DoArgReductionOpOf(const TensorView& a, ElementWiseOperator reductionOp)
 {
@@ -292,7 +454,7 @@ void TensorView<ElemType>::DoArgReductionOpOf(const TensorView& a, ElementWiseOp
     array<size_t, 2> offsets;
     array<SmallVector<ptrdiff_t>, 2> regularStrides, reducingStrides;
     SmallVector<size_t> regularOpDims, reducingOpDims;
-    PrepareTensorOperands<ElemType, 2>(array<TensorShape, 2>{a.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    PrepareTensorOperands<ElemType>(array<TensorShape, 2>{a.GetShape(), GetShape()}, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
 
     // output cannot be input when reducing
     if (reducingOpDims.size() > 0)
@@ -134,6 +134,19 @@ public:
     void DoBinaryOpOf (ElemType beta, const TensorView& a, const TensorView& b,                      ElemType alpha, ElementWiseOperator op, ElementWiseOperator reductionOp);
     void DoTernaryOpOf(ElemType beta, const TensorView& a, const TensorView& b, const TensorView& c, ElemType alpha, ElementWiseOperator op, ElementWiseOperator reductionOp);
 
+    // -------------------------------------------------------------------
+    // fused elementwise operations, see FusedElementwiseProgram
+    // The whole chain is computed in one pass on the CPU; otherwise it runs op by op on temporaries.
+    // Inputs can broadcast, but the result cannot be reduced into, i.e. it must have the shape of the operation.
+    // -------------------------------------------------------------------
+
+    // this = beta * this + alpha * program(inputs)
+    void DoFusedElementwiseOf(ElemType beta, const std::vector<TensorView>& inputs, ElemType alpha, const FusedElementwiseProgram& program);
+    // inputGradients[i] = betas[i] * inputGradients[i] + gradient w.r.t. inputs[i], for the input gradients that are not null
+    static void DoFusedElementwiseGradientOf(const std::vector<TensorView>& inputs, const TensorView& outputGradient,
+                                             const std::vector<TensorView*>& inputGradients, const std::vector<ElemType>& betas,
+                                             const FusedElementwiseProgram& program);
+
     // -------------------------------------------------------------------
     // arg based operations
     // -------------------------------------------------------------------
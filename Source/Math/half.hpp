@@ -124,6 +124,16 @@ struct TypeSelector<half>
     typedef float comp_t;
 };
 
+/* buffer conversions between half and float, used when half data is computed on in float */
+inline void ConvertBuffer(float* dst, const half* src, size_t count)
+{
+    CNTK::float16ToFloat(reinterpret_cast<const unsigned short*>(src), dst, count);
+}
+inline void ConvertBuffer(half* dst, const float* src, size_t count)
+{
+    CNTK::floatToFloat16(src, reinterpret_cast<unsigned short*>(dst), count);
+}
+
 /* operators to write to/read from files for half */
 inline Microsoft::MSR::CNTK::File& operator>>(Microsoft::MSR::CNTK::File& stream, half& h)
 {
@@ -51,6 +51,9 @@ BinaryChunkDeserializer::BinaryChunkDeserializer(const BinaryConfigHelper& helpe
 {
     SetTraceLevel(helper.GetTraceLevel());
 
+    if (helper.UseMemoryMap())
+        m_mappedFile = make_shared<MappedFile>(helper.GetFilePath(), true);
+
     Initialize(helper.GetRename(), helper.GetElementType());
 }
 
@@ -150,10 +153,19 @@ void BinaryChunkDeserializer::SequenceInfosForChunk(ChunkIdType chunkId, std::ve
     auto numberOfSequences = m_chunkTable->GetNumSequences(chunkId);
     unique_ptr<uint32_t[]> numSamplesPerSequence(new uint32_t[numberOfSequences]);
 
-    // Seek to the start of the chunk
-    m_file.SeekOrDie(offset, SEEK_SET);
-    // read 'numberOfSequences' unsigned ints
-    m_file.ReadOrDie(numSamplesPerSequence.get(), sizeof(uint32_t), numberOfSequences);
+    if (m_mappedFile)
+    {
+        if (offset + numberOfSequences * sizeof(uint32_t) > m_mappedFile->Size())
+            RuntimeError("Chunk %u is out of the bounds of the input file.", (unsigned int)chunkId);
+        memcpy(numSamplesPerSequence.get(), m_mappedFile->Data() + offset, numberOfSequences * sizeof(uint32_t));
+    }
+    else
+    {
+        // Seek to the start of the chunk
+        m_file.SeekOrDie(offset, SEEK_SET);
+        // read 'numberOfSequences' unsigned ints
+        m_file.ReadOrDie(numSamplesPerSequence.get(), sizeof(uint32_t), numberOfSequences);
+    }
 
     auto startId = m_chunkTable->GetStartIndex(chunkId);
     for (decltype(numberOfSequences) i = 0; i < numberOfSequences; i++)
@@ -169,17 +181,31 @@ void BinaryChunkDeserializer::SequenceInfosForChunk(ChunkIdType chunkId, std::ve
     }
 }
 
-unique_ptr<byte[]> BinaryChunkDeserializer::ReadChunk(ChunkIdType chunkId)
+std::shared_ptr<byte> BinaryChunkDeserializer::ReadChunk(ChunkIdType chunkId)
 {
-    // Seek to the start of the data portion in the chunk
-    m_file.SeekOrDie(m_chunkTable->GetDataStartOffset(chunkId), SEEK_SET);
+    auto dataStartOffset = m_chunkTable->GetDataStartOffset(chunkId);
 
     // Determine how big the chunk is.
     size_t chunkSize = m_chunkTable->GetChunkSize(chunkId);
-    
+
+    if (m_mappedFile)
+    {
+        if (dataStartOffset + chunkSize > m_mappedFile->Size())
+            RuntimeError("Chunk %u is out of the bounds of the input file.", (unsigned int)chunkId);
+
+        // GetChunk() is called by the randomizer ahead of time for the chunks it is going to use,
+        // so this is the place to start paging in the chunk. The returned pointer shares ownership
+        // of the mapping, sequences only read through it.
+        m_mappedFile->WillNeed(dataStartOffset, chunkSize);
+        return std::shared_ptr<byte>(m_mappedFile, const_cast<byte*>(m_mappedFile->Data()) + dataStartOffset);
+    }
+
+    // Seek to the start of the data portion in the chunk
+    m_file.SeekOrDie(dataStartOffset, SEEK_SET);
+
     // Create buffer
     // TODO: use a pool of buffers instead of allocating a new one, each time a chunk is read.
-    unique_ptr<byte[]> buffer(new byte[chunkSize]);
+    std::shared_ptr<byte> buffer(new byte[chunkSize], [](byte* p) { delete[] p; });
 
     // Read the chunk from disk
     m_file.ReadOrDie(buffer.get(), sizeof(byte), chunkSize);
@@ -191,7 +217,7 @@ unique_ptr<byte[]> BinaryChunkDeserializer::ReadChunk(ChunkIdType chunkId)
 ChunkPtr BinaryChunkDeserializer::GetChunk(ChunkIdType chunkId)
 {
     // Read the chunk into memory
-    unique_ptr<byte[]> buffer = ReadChunk(chunkId);
+    std::shared_ptr<byte> buffer = ReadChunk(chunkId);
 
     return make_shared<BinaryDataChunk>(chunkId, m_chunkTable->GetNumSequences(chunkId), std::move(buffer), m_deserializers);
 }
@@ -9,6 +9,7 @@
 #include "BinaryConfigHelper.h"
 #include "BinaryDataChunk.h"
 #include "BinaryDataDeserializer.h"
+#include "MappedFile.h"
 
 namespace CNTK {
 
@@ -108,8 +109,8 @@ private:
     // Reads the chunk table from disk into memory
     void ReadChunkTable();
 
-    // Reads a chunk from disk into buffer
-    unique_ptr<byte[]> ReadChunk(ChunkIdType chunkId);
+    // Reads a chunk from disk into buffer, or returns a view into the mapped file.
+    std::shared_ptr<byte> ReadChunk(ChunkIdType chunkId);
 
     BinaryChunkDeserializer(const wstring& filename);
 
@@ -118,6 +119,9 @@ private:
 private:
     FileWrapper m_file;
 
+    // If set, chunks are not read but handed out as views into the mapped file.
+    MappedFilePtr m_mappedFile;
+
     int64_t m_headerOffset, m_chunkTableOffset;
 
     std::vector<BinaryDataDeserializerPtr> m_deserializers;
@@ -66,6 +66,8 @@ namespace CNTK {
 
         m_filepath = Microsoft::MSR::CNTK::ToFixedWStringFromMultiByte(config(L"file"));
         m_keepDataInMemory = config(L"keepDataInMemory", false);
+        m_chunkCacheSizeBytes = config(L"chunkCacheSizeInBytes", (size_t)0);
+        m_useMemoryMap = config(L"useMemoryMap", false);
 
         m_randomizationWindow = GetRandomizationWindowFromConfig(config);
         m_sampleBasedRandomizationWindow = config(L"sampleBasedRandomizationWindow", false);
@@ -33,10 +33,16 @@ public:
 
     unsigned int GetTraceLevel() const { return m_traceLevel; }
 
-    bool ShouldKeepDataInMemory() const { return m_keepDataInMemory; }
+    bool ShouldKeepDataInMemory() const { return m_keepDataInMemory || m_chunkCacheSizeBytes > 0; }
+
+    // Size limit of the chunk cache, 0 if the whole dataset should be kept in memory.
+    size_t GetChunkCacheSize() const { return m_chunkCacheSizeBytes; }
 
     DataType GetElementType() const { return m_elementType; }
 
+    // If true, the input file is memory mapped and sequences point directly into the mapping.
+    bool UseMemoryMap() const { return m_useMemoryMap; }
+
     DISABLE_COPY_AND_MOVE(BinaryConfigHelper);
 
 private:
@@ -49,6 +55,8 @@ private:
     bool m_sampleBasedRandomizationWindow;
     unsigned int m_traceLevel;
     bool m_keepDataInMemory; // if true the whole dataset is kept in memory
+    size_t m_chunkCacheSizeBytes; // if not 0, chunks are kept in memory up to this size, least recently used are dropped first
+    bool m_useMemoryMap; // if true chunks are views into the memory mapped file instead of heap copies
 };
 
 }
@@ -17,7 +17,7 @@ class BinaryDataChunk : public Chunk, public std::enable_shared_from_this<Chunk>
 public:
     explicit BinaryDataChunk(ChunkIdType chunkId,
         size_t numSequences, 
-        unique_ptr<byte[]> buffer, 
+        std::shared_ptr<byte> buffer, 
         std::vector<BinaryDataDeserializerPtr> deserializer)
         : m_chunkId(chunkId),
         m_numSequences(numSequences), 
@@ -28,21 +28,13 @@ public:
     virtual ~BinaryDataChunk()
     {
         // There might be outstanding sequences sharing the memory from this chunk
-        // in that case, create a new chunk and let outstanding sequences ref it
-        std::shared_ptr<uint8_t> holdingBuffer;
+        // in that case, let outstanding sequences ref the buffer
         for (auto& seqs : m_data)
         {
             for (auto& s : seqs)
             {
                 if (!s.unique())
-                {
-                    // create holding chunk if not already have one
-                    if (!holdingBuffer)
-                    {
-                        holdingBuffer.reset((uint8_t*)m_buffer.release());
-                    }
-                    s->m_holdingBuffer = holdingBuffer;
-                }
+                    s->m_holdingBuffer = m_buffer;
             }
         }
     }
@@ -90,8 +82,9 @@ protected:
     // so we must tell the chunk where it starts.
     size_t m_numSequences;
 
-    // This is the actual chunk read from disk. We will call back to the deserializer for it to be deserialized
-    unique_ptr<byte[]> m_buffer;
+    // This is the actual chunk read from disk, or a view into the memory mapped file that keeps the mapping alive.
+    // We will call back to the deserializer for it to be deserialized
+    std::shared_ptr<byte> m_buffer;
 
     // This is the deserializer who knows how to interpret the m_data chunk that we read in
     std::vector<BinaryDataDeserializerPtr> m_deserializers;
@@ -30,11 +30,15 @@ CNTKBinaryReader::CNTKBinaryReader(const ConfigParameters& config)
     try
     {
         m_deserializer = shared_ptr<DataDeserializer>(new BinaryChunkDeserializer(configHelper));
+        if (configHelper.UseMemoryMap())
+            log << " | memory mapped";
 
         if (configHelper.ShouldKeepDataInMemory())
         {
-            m_deserializer = shared_ptr<DataDeserializer>(new ChunkCache(m_deserializer));
+            m_deserializer = shared_ptr<DataDeserializer>(new ChunkCache(m_deserializer, configHelper.GetChunkCacheSize()));
             log << " | keeping data in memory";
+            if (configHelper.GetChunkCacheSize() > 0)
+                log << " (up to " << (configHelper.GetChunkCacheSize() >> 20) << " MB)";
         }
 
         size_t window = configHelper.GetRandomizationWindow();
@@ -126,6 +126,7 @@ TextConfigHelper::TextConfigHelper(const ConfigParameters& config)
     m_traceLevel = config(L"traceLevel", 1);
     m_chunkSizeBytes = config(L"chunkSizeInBytes", g_32MB); // 32 MB by default
     m_keepDataInMemory = config(L"keepDataInMemory", false);
+    m_chunkCacheSizeBytes = config(L"chunkCacheSizeInBytes", (size_t)0);
     m_frameMode = config(L"frameMode", false);
     m_cacheIndex = config(L"cacheIndex", false);
 
@@ -39,7 +39,10 @@ public:
 
     size_t GetChunkSize() const { return m_chunkSizeBytes; }
 
-    bool ShouldKeepDataInMemory() const { return m_keepDataInMemory; }
+    bool ShouldKeepDataInMemory() const { return m_keepDataInMemory || m_chunkCacheSizeBytes > 0; }
+
+    // Size limit of the chunk cache, 0 if the whole dataset should be kept in memory.
+    size_t GetChunkCacheSize() const { return m_chunkCacheSizeBytes; }
 
     bool IsInFrameMode() const { return m_frameMode; }
 
@@ -60,6 +63,7 @@ private:
     unsigned int m_traceLevel;
     size_t m_chunkSizeBytes; // chunks size in bytes
     bool m_keepDataInMemory; // if true the whole dataset is kept in memory
+    size_t m_chunkCacheSizeBytes; // if not 0, chunks are kept in memory up to this size, least recently used are dropped first
     bool m_frameMode; // if true, the maximum expected sequence length in the dataset is one sample.
     bool m_cacheIndex; // When true, the index will be loaded from a cache file it if exists.
                        // If cache does not exist, the index, once created, will be written out to a file.
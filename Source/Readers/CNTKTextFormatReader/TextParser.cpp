@@ -7,6 +7,10 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <cfloat>
+#include <numeric>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 #include "BufferedFileReader.h"
 #include "IndexBuilder.h"
 #include "TextParser.h"
@@ -37,6 +41,235 @@ enum State
     Exponent
 };
 
+// Helpers for the in-memory parser (see TextParser::TryParseSequence()).
+// They only accept input that TryReadRealNumber()/TryReadUint64() would accept without
+// a warning, and must produce bit-identical values.
+
+inline int CountTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int CountTrailingZeros64(uint64_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// Returns a pointer to the first occurrence of either 'a' or 'b' in [begin, end), or end if there is none.
+// Scans 32 (AVX2) or 16 bytes at a time.
+inline const char* FindFirstOf(const char* begin, const char* end, char a, char b)
+{
+#if defined(__AVX2__)
+    const __m256i a32 = _mm256_set1_epi8(a), b32 = _mm256_set1_epi8(b);
+    for (; end - begin >= 32; begin += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)begin);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, a32), _mm256_cmpeq_epi8(block, b32)));
+        if (mask)
+            return begin + CountTrailingZeros(mask);
+    }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+    const __m128i a16 = _mm_set1_epi8(a), b16 = _mm_set1_epi8(b);
+    for (; end - begin >= 16; begin += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)begin);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, a16), _mm_cmpeq_epi8(block, b16)));
+        if (mask)
+            return begin + CountTrailingZeros(mask);
+    }
+#endif
+    for (; begin != end; ++begin)
+    {
+        if (*begin == a || *begin == b)
+            return begin;
+    }
+    return end;
+}
+
+// Returns the number of leading decimal digits (up to 8) in the given 8 characters, and their value.
+// The characters are processed as a single 64-bit word.
+inline size_t ParseEightDigits(const char* p, uint64_t& value)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    word ^= 0x3030303030303030ull; // digits become bytes 0..9
+    // The high bit of each byte that is not a digit gets set. A carry into the next byte only
+    // happens for non-digits, and only bytes after the first non-digit are affected.
+    uint64_t nonDigits = (word | (word + 0x7676767676767676ull)) & 0x8080808080808080ull;
+    size_t count = nonDigits ? CountTrailingZeros64(nonDigits) / 8 : 8;
+    if (count == 0)
+        return 0;
+
+    // Move the digits to the most significant bytes (the first character is the least significant byte),
+    // so that the free bytes act as leading zeros, and combine pairs, quadruples and octets of digits.
+    word <<= 8 * (8 - count);
+    word = (word * 10) + (word >> 8);
+    word = (((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+            (((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    value = word;
+    return count;
+}
+
+// Same as calling number = number * 10 + digit for each of the digits at the current position,
+// starting with number = 0. Up to 15 digits the intermediate values are exact integers in double
+// precision, so they are accumulated as integers, the rest (if any) as doubles in the same order.
+// Returns the number of digits consumed.
+inline size_t ReadDigits(const char*& p, const char* end, double& number)
+{
+    const char* start = p;
+    uint64_t integer = 0;
+    if (end - p >= 8)
+    {
+        size_t count = ParseEightDigits(p, integer);
+        p += count;
+        if (count < 8)
+        {
+            number = static_cast<double>(integer);
+            return count;
+        }
+    }
+
+    const char* exactEnd = (end - start > 15) ? start + 15 : end;
+    for (; p != exactEnd && IsDigit(*p); ++p)
+        integer = integer * 10 + (*p - '0');
+
+    number = static_cast<double>(integer);
+    for (; p != end && IsDigit(*p); ++p)
+        number = number * 10 + (*p - '0');
+
+    return p - start;
+}
+
+// Returns 10^n computed as 10 * 10 * ... * 10 in double precision, the way
+// TryReadRealNumber() computes the divider of the fractional part.
+inline double PowerOfTen(size_t n)
+{
+    static const auto powers = []()
+    {
+        std::vector<double> result(32);
+        result[0] = 1;
+        for (size_t i = 1; i < result.size(); ++i)
+            result[i] = result[i - 1] * 10;
+        return result;
+    }();
+
+    if (n < powers.size())
+        return powers[n];
+
+    double result = powers.back();
+    for (size_t i = powers.size() - 1; i < n; ++i)
+        result *= 10;
+    return result;
+}
+
+// In-memory equivalent of TryReadRealNumber(), see the state machine there.
+// Fails if the number is malformed or not followed by another character.
+template <class ElemType>
+bool TryParseRealNumber(const char*& p, const char* end, ElemType& value)
+{
+    bool negative = false;
+    if (isSign(*p))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    double number;
+    if (p == end || !IsDigit(*p))
+        return false;
+    ReadDigits(p, end, number);
+    if (p == end)
+        return false;
+
+    double coefficient;
+    if (*p == '.')
+    {
+        ++p;
+        if (p == end)
+            return false;
+        if (!IsDigit(*p))
+        {
+            value = static_cast<ElemType>((negative) ? -number : number);
+            return true;
+        }
+
+        coefficient = number;
+        size_t numDigits = ReadDigits(p, end, number);
+        if (p == end)
+            return false;
+
+        coefficient += (number / PowerOfTen(numDigits));
+        if (!isE(*p))
+        {
+            value = static_cast<ElemType>((negative) ? -coefficient : coefficient);
+            return true;
+        }
+        if (negative)
+            coefficient = -coefficient;
+    }
+    else if (isE(*p))
+    {
+        coefficient = (negative) ? -number : number;
+    }
+    else
+    {
+        value = static_cast<ElemType>((negative) ? -number : number);
+        return true;
+    }
+
+    // exponent: optional sign and a nonempty sequence of digits
+    ++p;
+    if (p == end)
+        return false;
+    negative = false;
+    if (isSign(*p))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == end || !IsDigit(*p))
+        return false;
+    ReadDigits(p, end, number);
+    if (p == end)
+        return false;
+
+    double exponent = (negative) ? -number : number;
+    value = static_cast<ElemType>(coefficient * pow(10.0, exponent));
+    return true;
+}
+
+// In-memory equivalent of TryReadUint64(), including its overflow check.
+inline bool TryParseUint64(const char*& p, const char* end, size_t& value)
+{
+    value = 0;
+    if (p == end || !IsDigit(*p))
+        return false;
+
+    for (; p != end && IsDigit(*p); ++p)
+    {
+        size_t temp = value;
+        value = value * 10 + (*p - '0');
+        if (temp > value)
+            return false;
+    }
+    return p != end;
+}
+
 template <class ElemType>
 class TextParser<ElemType>::TextDataChunk : public Chunk, public std::enable_shared_from_this<Chunk>
 {
@@ -93,7 +326,8 @@ TextParser<ElemType>::TextParser(CorpusDescriptorPtr corpus, const std::wstring&
     m_numRetries(5),
     m_corpus(corpus),
     m_useMaximumAsSequenceLength(true),
-    m_cacheIndex(false)
+    m_cacheIndex(false),
+    m_useInMemoryParser(true)
 {
     assert(streams.size() > 0);
 
@@ -282,13 +516,244 @@ template <class ElemType>
 void TextParser<ElemType>::LoadChunk(TextChunkPtr& chunk, const ChunkDescriptor& descriptor)
 {
     chunk->m_sequenceMap.resize(descriptor.NumberOfSequences());
-    for (size_t sequenceIndex = 0; sequenceIndex < descriptor.NumberOfSequences(); ++sequenceIndex)
+
+    // Sequences that could not be parsed from memory (or all of them, if the in-memory parser is not used).
+    std::vector<size_t> remaining;
+
+    // The in-memory parser does not report anything, so with the 'Info' trace level
+    // (a message per sequence) everything goes through LoadSequence().
+    std::vector<char> buffer;
+    if (m_useInMemoryParser && m_traceLevel < Info)
+    {
+        buffer.resize(descriptor.SizeInBytes());
+        m_fileReader->SetFileOffset(descriptor.StartOffset());
+        if (buffer.empty() || !m_fileReader->TryReadBinarySegment(buffer.size(), buffer.data()))
+            buffer.clear();
+    }
+
+    if (buffer.empty())
+    {
+        remaining.resize(descriptor.NumberOfSequences());
+        std::iota(remaining.begin(), remaining.end(), 0);
+    }
+    else
+    {
+        std::vector<char> parsed(descriptor.NumberOfSequences(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+        for (int sequenceIndex = 0; sequenceIndex < (int)descriptor.NumberOfSequences(); ++sequenceIndex)
+        {
+            const auto& sequenceDescriptor = descriptor.Sequences()[sequenceIndex];
+            const char* begin = buffer.data() + sequenceDescriptor.OffsetInChunk();
+            if (sequenceDescriptor.OffsetInChunk() + sequenceDescriptor.SizeInBytes() <= buffer.size())
+                parsed[sequenceIndex] = TryParseSequence(begin, begin + sequenceDescriptor.SizeInBytes(), sequenceDescriptor, chunk->m_sequenceMap[sequenceIndex]);
+        }
+
+        for (size_t sequenceIndex = 0; sequenceIndex < parsed.size(); ++sequenceIndex)
+        {
+            if (!parsed[sequenceIndex])
+                remaining.push_back(sequenceIndex);
+        }
+    }
+
+    // Sequences with errors or warnings are re-read in order, so that the messages and
+    // the number of allowed errors are exactly the same as without the in-memory parser.
+    for (size_t sequenceIndex : remaining)
     {
         const auto& sequenceDescriptor = descriptor.Sequences()[sequenceIndex];
         chunk->m_sequenceMap[sequenceIndex] = LoadSequence(sequenceDescriptor, descriptor.StartOffset());
     }
 }
 
+template <class ElemType>
+typename TextParser<ElemType>::SequenceBuffer TextParser<ElemType>::CreateSequenceBuffer(size_t numberOfSamples) const
+{
+    SequenceBuffer sequence;
+
+    // TODO: reuse loaded sequences instead of creating new ones!
+    for (auto const & stream : m_streamInfos)
+    {
+        if (stream.m_type == StorageFormat::Dense)
+        {
+            sequence.push_back(make_unique<DenseInputStreamBuffer>(
+                stream.m_sampleShape.Dimensions()[0] * numberOfSamples, stream.m_sampleShape));
+        }
+        else
+        {
+            sequence.push_back(make_unique<SparseInputStreamBuffer>(stream.m_sampleShape));
+        }
+    }
+
+    return sequence;
+}
+
+// Mirrors TryReadRow(), TryReadSample(), TryGetInputId(), TryReadDenseSample(), TryReadSparseSample()
+// and the checks in LoadSequence(), bailing out wherever those print a message or count an error.
+template <class ElemType>
+bool TextParser<ElemType>::TryParseSequence(const char* p, const char* end, const SequenceDescriptor& sequenceDsc, SequenceBuffer& result)
+{
+    SequenceBuffer sequence = CreateSequenceBuffer(sequenceDsc.m_numberOfSamples);
+
+    size_t numRowsRead = 0;
+    while (p != end)
+    {
+        // skip sequence ids
+        while (p != end && IsDigit(*p))
+            ++p;
+
+        size_t numSampleRead = 0;
+        for (;;)
+        {
+            if (p == end)
+                return false; // missing trailing newline
+
+            char c = *p;
+            if (c == ROW_DELIMITER)
+            {
+                ++p;
+                if (numSampleRead == 0 || numSampleRead > m_streams.size())
+                    return false;
+                break;
+            }
+
+            if (isColumnDelimiter(c))
+            {
+                ++p;
+                continue;
+            }
+
+            if (c != NAME_PREFIX)
+                return false;
+            ++p;
+
+            if (p != end && *p == ESCAPE_SYMBOL)
+            {
+                // comment, skip until the next input or the end of row
+                p = FindFirstOf(p + 1, end, NAME_PREFIX, ROW_DELIMITER);
+                continue;
+            }
+
+            const char* name = p;
+            while (p != end && !(isValueDelimiter(*p) || *p == NAME_PREFIX || isNonPrintable(*p)))
+                ++p;
+            if (p == end || p == name)
+                return false;
+
+            size_t nameLength = p - name;
+            size_t id = m_streamDescriptors.size();
+            if (nameLength <= m_maxAliasLength)
+            {
+                for (id = 0; id < m_streamDescriptors.size(); ++id)
+                {
+                    const auto& alias = m_streamDescriptors[id].m_alias;
+                    if (alias.size() == nameLength && memcmp(alias.data(), name, nameLength) == 0)
+                        break;
+                }
+            }
+
+            if (id == m_streamDescriptors.size())
+            {
+                // unknown input, skip it
+                p = FindFirstOf(p, end, NAME_PREFIX, ROW_DELIMITER);
+                continue;
+            }
+
+            const StreamInfo& stream = m_streamInfos[id];
+            size_t sampleSize = stream.m_sampleShape.Dimensions()[0];
+            ElemType value;
+
+            if (stream.m_type == StorageFormat::Dense)
+            {
+                DenseInputStreamBuffer* data = reinterpret_cast<DenseInputStreamBuffer*>(sequence[id].get());
+                vector<ElemType>& values = data->m_buffer;
+                size_t counter = 0;
+                for (;;)
+                {
+                    if (p == end)
+                        return false;
+                    c = *p;
+                    if (isValueDelimiter(c))
+                    {
+                        ++p;
+                        continue;
+                    }
+                    if (isNonPrintable(c) || c == NAME_PREFIX)
+                        break;
+                    if (!TryParseRealNumber(p, end, value))
+                        return false;
+                    values.push_back(value);
+                    ++counter;
+                }
+
+                if (counter != sampleSize)
+                    return false;
+                ++data->m_numberOfSamples;
+            }
+            else
+            {
+                SparseInputStreamBuffer* data = reinterpret_cast<SparseInputStreamBuffer*>(sequence[id].get());
+                vector<ElemType>& values = data->m_buffer;
+                vector<SparseIndexType>& indices = data->m_indicesBuffer;
+                size_t size = values.size();
+                for (;;)
+                {
+                    if (p == end)
+                        return false;
+                    c = *p;
+                    if (isValueDelimiter(c))
+                    {
+                        ++p;
+                        continue;
+                    }
+                    if (isNonPrintable(c) || c == NAME_PREFIX)
+                        break;
+
+                    size_t index;
+                    if (!TryParseUint64(p, end, index) || index >= sampleSize || *p != INDEX_DELIMITER)
+                        return false;
+                    ++p;
+                    if (p == end || !TryParseRealNumber(p, end, value))
+                        return false;
+                    values.push_back(value);
+                    indices.push_back(static_cast<SparseIndexType>(index));
+                }
+
+                ++data->m_numberOfSamples;
+                SparseIndexType count = static_cast<SparseIndexType>(values.size() - size);
+                data->m_nnzCounts.push_back(count);
+                data->m_totalNnzCount += count;
+            }
+            ++numSampleRead;
+        }
+        ++numRowsRead;
+    }
+
+    size_t expectedRowCount = sequenceDsc.m_numberOfSamples;
+    if (numRowsRead < expectedRowCount)
+        return false;
+
+    uint32_t overallSequenceLength = 0;
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        if (sequence[i]->m_numberOfSamples == 0)
+            return false;
+
+        if (!m_useMaximumAsSequenceLength && !m_streamDescriptors[i].m_definesMbSize)
+            continue;
+
+        if (sequence[i]->m_numberOfSamples > expectedRowCount)
+            return false;
+        overallSequenceLength = max(sequence[i]->m_numberOfSamples, overallSequenceLength);
+    }
+
+    if (overallSequenceLength < expectedRowCount)
+        return false;
+
+    FillSequenceMetadata(sequence, { sequenceDsc.m_key, 0 });
+    result = std::move(sequence);
+    return true;
+}
+
 template <class ElemType>
 void TextParser<ElemType>::IncrementNumberOfErrorsOrDie()
 {
@@ -311,21 +776,7 @@ typename TextParser<ElemType>::SequenceBuffer TextParser<ElemType>::LoadSequence
 
     size_t bytesToRead = sequenceDsc.SizeInBytes();
 
-    SequenceBuffer sequence;
-
-    // TODO: reuse loaded sequences instead of creating new ones!
-    for (auto const & stream : m_streamInfos)
-    {
-        if (stream.m_type == StorageFormat::Dense)
-        {
-            sequence.push_back(make_unique<DenseInputStreamBuffer>(
-                stream.m_sampleShape.Dimensions()[0] * sequenceDsc.m_numberOfSamples, stream.m_sampleShape));
-        }
-        else
-        {
-            sequence.push_back(make_unique<SparseInputStreamBuffer>(stream.m_sampleShape));
-        }
-    }
+    SequenceBuffer sequence = CreateSequenceBuffer(sequenceDsc.m_numberOfSamples);
 
     size_t numRowsRead = 0, expectedRowCount = sequenceDsc.m_numberOfSamples;
     size_t rowNumber = 1;
@@ -1232,6 +1683,12 @@ void TextParser<ElemType>::SetCacheIndex(bool value)
     m_cacheIndex = value;
 }
 
+template <class ElemType>
+void TextParser<ElemType>::SetUseInMemoryParser(bool value)
+{
+    m_useInMemoryParser = value;
+}
+
 template<class ElemType>
 inline bool TextParser<ElemType>::CanRead()
 {
@@ -133,6 +133,7 @@ private:
     unsigned int m_numAllowedErrors;
     bool m_skipSequenceIds;
     bool m_cacheIndex;
+    bool m_useInMemoryParser; // if true, chunks are read at once and their sequences parsed in parallel
     unsigned int m_numRetries; // specifies the number of times an unsuccessful
                                // file operation should be repeated (default value is 5).
 
@@ -188,6 +189,14 @@ private:
     // Given a descriptor, retrieves the data for the corresponding chunk from the file.
     void LoadChunk(TextChunkPtr& chunk, const ChunkDescriptor& descriptor);
 
+    // Creates empty input stream buffers for a sequence with the given number of samples.
+    SequenceBuffer CreateSequenceBuffer(size_t numberOfSamples) const;
+
+    // Parses a sequence from the in-memory copy of its chunk. Only accepts well-formed input:
+    // returns false on anything that makes LoadSequence() print a message or count an error,
+    // in which case the sequence has to be loaded by LoadSequence(). Can be called concurrently.
+    bool TryParseSequence(const char* begin, const char* end, const SequenceDescriptor& descriptor, SequenceBuffer& sequence);
+
     // Fills some metadata members to be conformant to the exposed SequenceData interface.
     void FillSequenceMetadata(SequenceBuffer& sequenceBuffer, const SequenceKey& sequenceKey);
 
@@ -203,6 +212,8 @@ private:
 
     void SetCacheIndex(bool value);
 
+    void SetUseInMemoryParser(bool value);
+
     friend class CNTKTextFormatReaderTestRunner<ElemType>;
 
     DISABLE_COPY_AND_MOVE(TextParser);
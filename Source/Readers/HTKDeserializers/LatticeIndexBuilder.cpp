@@ -41,6 +41,14 @@ namespace CNTK {
         return wss.str();
     }
 
+    /*virtual*/ uint64_t LatticeIndexBuilder::AuxiliaryInputHash() /*override*/
+    {
+        auto hash = Hash(&m_lastChunkInTOC, sizeof(m_lastChunkInTOC));
+        for (const auto& line : m_latticeToc)
+            hash = Hash(line.data(), line.size() + 1, hash); // including the terminating zero as a separator
+        return hash;
+    }
+
     void LatticeIndexBuilder::AddSequence(shared_ptr<Index>& index, size_t id, size_t byteOffset, size_t prevSequenceStartOffset, const string& seqKey)
     {
         IndexedSequence sequence;
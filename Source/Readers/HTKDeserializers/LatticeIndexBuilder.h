@@ -19,6 +19,10 @@ namespace CNTK {
 
     private:
         virtual void Populate(std::shared_ptr<Index>& index) override;
+
+        // The index is built from the TOC, a change of it invalidates the cache as well.
+        virtual uint64_t AuxiliaryInputHash() override;
+
         void AddSequence(std::shared_ptr<Index>& index, size_t id, size_t byteOffset, size_t prevSequenceStartOffset, const std::string& seqKey);
         std::vector<std::string> m_latticeToc;
         bool m_lastChunkInTOC;
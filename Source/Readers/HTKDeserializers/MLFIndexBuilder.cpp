@@ -53,7 +53,8 @@ namespace CNTK {
     {
         m_input.CheckIsOpenOrDie();
 
-        index->Reserve(filesize(m_input.File()));
+        auto fileSize = filesize(m_input.File());
+        index->Reserve(fileSize);
 
         BufferedFileReader reader(m_bufferSize, m_input);
 
@@ -63,9 +64,69 @@ namespace CNTK {
         if (!m_corpus)
             RuntimeError("MLFIndexBuilder: corpus descriptor was not specified.");
 
+        // Without hashing, symbolic keys are assigned ids in the order they are seen,
+        // such input has to be indexed sequentially.
+        vector<InputRange> ranges;
+        if (m_corpus->IsNumericSequenceKeys() || m_corpus->IsHashingEnabled())
+            ranges = SplitInput(0, fileSize, TryMoveToUtteranceKey);
 
+        if (ranges.size() < 2)
+        {
+            IndexUtterances(reader, fileSize, State::Header,
+                [&index](const IndexedSequence& sequence) { index->AddSequence(sequence); },
+                [](const string& warning) { fprintf(stderr, "%s", warning.c_str()); });
+            return;
+        }
+
+        // Sequences and warnings of each range are collected and passed on in the order of the ranges.
+        vector<vector<IndexedSequence>> sequences(ranges.size());
+        vector<string> warnings(ranges.size());
+        IndexInParallel(ranges,
+            [&](size_t i)
+            {
+                auto rangeReader = i == 0 ? nullptr : OpenReader(ranges[i].m_begin);
+                IndexUtterances(i == 0 ? reader : *rangeReader, ranges[i].m_end, i == 0 ? State::Header : State::UtteranceKey,
+                    [&](const IndexedSequence& sequence) { sequences[i].push_back(sequence); },
+                    [&](const string& warning) { warnings[i] += warning; });
+            },
+            [&](size_t i)
+            {
+                fprintf(stderr, "%s", warnings[i].c_str());
+                for (const auto& sequence : sequences[i])
+                    index->AddSequence(sequence);
+                vector<IndexedSequence>().swap(sequences[i]);
+            });
+    }
+
+    // Moves the reader to the beginning of an utterance: the line following a single dot, 
+    // which ends the previous utterance. A dot right after the header or another dot would be
+    // taken for an utterance key though, such lines are skipped.
+    /*static*/ bool MLFIndexBuilder::TryMoveToUtteranceKey(BufferedFileReader& reader)
+    {
+        if (!reader.TryMoveToNextLine())
+            return false;
+
+        string line, previousLine;
+        while (reader.TryReadLine(line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            if (line.empty())
+                continue;
+
+            if (line == "." && !previousLine.empty() && previousLine != "." && previousLine != "#!MLF!#")
+                return true;
+
+            previousLine.swap(line);
+        }
+        return false;
+    }
+
+    void MLFIndexBuilder::IndexUtterances(BufferedFileReader& reader, size_t end, State currentState,
+        const function<void(const IndexedSequence&)>& add, const function<void(const string&)>& warn)
+    {
         size_t id = 0;
-        State currentState = State::Header;
         vector<boost::iterator_range<char*>> tokens;
         bool isValid = true; // Flag indicating whether the current sequence is valid.
         size_t sequenceStartOffset = 0; // Offset in file where current sequence starts.
@@ -76,7 +137,7 @@ namespace CNTK {
         {
             auto offset = reader.GetFileOffset();
 
-            if (!reader.TryReadLine(line))
+            if (offset >= end || !reader.TryReadLine(line))
                 break;
 
             if (!line.empty() && line.back() == '\r')
@@ -141,10 +202,10 @@ namespace CNTK {
                         .SetNumberOfSamples(numberOfSamples)
                         .SetOffset(sequenceStartOffset)
                         .SetSize(sequenceEndOffset - sequenceStartOffset);
-                    index->AddSequence(sequence);
+                    add(sequence);
                 }
                 else
-                    fprintf(stderr, "WARNING: Cannot parse the utterance '%s' at offset (%" PRIu64 ")\n", m_corpus->IdToKey(id).c_str(), sequenceStartOffset);
+                    warn(msra::strfun::strprintf("WARNING: Cannot parse the utterance '%s' at offset (%" PRIu64 ")\n", m_corpus->IdToKey(id).c_str(), sequenceStartOffset));
                 currentState = State::UtteranceKey; // Let's try the next one.
             }
             break;
@@ -154,7 +215,6 @@ namespace CNTK {
         }
     }
 
-
     // Tries to parse sequence key
     // In MLF a sequence key should be in quotes. During parsing the extension should be removed.
     bool MLFIndexBuilder::TryParseSequenceKey(const string& line, size_t& id, function<size_t(const string&)> keyToId)
@@ -28,6 +28,14 @@ namespace CNTK {
             UtteranceFrames
         };
 
+        // Indexes the utterances that start before the end offset, beginning at the current reader position
+        // in the given state. Sequences are passed to add, warnings about invalid utterances to warn.
+        void IndexUtterances(BufferedFileReader& reader, size_t end, State state,
+            const std::function<void(const IndexedSequence&)>& add, const std::function<void(const std::string&)>& warn);
+
+        // Finds the first offset after the reader position at which an utterance starts, see SplitInput().
+        static bool TryMoveToUtteranceKey(BufferedFileReader& reader);
+
         inline bool TryParseSequenceKey(const std::string& line, size_t& id, std::function<size_t(const std::string&)> keyToId);
     };
 
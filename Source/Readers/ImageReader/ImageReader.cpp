@@ -64,20 +64,28 @@ ImageReader::ImageReader(const ConfigParameters& config)
     ConfigParameters featureStream = config(featureName);
 
     std::vector<Transformation> transformations;
-    transformations.push_back(Transformation{ std::make_shared<CropTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ScaleTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<ColorTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<IntensityTransformer>(featureStream), featureName });
-    transformations.push_back(Transformation{ std::make_shared<MeanTransformer>(featureStream), featureName });
-
-    if (configHelper.GetDataFormat() == CHW)
+    if (featureStream(L"fuseTransforms", false))
     {
-        transformations.push_back(Transformation{ std::make_shared<TransposeTransformer>(featureStream), featureName });
+        // The same steps as below, without an intermediate image per step where possible.
+        transformations.push_back(Transformation{ std::make_shared<FusedImageTransformer>(featureStream, configHelper.GetDataFormat() == CHW), featureName });
     }
+    else
+    {
+        transformations.push_back(Transformation{ std::make_shared<CropTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<ScaleTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<ColorTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<IntensityTransformer>(featureStream), featureName });
+        transformations.push_back(Transformation{ std::make_shared<MeanTransformer>(featureStream), featureName });
 
-    // We should always have cast at the end. 
-    // It is noop if the matrix element type is already expected by the packer.
-    transformations.push_back(Transformation{ std::make_shared<CastTransformer>(featureStream), featureName });
+        if (configHelper.GetDataFormat() == CHW)
+        {
+            transformations.push_back(Transformation{ std::make_shared<TransposeTransformer>(featureStream), featureName });
+        }
+
+        // We should always have cast at the end. 
+        // It is noop if the matrix element type is already expected by the packer.
+        transformations.push_back(Transformation{ std::make_shared<CastTransformer>(featureStream), featureName });
+    }
 
     m_sequenceEnumerator = std::make_shared<TransformController>(transformations, randomizer);
     bool useLocalTimeline = true;
@@ -7,6 +7,10 @@
 #include <algorithm>
 #include <unordered_map>
 #include <random>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include <boost/random/bernoulli_distribution.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include "ImageTransformers.h"
@@ -126,24 +130,35 @@ StreamInformation CropTransformer::Transform(const StreamInformation& inputStrea
 }
 
 void CropTransformer::Apply(uint8_t copyId, cv::Mat &mat, int indexInBatch)
+{
+    bool flip;
+    mat = mat(GetCropRect(copyId, mat.rows, mat.cols, indexInBatch, flip));
+    if (flip)
+    {
+        cv::flip(mat, mat, 1);
+    }
+}
+
+cv::Rect CropTransformer::GetCropRect(uint8_t copyId, int crow, int ccol, int indexInBatch, bool& flip)
 {
     auto seed = GetSeed();
     auto rng = m_rngs.at_or_create(indexInBatch, [seed](int offset) { return std::make_unique<std::mt19937>(seed + offset); });
     int viewIndex = m_cropType == CropType::MultiView10 ? (int)(copyId % ImageDeserializerBase::NumMultiViewCopies) : 0;
 
+    cv::Rect rect;
     switch (m_cropType)
     {
     case CropType::Center: 
-        mat = mat(GetCropRectCenter(mat.rows, mat.cols, *rng));
+        rect = GetCropRectCenter(crow, ccol, *rng);
         break; 
     case CropType::RandomSide: 
-        mat = mat(GetCropRectRandomSide(mat.rows, mat.cols, *rng)); 
+        rect = GetCropRectRandomSide(crow, ccol, *rng);
         break; 
     case CropType::RandomArea: 
-        mat = mat(GetCropRectRandomArea(mat.rows, mat.cols, *rng));
+        rect = GetCropRectRandomArea(crow, ccol, *rng);
         break;
     case CropType::MultiView10: 
-        mat = mat(GetCropRectMultiView10(viewIndex, mat.rows, mat.cols, *rng));
+        rect = GetCropRectMultiView10(viewIndex, crow, ccol, *rng);
         break; 
     default: 
         RuntimeError("Invalid crop type."); 
@@ -151,13 +166,11 @@ void CropTransformer::Apply(uint8_t copyId, cv::Mat &mat, int indexInBatch)
     }
 
     // for MultiView10 m_hFlip is false, hence the first 5 will be unflipped, the later 5 will be flipped
-    if ((m_hFlip && boost::random::bernoulli_distribution<>()(*rng)) ||
-        viewIndex >= 5)
-    {
-        cv::flip(mat, mat, 1);
-    }
+    flip = (m_hFlip && boost::random::bernoulli_distribution<>()(*rng)) ||
+        viewIndex >= 5;
 
     m_rngs.assignTo(indexInBatch, std::move(rng));
+    return rect;
 }
 
 CropTransformer::RatioJitterType
@@ -626,7 +639,7 @@ void IntensityTransformer::StartEpoch(const EpochConfiguration &config)
 
 void IntensityTransformer::Apply(uint8_t, cv::Mat &mat, int indexInBatch)
 {
-    if (m_eigVal.empty() || m_eigVec.empty() || m_stdDev == 0.0)
+    if (!IsEnabled())
         return;
 
     // Have to convert to float.
@@ -642,8 +655,7 @@ void IntensityTransformer::Apply(uint8_t, cv::Mat &mat, int indexInBatch)
         RuntimeError("Unsupported type");
 }
 
-template <typename ElemType>
-void IntensityTransformer::Apply(cv::Mat &mat, int indexInBatch)
+cv::Mat IntensityTransformer::DrawShifts(int indexInBatch)
 {
     auto seed = GetSeed();
     auto rng = m_rngs.at_or_create(indexInBatch, [seed](int offset) { return std::make_unique<std::mt19937>(seed + offset); });
@@ -659,7 +671,13 @@ void IntensityTransformer::Apply(cv::Mat &mat, int indexInBatch)
 
     assert(m_eigVec.rows == 3 && m_eigVec.cols == 3);
 
-    cv::Mat shifts = m_eigVec * alphas.t();
+    return m_eigVec * alphas.t();
+}
+
+template <typename ElemType>
+void IntensityTransformer::Apply(cv::Mat &mat, int indexInBatch)
+{
+    cv::Mat shifts = DrawShifts(indexInBatch);
 
     // For multi-channel images data is in BGR format.
     size_t cdst = mat.rows * mat.cols * mat.channels();
@@ -699,7 +717,7 @@ void ColorTransformer::StartEpoch(const EpochConfiguration &config)
 
 void ColorTransformer::Apply(uint8_t, cv::Mat &mat, int indexInBatch)
 {
-    if (m_brightnessRadius == 0.0 && m_contrastRadius == 0.0 && m_saturationRadius == 0.0)
+    if (!IsEnabled())
         return;
 
     // Have to convert to float
@@ -713,12 +731,33 @@ void ColorTransformer::Apply(uint8_t, cv::Mat &mat, int indexInBatch)
         RuntimeError("Unsupported type");
 }
 
-template <typename ElemType>
-void ColorTransformer::Apply(cv::Mat &mat, int indexInBatch)
+ColorTransformer::Jitter ColorTransformer::DrawJitter(int indexInBatch, int channels)
 {
     auto seed = GetSeed();
     auto rng = m_rngs.at_or_create(indexInBatch, [seed](int offset) { return std::make_unique<std::mt19937>(seed + offset); });
 
+    Jitter jitter;
+    if (m_brightnessRadius > 0)
+        jitter.m_brightness = UniRealT(-m_brightnessRadius, m_brightnessRadius)(*rng);
+
+    if (m_contrastRadius > 0)
+        jitter.m_contrast = 1 + UniRealT(-m_contrastRadius, m_contrastRadius)(*rng);
+
+    if (m_saturationRadius > 0 && channels == 3)
+    {
+        jitter.m_saturation = 1.0 + UniRealT(-m_saturationRadius, m_saturationRadius)(*rng);
+        assert(0 <= jitter.m_saturation && jitter.m_saturation <= 2);
+    }
+
+    m_rngs.assignTo(indexInBatch, std::move(rng));
+    return jitter;
+}
+
+template <typename ElemType>
+void ColorTransformer::Apply(cv::Mat &mat, int indexInBatch)
+{
+    Jitter jitter = DrawJitter(indexInBatch, mat.channels());
+
     if (m_brightnessRadius > 0 || m_contrastRadius > 0)
     {
         // To change brightness and/or contrast the following standard transformation is used:
@@ -727,19 +766,13 @@ void ColorTransformer::Apply(cv::Mat &mat, int indexInBatch)
         ElemType beta = 0;
         if (m_brightnessRadius > 0)
         {
-            UniRealT d(-m_brightnessRadius, m_brightnessRadius);
             // Compute mean value of the image.
             cv::Scalar imgMean = cv::sum(cv::sum(mat));
             // Compute beta as a fraction of the mean.
-            beta = (ElemType)(d(*rng) * imgMean[0] / (mat.rows * mat.cols * mat.channels()));
+            beta = (ElemType)(jitter.m_brightness * imgMean[0] / (mat.rows * mat.cols * mat.channels()));
         }
 
-        ElemType alpha = 1;
-        if (m_contrastRadius > 0)
-        {
-            UniRealT d(-m_contrastRadius, m_contrastRadius);
-            alpha = (ElemType)(1 + d(*rng));
-        }
+        ElemType alpha = (ElemType)jitter.m_contrast;
 
         // Could potentially use mat.convertTo(mat, -1, alpha, beta) 
         // but it does not do range checking for single/double precision matrix. saturate_cast won't work either.
@@ -753,9 +786,7 @@ void ColorTransformer::Apply(cv::Mat &mat, int indexInBatch)
 
     if (m_saturationRadius > 0 && mat.channels() == 3)
     {
-        UniRealT d(-m_saturationRadius, m_saturationRadius);
-        double ratio = 1.0 + d(*rng);
-        assert(0 <= ratio && ratio <= 2);
+        double ratio = jitter.m_saturation;
 
         auto hsv = m_hsvTemp.pop_or_create([]() { return std::make_unique<cv::Mat>(); });
 
@@ -774,8 +805,6 @@ void ColorTransformer::Apply(cv::Mat &mat, int indexInBatch)
 
         m_hsvTemp.push(std::move(hsv));
     }
-
-    m_rngs.assignTo(indexInBatch, std::move(rng));
 }
 
 CastTransformer::CastTransformer(const ConfigParameters& config) : TransformBase(config), m_floatTransform(this), m_doubleTransform(this)
@@ -855,4 +884,259 @@ SequenceDataPtr CastTransformer::TypedCast<TElementTo>::Apply(SequenceDataPtr se
     return result;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bilinear resampling of an 8-bit image of srcWidth x srcHeight pixels to width x height pixels, with the pixel centers
+// of cv::resize(INTER_LINEAR), mirrored horizontally if 'flip' is set. Channel c of the pixel (x, y) of the result
+// goes to dst[c * planeStride + (y * width + x) * pixelStride], which writes the result either as HWC or as CHW.
+// Returns the sum of all values of the result.
+static uint64_t ResampleBilinear(const uint8_t* src, size_t srcStep, int srcWidth, int srcHeight, int channels, bool flip,
+                                 int width, int height, uint8_t* dst, size_t planeStride, size_t pixelStride,
+                                 std::vector<int>& columns, std::vector<float>& columnWeights)
+{
+    // Maps the output coordinate i to the two source coordinates and the weight of the second one.
+    auto map = [](int i, double scale, int size, int& index0, int& index1, float& weight)
+    {
+        float f = (float)((i + 0.5) * scale - 0.5);
+        index0 = (int)std::floor(f);
+        weight = f - index0;
+        if (index0 < 0)
+        {
+            index0 = 0;
+            weight = 0;
+        }
+        if (index0 >= size - 1)
+        {
+            index0 = size - 1;
+            weight = 0;
+        }
+        index1 = weight == 0 ? index0 : index0 + 1;
+    };
+
+    columns.resize(2 * width);
+    columnWeights.resize(width);
+    for (int x = 0; x < width; x++)
+    {
+        // Resampling the mirrored crop is the same as mirroring the resampled one.
+        int i = flip ? width - 1 - x : x;
+        map(x, (double)srcWidth / width, srcWidth, columns[2 * i], columns[2 * i + 1], columnWeights[i]);
+        columns[2 * i] *= channels;
+        columns[2 * i + 1] *= channels;
+    }
+
+    uint64_t sum = 0;
+    for (int y = 0; y < height; y++)
+    {
+        int y0, y1;
+        float b;
+        map(y, (double)srcHeight / height, srcHeight, y0, y1, b);
+
+        const uint8_t* row0 = src + y0 * srcStep;
+        const uint8_t* row1 = src + y1 * srcStep;
+        uint8_t* out = dst + (size_t)y * width * pixelStride;
+        for (int x = 0; x < width; x++, out += pixelStride)
+        {
+            const int x0 = columns[2 * x], x1 = columns[2 * x + 1];
+            const float a = columnWeights[x];
+            for (int c = 0; c < channels; c++)
+            {
+                float top = row0[x0 + c] + a * (row0[x1 + c] - row0[x0 + c]);
+                float bottom = row1[x0 + c] + a * (row1[x1 + c] - row1[x0 + c]);
+                int value = (int)(top + b * (bottom - top) + 0.5f);
+                out[c * planeStride] = (uint8_t)value;
+                sum += value;
+            }
+        }
+    }
+    return sum;
+}
+
+#ifdef __AVX2__
+// AVX2 version of ApplyPixelArithmetic() below for consecutive values. Returns the number of values done.
+static size_t ApplyPixelArithmeticAVX2(const uint8_t* pixels, size_t count, float alpha, float beta, float shift, const float* mean, float* result)
+{
+    const __m256 a = _mm256_set1_ps(alpha);
+    const __m256 b = _mm256_set1_ps(beta);
+    const __m256 s = _mm256_set1_ps(shift);
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + i))));
+        v = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(v, a), b), lo), hi);
+        v = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(v, s), lo), hi);
+        if (mean)
+            v = _mm256_sub_ps(v, _mm256_loadu_ps(mean + i));
+        _mm256_storeu_ps(result + i, v);
+    }
+    return i;
+}
+#endif
+
+// The color, intensity and mean steps for 'count' values of one channel, 'stride' apart:
+//   result = clamp(clamp(alpha * pixel + beta) + shift) - mean, with clamp() to [0, 255].
+// As the pixels are in [0, 255], the defaults of a disabled step (alpha = 1, beta = shift = 0, no mean) leave them unchanged.
+template <class TElement>
+static void ApplyPixelArithmetic(const uint8_t* pixels, size_t count, size_t stride, TElement alpha, TElement beta, TElement shift,
+                                 const TElement* mean, TElement* result)
+{
+    size_t i = 0;
+#ifdef __AVX2__
+    if (std::is_same<TElement, float>::value && stride == 1)
+        i = ApplyPixelArithmeticAVX2(pixels, count, (float)alpha, (float)beta, (float)shift,
+                                     reinterpret_cast<const float*>(mean), reinterpret_cast<float*>(result));
+#endif
+    for (; i < count; i++)
+    {
+        TElement value = std::min(std::max(pixels[i * stride] * alpha + beta, (TElement)0), (TElement)255);
+        value = std::min(std::max(value + shift, (TElement)0), (TElement)255);
+        result[i * stride] = mean ? value - mean[i * stride] : value;
+    }
+}
+
+FusedImageTransformer::FusedImageTransformer(const ConfigParameters& config, bool transpose) : TransformBase(config),
+    m_crop(std::make_shared<CropTransformer>(config)),
+    m_scale(std::make_shared<ScaleTransformer>(config)),
+    m_color(std::make_shared<ColorTransformer>(config)),
+    m_intensity(std::make_shared<IntensityTransformer>(config)),
+    m_mean(std::make_shared<MeanTransformer>(config)),
+    m_transpose(transpose)
+{
+    m_chain = { m_crop, m_scale, m_color, m_intensity, m_mean };
+    if (m_transpose)
+        m_chain.push_back(std::make_shared<TransposeTransformer>(config));
+    m_chain.push_back(std::make_shared<CastTransformer>(config));
+
+    m_fusable = m_scale->m_scaleMode == ScaleTransformer::ScaleMode::Fill &&
+                m_scale->m_interp == cv::INTER_LINEAR &&
+                m_color->m_saturationRadius == 0;
+
+    const cv::Mat& meanImage = m_mean->m_meanImg;
+    if (meanImage.empty())
+        return;
+
+    int width = (int)m_scale->m_imgWidth;
+    int height = (int)m_scale->m_imgHeight;
+    int channels = (int)m_scale->m_imgChannels;
+    if (meanImage.cols != width || meanImage.rows != height || meanImage.channels() != channels)
+    {
+        // The mean transform warns about it per image.
+        m_fusable = false;
+        return;
+    }
+
+    // Bring the mean image into the layout of the output.
+    cv::Mat mean;
+    meanImage.convertTo(mean, CV_64F);
+    m_doubleMean.resize((size_t)width * height * channels);
+    for (int y = 0; y < height; y++)
+    {
+        const double* row = mean.ptr<double>(y);
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < channels; c++)
+            {
+                size_t index = m_transpose ? ((size_t)c * height + y) * width + x : ((size_t)y * width + x) * channels + c;
+                m_doubleMean[index] = row[x * channels + c];
+            }
+    }
+    m_floatMean.assign(m_doubleMean.begin(), m_doubleMean.end());
+}
+
+void FusedImageTransformer::StartEpoch(const EpochConfiguration &config)
+{
+    for (auto& t : m_chain)
+        t->StartEpoch(config);
+}
+
+StreamInformation FusedImageTransformer::Transform(const StreamInformation& inputStream)
+{
+    m_outputStream = TransformBase::Transform(inputStream);
+    for (auto& t : m_chain)
+        m_outputStream = t->Transform(m_outputStream);
+
+    return m_outputStream;
+}
+
+bool FusedImageTransformer::CanFuse(const ImageSequenceData& sequence) const
+{
+    const cv::Mat& image = sequence.m_image;
+    return m_fusable &&
+        image.depth() == CV_8U &&
+        image.channels() == (int)m_scale->m_imgChannels &&
+        image.rows > 0 && image.cols > 0 &&
+        sequence.m_numberOfSamples == 1;
+}
+
+SequenceDataPtr FusedImageTransformer::Transform(SequenceDataPtr sequence, int indexInBatch)
+{
+    auto inputSequence = dynamic_cast<ImageSequenceData*>(sequence.get());
+    if (inputSequence == nullptr || !CanFuse(*inputSequence))
+    {
+        for (auto& t : m_chain)
+            sequence = t->Transform(sequence, indexInBatch);
+        return sequence;
+    }
+
+    if (m_precision == DataType::Float)
+        return Apply<float>(*inputSequence, indexInBatch, m_floatMean, m_floatBuffers);
+    return Apply<double>(*inputSequence, indexInBatch, m_doubleMean, m_doubleBuffers);
+}
+
+template <class TElementTo>
+SequenceDataPtr FusedImageTransformer::Apply(ImageSequenceData& sequence, int indexInBatch,
+                                             const std::vector<TElementTo>& mean, conc_stack<std::vector<TElementTo>>& memBuffers)
+{
+    const cv::Mat& image = sequence.m_image;
+    const int width = (int)m_scale->m_imgWidth;
+    const int height = (int)m_scale->m_imgHeight;
+    const int channels = image.channels();
+
+    // Random parameters, drawn by the transforms of the individual steps.
+    bool flip;
+    cv::Rect crop = m_crop->GetCropRect(sequence.m_copyIndex, image.rows, image.cols, indexInBatch, flip);
+
+    ColorTransformer::Jitter jitter;
+    if (m_color->IsEnabled())
+        jitter = m_color->DrawJitter(indexInBatch, channels);
+
+    cv::Mat shifts;
+    if (m_intensity->IsEnabled())
+        shifts = m_intensity->DrawShifts(indexInBatch);
+
+    // Pass 1: crop, flip and scale into the 8-bit scratch buffer, in the layout of the output.
+    const size_t planeSize = (size_t)width * height;
+    const size_t count = planeSize * channels;
+    const size_t planeStride = m_transpose ? planeSize : 1;
+    const size_t pixelStride = m_transpose ? 1 : channels;
+
+    auto scratch = m_scratch.pop_or_create([]() { return std::make_unique<Scratch>(); });
+    scratch->m_pixels.resize(count);
+    uint64_t sum = ResampleBilinear(image.ptr<uint8_t>(crop.y) + crop.x * channels, image.step, crop.width, crop.height, channels, flip,
+                                    width, height, scratch->m_pixels.data(), planeStride, pixelStride,
+                                    scratch->m_columns, scratch->m_columnWeights);
+
+    // Pass 2: color, intensity and mean, cast to the output type.
+    auto result = std::make_shared<DenseSequenceWithBuffer<TElementTo>>(memBuffers, count, m_outputStream.m_sampleLayout);
+    TElementTo* output = result->GetBuffer();
+
+    TElementTo alpha = (TElementTo)jitter.m_contrast;
+    TElementTo beta = (TElementTo)(jitter.m_brightness * sum / count);
+    for (int c = 0; c < channels; c++)
+    {
+        // For multi-channel images data is in BGR format.
+        TElementTo shift = shifts.empty() ? 0 : (TElementTo)shifts.at<float>(channels - c - 1);
+        size_t offset = c * planeStride;
+        ApplyPixelArithmetic(scratch->m_pixels.data() + offset, planeSize, pixelStride, alpha, beta, shift,
+                             mean.empty() ? nullptr : mean.data() + offset, output + offset);
+    }
+    m_scratch.push(std::move(scratch));
+
+    result->m_key = sequence.m_key;
+    result->m_numberOfSamples = sequence.m_numberOfSamples;
+    result->m_elementType = m_precision;
+    return result;
+}
+
 }
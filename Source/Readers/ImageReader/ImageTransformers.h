@@ -115,6 +115,9 @@ private:
     cv::Rect GetCropRectRandomArea(int crow, int ccol, std::mt19937 &rng);
     cv::Rect GetCropRectMultiView10(int viewIndex, int crow, int ccol, std::mt19937 &rng);
 
+    // Draws the crop rectangle of the image and whether it is flipped horizontally.
+    cv::Rect GetCropRect(uint8_t copyId, int crow, int ccol, int indexInBatch, bool& flip);
+
     Microsoft::MSR::CNTK::conc_vector<std::unique_ptr<std::mt19937>> m_rngs;
     CropType m_cropType; 
     int m_cropWidth; 
@@ -131,6 +134,8 @@ private:
 
     RatioJitterType m_jitterType;
     bool m_hFlip;
+
+    friend class FusedImageTransformer;
 };
 
 // Scale transformation of the image.
@@ -159,6 +164,8 @@ private:
     int m_interp;
     int m_borderType;
     int m_padValue;
+
+    friend class FusedImageTransformer;
 };
 
 // Mean transformation.
@@ -171,6 +178,8 @@ private:
     void Apply(uint8_t copyId, cv::Mat &mat, int indexInBatch) override;
 
     cv::Mat m_meanImg;
+
+    friend class FusedImageTransformer;
 };
 
 // Transpose transformation from HWC to CHW (note: row-major notation).
@@ -223,12 +232,22 @@ private:
     template <typename ElemType>
     void Apply(cv::Mat &mat, int indexInBatch);
 
+    bool IsEnabled() const
+    {
+        return !m_eigVal.empty() && !m_eigVec.empty() && m_stdDev != 0.0;
+    }
+
+    // Draws the shifts of the B, G and R channels, in this order.
+    cv::Mat DrawShifts(int indexInBatch);
+
     double m_stdDev;
 
     cv::Mat m_eigVal;
     cv::Mat m_eigVec;
 
     Microsoft::MSR::CNTK::conc_vector<std::unique_ptr<std::mt19937>> m_rngs;
+
+    friend class FusedImageTransformer;
 };
 
 // Color jittering transform based on the paper: http://arxiv.org/abs/1312.5402
@@ -245,12 +264,29 @@ private:
     template <typename ElemType>
     void Apply(cv::Mat &mat, int indexInBatch);
 
+    bool IsEnabled() const
+    {
+        return m_brightnessRadius != 0.0 || m_contrastRadius != 0.0 || m_saturationRadius != 0.0;
+    }
+
+    // Random parameters of the transform for one image.
+    struct Jitter
+    {
+        double m_brightness = 0; // fraction of the image mean that is added to the pixels
+        double m_contrast = 1;   // factor of the pixels
+        double m_saturation = 1; // factor of the saturation
+    };
+
+    Jitter DrawJitter(int indexInBatch, int channels);
+
     double m_brightnessRadius;
     double m_contrastRadius;
     double m_saturationRadius;
 
     Microsoft::MSR::CNTK::conc_vector<std::unique_ptr<std::mt19937>> m_rngs;
     Microsoft::MSR::CNTK::conc_stack<std::unique_ptr<cv::Mat>> m_hsvTemp;
+
+    friend class FusedImageTransformer;
 };
 
 // Cast the input to a particular type.
@@ -288,4 +324,61 @@ private:
     TypedCast<double> m_doubleTransform;
 };
 
+// Crop, scale, color, intensity, mean, transpose and cast as a single transform, for 8-bit images.
+// The parameters of each step, including the random ones, come from the transformer of that step, constructed
+// from the same config, so that the result is the same as of the chain of transforms up to rounding of the
+// interpolation (+/-1 gray level). Instead of a cv::Mat per step, the pixels are processed in two passes:
+// bilinear resampling of the (flipped) crop into an 8-bit scratch buffer, which also sums the pixels for the
+// brightness, and the color, intensity and mean arithmetic that writes straight into the typed output buffer.
+// Both buffers are pooled. Images or configs the fused path does not support (other scale modes or interpolations,
+// saturation jitter, non-8-bit images) go through the chain of transforms.
+class FusedImageTransformer : public TransformBase
+{
+public:
+    FusedImageTransformer(const Microsoft::MSR::CNTK::ConfigParameters& config, bool transpose);
+
+    void StartEpoch(const EpochConfiguration &config) override;
+
+    // Transformation of the stream.
+    StreamInformation Transform(const StreamInformation& inputStream) override;
+
+    // Transformation of the sequence.
+    SequenceDataPtr Transform(SequenceDataPtr sequence, int indexInBatch) override;
+
+private:
+    // Per-image buffers of the resampling pass.
+    struct Scratch
+    {
+        std::vector<uint8_t> m_pixels;
+        std::vector<int> m_columns;
+        std::vector<float> m_columnWeights;
+    };
+
+    bool CanFuse(const ImageSequenceData& sequence) const;
+
+    template <class TElementTo>
+    SequenceDataPtr Apply(ImageSequenceData& sequence, int indexInBatch,
+                          const std::vector<TElementTo>& mean, Microsoft::MSR::CNTK::conc_stack<std::vector<TElementTo>>& memBuffers);
+
+    std::shared_ptr<CropTransformer> m_crop;
+    std::shared_ptr<ScaleTransformer> m_scale;
+    std::shared_ptr<ColorTransformer> m_color;
+    std::shared_ptr<IntensityTransformer> m_intensity;
+    std::shared_ptr<MeanTransformer> m_mean;
+
+    // The same steps as individual transforms, for the fallback.
+    std::vector<TransformerPtr> m_chain;
+
+    bool m_transpose;
+    bool m_fusable; // whether the config of the steps allows fusing
+
+    // Mean image in the output layout, empty if there is none.
+    std::vector<float> m_floatMean;
+    std::vector<double> m_doubleMean;
+
+    Microsoft::MSR::CNTK::conc_stack<std::vector<float>> m_floatBuffers;
+    Microsoft::MSR::CNTK::conc_stack<std::vector<double>> m_doubleBuffers;
+    Microsoft::MSR::CNTK::conc_stack<std::unique_ptr<Scratch>> m_scratch;
+};
+
 }
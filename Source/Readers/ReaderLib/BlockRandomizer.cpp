@@ -41,6 +41,7 @@ BlockRandomizer::BlockRandomizer(
     assert(deserializer != nullptr);
 
     m_launchType = shouldPrefetch ? launch::async : launch::deferred;
+    m_chunkCache = std::dynamic_pointer_cast<ChunkCache>(deserializer);
 
     m_streams = m_deserializer->StreamInfos();
     m_sequenceRandomizer = std::make_shared<SequenceRandomizer>(verbosity, m_deserializer, m_chunkRandomizer);
@@ -96,6 +97,20 @@ void BlockRandomizer::StartEpoch(const EpochConfiguration& config)
                 m_globalSamplePosition,
                 config.m_workerRank,
                 config.m_numberOfWorkers);
+
+        if (m_chunkCache)
+        {
+            auto statistics = m_chunkCache->GetStatistics();
+            std::string limit = m_chunkCache->GetMaxSizeInBytes() == 0 ? "no limit" : std::to_string(m_chunkCache->GetMaxSizeInBytes() >> 20) + " MB limit";
+            fprintf(stderr, "BlockRandomizer::StartEpoch: chunk cache: %" PRIu64 " chunks (%" PRIu64 " MB, %s), %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions, %" PRIu64 " prefetches\n",
+                    statistics.m_numberOfChunks,
+                    statistics.m_sizeInBytes >> 20,
+                    limit.c_str(),
+                    statistics.m_hits,
+                    statistics.m_misses,
+                    statistics.m_evictions,
+                    statistics.m_prefetches);
+        }
     }
 }
 
@@ -454,6 +469,16 @@ void BlockRandomizer::Prefetch(ChunkIdType chunkId)
     // Start new prefetch if necessary.
     if (m_prefetchedChunk != chunkId && chunkId != ChunkIdMax)
     {
+        // The cache loads the chunk on its own thread and keeps it, GetChunk() picks it up from there.
+        if (m_chunkCache && m_launchType == launch::async)
+        {
+            m_prefetchedChunk = chunkId;
+            m_chunkCache->Prefetch(chunkId);
+            if (m_verbosity >= Debug)
+                fprintf(stderr, "BlockRandomizer::Prefetch: prefetching original chunk into cache: %u\n", chunkId);
+            return;
+        }
+
         // Wait to make sure there is no outstanding prefetches.
         if (m_prefetch.valid())
         {
@@ -12,6 +12,7 @@
 #include "ChunkRandomizer.h"
 #include "SequenceRandomizer.h"
 #include "ReaderUtil.h"
+#include "ChunkCache.h"
 #include <future>
 
 namespace CNTK {
@@ -159,6 +160,8 @@ private:
     launch m_launchType;
     // Prefetched original chunk id.
     ChunkIdType m_prefetchedChunk;
+    // Set if the deserializer is a chunk cache, which then does the prefetch.
+    std::shared_ptr<ChunkCache> m_chunkCache;
 
     // Current loaded chunks.
     ClosedOpenChunkInterval m_currentWindowRange;
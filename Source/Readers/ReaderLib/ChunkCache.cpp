@@ -9,18 +9,168 @@
 
 namespace CNTK {
 
+ChunkCache::ChunkCache(DataDeserializerPtr deserializer, size_t maxSizeInBytes)
+    : m_deserializer(deserializer), m_maxSizeInBytes(maxSizeInBytes), m_stopPrefetch(false)
+{
+    auto streams = m_deserializer->StreamInfos();
+    for (const auto& chunk : m_deserializer->ChunkInfos())
+    {
+        if (chunk.m_id >= m_chunkSizes.size())
+            m_chunkSizes.resize(chunk.m_id + 1, 0);
+        m_chunkSizes[chunk.m_id] = EstimateChunkSize(chunk, streams);
+    }
+}
+
+ChunkCache::~ChunkCache()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_stopPrefetch = true;
+    }
+    m_prefetchRequested.notify_all();
+    if (m_prefetchThread.joinable())
+        m_prefetchThread.join();
+}
+
+/*static*/ size_t ChunkCache::EstimateChunkSize(const ChunkInfo& chunk, const std::vector<StreamInformation>& streams)
+{
+    const size_t sequenceOverhead = 128; // sequence data objects and their bookkeeping
+
+    size_t bytesPerSample = 0;
+    for (const auto& stream : streams)
+    {
+        size_t elementSize = stream.m_elementType == DataType::Unknown ? sizeof(float) : DataTypeSize(stream.m_elementType);
+        if (stream.m_storageFormat != StorageFormat::Dense)
+            bytesPerSample += elementSize + sizeof(SparseIndexType);
+        else if (stream.m_sampleLayout.IsUnknown() || stream.m_sampleLayout.HasUnboundDimension())
+            bytesPerSample += elementSize;
+        else
+            bytesPerSample += elementSize * stream.m_sampleLayout.TotalSize();
+    }
+    return chunk.m_numberOfSamples * bytesPerSample + chunk.m_numberOfSequences * sequenceOverhead;
+}
+
 ChunkPtr ChunkCache::GetChunk(ChunkIdType chunkId)
 {
-    auto it = m_chunkMap.find(chunkId);
-    if (it != m_chunkMap.end())
+    std::unique_lock<std::mutex> lock(m_lock);
+    auto it = m_chunks.find(chunkId);
+    if (it != m_chunks.end())
+    {
+        m_statistics.m_hits++;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.m_lruPosition);
+        return it->second.m_chunk;
+    }
+
+    auto pending = m_pending.find(chunkId);
+    if (pending != m_pending.end())
     {
-        return it->second;
+        // The chunk is being prefetched, the background thread will also cache it.
+        m_statistics.m_hits++;
+        auto chunk = pending->second;
+        lock.unlock();
+        return chunk.get();
     }
- 
-    ChunkPtr chunk = m_deserializer->GetChunk(chunkId);
-    m_chunkMap[chunkId] = chunk;
- 
+
+    m_statistics.m_misses++;
+    lock.unlock();
+
+    ChunkPtr chunk = LoadChunk(chunkId);
+
+    lock.lock();
+    Insert(chunkId, chunk);
     return chunk;
 }
 
+void ChunkCache::Prefetch(ChunkIdType chunkId)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_chunks.find(chunkId) != m_chunks.end() || m_pending.find(chunkId) != m_pending.end())
+        return;
+
+    std::promise<ChunkPtr> promise;
+    m_pending[chunkId] = promise.get_future().share();
+    m_prefetchQueue.push_back(std::make_pair(chunkId, std::move(promise)));
+    if (!m_prefetchThread.joinable())
+        m_prefetchThread = std::thread([this]() { PrefetchLoop(); });
+    lock.unlock();
+    m_prefetchRequested.notify_one();
+}
+
+void ChunkCache::PrefetchLoop()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;)
+    {
+        m_prefetchRequested.wait(lock, [this]() { return m_stopPrefetch || !m_prefetchQueue.empty(); });
+        if (m_stopPrefetch)
+            break;
+
+        auto request = std::move(m_prefetchQueue.front());
+        m_prefetchQueue.pop_front();
+        lock.unlock();
+
+        ChunkPtr chunk;
+        try
+        {
+            chunk = LoadChunk(request.first);
+        }
+        catch (...)
+        {
+            // Rethrown by GetChunk() for this chunk, if anyone asks for it.
+            lock.lock();
+            m_pending.erase(request.first);
+            request.second.set_exception(std::current_exception());
+            continue;
+        }
+
+        lock.lock();
+        m_statistics.m_prefetches++;
+        Insert(request.first, chunk);
+        m_pending.erase(request.first);
+        request.second.set_value(chunk);
+    }
+
+    // Release whoever might still wait for a prefetch.
+    for (auto& request : m_prefetchQueue)
+        request.second.set_exception(std::make_exception_ptr(std::runtime_error("ChunkCache: prefetch was cancelled.")));
+    m_prefetchQueue.clear();
+    m_pending.clear();
+}
+
+ChunkPtr ChunkCache::LoadChunk(ChunkIdType chunkId)
+{
+    std::lock_guard<std::mutex> lock(m_deserializerLock);
+    return m_deserializer->GetChunk(chunkId);
+}
+
+void ChunkCache::Insert(ChunkIdType chunkId, const ChunkPtr& chunk)
+{
+    if (m_chunks.find(chunkId) != m_chunks.end())
+        return; // loaded concurrently by GetChunk() and the prefetch thread
+
+    size_t size = chunkId < m_chunkSizes.size() ? m_chunkSizes[chunkId] : 0;
+    if (m_maxSizeInBytes != 0 && size > m_maxSizeInBytes)
+        return; // would evict everything else and still not fit
+
+    m_lru.push_front(chunkId);
+    m_chunks[chunkId] = CachedChunk{ chunk, size, m_lru.begin() };
+    m_statistics.m_sizeInBytes += size;
+
+    while (m_maxSizeInBytes != 0 && m_statistics.m_sizeInBytes > m_maxSizeInBytes)
+    {
+        auto victim = m_chunks.find(m_lru.back());
+        m_statistics.m_sizeInBytes -= victim->second.m_sizeInBytes;
+        m_statistics.m_evictions++;
+        m_chunks.erase(victim);
+        m_lru.pop_back();
+    }
+    m_statistics.m_numberOfChunks = m_chunks.size();
+}
+
+ChunkCacheStatistics ChunkCache::GetStatistics() const
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    return m_statistics;
+}
+
 }
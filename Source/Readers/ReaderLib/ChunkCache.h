@@ -5,50 +5,120 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
 #include <map>
+#include <mutex>
+#include <thread>
 #include "DataDeserializer.h"
 
 namespace CNTK {
 
-// A cache to store the complete dataset (all chunks) in memory. The caching can
-// be switched on/off by a boolean flag in the reader config section, independent 
-// of the randomization and chunking parameters. The caching should only be enabled 
-// when the whole dataset fits in memory.
-// Implemented as a wrapping proxy around a deserializer that stores pointers to
-// all chunks it sees in an internal map.
+// Counters of a ChunkCache, to help choosing its size.
+struct ChunkCacheStatistics
+{
+    size_t m_hits = 0;            // GetChunk() calls served from the cache, or by a prefetch in progress
+    size_t m_misses = 0;          // GetChunk() calls that had to load the chunk
+    size_t m_evictions = 0;       // chunks dropped from the cache to stay within the size limit
+    size_t m_prefetches = 0;      // chunks loaded in the background
+    size_t m_numberOfChunks = 0;  // chunks currently in the cache
+    size_t m_sizeInBytes = 0;     // estimated size of the chunks currently in the cache
+};
+
+// A cache of chunks in memory. The caching can be switched on/off by a boolean flag
+// in the reader config section, independent of the randomization and chunking parameters.
+// Without a size limit the whole dataset is kept in memory once it has been seen, so this
+// should only be done when it fits. With a size limit, the least recently used chunks are
+// evicted when the estimated size of the cached chunks exceeds it. The size of a chunk is
+// estimated from its ChunkInfo and the stream descriptions, see EstimateChunkSize().
+// Chunks that are known to be needed soon can be loaded in the background by Prefetch().
+// Implemented as a wrapping proxy around a deserializer. It is safe to call GetChunk() and
+// Prefetch() from different threads. The wrapped deserializer is never entered by two threads
+// at the same time, since deserializers share their file handles between chunks.
 class ChunkCache : public DataDeserializer
 {
 public:
+    // maxSizeInBytes == 0 means no limit.
+    ChunkCache(DataDeserializerPtr deserializer, size_t maxSizeInBytes = 0);
 
-    ChunkCache(DataDeserializerPtr deserializer) : m_deserializer(deserializer) { }
+    ~ChunkCache();
 
     virtual std::vector<StreamInformation> StreamInfos() override
     {
+        std::lock_guard<std::mutex> lock(m_deserializerLock);
         return m_deserializer->StreamInfos();
     }
 
     virtual std::vector<ChunkInfo> ChunkInfos() override
     {
+        std::lock_guard<std::mutex> lock(m_deserializerLock);
         return m_deserializer->ChunkInfos();
     }
 
     virtual void SequenceInfosForChunk(ChunkIdType chunkId, std::vector<SequenceInfo>& descriptions) override
     {
+        std::lock_guard<std::mutex> lock(m_deserializerLock);
         return m_deserializer->SequenceInfosForChunk(chunkId, descriptions);
     }
 
     virtual bool GetSequenceInfo(const SequenceInfo& primary, SequenceInfo& description) override
     {
+        std::lock_guard<std::mutex> lock(m_deserializerLock);
         return m_deserializer->GetSequenceInfo(primary, description);
     }
 
     // Gets chunk data given its id.
-    virtual ChunkPtr GetChunk(ChunkIdType chunkId);
+    virtual ChunkPtr GetChunk(ChunkIdType chunkId) override;
+
+    // Starts loading the chunk in the background, unless it is cached or already being loaded.
+    // A GetChunk() for the chunk waits for the background load instead of loading it again.
+    void Prefetch(ChunkIdType chunkId);
+
+    ChunkCacheStatistics GetStatistics() const;
+
+    size_t GetMaxSizeInBytes() const { return m_maxSizeInBytes; }
+
+    // Estimated memory needed for the chunk: the dense size of all samples of dense streams,
+    // one non-zero element per sample of sparse streams, and a fixed overhead per sequence.
+    static size_t EstimateChunkSize(const ChunkInfo& chunk, const std::vector<StreamInformation>& streams);
 
 private:
-    // A map of currently loaded chunks
-    std::map<size_t, ChunkPtr> m_chunkMap;
+    struct CachedChunk
+    {
+        ChunkPtr m_chunk;
+        size_t m_sizeInBytes;
+        std::list<ChunkIdType>::iterator m_lruPosition;
+    };
+
+    // Loads a chunk from the wrapped deserializer under m_deserializerLock. Must not be called under m_lock.
+    ChunkPtr LoadChunk(ChunkIdType chunkId);
+
+    // Adds a loaded chunk to the cache and evicts chunks if needed. Must be called under m_lock.
+    void Insert(ChunkIdType chunkId, const ChunkPtr& chunk);
+
+    // Body of the background loading thread.
+    void PrefetchLoop();
+
     DataDeserializerPtr m_deserializer;
+    size_t m_maxSizeInBytes;
+    std::vector<size_t> m_chunkSizes; // estimated size per chunk id
+
+    // Serializes all calls into m_deserializer, which is not reentrant. Never taken while holding m_lock.
+    std::mutex m_deserializerLock;
+
+    mutable std::mutex m_lock;
+    std::map<ChunkIdType, CachedChunk> m_chunks;
+    std::list<ChunkIdType> m_lru; // ids of cached chunks, most recently used first
+    ChunkCacheStatistics m_statistics;
+
+    // Background loading.
+    std::map<ChunkIdType, std::shared_future<ChunkPtr>> m_pending; // chunks requested or being loaded
+    std::deque<std::pair<ChunkIdType, std::promise<ChunkPtr>>> m_prefetchQueue;
+    std::condition_variable m_prefetchRequested;
+    std::thread m_prefetchThread;
+    bool m_stopPrefetch;
 
     DISABLE_COPY_AND_MOVE(ChunkCache);
 };
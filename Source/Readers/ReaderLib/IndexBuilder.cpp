@@ -7,7 +7,9 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <inttypes.h>
 #include <future>
+#include <thread>
 #include "IndexBuilder.h"
+#include "MappedFile.h"
 #include "ReaderConstants.h"
 #include "FileWrapper.h"
 #include "EnvironmentUtil.h"
@@ -21,6 +23,8 @@ IndexBuilder::IndexBuilder(const FileWrapper& input)
     : m_input(input),
     m_corpus(nullptr),
     m_isCacheEnabled(false),
+    m_numberOfThreads(0),
+    m_minRangeSize(g_64MB),
     m_chunkSize(g_32MB),
     m_bufferSize(g_2MB),
     m_primary(true)
@@ -28,20 +32,20 @@ IndexBuilder::IndexBuilder(const FileWrapper& input)
 
 shared_ptr<Index> IndexBuilder::Build()
 {
-    if (m_isCacheEnabled) 
+    // The cache is only used if it was built from an input with the same size, modification time
+    // and (sampled) contents, otherwise it is rebuilt.
+    InputSignature signature;
+    bool isCacheEnabled = m_isCacheEnabled && TryGetInputSignature(signature);
+
+    if (isCacheEnabled) 
     {
-        auto cacheFilename = GetCacheFilename();
-        if (msra::files::fuptodate(cacheFilename, m_input.Filename(), true))
-        {
-            // cache file is up-to-date, try to reconstruct the index from cache.
-            auto index = TryLoadFromCache(cacheFilename, m_chunkSize);
+        auto index = TryLoadFromCache(GetCacheFilename(), signature, m_chunkSize);
 
-            if (index != nullptr) 
-            {
-                if (!m_primary) 
-                    index->MapSequenceKeyToLocation();
-                return index;
-            }
+        if (index != nullptr) 
+        {
+            if (!m_primary) 
+                index->MapSequenceKeyToLocation();
+            return index;
         }
     }
     
@@ -49,12 +53,12 @@ shared_ptr<Index> IndexBuilder::Build()
     
     Populate(index);
 
-    if (!m_corpus || m_corpus->IsNumericSequenceKeys() || m_corpus->IsHashingEnabled())
+    if (isCacheEnabled && (!m_corpus || m_corpus->IsNumericSequenceKeys() || m_corpus->IsHashingEnabled()))
     {
         // For now, we do not cache index if input contains non-numeric sequence ids 
         // and the corpus does not use a (deterministic and stateless) hashing procedure
         // to transform sequence ids into numeric keys.
-        WriteIndexCacheAsync(index);
+        WriteIndexCacheAsync(index, signature);
     }
 
     if (!m_primary)
@@ -62,8 +66,123 @@ shared_ptr<Index> IndexBuilder::Build()
     return index;
 }
 
+/*static*/ uint64_t IndexBuilder::Hash(const void* data, size_t size, uint64_t hash)
+{
+    const uint64_t prime = 0x100000001b3;
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= prime;
+    }
+    return hash;
+}
 
-void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index) 
+bool IndexBuilder::TryGetInputSignature(InputSignature& signature)
+{
+    // The input is accessed by name, the file handle might not be open when the index is loaded from the cache.
+    const auto& filename = m_input.Filename();
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(filename.c_str(), GetFileExInfoStandard, &attributes))
+        return false;
+    signature.size = (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+    signature.modificationTime = (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat attributes;
+    if (stat(Microsoft::MSR::CNTK::ToLegacyString(Microsoft::MSR::CNTK::ToUTF8(filename)).c_str(), &attributes) != 0)
+        return false;
+    signature.size = attributes.st_size;
+    signature.modificationTime = uint64_t(attributes.st_mtim.tv_sec) * 1000000000 + attributes.st_mtim.tv_nsec;
+#endif
+
+    // Hashing a multi-GB input as a whole would take about as long as indexing it, 
+    // so only blocks evenly spread over the file are hashed.
+    const size_t blockSize = 64 * 1024;
+    const size_t numberOfBlocks = 16;
+
+    FileWrapper input(filename, L"rb");
+    if (!input.IsOpen())
+        return false;
+
+    vector<char> buffer(blockSize);
+    uint64_t hash = Hash(&signature.size, sizeof(signature.size));
+    if (signature.size <= blockSize * numberOfBlocks)
+    {
+        size_t bytesRead;
+        while ((bytesRead = input.Read(buffer.data(), 1, blockSize)) > 0)
+            hash = Hash(buffer.data(), bytesRead, hash);
+        if (input.CheckError())
+            return false;
+    }
+    else
+    {
+        for (size_t i = 0; i < numberOfBlocks; i++)
+        {
+            auto offset = (signature.size - blockSize) / (numberOfBlocks - 1) * i;
+            if (!input.TrySeek(offset, SEEK_SET) || !input.TryRead(buffer.data(), blockSize, 1))
+                return false;
+            hash = Hash(buffer.data(), blockSize, hash);
+        }
+    }
+
+    auto auxiliaryHash = AuxiliaryInputHash();
+    signature.contentHash = Hash(&auxiliaryHash, sizeof(auxiliaryHash), hash);
+    return true;
+}
+
+vector<IndexBuilder::InputRange> IndexBuilder::SplitInput(size_t begin, size_t end, const function<bool(BufferedFileReader&)>& moveToBoundary)
+{
+    size_t numberOfThreads = m_numberOfThreads != 0 ? m_numberOfThreads : thread::hardware_concurrency();
+    size_t numberOfRanges = end > begin ? min(numberOfThreads, (end - begin) / max<size_t>(m_minRangeSize, 1)) : 0;
+
+    vector<InputRange> ranges;
+    if (numberOfRanges > 1)
+    {
+        auto reader = OpenReader(begin);
+        auto rangeSize = (end - begin) / numberOfRanges;
+        for (size_t i = 1; i < numberOfRanges; i++)
+        {
+            auto split = begin + i * rangeSize;
+            if (!ranges.empty() && split <= ranges.back().m_end)
+                continue; // the previous boundary is past this split point.
+
+            // The boundary search starts at the preceding byte, so that a boundary right at the split point is found.
+            reader->SetFileOffset(split - 1);
+            if (!moveToBoundary(*reader) || reader->GetFileOffset() >= end)
+                break;
+
+            ranges.push_back({ ranges.empty() ? begin : ranges.back().m_end, reader->GetFileOffset() });
+        }
+    }
+
+    ranges.push_back({ ranges.empty() ? begin : ranges.back().m_end, end });
+    return ranges;
+}
+
+void IndexBuilder::IndexInParallel(const vector<InputRange>& ranges, const function<void(size_t)>& index, const function<void(size_t)>& merge)
+{
+    vector<future<void>> tasks;
+    tasks.reserve(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+        tasks.push_back(async(launch::async, [&index, i]() { index(i); }));
+
+    // If one of the ranges fails, the destructors of the remaining futures wait for their tasks.
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        tasks[i].get();
+        merge(i);
+    }
+}
+
+unique_ptr<BufferedFileReader> IndexBuilder::OpenReader(size_t offset)
+{
+    auto input = FileWrapper::OpenOrDie(m_input.Filename(), L"rbS");
+    input.SeekOrDie(offset, SEEK_SET);
+    return unique_ptr<BufferedFileReader>(new BufferedFileReader(m_bufferSize, input));
+}
+
+void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index, const InputSignature& input) 
 {
     if (!m_isCacheEnabled)
         return;
@@ -75,7 +194,7 @@ void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index)
 
     // using thread(lambda).detach() as a workaround the blocking
     // async destructor.
-    thread([cacheFilename, index]()
+    thread([cacheFilename, index, input]()
     {
         // At this point, it's safe to assume that the previous cache is stale,
         // remove the cache file if it exists (return value is ignored).
@@ -87,7 +206,7 @@ void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index)
             FileWrapper cache(temp, L"wb");
             isCacheEnabled = cache.IsOpen();
 
-            Prefix prefix(s_magic, s_version, index->NumberOfSequences(), uint64_t(sizeof(Prefix)));
+            Prefix prefix(s_magic, s_version, index->NumberOfSequences(), input, uint64_t(sizeof(Prefix)));
 
             isCacheEnabled = isCacheEnabled && cache.TryWrite(prefix);
 
@@ -121,34 +240,52 @@ void IndexBuilder::WriteIndexCacheAsync(shared_ptr<Index>& index)
     }).detach();
 }
 
-const static size_t s_sequenceSize = sizeof(IndexedSequence);
-const static size_t s_numSequencesToBuffer = (g_1MB >> 1) / s_sequenceSize;
-
-/*static*/ shared_ptr<Index> IndexBuilder::TryLoadFromCache(const wstring& cacheFilename, size_t chunkSize)
+/*static*/ shared_ptr<Index> IndexBuilder::TryLoadFromCache(const wstring& cacheFilename, const InputSignature& input, size_t chunkSize)
 {
-    FileWrapper cache(cacheFilename.c_str(), L"rb");
+    if (!fexists(cacheFilename))
+        return nullptr;
 
-    if (!cache.IsOpen())
+    // The cache is mapped rather than read, the sequences are added to the index
+    // straight from the page cache.
+    unique_ptr<MappedFile> cache;
+    try
+    {
+        cache.reset(new MappedFile(cacheFilename));
+    }
+    catch (const std::exception&)
+    {
         return nullptr;
+    }
 
     Prefix prefix;
-    if (!cache.TryRead(prefix) || prefix.magic != s_magic)
+    if (cache->Size() < sizeof(Prefix))
+        return nullptr;
+    memcpy(&prefix, cache->Data(), sizeof(Prefix));
+
+    if (prefix.magic != s_magic || prefix.version != s_version ||
+        prefix.input.size != input.size ||
+        prefix.input.modificationTime != input.modificationTime ||
+        prefix.input.contentHash != input.contentHash ||
+        prefix.firstSequenceOffset > cache->Size() ||
+        (cache->Size() - prefix.firstSequenceOffset) / sizeof(IndexedSequence) != prefix.totalNumberOfSequences)
         return nullptr;
 
     auto index = make_shared<Index>(chunkSize);
+    index->Reserve(input.size);
 
-    char buffer[s_numSequencesToBuffer * s_sequenceSize];
-    for (uint64_t i = 0; i < prefix.totalNumberOfSequences; )
+    auto sequences = cache->Data() + prefix.firstSequenceOffset;
+    IndexedSequence sequence;
+    try
     {
-        auto numSequencesToRead = min(s_numSequencesToBuffer, prefix.totalNumberOfSequences - i);
-
-        if (!cache.TryRead(buffer, s_sequenceSize, numSequencesToRead))
-            return nullptr;
-
-        for (int j = 0; j < numSequencesToRead; j++) 
-            index->AddSequence(*reinterpret_cast<IndexedSequence*>(buffer + j * s_sequenceSize));
-        
-        i += numSequencesToRead;
+        for (uint64_t i = 0; i < prefix.totalNumberOfSequences; i++)
+        {
+            memcpy(&sequence, sequences + i * sizeof(IndexedSequence), sizeof(IndexedSequence));
+            index->AddSequence(sequence);
+        }
+    }
+    catch (const std::exception&)
+    {
+        return nullptr; // a corrupted cache, the index is rebuilt.
     }
 
     return index;
@@ -257,32 +394,66 @@ static const char s_BOM[3] = { '\xEF', '\xBB', '\xBF' };
 }
 
 void TextInputIndexBuilder::PopulateFromLines(shared_ptr<Index>& index)
+{
+    auto ranges = SplitInput(m_reader->GetFileOffset(), m_fileSize, 
+        [](BufferedFileReader& reader) { return reader.TryMoveToNextLine(); });
+
+    if (ranges.size() == 1)
+    {
+        IndexLines(*m_reader, m_fileSize, [&index](const IndexedSequence& sequence) { index->AddSequence(sequence); });
+        return;
+    }
+
+    // The first range is indexed by the current reader, so that its line numbers include the lines 
+    // skipped at the beginning of the input. The line numbers of the other ranges are made global 
+    // when merging, by adding the number of lines in all ranges before.
+    vector<vector<IndexedSequence>> sequences(ranges.size());
+    vector<size_t> numberOfLines(ranges.size());
+    size_t firstLine = 0;
+    IndexInParallel(ranges,
+        [&](size_t i)
+        {
+            auto reader = i == 0 ? nullptr : OpenReader(ranges[i].m_begin);
+            auto& rangeReader = i == 0 ? *m_reader : *reader;
+            IndexLines(rangeReader, ranges[i].m_end, [&](const IndexedSequence& sequence) { sequences[i].push_back(sequence); });
+            numberOfLines[i] = rangeReader.CurrentLineNumber();
+        },
+        [&](size_t i)
+        {
+            for (auto& sequence : sequences[i])
+                index->AddSequence(sequence.SetKey(sequence.Key() + firstLine));
+            firstLine += numberOfLines[i];
+            vector<IndexedSequence>().swap(sequences[i]);
+        });
+}
+
+void TextInputIndexBuilder::IndexLines(BufferedFileReader& reader, size_t end, const function<void(const IndexedSequence&)>& add)
 {
     IndexedSequence sequence;
-    while (!m_reader->Empty())
+    while (!reader.Empty() && reader.GetFileOffset() < end)
     {
-        size_t offset = m_reader->GetFileOffset();
+        size_t offset = reader.GetFileOffset();
 
-        if (!FindMainStream())
+        if (!FindMainStream(reader))
         { 
             // skip lines that do not contain main stream name.
-            m_reader->TryMoveToNextLine();
+            reader.TryMoveToNextLine();
             continue;
         }
 
-        sequence.SetNumberOfSamples(1).SetOffset(offset).SetKey(m_reader->CurrentLineNumber());
+        sequence.SetNumberOfSamples(1).SetOffset(offset).SetKey(reader.CurrentLineNumber());
 
-        if (m_reader->TryMoveToNextLine())
+        if (reader.TryMoveToNextLine())
         {
-            sequence.SetSize(m_reader->GetFileOffset() - offset);
-            index->AddSequence(sequence);
+            sequence.SetSize(reader.GetFileOffset() - offset);
+            add(sequence);
         } 
         else  if (offset < m_fileSize)
         {
             // There's a number of characters, not terminated by a newline,
             // add a sequence to the index, parser will have to deal with it.
             sequence.SetSize(m_fileSize - offset);
-            index->AddSequence(sequence);
+            add(sequence);
             break;
         }
     }
@@ -303,7 +474,7 @@ void TextInputIndexBuilder::PopulateImpl(shared_ptr<Index>& index)
 
     while (!m_reader->Empty())
     {
-        if (FindMainStream())
+        if (FindMainStream(*m_reader))
         {
             numberOfSamples++;
             foundMainStream = true;
@@ -344,9 +515,9 @@ void TextInputIndexBuilder::PopulateImpl(shared_ptr<Index>& index)
     }
 }
 
-inline bool TextInputIndexBuilder::FindMainStream()
+inline bool TextInputIndexBuilder::FindMainStream(BufferedFileReader& reader)
 {
-    if (m_reader->Empty())
+    if (reader.Empty())
         return false;
     
     if (m_mainStream.empty())
@@ -357,7 +528,7 @@ inline bool TextInputIndexBuilder::FindMainStream()
     int i = 0;
     do  
     {
-        char c = m_reader->Peek();
+        char c = reader.Peek();
         if (i == length)
         {
             // we found a match, check to see if it's followed by either a space, 
@@ -375,7 +546,7 @@ inline bool TextInputIndexBuilder::FindMainStream()
 
         if (c == g_eol)
             break;
-    } while (m_reader->Pop());
+    } while (reader.Pop());
 
     // we hit either the EOL or the EOF, see if we have a match
     return (i == length);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 #include <vector>
 #include <boost/noncopyable.hpp>
 #include "Index.h"
@@ -28,6 +29,8 @@ class IndexedSequence
     
 public:
     IndexedSequence& SetKey(size_t value) { key = value; return *this;  }
+
+    size_t Key() const { return key; }
     
     IndexedSequence& SetNumberOfSamples(uint32_t value) { numberOfSamples = value; return *this; }
     
@@ -45,12 +48,21 @@ public:
 
 class IndexBuilder : private boost::noncopyable
 {
+    // Identifies the contents of an input file, an index cache is only used if the signature
+    // stored in it matches the one of the input.
+    struct InputSignature {
+        uint64_t size;
+        uint64_t modificationTime;
+        uint64_t contentHash; // hash of (a sample of) the input contents and of the auxiliary inputs
+    };
+
     struct Prefix {
         Prefix() = default;
-        Prefix(uint64_t magic, uint64_t version, uint64_t totalNumberOfSequences, 
+        Prefix(uint64_t magic, uint64_t version, uint64_t totalNumberOfSequences, const InputSignature& input,
             uint64_t firstSequenceOffset = sizeof(Prefix))
             : magic{ magic }, version{ version },
-            totalNumberOfSequences{ totalNumberOfSequences }, firstSequenceOffset{ firstSequenceOffset }
+            totalNumberOfSequences{ totalNumberOfSequences }, firstSequenceOffset{ firstSequenceOffset },
+            input(input)
         {}
         uint64_t magic;
         uint64_t version;
@@ -58,6 +70,7 @@ class IndexBuilder : private boost::noncopyable
         uint64_t firstSequenceOffset; // this offset is set to the size of prefix for the moment
         // but eventually, this can be used to append additional staff after prefix, without breaking
         // back compat.
+        InputSignature input;
     };
 
 public:
@@ -76,6 +89,13 @@ public:
 
     IndexBuilder& SetCachingEnabled(bool value) { m_isCacheEnabled = value; return *this; }
 
+    // Maximum number of threads used to index an input that is split into ranges (0 = one per core).
+    IndexBuilder& SetNumberOfThreads(size_t value) { m_numberOfThreads = value; return *this; }
+
+    // Minimum size of a range of the input indexed by a single thread. Inputs smaller
+    // than twice this size are indexed sequentially.
+    IndexBuilder& SetMinRangeSize(size_t size) { m_minRangeSize = size; return *this; }
+
     virtual std::wstring GetCacheFilename() = 0;
 
 protected:
@@ -85,6 +105,35 @@ protected:
 
     virtual void Populate(std::shared_ptr<Index>&) = 0;
 
+    // Hash of other inputs that the index depends on (e.g., a table of contents),
+    // a change of it invalidates the index cache.
+    virtual uint64_t AuxiliaryInputHash() { return 0; }
+
+    // FNV-1a hash of the given bytes, continuing from the given hash value.
+    static uint64_t Hash(const void* data, size_t size, uint64_t hash = s_hashSeed);
+
+    // A part of the input that is indexed independently of the rest.
+    struct InputRange
+    {
+        size_t m_begin;
+        size_t m_end;
+    };
+
+    // Splits [begin, end) of the input into ranges of at least m_minRangeSize bytes, one per thread.
+    // Each split point is moved forward by moveToBoundary, which gets a reader positioned at the
+    // tentative split point and moves it to the next offset at which indexing can start from scratch
+    // (e.g., the beginning of a line). It returns false if there is no such offset before the EOF.
+    // Returns a single range if the input is too small to be split.
+    std::vector<InputRange> SplitInput(size_t begin, size_t end, const std::function<bool(BufferedFileReader&)>& moveToBoundary);
+
+    // Runs index(i) for each of the ranges on its own thread and merge(i) on the calling thread, in the
+    // order of the ranges, once index(i) is done. An exception thrown by index(i) is rethrown after merging
+    // all ranges before it, so the error reported is the one a sequential pass would have run into first.
+    void IndexInParallel(const std::vector<InputRange>& ranges, const std::function<void(size_t)>& index, const std::function<void(size_t)>& merge);
+
+    // Opens a reader of the input positioned at the given offset.
+    std::unique_ptr<BufferedFileReader> OpenReader(size_t offset);
+
     FileWrapper m_input;
     CorpusDescriptorPtr m_corpus;
     size_t m_bufferSize;
@@ -92,14 +141,21 @@ protected:
     size_t m_chunkSize;
 
     bool m_isCacheEnabled;
+    size_t m_numberOfThreads;
+    size_t m_minRangeSize;
 
-    static const uint64_t s_version = 1;
+    static const uint64_t s_version = 2;
 
 private:
-    static std::shared_ptr<Index> TryLoadFromCache(const std::wstring& cacheFilename, size_t chunkSize);
-    void WriteIndexCacheAsync(std::shared_ptr<Index>& index);
+    // Returns false if the input file cannot be accessed by name.
+    bool TryGetInputSignature(InputSignature& signature);
+
+    static std::shared_ptr<Index> TryLoadFromCache(const std::wstring& cacheFilename, const InputSignature& input, size_t chunkSize);
+    void WriteIndexCacheAsync(std::shared_ptr<Index>& index, const InputSignature& input);
     std::shared_ptr<Index> m_index;
 
+    static const uint64_t s_hashSeed = 0xcbf29ce484222325;
+
     static const uint64_t s_magic = 0x636e746b5f696478; // 'cntk_idx'
 };
 
@@ -145,7 +201,7 @@ private:
     std::unique_ptr<BufferedFileReader> m_reader;
 
     // Returns true if main stream name if found on the current line.
-    bool FindMainStream();
+    bool FindMainStream(BufferedFileReader& reader);
 
     // Invokes either TryGetNumericSequenceId or TryGetSymbolicSequenceId depending
     // on the specified corpus settings.
@@ -166,7 +222,12 @@ private:
 
     // Parses input line by line, treating each line as an individual sequence.
     // Ignores sequence id information, using the line number instead as the id.
+    // Large inputs are split into ranges at line boundaries and indexed in parallel.
     void PopulateFromLines(std::shared_ptr<Index>& index);
+
+    // Indexes the lines that start before the end offset, beginning at the current reader position.
+    // The keys are the reader line numbers, i.e., relative to where the reader was opened.
+    void IndexLines(BufferedFileReader& reader, size_t end, const std::function<void(const IndexedSequence&)>& add);
 };
 
 }
@@ -0,0 +1,115 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "MappedFile.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CNTK {
+
+using namespace Microsoft::MSR::CNTK;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::wstring& filename, bool /*randomAccess*/)
+    : m_filename(filename), m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+{
+    m_file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+        RuntimeError("Unable to open file '%ls' for memory mapping, error %x.", filename.c_str(), GetLastError());
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size))
+    {
+        CloseHandle(m_file);
+        RuntimeError("Unable to retrieve the size of file '%ls', error %x.", filename.c_str(), GetLastError());
+    }
+    m_size = (size_t)size.QuadPart;
+
+    m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping != NULL)
+        m_data = (byte*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (m_data == nullptr)
+    {
+        auto error = GetLastError();
+        if (m_mapping != NULL)
+            CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        RuntimeError("Unable to memory map file '%ls', error %x.", filename.c_str(), error);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+}
+
+void MappedFile::WillNeed(size_t, size_t) const
+{
+    // The system readahead of mapped views is good enough for sequential chunks.
+}
+
+#else
+
+MappedFile::MappedFile(const std::wstring& filename, bool randomAccess)
+    : m_filename(filename), m_data(nullptr), m_size(0), m_file(-1)
+{
+    m_file = open(ToLegacyString(ToUTF8(filename)).c_str(), O_RDONLY);
+    if (m_file == -1)
+        RuntimeError("Unable to open file '%ls' for memory mapping: %s.", filename.c_str(), strerror(errno));
+
+    struct stat sb;
+    if (fstat(m_file, &sb) == -1)
+    {
+        auto error = errno;
+        close(m_file);
+        RuntimeError("Unable to retrieve the size of file '%ls': %s.", filename.c_str(), strerror(error));
+    }
+    m_size = (size_t)sb.st_size;
+
+    void* data = m_size == 0 ? MAP_FAILED : mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+    {
+        auto error = errno;
+        close(m_file);
+        RuntimeError("Unable to memory map file '%ls': %s.", filename.c_str(), strerror(error));
+    }
+    m_data = (byte*)data;
+
+    // E.g. chunks are visited in randomized order, the kernel readahead around faulting pages
+    // would mostly read data of other chunks. These are requested explicitly via WillNeed().
+    madvise(m_data, m_size, randomAccess ? MADV_RANDOM : MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(m_data, m_size);
+    close(m_file);
+}
+
+void MappedFile::WillNeed(size_t offset, size_t size) const
+{
+    if (offset >= m_size || size == 0)
+        return;
+
+    // madvise() needs a page aligned address.
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = offset - offset % pageSize;
+    size_t end = std::min(offset + size, m_size);
+    madvise(m_data + begin, end - begin, MADV_WILLNEED);
+}
+
+#endif
+
+}
@@ -0,0 +1,51 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "Basics.h"
+#include "basetypes.h"
+
+namespace CNTK {
+
+// A read-only memory mapping of a whole file.
+// Data is handed out as views into the mapping (e.g. chunks of the binary format), so it
+// is paged in by the OS on first access instead of being copied into a heap buffer.
+class MappedFile
+{
+public:
+    // With randomAccess the OS readahead is disabled, parts of the file that are about
+    // to be accessed should be announced with WillNeed() instead.
+    explicit MappedFile(const std::wstring& filename, bool randomAccess = false);
+
+    ~MappedFile();
+
+    const byte* Data() const { return m_data; }
+
+    size_t Size() const { return m_size; }
+
+    // Asks the OS to start reading the given range of the file in the background,
+    // so that it is resident by the time it is accessed. Only a hint.
+    void WillNeed(size_t offset, size_t size) const;
+
+    DISABLE_COPY_AND_MOVE(MappedFile);
+
+private:
+    std::wstring m_filename;
+    byte* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_file;
+#endif
+};
+
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+}
@@ -12,6 +12,8 @@
 #endif
 
 #include <sstream>
+#include <algorithm>
+#include <chrono>
 #include "Basics.h"
 
 #define DATAREADER_EXPORTS // creating the exports here
@@ -42,12 +44,20 @@ inline TensorShape AsTensorShape(const NDShape& viewShape)
 template <class ElemType>
 ReaderShim<ElemType>::ReaderShim() :
     m_deviceId(CPUDEVICE),
-    m_dataTransferers(2, DataTransfererPtr()),
-    m_currentDataTransferIndex(0),
     m_endOfEpoch(false),
     m_endOfSweep(false),
     m_reader(nullptr),
-    m_factory(nullptr)
+    m_factory(nullptr),
+    m_prefetch(true),
+    m_numPrefetchThreads(1),
+    m_traceLevel(0),
+    m_slots(1),
+    m_prefetchRunning(false),
+    m_stopPrefetchThreads(false),
+    m_isReading(false),
+    m_readerExhausted(false),
+    m_nextTicket(0),
+    m_nextToConsume(0)
 {
 }
 
@@ -65,16 +75,41 @@ ReaderShim<ElemType>::ReaderShim(ReaderPtr reader) :
     m_reader = reader;
 }
 
+template <class ElemType>
+ReaderShim<ElemType>::~ReaderShim()
+{
+    // Make sure there are no outstanding reads.
+    StopPrefetching();
+
+    {
+        std::unique_lock<std::mutex> lock(m_prefetchLock);
+        m_stopPrefetchThreads = true;
+    }
+    m_prefetchStateChanged.notify_all();
+    for (auto& thread : m_prefetchThreads)
+        thread.join();
+}
+
 template <class ElemType>
 void ReaderShim<ElemType>::Init(const ConfigParameters& config)
 {
     intargvector numberOfuttsPerMinibatchForAllEpochs =
         config(L"nbruttsineachrecurrentiter", ConfigParameters::Array(intargvector(vector<int> { 1 })));
 
-    bool prefetch = config(L"prefetch", true);
-    // if prefetch - launching asynchronously,
-    // otherwise deferring - synchronous execution during .get() call
-    m_launchType = prefetch ? launch::async : launch::deferred;
+    // if prefetch - up to prefetchDepth minibatches are read ahead by prefetchThreads threads,
+    // otherwise the minibatch is read synchronously by GetMinibatch()
+    m_prefetch = config(L"prefetch", true);
+    size_t prefetchDepth = config(L"prefetchDepth", (size_t)1);
+    m_numPrefetchThreads = config(L"prefetchThreads", (size_t)1);
+    if (m_prefetch && (prefetchDepth == 0 || m_numPrefetchThreads == 0))
+        InvalidArgument("ReaderShim: prefetchDepth and prefetchThreads must be positive.");
+    if (!m_prefetch)
+    {
+        prefetchDepth = 1;
+        m_numPrefetchThreads = 0;
+    }
+    m_slots = std::vector<PrefetchSlot>(prefetchDepth);
+    m_traceLevel = config(L"traceLevel", 0);
 
     m_numParallelSequences = numberOfuttsPerMinibatchForAllEpochs[0];
 
@@ -122,14 +157,8 @@ void ReaderShim<ElemType>::SetCurrentSamplePosition(size_t currentSamplePosition
     if (GetCurrentSamplePosition() == currentSamplePosition)
         return;
 
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.wait();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads, the prefetched minibatches are dropped.
+    StopPrefetching();
 
     // Set current position.
     std::map<std::wstring, size_t> state;
@@ -143,14 +172,9 @@ void ReaderShim<ElemType>::SetCurrentSamplePosition(size_t currentSamplePosition
 template <class ElemType>
 void ReaderShim<ElemType>::SetConfiguration(const ReaderConfiguration& config, const std::map<std::wstring, int>& inputDescriptions)
 {
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.get();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads, the prefetched minibatches are dropped
+    // and read again with the new configuration.
+    StopPrefetching();
 
     m_reader->SetConfiguration(config, inputDescriptions);
     m_reader->SetState(m_currentState);
@@ -160,13 +184,7 @@ template <class ElemType>
 void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const std::unordered_set<InputStreamDescription>& inputs)
 {
     // For adaptive minibatch, make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.get();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    StopPrefetching();
 
     // Now we can be sure, no prefetch thread is running and there are no outstanding memcopies.
     // Let's check that requested devices are ok and see whether we need to change our data transferers.
@@ -184,26 +202,33 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
 
     if (m_deviceId != deviceId)
     {
-        // Device changed. Let's change the data transferers.
+        // Device changed. Let's change the data transferers, one per slot, so that the copies of all slots can be in flight.
         m_deviceId = deviceId;
-        m_dataTransferers.clear();
-        // We need two in order to support two operations in flight.
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
-        m_dataTransferers.push_back(m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId));
+        for (auto& slot : m_slots)
+            slot.m_dataTransferer = m_deviceId == CPUDEVICE ? nullptr : CreatePrefetchDataTransferer(m_deviceId);
     }
 
-    // Let's create the buffers for the prefetch thread.
+    // Let's create the buffers for the prefetch threads.
     std::map<std::wstring, int> inputDescriptions;
     for (const auto& i : inputs)
     {
         inputDescriptions[i.GetStreamName()] = i.GetDeviceId();
         // Creating buffers with the same properties the network expects.
-        m_prefetchBuffers[i.GetStreamName()] = StreamPrefetchBuffer
+        for (auto& slot : m_slots)
         {
-            std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
-            std::make_shared<MBLayout>(),
-            NDShape::Unknown()
-        };
+            slot.m_buffers[i.GetStreamName()] = StreamPrefetchBuffer
+            {
+                std::make_shared<Matrix<ElemType>>(0, 0, i.GetDeviceId(), i.GetMatrixType(), i.GetMatrixFormat()),
+                std::make_shared<MBLayout>(),
+                NDShape::Unknown()
+            };
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_prefetchLock);
+        m_prefetchStatistics = PrefetchStatistics();
+        m_prefetchStatistics.m_occupancyHistogram.assign(m_slots.size() + 1, 0);
     }
 
     m_endOfEpoch = false;
@@ -215,16 +240,134 @@ void ReaderShim<ElemType>::StartEpoch(const EpochConfiguration& config, const st
 template <class ElemType>
 void ReaderShim<ElemType>::StartAsyncPrefetching()
 {
-    auto localCurrentDataTransferIndex = m_currentDataTransferIndex;
-    // Starting the prefetch task. There is always a single async read in flight.
-    // When the network requests a new minibatch, we wait for the current async to finish, swap the buffers
-    // and kick off the new prefetch.
-    m_prefetchTask = std::async(m_launchType, [this, localCurrentDataTransferIndex]()
     {
-        return PrefetchMinibatch(localCurrentDataTransferIndex);
+        std::unique_lock<std::mutex> lock(m_prefetchLock);
+        m_prefetchRunning = true;
+        // The threads are started once and wait for work in between epochs.
+        while (m_prefetchThreads.size() < m_numPrefetchThreads)
+            m_prefetchThreads.push_back(std::thread([this]() { PrefetchLoop(); }));
+    }
+    m_prefetchStateChanged.notify_all();
+}
+
+// Waits for the outstanding reads and drops all prefetched minibatches.
+// The caller sets the reader to the state it wants to continue from.
+template <class ElemType>
+void ReaderShim<ElemType>::StopPrefetching()
+{
+    std::unique_lock<std::mutex> lock(m_prefetchLock);
+    m_prefetchRunning = false;
+    m_prefetchStateChanged.wait(lock, [this]()
+    {
+        // A slot that has been read but not filled yet still refers to the data of the reader.
+        return !m_isReading && std::none_of(m_slots.begin(), m_slots.end(),
+            [](const PrefetchSlot& slot) { return slot.m_state == SlotState::Read || slot.m_state == SlotState::Filling; });
+    });
+
+    // Without prefetch threads a slot may have been read, but not filled.
+    for (auto& slot : m_slots)
+    {
+        slot.m_state = SlotState::Free;
+        slot.m_minibatch = Minibatch();
+        slot.m_error = nullptr;
+    }
+    m_readerExhausted = false;
+    m_nextTicket = 0;
+    m_nextToConsume = 0;
+}
+
+template <class ElemType>
+void ReaderShim<ElemType>::PrefetchLoop()
+{
+    std::unique_lock<std::mutex> lock(m_prefetchLock);
+    for (;;)
+    {
+        m_prefetchStateChanged.wait(lock, [this]() { return m_stopPrefetchThreads || FindSlotToFill() || CanRead(); });
+        if (m_stopPrefetchThreads)
+            break;
+
+        RunPrefetchStep(lock);
+    }
+}
+
+// The next slot in ring order can be read. Called under m_prefetchLock.
+template <class ElemType>
+bool ReaderShim<ElemType>::CanRead() const
+{
+    if (!m_prefetchRunning || m_isReading || m_readerExhausted)
+        return false;
+
+    if (m_slots[m_nextTicket % m_slots.size()].m_state != SlotState::Free)
+        return false; // the ring is full
+
+    // Reading overwrites the data of the minibatch before the previous one.
+    return std::none_of(m_slots.begin(), m_slots.end(), [this](const PrefetchSlot& slot)
+    {
+        return (slot.m_state == SlotState::Read || slot.m_state == SlotState::Filling) && slot.m_ticket + 2 <= m_nextTicket;
     });
 }
 
+// Returns the oldest slot that has been read and waits to be filled, nullptr if there is none. Called under m_prefetchLock.
+template <class ElemType>
+typename ReaderShim<ElemType>::PrefetchSlot* ReaderShim<ElemType>::FindSlotToFill()
+{
+    PrefetchSlot* result = nullptr;
+    for (auto& slot : m_slots)
+    {
+        if (slot.m_state == SlotState::Read && (!result || slot.m_ticket < result->m_ticket))
+            result = &slot;
+    }
+    return result;
+}
+
+// Fills a slot, or reads the next one. Called under m_prefetchLock, which is released while working.
+template <class ElemType>
+void ReaderShim<ElemType>::RunPrefetchStep(std::unique_lock<std::mutex>& lock)
+{
+    auto slot = FindSlotToFill();
+    if (slot)
+    {
+        slot->m_state = SlotState::Filling;
+        lock.unlock();
+        try
+        {
+            FillSlot(*slot);
+        }
+        catch (...)
+        {
+            slot->m_error = std::current_exception();
+        }
+        slot->m_minibatch = Minibatch();
+        lock.lock();
+        slot->m_state = SlotState::Ready;
+    }
+    else if (CanRead())
+    {
+        slot = &m_slots[m_nextTicket % m_slots.size()];
+        slot->m_state = SlotState::Reading;
+        slot->m_ticket = m_nextTicket++;
+        m_isReading = true;
+        lock.unlock();
+        try
+        {
+            ReadSlot(*slot);
+        }
+        catch (...)
+        {
+            slot->m_error = std::current_exception();
+        }
+        lock.lock();
+        m_isReading = false;
+        if (slot->m_error || slot->m_result.m_isEndOfEpoch)
+            m_readerExhausted = true;
+        slot->m_state = slot->m_error || !slot->m_result.m_isDataAvailable ? SlotState::Ready : SlotState::Read;
+    }
+    else
+        LogicError("ReaderShim: there is nothing to prefetch.");
+
+    m_prefetchStateChanged.notify_all();
+}
+
 string EnumerateInputs(const unordered_map<wstring, size_t>& nameToStreamId)
 {
     // TODO use boost::algorithm::join, boost::adapters::transformed, make this a generic function
@@ -266,44 +409,83 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         }
     }
 
-    if (!m_prefetchTask.valid())
+    if (!m_prefetchRunning)
         StartAsyncPrefetching();
 
-    auto result = m_prefetchTask.get();
+    std::unique_lock<std::mutex> lock(m_prefetchLock);
+    auto& slot = m_slots[m_nextToConsume % m_slots.size()];
+
+    size_t numReady = std::count_if(m_slots.begin(), m_slots.end(), [](const PrefetchSlot& s) { return s.m_state == SlotState::Ready; });
+    m_prefetchStatistics.m_occupancyHistogram.resize(m_slots.size() + 1);
+    m_prefetchStatistics.m_occupancyHistogram[numReady]++;
+    if (slot.m_state != SlotState::Ready)
+    {
+        auto start = std::chrono::steady_clock::now();
+        while (slot.m_state != SlotState::Ready)
+        {
+            if (m_prefetchThreads.empty())
+                RunPrefetchStep(lock);
+            else
+                m_prefetchStateChanged.wait(lock);
+        }
+        m_prefetchStatistics.m_numStalls++;
+        m_prefetchStatistics.m_waitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    m_prefetchStatistics.m_numMinibatches++;
 
     // Ok, prefetch is done.
+    if (slot.m_error)
+    {
+        auto error = slot.m_error;
+        lock.unlock();
+        StopPrefetching();
+        std::rethrow_exception(error);
+    }
+    lock.unlock();
 
     // Let's update our sample position.
-    m_currentState = m_reader->GetState();
+    m_currentState = slot.m_readerState;
 
+    auto result = slot.m_result;
     m_endOfEpoch = result.m_isEndOfEpoch;
     m_endOfSweep = result.m_isEndOfSweep;
-    if (m_endOfEpoch && !result.m_isDataAvailable)
+
+    std::unordered_map<std::wstring, std::pair<MBLayoutPtr, NDShape>> streamLayouts;
+    if (result.m_isDataAvailable)
     {
-        // No data and end of epoch, simply return.
-        return false;
-    }
+        matrices.m_getKeyById = slot.m_getKeyById;
 
-    // Remember current data transfer, async memcpy for it already started on the prefetch thread.
-    auto currentDataTransferIndex = m_currentDataTransferIndex;
+        // Record an event that the next prefetch into this slot can wait on to ensure that prior compute has finished.
+        if (slot.m_dataTransferer)
+            slot.m_dataTransferer->RecordComputeStreamSyncPoint();
 
-    matrices.m_getKeyById = m_getKeyById;
+        // We have some data - let's swap the matrices.
+        // We cannot simply change pointers because it seems they are remembered deeper in the network.
+        for (auto i = matrices.begin(); i != matrices.end(); ++i)
+        {
+            auto& buffer = slot.m_buffers[i->first];
+            std::swap(i->second.GetMatrix<ElemType>(), *buffer.m_matrix);
+            streamLayouts[i->first] = std::make_pair(buffer.m_mbLayout, buffer.m_sampleShape);
 
-    // Let's update the current data transferer.
-    m_currentDataTransferIndex = (m_currentDataTransferIndex + 1) % 2;
+            // Resetting layouts.
+            i->second.pMBLayout->Init(1, 0);
+        }
+    }
 
-    // Record an event that prefetch can wait on to ensure that prior compute has finished.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->RecordComputeStreamSyncPoint();
+    // The slot can be prefetched into again.
+    lock.lock();
+    slot.m_state = SlotState::Free;
+    m_nextToConsume++;
+    lock.unlock();
+    m_prefetchStateChanged.notify_all();
 
-    // We have some data - let's swap the matrices.
-    // We cannot simply change pointers because it seems they are remembered deeper in the network.
-    for (auto i = matrices.begin(); i != matrices.end(); ++i)
-    {
-        std::swap(i->second.GetMatrix<ElemType>(), *m_prefetchBuffers[i->first].m_matrix);
+    if (m_endOfEpoch)
+        ReportPrefetchStatistics();
 
-        // Resetting layouts.
-        i->second.pMBLayout->Init(1, 0);
+    if (!result.m_isDataAvailable)
+    {
+        // No data and end of epoch, simply return.
+        return false;
     }
 
     // a map to generate error messages when checking layout constraints.
@@ -312,7 +494,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // Let's now check the layouts and throw if the same layout is being assigned twice.
     for (auto i = matrices.begin(); i != matrices.end(); ++i)
     {
-        auto streamLayout = m_prefetchBuffers[i->first].m_mbLayout;
+        auto streamLayout = streamLayouts[i->first].first;
         auto& layout = i->second.pMBLayout;
         if (layout->GetNumCols() == 0) // just initialized, let's take the layout of the reader.
         {
@@ -329,7 +511,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
         }
 
         // Check sample shape.
-        const auto& sampleShape = m_prefetchBuffers[i->first].m_sampleShape;
+        const auto& sampleShape = streamLayouts[i->first].second;
         if (i->second.sampleLayout.size() == 0 || AsNDShape(i->second.sampleLayout).IsUnknown()) // Not set.
         {
             i->second.sampleLayout = AsTensorShape(sampleShape);
@@ -345,17 +527,7 @@ bool ReaderShim<ElemType>::GetMinibatch(StreamMinibatchInputs& matrices)
     // So pick up the first one.
     m_numParallelSequences = matrices.begin()->second.pMBLayout->GetNumParallelSequences();
 
-    // It is time to issue the next prefetch.
-    if (!m_endOfEpoch)
-    {
-        StartAsyncPrefetching();
-    }
-
-    // Let's wait till the previous memcopy has finished.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->WaitForCopyCPUToGPU();
-
-    return result.m_isDataAvailable;
+    return true;
 }
 
 template <class ElemType>
@@ -384,52 +556,92 @@ void FillMatrixFromStream(StorageFormat type, Matrix<ElemType>* matrix, size_t n
 }
 
 template <class ElemType>
-typename ReaderShim<ElemType>::PrefetchResult ReaderShim<ElemType>::PrefetchMinibatch(size_t currentDataTransferIndex)
+void ReaderShim<ElemType>::ReadSlot(PrefetchSlot& slot)
+{
+    slot.m_minibatch = m_reader->ReadMinibatch();
+    slot.m_readerState = m_reader->GetState();
+
+    const auto& minibatch = slot.m_minibatch;
+    slot.m_result = PrefetchResult{ minibatch.m_endOfSweep, minibatch.m_endOfEpoch, !minibatch.m_data.empty() };
+    if (minibatch.m_data.empty())
+        return;
+
+    for (auto& mx : slot.m_buffers)
+    {
+        if (m_streams[m_nameToStreamId[mx.first]].m_sampleLayout.IsUnknown())
+        {
+            // Sample layout can be lazily updated on the first minibatch, so let reread it.
+            // In the future we should use NDShape for the sequence instead of sample.
+            m_streams = m_reader->GetStreamDescriptions();
+            break;
+        }
+    }
+    slot.m_streams = m_streams;
+}
+
+template <class ElemType>
+void ReaderShim<ElemType>::FillSlot(PrefetchSlot& slot)
 {
     PROFILE_SCOPE(profilerEvtPrefetchMinibatch);
 
     // Resetting layouts.
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : slot.m_buffers)
         mx.second.m_mbLayout = std::make_shared<MBLayout>();
 
-    Minibatch minibatch = m_reader->ReadMinibatch();
-
-    // If there is no data we can simply return.
-    if (minibatch.m_data.empty())
-        return PrefetchResult{ minibatch.m_endOfSweep, minibatch.m_endOfEpoch, false };
-
-    // Ok we have some data. Let's load it to GPU.
+    // Let's load the data to GPU.
     // But before we need to make sure that corresponding compute has already finished from the last iteration.
 
     // We need to make sure that the compute for the current transfer is finished before we start prefetch.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->WaitForSyncPointOnAssignStreamAsync();
+    if (slot.m_dataTransferer)
+        slot.m_dataTransferer->WaitForSyncPointOnAssignStreamAsync();
 
-    m_getKeyById = minibatch.m_getKeyById;
+    const auto& minibatch = slot.m_minibatch;
+    slot.m_getKeyById = minibatch.m_getKeyById;
 
-    for (auto& mx : m_prefetchBuffers)
+    for (auto& mx : slot.m_buffers)
     {
         size_t streamId = m_nameToStreamId[mx.first];
         const auto& stream = minibatch.m_data[streamId];
         mx.second.m_mbLayout = stream->m_layout;
         mx.second.m_sampleShape = stream->m_sampleShape;
 
-        if (m_streams[streamId].m_sampleLayout.IsUnknown())
-        {
-            // Sample layout can be lazily updated on the first minibatch, so let reread it.
-            // In the future we should use NDShape for the sequence instead of sample.
-            m_streams = m_reader->GetStreamDescriptions();
-        }
+        size_t sampleSize = slot.m_streams[streamId].m_sampleLayout.TotalSize();
+        FillMatrixFromStream(slot.m_streams[streamId].m_storageFormat, mx.second.m_matrix.get(), sampleSize, stream, slot.m_dataTransferer.get());
+    }
 
-        size_t sampleSize = m_streams[streamId].m_sampleLayout.TotalSize();
-        FillMatrixFromStream(m_streams[streamId].m_storageFormat, mx.second.m_matrix.get(), sampleSize, stream, m_dataTransferers[currentDataTransferIndex].get());
+    // The data of the reader must not be used once the slot is filled, so let's wait for the copy.
+    if (slot.m_dataTransferer)
+    {
+        slot.m_dataTransferer->RecordCPUToGPUCopy();
+        slot.m_dataTransferer->WaitForCopyCPUToGPU();
     }
+}
+
+template <class ElemType>
+PrefetchStatistics ReaderShim<ElemType>::GetPrefetchStatistics()
+{
+    std::unique_lock<std::mutex> lock(m_prefetchLock);
+    return m_prefetchStatistics;
+}
 
-    // Let's record that we started the copy, so that the main thread can wait afterwards.
-    if (m_dataTransferers[currentDataTransferIndex])
-        m_dataTransferers[currentDataTransferIndex]->RecordCPUToGPUCopy();
+template <class ElemType>
+void ReaderShim<ElemType>::ReportPrefetchStatistics()
+{
+    if (m_traceLevel <= 0 || !m_prefetch)
+        return;
+
+    auto statistics = GetPrefetchStatistics();
+    if (statistics.m_numMinibatches == 0)
+        return;
+
+    double averageOccupancy = 0;
+    for (size_t i = 0; i < statistics.m_occupancyHistogram.size(); ++i)
+        averageOccupancy += i * statistics.m_occupancyHistogram[i];
+    averageOccupancy /= statistics.m_numMinibatches;
 
-    return PrefetchResult{ minibatch.m_endOfSweep, minibatch.m_endOfEpoch, true };
+    fprintf(stderr, "Prefetch: %d minibatches, %d (%.1f%%) waited for, %.3f seconds waiting, on average %.2f of %d prefetched minibatches ready.\n",
+            (int)statistics.m_numMinibatches, (int)statistics.m_numStalls, 100.0 * statistics.m_numStalls / statistics.m_numMinibatches,
+            statistics.m_waitSeconds, averageOccupancy, (int)m_slots.size());
 }
 
 template <class ElemType>
@@ -474,14 +686,8 @@ void ReaderShim<ElemType>::SetState(const std::map<std::wstring, size_t>& state)
     if (m_currentState == state)
         return;
 
-    // Make sure there are no outstanding reads.
-    if (m_prefetchTask.valid())
-        m_prefetchTask.wait();
-
-    // Let's check that there is no outstanding copies.
-    // Wait on all events if there are any pending copy operations in flight.
-    if (m_dataTransferers[m_currentDataTransferIndex])
-        m_dataTransferers[m_currentDataTransferIndex]->WaitForCopyCPUToGPU();
+    // Make sure there are no outstanding reads, the prefetched minibatches are dropped.
+    StopPrefetching();
 
     // Set current position.
     m_reader->SetState(state);
@@ -10,7 +10,9 @@
 
 #include <unordered_map>
 #include <string>
-#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "DataReader.h"
 #include "Reader.h"
 
@@ -26,6 +28,16 @@ struct ReaderConfiguration;
 
 typedef ReaderPtr (*ReaderFactory)(const MSR_CNTK::ConfigParameters& parameters);
 
+// Statistics of the prefetch ring of the ReaderShim, since the start of the epoch.
+// A trainer that often finds no prefetched minibatch in the ring is input-bound.
+struct PrefetchStatistics
+{
+    size_t m_numMinibatches{ 0 };              // minibatches handed out by GetMinibatch()
+    size_t m_numStalls{ 0 };                   // of which GetMinibatch() had to wait for
+    double m_waitSeconds{ 0 };                 // total time GetMinibatch() waited
+    std::vector<size_t> m_occupancyHistogram;  // [number of prefetched minibatches found in the ring] -> number of GetMinibatch() calls
+};
+
 template <class ElemType>
 class ReaderShim : public MSR_CNTK::IDataReader
 {
@@ -37,7 +49,7 @@ public:
     explicit ReaderShim(ReaderFactory factory);
     explicit ReaderShim(ReaderPtr reader);
 
-    virtual ~ReaderShim() { }
+    virtual ~ReaderShim();
 
     virtual void Init(const Microsoft::MSR::ScriptableObjects::IConfigRecord& /*config*/) override
     {
@@ -47,16 +59,7 @@ public:
 
     virtual void Destroy() override
     {
-        // Make sure there are no outstanding reads.
-        // Future destructor does not wait as of 2013 so probably it is not in VS2013:
-        // More info can be found here http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2013/n3679.html.
-        if (m_prefetchTask.valid())
-        {
-            // If there are some, give them time to finish.
-            m_prefetchTask.wait_for(std::chrono::seconds(60));
-            // TODO: if the prefetch is still valid, print a warning here!
-        }
-
+        // The destructor waits for the outstanding reads.
         delete this;
     }
 
@@ -114,9 +117,28 @@ public:
         return m_endOfSweep;
     }
 
+    PrefetchStatistics GetPrefetchStatistics();
+
 private:
 
-    void StartAsyncPrefetching();
+    // Prefetching.
+    // The minibatches are prefetched into a ring of m_slots, which a pool of threads fills ahead of GetMinibatch().
+    // A slot goes through the states Free -> Reading -> Read -> Filling -> Ready, and back to Free in GetMinibatch().
+    // The reader is not thread safe and defines the order of the minibatches, so the slots are read one at a time,
+    // in ring order, and each slot remembers the reader state after its minibatch. This keeps the minibatches and
+    // GetState() exactly the same as without the ring. Filling the matrices of a slot, which includes the copy to
+    // the GPU, runs in parallel with reading the next slot. The data of a minibatch is only valid until the
+    // reader has returned the next one as well (the packers alternate two buffers), so a slot is read only when
+    // all but the previous slot have been filled; more than two threads mostly wait.
+    // Everything below m_prefetchLock is protected by it.
+    enum class SlotState
+    {
+        Free,
+        Reading,
+        Read,
+        Filling,
+        Ready
+    };
 
     struct PrefetchResult
     {
@@ -125,9 +147,46 @@ private:
         bool m_isDataAvailable;
     };
 
-    PrefetchResult PrefetchMinibatch(size_t currentDataTransferIndex);
+    // Data structure required for prefetch.
+    struct StreamPrefetchBuffer
+    {
+        std::shared_ptr<MSR_CNTK::Matrix<ElemType>> m_matrix;
+        MSR_CNTK::MBLayoutPtr m_mbLayout;
+        NDShape m_sampleShape;
+    };
+
+    struct PrefetchSlot
+    {
+        PrefetchSlot() : m_state(SlotState::Free), m_ticket(0), m_result{ false, false, false } {}
+
+        SlotState m_state;
+        size_t m_ticket;                                   // position of the minibatch in the reading order
+
+        Minibatch m_minibatch;                             // as returned by the reader, until the slot is filled
+        std::vector<StreamInformation> m_streams;          // stream descriptions at the time of reading
+        std::map<std::wstring, size_t> m_readerState;      // reader state after this minibatch
+        PrefetchResult m_result;
+        std::exception_ptr m_error;                        // rethrown by GetMinibatch()
+
+        // Buffers where the prefetch thread puts its data to.
+        // When the main thread enters GetMinibatch it swaps the matrices from these buffers.
+        std::unordered_map<std::wstring, StreamPrefetchBuffer> m_buffers;
+        std::function<std::string(size_t)> m_getKeyById;
+
+        // Copies the data of this slot to the GPU, nullptr on the CPU.
+        MSR_CNTK::DataTransfererPtr m_dataTransferer;
+    };
+
+    void StartAsyncPrefetching();
+    void StopPrefetching();
+    void PrefetchLoop();
+    bool CanRead() const;
+    PrefetchSlot* FindSlotToFill();
+    void RunPrefetchStep(std::unique_lock<std::mutex>& lock);
+    void ReadSlot(PrefetchSlot& slot);
+    void FillSlot(PrefetchSlot& slot);
+    void ReportPrefetchStatistics();
 
-    std::future<PrefetchResult> m_prefetchTask;
     ReaderPtr m_reader;
     ReaderFactory m_factory;
     bool m_endOfEpoch;
@@ -137,37 +196,29 @@ private:
 
     std::unordered_map<std::wstring, size_t> m_nameToStreamId;
 
+    // Only accessed by the thread that reads a slot.
     std::vector<StreamInformation> m_streams;
-    launch m_launchType;
-
-    // Data structure required for prefetch.
-    struct StreamPrefetchBuffer
-    {
-        std::shared_ptr<MSR_CNTK::Matrix<ElemType>> m_matrix;
-        MSR_CNTK::MBLayoutPtr m_mbLayout;
-        NDShape m_sampleShape;
-    };
-
-    // Intermediate buffer where the prefetch thread puts its data to.
-    // When the main thread enters GetMinibatch it swaps the matrices from this buffer,
-    // triggers the next prefetch and waits if memCpy is still in progress.
-    std::unordered_map<std::wstring, StreamPrefetchBuffer> m_prefetchBuffers;
-
-    // Alternating data transfer operations. In the current version these are only two - 
-    // currently waiting on the main thread and the one that can be started by the prefetch thread 
-    // in the meantime.
-    std::vector<MSR_CNTK::DataTransfererPtr> m_dataTransferers;
-
-    // Id to key mapping.
-    std::function<std::string(size_t)> m_getKeyById;
 
-    // Current data transfer. Flips 0 and 1.
-    // Can be changed only from the main thread with no ongoing prefetch.
-    size_t m_currentDataTransferIndex; 
+    bool m_prefetch;              // false: the minibatches are read by GetMinibatch() itself
+    size_t m_numPrefetchThreads;
+    int m_traceLevel;
+
+    std::mutex m_prefetchLock;
+    std::condition_variable m_prefetchStateChanged;
+    std::vector<PrefetchSlot> m_slots;
+    std::vector<std::thread> m_prefetchThreads;
+    bool m_prefetchRunning;       // the threads may read further minibatches
+    bool m_stopPrefetchThreads;
+    bool m_isReading;             // a slot is being read
+    bool m_readerExhausted;       // end of epoch or error, nothing to read before StopPrefetching()
+    size_t m_nextTicket;          // next minibatch to read
+    size_t m_nextToConsume;       // next minibatch to hand out by GetMinibatch()
+    PrefetchStatistics m_prefetchStatistics;
 
     // Device id.
     int m_deviceId;
 
+    // Reader state after the last minibatch handed out by GetMinibatch().
     std::map<std::wstring, size_t> m_currentState;
 };
 
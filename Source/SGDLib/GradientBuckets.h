@@ -0,0 +1,258 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include "Basics.h"
+#include "Matrix.h"
+#include "MPIWrapper.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK {
+
+// Fusion buckets for overlapping gradient aggregation with backprop.
+//
+// The gradients are assigned to buckets of roughly fixed size, in the order in which backprop finalizes them,
+// i.e. in reverse order of the gradient list (which follows the evaluation order of the parameters).
+// As soon as all gradients of a bucket are final, they are copied into the bucket and the bucket is
+// all-reduced asynchronously, while backprop computes the gradients of the next buckets.
+// A gradient larger than the bucket size gets a bucket of its own and is reduced in place.
+//
+// Buckets are started strictly in bucket order, so that all workers issue the same sequence of collective
+// operations no matter in which order their gradients become final. A bucket that is complete but waits
+// for an earlier one is started together with it.
+//
+// The memory of a started bucket belongs to MPI until Complete(): a gradient that is reduced in place must
+// not be written anymore once it is reported ready, e.g. by accumulating sub-minibatches into it.
+//
+// Only dense gradients in CPU memory are supported, see CanReduce().
+template <class ElemType>
+class GradientBuckets
+{
+    typedef std::chrono::steady_clock Clock;
+
+public:
+    GradientBuckets(const MPIWrapperPtr& mpi, size_t bucketSizeInBytes)
+        : m_mpi(mpi), m_bucketSizeInBytes(bucketSizeInBytes), m_inIteration(false), m_numStarted(0), m_numStartedEarly(0)
+    {}
+
+    ~GradientBuckets()
+    {
+        // Make sure MPI does not write into freed buckets.
+        if (m_inIteration)
+        {
+            for (size_t i = 0; i < m_numStarted; i++)
+                m_mpi->Wait(&m_buckets[i].m_request);
+        }
+    }
+
+    // MPIWrapper::AllReduceAsync() works on host memory of float and double only.
+    static bool CanReduce(int deviceId)
+    {
+        return deviceId == CPUDEVICE && (std::is_same<ElemType, float>::value || std::is_same<ElemType, double>::value);
+    }
+
+    void Initialize(const std::vector<Matrix<ElemType>*>& gradients)
+    {
+        m_gradients = gradients;
+        m_buckets.clear();
+        m_bucketOfGradient.assign(gradients.size(), 0);
+
+        for (size_t i = gradients.size(); i-- > 0;)
+        {
+            size_t numElements = gradients[i]->GetNumElements();
+            if (m_buckets.empty() || (m_buckets.back().m_numElements + numElements) * sizeof(ElemType) > m_bucketSizeInBytes)
+                m_buckets.push_back(Bucket());
+
+            auto& bucket = m_buckets.back();
+            bucket.m_gradientIndices.push_back(i);
+            bucket.m_numElements += numElements;
+            m_bucketOfGradient[i] = m_buckets.size() - 1;
+        }
+
+        for (auto& bucket : m_buckets)
+        {
+            if (bucket.m_gradientIndices.size() > 1)
+                bucket.m_buffer.resize(bucket.m_numElements);
+        }
+    }
+
+    bool IsInitializedFor(const std::vector<Matrix<ElemType>*>& gradients) const
+    {
+        return m_gradients == gradients;
+    }
+
+    // Starts a new iteration; no gradient is final yet.
+    void Begin()
+    {
+        if (m_inIteration)
+            LogicError("GradientBuckets: Begin() called while the aggregation of the previous iteration is still in progress.");
+
+        m_inIteration = true;
+        m_numStarted = 0;
+        m_numStartedEarly = 0;
+        m_iterationStart = Clock::now();
+        m_isReady.assign(m_gradients.size(), false);
+        for (auto& bucket : m_buckets)
+        {
+            bucket.m_numReady = 0;
+            bucket.m_readyTime = bucket.m_startTime = bucket.m_packSeconds = bucket.m_waitSeconds = bucket.m_unpackSeconds = 0;
+        }
+    }
+
+    bool InIteration() const { return m_inIteration; }
+
+    bool AnyStarted() const { return m_numStarted > 0; }
+
+    // Called by backprop when gradients[index] will not change anymore in this iteration.
+    void GradientReady(size_t index)
+    {
+        if (!m_inIteration)
+            LogicError("GradientBuckets: GradientReady() called outside of an iteration.");
+
+        if (m_isReady[index])
+            LogicError("GradientBuckets: GradientReady() called twice for gradient %d, whose bucket may be in flight already.", (int)index);
+        m_isReady[index] = true;
+
+        auto& bucket = m_buckets[m_bucketOfGradient[index]];
+        if (++bucket.m_numReady == bucket.m_gradientIndices.size())
+            bucket.m_readyTime = SecondsSinceBegin();
+
+        while (m_numStarted < m_buckets.size() && m_buckets[m_numStarted].m_numReady == m_buckets[m_numStarted].m_gradientIndices.size())
+        {
+            Start(m_buckets[m_numStarted]);
+            m_numStarted++;
+            m_numStartedEarly++;
+        }
+    }
+
+    // Starts all buckets that backprop has not started. This must happen at the same point of the sequence of
+    // collective operations on all workers, i.e. before any other collective operation of the aggregation.
+    void StartRemaining()
+    {
+        if (!m_inIteration)
+            Begin();
+
+        for (; m_numStarted < m_buckets.size(); m_numStarted++)
+        {
+            auto& bucket = m_buckets[m_numStarted];
+            if (bucket.m_numReady < bucket.m_gradientIndices.size())
+                bucket.m_readyTime = SecondsSinceBegin();
+            Start(bucket);
+        }
+    }
+
+    // Waits for all buckets and copies the aggregated values back into the gradients.
+    void Complete(bool showSyncPerfStats)
+    {
+        StartRemaining();
+
+        size_t numBytes = 0;
+        for (auto& bucket : m_buckets)
+        {
+            auto start = Clock::now();
+            m_mpi->Wait(&bucket.m_request);
+            auto reduced = Clock::now();
+
+            if (!bucket.m_buffer.empty())
+            {
+                size_t offset = 0;
+                for (size_t i : bucket.m_gradientIndices)
+                {
+                    auto gradient = m_gradients[i];
+                    memcpy(gradient->Data(), bucket.m_buffer.data() + offset, gradient->GetNumElements() * sizeof(ElemType));
+                    offset += gradient->GetNumElements();
+                }
+            }
+
+            bucket.m_waitSeconds = std::chrono::duration<double>(reduced - start).count();
+            bucket.m_unpackSeconds = std::chrono::duration<double>(Clock::now() - reduced).count();
+            numBytes += bucket.m_numElements * sizeof(ElemType);
+        }
+        m_inIteration = false;
+
+        if (showSyncPerfStats)
+        {
+            fprintf(stderr, "Bucketed gradient aggregation: %d buckets, %.6g MB, %d started during backprop, done after %.6g seconds\n",
+                    (int)m_buckets.size(), numBytes / (1024.0 * 1024.0), (int)m_numStartedEarly, SecondsSinceBegin());
+            for (size_t i = 0; i < m_buckets.size(); i++)
+            {
+                const auto& bucket = m_buckets[i];
+                fprintf(stderr, "    bucket %d: %d gradients, %.6g KB, ready at %.6g, started at %.6g, pack %.6g, wait %.6g, unpack %.6g\n",
+                        (int)i, (int)bucket.m_gradientIndices.size(), bucket.m_numElements * sizeof(ElemType) / 1024.0,
+                        bucket.m_readyTime, bucket.m_startTime, bucket.m_packSeconds, bucket.m_waitSeconds, bucket.m_unpackSeconds);
+            }
+        }
+    }
+
+private:
+    struct Bucket
+    {
+        Bucket() : m_numElements(0), m_numReady(0), m_readyTime(0), m_startTime(0), m_packSeconds(0), m_waitSeconds(0), m_unpackSeconds(0) {}
+
+        std::vector<size_t> m_gradientIndices; // in the order in which they are packed
+        size_t m_numElements;
+        std::vector<ElemType> m_buffer;        // empty if the bucket holds a single gradient, which is reduced in place
+        MPI_Request m_request;
+        size_t m_numReady;
+
+        // Timing of the current iteration, in seconds since Begin().
+        double m_readyTime;
+        double m_startTime;
+        double m_packSeconds;
+        double m_waitSeconds;
+        double m_unpackSeconds;
+    };
+
+    void Start(Bucket& bucket)
+    {
+        auto start = Clock::now();
+        ElemType* data;
+        if (bucket.m_buffer.empty())
+            data = m_gradients[bucket.m_gradientIndices.front()]->Data();
+        else
+        {
+            data = bucket.m_buffer.data();
+            size_t offset = 0;
+            for (size_t i : bucket.m_gradientIndices)
+            {
+                auto gradient = m_gradients[i];
+                memcpy(data + offset, gradient->Data(), gradient->GetNumElements() * sizeof(ElemType));
+                offset += gradient->GetNumElements();
+            }
+        }
+        bucket.m_packSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        bucket.m_startTime = SecondsSinceBegin();
+        AllReduceAsync(data, bucket.m_numElements, &bucket.m_request);
+    }
+
+    void AllReduceAsync(float* data, size_t numElements, MPI_Request* request) { m_mpi->AllReduceAsync(data, numElements, request); }
+    void AllReduceAsync(double* data, size_t numElements, MPI_Request* request) { m_mpi->AllReduceAsync(data, numElements, request); }
+    template <class T>
+    void AllReduceAsync(T*, size_t, MPI_Request*) { LogicError("GradientBuckets: Unsupported element type."); }
+
+    double SecondsSinceBegin() const
+    {
+        return std::chrono::duration<double>(Clock::now() - m_iterationStart).count();
+    }
+
+    MPIWrapperPtr m_mpi;
+    const size_t m_bucketSizeInBytes;
+
+    std::vector<Matrix<ElemType>*> m_gradients;
+    std::vector<Bucket> m_buckets;          // in the order in which they are started
+    std::vector<size_t> m_bucketOfGradient; // per gradient index
+    std::vector<bool> m_isReady;            // per gradient index, whether GradientReady() has been called in this iteration
+
+    bool m_inIteration;
+    size_t m_numStarted;      // buckets [0, m_numStarted) have been started
+    size_t m_numStartedEarly; // of which started by GradientReady()
+    Clock::time_point m_iterationStart;
+
+    DISABLE_COPY_AND_MOVE(GradientBuckets);
+};
+
+}}}
@@ -19,6 +19,20 @@ public:
     // Returns a boolean indicating if any samples were processed
     virtual bool AggregateGradients(const std::vector<Matrix<ElemType>*>& gradients, DistGradHeader* headerCPU, bool resetState) = 0;
 
+    // Overlapping the aggregation with backprop: called before backprop with the gradients that the next
+    // AggregateGradients() call will get. Aggregators that support it then start aggregating the gradients
+    // reported by OnGradientReady() right away, and AggregateGradients() completes what was started.
+    // Returns false if the gradients will only be aggregated by AggregateGradients().
+    virtual bool BeginOverlappedAggregation(const std::vector<Matrix<ElemType>*>& /*gradients*/)
+    {
+        return false;
+    }
+
+    // Called during backprop when gradients[index] (see BeginOverlappedAggregation()) will not change anymore.
+    virtual void OnGradientReady(size_t /*index*/)
+    {
+    }
+
     size_t NumProc()
     {
         return m_mpi->NumNodesInUse();
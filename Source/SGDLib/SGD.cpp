@@ -810,6 +810,7 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                 if (m_loadBestModel)
                 {
                     // roll back
+                    WaitForAsyncCheckpoint();
                     auto bestModelPath = GetModelNameForEpoch(i - m_learnRateAdjustInterval);
                     LOGPRINTF(stderr, "Loading (rolling back to) previous model with best training-criterion value: %ls.\n", bestModelPath.c_str());
                     net->RereadPersistableParameters<ElemType>(bestModelPath);
@@ -916,18 +917,7 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
             }
             else
             {
-                SaveCheckPointInfo(
-                    i,
-                    totalTrainingSamplesSeen,
-                    learnRatePerSample,
-                    smoothedGradients,
-                    smoothedCounts,
-                    prevCriterion,
-                    chosenMinibatchSize);
-                auto modelName = GetModelNameForEpoch(i);
-                if (m_traceLevel > 0)
-                    LOGPRINTF(stderr, "SGD: Saving checkpoint model '%ls'\n", modelName.c_str());
-                net->Save(modelName);
+                vector<int> checkPointsToDelete;
                 if (!m_keepCheckPointFiles)
                 {
                     // delete previous checkpoint file to save space
@@ -935,18 +925,38 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
                     {
                         if (epochsSinceLastLearnRateAdjust != 1)
                         {
-                            _wunlink(GetCheckPointFileNameForEpoch(i - 1).c_str());
+                            checkPointsToDelete.push_back(i - 1);
                         }
                         if (epochsSinceLastLearnRateAdjust == m_learnRateAdjustInterval)
                         {
-                            _wunlink(GetCheckPointFileNameForEpoch(i - m_learnRateAdjustInterval).c_str());
+                            checkPointsToDelete.push_back(i - m_learnRateAdjustInterval);
                         }
                     }
                     else
                     {
-                        _wunlink(GetCheckPointFileNameForEpoch(i - 1).c_str());
+                        checkPointsToDelete.push_back(i - 1);
                     }
                 }
+
+                auto modelName = GetModelNameForEpoch(i);
+                if (m_traceLevel > 0)
+                    LOGPRINTF(stderr, "SGD: Saving checkpoint model '%ls'\n", modelName.c_str());
+                if (!m_checkpointWriter ||
+                    !SaveCheckPointAndModelAsync(i, net, learnableNodes, totalTrainingSamplesSeen, learnRatePerSample,
+                                                 smoothedGradients, smoothedCounts, prevCriterion, chosenMinibatchSize, checkPointsToDelete))
+                {
+                    SaveCheckPointInfo(
+                        i,
+                        totalTrainingSamplesSeen,
+                        learnRatePerSample,
+                        smoothedGradients,
+                        smoothedCounts,
+                        prevCriterion,
+                        chosenMinibatchSize);
+                    net->Save(modelName);
+                    for (int epochToDelete : checkPointsToDelete)
+                        _wunlink(GetCheckPointFileNameForEpoch(epochToDelete).c_str());
+                }
             }
         }
         else
@@ -966,6 +976,8 @@ void SGD<ElemType>::TrainOrAdaptModel(int startEpoch, ComputationNetworkPtr net,
     }
     // --- END OF MAIN EPOCH LOOP
 
+    WaitForAsyncCheckpoint();
+
     // Check if we need to save best model per criterion and this is the main node as well.
     if (m_saveBestModelPerCriterion && ((m_mpi == nullptr) || m_mpi->IsMainNode()))
     {
@@ -1063,6 +1075,7 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
     }
 
     std::vector<Matrix<ElemType>*> learnParamsGradients;
+    std::map<ComputationNodeBasePtr, size_t> learnParamsGradientIndex; // node -> index into learnParamsGradients
     Profiler profiler(m_numMBsToCUDAProfile);
 
     // resetting this, so profiling is performed for one epoch only
@@ -1266,6 +1279,18 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
             // We optionally break the minibatch into sub-minibatches.
             // This, when enabled, is used when a full minibatch does not fit into GPU RAM.
             size_t actualNumSubminibatches = numSubminibatchesNeeded <= 1 ? 1 : smbDispatcher.GetMinibatchIntoCache(*trainSetDataReader, *net, *inputMatrices, numSubminibatchesNeeded);
+
+            // In bucketed mode, the aggregator starts aggregating the gradients while backprop is still running.
+            // (The list of gradients is formed by the first aggregation, so the first minibatch is not overlapped.)
+            // Not with sub-minibatches: their gradients are accumulated after backprop, into the matrices that would be in flight.
+            bool overlapGradientAggregation = useGradientAggregation && actualNumSubminibatches == 1 && !learnParamsGradients.empty() &&
+                                              learnRatePerSample > 0.01 * m_minLearnRate && m_distGradAgg->BeginOverlappedAggregation(learnParamsGradients);
+            auto onGradientFinalized = [&](const ComputationNodeBasePtr& node)
+            {
+                auto index = learnParamsGradientIndex.find(node);
+                if (index != learnParamsGradientIndex.end())
+                    m_distGradAgg->OnGradientReady(index->second);
+            };
             for (size_t ismb = 0; ismb < actualNumSubminibatches; ismb++)
             {
                 if (actualNumSubminibatches > 1)
@@ -1288,7 +1313,13 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
                 // ===========================================================
 
                 if (learnRatePerSample > 0.01 * m_minLearnRate) // only compute gradient when learning rate is large enough
-                    net->Backprop(criterionNodes[0]);
+                {
+                    net->SetLossScale(m_lossScale);
+                    if (overlapGradientAggregation)
+                        net->Backprop(criterionNodes[0], onGradientFinalized);
+                    else
+                        net->Backprop(criterionNodes[0]);
+                }
 
                 // house-keeping for sub-minibatching
                 if (actualNumSubminibatches > 1)
@@ -1353,6 +1384,7 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
                             currParamsGradient->Resize(currParamsValues->GetNumRows(), currParamsValues->GetNumCols());
                         }
 
+                        learnParamsGradientIndex[*nodeIter] = learnParamsGradients.size();
                         learnParamsGradients.push_back(currParamsGradient);
                     }
                 }
@@ -1401,8 +1433,12 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
         ProfilerTimeEnd(profGradientAgg, profilerEvtMainGradient);
         auto profWeights = ProfilerTimeBegin();
 
+        // with dynamic loss scaling, the update is skipped if the gradients overflowed, on all workers alike since they are aggregated
+        bool updateModelParameters = (aggregateNumSamples > 0) && (learnRatePerSample > m_minLearnRate * 0.01);
+        bool gradientsOverflowed = updateModelParameters && m_dynamicLossScaling && GradientsHaveNanOrInf(learnableNodes);
+
         // update model parameters
-        if ((aggregateNumSamples > 0) && (learnRatePerSample > m_minLearnRate * 0.01))
+        if (updateModelParameters && !gradientsOverflowed)
         {
 #if 1       // BUGBUG: We must skip gaps in our momentum, clipping, regularization etc. criteria.
             // This will break test cases. So for now, we will only enable this for per-sample criteria.
@@ -1464,6 +1500,9 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
             }
         }
 
+        if (updateModelParameters && m_dynamicLossScaling)
+            UpdateLossScale(gradientsOverflowed);
+
 
         // aggregation by model averaging or block momentum 
         if (useModelAggregation)
@@ -1746,6 +1785,9 @@ size_t SGD<ElemType>::TrainOneEpoch(ComputationNetworkPtr net,
             localEpochEvalErrors, ContainsAccumulatedResult, m_packThresholdSizeInBytes);
     }
 
+    // other users of the network, e.g. GradientCheck(), expect unscaled gradients
+    net->SetLossScale(1);
+
     return numMBsRun;
 }
 
@@ -1885,6 +1927,7 @@ double SGD<ElemType>::SearchForBestLearnRate(ComputationNetworkPtr net,
     }
 
     int baseModelEpoch = epochNumber - 1;
+    WaitForAsyncCheckpoint();
     net->RereadPersistableParameters<ElemType>(GetModelNameForEpoch(baseModelEpoch));
 
     double learnRate = learnRatePerSample;
@@ -2262,6 +2305,7 @@ void SGD<ElemType>::TrainOneMiniEpochAndReloadModel(ComputationNetworkPtr net,
 
     // go back to where we came from
     int baseModelEpoch = epochNumber - 1;
+    WaitForAsyncCheckpoint();
     let path = GetModelNameForEpoch(baseModelEpoch);
     //fprintf(stderr, "Reverting parameters back to %ls\n", path.c_str());
     net->RereadPersistableParameters<ElemType>(path);
@@ -2352,7 +2396,7 @@ void SGD<ElemType>::InitDistGradAgg(int numEvalNodes, int numGradientBits, int d
     {
         if (traceLevel > 0)
             fprintf(stderr, "Initializing dataParallelSGD with FP%d aggregation.\n", numGradientBits);
-        m_distGradAgg = GetSimpleDistGradAggregator<ElemType>(m_mpi, m_bufferedAsyncGradientAggregation, deviceId, m_syncStatsTrace, m_packThresholdSizeInBytes, m_useFP16AllReduce);
+        m_distGradAgg = GetSimpleDistGradAggregator<ElemType>(m_mpi, m_bufferedAsyncGradientAggregation, deviceId, m_syncStatsTrace, m_packThresholdSizeInBytes, m_useFP16AllReduce, m_fusionBucketSizeInBytes);
     }
 
     m_gradHeader.reset(DistGradHeader::Create(numEvalNodes), [](DistGradHeader* ptr) { DistGradHeader::Destroy(ptr); });
@@ -2489,6 +2533,10 @@ void SGD<ElemType1>::TypedUpdateWeights(Matrix<ElemType>& functionValues, Matrix
     // make actualMBSize is a valid value
     assert(actualMBSize > 0);
 
+    // undo the loss scaling; for half parameters, this is done on the float copy of the gradient, see UpdateWeights()
+    if (m_lossScale != 1)
+        Matrix<ElemType>::Scale((ElemType)(1 / m_lossScale), gradientValues);
+
     // clipping gradients to prevent outliers
     ClipGradient<ElemType>(gradientValues, actualMBSize);
 
@@ -2579,6 +2627,35 @@ void SGD<ElemType1>::TypedUpdateWeights(Matrix<ElemType>& functionValues, Matrix
 #endif
 }
 
+template <class ElemType>
+bool SGD<ElemType>::GradientsHaveNanOrInf(const std::list<ComputationNodeBasePtr>& learnableNodes) const
+{
+    for (const auto& node : learnableNodes)
+    {
+        if (node->IsParameterUpdateRequired() && dynamic_pointer_cast<ComputationNode<ElemType>>(node)->Gradient().HasNanOrInf())
+            return true;
+    }
+    return false;
+}
+
+template <class ElemType>
+void SGD<ElemType>::UpdateLossScale(bool gradientsOverflowed)
+{
+    const double maxLossScale = 16777216; // 2^24, a bound for long runs without overflow
+    if (gradientsOverflowed)
+    {
+        m_lossScale = max(m_lossScale / 2, 1.0);
+        m_numMBsSinceLossScaleChange = 0;
+        if (m_traceLevel > 0)
+            LOGPRINTF(stderr, "UpdateLossScale: Gradients overflowed, minibatch skipped, loss scale reduced to %g.\n", m_lossScale);
+    }
+    else if (++m_numMBsSinceLossScaleChange >= m_lossScaleGrowthInterval && m_lossScale < maxLossScale)
+    {
+        m_lossScale *= 2;
+        m_numMBsSinceLossScaleChange = 0;
+    }
+}
+
 // protected:
 template <class ElemType1>
 template <class ElemType>
@@ -2643,60 +2720,153 @@ void SGD<ElemType>::SaveCheckPointInfo(const size_t epoch, const size_t totalSam
             File fstream(tempFileName, FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite);
             // Buffer writes in memory then flush to filesystem, which reduces number of small writes
             fstream.Setvbuf();
-            fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BVersion"); 
-            fstream << (size_t)CURRENT_CNTK_CHECKPOINT_VERSION; 
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EVersion");
+            WriteCheckPointInfo(fstream, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+        }
 
-            fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCKP");
-            fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BLearnRate");
-            fstream << totalSamplesSeen << learnRatePerSample << prevCriterion;
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ELearnRate");
+        _wunlink(checkPointFileName.c_str());
+        renameOrDie(tempFileName, checkPointFileName);
+    }
+}
 
-            fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BMinibatchSize");
-            fstream << minibatchSize;
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EMinibatchSize");
+template <class ElemType>
+void SGD<ElemType>::WriteCheckPointInfo(File& fstream, const size_t totalSamplesSeen,
+                                        const double learnRatePerSample,
+                                        const std::list<MatrixBasePtr>& smoothedGradients,
+                                        const std::vector<double>& smoothedCounts,
+                                        const double prevCriterion,
+                                        const size_t minibatchSize)
+{
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BVersion"); 
+    fstream << (size_t)CURRENT_CNTK_CHECKPOINT_VERSION; 
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EVersion");
 
-            fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BGradient");
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCKP");
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BLearnRate");
+    fstream << totalSamplesSeen << learnRatePerSample << prevCriterion;
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ELearnRate");
 
-            for (auto smoothedGradient : smoothedGradients)
-            {
-                if (std::is_same<ElemType, half>())
-                    SaveSmoothedGradient<float>(fstream, smoothedGradient);
-                else
-                    SaveSmoothedGradient<ElemType>(fstream, smoothedGradient);
-            }
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BMinibatchSize");
+    fstream << minibatchSize;
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EMinibatchSize");
 
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EGradient");
+    fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BGradient");
 
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"BCount");
+    for (auto smoothedGradient : smoothedGradients)
+    {
+        if (std::is_same<ElemType, half>())
+            SaveSmoothedGradient<float>(fstream, smoothedGradient);
+        else
+            SaveSmoothedGradient<ElemType>(fstream, smoothedGradient);
+    }
 
-            for (auto sc : smoothedCounts)
-                fstream << sc;
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"EGradient");
 
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECount");
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"BCount");
 
-            if (m_saveBestModelPerCriterion)
-            {
-                fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCriteria");
-                const int32_t criteriaSize = static_cast<int32_t>(m_criteriaBestEpoch.size());
-                fstream << criteriaSize;
-                for (const auto& criterion : m_criteriaBestEpoch)
-                {
-                    fstream << criterion.second.criterionMinValue << criterion.second.epochIndex;
-                }
-                fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECriteria");
-            }
+    for (auto sc : smoothedCounts)
+        fstream << sc;
+
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECount");
 
-            fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECKP");
-            if (m_pMASGDHelper)
-                m_pMASGDHelper->SaveToCheckPoint(fstream);
-            // Ensuring that data is written
-            fstream.Flush();
+    if (m_saveBestModelPerCriterion)
+    {
+        fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BCriteria");
+        const int32_t criteriaSize = static_cast<int32_t>(m_criteriaBestEpoch.size());
+        fstream << criteriaSize;
+        for (const auto& criterion : m_criteriaBestEpoch)
+        {
+            fstream << criterion.second.criterionMinValue << criterion.second.epochIndex;
         }
+        fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECriteria");
+    }
 
-        _wunlink(checkPointFileName.c_str());
-        renameOrDie(tempFileName, checkPointFileName);
+    if (m_dynamicLossScaling)
+    {
+        fstream.PutMarker(FileMarker::fileMarkerBeginSection, L"BLossScale");
+        fstream << m_lossScale << m_numMBsSinceLossScaleChange;
+        fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ELossScale");
+    }
+
+    fstream.PutMarker(FileMarker::fileMarkerEndSection, L"ECKP");
+    if (m_pMASGDHelper)
+        m_pMASGDHelper->SaveToCheckPoint(fstream);
+    // Ensuring that data is written
+    fstream.Flush();
+}
+
+static size_t MatrixSizeInBytes(const MatrixBasePtr& matrix)
+{
+    if (auto floatMatrix = dynamic_pointer_cast<Matrix<float>>(matrix))
+        return floatMatrix->GetNumElements() * sizeof(float);
+    if (auto doubleMatrix = dynamic_pointer_cast<Matrix<double>>(matrix))
+        return doubleMatrix->GetNumElements() * sizeof(double);
+    if (auto halfMatrix = dynamic_pointer_cast<Matrix<half>>(matrix))
+        return halfMatrix->GetNumElements() * sizeof(half);
+    return 0;
+}
+
+template <class ElemType>
+bool SGD<ElemType>::SaveCheckPointAndModelAsync(const size_t epoch, ComputationNetworkPtr net,
+                                                const std::list<ComputationNodeBasePtr>& learnableNodes,
+                                                const size_t totalSamplesSeen,
+                                                const double learnRatePerSample,
+                                                const std::list<MatrixBasePtr>& smoothedGradients,
+                                                const std::vector<double>& smoothedCounts,
+                                                const double prevCriterion,
+                                                const size_t minibatchSize,
+                                                const std::vector<int>& checkPointsToDelete)
+{
+    // Only one checkpoint is staged at a time.
+    m_checkpointWriter->Wait();
+
+    // The parameters and smoothed gradients make up most of the staged checkpoint.
+    size_t stagingSize = 0;
+    for (const auto& node : learnableNodes)
+        stagingSize += MatrixSizeInBytes(node->ValuePtr());
+    for (const auto& smoothedGradient : smoothedGradients)
+        stagingSize += MatrixSizeInBytes(smoothedGradient);
+    if (m_asyncCheckpointMaxStagingMB != 0 && stagingSize > m_asyncCheckpointMaxStagingMB * 1024 * 1024)
+    {
+        LOGPRINTF(stderr, "SGD: checkpoint of about %.1f MB exceeds asyncCheckpointMaxStagingMB = %d, saving it synchronously\n",
+                  stagingSize / (1024.0 * 1024.0), (int)m_asyncCheckpointMaxStagingMB);
+        return false;
     }
+
+    // Snapshot everything into memory. Serializing there is mostly copying the matrices, training continues
+    // while the background thread writes the files, syncs them to disk and renames them.
+    Timer timer;
+    timer.Start();
+    shared_ptr<File> checkPoint = File::CreateStagingFile(FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite);
+    WriteCheckPointInfo(*checkPoint, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+    shared_ptr<File> model = File::CreateStagingFile(FileOptions::fileOptionsBinary | FileOptions::fileOptionsWrite);
+    net->Save(*model);
+    timer.Stop();
+    if (m_traceLevel > 0)
+        LOGPRINTF(stderr, "SGD: Staged checkpoint in %.3f seconds, writing it in the background\n", timer.ElapsedSeconds());
+
+    vector<wstring> filesToDelete;
+    for (int epochToDelete : checkPointsToDelete)
+        filesToDelete.push_back(GetCheckPointFileNameForEpoch(epochToDelete));
+
+    // Same order as the synchronous save: the model file appears after its checkpoint file.
+    m_checkpointWriter->Submit({ { GetCheckPointFileNameForEpoch(int(epoch)), [checkPoint](const wstring& fileName) { checkPoint->WriteStagedTo(fileName); } },
+                                 { GetModelNameForEpoch(int(epoch)),          [model](const wstring& fileName) { model->WriteStagedTo(fileName); } } },
+                               [filesToDelete]()
+                               {
+                                   for (const auto& fileName : filesToDelete)
+                                       _wunlink(fileName.c_str());
+                               });
+    return true;
+}
+
+template <class ElemType>
+void SGD<ElemType>::WaitForAsyncCheckpoint()
+{
+    if (!m_checkpointWriter)
+        return;
+
+    m_checkpointWriter->Wait();
+    SynchronizeWorkers();
 }
 
 template <class ElemType>
@@ -2806,6 +2976,20 @@ void SGD<ElemType>::LoadCheckPointInfo(const size_t epochNumber,
         fstream.GetMarker(FileMarker::fileMarkerBeginSection, L"ECriteria");
     }
 
+    // the dynamic loss scale continues where it was, rather than backing off from m_initialLossScale again
+    if (fstream.TryGetMarker(FileMarker::fileMarkerBeginSection, L"BLossScale"))
+    {
+        double lossScale;
+        size_t numMBsSinceLossScaleChange;
+        fstream >> lossScale >> numMBsSinceLossScaleChange;
+        fstream.GetMarker(FileMarker::fileMarkerEndSection, L"ELossScale");
+        if (m_dynamicLossScaling)
+        {
+            m_lossScale = lossScale;
+            m_numMBsSinceLossScaleChange = numMBsSinceLossScaleChange;
+        }
+    }
+
     fstream.GetMarker(FileMarker::fileMarkerEndSection, L"ECKP");
 
     if (m_pMASGDHelper)
@@ -3138,6 +3322,14 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
     m_gradientClippingWithTruncation = configSGD(L"gradientClippingWithTruncation", true);
     m_clippingThresholdPerSample = configSGD(L"clippingThresholdPerSample", numeric_limits<double>::infinity());
 
+    m_dynamicLossScaling = configSGD(L"dynamicLossScaling", false);
+    m_initialLossScale = configSGD(L"lossScale", m_dynamicLossScaling ? 32768.0 : 1.0);
+    m_lossScaleGrowthInterval = configSGD(L"lossScaleGrowthInterval", (size_t)2000);
+    if (m_initialLossScale <= 0)
+        InvalidArgument("lossScale must be positive.");
+    if (m_dynamicLossScaling && m_lossScaleGrowthInterval == 0)
+        InvalidArgument("lossScaleGrowthInterval must be positive.");
+
     // sequence-training parameters
     m_hSmoothingWeight = configSGD(L"hSmoothingWeight", 0.95);
     m_frameDropThresh = configSGD(L"frameDropThresh", 1e-10);
@@ -3296,6 +3488,7 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
     m_numGradientBits = vector<int>{8 * (int)sizeofElemType}; // means no quantization
     m_zeroThresholdFor1Bit = true;
     m_bufferedAsyncGradientAggregation = false;
+    m_fusionBucketSizeInBytes = 0;
     m_enableDistributedMBReading = false;
     m_parallelizationStartEpochNum = 0;
     m_modelAggregationBlockSize = 0; 
@@ -3335,6 +3528,12 @@ SGDParams::SGDParams(const ConfigRecordType& configSGD, size_t sizeofElemType)
             m_numGradientBits = configDataParallelSGD(L"gradientBits", ConfigRecordType::Array(intargvector(vector<int>{defaultGradientBits})));
             m_zeroThresholdFor1Bit = configDataParallelSGD(L"useZeroThresholdFor1BitQuantization", true);
             m_bufferedAsyncGradientAggregation = configDataParallelSGD(L"useBufferedAsyncGradientAggregation", false);
+            if (configDataParallelSGD(L"useBucketedGradientAggregation", false))
+            {
+                if (m_bufferedAsyncGradientAggregation)
+                    InvalidArgument("useBucketedGradientAggregation cannot be combined with useBufferedAsyncGradientAggregation.");
+                m_fusionBucketSizeInBytes = configDataParallelSGD(L"fusionBucketSizeInKB", DEFAULT_FUSION_BUCKET_SIZE_IN_KB) * 1024;
+            }
             for (size_t i = 0; i < m_numGradientBits.size(); i++)
             {
                 if (m_numGradientBits[i] < 1 || m_numGradientBits[i] > defaultGradientBits)
@@ -20,6 +20,7 @@
 #include "Profiler.h"
 #include "MASGD.h"
 #include "ASGDHelper.h"
+#include "AsyncCheckpointWriter.h"
 #include <map>
 using namespace std; // ugh! TODO: get rid of this from .h files!!!
 
@@ -36,6 +37,10 @@ namespace CNTK { namespace Internal {
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
+namespace Test {
+    template <class ElemType> class SGDTestRunner;
+}
+
 struct BestEpoch;
 
 enum class LearningRateSearchAlgorithm : int
@@ -228,6 +233,14 @@ protected:
     bool m_gradientClippingWithTruncation;
     double m_clippingThresholdPerSample;
 
+    // loss scaling for training with half precision: the root gradient is the loss scale instead of 1, so that small
+    // gradients do not flush to zero, and the gradients are divided by it again in float before the update.
+    // With dynamic loss scaling, a minibatch whose gradients overflowed is skipped and the scale is halved;
+    // it is doubled again after m_lossScaleGrowthInterval minibatches without overflow.
+    double m_initialLossScale;
+    bool m_dynamicLossScaling;
+    size_t m_lossScaleGrowthInterval;
+
     intargvector m_numSamples4Search;
     size_t m_numBestSearchEpoch;
 
@@ -310,6 +323,8 @@ protected:
     // Data parallel SGD training parameters
     intargvector m_numGradientBits;
     bool m_bufferedAsyncGradientAggregation;
+    // Size of the fusion buckets for overlapping gradient aggregation with backprop; 0 if not overlapping.
+    size_t m_fusionBucketSizeInBytes;
     bool m_zeroThresholdFor1Bit;
 
     // Parallel training related with MA / BM
@@ -365,6 +380,8 @@ protected:
     typedef shared_ptr<ComputationNode<ElemType>> ComputationNodePtr;
     typedef ClassBasedCrossEntropyWithSoftmaxNode<ElemType>* ClassBasedCrossEntropyWithSoftmaxNodePtr;
 
+    friend class Test::SGDTestRunner<ElemType>;
+
 public:
     // constructor from old CNTK config. This is a function template that is also used to get the config from Scripting.
     template <class ConfigRecordType>
@@ -374,6 +391,8 @@ public:
           m_modelPath((const wstring&) configSGD(L"modelPath")),
           m_keepCheckPointFiles(configSGD(L"keepCheckPointFiles", false)),
           m_saveBestModelPerCriterion(configSGD(L"saveBestModelPerCriterion", false)),
+          m_asyncCheckpoint(configSGD(L"asyncCheckpoint", false)),
+          m_asyncCheckpointMaxStagingMB(configSGD(L"asyncCheckpointMaxStagingMB", (size_t)4096)),
           m_trainCriterionNodeName((const wstring&) configSGD(L"trainCriterionNodeName", L"")),
           m_evalCriterionNodeName ((const wstring&) configSGD(L"evalCriterionNodeName", L"")),
           m_traceNodeNamesReal    (configSGD(L"traceNodeNamesReal",     ConfigRecordType::Array(stringargvector()))),
@@ -381,10 +400,14 @@ public:
           m_traceNodeNamesSparse  (configSGD(L"traceNodeNamesSparse",   ConfigRecordType::Array(stringargvector()))),
           m_prevChosenMinibatchSize(0),
           m_lastFinishedEpochTrainLoss(0.0),
+          m_lossScale(m_initialLossScale),
+          m_numMBsSinceLossScaleChange(0),
           m_distGradAgg(nullptr),
           m_gradHeader(nullptr)
     {
         msra::files::make_intermediate_dirs(m_modelPath);
+        if (m_asyncCheckpoint)
+            m_checkpointWriter.reset(new AsyncCheckpointWriter());
     }
     // note: This must be in the header, as we cannot properly specialize this constructor in the CPP to make sure all versions are generated.
 
@@ -553,6 +576,10 @@ private:
                        const double L2RegWeight, const double L1RegWeight,
                        const bool needAveMultiplier,
                        const bool useNesterovMomentum) const;
+
+    // for dynamic loss scaling: checks the aggregated gradients for overflow, and adapts the loss scale after the update
+    bool GradientsHaveNanOrInf(const std::list<ComputationNodeBasePtr>& learnableNodes) const;
+    void UpdateLossScale(bool gradientsOverflowed);
 public:
     // return -1 if nothing exists
     int DetermineStartEpoch(const bool makeMode);
@@ -570,6 +597,29 @@ protected:
                             const double prevCriterion,
                             const size_t minibatchSize);
 
+    void WriteCheckPointInfo(File& fstream, const size_t totalSamplesSeen,
+                             const double learnRatePerSample,
+                             const std::list<MatrixBasePtr>& smoothedGradients,
+                             const std::vector<double>& smoothedCounts,
+                             const double prevCriterion,
+                             const size_t minibatchSize);
+
+    // With asyncCheckpoint: stages the checkpoint and the model of an epoch in memory, and writes them on a
+    // background thread, which then deletes the given older checkpoint files.
+    // Returns false if the checkpoint is too large for staging; the caller then saves it synchronously.
+    bool SaveCheckPointAndModelAsync(const size_t epoch, ComputationNetworkPtr net,
+                                     const std::list<ComputationNodeBasePtr>& learnableNodes,
+                                     const size_t totalSamplesSeen,
+                                     const double learnRatePerSample,
+                                     const std::list<MatrixBasePtr>& smoothedGradients,
+                                     const std::vector<double>& smoothedCounts,
+                                     const double prevCriterion,
+                                     const size_t minibatchSize,
+                                     const std::vector<int>& checkPointsToDelete);
+
+    // Waits until the checkpoint written in the background is on disk, on all workers, before anyone reads it.
+    void WaitForAsyncCheckpoint();
+
     bool TryLoadCheckPointInfo(const size_t epochNumber,
                                /*out*/ size_t& totalSamplesSeen,
                                /*out*/ double& learnRatePerSample,
@@ -608,6 +658,9 @@ protected:
     std::wstring m_modelPath;
     bool m_keepCheckPointFiles;
     bool m_saveBestModelPerCriterion;
+    bool m_asyncCheckpoint;
+    size_t m_asyncCheckpointMaxStagingMB;
+    std::unique_ptr<AsyncCheckpointWriter> m_checkpointWriter; // only with asyncCheckpoint
     // Mapping from criterion to the best epoch on validation data set.
     std::map<std::wstring, BestEpoch> m_criteriaBestEpoch;
 
@@ -622,6 +675,9 @@ protected:
     size_t m_prevChosenMinibatchSize;
     double m_lastFinishedEpochTrainLoss;
 
+    double m_lossScale; // current loss scale, see m_initialLossScale; saved in the checkpoints with dynamic loss scaling
+    size_t m_numMBsSinceLossScaleChange;
+
     std::shared_ptr<IDistGradAggregator<ElemType>> m_distGradAgg;
     std::shared_ptr<struct DistGradHeader> m_gradHeader;
 
@@ -16,6 +16,7 @@
 #include "GPUDataTransferer.h"
 #include "TimerUtility.h"
 #include "MatrixQuantizerImpl.h"
+#include "GradientBuckets.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -25,9 +26,9 @@ class SimpleDistGradAggregator : public IDistGradAggregator<ElemType>
     UsingIDistGradAggregatorMembers;
 
 public:
-    SimpleDistGradAggregator(const MPIWrapperPtr& mpi, bool useAsyncAggregation, int deviceId, int syncStatsTrace, size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES)
+    SimpleDistGradAggregator(const MPIWrapperPtr& mpi, bool useAsyncAggregation, int deviceId, int syncStatsTrace, size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES, size_t fusionBucketSizeInBytes = 0)
         : IDistGradAggregator<ElemType>(mpi), m_useAsyncAggregation(useAsyncAggregation), m_initialized(false), m_bufferedGradHeader(nullptr), m_syncStatsTrace(syncStatsTrace),
-        m_iterationCount(0), m_packThresholdSizeInBytes(packThresholdSizeInBytes)
+        m_iterationCount(0), m_packThresholdSizeInBytes(packThresholdSizeInBytes), m_fusionBucketSizeInBytes(fusionBucketSizeInBytes)
     {}
 
     ~SimpleDistGradAggregator()
@@ -135,6 +136,21 @@ public:
         }
     }
 
+    // Only in bucketed mode, which is set up by the first AggregateGradients() call.
+    bool BeginOverlappedAggregation(const std::vector<Matrix<ElemType>*>& gradients) override
+    {
+        if (!m_gradientBuckets || !m_gradientBuckets->IsInitializedFor(gradients))
+            return false;
+
+        m_gradientBuckets->Begin();
+        return true;
+    }
+
+    void OnGradientReady(size_t index) override
+    {
+        m_gradientBuckets->GradientReady(index);
+    }
+
 private:
     std::shared_ptr<ElemType> AllocateIntermediateBuffer(int deviceID, size_t numElements)
     {
@@ -175,10 +191,22 @@ private:
                 m_allocator.reset(new CUDAPageLockedMemAllocator(deviceId));
             }
 
+            // Bucketed mode replaces packing: gradients are packed into fusion buckets, which are reduced
+            // with MPIWrapper::AllReduceAsync() while backprop is still running.
+            if (m_fusionBucketSizeInBytes > 0 && !m_useAsyncAggregation && !m_nccl->IsSupported() && GradientBuckets<ElemType>::CanReduce(deviceId))
+            {
+                m_gradientBuckets.reset(new GradientBuckets<ElemType>(m_mpi, m_fusionBucketSizeInBytes));
+                m_gradientBuckets->Initialize(gradients);
+            }
+
             size_t packedGradientsSizeInElements = 0;
             for (size_t i = 0; i < gradients.size(); i++)
             {
-                if (!m_useAsyncAggregation && sizeof(ElemType) * gradients[i]->GetNumElements() <= m_packThresholdSizeInBytes)
+                if (m_gradientBuckets)
+                {
+                    // nothing to do, see GradientBuckets
+                }
+                else if (!m_useAsyncAggregation && sizeof(ElemType) * gradients[i]->GetNumElements() <= m_packThresholdSizeInBytes)
                 {
                     packedGradientsSizeInElements += gradients[i]->GetNumElements();
                     m_packedGradientsIndex.push_back(i);
@@ -203,7 +231,11 @@ private:
                 m_aggregationBuffer.reset(new (std::nothrow) Matrix<ElemType>(1, packedGradientsSizeInElements, deviceId));
             }
             // If no extra continous buffer allocated or using async aggregation
-            if (m_aggregationBuffer == nullptr)
+            if (m_gradientBuckets)
+            {
+                // nothing to do, see GradientBuckets
+            }
+            else if (m_aggregationBuffer == nullptr)
             {
                 m_gradientIndexToAggregate.clear();
                 m_packedGradientsIndex.clear();
@@ -279,7 +311,9 @@ private:
             for (int i = 0; i < headerCPU->numEvalNode; ++i)
                 assert(headerCPU->evalErrors[i].first == 0 && headerCPU->evalErrors[i].second == 0);
 
-            // If the current node did not process any samples, the gradients should be zero'd
+            // If the current node did not process any samples, the gradients should be zero'd.
+            // (Backprop did not run then, so no bucket can have been started with the stale gradients.)
+            assert(!m_gradientBuckets || !m_gradientBuckets->AnyStarted());
             for (size_t i = 0; i < numGradMatrices; ++i)
                 gradients[i]->SetValue(0);
 
@@ -323,7 +357,12 @@ private:
         size_t cpuToGpuIndex = 0;
         size_t allReduceIndex = 0;
         size_t numGradientIndex = m_gradientIndexToAggregate.size();
-        if (numGradientIndex > 0)
+        if (m_gradientBuckets)
+        {
+            // Start the buckets backprop did not start, before the collective operations of the header.
+            m_gradientBuckets->StartRemaining();
+        }
+        else if (numGradientIndex > 0)
         {
             // non-GDR && GPU && non-NCCL: need to copy data from GPU to CPU
             if ((m_mpi->UseGpuGdr() == 0) && (deviceId != CPUDEVICE) && !m_nccl->IsSupported())
@@ -443,7 +482,11 @@ private:
         // Broadcast the aggregated header to all nodes
         m_mpi->Bcast(headerCPU, headerCPU->Size(), MPI_CHAR, m_mpi->MainNodeRank());
 
-        if (m_nccl->IsSupported())
+        if (m_gradientBuckets)
+        {
+            m_gradientBuckets->Complete(showSyncPerfStats);
+        }
+        else if (m_nccl->IsSupported())
         {
             m_nccl->Sync();
         }
@@ -509,6 +552,10 @@ private:
     std::vector<size_t> m_packedGradientsIndex;
     std::vector<size_t> m_gradientIndexToAggregate;
 
+    // Bucketed mode, overlapping the aggregation with backprop; off if the bucket size is 0 (tunable by "fusionBucketSizeInKB=[value]")
+    const size_t m_fusionBucketSizeInBytes;
+    std::unique_ptr<GradientBuckets<ElemType>> m_gradientBuckets;
+
     int m_syncStatsTrace;
 
     // Only used for controlling frequency of measuring/showing gradient aggregation perf stats
@@ -25,7 +25,8 @@ std::shared_ptr<IDistGradAggregator<ElemType>> GetSimpleDistGradAggregator(
     int deviceId,
     int syncStatsTrace,
     size_t packThresholdSizeInBytes,
-    bool useFP16AllReduce)
+    bool useFP16AllReduce,
+    size_t fusionBucketSizeInBytes)
 {
     if (Globals::UseV2Aggregator())
         return std::make_shared<V2SimpleDistGradAggregator<ElemType>>(
@@ -33,14 +34,16 @@ std::shared_ptr<IDistGradAggregator<ElemType>> GetSimpleDistGradAggregator(
             useAsyncAggregation,
             deviceId,
             syncStatsTrace,
-            ::CNTK::MPICommunicator(packThresholdSizeInBytes, useFP16AllReduce));
+            ::CNTK::MPICommunicator(packThresholdSizeInBytes, useFP16AllReduce),
+            fusionBucketSizeInBytes);
     else
         return std::make_shared<SimpleDistGradAggregator<ElemType>>(
             mpi,
             useAsyncAggregation,
             deviceId,
             syncStatsTrace,
-            packThresholdSizeInBytes);
+            packThresholdSizeInBytes,
+            fusionBucketSizeInBytes);
 }
 
 template <>
@@ -50,7 +53,8 @@ std::shared_ptr<IDistGradAggregator<half>> GetSimpleDistGradAggregator<half>(
     int deviceId,
     int syncStatsTrace,
     size_t packThresholdSizeInBytes,
-    bool useFP16AllReduce)
+    bool useFP16AllReduce,
+    size_t fusionBucketSizeInBytes)
 {
     if (Globals::UseV2Aggregator())
         return std::make_shared<V2SimpleDistGradAggregator<half>>(
@@ -58,7 +62,8 @@ std::shared_ptr<IDistGradAggregator<half>> GetSimpleDistGradAggregator<half>(
             useAsyncAggregation,
             deviceId,
             syncStatsTrace,
-            ::CNTK::MPICommunicator(packThresholdSizeInBytes, useFP16AllReduce));
+            ::CNTK::MPICommunicator(packThresholdSizeInBytes, useFP16AllReduce),
+            fusionBucketSizeInBytes);
     else
         RuntimeError("SGD - half not supported when useV2Aggregator is false!");
 }
@@ -69,7 +74,8 @@ template std::shared_ptr<IDistGradAggregator<float>> GetSimpleDistGradAggregator
     int deviceId,
     int syncStatsTrace,
     size_t packThresholdSizeInBytes,
-    bool useFP16AllReduce);
+    bool useFP16AllReduce,
+    size_t fusionBucketSizeInBytes);
 
 template std::shared_ptr<IDistGradAggregator<double>> GetSimpleDistGradAggregator<double>(
     const MPIWrapperPtr& mpi,
@@ -77,6 +83,7 @@ template std::shared_ptr<IDistGradAggregator<double>> GetSimpleDistGradAggregato
     int deviceId,
     int syncStatsTrace,
     size_t packThresholdSizeInBytes,
-    bool useFP16AllReduce);
+    bool useFP16AllReduce,
+    size_t fusionBucketSizeInBytes);
 
 }}}
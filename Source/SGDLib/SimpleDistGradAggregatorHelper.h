@@ -19,6 +19,7 @@ std::shared_ptr<IDistGradAggregator<ElemType>> GetSimpleDistGradAggregator(
     int deviceId,
     int syncStatsTrace,
     size_t packThresholdSizeInBytes = DEFAULT_PACK_THRESHOLD_SIZE_IN_BYTES,
-    bool useFP16AllReduce = false);
+    bool useFP16AllReduce = false,
+    size_t fusionBucketSizeInBytes = 0);
 
 }}}
@@ -15,6 +15,7 @@
 #include "MatrixQuantizerImpl.h"
 #include "Utils.h"
 #include "NcclComm.h"
+#include "GradientBuckets.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK {
 
@@ -26,9 +27,9 @@ class V2SimpleDistGradAggregator : public IDistGradAggregator<ElemType>
     NcclComm m_nccl;
 
 public:
-    V2SimpleDistGradAggregator(const MPIWrapperPtr& mpi, bool useAsyncAggregation, int deviceId, int syncStatsTrace, ::CNTK::DistributedCommunicatorPtr communicator)
+    V2SimpleDistGradAggregator(const MPIWrapperPtr& mpi, bool useAsyncAggregation, int deviceId, int syncStatsTrace, ::CNTK::DistributedCommunicatorPtr communicator, size_t fusionBucketSizeInBytes = 0)
         : IDistGradAggregator<ElemType>(mpi), m_useAsyncAggregation(useAsyncAggregation), m_initialized(false), m_bufferedGradHeader(nullptr), m_syncStatsTrace(syncStatsTrace), m_iterationCount(0),
-        m_communicator(communicator), m_nccl(deviceId, mpi)
+        m_communicator(communicator), m_nccl(deviceId, mpi), m_fusionBucketSizeInBytes(fusionBucketSizeInBytes)
     {}
 
     ~V2SimpleDistGradAggregator()
@@ -121,6 +122,21 @@ public:
         return false;
     }
 
+    // Only in bucketed mode, which is set up by the first AggregateGradients() call.
+    bool BeginOverlappedAggregation(const std::vector<Matrix<ElemType>*>& gradients) override
+    {
+        if (!m_gradientBuckets || !m_gradientBuckets->IsInitializedFor(gradients))
+            return false;
+
+        m_gradientBuckets->Begin();
+        return true;
+    }
+
+    void OnGradientReady(size_t index) override
+    {
+        m_gradientBuckets->GradientReady(index);
+    }
+
 private:
     bool IsInitialized() const { return m_initialized; }
     void Initialize(const std::vector<Matrix<ElemType>*>& gradients, int numEvalNodes)
@@ -141,6 +157,14 @@ private:
             m_bufferedGradHeader = DistGradHeader::Create(numEvalNodes);
             m_bufferedGradHeader->Clear();
         }
+
+        // In bucketed mode the gradients bypass the communicator: they are reduced in fusion buckets with
+        // MPIWrapper::AllReduceAsync() while backprop is still running, and only the header goes through AggregateInPlace().
+        if (m_fusionBucketSizeInBytes > 0 && !m_useAsyncAggregation && !m_nccl.IsSupported() && m_mpi != nullptr && GradientBuckets<ElemType>::CanReduce(deviceId))
+        {
+            m_gradientBuckets.reset(new GradientBuckets<ElemType>(m_mpi, m_fusionBucketSizeInBytes));
+            m_gradientBuckets->Initialize(gradients);
+        }
         m_initialized = true;
     }
 
@@ -178,7 +202,9 @@ private:
             for (int i = 0; i < headerCPU->numEvalNode; ++i)
                 assert(headerCPU->evalErrors[i].first == 0 && headerCPU->evalErrors[i].second == 0);
 
-            // If the current node did not process any samples, the gradients should be zero'd
+            // If the current node did not process any samples, the gradients should be zero'd.
+            // (Backprop did not run then, so no bucket can have been started with the stale gradients.)
+            assert(!m_gradientBuckets || !m_gradientBuckets->AnyStarted());
             for (size_t i = 0; i < gradients.size(); ++i)
                 gradients[i]->SetValue(0);
 
@@ -195,6 +221,11 @@ private:
         {                         // we assume in this case all grad layers are on the GPU too.
             m_nccl.AllReduce(gradients);
         }
+        else if (m_gradientBuckets)
+        {
+            // Start the buckets backprop did not start, before the collective operations of the header.
+            m_gradientBuckets->StartRemaining();
+        }
         else
         {
             for (size_t i = 0; i < gradients.size(); ++i)
@@ -227,6 +258,8 @@ private:
 
         if (m_nccl.IsSupported())
             m_nccl.Sync();
+        else if (m_gradientBuckets)
+            m_gradientBuckets->Complete(showSyncPerfStats);
 
         // Copy data back to the header
         headerCPU->criterion = headerBuffer[0];
@@ -261,6 +294,10 @@ private:
     int m_syncStatsTrace;
     size_t m_iterationCount;
     bool m_initialized;
+
+    // Bucketed mode, overlapping the aggregation with backprop; off if the bucket size is 0
+    const size_t m_fusionBucketSizeInBytes;
+    std::unique_ptr<GradientBuckets<ElemType>> m_gradientBuckets;
 };
 
 }}}
@@ -8,6 +8,7 @@
 #include "Matrix.h"
 #include "CUDAPageLockedMemAllocator.h"
 
+#include <exception>
 #include <memory>
 #include <vector>
 
@@ -97,6 +98,12 @@ public:
                        std::vector<size_t>& extrauttmap,
                        bool doreferencealign)
     {
+        if (m_deviceid == CPUDEVICE)
+        {
+            calgammaformbcpu(functionValues, lattices, loglikelihood, labels, gammafromlattice, uids, boundaries, samplesInRecurrentStep, pMBLayout, extrauttmap, doreferencealign);
+            return;
+        }
+
         // check total frame number to be added ?
         // int deviceid = loglikelihood.GetDeviceId();
         size_t boundaryframenum;
@@ -151,22 +158,7 @@ public:
                 // get number of frames for the utterance
                 mapi = extrauttmap[i]; // parallel-sequence index; in case of >1 utterance within this parallel sequence, this is in order of concatenation
 
-                // scan MBLayout for end of utterance
-                size_t mapframenum = SIZE_MAX; // duration of utterance [i] as determined from MBLayout
-                for (size_t t = validframes[mapi]; t < T; t++)
-                {
-                    // TODO: Adapt this to new MBLayout, m_sequences would be easier to work off.
-                    if (pMBLayout->IsEnd(mapi, t))
-                    {
-                        mapframenum = t - validframes[mapi] + 1;
-                        break;
-                    }
-                }
-
-                // must match the explicit information we get from the reader
-                if (numframes != mapframenum)
-                    LogicError("gammacalculation: IsEnd() not working, numframes (%d) vs. mapframenum (%d)", (int) numframes, (int) mapframenum);
-                assert(numframes == mapframenum);
+                CheckNumFramesInLayout(*pMBLayout, mapi, validframes[mapi], T, numframes);
 
                 if (numframes > tempmatrix.GetNumCols())
                     tempmatrix.Resize(numrows, numframes);
@@ -384,6 +376,152 @@ public:
     }
 
 private:
+    // CPU version of calgammaformb(). The utterances of a minibatch are independent, so their lattice forward-backward
+    // passes run in parallel, one utterance per thread. Each utterance works on its own column stripes of pred,
+    // dengammas and uids, and reads and writes its own columns of the minibatch matrices, which are in CPU memory.
+    void calgammaformbcpu(Microsoft::MSR::CNTK::Matrix<ElemType>& functionValues,
+                          std::vector<std::shared_ptr<const msra::dbn::latticepair>>& lattices,
+                          const Microsoft::MSR::CNTK::Matrix<ElemType>& loglikelihood,
+                          Microsoft::MSR::CNTK::Matrix<ElemType>& labels,
+                          Microsoft::MSR::CNTK::Matrix<ElemType>& gammafromlattice,
+                          std::vector<size_t>& uids, std::vector<size_t>& boundaries,
+                          size_t samplesInRecurrentStep,
+                          std::shared_ptr<Microsoft::MSR::CNTK::MBLayout> pMBLayout,
+                          std::vector<size_t>& extrauttmap,
+                          bool doreferencealign)
+    {
+        const size_t numrows = loglikelihood.GetNumRows();
+        const size_t numcols = loglikelihood.GetNumCols();
+        if (numcols > pred.cols())
+        {
+            pred.resize(numrows, numcols);
+            dengammas.resize(numrows, numcols);
+        }
+
+        if (doreferencealign)
+            labels.SetValue((ElemType)(0.0f));
+
+        size_t T = numcols / samplesInRecurrentStep; // number of time steps in minibatch
+        if (samplesInRecurrentStep > 1)
+        {
+            assert(extrauttmap.size() == lattices.size());
+            assert(T == pMBLayout->GetNumTimeSteps());
+        }
+
+        // locate the utterances: utterance [i] is at columns ts[i]... of pred, dengammas and uids (utterances concatenated),
+        // and at columns firstcol[i] + t * samplesInRecurrentStep in the minibatch
+        const size_t numutterances = lattices.size();
+        std::vector<size_t> ts(numutterances);
+        std::vector<size_t> firstcol(numutterances);
+        std::vector<size_t> validframes(samplesInRecurrentStep, 0); // [s] cursor pointing to next utterance begin within a single parallel sequence [s]
+        size_t tsnext = 0;
+        for (size_t i = 0; i < numutterances; i++)
+        {
+            const size_t numframes = lattices[i]->getnumframes();
+            ts[i] = tsnext;
+            if (samplesInRecurrentStep == 1) // no sequence parallelism
+                firstcol[i] = ts[i];
+            else
+            {
+                const size_t mapi = extrauttmap[i]; // parallel-sequence index; in case of >1 utterance within this parallel sequence, this is in order of concatenation
+                CheckNumFramesInLayout(*pMBLayout, mapi, validframes[mapi], T, numframes);
+                firstcol[i] = mapi + validframes[mapi] * samplesInRecurrentStep;
+                validframes[mapi] += numframes; // advance the cursor within the parallel sequence
+            }
+            tsnext += numframes;
+        }
+
+        const ElemType* loglls = loglikelihood.Data();
+        ElemType* gammas = gammafromlattice.Data();
+        std::vector<double> objectValues(numutterances);
+        std::vector<double> denavlogps(numutterances);
+        std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < (int) numutterances; i++)
+        {
+            try
+            {
+                const size_t numframes = lattices[i]->getnumframes();
+                msra::dbn::matrixstripe predstripe(pred, ts[i], numframes);           // logLLs for this utterance
+                msra::dbn::matrixstripe dengammasstripe(dengammas, ts[i], numframes); // denominator gammas
+                for (size_t t = 0; t < numframes; t++)
+                {
+                    const ElemType* loglljt = loglls + (firstcol[i] + t * samplesInRecurrentStep) * numrows;
+                    for (size_t s = 0; s < numrows; s++)
+                        predstripe(s, t) = (float) loglljt[s];
+                }
+
+                array_ref<size_t> uidsstripe(&uids[ts[i]], numframes);
+                array_ref<size_t> boundariesstripe(&boundaries[ts[i]], doreferencealign ? numframes : 0);
+
+                double numavlogp = 0;
+                foreach_column (t, dengammasstripe) // we do not allocate memory for numgamma now, should be the same as numgammasstripe
+                {
+                    const size_t s = uidsstripe[t];
+                    numavlogp += predstripe(s, t) / amf;
+                }
+                numavlogp /= numframes;
+
+                double denavlogp = lattices[i]->second.forwardbackward(parallellattice,
+                                                                       (const msra::math::ssematrixbase&) predstripe, (const msra::asr::simplesenonehmm&) m_hset,
+                                                                       (msra::math::ssematrixbase&) dengammasstripe, (msra::math::ssematrixbase&) gammasbuffer /*empty, not used*/,
+                                                                       lmf, wp, amf, boostmmifactor, seqsMBRmode, uidsstripe, boundariesstripe);
+                objectValues[i] = (numavlogp - denavlogp) * numframes;
+                denavlogps[i] = denavlogp;
+
+                for (size_t t = 0; t < numframes; t++)
+                {
+                    ElemType* gammajt = gammas + (firstcol[i] + t * samplesInRecurrentStep) * numrows;
+                    for (size_t s = 0; s < numrows; s++)
+                        gammajt[s] = (ElemType) dengammasstripe(s, t);
+                }
+            }
+            catch (...)
+            {
+#pragma omp critical
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        ElemType objectValue = 0.0;
+        for (size_t i = 0; i < numutterances; i++)
+        {
+            const size_t numframes = lattices[i]->getnumframes();
+            if (doreferencealign)
+            {
+                for (size_t nframe = 0; nframe < numframes; nframe++)
+                    labels(uids[ts[i] + nframe], firstcol[i] + nframe * samplesInRecurrentStep) = 1.0;
+            }
+            fprintf(stderr, "dengamma value %f\n", denavlogps[i]);
+            objectValue += (ElemType) objectValues[i];
+        }
+        functionValues.SetValue(objectValue);
+    }
+
+    // utterances that share a parallel sequence are concatenated; the one starting at time 'begin' must end where the reader says it does
+    static void CheckNumFramesInLayout(const Microsoft::MSR::CNTK::MBLayout& layout, size_t mapi, size_t begin, size_t T, size_t numframes)
+    {
+        // scan MBLayout for end of utterance
+        size_t mapframenum = SIZE_MAX; // duration of utterance [i] as determined from MBLayout
+        for (size_t t = begin; t < T; t++)
+        {
+            // TODO: Adapt this to new MBLayout, m_sequences would be easier to work off.
+            if (layout.IsEnd(mapi, t))
+            {
+                mapframenum = t - begin + 1;
+                break;
+            }
+        }
+
+        // must match the explicit information we get from the reader
+        if (numframes != mapframenum)
+            LogicError("gammacalculation: IsEnd() not working, numframes (%d) vs. mapframenum (%d)", (int) numframes, (int) mapframenum);
+        assert(numframes == mapframenum);
+    }
+
     // Helper methods for copying between ssematrix objects and CNTK matrices
     void CopyFromCNTKMatrixToSSEMatrix(const Microsoft::MSR::CNTK::Matrix<ElemType>& src, size_t numCols, msra::math::ssematrixbase& dest)
     {
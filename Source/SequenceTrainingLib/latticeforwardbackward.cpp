@@ -15,6 +15,10 @@
 #include <unordered_map>
 #include <list>
 #include <stdexcept>
+#include <exception>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -117,7 +121,7 @@ static void logmax(FLOAT &loga, FLOAT logb) // for testing (max approx)
 }
 
 template <typename FLOAT>
-static FLOAT expdiff(FLOAT a, FLOAT b) // for testing
+static FLOAT expdiff(FLOAT a, FLOAT b) // exp (a) - exp (b)
 {
     if (b > a)
         return exp(b) * (exp(a - b) - 1);
@@ -506,8 +510,22 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
 
         return totalfwscore;
     }
-    // if we get here, we have no CUDA, and do it the good ol' way
+    // if we get here, we have no CUDA; use the native CPU version, which requires the lattice to be topologically sorted
+    double totalscore;
+    if (cpuforwardbackwardlattice(edgeacscores, logpps, logalphas, logbetas, lmf, wp, amf, sMBRmode, uids, thisedgealignments, logEframescorrect, Eframescorrectbuf, logEframescorrecttotal, totalscore))
+        return totalscore;
+
+    // otherwise do it the good ol' way
+    return edgeserialforwardbackwardlattice(edgeacscores, logpps, logalphas, logbetas, lmf, wp, amf, sMBRmode, uids, thisedgealignments, logEframescorrect, Eframescorrectbuf, logEframescorrecttotal);
+}
 
+// edge-serial version of forwardbackwardlattice(), which accumulates into the nodes with one logadd() per edge
+double lattice::edgeserialforwardbackwardlattice(const std::vector<float> &edgeacscores, std::vector<double> &logpps,
+                                                 std::vector<double> &logalphas, std::vector<double> &logbetas,
+                                                 const float lmf, const float wp, const float amf, const bool sMBRmode,
+                                                 const_array_ref<size_t> &uids, const edgealignments &thisedgealignments,
+                                                 std::vector<double> &logEframescorrect, std::vector<double> &Eframescorrectbuf, double &logEframescorrecttotal) const
+{
     // allocate return values
     logpps.resize(edges.size()); // this is our primary return value
 
@@ -587,6 +605,7 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
             double tmplogeframecorrect = logframescorrectedge[j];
             logadd(tmplogeframecorrect, logaccalphas[e.S]);
             logadd(tmplogeframecorrect, logaccbetas[e.E] - logbetas[e.E]);
+            logEframescorrect[j] = tmplogeframecorrect;
             Eframescorrectbuf[j] = exp(tmplogeframecorrect);
         }
         foreach_index (j, logaccbetas)
@@ -647,6 +666,272 @@ double lattice::forwardbackwardlattice(const std::vector<float> &edgeacscores, p
     return totalfwscore;
 }
 
+// ---------------------------------------------------------------------------
+// cpuforwardbackwardlattice() -- native CPU version of forwardbackwardlattice()
+//
+// The version above accumulates into a node with one logadd() per edge, which
+// is a long chain of dependent exp/log calls. Since edges are sorted by end
+// node, and each edge starts at a lower node than it ends, a node's alpha can
+// instead be computed at once, as a log-sum-exp over the path scores of its
+// incoming edges, which are contiguous. For the backward pass, edges are
+// grouped by start node once (counting sort). Topology and per-edge scores
+// are kept in separate arrays, so the per-edge loops stream through memory
+// and the log-sum-exp reductions are done with SIMD instructions.
+// ---------------------------------------------------------------------------
+
+#ifdef __AVX2__
+// exp() of 4 doubles <= 0, with a relative error of about 1e-15
+static inline __m256d exp4(__m256d x)
+{
+    x = _mm256_max_pd(x, _mm256_set1_pd(-708.0)); // exp(-708) is near the smallest normalized double, which is as good as 0 here
+    // x = n log 2 + r with |r| <= log(2) / 2; log 2 is split into two parts for precision
+    const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(6.93145751953125e-1)));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(1.42860682030941723212e-6)));
+    // exp(r) by its Taylor series up to r^12
+    static const double invfactorials[] = {1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880, 1.0 / 40320, 1.0 / 5040, 1.0 / 720,
+                                           1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2, 1.0, 1.0};
+    __m256d p = _mm256_set1_pd(1.0 / 479001600);
+    for (double c : invfactorials)
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(c));
+    // times 2^n, constructed in the exponent bits
+    const __m256i pow2n = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(pow2n));
+}
+#endif
+
+// log (sum_k exp (x[k])) -- same as logadd() over all x[k], but without the dependency chain
+static double logsumexp(const double *x, size_t n)
+{
+    const double logzero = LOGZERO;
+    double maxx = logzero;
+    size_t k = 0;
+#ifdef __AVX2__
+    if (n >= 4)
+    {
+        __m256d max4 = _mm256_set1_pd(logzero);
+        for (; k + 4 <= n; k += 4)
+            max4 = _mm256_max_pd(max4, _mm256_loadu_pd(x + k));
+        double lanes[4];
+        _mm256_storeu_pd(lanes, max4);
+        maxx = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+    }
+#endif
+    for (; k < n; k++)
+        maxx = max(maxx, x[k]);
+    if (maxx <= logzero) // all are 0
+        return logzero;
+
+    double sum = 0.0;
+    k = 0;
+#ifdef __AVX2__
+    if (n >= 4)
+    {
+        const __m256d max4 = _mm256_set1_pd(maxx);
+        __m256d sum4 = _mm256_setzero_pd();
+        for (; k + 4 <= n; k += 4)
+            sum4 = _mm256_add_pd(sum4, exp4(_mm256_sub_pd(_mm256_loadu_pd(x + k), max4)));
+        double lanes[4];
+        _mm256_storeu_pd(lanes, sum4);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#endif
+    for (; k < n; k++)
+        sum += exp(x[k] - maxx);
+    return maxx + log(sum);
+}
+
+// lattice topology in structure-of-arrays layout, with edges grouped by end node (lattice order) and by start node
+struct latticetopology
+{
+    std::vector<unsigned int> S, E;         // [j] start and end node of edge j
+    std::vector<unsigned int> firstinedge;  // [i] incoming edges of node i are [firstinedge[i], firstinedge[i+1])
+    std::vector<unsigned int> firstoutedge; // [i] outgoing edges of node i are outedges[firstoutedge[i]], ..., outedges[firstoutedge[i+1]-1]
+    std::vector<unsigned int> outedges;     // edge indices grouped by start node
+
+    // returns false if edges are not sorted by end node, or not topologically (S < E)
+    bool init(const std::vector<nodeinfo> &nodes, const std::vector<edgeinfowithscores> &edges)
+    {
+        const size_t numnodes = nodes.size();
+        const size_t numedges = edges.size();
+        S.resize(numedges);
+        E.resize(numedges);
+        firstinedge.assign(numnodes + 1, 0);
+        firstoutedge.assign(numnodes + 1, 0);
+        for (size_t j = 0; j < numedges; j++)
+        {
+            S[j] = (unsigned int) edges[j].S;
+            E[j] = (unsigned int) edges[j].E;
+            if (S[j] >= E[j] || E[j] >= numnodes || (j > 0 && E[j] < E[j - 1]))
+                return false;
+            firstinedge[E[j] + 1]++;
+            firstoutedge[S[j] + 1]++;
+        }
+        for (size_t i = 0; i < numnodes; i++)
+        {
+            firstinedge[i + 1] += firstinedge[i];
+            firstoutedge[i + 1] += firstoutedge[i];
+        }
+        outedges.resize(numedges);
+        std::vector<unsigned int> next(firstoutedge.begin(), firstoutedge.end() - 1);
+        for (size_t j = 0; j < numedges; j++)
+            outedges[next[S[j]]++] = (unsigned int) j;
+        return true;
+    }
+};
+
+bool lattice::cpuforwardbackwardlattice(const std::vector<float> &edgeacscores, std::vector<double> &logpps,
+                                        std::vector<double> &logalphas, std::vector<double> &logbetas,
+                                        const float lmf, const float wp, const float amf, const bool sMBRmode,
+                                        const_array_ref<size_t> &uids, const edgealignments &thisedgealignments,
+                                        std::vector<double> &logEframescorrect, std::vector<double> &Eframescorrectbuf,
+                                        double &logEframescorrecttotal, double &totalscore) const
+{
+    latticetopology topology;
+    if (!topology.init(nodes, edges))
+        return false;
+    const auto &S = topology.S;
+    const auto &E = topology.E;
+    const size_t numnodes = nodes.size();
+    const size_t numedges = edges.size();
+
+    // per-edge scores, and in sMBR mode the raw counts of correct frames in each edge
+    // Pruned edges (LOGZERO ac. score) are left out of sMBR, like in the edge-serial version.
+    std::vector<double> edgescores(numedges);
+    foreach_index (j, edges)
+        edgescores[j] = (edges[j].l * lmf + wp + edgeacscores[j]) / amf; // note: edgeacscores[j] == LOGZERO if edge was pruned
+    std::vector<double> logframescorrectedge;
+    if (sMBRmode)
+    {
+        logframescorrectedge.assign(numedges, LOGZERO);
+        foreach_index (j, edges)
+        {
+            if (islogzero(edgeacscores[j]))
+            {
+                edgescores[j] = LOGZERO;
+                continue;
+            }
+            const size_t ts = nodes[S[j]].t;
+            const size_t te = nodes[E[j]].t;
+            const auto edgealignment = thisedgealignments[j];
+            size_t framescorrect = 0;
+            for (size_t t = ts; t < te; t++)
+                framescorrect += (edgealignment[t - ts] == uids[t]);
+            if (framescorrect > 0)
+                logframescorrectedge[j] = log((double) framescorrect);
+        }
+    }
+
+    std::vector<double> pathscores(numedges); // scratch for the path scores into/out of one node
+    std::vector<double> pathaccs(sMBRmode ? numedges : 0);
+    std::vector<double> logaccalphas(sMBRmode ? numnodes : 0, LOGZERO); // [i] expected frames-correct count over all paths from start to node i (not normalized until the end)
+    std::vector<double> logaccbetas(sMBRmode ? numnodes : 0, LOGZERO);  // [i] likewise
+
+    // forward pass
+    logalphas.assign(numnodes, LOGZERO);
+    logalphas.front() = 0.0f;
+    for (size_t i = 1; i < numnodes; i++)
+    {
+        const size_t jb = topology.firstinedge[i];
+        const size_t je = topology.firstinedge[i + 1];
+        for (size_t j = jb; j < je; j++)
+            pathscores[j - jb] = logalphas[S[j]] + edgescores[j];
+        logalphas[i] = logsumexp(pathscores.data(), je - jb);
+        if (sMBRmode)
+        {
+            for (size_t j = jb; j < je; j++)
+            {
+                double loginaccs = logaccalphas[S[j]] - logalphas[S[j]];
+                logadd(loginaccs, logframescorrectedge[j]);
+                pathaccs[j - jb] = loginaccs + pathscores[j - jb];
+            }
+            logaccalphas[i] = logsumexp(pathaccs.data(), je - jb);
+        }
+    }
+    const double totalfwscore = logalphas.back();
+    if (islogzero(totalfwscore))
+    {
+        fprintf(stderr, "forwardbackward: WARNING: no path found in lattice (%d nodes/%d edges)\n", (int) nodes.size(), (int) edges.size());
+        totalscore = LOGZERO; // failed, do not use resulting matrix
+        return true;
+    }
+
+    // backward pass
+    logbetas.assign(numnodes, LOGZERO);
+    logbetas.back() = 0.0f;
+    for (size_t i = numnodes - 1; i-- > 0;)
+    {
+        const size_t kb = topology.firstoutedge[i];
+        const size_t ke = topology.firstoutedge[i + 1];
+        for (size_t k = kb; k < ke; k++)
+        {
+            const size_t j = topology.outedges[k];
+            pathscores[k - kb] = logbetas[E[j]] + edgescores[j];
+        }
+        logbetas[i] = logsumexp(pathscores.data(), ke - kb);
+        if (sMBRmode)
+        {
+            for (size_t k = kb; k < ke; k++)
+            {
+                const size_t j = topology.outedges[k];
+                double loginaccs = logaccbetas[E[j]] - logbetas[E[j]];
+                logadd(loginaccs, logframescorrectedge[j]);
+                pathaccs[k - kb] = loginaccs + pathscores[k - kb];
+            }
+            logaccbetas[i] = logsumexp(pathaccs.data(), ke - kb);
+        }
+    }
+    const double totalbwscore = logbetas.front();
+    if (fabs(totalfwscore - totalbwscore) / info.numframes > 1e-4)
+        fprintf(stderr, "forwardbackward: WARNING: lattice fw and bw scores %.10f vs. %.10f (%d nodes/%d edges)\n", (float) totalfwscore, (float) totalbwscore, (int) nodes.size(), (int) edges.size());
+
+    // edge posteriors, and in sMBR mode the expected frames-correct count per edge (since we assume hard state alignment)
+    logpps.resize(numedges);
+    if (sMBRmode)
+    {
+        logEframescorrect.resize(numedges);
+        Eframescorrectbuf.resize(numedges);
+    }
+    foreach_index (j, edges)
+    {
+        if (sMBRmode && islogzero(edgeacscores[j])) // pruned
+        {
+            logpps[j] = LOGZERO;
+            logEframescorrect[j] = LOGZERO;
+            Eframescorrectbuf[j] = 0.0;
+            continue;
+        }
+        double logpp = logalphas[S[j]] + edgescores[j] + logbetas[E[j]] - totalfwscore;
+        if (logpp > 1e-2)
+            fprintf(stderr, "forwardbackward: WARNING: edge J=%d log posterior %.10f > 0\n", (int) j, (float) logpp);
+        if (logpp > 0.0)
+            logpp = 0.0;
+        logpps[j] = logpp;
+        if (sMBRmode)
+        {
+            double logsum = logframescorrectedge[j]; // sum over this edge, left partial (alpha), right partial (beta)
+            logadd(logsum, logaccalphas[S[j]] - logalphas[S[j]]);
+            logadd(logsum, logaccbetas[E[j]] - logbetas[E[j]]);
+            logEframescorrect[j] = logsum;
+            Eframescorrectbuf[j] = exp(logsum);
+        }
+    }
+
+    if (!sMBRmode)
+    {
+        totalscore = totalfwscore;
+        return true;
+    }
+
+    const double totalfwacc = logaccalphas.back() - logalphas.back();
+    const double totalbwacc = logaccbetas.front() - logbetas.front();
+    if (fabs(totalfwacc - totalbwacc) / info.numframes > 1e-4)
+        fprintf(stderr, "forwardbackwardlatticesMBR: WARNING: lattice fw and bw accs %.10f vs. %.10f (%d nodes/%d edges)\n", (float) totalfwacc, (float) totalbwacc, (int) nodes.size(), (int) edges.size());
+    logEframescorrecttotal = totalbwacc;
+    totalscore = totalbwscore;
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // forwardbackwardlatticesMBR() -- compute expected frame-accuracy counts,
 // both the conditioned one (corresponding to c(q) in Dan Povey's thesis)
@@ -952,50 +1237,66 @@ void lattice::forwardbackwardalign(parallelstate &parallelstate,
             parallelstate.getedgeacscores(edgeacscoresgpu);
             parallelstate.copyalignments(thisedgealignmentsgpu);
         }
-        foreach_index (j, edges)
+        // edges are independent, so we process them in parallel; allocate the alignment buffer up front, as operator[] would do it lazily
+        thisedgealignments.getalignmentsbuffer();
+        // an exception must not escape the parallel region, so the first one is passed on after the loop
+        std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic, 16) if (!cpuverification)
+        for (int j = 0; j < (int) edges.size(); j++)
         {
-            const edgeinfowithscores &e = edges[j];
-            const size_t ts = nodes[e.S].t;
-            const size_t te = nodes[e.E].t;
-            if (ts == te) // dummy !NULL edge at end
-                edgeacscores[j] = 0.0f;
-            else
+            try
             {
-                const auto &aligntokens = getaligninfo(j); // get alignment tokens
-                const auto edgeLLs = msra::math::ssematrixstriperef<msra::math::ssematrixbase>(const_cast<msra::math::ssematrixbase &>(logLLs), ts, te - ts);
-                if (minlogpp > LOGZERO && origlogpps[j] < minlogpp)
-                    edgeacscores[j] = LOGZERO; // will kill word level forwardbackward hypothesis
-                else if (softalignstates)
-                    edgeacscores[j] = forwardbackwardedge(aligntokens, hset, edgeLLs, *abcs[j], j);
+                const edgeinfowithscores &e = edges[j];
+                const size_t ts = nodes[e.S].t;
+                const size_t te = nodes[e.E].t;
+                if (ts == te) // dummy !NULL edge at end
+                    edgeacscores[j] = 0.0f;
                 else
-                    edgeacscores[j] = alignedge(aligntokens, hset, edgeLLs, *abcs[j], j, returnsenoneids, thisedgealignments[j]);
-            }
-            if (cpuverification)
-            {
-                const auto &aligntokens = getaligninfo(j); // get alignment tokens
-                bool edgehassil = false;
-                foreach_index (i, aligntokens)
                 {
-                    if (aligntokens[i].unit == silunitid)
-                        edgehassil = true;
+                    const auto &aligntokens = getaligninfo(j); // get alignment tokens
+                    const auto edgeLLs = msra::math::ssematrixstriperef<msra::math::ssematrixbase>(const_cast<msra::math::ssematrixbase &>(logLLs), ts, te - ts);
+                    if (minlogpp > LOGZERO && origlogpps[j] < minlogpp)
+                        edgeacscores[j] = LOGZERO; // will kill word level forwardbackward hypothesis
+                    else if (softalignstates)
+                        edgeacscores[j] = forwardbackwardedge(aligntokens, hset, edgeLLs, *abcs[j], j);
+                    else
+                        edgeacscores[j] = alignedge(aligntokens, hset, edgeLLs, *abcs[j], j, returnsenoneids, thisedgealignments[j]);
                 }
-                if (fabs(edgeacscores[j] - edgeacscoresgpu[j]) > 1e-3)
+                if (cpuverification)
                 {
-                    fprintf(stderr, "edge %d, sil ? %d, edgeacscores / edgeacscoresgpu MISMATCH %f v.s. %f, diff %e\n",
-                            j, edgehassil ? 1 : 0, (float) edgeacscores[j], (float) edgeacscoresgpu[j],
-                            (float) (edgeacscores[j] - edgeacscoresgpu[j]));
-                    fprintf(stderr, "aligntokens: ");
+                    const auto &aligntokens = getaligninfo(j); // get alignment tokens
+                    bool edgehassil = false;
                     foreach_index (i, aligntokens)
-                        fprintf(stderr, "%d %d; ", i, aligntokens[i].unit);
-                    fprintf(stderr, "\n");
-                }
-                for (size_t t = ts; t < te; t++)
-                {
-                    if (thisedgealignments[j][t - ts] != thisedgealignmentsgpu[j][t - ts])
-                        fprintf(stderr, "edge %d, sil ? %d, time %d, alignment / alignmentgpu MISMATCH %d v.s. %d\n", j, edgehassil ? 1 : 0, (int) (t - ts), thisedgealignments[j][t - ts], thisedgealignmentsgpu[j][t - ts]);
+                    {
+                        if (aligntokens[i].unit == silunitid)
+                            edgehassil = true;
+                    }
+                    if (fabs(edgeacscores[j] - edgeacscoresgpu[j]) > 1e-3)
+                    {
+                        fprintf(stderr, "edge %d, sil ? %d, edgeacscores / edgeacscoresgpu MISMATCH %f v.s. %f, diff %e\n",
+                                j, edgehassil ? 1 : 0, (float) edgeacscores[j], (float) edgeacscoresgpu[j],
+                                (float) (edgeacscores[j] - edgeacscoresgpu[j]));
+                        fprintf(stderr, "aligntokens: ");
+                        foreach_index (i, aligntokens)
+                            fprintf(stderr, "%d %d; ", i, aligntokens[i].unit);
+                        fprintf(stderr, "\n");
+                    }
+                    for (size_t t = ts; t < te; t++)
+                    {
+                        if (thisedgealignments[j][t - ts] != thisedgealignmentsgpu[j][t - ts])
+                            fprintf(stderr, "edge %d, sil ? %d, time %d, alignment / alignmentgpu MISMATCH %d v.s. %d\n", j, edgehassil ? 1 : 0, (int) (t - ts), thisedgealignments[j][t - ts], thisedgealignmentsgpu[j][t - ts]);
+                    }
                 }
             }
+            catch (...)
+            {
+#pragma omp critical
+                if (!error)
+                    error = std::current_exception();
+            }
         }
+        if (error)
+            std::rethrow_exception(error);
     }
 }
 
@@ -1030,7 +1331,7 @@ void lattice::sMBRerrorsignal(parallelstate &parallelstate,
         size_t ts = nodes[e.S].t;
         size_t te = nodes[e.E].t;
 
-        const double diff = logEframescorrect[j] - logEframescorrecttotal;
+        const double diff = expdiff(logEframescorrect[j], logEframescorrecttotal);
         // Note: the contribution of the states of an edge to their senones is the same for all states
         // so we compute it once and add it to all; this will not be the case without hard alignments.
         const double pp = exp(logpps[j]); // edge posterior
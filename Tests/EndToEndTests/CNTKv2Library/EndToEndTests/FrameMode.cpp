@@ -111,6 +111,7 @@ void TestFrameMode()
     // Create a set of trainers.
     std::map<std::wstring, std::function<DistributedLearnerPtr(LearnerPtr)>> learners;
     learners[L"simple"] = [](LearnerPtr l) { return CreateDataParallelDistributedLearner(MPICommunicator(), l, 0); };
+    learners[L"hierarchical"] = [](LearnerPtr l) { return CreateDataParallelDistributedLearner(HierarchicalMPICommunicator(Internal::GetMPIPackThreshold(), /*ranksPerNode=*/1), l, 0); };
 
     learners[L"gpu"] = [](LearnerPtr l) { return CreateQuantizedDataParallelDistributedLearner(QuantizedMPICommunicator(true, true, 32), l, 0); };
     learners[L"blockmomentum"] = [](LearnerPtr l) { return CreateBlockMomentumDistributedLearner(MPICommunicator(), l, 0, 1024); };
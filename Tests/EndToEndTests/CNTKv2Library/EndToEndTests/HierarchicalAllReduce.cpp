@@ -0,0 +1,96 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+
+#define _CRT_SECURE_NO_WARNINGS // "secure" CRT not available on all platforms  --add this at the top of all CPP files that give "function or variable may be unsafe" warnings
+
+#include "CNTKLibrary.h"
+#include "Common.h"
+
+using namespace CNTK;
+using namespace std;
+
+namespace
+{
+    // Small integers, so that the sums are exact whatever the order the workers' values are added in.
+    template <typename ElementType>
+    ElementType TestValue(size_t worker, size_t valueIndex, size_t element)
+    {
+        return (ElementType)((int)((worker + 1) * ((element + valueIndex) % 13)) - 6);
+    }
+
+    template <typename ElementType>
+    void TestAggregation(const DistributedCommunicatorPtr& communicator, const DeviceDescriptor& device, bool inPlace, const std::string& description)
+    {
+        // Values below the pack threshold, and values larger than the chunks of the shared memory reduction
+        const std::vector<NDShape> shapes = { { 3 }, { 10, 7 }, { 1 << 18 }, { 513, 1031 }, { 1 } };
+
+        const size_t numWorkers = communicator->Workers().size();
+        const size_t worker = communicator->CurrentWorker().m_globalRank;
+
+        std::vector<NDArrayViewPtr> values;
+        for (size_t i = 0; i < shapes.size(); i++)
+        {
+            std::vector<ElementType> data(shapes[i].TotalSize());
+            for (size_t k = 0; k < data.size(); k++)
+                data[k] = TestValue<ElementType>(worker, i, k);
+            values.push_back(MakeSharedObject<NDArrayView>(shapes[i], data)->DeepClone(device));
+        }
+
+        std::vector<NDArrayViewPtr> aggregates;
+        if (inPlace)
+        {
+            communicator->AggregateInPlace(values, communicator->Workers());
+            aggregates = values;
+        }
+        else
+            communicator->Aggregate(values, aggregates, communicator->Workers());
+
+        for (size_t i = 0; i < shapes.size(); i++)
+        {
+            auto aggregate = aggregates[i]->DeepClone(DeviceDescriptor::CPUDevice());
+            const ElementType* data = aggregate->DataBuffer<ElementType>();
+            for (size_t k = 0; k < shapes[i].TotalSize(); k++)
+            {
+                ElementType expected = 0;
+                for (size_t w = 0; w < numWorkers; w++)
+                    expected += TestValue<ElementType>(w, i, k);
+                if (data[k] != expected)
+                    ReportFailure("%s: element %d of value %d is %g after aggregation, but should be %g.", description.c_str(), (int)k, (int)i, (double)data[k], (double)expected);
+            }
+        }
+    }
+}
+
+void TestHierarchicalAllReduce()
+{
+    std::vector<DeviceDescriptor> devices;
+    if (ShouldRunOnCpu())
+        devices.push_back(DeviceDescriptor::CPUDevice());
+    if (ShouldRunOnGpu())
+        devices.push_back(DeviceDescriptor::GPUDevice(0));
+
+    auto sync = MPICommunicator();
+    const size_t numWorkers = sync->Workers().size();
+
+    // Nodes by host name, and then every way of simulating nodes with blocks of consecutive ranks: one worker per node
+    // (ring only), one node for all workers (shared memory only), and several workers on several nodes, not all of the same size.
+    for (size_t ranksPerNode = 0; ranksPerNode <= numWorkers; ranksPerNode++)
+    {
+        auto communicator = HierarchicalMPICommunicator(Internal::GetMPIPackThreshold(), ranksPerNode);
+        for (auto device : devices)
+        {
+            for (bool inPlace : { true, false })
+            {
+                std::string description = "ranksPerNode=" + std::to_string(ranksPerNode) + (inPlace ? ", in place" : ", out of place") + (device.Type() == DeviceKind::CPU ? ", CPU" : ", GPU");
+                sync->Barrier();
+                TestAggregation<float>(communicator, device, inPlace, description + ", float");
+                TestAggregation<double>(communicator, device, inPlace, description + ", double");
+            }
+        }
+    }
+    sync->Barrier();
+
+    printf("Aggregated with hierarchical all-reduce on %d workers.\n", (int)numWorkers);
+}
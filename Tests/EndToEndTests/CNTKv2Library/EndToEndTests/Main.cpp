@@ -22,6 +22,7 @@ void TrainSequenceToSequenceTranslator();
 void TrainTruncatedLSTMAcousticModelClassifier();
 void TestFrameMode();
 void TestDistributedCheckpointing();
+void TestHierarchicalAllReduce();
 
 int main(int argc, char *argv[])
 {
@@ -45,7 +46,8 @@ int main(int argc, char *argv[])
 
     if (argc > 2)
     {
-        if (argc == 3 && !std::string(argv[1]).compare("Distribution")) {
+        std::string testName(argv[1]);
+        if (argc == 3 && (!testName.compare("Distribution") || !testName.compare("HierarchicalAllReduce"))) {
             {
                 auto communicator = MPICommunicator();
                 std::string logFilename = argv[2] + std::to_string(communicator->CurrentWorker().m_globalRank);
@@ -57,11 +59,18 @@ int main(int argc, char *argv[])
                 }
             }
 
-            TestFrameMode();
+            if (!testName.compare("Distribution"))
+            {
+                TestFrameMode();
 
-            TestDistributedCheckpointing();
+                TestDistributedCheckpointing();
+            }
+            else
+            {
+                TestHierarchicalAllReduce();
+            }
 
-            std::string testsPassedMsg = "\nCNTKv2Library-Distribution tests: Passed\n";
+            std::string testsPassedMsg = "\nCNTKv2Library-" + testName + " tests: Passed\n";
 
             printf("%s", testsPassedMsg.c_str());
 
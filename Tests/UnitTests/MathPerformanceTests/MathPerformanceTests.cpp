@@ -156,6 +156,134 @@ void SquareMultiplyAndAdd10TimesAvgTest(int n, int count)
     cout << "CPUMatrix/Matrix ratio is: " << cpu_avg / m_avg << " seconds" << endl;
 }
 
+// time a reduction of a [rows x cols] matrix over its rows (contiguous) or columns (strided),
+// with the serial tensor reduction code and with the parallel/vectorized one (CPUMatrix::OPT_PARALLEL_REDUCTION)
+template <class ElemType>
+void ReductionPerformanceTest(size_t rows, size_t cols, bool overRows, ElementWiseOperator reductionOp, int count)
+{
+    CPUMatrix<ElemType> A(rows, cols);
+    randomInitializeCPUMatrix<ElemType>(A);
+    CPUMatrix<ElemType> C = overRows ? CPUMatrix<ElemType>(1, cols) : CPUMatrix<ElemType>(rows, 1);
+
+    const array<size_t, 2> offsets = { 0, 0 };
+    SmallVector<size_t> regularOpDims({ overRows ? cols : rows });
+    array<SmallVector<ptrdiff_t>, 2> regularStrides = { SmallVector<ptrdiff_t>({ overRows ? (ptrdiff_t)rows : 1 }), SmallVector<ptrdiff_t>({ 1 }) };
+    SmallVector<size_t> reducingOpDims({ overRows ? rows : cols });
+    array<SmallVector<ptrdiff_t>, 2> reducingStrides = { SmallVector<ptrdiff_t>({ overRows ? 1 : (ptrdiff_t)rows }), SmallVector<ptrdiff_t>({ 0 }) };
+    bool isArgOp = reductionOp == ElementWiseOperator::opArgmax || reductionOp == ElementWiseOperator::opArgmin;
+
+    int flags = CPUMatrix<ElemType>::GetOptimizationFlags();
+    double seconds[2];
+    for (int parallel = 0; parallel < 2; parallel++)
+    {
+        CPUMatrix<ElemType>::SetOptimizationFlags(parallel ? (flags | CPUMatrix<ElemType>::OPT_PARALLEL_REDUCTION) : (flags & ~CPUMatrix<ElemType>::OPT_PARALLEL_REDUCTION));
+        auto t_start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            if (isArgOp)
+                C.TensorArgOp(A, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+            else
+                C.TensorOp(0, A, 1, ElementWiseOperator::opCopy, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+        }
+        auto t_end = chrono::high_resolution_clock::now();
+        seconds[parallel] = chrono::duration<double>(t_end - t_start).count() / count;
+    }
+    CPUMatrix<ElemType>::SetOptimizationFlags(flags);
+
+    cout << "Reduction op " << (int)reductionOp << " of A(" << rows << "x" << cols << ") over " << (overRows ? "rows" : "columns") << ": "
+         << "serial " << seconds[0] * 1000 << " ms, parallel " << seconds[1] * 1000 << " ms, speed-up " << seconds[0] / seconds[1] << endl;
+}
+
+// int8 evaluation of W * X, with W quantized once and X quantized on every call, against the fp32 product
+template <class ElemType>
+void Int8MultiplyPerformanceTest(size_t m, size_t k, size_t n, int count)
+{
+    CPUMatrix<ElemType> W(m, k), X(k, n), C(m, n), C8(m, n);
+    randomInitializeCPUMatrix<ElemType>(W);
+    randomInitializeCPUMatrix<ElemType>(X);
+    auto pQuantizedMultiplier = make_shared<Int8QuantizedMultiplier<ElemType>>(/*isAConstant=*/true, /*isBConstant=*/false);
+
+    double seconds[2];
+    for (int int8 = 0; int8 < 2; int8++)
+    {
+        auto t_start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            if (int8)
+                CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, false, X, false, 0, C8, pQuantizedMultiplier);
+            else
+                CPUMatrix<ElemType>::MultiplyAndWeightedAdd(1, W, false, X, false, 0, C);
+        }
+        auto t_end = chrono::high_resolution_clock::now();
+        seconds[int8] = chrono::duration<double>(t_end - t_start).count() / count;
+    }
+
+    double maxError = 0, maxValue = 0;
+    for (size_t i = 0; i < C.GetNumElements(); i++)
+    {
+        maxError = max(maxError, (double)fabs(C.Data()[i] - C8.Data()[i]));
+        maxValue = max(maxValue, (double)fabs(C.Data()[i]));
+    }
+
+    cout << "W(" << m << "x" << k << ") * X(" << k << "x" << n << "): fp32 " << seconds[0] * 1000 << " ms, int8 (" << Int8MultiplyKernelName() << ") "
+         << seconds[1] * 1000 << " ms, speed-up " << seconds[0] / seconds[1] << ", max error " << maxError / maxValue << " of max |result|" << endl;
+}
+
+// time CTC (CPUMatrix::AssignCTCScore) of a minibatch of 'numUtterances' utterances, one per channel, each of 'numFrames' frames
+// and 'numLabels' labels out of 'numClasses' (including blank), with the serial code and with the parallel one (CPUMatrix::OPT_PARALLEL_CTC)
+template <class ElemType>
+void CTCPerformanceTest(size_t numUtterances, size_t numFrames, size_t numLabels, size_t numClasses, int count)
+{
+    const size_t blankTokenId = numClasses - 1;
+    const size_t numPhones = 2 * numLabels + 3;
+    CPUMatrix<ElemType> prob(numClasses, numFrames * numUtterances);
+    randomInitializeCPUMatrix<ElemType>(prob, -20, 20); // log posteriors in [-20, 0)
+
+    CPUMatrix<ElemType> phoneSeq(numPhones, numUtterances), phoneBound(numPhones, numUtterances);
+    vector<size_t> uttToChanInd, uttBeginFrame, uttFrameNum, uttPhoneNum;
+    for (size_t u = 0; u < numUtterances; u++)
+    {
+        phoneSeq(0, u) = (ElemType) SIZE_MAX;
+        phoneBound(0, u) = 0;
+        for (size_t k = 0; k < numLabels; k++)
+        {
+            phoneSeq(2 * k + 1, u) = (ElemType) blankTokenId;
+            phoneSeq(2 * k + 2, u) = (ElemType) (rand() % blankTokenId);
+            phoneBound(2 * k + 1, u) = phoneBound(2 * k + 2, u) = (ElemType) ((k + 1) * numFrames / (numLabels + 1));
+        }
+        phoneSeq(numPhones - 2, u) = (ElemType) blankTokenId;
+        phoneSeq(numPhones - 1, u) = (ElemType) SIZE_MAX;
+        phoneBound(numPhones - 2, u) = phoneBound(numPhones - 1, u) = (ElemType) numFrames;
+        uttToChanInd.push_back(u);
+        uttBeginFrame.push_back(0);
+        uttFrameNum.push_back(numFrames);
+        uttPhoneNum.push_back(numPhones);
+    }
+
+    CPUMatrix<ElemType> posteriors(numClasses, prob.GetNumCols()), alpha(numPhones, prob.GetNumCols()), beta(numPhones, prob.GetNumCols()), totalScore(1, 1);
+    int flags = CPUMatrix<ElemType>::GetOptimizationFlags();
+    double seconds[2];
+    for (int parallel = 0; parallel < 2; parallel++)
+    {
+        CPUMatrix<ElemType>::SetOptimizationFlags(parallel ? (flags | CPUMatrix<ElemType>::OPT_PARALLEL_CTC) : (flags & ~CPUMatrix<ElemType>::OPT_PARALLEL_CTC));
+        auto t_start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            alpha.SetValue((ElemType) LZERO);
+            beta.SetValue((ElemType) LZERO);
+            posteriors.SetValue((ElemType) LZERO);
+            posteriors.AssignCTCScore(prob, alpha, beta, phoneSeq, phoneBound, totalScore, uttToChanInd, uttBeginFrame, uttFrameNum, uttPhoneNum,
+                                      numUtterances, numFrames, blankTokenId, /*delayConstraint=*/-1, /*isColWise=*/true);
+        }
+        auto t_end = chrono::high_resolution_clock::now();
+        seconds[parallel] = chrono::duration<double>(t_end - t_start).count() / count;
+    }
+    CPUMatrix<ElemType>::SetOptimizationFlags(flags);
+
+    cout << "CTC of " << numUtterances << " utterances of " << numFrames << " frames, " << numLabels << " labels out of " << numClasses << ": "
+         << "serial " << seconds[0] * 1000 << " ms, parallel " << seconds[1] * 1000 << " ms, speed-up " << seconds[0] / seconds[1] << endl;
+}
+
 // simple test suite for TensorView
 //  - this is meant for performance optimization
 //  - correctness is defined as same result between GPU and CPU
@@ -340,6 +468,25 @@ int wmain()
 {
     // MandSTest<float>(100, 2);
 
+    cout << endl << "********************CPU tensor reduction TEST********************" << endl;
+    for (auto reductionOp : { ElementWiseOperator::opSum, ElementWiseOperator::opMax, ElementWiseOperator::opLogSum, ElementWiseOperator::opArgmax })
+    {
+        ReductionPerformanceTest<float>(1000, 4096, /*overRows=*/true, reductionOp, 20);  // e.g. softmax normalizer over a 1000-class output
+        ReductionPerformanceTest<float>(1024, 4096, /*overRows=*/false, reductionOp, 20); // e.g. bias gradient
+        ReductionPerformanceTest<float>(4096 * 1024, 1, /*overRows=*/true, reductionOp, 20); // reduction to a scalar
+    }
+
+    cout << endl << "********************CPU int8 vs. fp32 product TEST********************" << endl;
+    Int8MultiplyPerformanceTest<float>(512, 512, 1, 200);      // single-sample dense layer
+    Int8MultiplyPerformanceTest<float>(2048, 512, 32, 50);     // LSTM gates of a 512-cell layer, 32 sequences
+    Int8MultiplyPerformanceTest<float>(1024, 1024, 256, 10);   // dense layer, large minibatch
+    Int8MultiplyPerformanceTest<float>(64, 576, 3136, 10);     // 3x3x64 convolution on 56x56, unrolled
+
+    cout << endl << "********************CPU CTC TEST********************" << endl;
+    CTCPerformanceTest<float>(16, 500, 60, 30, 5);    // character CTC, 5 s utterances
+    CTCPerformanceTest<float>(32, 300, 100, 5000, 2); // word piece CTC
+    CTCPerformanceTest<float>(1, 2000, 400, 100, 5);  // a single long utterance
+
     /*cout<<endl<<"********************Matrix SquareMultiplyAndWeightedAdd10TimesAvg TEST********************"<<endl;
     SquareMultiplyAndAdd10TimesAvgTest<float>(4096,10);
 
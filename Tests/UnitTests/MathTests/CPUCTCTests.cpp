@@ -0,0 +1,209 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include <cmath>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../../../Source/Math/CPUMatrix.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// An utterance of a CTC minibatch: its channel, first frame in the channel, number of frames and number of labels.
+struct CTCUtterance
+{
+    size_t channel, beginFrame, numFrames, numLabels;
+};
+
+// The inputs of CPUMatrix::AssignCTCScore(), laid out as by GammaCalculation::doCTC(): the label sequence of every
+// utterance is SIZE_MAX, (blank, label)..., blank, SIZE_MAX, with the boundaries of the labels evenly spread over its frames.
+template <class ElemType>
+struct CTCMinibatch
+{
+    static const size_t numChannels = 3;
+    static const size_t maxFrameNum = 40;
+    static const size_t totalPhoneNum = 10;
+    static const size_t blankTokenId = totalPhoneNum - 1;
+
+    CPUMatrix<ElemType> prob;
+    CPUMatrix<ElemType> phoneSeq;
+    CPUMatrix<ElemType> phoneBound;
+    std::vector<size_t> uttToChanInd, uttBeginFrame, uttFrameNum, uttPhoneNum;
+
+    explicit CTCMinibatch(unsigned long seed)
+    {
+        // utterances of different lengths, some of them after another in the same channel
+        const std::vector<CTCUtterance> utterances = {
+            { 0, 0, 12, 4 }, { 1, 0, 40, 15 }, { 2, 0, 7, 2 }, { 0, 12, 25, 9 }, { 2, 7, 30, 1 }, { 0, 37, 3, 1 },
+        };
+
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> logit(-3, 3);
+        std::uniform_int_distribution<size_t> label(0, blankTokenId - 1);
+
+        // log posteriors
+        prob.Resize(totalPhoneNum, maxFrameNum * numChannels);
+        for (size_t j = 0; j < prob.GetNumCols(); j++)
+        {
+            std::vector<double> logits(totalPhoneNum);
+            double sum = 0;
+            for (auto& x : logits)
+            {
+                x = logit(rng);
+                sum += exp(x);
+            }
+            for (size_t i = 0; i < totalPhoneNum; i++)
+                prob(i, j) = (ElemType) (logits[i] - log(sum));
+        }
+
+        std::vector<std::vector<size_t>> seqs, bounds;
+        size_t maxPhoneNum = 0;
+        for (const auto& utt : utterances)
+        {
+            std::vector<size_t> seq = { SIZE_MAX }, bound = { 0 };
+            for (size_t k = 0; k < utt.numLabels; k++)
+            {
+                // labels repeat, so that some transitions from s-2 to s are not allowed
+                size_t phoneId = k > 0 && rng() % 3 == 0 ? seq.back() : label(rng);
+                size_t frame = (k + 1) * utt.numFrames / (utt.numLabels + 1);
+                seq.insert(seq.end(), { blankTokenId, phoneId });
+                bound.insert(bound.end(), { frame, frame });
+            }
+            seq.insert(seq.end(), { blankTokenId, SIZE_MAX });
+            bound.insert(bound.end(), { utt.numFrames, utt.numFrames });
+
+            uttToChanInd.push_back(utt.channel);
+            uttBeginFrame.push_back(utt.beginFrame);
+            uttFrameNum.push_back(utt.numFrames);
+            uttPhoneNum.push_back(seq.size());
+            maxPhoneNum = std::max(maxPhoneNum, seq.size());
+            seqs.push_back(seq);
+            bounds.push_back(bound);
+        }
+
+        phoneSeq.Resize(maxPhoneNum, utterances.size());
+        phoneBound.Resize(maxPhoneNum, utterances.size());
+        phoneSeq.SetValue(0);
+        phoneBound.SetValue(0);
+        for (size_t i = 0; i < utterances.size(); i++)
+        {
+            for (size_t j = 0; j < seqs[i].size(); j++)
+            {
+                phoneSeq(j, i) = (ElemType) seqs[i][j];
+                phoneBound(j, i) = (ElemType) bounds[i][j];
+            }
+        }
+    }
+
+    // CTC posteriors, alpha, beta and the total score, with the parallel CTC code on or off
+    void Compute(bool parallel, int delayConstraint, CPUMatrix<ElemType>& posteriors, CPUMatrix<ElemType>& alpha, CPUMatrix<ElemType>& beta, CPUMatrix<ElemType>& totalScore) const
+    {
+        int flags = CPUMatrix<ElemType>::GetOptimizationFlags();
+        CPUMatrix<ElemType>::SetOptimizationFlags(parallel ? (flags | CPUMatrix<ElemType>::OPT_PARALLEL_CTC) : (flags & ~CPUMatrix<ElemType>::OPT_PARALLEL_CTC));
+
+        // initialized as by Matrix::AssignCTCScore()
+        alpha.Resize(phoneSeq.GetNumRows(), prob.GetNumCols());
+        beta.Resize(phoneSeq.GetNumRows(), prob.GetNumCols());
+        posteriors.Resize(prob.GetNumRows(), prob.GetNumCols());
+        totalScore.Resize(1, 1);
+        alpha.SetValue((ElemType) LZERO);
+        beta.SetValue((ElemType) LZERO);
+        posteriors.SetValue((ElemType) LZERO);
+        posteriors.AssignCTCScore(prob, alpha, beta, phoneSeq, phoneBound, totalScore, uttToChanInd, uttBeginFrame, uttFrameNum, uttPhoneNum,
+                                  numChannels, maxFrameNum, blankTokenId, delayConstraint, /*isColWise=*/true);
+
+        CPUMatrix<ElemType>::SetOptimizationFlags(flags);
+    }
+};
+
+// log scores below LSMALL are all treated as log(0)
+template <class ElemType>
+static void CheckSameLogScores(const CPUMatrix<ElemType>& expected, const CPUMatrix<ElemType>& actual, double relativeTolerance)
+{
+    BOOST_REQUIRE_EQUAL(expected.GetNumElements(), actual.GetNumElements());
+    for (size_t i = 0; i < expected.GetNumElements(); i++)
+    {
+        double e = expected.Data()[i], a = actual.Data()[i];
+        if (e < LSMALL)
+            BOOST_REQUIRE_LT(a, LSMALL);
+        else
+            BOOST_REQUIRE_SMALL(e - a, relativeTolerance * std::max(1.0, std::fabs(e)));
+    }
+}
+
+template <class ElemType>
+static void CheckSame(const CPUMatrix<ElemType>& expected, const CPUMatrix<ElemType>& actual, double tolerance)
+{
+    BOOST_REQUIRE_EQUAL(expected.GetNumElements(), actual.GetNumElements());
+    for (size_t i = 0; i < expected.GetNumElements(); i++)
+    {
+        if (tolerance == 0)
+            BOOST_REQUIRE_EQUAL(expected.Data()[i], actual.Data()[i]);
+        else
+            BOOST_REQUIRE_SMALL((double) expected.Data()[i] - (double) actual.Data()[i], tolerance);
+    }
+}
+
+template <class ElemType>
+static void TestParallelCTCMatchesSerial(double tolerance)
+{
+    for (unsigned long seed : { 1, 2, 3 })
+    {
+        CTCMinibatch<ElemType> mb(seed);
+        for (int delayConstraint : { -1, 3 })
+        {
+            CPUMatrix<ElemType> posteriors, alpha, beta, totalScore;
+            mb.Compute(false, delayConstraint, posteriors, alpha, beta, totalScore);
+            BOOST_REQUIRE_GT(totalScore(0, 0), 0);
+            BOOST_REQUIRE_LT(totalScore(0, 0), -LSMALL);
+
+            CPUMatrix<ElemType> parallelPosteriors, parallelAlpha, parallelBeta, parallelTotalScore;
+            mb.Compute(true, delayConstraint, parallelPosteriors, parallelAlpha, parallelBeta, parallelTotalScore);
+
+            CheckSameLogScores(totalScore, parallelTotalScore, tolerance);
+            CheckSameLogScores(alpha, parallelAlpha, tolerance);
+            CheckSameLogScores(beta, parallelBeta, tolerance);
+            CheckSame(posteriors, parallelPosteriors, tolerance);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(CPUCTCSuite)
+
+BOOST_FIXTURE_TEST_CASE(ParallelCTCMatchesSerialFloat, RandomSeedFixture)
+{
+    TestParallelCTCMatchesSerial<float>(1e-4);
+}
+
+BOOST_FIXTURE_TEST_CASE(ParallelCTCMatchesSerialDouble, RandomSeedFixture)
+{
+    TestParallelCTCMatchesSerial<double>(1e-9);
+}
+
+BOOST_FIXTURE_TEST_CASE(ParallelCTCIsDeterministic, RandomSeedFixture)
+{
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+    CTCMinibatch<float> mb(4);
+    CPUMatrix<float> posteriors, alpha, beta, totalScore;
+    omp_set_num_threads(1);
+    mb.Compute(true, -1, posteriors, alpha, beta, totalScore);
+    for (int numThreads : { 2, 3, 8 })
+    {
+        omp_set_num_threads(numThreads);
+        CPUMatrix<float> otherPosteriors, otherAlpha, otherBeta, otherTotalScore;
+        mb.Compute(true, -1, otherPosteriors, otherAlpha, otherBeta, otherTotalScore);
+        CheckSame(posteriors, otherPosteriors, 0);
+        CheckSame(alpha, otherAlpha, 0);
+        CheckSame(beta, otherBeta, 0);
+        CheckSame(totalScore, otherTotalScore, 0);
+    }
+    omp_set_num_threads(maxThreads);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}}}}
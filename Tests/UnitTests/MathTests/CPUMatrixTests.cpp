@@ -1215,6 +1215,53 @@ BOOST_FIXTURE_TEST_CASE(CPUMatrixGatherFromTarget, RandomSeedFixture)
     BOOST_CHECK(m2.IsEqualTo(expect, 1e-6));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUMatrixHasNanOrInf, RandomSeedFixture)
+{
+    SMatrix s = SMatrix::RandomUniform(17, 33, -100.0f, 100.0f, IncrementCounter());
+    BOOST_CHECK(!s.HasNanOrInf());
+    s(16, 32) = std::numeric_limits<float>::infinity();
+    BOOST_CHECK(s.HasNanOrInf());
+    s(16, 32) = std::numeric_limits<float>::max();
+    BOOST_CHECK(!s.HasNanOrInf());
+    s(3, 5) = std::numeric_limits<float>::quiet_NaN();
+    BOOST_CHECK(s.HasNanOrInf());
+
+    DMatrix d = DMatrix::RandomUniform(17, 33, -100.0, 100.0, IncrementCounter());
+    BOOST_CHECK(!d.HasNanOrInf());
+    d(0, 0) = -std::numeric_limits<double>::infinity();
+    BOOST_CHECK(d.HasNanOrInf());
+
+    // half overflows beyond 65504
+    CPUMatrix<half> h(17, 33);
+    ConvertBuffer(h.Data(), s.Data(), h.GetNumElements());
+    BOOST_CHECK(h.HasNanOrInf());
+    s(3, 5) = 65504.0f;
+    s(16, 32) = -1e-7f;
+    ConvertBuffer(h.Data(), s.Data(), h.GetNumElements());
+    BOOST_CHECK(!h.HasNanOrInf());
+    s(7, 7) = 65520.0f; // rounds to infinity
+    ConvertBuffer(h.Data(), s.Data(), h.GetNumElements());
+    BOOST_CHECK(h.HasNanOrInf());
+}
+
+BOOST_FIXTURE_TEST_CASE(CPUMatrixHalfConvertBuffer, RandomSeedFixture)
+{
+    // the buffer conversions must agree with the conversions of single values, also for the tail after the vectorized part
+    SMatrix s = SMatrix::RandomUniform(13, 7, -70000.0f, 70000.0f, IncrementCounter());
+    s(0, 0) = 1e-6f; // denormal in half
+    s(1, 0) = -0.0f;
+    CPUMatrix<half> h(13, 7);
+    ConvertBuffer(h.Data(), s.Data(), h.GetNumElements());
+    SMatrix back(13, 7);
+    ConvertBuffer(back.Data(), h.Data(), h.GetNumElements());
+    foreach_coord (i, j, s)
+    {
+        half expected = s(i, j);
+        BOOST_CHECK_EQUAL(*(unsigned short*)&expected, *(unsigned short*)&h(i, j));
+        BOOST_CHECK_EQUAL((float)expected, back(i, j));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
 } } }
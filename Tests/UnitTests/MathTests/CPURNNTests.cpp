@@ -0,0 +1,229 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "../../../Source/Math/CPUMatrix.h"
+#include "../../../Source/Math/RNNCommon.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+using DMatrix = CPUMatrix<double>;
+
+// Straightforward per-sequence evaluation of an OptimizedRNNStack in the cuDNN parameter layout,
+// used as the baseline for the packed CPU engine.
+static std::vector<std::vector<double>> ReferenceRNN(const RnnAttributes& attr, size_t inputDim, const std::vector<double>& w,
+                                                     const std::vector<std::vector<double>>& seq /* per sequence: [inputDim x T] */)
+{
+    const size_t H = attr.m_hiddenSize;
+    const size_t D = attr.m_bidirectional ? 2 : 1;
+    const size_t G = attr.m_recurrentOp == L"lstm" ? 4 : attr.m_recurrentOp == L"gru" ? 3 : 1;
+    auto sigmoid = [](double v) { return 1 / (1 + exp(-v)); };
+
+    // parameter offsets
+    std::vector<size_t> wOffset, bOffset;
+    size_t offset = 0;
+    for (size_t l = 0; l < attr.m_numLayers; l++)
+        for (size_t d = 0; d < D; d++)
+        {
+            wOffset.push_back(offset);
+            offset += G * H * ((l == 0 ? inputDim : D * H) + H);
+        }
+    for (size_t l = 0; l < attr.m_numLayers; l++)
+        for (size_t d = 0; d < D; d++)
+        {
+            bOffset.push_back(offset);
+            offset += 2 * G * H;
+        }
+
+    std::vector<std::vector<double>> result;
+    for (auto x : seq)
+    {
+        size_t dim = inputDim;
+        const size_t T = x.size() / inputDim;
+        for (size_t l = 0; l < attr.m_numLayers; l++)
+        {
+            std::vector<double> y(D * H * T);
+            for (size_t d = 0; d < D; d++)
+            {
+                const double* W = &w[wOffset[l * D + d]];
+                const double* R = W + G * H * dim;
+                const double* bW = &w[bOffset[l * D + d]];
+                const double* bR = bW + G * H;
+                std::vector<double> h(H, 0), c(H, 0);
+                for (size_t s = 0; s < T; s++)
+                {
+                    size_t t = d == 0 ? s : T - 1 - s;
+                    std::vector<double> gx(G * H), gh(G * H);
+                    for (size_t k = 0; k < G * H; k++)
+                    {
+                        gx[k] = bW[k];
+                        gh[k] = bR[k];
+                        for (size_t i = 0; i < dim; i++)
+                            gx[k] += W[k * dim + i] * x[t * dim + i];
+                        for (size_t i = 0; i < H; i++)
+                            gh[k] += R[k * H + i] * h[i];
+                    }
+                    std::vector<double> hNew(H);
+                    for (size_t u = 0; u < H; u++)
+                    {
+                        if (G == 4)
+                        {
+                            double i = sigmoid(gx[u] + gh[u]), f = sigmoid(gx[H + u] + gh[H + u]);
+                            double cc = tanh(gx[2 * H + u] + gh[2 * H + u]), o = sigmoid(gx[3 * H + u] + gh[3 * H + u]);
+                            c[u] = f * c[u] + i * cc;
+                            hNew[u] = o * tanh(c[u]);
+                        }
+                        else if (G == 3)
+                        {
+                            double r = sigmoid(gx[u] + gh[u]), z = sigmoid(gx[H + u] + gh[H + u]);
+                            double cc = tanh(gx[2 * H + u] + r * gh[2 * H + u]);
+                            hNew[u] = (1 - z) * cc + z * h[u];
+                        }
+                        else
+                        {
+                            double a = gx[u] + gh[u];
+                            hNew[u] = attr.m_recurrentOp == L"rnnReLU" ? std::max(a, 0.0) : tanh(a);
+                        }
+                    }
+                    h = hNew;
+                    for (size_t u = 0; u < H; u++)
+                        y[t * D * H + d * H + u] = h[u];
+                }
+            }
+            x = y;
+            dim = D * H;
+        }
+        result.push_back(x);
+    }
+    return result;
+}
+
+struct RNNTestSetup
+{
+    RnnAttributes attr;
+    size_t inputDim;
+    std::vector<size_t> lengths; // sorted from longest to shortest, as PackSequencesForCuDNN() does
+    std::vector<size_t> numSequencesForFrame;
+    std::vector<std::vector<double>> seq;
+    DMatrix x, w;
+
+    RNNTestSetup(const RnnAttributes& attributes, size_t dim, const std::vector<size_t>& seqLengths, unsigned long seed)
+        : attr(attributes), inputDim(dim), lengths(seqLengths)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(-0.5, 0.5);
+
+        auto numParameters = attr.GetNumParameters(inputDim);
+        w.Resize(numParameters.first, numParameters.second);
+        for (size_t i = 0; i < w.GetNumElements(); i++)
+            w.Data()[i] = dist(rng);
+
+        size_t numColumns = 0;
+        numSequencesForFrame.assign(lengths[0], 0);
+        for (auto len : lengths)
+        {
+            std::vector<double> s(inputDim * len);
+            for (auto& v : s)
+                v = dist(rng);
+            seq.push_back(s);
+            for (size_t t = 0; t < len; t++)
+                numSequencesForFrame[t]++;
+            numColumns += len;
+        }
+
+        // dense cuDNN packing: frame by frame, longest sequence first
+        x.Resize(inputDim, numColumns);
+        size_t col = 0;
+        for (size_t t = 0; t < lengths[0]; t++)
+            for (size_t j = 0; j < numSequencesForFrame[t]; j++, col++)
+                for (size_t i = 0; i < inputDim; i++)
+                    x(i, col) = seq[j][t * inputDim + i];
+    }
+
+    size_t OutputDim() const { return (attr.m_bidirectional ? 2 : 1) * attr.m_hiddenSize; }
+
+    // sum(Y .* weights), the scalar objective used for the gradient check
+    double Objective(const DMatrix& xIn, const DMatrix& wIn, const DMatrix& weights) const
+    {
+        DMatrix y(OutputDim(), xIn.GetNumCols()), reserve, workspace;
+        y.RNNForward(xIn, wIn, inputDim, OutputDim(), numSequencesForFrame, attr, reserve, workspace);
+        return DMatrix::InnerProductOfMatrices(y, weights);
+    }
+};
+
+static std::vector<RnnAttributes> RNNTestConfigs()
+{
+    std::vector<RnnAttributes> res;
+    for (auto op : { L"lstm", L"gru", L"rnnTanh", L"rnnReLU" })
+        for (bool bidirectional : { false, true })
+            for (size_t numLayers : { 1, 2 })
+                res.push_back(RnnAttributes(bidirectional, numLayers, 3, op, -1));
+    return res;
+}
+
+BOOST_AUTO_TEST_SUITE(CPURNNSuite)
+
+BOOST_FIXTURE_TEST_CASE(CPURNNForwardMatchesReference, RandomSeedFixture)
+{
+    unsigned long seed = 1;
+    for (const auto& attr : RNNTestConfigs())
+    {
+        RNNTestSetup setup(attr, 4, { 5, 5, 3, 1 }, seed++);
+        DMatrix y(setup.OutputDim(), setup.x.GetNumCols()), reserve, workspace;
+        y.RNNForward(setup.x, setup.w, setup.inputDim, setup.OutputDim(), setup.numSequencesForFrame, attr, reserve, workspace);
+
+        auto expected = ReferenceRNN(attr, setup.inputDim, std::vector<double>(setup.w.Data(), setup.w.Data() + setup.w.GetNumElements()), setup.seq);
+        size_t col = 0;
+        for (size_t t = 0; t < setup.lengths[0]; t++)
+            for (size_t j = 0; j < setup.numSequencesForFrame[t]; j++, col++)
+                for (size_t i = 0; i < setup.OutputDim(); i++)
+                    BOOST_REQUIRE_SMALL(y(i, col) - expected[j][t * setup.OutputDim() + i], 1e-10);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(CPURNNBackwardMatchesFiniteDifferences, RandomSeedFixture)
+{
+    const double eps = 1e-6;
+    unsigned long seed = 100;
+    for (const auto& attr : RNNTestConfigs())
+    {
+        RNNTestSetup setup(attr, 4, { 4, 3, 3, 2 }, seed++);
+        const size_t numColumns = setup.x.GetNumCols();
+
+        DMatrix y(setup.OutputDim(), numColumns), reserve, workspace;
+        y.RNNForward(setup.x, setup.w, setup.inputDim, setup.OutputDim(), setup.numSequencesForFrame, attr, reserve, workspace);
+
+        DMatrix dy = DMatrix::RandomUniform(setup.OutputDim(), numColumns, -1, 1, seed);
+        DMatrix dx(setup.inputDim, numColumns);
+        y.RNNBackwardData(dy, setup.w, dx, attr, reserve, workspace);
+
+        // weight gradients are accumulated, as in cuDNN
+        DMatrix dw(setup.w.GetNumRows(), setup.w.GetNumCols());
+        dw.SetValue(1.0);
+        y.RNNBackwardWeights(setup.x, y, dw, attr, reserve, workspace);
+
+        for (size_t i = 0; i < setup.x.GetNumElements(); i++)
+        {
+            DMatrix xp(setup.x), xm(setup.x);
+            xp.Data()[i] += eps;
+            xm.Data()[i] -= eps;
+            double numeric = (setup.Objective(xp, setup.w, dy) - setup.Objective(xm, setup.w, dy)) / (2 * eps);
+            BOOST_REQUIRE_SMALL(dx.Data()[i] - numeric, 1e-6);
+        }
+        for (size_t i = 0; i < setup.w.GetNumElements(); i++)
+        {
+            DMatrix wp(setup.w), wm(setup.w);
+            wp.Data()[i] += eps;
+            wm.Data()[i] -= eps;
+            double numeric = (setup.Objective(setup.x, wp, dy) - setup.Objective(setup.x, wm, dy)) / (2 * eps);
+            BOOST_REQUIRE_SMALL(dw.Data()[i] - 1.0 - numeric, 1e-6);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}}}}
@@ -0,0 +1,127 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include <cmath>
+#include <random>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../../../Source/Math/CPUMatrix.h"
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+using FMatrix = CPUMatrix<float>;
+
+// A reduction of a [rows x cols] column-major matrix, either over the rows (giving a row vector)
+// or over the columns (giving a column vector). The former reduces over contiguous memory.
+struct ReductionCase
+{
+    size_t rows, cols;
+    bool overRows;
+};
+
+static std::vector<ReductionCase> ReductionCases()
+{
+    return {
+        { 256, 512, true },     // many outputs, contiguous: vectorized path, parallel over outputs
+        { 256, 512, false },    // many outputs, strided: generic path, parallel over outputs
+        { 100003, 3, true },    // few outputs, contiguous: blocked reduction
+        { 5, 40001, false },    // few outputs, strided: blocked generic reduction
+        { 7, 9, true },         // too small to parallelize
+    };
+}
+
+// run the reduction, with the parallel reduction code on or off
+static FMatrix Reduce(const FMatrix& a, const ReductionCase& rc, ElementWiseOperator op, ElementWiseOperator reductionOp, bool parallel, float beta = 0)
+{
+    int flags = FMatrix::GetOptimizationFlags();
+    FMatrix::SetOptimizationFlags(parallel ? (flags | FMatrix::OPT_PARALLEL_REDUCTION) : (flags & ~FMatrix::OPT_PARALLEL_REDUCTION));
+
+    FMatrix o = rc.overRows ? FMatrix(1, rc.cols) : FMatrix(rc.rows, 1);
+    o.SetValue(1.0f);
+    const std::array<size_t, 2> offsets = { 0, 0 };
+    SmallVector<size_t> regularOpDims({ rc.overRows ? rc.cols : rc.rows });
+    std::array<SmallVector<ptrdiff_t>, 2> regularStrides = { SmallVector<ptrdiff_t>({ rc.overRows ? (ptrdiff_t)rc.rows : 1 }), SmallVector<ptrdiff_t>({ 1 }) };
+    SmallVector<size_t> reducingOpDims({ rc.overRows ? rc.rows : rc.cols });
+    std::array<SmallVector<ptrdiff_t>, 2> reducingStrides = { SmallVector<ptrdiff_t>({ rc.overRows ? 1 : (ptrdiff_t)rc.rows }), SmallVector<ptrdiff_t>({ 0 }) };
+    if (reductionOp == ElementWiseOperator::opArgmax || reductionOp == ElementWiseOperator::opArgmin)
+        o.TensorArgOp(a, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+    else
+        o.TensorOp(beta, a, 1.0f, op, reductionOp, offsets, regularOpDims, regularStrides, reducingOpDims, reducingStrides);
+
+    FMatrix::SetOptimizationFlags(flags);
+    return o;
+}
+
+static FMatrix RandomMatrix(size_t rows, size_t cols, unsigned long seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    FMatrix a(rows, cols);
+    for (size_t i = 0; i < a.GetNumElements(); i++)
+        a.Data()[i] = dist(rng);
+    return a;
+}
+
+static void CheckSame(const FMatrix& expected, const FMatrix& actual, float relativeTolerance)
+{
+    BOOST_REQUIRE_EQUAL(expected.GetNumElements(), actual.GetNumElements());
+    for (size_t i = 0; i < expected.GetNumElements(); i++)
+    {
+        if (relativeTolerance == 0)
+            BOOST_REQUIRE_EQUAL(expected.Data()[i], actual.Data()[i]);
+        else
+            BOOST_REQUIRE_SMALL(expected.Data()[i] - actual.Data()[i], relativeTolerance * std::max(1.0f, std::fabs(expected.Data()[i])));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(CPUTensorReductionSuite)
+
+BOOST_FIXTURE_TEST_CASE(ParallelReductionMatchesSerial, RandomSeedFixture)
+{
+    unsigned long seed = 1;
+    for (const auto& rc : ReductionCases())
+    {
+        FMatrix a = RandomMatrix(rc.rows, rc.cols, seed++);
+
+        // max/min/argmax/argmin do not depend on the order of evaluation
+        for (auto reductionOp : { ElementWiseOperator::opMax, ElementWiseOperator::opMin, ElementWiseOperator::opArgmax, ElementWiseOperator::opArgmin })
+            CheckSame(Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, false), Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, true), 0);
+
+        // sums are evaluated in a different order, with aggregation in double
+        for (auto reductionOp : { ElementWiseOperator::opSum, ElementWiseOperator::opLogSum })
+        {
+            CheckSame(Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, false), Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, true), 1e-5f);
+            CheckSame(Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, false, 0.5f), Reduce(a, rc, ElementWiseOperator::opCopy, reductionOp, true, 0.5f), 1e-5f);
+        }
+        CheckSame(Reduce(a, rc, ElementWiseOperator::opSqr, ElementWiseOperator::opSum, false), Reduce(a, rc, ElementWiseOperator::opSqr, ElementWiseOperator::opSum, true), 1e-5f);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(ParallelReductionIsDeterministic, RandomSeedFixture)
+{
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+    unsigned long seed = 100;
+    for (const auto& rc : ReductionCases())
+    {
+        FMatrix a = RandomMatrix(rc.rows, rc.cols, seed++);
+        for (auto op : { ElementWiseOperator::opCopy, ElementWiseOperator::opSqr })
+        {
+            omp_set_num_threads(1);
+            FMatrix expected = Reduce(a, rc, op, ElementWiseOperator::opSum, true);
+            for (int numThreads : { 2, 3, 8 })
+            {
+                omp_set_num_threads(numThreads);
+                CheckSame(expected, Reduce(a, rc, op, ElementWiseOperator::opSum, true), 0);
+            }
+        }
+    }
+    omp_set_num_threads(maxThreads);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}}}}
@@ -6,6 +6,7 @@
 #include "stdafx.h"
 #include <algorithm>
 #include <array>
+#include <fstream>
 #include <random>
 #include <numeric>
 #include <boost/random/normal_distribution.hpp>
@@ -17,6 +18,7 @@
 #include "../../../Source/Math/GPUMatrix.h"
 #include "../../../Source/Math/ConvolutionEngine.h"
 #include "../../../Source/Math/CuDnnFactories.h"
+#include "../../../Source/Math/QuantizedOperations.h"
 #include "common.h"
 
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
@@ -642,6 +644,381 @@ BOOST_AUTO_TEST_CASE(MaxUnpooling)
     }
 }
 
+// Geometries of the CPU engines that work on the images directly: 3x3 convolutions with unit stride (Winograd)
+// and 1x1 convolutions (direct), with and without padding.
+std::vector<ConvolveGeometryPtr> GenerateWinogradAndPointwiseTestConfigs()
+{
+    std::vector<ConvolveGeometryPtr> res;
+    for (size_t k : {1, 3})
+    {
+        for (size_t inW : {3, 5, 8, 13})
+        {
+            for (size_t inC : {1, 3})
+            {
+                for (size_t mapCount : {1, 5})
+                {
+                    for (size_t stride : k == 1 ? std::vector<size_t>{1, 2} : std::vector<size_t>{1})
+                    {
+                        for (bool autoPad : {false, true})
+                        {
+                            res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(inW, inW + 4, inC),
+                                TensorShape(k, k, inC), TensorShape(mapCount), TensorShape(stride, stride, inC),
+                                ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{autoPad, autoPad, false},
+                                TensorShape(0), TensorShape(0)));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // Explicit padding.
+    res.push_back(std::make_shared<ConvolveGeometry>(TensorShape(9, 6, 4),
+        TensorShape(3, 3, 4), TensorShape(3), TensorShape(1, 1, 4),
+        ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{false},
+        TensorShape(1, 1, 0), TensorShape(1, 1, 0)));
+    return res;
+}
+
+BOOST_AUTO_TEST_CASE(WinogradAndPointwiseConvolution)
+{
+    std::mt19937 rng(0);
+    boost::random::uniform_int_distribution<> batchSizeG(1, 8);
+    boost::random::normal_distribution<float> nd;
+
+    auto initMat = [&](SingleMatrix& buf, size_t r, size_t c, vec& data) -> SingleMatrix
+    {
+        data.resize(r * 3 * c);
+        std::fill(begin(data), end(data), std::numeric_limits<float>::quiet_NaN());
+        std::generate(begin(data) + r * c, begin(data) + 2 * r * c, [&] { return nd(rng); });
+        buf.SetValue(r, 3 * c, buf.GetDeviceId(), data.data());
+        // Get center slice.
+        return buf.ColumnSlice(c, c);
+    };
+
+    int deviceId = -1;
+    for (size_t maxTempMem : {0, 1, 3})
+    {
+        for (const auto& g : GenerateWinogradAndPointwiseTestConfigs())
+        {
+            auto engKind = g->KernelShape()[0] == 3 ? ConvolutionEngineKind::Winograd : ConvolutionEngineKind::Direct;
+            auto baseEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+            auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, maxTempMem, PoolKind::None, engKind);
+
+            size_t n = batchSizeG(rng);
+            vec buf;
+            buf.resize(g->InputShape().GetNumElements() * n);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+            size_t mapCount = g->GetMapCount(g->InputShape().GetRank() - 1);
+            buf.resize(g->KernelShape().GetNumElements() * mapCount);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix kernel(mapCount, g->KernelShape().GetNumElements(), buf.data(), deviceId, matrixFlagNormal);
+
+            buf.resize(g->OutputShape().GetNumElements() * n);
+            std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+            SingleMatrix srcGrad(g->OutputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+            std::stringstream tmsg;
+            tmsg << "Geometry: " << (std::string)(*g) << ", Batch: " << n << ", MaxTempMem: " << maxTempMem;
+            std::string msg = " are not equal, " + tmsg.str();
+            std::string msgNan = " has NaNs, " + tmsg.str();
+            std::string msgNotNan = " has buffer overflow/underflow, " + tmsg.str();
+
+            // The direct engine sums at most 5 products per output or input gradient, in another order than the
+            // reference engine, and stays within 16 * Abs of it. F(4x4,3x3) rounds transformed tiles that are much
+            // larger than the results, as its interpolation points are +-2 and +-1/2: on these sums of up to 45
+            // products of unit normals its error reaches 650 * Abs (F(2x2,3x3): 64 * Abs), also on results close to
+            // zero, which only an absolute bound covers. Kernel gradients of both engines are sums over all pixels
+            // and samples, the Winograd ones done by the GEMM engine, and get the bounds of ConvolutionBackwardKernel.
+            bool isWinograd = engKind == ConvolutionEngineKind::Winograd;
+            float relErr = Err<float>::Rel * (isWinograd ? 16 : 1);
+            float absErr = Err<float>::Abs * (isWinograd ? 1024 : 32);
+            float kernelRelErr = Err<float>::Rel * 192;
+            float kernelAbsErr = Err<float>::Abs * 32;
+            std::string emsg;
+
+            size_t crowOut = g->OutputShape().GetNumElements();
+            SingleMatrix outBuf(deviceId);
+            SingleMatrix out = initMat(outBuf, crowOut, n, buf);
+            SingleMatrix outB(crowOut, n, deviceId);
+            SingleMatrix workspace(deviceId);
+            SingleMatrix workspaceB(deviceId);
+
+            testEng->Forward(in, kernel, out, workspace);
+            baseEng->Forward(in, kernel, outB, workspaceB);
+
+            BOOST_REQUIRE_MESSAGE(!out.HasNan("out"), "out" << msgNan);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr, absErr), "out" << msg << ". " << emsg);
+            BOOST_REQUIRE_MESSAGE(CountNans(outBuf) == crowOut * 2 * n, "out" << msgNotNan);
+
+            size_t crowGrad = g->InputShape().GetNumElements();
+            SingleMatrix gradBuf(deviceId);
+            SingleMatrix grad = initMat(gradBuf, crowGrad, n, buf);
+            SingleMatrix gradB(grad.DeepClone(), deviceId);
+
+            testEng->BackwardData(srcGrad, kernel, grad, true, workspace);
+            baseEng->BackwardData(srcGrad, kernel, gradB, true, workspaceB);
+
+            BOOST_REQUIRE_MESSAGE(!grad.HasNan("grad"), "grad" << msgNan);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr, absErr), "grad" << msg << ". " << emsg);
+            BOOST_REQUIRE_MESSAGE(CountNans(gradBuf) == crowGrad * 2 * n, "grad" << msgNotNan);
+
+            SingleMatrix kernelGrad(kernel.DeepClone(), deviceId);
+            SingleMatrix kernelGradB(kernel.DeepClone(), deviceId);
+
+            testEng->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+            baseEng->BackwardKernel(srcGrad, in, kernelGradB, true, false, workspaceB);
+
+            BOOST_REQUIRE_MESSAGE(!kernelGrad.HasNan("kernelGrad"), "kernelGrad" << msgNan);
+            BOOST_REQUIRE_MESSAGE(CheckEqual(kernelGrad, kernelGradB, emsg, kernelRelErr, kernelAbsErr), "kernelGrad" << msg << ". " << emsg);
+        }
+    }
+}
+
+// Depthwise convolution is compared with the reference engine running the equivalent full convolution,
+// whose kernels are zero except for the input channel of the map.
+BOOST_AUTO_TEST_CASE(DepthwiseConvolution)
+{
+    std::mt19937 rng(0);
+    boost::random::uniform_int_distribution<> batchSizeG(1, 8);
+    boost::random::normal_distribution<float> nd;
+
+    int deviceId = -1;
+    for (size_t k : {1, 3, 5})
+    {
+        for (size_t inW : {5, 8, 11})
+        {
+            for (size_t multiplier : {1, 2})
+            {
+                for (size_t stride : {1, 2})
+                {
+                    for (bool autoPad : {false, true})
+                    {
+                        size_t inC = 3;
+                        size_t mapCount = inC * multiplier;
+                        auto g = std::make_shared<ConvolveGeometry>(TensorShape(inW, inW + 1, inC),
+                            TensorShape(k, k, 1), TensorShape(mapCount), TensorShape(stride, stride, 1),
+                            ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{autoPad, autoPad, false},
+                            TensorShape(0), TensorShape(0), TensorShape(1), false, /*groups=*/inC);
+                        auto gB = std::make_shared<ConvolveGeometry>(TensorShape(inW, inW + 1, inC),
+                            TensorShape(k, k, inC), TensorShape(mapCount), TensorShape(stride, stride, inC),
+                            ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{autoPad, autoPad, false},
+                            TensorShape(0), TensorShape(0));
+                        auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Direct);
+                        auto baseEng = ConvEng::Create(gB, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+
+                        size_t n = batchSizeG(rng);
+                        vec buf(g->InputShape().GetNumElements() * n);
+                        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+                        SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+                        size_t kernelSize = k * k;
+                        buf.resize(kernelSize * mapCount);
+                        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+                        SingleMatrix kernel(mapCount, kernelSize, buf.data(), deviceId, matrixFlagNormal);
+                        vec bufB(kernelSize * inC * mapCount, 0);
+                        for (size_t m = 0; m < mapCount; m++)
+                            std::copy(begin(buf) + m * kernelSize, begin(buf) + (m + 1) * kernelSize, begin(bufB) + (m * inC + m / multiplier) * kernelSize);
+                        SingleMatrix kernelB(mapCount, kernelSize * inC, bufB.data(), deviceId, matrixFlagNormal);
+
+                        buf.resize(g->OutputShape().GetNumElements() * n);
+                        std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+                        SingleMatrix srcGrad(g->OutputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+                        std::stringstream tmsg;
+                        tmsg << "Geometry: " << (std::string)(*g) << ", Batch: " << n;
+                        std::string msg = " are not equal, " + tmsg.str();
+
+                        float relErr = Err<float>::Rel;
+                        float absErr = Err<float>::Abs;
+                        std::string emsg;
+
+                        SingleMatrix out(g->OutputShape().GetNumElements(), n, deviceId);
+                        SingleMatrix outB(g->OutputShape().GetNumElements(), n, deviceId);
+                        SingleMatrix workspace(deviceId);
+                        testEng->Forward(in, kernel, out, workspace);
+                        baseEng->Forward(in, kernelB, outB, workspace);
+                        BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr * 4, absErr * 14), "out" << msg << ". " << emsg);
+
+                        SingleMatrix grad(g->InputShape().GetNumElements(), n, deviceId);
+                        SingleMatrix gradB(g->InputShape().GetNumElements(), n, deviceId);
+                        grad.SetValue(0);
+                        gradB.SetValue(0);
+                        testEng->BackwardData(srcGrad, kernel, grad, true, workspace);
+                        baseEng->BackwardData(srcGrad, kernelB, gradB, true, workspace);
+                        BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr * 16, absErr * 16), "grad" << msg << ". " << emsg);
+
+                        SingleMatrix kernelGrad(mapCount, kernelSize, deviceId);
+                        SingleMatrix kernelGradB(mapCount, kernelSize * inC, deviceId);
+                        kernelGrad.SetValue(0);
+                        kernelGradB.SetValue(0);
+                        testEng->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+                        baseEng->BackwardKernel(srcGrad, in, kernelGradB, true, false, workspace);
+                        std::unique_ptr<float[]> kernelGradData(kernelGradB.CopyToArray());
+                        for (size_t m = 0; m < mapCount; m++)
+                            std::copy(kernelGradData.get() + (m * inC + m / multiplier) * kernelSize, kernelGradData.get() + (m * inC + m / multiplier + 1) * kernelSize, buf.begin() + m * kernelSize);
+                        SingleMatrix kernelGradExpected(mapCount, kernelSize, buf.data(), deviceId, matrixFlagNormal);
+                        BOOST_REQUIRE_MESSAGE(CheckEqual(kernelGrad, kernelGradExpected, emsg, relErr * 192, absErr * 32), "kernelGrad" << msg << ". " << emsg);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Only the GEMM engine runs int8 products, so a quantized 3x3 convolution must not get the Winograd engine.
+BOOST_AUTO_TEST_CASE(QuantizedConvolutionUsesGemm)
+{
+    std::mt19937 rng(0);
+    boost::random::normal_distribution<float> nd;
+
+    int deviceId = -1;
+    size_t n = 5;
+    auto g = std::make_shared<ConvolveGeometry>(TensorShape(10, 9, 3), TensorShape(3, 3, 3), TensorShape(4), TensorShape(1, 1, 3),
+                                                ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+                                                TensorShape(0), TensorShape(0));
+
+    vec buf(g->InputShape().GetNumElements() * n);
+    std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+    SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+    buf.resize(g->KernelShape().GetNumElements() * 4);
+    std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+    SingleMatrix kernel(4, g->KernelShape().GetNumElements(), buf.data(), deviceId, matrixFlagNormal);
+
+    for (bool autotune : {false, true})
+    {
+        if (autotune)
+            ConvolutionEngineAutotuner::Enable(L"");
+        auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::All,
+                                       L"", false, false, false, /*quantized=*/true);
+        auto gemmEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Gemm);
+        testEng->SetQuantizedMultiplier(std::make_shared<Int8QuantizedMultiplier<float>>(false, true));
+        gemmEng->SetQuantizedMultiplier(std::make_shared<Int8QuantizedMultiplier<float>>(false, true));
+
+        SingleMatrix workspace(deviceId);
+        SingleMatrix out(g->OutputShape().GetNumElements(), n, deviceId);
+        SingleMatrix outGemm(g->OutputShape().GetNumElements(), n, deviceId);
+        testEng->Forward(in, kernel, out, workspace);
+        gemmEng->Forward(in, kernel, outGemm, workspace);
+
+        // same quantized products, so the same bits
+        std::string emsg;
+        BOOST_REQUIRE_MESSAGE(CheckEqual(out, outGemm, emsg, 0.0f, 0.0f), "out are not equal" << (autotune ? " with autotuning. " : ". ") << emsg);
+    }
+    ConvolutionEngineAutotuner::Disable();
+}
+
+BOOST_AUTO_TEST_CASE(AutotunedConvolution)
+{
+    std::mt19937 rng(0);
+    boost::random::normal_distribution<float> nd;
+
+    const char* cacheFile = "convautotune.test.tmp";
+    std::remove(cacheFile);
+    auto countCacheLines = [&]
+    {
+        std::ifstream f(cacheFile);
+        std::string line;
+        size_t count = 0;
+        while (std::getline(f, line))
+        {
+            BOOST_REQUIRE_MESSAGE(line.find(ConvolutionEngineAutotuner::CpuSignature()) == 0, "Autotuning cache line without CPU signature: " << line);
+            count++;
+        }
+        return count;
+    };
+
+    int deviceId = -1;
+    size_t n = 6;
+    auto g = std::make_shared<ConvolveGeometry>(TensorShape(10, 9, 3), TensorShape(3, 3, 3), TensorShape(4), TensorShape(1, 1, 3),
+                                                ConvolveGeometry::BoolVec{true}, ConvolveGeometry::BoolVec{true, true, false},
+                                                TensorShape(0), TensorShape(0));
+    vec buf(g->InputShape().GetNumElements() * n);
+    std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+    SingleMatrix in(g->InputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+    buf.resize(g->KernelShape().GetNumElements() * 4);
+    std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+    SingleMatrix kernel(4, g->KernelShape().GetNumElements(), buf.data(), deviceId, matrixFlagNormal);
+    buf.resize(g->OutputShape().GetNumElements() * n);
+    std::generate(begin(buf), end(buf), [&] { return nd(rng); });
+    SingleMatrix srcGrad(g->OutputShape().GetNumElements(), n, buf.data(), deviceId, matrixFlagNormal);
+
+    auto baseEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, ConvolutionEngineKind::Reference);
+    SingleMatrix workspace(deviceId);
+    SingleMatrix outB(g->OutputShape().GetNumElements(), n, deviceId);
+    SingleMatrix gradB(g->InputShape().GetNumElements(), n, deviceId);
+    SingleMatrix kernelGradB(kernel.GetNumRows(), kernel.GetNumCols(), deviceId);
+    gradB.SetValue(1);
+    kernelGradB.SetValue(1);
+    baseEng->Forward(in, kernel, outB, workspace);
+    baseEng->BackwardData(srcGrad, kernel, gradB, true, workspace);
+    baseEng->BackwardKernel(srcGrad, in, kernelGradB, true, false, workspace);
+
+    // Either engine may win the tuning, so the outputs and input gradients get the bounds of Winograd F(4x4,3x3)
+    // (see WinogradAndPointwiseConvolution), and the quantized ones, which only GEMM computes, those of GEMM.
+    float relErr = Err<float>::Rel;
+    float absErr = Err<float>::Abs;
+    std::string emsg;
+
+    // The second run reads the decisions of the first from the cache file and does not tune again.
+    auto engines = (ConvolutionEngineKind)((int)ConvolutionEngineKind::Winograd | (int)ConvolutionEngineKind::Gemm);
+    for (int run = 0; run < 2; run++)
+    {
+        ConvolutionEngineAutotuner::Enable(std::wstring(cacheFile, cacheFile + strlen(cacheFile)));
+        auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, engines);
+
+        SingleMatrix out(g->OutputShape().GetNumElements(), n, deviceId);
+        SingleMatrix grad(g->InputShape().GetNumElements(), n, deviceId);
+        SingleMatrix kernelGrad(kernel.GetNumRows(), kernel.GetNumCols(), deviceId);
+        grad.SetValue(1);
+        kernelGrad.SetValue(1);
+        testEng->Forward(in, kernel, out, workspace);
+        testEng->BackwardData(srcGrad, kernel, grad, true, workspace);
+        testEng->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+
+        BOOST_REQUIRE_MESSAGE(CheckEqual(out, outB, emsg, relErr * 16, absErr * 1024), "out are not equal. " << emsg);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr * 16, absErr * 1024), "grad are not equal. " << emsg);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(kernelGrad, kernelGradB, emsg, relErr * 192, absErr * 32), "kernelGrad are not equal. " << emsg);
+        BOOST_REQUIRE_EQUAL(countCacheLines(), 3);
+    }
+
+    // A quantized engine has its own decisions, which leave the full-precision ones alone: the forward pass runs
+    // quantized products, and the backward passes choose among fewer candidates, since Winograd is skipped.
+    {
+        auto testEng = ConvEng::Create(g, deviceId, ImageLayoutKind::CHW, 0, PoolKind::None, engines, L"", false, false, false, /*quantized=*/true);
+        testEng->SetQuantizedMultiplier(std::make_shared<Int8QuantizedMultiplier<float>>(false, true));
+        SingleMatrix out(g->OutputShape().GetNumElements(), n, deviceId);
+        SingleMatrix grad(g->InputShape().GetNumElements(), n, deviceId);
+        SingleMatrix kernelGrad(kernel.GetNumRows(), kernel.GetNumCols(), deviceId);
+        grad.SetValue(1);
+        kernelGrad.SetValue(1);
+        testEng->Forward(in, kernel, out, workspace);
+        BOOST_REQUIRE_EQUAL(countCacheLines(), 4);
+        testEng->BackwardData(srcGrad, kernel, grad, true, workspace);
+        testEng->BackwardKernel(srcGrad, in, kernelGrad, true, false, workspace);
+        BOOST_REQUIRE_EQUAL(countCacheLines(), 6);
+
+        BOOST_REQUIRE_MESSAGE(CheckEqual(grad, gradB, emsg, relErr * 16, absErr * 16), "quantized grad are not equal. " << emsg);
+        BOOST_REQUIRE_MESSAGE(CheckEqual(kernelGrad, kernelGradB, emsg, relErr * 192, absErr * 32), "quantized kernelGrad are not equal. " << emsg);
+
+        std::ifstream f(cacheFile);
+        std::string line;
+        size_t int8Lines = 0, backwardDataLines = 0, backwardKernelLines = 0;
+        while (std::getline(f, line))
+        {
+            int8Lines += line.find("\tfloat int8 forward ") != std::string::npos;
+            backwardDataLines += line.find("\tfloat backwardData ") != std::string::npos;
+            backwardKernelLines += line.find("\tfloat backwardKernel ") != std::string::npos;
+        }
+        BOOST_REQUIRE_EQUAL(int8Lines, 1);
+        BOOST_REQUIRE_EQUAL(backwardDataLines, 2);
+        BOOST_REQUIRE_EQUAL(backwardKernelLines, 2);
+    }
+    ConvolutionEngineAutotuner::Disable();
+    std::remove(cacheFile);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(Half_ConvolutionSuite)
@@ -8,6 +8,7 @@
 #include "../../../Source/Math/GPUMatrix.h"
 #include "../../Common/Include/fileutil.h"
 #include "../../Common/Include/File.h"
+#include "../../Common/Include/AsyncCheckpointWriter.h"
 
 #include <string>
 
@@ -70,6 +71,37 @@ BOOST_FIXTURE_TEST_CASE(MatrixFileWriteRead, RandomSeedFixture)
     BOOST_CHECK(matrixSparseRead.IsEqualTo(matrixSparseCopy, c_epsilonFloatE5));
 }
 
+BOOST_FIXTURE_TEST_CASE(CPUMatrixStagedFileWriteRead, RandomSeedFixture)
+{
+    CPUMatrix<float> matrixCpu = CPUMatrix<float>::RandomUniform(43, 10, -26.3f, 30.2f, IncrementCounter());
+    CPUMatrix<float> matrixCpuCopy = matrixCpu;
+
+    std::shared_ptr<File> staged = File::CreateStagingFile(fileOptionsBinary | fileOptionsWrite);
+    *staged << matrixCpu << (size_t)42;
+
+    // What is written later to disk is what was staged, not the current value.
+    matrixCpu.SetValue(0);
+
+    std::wstring fileName(L"MCPUStaged.bin");
+    AsyncCheckpointWriter writer;
+    writer.Submit({ { fileName, [staged](const std::wstring& tempFileName) { staged->WriteStagedTo(tempFileName); } } });
+    writer.Wait();
+    BOOST_CHECK(!fexists(fileName + L".tmp"));
+
+    File file(fileName, fileOptionsBinary | fileOptionsRead);
+    CPUMatrix<float> matrixCpuRead;
+    size_t marker;
+    file >> matrixCpuRead >> marker;
+
+    BOOST_CHECK(matrixCpuCopy.IsEqualTo(matrixCpuRead, 0));
+    BOOST_CHECK_EQUAL(marker, 42);
+
+    // Errors of the background thread are thrown by the next Wait().
+    writer.Submit({ { fileName, [](const std::wstring&) { RuntimeError("Staged file could not be written."); } } });
+    BOOST_CHECK_THROW(writer.Wait(), std::runtime_error);
+    writer.Wait();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(GPUMatrixSuite)
@@ -76,6 +76,56 @@ public:
     }
 };
 
+// Sparse gradients on the CPU that touch different columns in consecutive minibatches, for the lazy sparse updates
+class LazyMatrixLearnerFixture : public RandomSeedFixture
+{
+public:
+    static const size_t dim1 = 64;
+    static const size_t dim2 = 128;
+    static const size_t dim3 = 512;
+    static const size_t numSteps = 3;
+
+    std::vector<SingleMatrix> gradients;       // dense
+    std::vector<SingleMatrix> sparseGradients; // block sparse column, same values
+    std::vector<bool> alwaysTouched;           // columns with a gradient in every step
+    std::vector<int> timestamps;
+
+    LazyMatrixLearnerFixture() : timestamps(dim2, 0)
+    {
+        SingleMatrix matG2 = SingleMatrix::RandomGaussian(dim1, dim3, CPUDEVICE, 0.0f, 1.0f, IncrementCounter());
+        alwaysTouched.assign(dim2, true);
+        for (size_t step = 0; step < numSteps; step++)
+        {
+            SingleMatrix matG1(CPUDEVICE);
+            matG1.AssignTruncateBottomOf(SingleMatrix::RandomUniform(dim2, dim3, CPUDEVICE, -100.0f, 0.1f, IncrementCounter()), 0);
+            SingleMatrix matG1sparseCSC(matG1.DeepClone());
+            matG1sparseCSC.SwitchToMatrixType(MatrixType::SPARSE, matrixFormatSparseCSC, true);
+
+            SingleMatrix matG(CPUDEVICE);
+            SingleMatrix::MultiplyAndWeightedAdd(1, matG2, false, matG1, true, 0, matG);
+            SingleMatrix matGsparseBSC(CPUDEVICE);
+            matGsparseBSC.SwitchToMatrixType(MatrixType::SPARSE, matrixFormatSparseBlockCol, false);
+            SingleMatrix::MultiplyAndAdd(matG2, false, matG1sparseCSC, true, matGsparseBSC);
+
+            for (size_t j = 0; j < dim2; j++)
+                alwaysTouched[j] = alwaysTouched[j] && matG.ColumnSlice(j, 1).SumOfAbsElements() != 0;
+
+            gradients.push_back(matG.DeepClone());
+            sparseGradients.push_back(matGsparseBSC.DeepClone());
+        }
+    }
+
+    // The values of columns with zero gradients in some step move along their momentum in the dense update only.
+    void CheckAlwaysTouchedColumns(const SingleMatrix& matM, const SingleMatrix& matMsparse)
+    {
+        for (size_t j = 0; j < dim2; j++)
+        {
+            if (alwaysTouched[j])
+                BOOST_CHECK(matM.ColumnSlice(j, 1).IsEqualTo(matMsparse.ColumnSlice(j, 1), c_epsilonFloatE5));
+        }
+    }
+};
+
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
 
 BOOST_AUTO_TEST_SUITE(MatrixLearnerSuite)
@@ -121,5 +171,194 @@ BOOST_FIXTURE_TEST_CASE(AdaDeltaSparse, MatrixLearnerFixture)
     });
 }
 
+// tests the lazy sparse Adam on the CPU vs. dense
+BOOST_FIXTURE_TEST_CASE(AdamSparseLazy, LazyMatrixLearnerFixture)
+{
+    SingleMatrix matSG = SingleMatrix::Zeros(dim1, 2 * dim2, CPUDEVICE);
+    SingleMatrix matSGsparse = SingleMatrix::Zeros(dim1, 2 * dim2, CPUDEVICE);
+    SingleMatrix matM = SingleMatrix::RandomGaussian(dim1, dim2, CPUDEVICE, 0.0f, 1.0f, IncrementCounter());
+    SingleMatrix matMsparse(matM.DeepClone());
+
+    for (int step = 1; step <= numSteps; step++)
+    {
+        matSG.AdamUpdate(gradients[step - 1], matM, step, 0.01, 0.9, 0.999, 1e-8, 0.1f);
+        matSGsparse.AdamUpdate(sparseGradients[step - 1], matMsparse, step, 0.01, 0.9, 0.999, 1e-8, 0.1f, false, timestamps.data(), step);
+    }
+    matSGsparse.LazyUpdateFlushState(dim2, { 0.999f, 0.9f }, { 0, 0 }, timestamps.data(), numSteps);
+
+    BOOST_CHECK(matSG.IsEqualTo(matSGsparse, c_epsilonFloatE5));
+    CheckAlwaysTouchedColumns(matM, matMsparse);
+}
+
+// tests the lazy sparse FSAdagrad on the CPU vs. dense
+BOOST_FIXTURE_TEST_CASE(FSAdagradSparseLazy, LazyMatrixLearnerFixture)
+{
+    SingleMatrix matSG = SingleMatrix::Zeros(dim1, 2 * dim2, CPUDEVICE);
+    SingleMatrix matSGsparse = SingleMatrix::Zeros(dim1, 2 * dim2, CPUDEVICE);
+    SingleMatrix matM = SingleMatrix::RandomGaussian(dim1, dim2, CPUDEVICE, 0.0f, 1.0f, IncrementCounter());
+    SingleMatrix matMsparse(matM.DeepClone());
+
+    for (int step = 1; step <= numSteps; step++)
+    {
+        matSG.FSAdagradUpdate(gradients[step - 1], matM, 0.5, 0.0001, 0.9, 0.99, 0.1f);
+        matSGsparse.FSAdagradUpdate(sparseGradients[step - 1], matMsparse, 0.5, 0.0001, 0.9, 0.99, 0.1f, timestamps.data(), step);
+    }
+    matSGsparse.LazyUpdateFlushState(dim2, { 0.99f, 0.9f }, { 0, 0 }, timestamps.data(), numSteps);
+
+    BOOST_CHECK(matSG.IsEqualTo(matSGsparse, c_epsilonFloatE5));
+    CheckAlwaysTouchedColumns(matM, matMsparse);
+}
+
+// tests the lazy sparse RmsProp on the CPU vs. dense, which are the same as zero gradients do not change the model
+BOOST_FIXTURE_TEST_CASE(RmsPropSparseLazy, LazyMatrixLearnerFixture)
+{
+    SingleMatrix matSG(CPUDEVICE);
+    SingleMatrix matSGsparse(CPUDEVICE);
+
+    for (int step = 1; step <= numSteps; step++)
+    {
+        matSG.RmsProp(gradients[step - 1], 0.99f, 1.2f, 10.0f, 0.75f, 0.1f, false, step > 1);
+        matSGsparse.RmsProp(sparseGradients[step - 1], 0.99f, 1.2f, 10.0f, 0.75f, 0.1f, false, step > 1, timestamps.data(), step);
+
+        // the gradients are scaled in place
+        SingleMatrix matGsparse(sparseGradients[step - 1].DeepClone());
+        matGsparse.SwitchToMatrixType(MatrixType::DENSE, matrixFormatDense, true);
+        BOOST_CHECK(gradients[step - 1].IsEqualTo(matGsparse, c_epsilonFloatE5));
+    }
+    matSGsparse.LazyUpdateFlushState(dim2, { 0.99f, 0, 0.75f }, { 0, 0, 0.1f }, timestamps.data(), numSteps);
+
+    BOOST_CHECK(matSG.IsEqualTo(matSGsparse, c_epsilonFloatE5));
+}
+
+// tests the sparse RmsProp on the CPU vs. dense with the average multiplier, which is taken over all columns,
+// so that the sparse version updates all of them
+BOOST_FIXTURE_TEST_CASE(RmsPropSparseAveMultiplier, LazyMatrixLearnerFixture)
+{
+    SingleMatrix matSG(CPUDEVICE);
+    SingleMatrix matSGsparse(CPUDEVICE);
+
+    for (int step = 1; step <= numSteps; step++)
+    {
+        float avg = matSG.RmsProp(gradients[step - 1], 0.99f, 1.2f, 10.0f, 0.75f, 0.1f, true, step > 1);
+        float avgSparse = matSGsparse.RmsProp(sparseGradients[step - 1], 0.99f, 1.2f, 10.0f, 0.75f, 0.1f, true, step > 1, timestamps.data(), step);
+        BOOST_CHECK_CLOSE(avg, avgSparse, 1e-3);
+        BOOST_CHECK(matSG.IsEqualTo(matSGsparse, c_epsilonFloatE5));
+
+        SingleMatrix matGsparse(sparseGradients[step - 1].DeepClone());
+        matGsparse.SwitchToMatrixType(MatrixType::DENSE, matrixFormatDense, true);
+        BOOST_CHECK(gradients[step - 1].IsEqualTo(matGsparse, c_epsilonFloatE5));
+    }
+    for (auto timestamp : timestamps)
+        BOOST_CHECK_EQUAL(timestamp, (int)numSteps);
+}
+
+// tests the fused update of several parameters vs. the separate passes of a learner over each of them
+BOOST_FIXTURE_TEST_CASE(FusedLearnerUpdate, RandomSeedFixture)
+{
+    // the first parameter spans several chunks of the fused update
+    const std::vector<std::pair<size_t, size_t>> dims = { { 300, 200 }, { 17, 1 }, { 64, 33 } };
+    const size_t numSteps = 2;
+
+    for (auto kind : { FusedLearnerKind::SGD, FusedLearnerKind::MomentumSGD, FusedLearnerKind::Nesterov, FusedLearnerKind::AdaGrad, FusedLearnerKind::RmsProp, FusedLearnerKind::Adam })
+    {
+        for (bool truncation : { true, false })
+        {
+            FusedLearnerStep step;
+            step.kind = kind;
+            step.gradientScale = 0.5;
+            step.clippingThreshold = truncation ? 0.8 : 50; // the norm of the first gradient only is clipped
+            step.clippingWithTruncation = truncation;
+            step.l2Weight = 0.01;
+            step.l1Threshold = 0.001;
+            step.learningRate = 0.1;
+            step.momentum = 0.9;
+            step.unitGainFactor = 0.1;
+            step.varianceMomentum = 0.999;
+            step.epsilon = 1e-8;
+            step.needAveMultiplier = true;
+            step.rmsGamma = 0.99;
+            step.rmsInc = 1.2;
+            step.rmsDec = 0.75;
+            step.rmsMax = 10;
+            step.rmsMin = 0.1;
+            const size_t numStates = kind == FusedLearnerKind::SGD ? 0 : kind == FusedLearnerKind::Adam ? 2 : kind == FusedLearnerKind::RmsProp ? 3 : 1;
+
+            std::vector<SingleMatrix> values, fusedValues, states, fusedStates;
+            for (const auto& dim : dims)
+            {
+                values.push_back(SingleMatrix::RandomGaussian(dim.first, dim.second, CPUDEVICE, 0.0f, 1.0f, IncrementCounter()));
+                fusedValues.push_back(values.back().DeepClone());
+                states.push_back(SingleMatrix::Zeros(dim.first, numStates * dim.second, CPUDEVICE));
+                fusedStates.push_back(states.back().DeepClone());
+            }
+
+            for (size_t t = 1; t <= numSteps; t++)
+            {
+                step.initialized = t > 1;
+                step.biasCorrection = sqrt(1 - pow(step.varianceMomentum, t)) / (1 - pow(step.momentum, t));
+
+                std::vector<SingleMatrix> gradients;
+                for (size_t k = 0; k < dims.size(); k++)
+                {
+                    auto& value = values[k];
+                    auto& state = states[k];
+                    SingleMatrix gradient = SingleMatrix::RandomGaussian(dims[k].first, dims[k].second, CPUDEVICE, 0.0f, 1.0f, IncrementCounter());
+                    gradients.push_back(gradient.DeepClone());
+
+                    // LearnerBase::PreProcess()
+                    SingleMatrix::Scale((float)step.gradientScale, gradient);
+                    if (truncation)
+                        gradient.InplaceTruncate((float)step.clippingThreshold);
+                    else if (gradient.FrobeniusNorm() > step.clippingThreshold)
+                        gradient *= (float)(step.clippingThreshold / gradient.FrobeniusNorm());
+                    SingleMatrix::ScaleAndAdd((float)step.l2Weight, value, gradient);
+
+                    const auto learningRate = (float)step.learningRate;
+                    switch (kind)
+                    {
+                    case FusedLearnerKind::SGD:
+                        value.SGDUpdate(gradient, learningRate);
+                        break;
+                    case FusedLearnerKind::MomentumSGD:
+                        value.MomentumSGDUpdate(gradient, state, learningRate, (float)step.momentum, (float)step.unitGainFactor);
+                        break;
+                    case FusedLearnerKind::Nesterov:
+                        value.NesterovAcceleratedMomentumSGDUpdate(gradient, state, learningRate, (float)step.momentum, (float)step.unitGainFactor);
+                        break;
+                    case FusedLearnerKind::AdaGrad:
+                        SingleMatrix::ScaleAndAdd(-learningRate / state.Adagrad(gradient, true), gradient, value);
+                        break;
+                    case FusedLearnerKind::RmsProp:
+                        SingleMatrix::ScaleAndAdd(-learningRate / state.RmsProp(gradient, 0.99f, 1.2f, 10.0f, 0.75f, 0.1f, true, step.initialized), gradient, value);
+                        break;
+                    case FusedLearnerKind::Adam:
+                        state.AdamUpdate(gradient, value, (double)t, step.learningRate, step.momentum, step.varianceMomentum, step.epsilon, (float)step.unitGainFactor);
+                        break;
+                    }
+
+                    // LearnerBase::PostProcess()
+                    value.InplaceSoftThreshold((float)step.l1Threshold);
+                }
+
+                std::vector<SingleMatrix*> fusedValuePtrs, gradientPtrs, fusedStatePtrs;
+                for (size_t k = 0; k < dims.size(); k++)
+                {
+                    fusedValuePtrs.push_back(&fusedValues[k]);
+                    gradientPtrs.push_back(&gradients[k]);
+                    fusedStatePtrs.push_back(&fusedStates[k]);
+                }
+
+                SingleMatrix::FusedLearnerUpdate(step, fusedValuePtrs, gradientPtrs, fusedStatePtrs);
+
+                for (size_t k = 0; k < dims.size(); k++)
+                {
+                    BOOST_CHECK_MESSAGE(values[k].IsEqualTo(fusedValues[k], c_epsilonFloatE5), "values of parameter " << k << " differ, learner kind " << (int)kind << ", step " << t);
+                    BOOST_CHECK_MESSAGE(states[k].IsEqualTo(fusedStates[k], c_epsilonFloatE5), "states of parameter " << k << " differ, learner kind " << (int)kind << ", step " << t);
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }}}}
@@ -118,6 +118,43 @@ BOOST_FIXTURE_TEST_CASE(MatrixDeepCopy, RandomSeedFixture)
     BOOST_CHECK_EQUAL(b.GetNumCols(), 0);
 }
 
+BOOST_FIXTURE_TEST_CASE(MatrixArenaSlot, RandomSeedFixture)
+{
+    // a slot of 60 elements in the middle of an arena
+    SingleMatrix arena(100, 1, CPUDEVICE);
+    arena.SetValue(0);
+    float* slot = arena.Data() + 20;
+
+    SingleMatrix a(CPUDEVICE);
+    a.SetValue(60, 1, CPUDEVICE, slot, matrixFlagDontOwnBuffer | matrixFlagMayOutgrowBuffer);
+
+    // reshaped within the slot
+    a.Resize(5, 12);
+    BOOST_CHECK_EQUAL(a.GetNumRows(), 5);
+    BOOST_CHECK_EQUAL(a.GetNumCols(), 12);
+    BOOST_CHECK(a.Data() == slot);
+    a.SetValue(1);
+    BOOST_CHECK_EQUAL(arena(19, 0), 0);
+    BOOST_CHECK_EQUAL(arena(20, 0), 1);
+    BOOST_CHECK_EQUAL(arena(79, 0), 1);
+    BOOST_CHECK_EQUAL(arena(80, 0), 0);
+
+    // leaves the slot when growing beyond it, without touching the arena
+    a.Resize(10, 10);
+    BOOST_CHECK_EQUAL(a.GetNumRows(), 10);
+    BOOST_CHECK_EQUAL(a.GetNumCols(), 10);
+    BOOST_CHECK(a.Data() != slot);
+    BOOST_CHECK(a.OwnBuffer());
+    a.SetValue(2);
+    BOOST_CHECK_EQUAL(arena(20, 0), 1);
+    BOOST_CHECK_EQUAL(arena(99, 0), 0);
+
+    // other external buffers still cannot be resized
+    SingleMatrix b(CPUDEVICE);
+    b.SetValue(60, 1, CPUDEVICE, slot, matrixFlagDontOwnBuffer);
+    BOOST_CHECK_THROW(b.Resize(5, 12), std::logic_error);
+}
+
 BOOST_FIXTURE_TEST_CASE(MatrixInitZero, RandomSeedFixture)
 {
     SingleMatrix a = SingleMatrix::Zeros(12, 32, c_deviceIdZero);
@@ -3,8 +3,12 @@
 // Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
 //
 #include "stdafx.h"
+#include <cmath>
+#include <random>
+#include <thread>
 #include "../../../Source/Math/QuantizedOperations.h"
 #include "../../../Source/Math/Helpers.h"
+#include "../../../Source/Math/CPUMatrix.h"
 
 using namespace Microsoft::MSR::CNTK;
 namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
@@ -50,6 +54,167 @@ BOOST_FIXTURE_TEST_CASE(MultiplyIntToShort, RandomSeedFixture)
         BOOST_CHECK_EQUAL(round(C_upd[i]), C_expected_upd[i]);
 }
 
+static CPUMatrix<float> RandomMatrix(size_t rows, size_t cols, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1, 1);
+    CPUMatrix<float> a(rows, cols);
+    for (size_t i = 0; i < a.GetNumElements(); i++)
+        a.Data()[i] = dist(rng);
+    return a;
+}
+
+BOOST_FIXTURE_TEST_CASE(Int8MultiplyIsExactOnQuantizedValues, RandomSeedFixture)
+{
+    // The int8 kernels must compute the dot products of the quantized rows exactly, for all
+    // inner dimensions, including those that are not a multiple of the SIMD width.
+    std::mt19937 rng(1);
+    for (size_t k : { 1, 31, 32, 33, 100 })
+    {
+        const size_t m = 13, n = 6;
+        CPUMatrix<float> a = RandomMatrix(m, k, rng), b = RandomMatrix(k, n, rng);
+        Int8QuantizedRows rowsA, rowsB;
+        QuantizeRowsToInt8(a.Data(), m, k, 1, m, rowsA);
+        QuantizeRowsToInt8(b.Data(), n, k, k, 1, rowsB);
+
+        std::vector<float> c(m * n);
+        Int8MultiplyAndWeightedAdd(rowsA, rowsB, 1.0f, 0.0f, c.data(), m);
+        for (size_t i = 0; i < m; i++)
+            for (size_t j = 0; j < n; j++)
+            {
+                int dot = 0;
+                for (size_t l = 0; l < k; l++)
+                {
+                    BOOST_REQUIRE_LE(std::abs((int)rowsA.values[i * rowsA.stride + l]), 127);
+                    dot += rowsA.values[i * rowsA.stride + l] * rowsB.values[j * rowsB.stride + l];
+                }
+                float expected = (float)((double)rowsA.scales[i] * rowsB.scales[j] * dot);
+                BOOST_REQUIRE_SMALL(c[i + j * m] - expected, 1e-6f * std::max(1.0f, std::fabs(expected)));
+            }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(QuantizeRowsToInt8RoundsHalvesAwayFromZero, RandomSeedFixture)
+{
+    // With an absolute maximum of 127 the values are not scaled, so all others are exactly x.5. They must be rounded
+    // the same way in the vectorized body (the first 32 values), in its tail, and by the scalar code used for strided rows.
+    const size_t k = 45;
+    std::vector<float> row(k), stridedRow(2 * k, 0.0f);
+    std::vector<int> expected(k);
+    row[0] = 127;
+    expected[0] = 127;
+    for (size_t l = 1; l < k; l++)
+    {
+        float magnitude = (l % 16) + 0.5f;
+        row[l] = l % 2 ? -magnitude : magnitude;
+        expected[l] = (l % 2 ? -1 : 1) * ((int)magnitude + 1);
+    }
+    for (size_t l = 0; l < k; l++)
+        stridedRow[2 * l] = row[l];
+
+    Int8QuantizedRows contiguous, strided;
+    QuantizeRowsToInt8(row.data(), 1, k, k, 1, contiguous);
+    QuantizeRowsToInt8(stridedRow.data(), 1, k, 2 * k, 2, strided);
+    BOOST_CHECK_EQUAL(contiguous.scales[0], 1.0f);
+    for (size_t l = 0; l < k; l++)
+    {
+        BOOST_CHECK_EQUAL((int)contiguous.values[l], expected[l]);
+        BOOST_CHECK_EQUAL((int)strided.values[l], expected[l]);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(Int8MultiplyMatchesFloatProduct, RandomSeedFixture)
+{
+    // C = alpha * op(A) * op(B) + beta * C through CPUMatrix, against the full precision product.
+    // With per-row scales, each quantized element is off by at most half a step, scale / 2.
+    std::mt19937 rng(2);
+    const size_t m = 37, n = 21, k = 70;
+    const float alpha = 0.5f, beta = 2.0f;
+    for (bool transposeA : { false, true })
+        for (bool transposeB : { false, true })
+        {
+            CPUMatrix<float> a = transposeA ? RandomMatrix(k, m, rng) : RandomMatrix(m, k, rng);
+            CPUMatrix<float> b = transposeB ? RandomMatrix(n, k, rng) : RandomMatrix(k, n, rng);
+            CPUMatrix<float> c0 = RandomMatrix(m, n, rng);
+            CPUMatrix<float> expected(c0), actual(c0);
+            CPUMatrix<float>::MultiplyAndWeightedAdd(alpha, a, transposeA, b, transposeB, beta, expected);
+            auto mult = make_shared<Int8QuantizedMultiplier<float>>(true, false);
+            CPUMatrix<float>::MultiplyAndWeightedAdd(alpha, a, transposeA, b, transposeB, beta, actual, mult);
+
+            for (size_t i = 0; i < m; i++)
+                for (size_t j = 0; j < n; j++)
+                {
+                    double maxA = 0, maxB = 0;
+                    for (size_t l = 0; l < k; l++)
+                    {
+                        maxA = std::max(maxA, (double)std::fabs(transposeA ? a(l, i) : a(i, l)));
+                        maxB = std::max(maxB, (double)std::fabs(transposeB ? b(j, l) : b(l, j)));
+                    }
+                    double bound = alpha * k * maxA * maxB * (1.0 / 127 + 1.0 / (254 * 254)) + 1e-5;
+                    BOOST_REQUIRE_SMALL((double)actual(i, j) - expected(i, j), bound);
+                }
+        }
+}
+
+BOOST_FIXTURE_TEST_CASE(Int8MultiplierQuantizesConstantOnce, RandomSeedFixture)
+{
+    std::mt19937 rng(3);
+    const size_t m = 8, n = 5, k = 40;
+    CPUMatrix<float> a = RandomMatrix(m, k, rng), b = RandomMatrix(k, n, rng);
+    CPUMatrix<float> c1(m, n), c2(m, n), c3(m, n);
+
+    // A is constant: a change of its values after the first product is not seen
+    auto mult = make_shared<Int8QuantizedMultiplier<float>>(true, false);
+    CPUMatrix<float>::MultiplyAndWeightedAdd(1, a, false, b, false, 0, c1, mult);
+    CPUMatrix<float> a0(a);
+    a.SetValue(0);
+    CPUMatrix<float>::MultiplyAndWeightedAdd(1, a, false, b, false, 0, c2, mult);
+    BOOST_CHECK(c1.IsEqualTo(c2, 0));
+
+    // B is not constant: it is quantized again on every call
+    CPUMatrix<float> b2 = RandomMatrix(k, n, rng);
+    CPUMatrix<float>::MultiplyAndWeightedAdd(1, a, false, b2, false, 0, c2, mult);
+    auto fresh = make_shared<Int8QuantizedMultiplier<float>>(true, false);
+    CPUMatrix<float>::MultiplyAndWeightedAdd(1, a0, false, b2, false, 0, c3, fresh);
+    BOOST_CHECK(c2.IsEqualTo(c3, 0));
+}
+
+BOOST_FIXTURE_TEST_CASE(Int8MultiplierSharedByConcurrentEvaluations, RandomSeedFixture)
+{
+    // Each thread multiplies the constant A by its own B through the same multiplier, as concurrent
+    // evaluations of a network do, and must get the product of a multiplier of its own.
+    std::mt19937 rng(4);
+    const size_t m = 16, n = 9, k = 64, numThreads = 4, numIterations = 50;
+    CPUMatrix<float> a = RandomMatrix(m, k, rng);
+    std::vector<CPUMatrix<float>> bs, expected;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        bs.push_back(RandomMatrix(k, n, rng));
+        expected.push_back(CPUMatrix<float>(m, n));
+        CPUMatrix<float>::MultiplyAndWeightedAdd(1, a, false, bs[t], false, 0, expected[t], make_shared<Int8QuantizedMultiplier<float>>(true, false));
+    }
+
+    auto mult = make_shared<Int8QuantizedMultiplier<float>>(true, false);
+    std::vector<int> matches(numThreads, 1); // not vector<bool>, whose elements share bytes
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            CPUMatrix<float> c(m, n);
+            for (size_t i = 0; i < numIterations; i++)
+            {
+                CPUMatrix<float>::MultiplyAndWeightedAdd(1, a, false, bs[t], false, 0, c, mult);
+                if (!c.IsEqualTo(expected[t], 0))
+                    matches[t] = 0;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (size_t t = 0; t < numThreads; t++)
+        BOOST_CHECK(matches[t]);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,106 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+
+#include "../../../Source/SGDLib/GradientBuckets.h"
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// The tests run on one worker, so the aggregated gradients equal the local ones.
+static MPIWrapperPtr GetMpi()
+{
+    auto mpi = MPIWrapper::GetInstance();
+    return mpi ? mpi : MPIWrapper::GetInstance(/*create=*/true);
+}
+
+// Gradients of 2, 3, 1000 and 4 elements; with a 64-byte bucket size, the first two share a bucket and the
+// others are reduced in place.
+static vector<unique_ptr<Matrix<float>>> CreateGradients(float value)
+{
+    vector<unique_ptr<Matrix<float>>> gradients;
+    for (size_t numElements : { 2, 3, 1000, 4 })
+    {
+        gradients.push_back(make_unique<Matrix<float>>(numElements, 1, CPUDEVICE));
+        gradients.back()->SetValue(value);
+    }
+    return gradients;
+}
+
+static vector<Matrix<float>*> GetPointers(const vector<unique_ptr<Matrix<float>>>& gradients)
+{
+    vector<Matrix<float>*> pointers;
+    for (const auto& gradient : gradients)
+        pointers.push_back(gradient.get());
+    return pointers;
+}
+
+static void CheckValue(const vector<unique_ptr<Matrix<float>>>& gradients, float value)
+{
+    for (const auto& gradient : gradients)
+    {
+        unique_ptr<float[]> data(gradient->CopyToArray());
+        for (size_t i = 0; i < gradient->GetNumElements(); i++)
+            BOOST_REQUIRE_EQUAL(data[i], value);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(GradientBucketsTestSuite)
+
+BOOST_AUTO_TEST_CASE(GradientBucketsOverlapped)
+{
+    auto gradients = CreateGradients(1);
+    GradientBuckets<float> buckets(GetMpi(), 64);
+    buckets.Initialize(GetPointers(gradients));
+
+    for (int iteration = 0; iteration < 2; iteration++)
+    {
+        buckets.Begin();
+        for (size_t i = gradients.size(); i-- > 0;)
+        {
+            gradients[i]->SetValue((float)(iteration + 2));
+            buckets.GradientReady(i);
+        }
+        BOOST_CHECK(buckets.AnyStarted());
+        buckets.Complete(false);
+        CheckValue(gradients, (float)(iteration + 2));
+    }
+}
+
+// Sub-minibatches are accumulated into the gradients after each backprop, so the aggregation must only start after
+// the last one, as SGD does by not overlapping then. A gradient reported ready again may be in flight already.
+BOOST_AUTO_TEST_CASE(GradientBucketsSubminibatches)
+{
+    auto gradients = CreateGradients(0);
+    GradientBuckets<float> buckets(GetMpi(), 64);
+    buckets.Initialize(GetPointers(gradients));
+
+    // overlapped: every backprop reports the gradients
+    buckets.Begin();
+    for (size_t i = gradients.size(); i-- > 0;)
+        buckets.GradientReady(i);
+    BOOST_CHECK_THROW(buckets.GradientReady(gradients.size() - 1), std::logic_error);
+    buckets.Complete(false);
+
+    // not overlapped: the accumulated gradients are packed by StartRemaining()
+    for (const auto& gradient : gradients)
+        gradient->SetValue(0);
+    for (int subminibatch = 0; subminibatch < 3; subminibatch++)
+    {
+        for (const auto& gradient : gradients)
+            *gradient += 1;
+    }
+    buckets.StartRemaining();
+    BOOST_CHECK(buckets.AnyStarted());
+    buckets.Complete(false);
+    CheckValue(gradients, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
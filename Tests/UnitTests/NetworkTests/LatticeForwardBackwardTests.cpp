@@ -0,0 +1,146 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+
+#include "simple_checked_arrays.h"
+#include "latticearchive.h"
+#include <random>
+
+using namespace std;
+
+namespace msra { namespace lattices {
+
+// Builds random lattices and runs the lattice-level forward-backward on them, with access to the private members of lattice.
+class LatticeTestRunner
+{
+    lattice m_lattice;
+    vector<float> m_edgeacscores;
+    vector<size_t> m_uids;
+    unique_ptr<lattice::edgealignments> m_alignments;
+
+public:
+    // results of one forward-backward pass
+    struct Result
+    {
+        vector<double> logpps, logalphas, logbetas, logEframescorrect, Eframescorrectbuf;
+        double logEframescorrecttotal = 0;
+        double totalscore = 0;
+    };
+
+    // A lattice over numnodes nodes with increasing times. Each node is reached from its predecessor, and from up to
+    // three earlier nodes. Edges are sorted by end node, then by start node, as in lattices read from archives.
+    LatticeTestRunner(size_t numnodes, unsigned int seed)
+    {
+        mt19937 rng(seed);
+        uniform_int_distribution<size_t> framesDist(1, 4);
+        uniform_int_distribution<size_t> senoneDist(0, 5);
+        uniform_real_distribution<float> lmDist(-4.0f, 0.0f);
+        uniform_real_distribution<float> acDist(-30.0f, -1.0f);
+        bernoulli_distribution extraEdgeDist(0.5);
+
+        auto& nodes = m_lattice.nodes;
+        auto& edges = m_lattice.edges;
+        size_t t = 0;
+        nodes.push_back(nodeinfo(t));
+        for (size_t i = 1; i < numnodes; i++)
+        {
+            t += framesDist(rng);
+            nodes.push_back(nodeinfo(t));
+        }
+        for (size_t e = 1; e < numnodes; e++)
+        {
+            for (size_t s = e >= 4 ? e - 4 : 0; s < e; s++)
+            {
+                if (s + 1 == e || extraEdgeDist(rng))
+                {
+                    edges.push_back(edgeinfowithscores(s, e, 0.0f, lmDist(rng), 0));
+                    m_edgeacscores.push_back(acDist(rng) * (nodes[e].t - nodes[s].t));
+                }
+            }
+        }
+        m_lattice.info.numnodes = nodes.size();
+        m_lattice.info.numedges = edges.size();
+        m_lattice.info.numframes = t;
+
+        // reference senones, and edge alignments that match them in some of the frames
+        for (size_t k = 0; k < t; k++)
+            m_uids.push_back(senoneDist(rng));
+        m_alignments.reset(new lattice::edgealignments(m_lattice));
+        for (size_t j = 0; j < edges.size(); j++)
+        {
+            auto alignment = (*m_alignments)[j];
+            for (size_t k = 0; k < alignment.size(); k++)
+                alignment[k] = (unsigned short) senoneDist(rng);
+        }
+    }
+
+    size_t NumEdges() const { return m_lattice.edges.size(); }
+
+    // the native CPU version; fails if the lattice is not sorted as it requires
+    Result Native(bool sMBRmode)
+    {
+        Result result;
+        const_array_ref<size_t> uids(m_uids.data(), m_uids.size());
+        bool sorted = m_lattice.cpuforwardbackwardlattice(m_edgeacscores, result.logpps, result.logalphas, result.logbetas, 1.0f, -0.5f, 2.0f, sMBRmode, uids, *m_alignments,
+                                                          result.logEframescorrect, result.Eframescorrectbuf, result.logEframescorrecttotal, result.totalscore);
+        BOOST_REQUIRE(sorted);
+        return result;
+    }
+
+    // the edge-serial version
+    Result EdgeSerial(bool sMBRmode)
+    {
+        Result result;
+        const_array_ref<size_t> uids(m_uids.data(), m_uids.size());
+        result.totalscore = m_lattice.edgeserialforwardbackwardlattice(m_edgeacscores, result.logpps, result.logalphas, result.logbetas, 1.0f, -0.5f, 2.0f, sMBRmode, uids, *m_alignments,
+                                                                       result.logEframescorrect, result.Eframescorrectbuf, result.logEframescorrecttotal);
+        return result;
+    }
+};
+
+} }
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+using msra::lattices::LatticeTestRunner;
+
+static void CheckClose(const vector<double>& actual, const vector<double>& expected, double tolerance)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_SMALL(actual[i] - expected[i], tolerance * (1 + fabs(expected[i])));
+}
+
+BOOST_AUTO_TEST_SUITE(LatticeForwardBackwardTestSuite)
+
+// The native CPU forward-backward computes the same scores as the edge-serial one.
+BOOST_AUTO_TEST_CASE(LatticeForwardBackwardMatchesEdgeSerial)
+{
+    const double tolerance = 1e-12;
+    for (unsigned int seed = 0; seed < 10; seed++)
+    {
+        LatticeTestRunner runner(/*numnodes=*/5 + 20 * seed, seed);
+        for (bool sMBRmode : { false, true })
+        {
+            auto native = runner.Native(sMBRmode);
+            auto edgeSerial = runner.EdgeSerial(sMBRmode);
+
+            BOOST_CHECK_SMALL(native.totalscore - edgeSerial.totalscore, tolerance * (1 + fabs(edgeSerial.totalscore)));
+            CheckClose(native.logalphas, edgeSerial.logalphas, tolerance);
+            CheckClose(native.logbetas, edgeSerial.logbetas, tolerance);
+            CheckClose(native.logpps, edgeSerial.logpps, tolerance);
+            if (sMBRmode)
+            {
+                BOOST_CHECK_SMALL(native.logEframescorrecttotal - edgeSerial.logEframescorrecttotal, tolerance * (1 + fabs(edgeSerial.logEframescorrecttotal)));
+                CheckClose(native.logEframescorrect, edgeSerial.logEframescorrect, tolerance);
+                CheckClose(native.Eframescorrectbuf, edgeSerial.Eframescorrectbuf, tolerance);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,250 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include "../../../Source/SGDLib/SGD.h"
+#include <limits>
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+const DEVICEID_TYPE c_deviceId = CPUDEVICE;
+
+// Gives access to the loss scaling state and the update steps of SGD.
+template <class ElemType>
+class SGDTestRunner
+{
+    SGD<ElemType> m_sgd;
+
+    static ConfigParameters Config(const string& config)
+    {
+        ConfigParameters parameters;
+        parameters.Parse("modelPath=lossScalingTest.model\nlearningRatesPerSample=0.1\n" + config);
+        return parameters;
+    }
+
+public:
+    SGDTestRunner(const string& config)
+        : m_sgd(Config(config))
+    {
+    }
+
+    double LossScale() const { return m_sgd.m_lossScale; }
+    size_t NumMBsSinceLossScaleChange() const { return m_sgd.m_numMBsSinceLossScaleChange; }
+
+    // a plain SGD step with L2 regularization, as TrainOneEpoch() does it for one parameter
+    void UpdateWeights(Matrix<ElemType>& value, Matrix<ElemType>& gradient, size_t numSamples)
+    {
+        auto smoothedGradient = make_shared<Matrix<ElemType>>(value.GetNumRows(), value.GetNumCols(), c_deviceId);
+        smoothedGradient->SetValue(0);
+        MatrixBasePtr smoothedGradientBase = smoothedGradient;
+        double smoothedCount = 0;
+        m_sgd.UpdateWeights(value, gradient, smoothedGradientBase, smoothedCount, /*learnRatePerSample=*/0.1, /*momentumPerSample=*/0, numSamples,
+                            /*L2RegWeight=*/0.01, /*L1RegWeight=*/0, /*needAveMultiplier=*/true, /*useNesterovMomentum=*/false);
+    }
+
+    bool GradientsHaveNanOrInf(const list<ComputationNodeBasePtr>& learnableNodes) const { return m_sgd.GradientsHaveNanOrInf(learnableNodes); }
+    void UpdateLossScale(bool gradientsOverflowed) { m_sgd.UpdateLossScale(gradientsOverflowed); }
+
+    void SaveCheckPoint()
+    {
+        m_sgd.SaveCheckPointInfo(/*epoch=*/0, /*totalSamplesSeen=*/0, /*learnRatePerSample=*/0.1, SmoothedGradients(), vector<double>{ 0 }, /*prevCriterion=*/0, /*minibatchSize=*/1);
+    }
+
+    void LoadCheckPoint()
+    {
+        size_t totalSamplesSeen, minibatchSize;
+        double learnRatePerSample, prevCriterion;
+        auto smoothedGradients = SmoothedGradients();
+        vector<double> smoothedCounts{ 0 };
+        m_sgd.LoadCheckPointInfo(/*epochNumber=*/0, totalSamplesSeen, learnRatePerSample, smoothedGradients, smoothedCounts, prevCriterion, minibatchSize);
+    }
+
+    void DeleteCheckPoint()
+    {
+        _wunlink(m_sgd.GetCheckPointFileNameForEpoch(0).c_str());
+    }
+
+private:
+    static list<MatrixBasePtr> SmoothedGradients()
+    {
+        auto smoothedGradient = make_shared<Matrix<ElemType>>(1, 1, c_deviceId);
+        smoothedGradient->SetValue(0);
+        return { smoothedGradient };
+    }
+};
+
+// A network W * x with the squared error against y as training criterion.
+struct LossScalingTestNetwork
+{
+    ComputationNetworkPtr net;
+    shared_ptr<ComputationNode<float>> x, y, w;
+    ComputationNodeBasePtr criterion;
+    static const size_t numSamples = 4;
+
+    LossScalingTestNetwork()
+    {
+        const size_t inputDim = 3, outputDim = 2;
+        net = make_shared<ComputationNetwork>(c_deviceId);
+        ComputationNetworkBuilder<float> builder(*net);
+        x = builder.CreateInputNode(L"x", inputDim);
+        y = builder.CreateInputNode(L"y", outputDim);
+        w = builder.CreateLearnableParameter(L"W", outputDim, inputDim);
+        criterion = builder.SquareError(y, builder.Times(w, x), L"criterion");
+        net->AddToNodeGroup(L"criterion", criterion);
+        net->CompileNetwork();
+
+        vector<float> weights(outputDim * inputDim);
+        for (size_t k = 0; k < weights.size(); k++)
+            weights[k] = 0.1f * k - 0.3f;
+        w->Value().SetValue(outputDim, inputDim, c_deviceId, weights.data());
+        net->AllocateAllMatrices({}, {}, criterion);
+
+        vector<float> xData(inputDim * numSamples);
+        vector<float> yData(outputDim * numSamples);
+        for (size_t k = 0; k < xData.size(); k++)
+            xData[k] = (float)((k * 7) % 11) / 11 - 0.5f;
+        for (size_t k = 0; k < yData.size(); k++)
+            yData[k] = (float)((k * 5) % 3) - 1;
+        net->GetMBLayoutPtrOfNetwork()->InitAsFrameMode(numSamples);
+        x->Value().SetValue(inputDim, numSamples, c_deviceId, xData.data());
+        y->Value().SetValue(outputDim, numSamples, c_deviceId, yData.data());
+    }
+
+    // Computes the gradient of W with the given loss scale.
+    Matrix<float> Gradient(double lossScale)
+    {
+        ScopedNetworkOperationMode modeGuard(net, NetworkOperationMode::training);
+        net->StartEvaluateMinibatchLoop(criterion);
+        ComputationNetwork::BumpEvalTimeStamp(vector<ComputationNodeBasePtr>{ x, y });
+        net->SetLossScale(lossScale);
+        net->ForwardProp(criterion);
+        net->Backprop(criterion);
+        net->SetLossScale(1);
+        return w->Gradient().DeepClone();
+    }
+};
+
+static void CheckClose(const Matrix<float>& actual, const Matrix<float>& expected, float tolerance)
+{
+    BOOST_REQUIRE_EQUAL(actual.GetNumRows(), expected.GetNumRows());
+    BOOST_REQUIRE_EQUAL(actual.GetNumCols(), expected.GetNumCols());
+    for (size_t i = 0; i < expected.GetNumRows(); i++)
+        for (size_t j = 0; j < expected.GetNumCols(); j++)
+            BOOST_CHECK_SMALL(actual(i, j) - expected(i, j), tolerance);
+}
+
+BOOST_AUTO_TEST_SUITE(LossScalingTestSuite)
+
+// Backprop seeds the root gradient with the loss scale, so all gradients come out scaled by it.
+BOOST_AUTO_TEST_CASE(BackpropScalesGradients)
+{
+    LossScalingTestNetwork network;
+    Matrix<float> gradient = network.Gradient(1);
+    Matrix<float> scaledGradient = network.Gradient(1024);
+
+    Matrix<float> expected = gradient.DeepClone();
+    Matrix<float>::Scale(1024.0f, expected);
+    CheckClose(scaledGradient, expected, 1e-3f);
+}
+
+// SGD undoes the loss scale before clipping, regularization and the update, so the update does not change.
+BOOST_AUTO_TEST_CASE(UpdateUnscalesGradients)
+{
+    LossScalingTestNetwork network;
+    SGDTestRunner<float> reference("");
+    SGDTestRunner<float> scaled("lossScale=1024");
+    BOOST_REQUIRE_EQUAL(scaled.LossScale(), 1024);
+
+    Matrix<float> referenceValue = network.w->Value().DeepClone();
+    Matrix<float> referenceGradient = network.Gradient(reference.LossScale());
+    reference.UpdateWeights(referenceValue, referenceGradient, network.numSamples);
+
+    Matrix<float> scaledValue = network.w->Value().DeepClone();
+    Matrix<float> scaledGradient = network.Gradient(scaled.LossScale());
+    scaled.UpdateWeights(scaledValue, scaledGradient, network.numSamples);
+
+    CheckClose(scaledValue, referenceValue, 1e-6f);
+}
+
+// With dynamic loss scaling, overflowing gradients are detected, which skips the update, and the loss scale backs off.
+BOOST_AUTO_TEST_CASE(OverflowBacksOffLossScale)
+{
+    LossScalingTestNetwork network;
+    SGDTestRunner<float> sgd("dynamicLossScaling=true\nlossScale=4\nlossScaleGrowthInterval=3");
+    list<ComputationNodeBasePtr> learnableNodes{ network.w };
+
+    network.Gradient(sgd.LossScale());
+    BOOST_CHECK(!sgd.GradientsHaveNanOrInf(learnableNodes));
+    sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 4);
+    BOOST_CHECK_EQUAL(sgd.NumMBsSinceLossScaleChange(), 1);
+
+    for (float overflow : { numeric_limits<float>::infinity(), numeric_limits<float>::quiet_NaN() })
+    {
+        network.Gradient(sgd.LossScale());
+        network.w->Gradient().SetValue(0, 1, overflow);
+        BOOST_CHECK(sgd.GradientsHaveNanOrInf(learnableNodes));
+        sgd.UpdateLossScale(true);
+        BOOST_CHECK_EQUAL(sgd.NumMBsSinceLossScaleChange(), 0);
+    }
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 1);
+
+    // the loss scale does not go below 1
+    sgd.UpdateLossScale(true);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 1);
+}
+
+// The loss scale doubles after lossScaleGrowthInterval minibatches without overflow, up to 2^24.
+BOOST_AUTO_TEST_CASE(LossScaleRegrows)
+{
+    SGDTestRunner<float> sgd("dynamicLossScaling=true\nlossScale=4\nlossScaleGrowthInterval=3");
+    sgd.UpdateLossScale(false);
+    sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 4);
+    sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 8);
+    BOOST_CHECK_EQUAL(sgd.NumMBsSinceLossScaleChange(), 0);
+
+    // an overflow restarts the interval
+    sgd.UpdateLossScale(false);
+    sgd.UpdateLossScale(true);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 4);
+    sgd.UpdateLossScale(false);
+    sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 4);
+    sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 8);
+
+    for (size_t i = 0; i < 3 * 30; i++)
+        sgd.UpdateLossScale(false);
+    BOOST_CHECK_EQUAL(sgd.LossScale(), 16777216);
+}
+
+// The checkpoint keeps the dynamic loss scale, so that training resumes with it rather than with the initial one.
+BOOST_AUTO_TEST_CASE(CheckpointKeepsLossScale)
+{
+    const string config = "dynamicLossScaling=true\nlossScale=64\nlossScaleGrowthInterval=3";
+    SGDTestRunner<float> sgd(config);
+    sgd.UpdateLossScale(true);
+    sgd.UpdateLossScale(false);
+    sgd.SaveCheckPoint();
+
+    SGDTestRunner<float> resumed(config);
+    BOOST_REQUIRE_EQUAL(resumed.LossScale(), 64);
+    resumed.LoadCheckPoint();
+    BOOST_CHECK_EQUAL(resumed.LossScale(), 32);
+    BOOST_CHECK_EQUAL(resumed.NumMBsSinceLossScaleChange(), 1);
+    resumed.DeleteCheckPoint();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,104 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+
+#include "../../../Source/ComputationNetworkLib/ComputationNetwork.h"
+#include "../../../Source/ComputationNetworkLib/ComputationNetworkBuilder.h"
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+const DEVICEID_TYPE c_deviceId = CPUDEVICE;
+
+// A network Tanh(W * x) with the squared error against y as training criterion, with or without the memory arena.
+struct ArenaTestNetwork
+{
+    ComputationNetworkPtr net;
+    shared_ptr<ComputationNode<float>> x, y, w;
+    ComputationNodeBasePtr criterion;
+
+    ArenaTestNetwork(bool useArena)
+    {
+        const size_t inputDim = 3, outputDim = 2;
+        net = make_shared<ComputationNetwork>(c_deviceId);
+        ComputationNetworkBuilder<float> builder(*net);
+        x = builder.CreateInputNode(L"x", inputDim);
+        y = builder.CreateInputNode(L"y", outputDim);
+        w = builder.CreateLearnableParameter(L"W", outputDim, inputDim);
+        criterion = builder.SquareError(y, builder.Tanh(builder.Times(w, x), L"h"), L"criterion");
+        net->AddToNodeGroup(L"criterion", criterion);
+        net->CompileNetwork();
+
+        vector<float> weights(outputDim * inputDim);
+        for (size_t k = 0; k < weights.size(); k++)
+            weights[k] = 0.1f * k - 0.3f;
+        w->Value().SetValue(outputDim, inputDim, c_deviceId, weights.data());
+
+        bool wasUsingArena = Globals::ShouldUseMemoryArena();
+        Globals::SetMemoryArena(useArena);
+        net->AllocateAllMatrices({}, {}, criterion);
+        Globals::SetMemoryArena(wasUsingArena);
+    }
+
+    // Computes the gradient of W for a minibatch of numSamples samples.
+    void ForwardBackward(size_t numSamples)
+    {
+        vector<float> xData(x->GetSampleLayout().GetNumElements() * numSamples);
+        vector<float> yData(y->GetSampleLayout().GetNumElements() * numSamples);
+        for (size_t k = 0; k < xData.size(); k++)
+            xData[k] = (float)((k * 7) % 11) / 11 - 0.5f;
+        for (size_t k = 0; k < yData.size(); k++)
+            yData[k] = (float)((k * 5) % 3) - 1;
+
+        net->GetMBLayoutPtrOfNetwork()->InitAsFrameMode(numSamples);
+        x->Value().SetValue(x->GetSampleLayout().GetNumElements(), numSamples, c_deviceId, xData.data());
+        y->Value().SetValue(y->GetSampleLayout().GetNumElements(), numSamples, c_deviceId, yData.data());
+        ComputationNetwork::BumpEvalTimeStamp(vector<ComputationNodeBasePtr>{ x, y });
+
+        net->ForwardProp(criterion);
+        net->Backprop(criterion);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(MemoryArenaTestSuite)
+
+// The arena is planned again after the backprop of every minibatch that is larger than the ones before.
+// The parameter gradient must survive that, in the matrix that SGD looked up at the start of training.
+BOOST_AUTO_TEST_CASE(TrainAcrossArenaReplanning)
+{
+    ArenaTestNetwork reference(/*useArena=*/false);
+    ArenaTestNetwork test(/*useArena=*/true);
+    ScopedNetworkOperationMode referenceMode(reference.net, NetworkOperationMode::training);
+    ScopedNetworkOperationMode testMode(test.net, NetworkOperationMode::training);
+    reference.net->StartEvaluateMinibatchLoop(reference.criterion);
+    test.net->StartEvaluateMinibatchLoop(test.criterion);
+
+    Matrix<float>* referenceGradient = &reference.w->Gradient();
+    Matrix<float>* testGradient = &test.w->Gradient();
+    for (size_t numSamples : { 2, 7, 3, 12, 5 })
+    {
+        reference.ForwardBackward(numSamples);
+        test.ForwardBackward(numSamples);
+
+        BOOST_REQUIRE(&test.w->Gradient() == testGradient);
+        BOOST_CHECK_SMALL(test.criterion->Get00Element() - reference.criterion->Get00Element(), 1e-5);
+        Matrix<float> expected = referenceGradient->DeepClone();
+        Matrix<float> actual = testGradient->DeepClone();
+        for (size_t i = 0; i < expected.GetNumRows(); i++)
+            for (size_t j = 0; j < expected.GetNumCols(); j++)
+                BOOST_CHECK_SMALL(actual(i, j) - expected(i, j), 1e-5f);
+
+        // SGD step through the matrices looked up before training
+        Matrix<float>::ScaleAndAdd(-0.1f, *referenceGradient, reference.w->Value());
+        Matrix<float>::ScaleAndAdd(-0.1f, *testGradient, test.w->Value());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -0,0 +1,223 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+
+#include "../../../Source/ComputationNetworkLib/TrainingNodes.h"
+#include "../../../Source/ComputationNetworkLib/InputAndParamNodes.h"
+#include "TestHelpers.h"
+#include <memory>
+
+using namespace Microsoft::MSR::CNTK;
+using namespace std;
+
+namespace Microsoft { namespace MSR { namespace CNTK { namespace Test {
+
+// Sampling is done on the CPU, and the rest of the node only uses generic matrix operations.
+const DEVICEID_TYPE c_deviceId = CPUDEVICE;
+
+// Extends the sampled softmax node to provide access to protected members.
+template <class ElemType>
+class SampledCrossEntropyWithSoftmaxNodeTest : public SampledCrossEntropyWithSoftmaxNode<ElemType>
+{
+public:
+    SampledCrossEntropyWithSoftmaxNodeTest(size_t sizeOfSampledSet)
+        : SampledCrossEntropyWithSoftmaxNode<ElemType>(c_deviceId, L"SampledCrossEntropyWithSoftmaxNodeTest", sizeOfSampledSet)
+    {
+    }
+
+    // Allocates the matrices that otherwise come from the matrix pool.
+    void AllocMatrices()
+    {
+        this->CreateValueMatrixIfNull();
+        this->CreateGradientMatrixIfNull();
+        this->Value().Resize(1, 1);
+        this->Gradient().Resize(1, 1);
+        this->Gradient().SetValue(1);
+        this->CreateMatrixIfNull(this->m_sampledWeights);
+        this->CreateMatrixIfNull(this->m_labelWeights);
+        this->CreateMatrixIfNull(this->m_logits);
+        this->CreateMatrixIfNull(this->m_labelLogitGradient);
+        this->CreateMatrixIfNull(this->m_sampledLogitsGradient);
+        this->CreateMatrixIfNull(this->m_weightsGradientTemp);
+    }
+
+    // The classes drawn by the last forward pass.
+    vector<size_t> GetSamples()
+    {
+        Matrix<ElemType> selection = this->m_sampleSelection->DeepClone();
+        selection.SwitchToMatrixType(DENSE, matrixFormatDense, true);
+        vector<size_t> samples;
+        for (size_t j = 0; j < selection.GetNumCols(); j++)
+            for (size_t i = 0; i < selection.GetNumRows(); i++)
+                if (selection(i, j) != 0)
+                    samples.push_back(i);
+        return samples;
+    }
+};
+
+// Dense copy of a matrix on the CPU.
+template <class ElemType>
+Matrix<ElemType> ToDense(const Matrix<ElemType>& m)
+{
+    Matrix<ElemType> dense = m.DeepClone();
+    if (dense.GetMatrixType() != DENSE)
+        dense.SwitchToMatrixType(DENSE, matrixFormatDense, true);
+    return dense;
+}
+
+template <class ElemType>
+void SampledSoftmaxForwardBackwardTestImpl(bool sparseLabels)
+{
+    const size_t inputDim = 3;
+    const size_t numClasses = 7;
+    const size_t numSamples = 5;
+    const size_t minibatchSize = 4;
+    const size_t labelClasses[minibatchSize] = { 1, 6, 0, 1 };
+
+    vector<ElemType> labelsData(numClasses * minibatchSize, 0);
+    vector<ElemType> inputData(inputDim * minibatchSize);
+    vector<ElemType> weightsData(inputDim * numClasses);
+    vector<ElemType> samplingWeightsData(numClasses);
+    for (size_t t = 0; t < minibatchSize; t++)
+        labelsData[t * numClasses + labelClasses[t]] = 1;
+    for (size_t k = 0; k < inputData.size(); k++)
+        inputData[k] = (ElemType)(0.1 * ((k * 7) % 11) - 0.5);
+    for (size_t k = 0; k < weightsData.size(); k++)
+        weightsData[k] = (ElemType)(0.2 * ((k * 5) % 9) - 0.8);
+    for (size_t k = 0; k < numClasses; k++)
+        samplingWeightsData[k] = (ElemType)(k % 3 + 1);
+
+    shared_ptr<ComputationNode<ElemType>> labels = make_shared<DummyNodeTest<ElemType>>(c_deviceId, minibatchSize, SmallVector<size_t>{ numClasses }, labelsData);
+    shared_ptr<ComputationNode<ElemType>> input = make_shared<DummyNodeTest<ElemType>>(c_deviceId, minibatchSize, SmallVector<size_t>{ inputDim }, inputData);
+    input->LinkToMBLayout(labels->GetMBLayout());
+    // one column per frame
+    labels->Value().SetValue(numClasses, minibatchSize, c_deviceId, labelsData.data());
+    input->Value().SetValue(inputDim, minibatchSize, c_deviceId, inputData.data());
+    shared_ptr<ComputationNode<ElemType>> weights = make_shared<LearnableParameter<ElemType>>(c_deviceId, L"weights", inputDim, numClasses);
+    weights->Value().SetValue(inputDim, numClasses, c_deviceId, weightsData.data());
+    weights->CreateGradientMatrixIfNull();
+    weights->Gradient().Resize(inputDim, numClasses);
+    weights->Gradient().SetValue(0);
+    auto samplingWeights = make_shared<LearnableParameter<ElemType>>(c_deviceId, L"samplingWeights", numClasses, 1);
+    samplingWeights->Value().SetValue(numClasses, 1, c_deviceId, samplingWeightsData.data());
+    input->Gradient().SetValue(0);
+    if (sparseLabels)
+        labels->Value().SwitchToMatrixType(SPARSE, matrixFormatSparseCSC, true);
+
+    auto node = make_shared<SampledCrossEntropyWithSoftmaxNodeTest<ElemType>>(numSamples);
+    node->AttachInputs(vector<ComputationNodeBasePtr>{ labels, input, weights, samplingWeights });
+    node->SetEnvironment(make_shared<ComputationEnvironment>());
+    node->Validate(true);
+    node->AllocMatrices();
+
+    ComputationNodeBasePtr criterion = node;
+    FrameRange fr;
+    criterion->ForwardProp(fr);
+    criterion->BackpropTo(1, fr);
+    criterion->BackpropTo(2, fr);
+
+    // the reference: a softmax over the label and the sampled classes, with logits corrected by log(numSamples * q)
+    vector<size_t> samples = node->GetSamples();
+    BOOST_REQUIRE_EQUAL(samples.size(), numSamples);
+    double sumOfSamplingWeights = 0;
+    for (auto w : samplingWeightsData)
+        sumOfSamplingWeights += w;
+    auto logit = [&](size_t t, size_t c)
+    {
+        double z = 0;
+        for (size_t i = 0; i < inputDim; i++)
+            z += (double)weightsData[c * inputDim + i] * inputData[t * inputDim + i];
+        return z - log(numSamples * samplingWeightsData[c] / sumOfSamplingWeights);
+    };
+
+    double expectedLoss = 0;
+    vector<double> expectedInputGradient(inputData.size(), 0);
+    vector<double> expectedWeightsGradient(weightsData.size(), 0);
+    for (size_t t = 0; t < minibatchSize; t++)
+    {
+        vector<size_t> classes = { labelClasses[t] };
+        classes.insert(classes.end(), samples.begin(), samples.end());
+        vector<double> z(classes.size());
+        double maxLogit = -numeric_limits<double>::infinity();
+        for (size_t k = 0; k < classes.size(); k++)
+            maxLogit = max(maxLogit, z[k] = logit(t, classes[k]));
+        double sumOfExp = 0;
+        for (double zk : z)
+            sumOfExp += exp(zk - maxLogit);
+        expectedLoss -= z[0] - maxLogit - log(sumOfExp);
+
+        for (size_t k = 0; k < classes.size(); k++)
+        {
+            double logitGradient = exp(z[k] - maxLogit) / sumOfExp - (k == 0 ? 1 : 0);
+            for (size_t i = 0; i < inputDim; i++)
+            {
+                expectedInputGradient[t * inputDim + i] += logitGradient * weightsData[classes[k] * inputDim + i];
+                expectedWeightsGradient[classes[k] * inputDim + i] += logitGradient * inputData[t * inputDim + i];
+            }
+        }
+    }
+
+    const double tolerance = sizeof(ElemType) == sizeof(float) ? 1e-4 : 1e-10;
+    BOOST_CHECK_SMALL(ToDense(node->Value())(0, 0) - expectedLoss, tolerance);
+    auto inputGradient = ToDense(input->Gradient());
+    for (size_t t = 0; t < minibatchSize; t++)
+        for (size_t i = 0; i < inputDim; i++)
+            BOOST_CHECK_SMALL(inputGradient(i, t) - expectedInputGradient[t * inputDim + i], tolerance);
+    // with sparse labels, the gradient of the weights only has the columns of the label and sampled classes
+    BOOST_CHECK(weights->Gradient().GetMatrixType() == (sparseLabels ? SPARSE : DENSE));
+    auto weightsGradient = ToDense(weights->Gradient());
+    for (size_t c = 0; c < numClasses; c++)
+        for (size_t i = 0; i < inputDim; i++)
+            BOOST_CHECK_SMALL(weightsGradient(i, c) - expectedWeightsGradient[c * inputDim + i], tolerance);
+}
+
+BOOST_AUTO_TEST_SUITE(SampledSoftmaxTestSuite)
+
+BOOST_AUTO_TEST_CASE(WalkerAliasTableProbabilities)
+{
+    const vector<double> weights = { 1, 0, 3, 0.5, 10, 2, 0, 7.5 };
+    WalkerAliasTable aliasTable;
+    aliasTable.Build(weights);
+    BOOST_REQUIRE_EQUAL(aliasTable.GetNumClasses(), weights.size());
+
+    // Draws of uniformly spaced numbers in [0, 1) give each class its share of the unit interval.
+    const size_t numDraws = 1 << 20;
+    vector<size_t> counts(weights.size(), 0);
+    for (size_t k = 0; k < numDraws; k++)
+        counts[aliasTable.Draw((k + 0.5) / numDraws)]++;
+
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        double probability = weights[i] / 24;
+        BOOST_CHECK_SMALL(aliasTable.GetProbability(i) - probability, 1e-12);
+        BOOST_CHECK_SMALL((double)counts[i] / numDraws - probability, 1e-5);
+        if (weights[i] == 0)
+            BOOST_CHECK_EQUAL(counts[i], 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WalkerAliasTableInvalidWeights)
+{
+    WalkerAliasTable aliasTable;
+    BOOST_CHECK_THROW(aliasTable.Build({ 1, -1, 2 }), std::invalid_argument);
+    BOOST_CHECK_THROW(aliasTable.Build({ 0, 0 }), std::invalid_argument);
+    BOOST_CHECK_THROW(aliasTable.Build({ 1, numeric_limits<double>::infinity() }), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(SampledSoftmaxForwardBackward)
+{
+    SampledSoftmaxForwardBackwardTestImpl<float>(/*sparseLabels=*/false);
+    SampledSoftmaxForwardBackwardTestImpl<double>(/*sparseLabels=*/false);
+}
+
+BOOST_AUTO_TEST_CASE(SampledSoftmaxForwardBackwardSparseLabels)
+{
+    SampledSoftmaxForwardBackwardTestImpl<float>(/*sparseLabels=*/true);
+    SampledSoftmaxForwardBackwardTestImpl<double>(/*sparseLabels=*/true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} } } }
@@ -32,12 +32,19 @@ namespace CNTK {
     public:
         ChunkPtr m_chunk;
 
+        // At the 'Info' trace level, all sequences are parsed by the file reader based parser,
+        // at the lower ones, the valid sequences are parsed in memory.
+        static const unsigned int Warning = TextParser<ElemType>::TraceLevel::Warning;
+        static const unsigned int Info = TextParser<ElemType>::TraceLevel::Info;
+
         CNTKTextFormatReaderTestRunner(const string& filename,
-            const vector<StreamDescriptor>& streams, unsigned int maxErrors) :
+            const vector<StreamDescriptor>& streams, unsigned int maxErrors,
+            unsigned int traceLevel = TextParser<ElemType>::TraceLevel::Info, bool useInMemoryParser = true) :
             m_parser(std::make_shared<CorpusDescriptor>(true), wstring(filename.begin(), filename.end()), streams, true)
         {
             m_parser.SetMaxAllowedErrors(maxErrors);
-            m_parser.SetTraceLevel(TextParser<ElemType>::TraceLevel::Info);
+            m_parser.SetTraceLevel(traceLevel);
+            m_parser.SetUseInMemoryParser(useInMemoryParser);
             m_parser.SetChunkSize(SIZE_MAX);
             m_parser.SetNumRetries(0);
             m_parser.Initialize();
@@ -47,6 +54,11 @@ namespace CNTK {
         {
             m_chunk = m_parser.GetChunk(0);
         }
+
+        size_t NumberOfSequences()
+        {
+            return m_parser.ChunkInfos()[0].m_numberOfSequences;
+        }
     };
 }
 
@@ -754,24 +766,10 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_ref_data_with_escape_sequences)
     test({ L"defMBSize=true" });
 };
 
-// input contains a number of empty sparse samples
-BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_invalid_inputs)
+// Loads the chunk of the test runner with stderr, where the parser reports errors and warnings, redirected to 'output'.
+template <class ElemType>
+static void LoadChunkWithStderrTo(CNTKTextFormatReaderTestRunner<ElemType>& testRunner, const string& output)
 {
-    vector<StreamDescriptor> streams(2);
-    streams[0].m_alias = "A";
-    streams[0].m_name = L"A";
-    streams[0].m_storageFormat = StorageFormat::Dense;
-    streams[0].m_sampleDimension = 1;
-
-    streams[1].m_alias = "B";
-    streams[1].m_name = L"B";
-    streams[1].m_storageFormat = StorageFormat::SparseCSC;
-    streams[1].m_sampleDimension = 10;
-
-    CNTKTextFormatReaderTestRunner<float> testRunner("invalid_inputs.txt", streams, 99999);
-
-    auto output = testDataPath() + "/Control/CNTKTextFormatReader/invalid_inputs_Output.txt";
-
     boost::filesystem::remove(output);
 
     FILE * redirected = fopen(output.c_str(), "w");
@@ -790,7 +788,7 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_invalid_inputs)
     }
     else 
     {
-        BOOST_SCOPE_EXIT(stderrDup, redirected)
+        BOOST_SCOPE_EXIT_TPL(stderrDup, redirected)
         {
             fflush(stderr);
             fclose(redirected);
@@ -805,10 +803,43 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_invalid_inputs)
         
         testRunner.LoadChunk();
     }
+}
+
+// input contains a number of empty sparse samples
+BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_invalid_inputs)
+{
+    vector<StreamDescriptor> streams(2);
+    streams[0].m_alias = "A";
+    streams[0].m_name = L"A";
+    streams[0].m_storageFormat = StorageFormat::Dense;
+    streams[0].m_sampleDimension = 1;
+
+    streams[1].m_alias = "B";
+    streams[1].m_name = L"B";
+    streams[1].m_storageFormat = StorageFormat::SparseCSC;
+    streams[1].m_sampleDimension = 10;
+
+    CNTKTextFormatReaderTestRunner<float> testRunner("invalid_inputs.txt", streams, 99999);
+
+    auto output = testDataPath() + "/Control/CNTKTextFormatReader/invalid_inputs_Output.txt";
+    LoadChunkWithStderrTo(testRunner, output);
 
     auto control = testDataPath() + "/Control/CNTKTextFormatReader/invalid_inputs_Control.txt";
 
     CheckFilesEquivalent(control, output);
+
+    // Below the 'Info' trace level, the valid sequences are parsed in memory and the others handed over
+    // to the file reader based parser, which has to report exactly the same warnings and errors.
+    const auto traceLevel = CNTKTextFormatReaderTestRunner<float>::Warning;
+    CNTKTextFormatReaderTestRunner<float> reference("invalid_inputs.txt", streams, 99999, traceLevel, false);
+    CNTKTextFormatReaderTestRunner<float> inMemory("invalid_inputs.txt", streams, 99999, traceLevel, true);
+
+    auto referenceOutput = testDataPath() + "/Control/CNTKTextFormatReader/invalid_inputs_Warning_Output.txt";
+    auto inMemoryOutput = testDataPath() + "/Control/CNTKTextFormatReader/invalid_inputs_Warning_InMemory_Output.txt";
+    LoadChunkWithStderrTo(reference, referenceOutput);
+    LoadChunkWithStderrTo(inMemory, inMemoryOutput);
+
+    CheckFilesEquivalent(referenceOutput, inMemoryOutput);
 };
 
 
@@ -823,29 +854,30 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_no_trailing_newline_valid_input)
     vector<std::pair<string, double>> input{ {"1", 1}, { "-123", -123. },{ "45.", 45. }, {"6.78", 6.78}, {"9.10e-11", 9.10e-11 } };
 
     size_t count = 0;
-    for (const auto& pair : input) 
-    {
-        string filename = std::to_string(count++) + ".no_trailing_newline.txt";
-        double value = 0;
-
+    for (auto traceLevel : { CNTKTextFormatReaderTestRunner<double>::Info, CNTKTextFormatReaderTestRunner<double>::Warning })
+        for (const auto& pair : input) 
         {
-            std::ofstream file;
-            file.open(filename, std::ofstream::out);
-            file << "|A " << pair.first;
-            file.flush();
+            string filename = std::to_string(count++) + ".no_trailing_newline.txt";
+            double value = 0;
 
-            CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0);
-            testRunner.LoadChunk();
-            vector<SequenceDataPtr> data;
-            testRunner.m_chunk->GetSequence(0, data);
-            value = *(reinterpret_cast<const double*>(data[0]->GetDataBuffer()));
-        }
+            {
+                std::ofstream file;
+                file.open(filename, std::ofstream::out);
+                file << "|A " << pair.first;
+                file.flush();
+
+                CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0, traceLevel);
+                testRunner.LoadChunk();
+                vector<SequenceDataPtr> data;
+                testRunner.m_chunk->GetSequence(0, data);
+                value = *(reinterpret_cast<const double*>(data[0]->GetDataBuffer()));
+            }
         
-        boost::filesystem::remove(filename);
+            boost::filesystem::remove(filename);
 
-        BOOST_REQUIRE_CLOSE(value, pair.second, 0.00001);
+            BOOST_REQUIRE_CLOSE(value, pair.second, 0.00001);
 
-    }
+        }
 
 };
 
@@ -859,24 +891,25 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_no_trailing_newline_invalid_input)
 
     string filename = "no_trailing_newline.txt";
 
-    for (auto& input : {"", "\t", " ", "     ", " -", " +", " 12.+", " 12.+e", " 1:" })
-    {
+    for (auto traceLevel : { CNTKTextFormatReaderTestRunner<double>::Info, CNTKTextFormatReaderTestRunner<double>::Warning })
+        for (auto& input : {"", "\t", " ", "     ", " -", " +", " 12.+", " 12.+e", " 1:" })
         {
-            boost::filesystem::remove(filename);
-            std::ofstream file;
-            file.open(filename, std::ofstream::out);
-            file << "|A" << input;
+            {
+                boost::filesystem::remove(filename);
+                std::ofstream file;
+                file.open(filename, std::ofstream::out);
+                file << "|A" << input;
+            }
+            CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0, traceLevel);
+            BOOST_REQUIRE_EXCEPTION(
+                testRunner.LoadChunk(),
+                std::runtime_error,
+                [](std::runtime_error const& ex)
+            {
+                return string("Reached the maximum number of allowed errors"
+                    " while reading the input file (no_trailing_newline.txt).") == ex.what();
+            });;
         }
-        CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0);
-        BOOST_REQUIRE_EXCEPTION(
-            testRunner.LoadChunk(),
-            std::runtime_error,
-            [](std::runtime_error const& ex)
-        {
-            return string("Reached the maximum number of allowed errors"
-                " while reading the input file (no_trailing_newline.txt).") == ex.what();
-        });;
-    }
 };
 
 
@@ -890,17 +923,90 @@ BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_extra_input_should_be_ignored)
 
     string filename = "extra_input.txt";
 
-    for (auto& input : { "|A 1 |B 1 2 3", "|A 2 |this_input_is_supposed_to_be_also_ignored 1 2 3" })
+    for (auto traceLevel : { CNTKTextFormatReaderTestRunner<double>::Info, CNTKTextFormatReaderTestRunner<double>::Warning })
+        for (auto& input : { "|A 1 |B 1 2 3", "|A 2 |this_input_is_supposed_to_be_also_ignored 1 2 3" })
+        {
+            {
+                boost::filesystem::remove(filename);
+                std::ofstream file;
+                file.open(filename, std::ofstream::out);
+                file << input;
+            }
+            CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0, traceLevel);
+            testRunner.LoadChunk();
+            vector<SequenceDataPtr> data;
+            testRunner.m_chunk->GetSequence(0, data);
+            BOOST_REQUIRE_EQUAL(*(reinterpret_cast<const double*>(data[0]->GetDataBuffer())), input[3] - '0');
+        }
+};
+
+// The in-memory parser has to produce exactly the same sequences as the file reader based one,
+// including the inputs with errors, which it hands over to the latter.
+BOOST_AUTO_TEST_CASE(CNTKTextFormatReader_in_memory_parser_matches_reference)
+{
+    auto test = [](const string& filename, const vector<StreamDescriptor>& streams)
     {
+        CNTKTextFormatReaderTestRunner<float> reference(filename, streams, 99999, 0, false);
+        CNTKTextFormatReaderTestRunner<float> inMemory(filename, streams, 99999, 0, true);
+        reference.LoadChunk();
+        inMemory.LoadChunk();
+
+        BOOST_REQUIRE(reference.NumberOfSequences() > 0);
+        for (size_t i = 0; i < reference.NumberOfSequences(); ++i)
         {
-            boost::filesystem::remove(filename);
-            std::ofstream file;
-            file.open(filename, std::ofstream::out);
-            file << input;
+            vector<SequenceDataPtr> expected, actual;
+            reference.m_chunk->GetSequence(i, expected);
+            inMemory.m_chunk->GetSequence(i, actual);
+            BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+
+            for (size_t j = 0; j < expected.size(); ++j)
+            {
+                BOOST_REQUIRE_EQUAL(expected[j]->m_numberOfSamples, actual[j]->m_numberOfSamples);
+                size_t numValues = expected[j]->m_numberOfSamples * streams[j].m_sampleDimension;
+                if (streams[j].m_storageFormat != StorageFormat::Dense)
+                {
+                    auto expectedSparse = static_pointer_cast<SparseSequenceData>(expected[j]);
+                    auto actualSparse = static_pointer_cast<SparseSequenceData>(actual[j]);
+                    numValues = expectedSparse->m_totalNnzCount;
+                    BOOST_REQUIRE_EQUAL(numValues, actualSparse->m_totalNnzCount);
+                    BOOST_REQUIRE(expectedSparse->m_nnzCounts == actualSparse->m_nnzCounts);
+                    BOOST_REQUIRE(equal(expectedSparse->m_indices, expectedSparse->m_indices + numValues, actualSparse->m_indices));
+                }
+                auto expectedValues = reinterpret_cast<const float*>(expected[j]->GetDataBuffer());
+                auto actualValues = reinterpret_cast<const float*>(actual[j]->GetDataBuffer());
+                BOOST_REQUIRE(memcmp(expectedValues, actualValues, numValues * sizeof(float)) == 0);
+            }
         }
-        CNTKTextFormatReaderTestRunner<double> testRunner(filename, streams, 0);
-        testRunner.LoadChunk();
-    }
+    };
+
+    vector<StreamDescriptor> streams(2);
+    streams[0].m_alias = "A";
+    streams[0].m_name = L"A";
+    streams[0].m_storageFormat = StorageFormat::Dense;
+    streams[0].m_sampleDimension = 1;
+    streams[1].m_alias = "B";
+    streams[1].m_name = L"B";
+    streams[1].m_storageFormat = StorageFormat::SparseCSC;
+    streams[1].m_sampleDimension = 10;
+    test("invalid_inputs.txt", streams);
+
+    streams[0].m_alias = "F0";
+    streams[0].m_name = L"F0";
+    streams[0].m_storageFormat = StorageFormat::SparseCSC;
+    streams[0].m_sampleDimension = 100;
+    streams[1].m_alias = "F1";
+    streams[1].m_name = L"F1";
+    streams[1].m_storageFormat = StorageFormat::Dense;
+    streams[1].m_sampleDimension = 3;
+    test("ref_data_with_escape_sequences.txt", streams);
+
+    streams.resize(1);
+    streams[0].m_alias = "F0";
+    streams[0].m_name = L"F0";
+    streams[0].m_storageFormat = StorageFormat::Dense;
+    streams[0].m_sampleDimension = 10;
+    test("1x10_dense.txt", streams);
+    test("5x10_jagged.txt", streams);
 };
 
 // 100 sequences with N samples for each of 3 inputs, where N is chosen at random
@@ -36,6 +36,67 @@ BOOST_AUTO_TEST_CASE(ImageReaderSimple)
         1);
 }
 
+BOOST_AUTO_TEST_CASE(ImageReaderSimpleFused)
+{
+    // The fused transform must produce the same minibatches as the chain of transforms.
+    HelperRunReaderTest<float>(
+        testDataPath() + "/Config/ImageReaderSimpleFused_Config.cntk",
+        testDataPath() + "/Control/ImageReaderSimple_Control.txt",
+        testDataPath() + "/Control/ImageReaderSimpleFused_Output.txt",
+        "Simple_Test",
+        "reader",
+        4,
+        4,
+        1,
+        1,
+        0,
+        0,
+        1);
+}
+
+BOOST_AUTO_TEST_CASE(ImageReaderFusedTransforms)
+{
+    // Non-uniform images, down- and upscaled from random side and center crops with flips, color and intensity
+    // jitter and a mean image: with the same seed, the fused transform must match the chain of transforms up to
+    // the rounding of the interpolation to 8 bits, one gray level, scaled by at most 1.2 by the contrast jitter.
+    const double tolerance = 1.5;
+    for (auto cropType : { L"RandomSide", L"Center" })
+    {
+        auto outputFile = [&](bool fuse)
+        {
+            auto file = testDataPath() + "/Control/ImageReaderFusedTransforms_" + (fuse ? "Fused_" : "") + "Output.txt";
+            HelperReadInAndWriteOut<float>(
+                testDataPath() + "/Config/ImageReaderFusedTransforms_Config.cntk",
+                file,
+                "FusedTransforms_Test",
+                "reader",
+                8,
+                4,
+                2,
+                1,
+                1,
+                0,
+                1,
+                false,
+                false,
+                true,
+                { std::wstring(L"CropMode=") + cropType, fuse ? L"Fuse=true" : L"Fuse=false" });
+            return file;
+        };
+
+        std::ifstream chained(outputFile(false));
+        std::ifstream fused(outputFile(true));
+        std::istream_iterator<double> itChained(chained), itFused(fused), end;
+        size_t count = 0;
+        for (; itChained != end && itFused != end; ++itChained, ++itFused, ++count)
+            BOOST_REQUIRE_SMALL(*itChained - *itFused, tolerance);
+
+        BOOST_REQUIRE_MESSAGE(itChained == end && itFused == end, "Different number of elements in the outputs of the chained and fused transforms");
+        // 2 epochs of 8 images, each 8 x 6 x 3 features and 4 labels.
+        BOOST_REQUIRE_EQUAL(count, 2 * 8 * (8 * 6 * 3 + 4));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(ImageAndTextReaderSimple)
 {
     HelperRunReaderTest<float>(
@@ -4,9 +4,12 @@
 //
 
 #include "stdafx.h"
+#include <atomic>
+#include <chrono>
 #include <numeric>
 #include <random>
 #include <set>
+#include <thread>
 #include "NoRandomizer.h"
 #include "LTNoRandomizer.h"
 #include "DataDeserializer.h"
@@ -18,6 +21,8 @@
 #include "CudaMemoryProvider.h"
 #include "HeapMemoryProvider.h"
 #include "BufferedFileReader.h"
+#include "ChunkCache.h"
+#include "ReaderShim.h"
 
 #pragma warning(push)
 // disable warning about possible mod 0 operation in uniform_int_distribution
@@ -792,6 +797,175 @@ BOOST_AUTO_TEST_CASE(BlockRandomizerOneEpochWithChunks2)
     BlockRandomizerOneEpochWithChunks2Test(true);
 }
 
+BOOST_AUTO_TEST_CASE(ChunkCacheEvictsLeastRecentlyUsed)
+{
+    vector<float> data(100);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(10, 10, data);
+    size_t chunkSize = ChunkCache::EstimateChunkSize(mockDeserializer->ChunkInfos()[0], mockDeserializer->StreamInfos());
+
+    ChunkCache cache(mockDeserializer, 3 * chunkSize);
+    for (ChunkIdType id : { 0, 1, 2, 0, 3, 0, 2, 1 })
+        cache.GetChunk(id);
+
+    // 3 evicts 1 (the least recently used), then 1 evicts 3.
+    auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.m_hits, 3u);
+    BOOST_CHECK_EQUAL(statistics.m_misses, 5u);
+    BOOST_CHECK_EQUAL(statistics.m_evictions, 2u);
+    BOOST_CHECK_EQUAL(statistics.m_numberOfChunks, 3u);
+    BOOST_CHECK_EQUAL(statistics.m_sizeInBytes, 3 * chunkSize);
+
+    // Without a limit, all chunks are kept.
+    ChunkCache unlimitedCache(mockDeserializer);
+    for (int sweep = 0; sweep < 2; sweep++)
+        for (ChunkIdType id = 0; id < 10; id++)
+            unlimitedCache.GetChunk(id);
+    statistics = unlimitedCache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.m_misses, 10u);
+    BOOST_CHECK_EQUAL(statistics.m_hits, 10u);
+    BOOST_CHECK_EQUAL(statistics.m_evictions, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(ChunkCachePrefetch)
+{
+    vector<float> data(100);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(10, 10, data);
+
+    ChunkCache cache(mockDeserializer);
+    cache.Prefetch(5);
+    cache.Prefetch(5);
+    auto chunk = cache.GetChunk(5);
+
+    vector<SequenceDataPtr> sequence;
+    chunk->GetSequence(50, sequence);
+    BOOST_CHECK_EQUAL(*(float*)sequence[0]->GetDataBuffer(), 50.0f);
+
+    auto statistics = cache.GetStatistics();
+    BOOST_CHECK_EQUAL(statistics.m_prefetches, 1u);
+    BOOST_CHECK_EQUAL(statistics.m_hits, 1u);
+    BOOST_CHECK_EQUAL(statistics.m_misses, 0u);
+}
+
+// Wraps a deserializer and records whether GetChunk() was ever entered by two threads at the same time,
+// which real deserializers do not support since they share their file handle between chunks.
+class NonReentrantDeserializer : public DataDeserializer
+{
+public:
+    NonReentrantDeserializer(DataDeserializerPtr deserializer)
+        : m_deserializer(deserializer), m_numActiveCalls(0), m_enteredConcurrently(false)
+    {}
+
+    vector<StreamInformation> StreamInfos() override { return m_deserializer->StreamInfos(); }
+    vector<ChunkInfo> ChunkInfos() override { return m_deserializer->ChunkInfos(); }
+
+    void SequenceInfosForChunk(ChunkIdType chunkId, vector<SequenceInfo>& descriptions) override
+    {
+        m_deserializer->SequenceInfosForChunk(chunkId, descriptions);
+    }
+
+    bool GetSequenceInfo(const SequenceInfo& primary, SequenceInfo& description) override
+    {
+        return m_deserializer->GetSequenceInfo(primary, description);
+    }
+
+    ChunkPtr GetChunk(ChunkIdType chunkId) override
+    {
+        if (m_numActiveCalls++ != 0)
+            m_enteredConcurrently = true;
+        // give another thread the time to enter as well
+        this_thread::sleep_for(chrono::milliseconds(2));
+        auto chunk = m_deserializer->GetChunk(chunkId);
+        m_numActiveCalls--;
+        return chunk;
+    }
+
+    bool WasEnteredConcurrently() const { return m_enteredConcurrently; }
+
+private:
+    DataDeserializerPtr m_deserializer;
+    atomic<int> m_numActiveCalls;
+    atomic<bool> m_enteredConcurrently;
+};
+
+BOOST_AUTO_TEST_CASE(ChunkCacheDoesNotEnterDeserializerConcurrently)
+{
+    vector<float> data(200);
+    iota(data.begin(), data.end(), 0.0f);
+    auto deserializer = make_shared<NonReentrantDeserializer>(make_shared<MockDeserializer>(20, 10, data));
+
+    // Chunks missed in the foreground while the odd chunks are being prefetched.
+    ChunkCache cache(deserializer);
+    for (ChunkIdType id = 1; id < 20; id += 2)
+        cache.Prefetch(id);
+    for (ChunkIdType id = 0; id < 20; id++)
+    {
+        auto chunk = cache.GetChunk(id);
+        vector<SequenceDataPtr> sequence;
+        chunk->GetSequence(id * 10, sequence);
+        BOOST_REQUIRE_EQUAL(*(float*)sequence[0]->GetDataBuffer(), (float)(id * 10));
+    }
+    BOOST_CHECK(!deserializer->WasEnteredConcurrently());
+
+    // The same through a prefetching randomizer, with a cache too small for the randomization window.
+    size_t chunkSize = ChunkCache::EstimateChunkSize(deserializer->ChunkInfos()[0], deserializer->StreamInfos());
+    auto boundedCache = make_shared<ChunkCache>(deserializer, 2 * chunkSize);
+    BlockRandomizer randomizer(0, 4, boundedCache, /*prefetch =*/ true, false, 0, /*sampleBasedRandomizationWindow =*/ false);
+
+    EpochConfiguration epochConfiguration;
+    epochConfiguration.m_numberOfWorkers = 1;
+    epochConfiguration.m_workerRank = 0;
+    epochConfiguration.m_minibatchSizeInSamples = 7;
+    epochConfiguration.m_totalEpochSizeInSamples = data.size();
+    epochConfiguration.m_epochIndex = 0;
+    randomizer.StartEpoch(epochConfiguration);
+    while (!randomizer.GetNextSequences(7, 7).m_data.empty())
+        ;
+    BOOST_CHECK(!deserializer->WasEnteredConcurrently());
+}
+
+BOOST_AUTO_TEST_CASE(BlockRandomizerWithBoundedChunkCache)
+{
+    vector<float> data(100);
+    iota(data.begin(), data.end(), 0.0f);
+    auto mockDeserializer = make_shared<MockDeserializer>(10, 10, data);
+    size_t chunkSize = ChunkCache::EstimateChunkSize(mockDeserializer->ChunkInfos()[0], mockDeserializer->StreamInfos());
+
+    EpochConfiguration epochConfiguration;
+    epochConfiguration.m_numberOfWorkers = 1;
+    epochConfiguration.m_workerRank = 0;
+    epochConfiguration.m_minibatchSizeInSamples = 7;
+    epochConfiguration.m_totalEpochSizeInSamples = data.size();
+
+    // The cache, too small for the randomization window, must not change what the randomizer returns.
+    for (bool prefetch : { false, true })
+    {
+        auto cache = make_shared<ChunkCache>(mockDeserializer, 2 * chunkSize);
+        BlockRandomizer expected(0, 4, mockDeserializer, prefetch, false, 0, /*sampleBasedRandomizationWindow =*/ false);
+        BlockRandomizer actual(0, 4, cache, prefetch, false, 0, /*sampleBasedRandomizationWindow =*/ false);
+        for (size_t epoch = 0; epoch < 3; epoch++)
+        {
+            epochConfiguration.m_epochIndex = epoch;
+            expected.StartEpoch(epochConfiguration);
+            actual.StartEpoch(epochConfiguration);
+            for (;;)
+            {
+                Sequences e = expected.GetNextSequences(7, 7), a = actual.GetNextSequences(7, 7);
+                BOOST_REQUIRE_EQUAL(e.m_data.size(), a.m_data.size());
+                BOOST_REQUIRE_EQUAL(e.m_endOfEpoch, a.m_endOfEpoch);
+                if (e.m_data.empty())
+                    break;
+                BOOST_REQUIRE_EQUAL(e.m_data[0].size(), a.m_data[0].size());
+                for (size_t i = 0; i < e.m_data[0].size(); i++)
+                    BOOST_REQUIRE_EQUAL(*(float*)e.m_data[0][i]->GetDataBuffer(), *(float*)a.m_data[0][i]->GetDataBuffer());
+            }
+        }
+        BOOST_CHECK(cache->GetStatistics().m_evictions > 0);
+        BOOST_CHECK(cache->GetStatistics().m_sizeInBytes <= 2 * chunkSize);
+    }
+}
+
 void RandomizerChaosMonkeyTest(SequenceEnumerator& randomizer, size_t sweepSize, int seed)
 {
     std::mt19937 rng(seed);
@@ -1305,6 +1479,156 @@ BOOST_AUTO_TEST_CASE(CheckNoDegenerateMinibatches)
     }
 }
 
+// A reader of a single dense stream with the values of its sample position, with a hiccup every few minibatches.
+// Like the packers, it alternates two buffers, i.e. a minibatch is overwritten by the one after the next.
+class CountingReader : public Reader
+{
+public:
+    CountingReader() : m_position(0), m_epochSize(0), m_minibatchSize(0), m_currentBuffer(0), m_buffers(2)
+    {}
+
+    void StartEpoch(const EpochConfiguration& config, const map<wstring, int>&) override
+    {
+        m_position = 0;
+        m_epochSize = config.m_totalEpochSizeInSamples;
+        m_minibatchSize = config.m_minibatchSizeInSamples;
+    }
+
+    void SetConfiguration(const ReaderConfiguration& config, const map<wstring, int>&) override
+    {
+        m_minibatchSize = config.m_minibatchSizeInSamples;
+    }
+
+    vector<StreamInformation> GetStreamDescriptions() override
+    {
+        StreamInformation stream;
+        stream.m_name = L"features";
+        stream.m_id = 0;
+        stream.m_storageFormat = StorageFormat::Dense;
+        stream.m_elementType = DataType::Float;
+        stream.m_sampleLayout = NDShape({ 1 });
+        return { stream };
+    }
+
+    Minibatch ReadMinibatch() override
+    {
+        size_t size = min(m_minibatchSize, m_epochSize - m_position);
+        if ((m_position / m_minibatchSize) % 3 == 0)
+            this_thread::sleep_for(chrono::milliseconds(2));
+
+        auto& buffer = m_buffers[m_currentBuffer];
+        m_currentBuffer = 1 - m_currentBuffer;
+        buffer.resize(size);
+        iota(buffer.begin(), buffer.end(), (float)m_position);
+        m_position += size;
+
+        Minibatch minibatch(false, m_position >= m_epochSize);
+        if (size > 0)
+        {
+            auto stream = make_shared<StreamMinibatch>();
+            stream->m_data = buffer.data();
+            stream->m_layout = make_shared<MBLayout>();
+            stream->m_layout->Init(1, size);
+            stream->m_layout->AddSequence(0, 0, 0, size);
+            stream->m_sampleShape = NDShape({ 1 });
+            minibatch.m_data.push_back(stream);
+        }
+        return minibatch;
+    }
+
+    map<wstring, size_t> GetState() override
+    {
+        return { { g_minibatchSourcePosition, m_position } };
+    }
+
+    void SetState(const map<wstring, size_t>& state) override
+    {
+        m_position = state.at(g_minibatchSourcePosition);
+    }
+
+private:
+    size_t m_position;
+    size_t m_epochSize;
+    size_t m_minibatchSize;
+    size_t m_currentBuffer;
+    vector<vector<float>> m_buffers;
+};
+
+shared_ptr<ReaderShim<float>> CreatePrefetchingShim(const string& prefetchConfig, size_t minibatchSize, size_t epochSize, StreamMinibatchInputs& inputs)
+{
+    auto shim = make_shared<ReaderShim<float>>(make_shared<CountingReader>());
+    ConfigParameters config;
+    config.Parse(prefetchConfig);
+    shim->Init(config);
+
+    inputs.AddInput(L"features", make_shared<Matrix<float>>(CPUDEVICE), make_shared<MBLayout>(), TensorShape(1));
+    unordered_set<InputStreamDescription> streams = { InputStreamDescription(L"features", CPUDEVICE, MatrixType::DENSE, matrixFormatDense) };
+    shim->StartMinibatchLoop(minibatchSize, 0, streams, epochSize);
+    return shim;
+}
+
+vector<float> ReadPrefetchedMinibatch(ReaderShim<float>& shim, StreamMinibatchInputs& inputs)
+{
+    if (!shim.GetMinibatch(inputs))
+        return {};
+    const auto& matrix = inputs.GetInputMatrix<float>(L"features");
+    return vector<float>(matrix.Data(), matrix.Data() + matrix.GetNumElements());
+}
+
+BOOST_AUTO_TEST_CASE(ReaderShimPrefetchRingKeepsOrder)
+{
+    const size_t minibatchSize = 7;
+    const size_t epochSize = 100;
+    for (string prefetchConfig : { "prefetch=false", "prefetchDepth=1", "prefetchDepth=4", "prefetchDepth=4\nprefetchThreads=3" })
+    {
+        StreamMinibatchInputs inputs;
+        auto shim = CreatePrefetchingShim(prefetchConfig, minibatchSize, epochSize, inputs);
+
+        vector<float> values;
+        size_t numMinibatches = 0;
+        for (auto minibatch = ReadPrefetchedMinibatch(*shim, inputs); !minibatch.empty(); minibatch = ReadPrefetchedMinibatch(*shim, inputs))
+        {
+            numMinibatches++;
+            values.insert(values.end(), minibatch.begin(), minibatch.end());
+            BOOST_CHECK_EQUAL(shim->GetCurrentSamplePosition(), values.size());
+        }
+        BOOST_CHECK(shim->IsEndOfEpoch());
+
+        vector<float> expected(epochSize);
+        iota(expected.begin(), expected.end(), 0.0f);
+        BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+
+        auto statistics = shim->GetPrefetchStatistics();
+        BOOST_CHECK_EQUAL(statistics.m_numMinibatches, numMinibatches);
+        BOOST_CHECK_EQUAL(accumulate(statistics.m_occupancyHistogram.begin(), statistics.m_occupancyHistogram.end(), (size_t)0), numMinibatches);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReaderShimPrefetchRingRestoresState)
+{
+    StreamMinibatchInputs inputs;
+    auto shim = CreatePrefetchingShim("prefetchDepth=5\nprefetchThreads=2", 10, 1000, inputs);
+
+    ReadPrefetchedMinibatch(*shim, inputs);
+    ReadPrefetchedMinibatch(*shim, inputs);
+    auto state = shim->GetState();
+    BOOST_CHECK_EQUAL(state.at(g_minibatchSourcePosition), 20u);
+
+    // The ring is filled far beyond the state by now.
+    this_thread::sleep_for(chrono::milliseconds(20));
+    auto first = ReadPrefetchedMinibatch(*shim, inputs);
+    ReadPrefetchedMinibatch(*shim, inputs);
+    BOOST_CHECK_EQUAL(first.front(), 20.0f);
+
+    shim->SetState(state);
+    auto restored = ReadPrefetchedMinibatch(*shim, inputs);
+    BOOST_CHECK_EQUAL_COLLECTIONS(restored.begin(), restored.end(), first.begin(), first.end());
+
+    shim->SetCurrentSamplePosition(500);
+    BOOST_CHECK_EQUAL(ReadPrefetchedMinibatch(*shim, inputs).front(), 500.0f);
+    BOOST_CHECK_EQUAL(shim->GetCurrentSamplePosition(), 510u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(PackerTests)
@@ -11,9 +11,11 @@
 #include "Platform.h"
 #include "IndexBuilder.h"
 #include "ReaderUtil.h"
+#include "../../../Source/Readers/HTKDeserializers/MLFIndexBuilder.h"
 #include "Common/ReaderTestHelper.h"
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 
 using namespace std;
 
@@ -354,8 +356,8 @@ static void CheckIdentical(const shared_ptr<Index>& index1, const shared_ptr<Ind
         Check(chunk1, chunk2.NumberOfSequences(), chunk2.NumberOfSamples(), chunk2.StartOffset(), chunk2.SizeInBytes());
         for (int j = 0; j < chunk1.NumberOfSequences(); j++)
         {
-            auto& seq1 = chunk1[i];
-            auto& seq2 = chunk2[i];
+            auto& seq1 = chunk1[j];
+            auto& seq2 = chunk2[j];
             Check(seq1, seq2.m_key, seq2.NumberOfSamples(), seq2.OffsetInChunk(), seq2.SizeInBytes());
         }
     }
@@ -764,6 +766,125 @@ BOOST_AUTO_TEST_CASE(Index_with_caching)
     CheckIdentical(index, cachedIndex);
 }
 
+BOOST_AUTO_TEST_CASE(Index_with_stale_cache)
+{
+    auto filename = L"test.tmp";
+    CreateTestFile(s_textData, filename);
+    {
+        auto f1 = FileWrapper::OpenOrDie(filename, L"rb");
+        TextInputIndexBuilder(f1).SetCachingEnabled(true).Build();
+    }
+    Sleep(1000);  // sleep for a second to give the cache enough time to be written.
+
+    // Same size, different sequences: the cache must not be used.
+    string input = boost::replace_all_copy(s_textData, "1\t|", "0\t|");
+    CreateTestFile(input, filename);
+
+    shared_ptr<Index> index;
+    {
+        auto f2 = FileWrapper::OpenOrDie(filename, L"rb");
+        TextInputIndexBuilder indexBuilder(f2);
+        index = indexBuilder.SetCachingEnabled(true).Build();
+        Sleep(1000);
+        _wunlink(indexBuilder.GetCacheFilename().c_str());
+    }
+    _wunlink(filename);
+
+    Check(index, 1, 1, 10, input.size());
+}
+
+BOOST_AUTO_TEST_CASE(Index_with_stale_cache_same_size_and_modification_time)
+{
+    // The input is replaced with one of the same size and the same modification time,
+    // e.g. by a copy that preserves timestamps: only the contents tell the cache is stale.
+    auto filename = L"test.tmp";
+    const std::time_t modificationTime = 1500000000;
+    CreateTestFile(s_textData, filename);
+    boost::filesystem::last_write_time(filename, modificationTime);
+    {
+        auto f1 = FileWrapper::OpenOrDie(filename, L"rb");
+        TextInputIndexBuilder(f1).SetCachingEnabled(true).Build();
+    }
+    Sleep(1000);  // sleep for a second to give the cache enough time to be written.
+
+    string input = boost::replace_all_copy(s_textData, "1\t|", "0\t|");
+    CreateTestFile(input, filename);
+    boost::filesystem::last_write_time(filename, modificationTime);
+
+    shared_ptr<Index> index;
+    {
+        auto f2 = FileWrapper::OpenOrDie(filename, L"rb");
+        TextInputIndexBuilder indexBuilder(f2);
+        index = indexBuilder.SetCachingEnabled(true).Build();
+        Sleep(1000);
+        _wunlink(indexBuilder.GetCacheFilename().c_str());
+    }
+    _wunlink(filename);
+
+    Check(index, 1, 1, 10, input.size());
+}
+
+BOOST_AUTO_TEST_CASE(Index_built_in_parallel)
+{
+    string bom{ '\xEF', '\xBB', '\xBF' };
+    string lines = bom + "\n  \n";
+    for (int i = 0; i < 1000; i++)
+        lines += (i % 7 == 0 ? "|b " : "|a ") + std::to_string(i) + (i % 13 == 0 ? "\r\n\n" : "\n");
+    lines += "|a 1000";
+
+    for (const auto& chunkSize : vector<size_t>{ 100, 1024, g_1MB })
+    {
+        for (const auto& minRangeSize : { 1, 7, 100, 3000 })
+        {
+            auto sequential = GetIndexBuilder(lines)->SetSkipSequenceIds(true).SetMainStream("a").SetChunkSize(chunkSize).Build();
+            auto parallel = GetIndexBuilder(lines)->SetSkipSequenceIds(true).SetMainStream("a").SetChunkSize(chunkSize)
+                .SetNumberOfThreads(4).SetMinRangeSize(minRangeSize).Build();
+            Check(sequential, ANY, 858, 858, ANY);
+            CheckIdentical(parallel, sequential);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Index_MLF_built_in_parallel)
+{
+    // Utterances of different lengths, some of them invalid, partly with Windows line endings
+    // and with a second header in between, as in concatenated MLF files.
+    string mlf = "#!MLF!#\n";
+    size_t numberOfValidUtterances = 0;
+    for (int i = 0; i < 500; i++)
+    {
+        string eol = i % 11 == 0 ? "\r\n" : "\n";
+        if (i == 250)
+            mlf += "#!MLF!#" + eol;
+
+        // the key of every 37th utterance is not quoted, every 5th utterance has no frames
+        mlf += (i % 37 == 0 ? "utterance" + std::to_string(i) : "\"" + std::to_string(i) + ".lab\"") + eol;
+        for (int j = 0, frame = 0; j < i % 5; frame += ++j)
+            mlf += std::to_string(frame * 100000) + " " + std::to_string((frame + j + 1) * 100000) + " s" + std::to_string(j) + " " + std::to_string(j) + eol;
+        mlf += "." + eol;
+
+        if (i % 37 != 0 && i % 5 != 0)
+            numberOfValidUtterances++;
+    }
+
+    auto filename = L"test.mlf.tmp";
+    CreateTestFile(mlf, filename);
+    auto corpus = std::make_shared<CorpusDescriptor>(true);
+    auto build = [&](size_t numberOfThreads, size_t minRangeSize)
+    {
+        auto f = FileWrapper::OpenOrDie(filename, L"rb");
+        MLFIndexBuilder indexBuilder(f, corpus);
+        return indexBuilder.SetNumberOfThreads(numberOfThreads).SetMinRangeSize(minRangeSize).SetChunkSize(1024).Build();
+    };
+
+    auto sequential = build(1, g_64MB);
+    Check(sequential, ANY, numberOfValidUtterances, ANY, ANY);
+    for (const auto& minRangeSize : { 1, 100, 5000 })
+        CheckIdentical(build(4, minRangeSize), sequential);
+
+    _wunlink(filename);
+}
+
 BOOST_AUTO_TEST_CASE(Index_64MB_with_caching_check_perf)
 {
     if (true)
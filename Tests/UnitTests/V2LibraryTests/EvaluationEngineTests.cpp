@@ -0,0 +1,134 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md file in the project root for full license information.
+//
+#include "stdafx.h"
+#include "CNTKLibrary.h"
+#include "Common.h"
+#include <future>
+
+using namespace CNTK;
+
+namespace CNTK { namespace Test {
+
+FunctionPtr CreateEvaluationEngineTestModel(size_t inputDim, size_t outputDim, const DeviceDescriptor& device)
+{
+    auto input = InputVariable({ inputDim }, DataType::Float, L"features");
+    auto weights = Parameter({ outputDim, inputDim }, DataType::Float, GlorotUniformInitializer(), device, L"W");
+    auto bias = Parameter({ outputDim }, DataType::Float, 0.5f, device, L"b");
+    return Sigmoid(Plus(Times(weights, input), bias), L"output");
+}
+
+std::vector<std::vector<float>> EvaluateDirectly(const FunctionPtr& model, const ValuePtr& input, const DeviceDescriptor& device)
+{
+    std::unordered_map<Variable, ValuePtr> outputs = { { model->Output(), nullptr } };
+    model->Evaluate({ { model->Arguments()[0], input } }, outputs, device);
+
+    std::vector<std::vector<float>> sequences;
+    outputs[model->Output()]->CopyVariableValueTo(model->Output(), sequences);
+    return sequences;
+}
+
+void TestEvaluationEngine(size_t numWorkers, size_t maxBatchSize, const DeviceDescriptor& device)
+{
+    const size_t inputDim = 7;
+    const size_t outputDim = 5;
+    const size_t numRequests = 40;
+    const size_t numClients = 4;
+
+    // The engine splits the outputs of merged requests by sequence, and the results are checked by sequence, too,
+    // both of which unpack packed value objects.
+    auto automaticUnpackingOfPackedValuesDisabled = Internal::IsAutomaticUnpackingOfPackedValuesDisabled();
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ false);
+
+    auto model = CreateEvaluationEngineTestModel(inputDim, outputDim, device);
+    auto input = model->Arguments()[0];
+    auto output = model->Output();
+
+    std::vector<ValuePtr> requests;
+    std::vector<std::vector<std::vector<float>>> expected;
+    for (size_t i = 0; i < numRequests; ++i)
+    {
+        auto sequenceLengths = GenerateSequenceLengths(1 + i % 3, 6);
+        auto sequences = GenerateSequences<float>(sequenceLengths, { inputDim });
+        requests.push_back(Value::Create({ inputDim }, sequences, device, /*readOnly =*/ true));
+        expected.push_back(EvaluateDirectly(model, requests.back(), device));
+    }
+
+    EvaluationEngineConfig config;
+    config.numWorkers = numWorkers;
+    config.maxBatchSize = maxBatchSize;
+    config.maxBatchingDelayInMicroseconds = 2000;
+    auto engine = CreateEvaluationEngine(model, device, config);
+
+    // Several clients submit their requests concurrently, so that the engine gets to merge them.
+    std::vector<std::future<void>> clients;
+    for (size_t client = 0; client < numClients; ++client)
+    {
+        clients.push_back(std::async(std::launch::async, [&, client]()
+        {
+            std::vector<std::pair<size_t, std::future<std::unordered_map<Variable, ValuePtr>>>> results;
+            for (size_t i = client; i < numRequests; i += numClients)
+                results.push_back(std::make_pair(i, engine->EvaluateAsync({ { input, requests[i] } }, { output })));
+
+            for (auto& result : results)
+            {
+                std::vector<std::vector<float>> actual;
+                result.second.get().at(output)->CopyVariableValueTo(output, actual);
+                if (actual.size() != expected[result.first].size())
+                    ReportFailure("EvaluationEngine: request %d has %d output sequences, expected %d", (int)result.first, (int)actual.size(), (int)expected[result.first].size());
+                for (size_t s = 0; s < actual.size(); ++s)
+                    FloatingPointVectorCompare(actual[s], expected[result.first][s], "EvaluationEngine: output does not match the direct evaluation");
+            }
+        }));
+    }
+    for (auto& client : clients)
+        client.get();
+
+    // The synchronous interface.
+    std::unordered_map<Variable, ValuePtr> outputs = { { output, nullptr } };
+    engine->Evaluate({ { input, requests[0] } }, outputs);
+    std::vector<std::vector<float>> actual;
+    outputs[output]->CopyVariableValueTo(output, actual);
+    for (size_t s = 0; s < actual.size(); ++s)
+        FloatingPointVectorCompare(actual[s], expected[0][s], "EvaluationEngine: output of Evaluate() does not match the direct evaluation");
+
+    auto statistics = engine->Statistics();
+    BOOST_TEST(statistics.numRequests == numRequests + 1);
+    BOOST_TEST(statistics.numMinibatches <= statistics.numRequests);
+    if (maxBatchSize == 1)
+        BOOST_TEST(statistics.numMinibatches == statistics.numRequests);
+    BOOST_TEST(statistics.latencyP50InMilliseconds <= statistics.latencyP99InMilliseconds);
+    BOOST_TEST(statistics.latencyP99InMilliseconds <= statistics.maxLatencyInMilliseconds);
+
+    // Unknown variables are rejected.
+    auto otherInput = InputVariable({ inputDim }, DataType::Float, L"other");
+    VerifyException([&]() { engine->EvaluateAsync({ { otherInput, requests[0] } }, { output }); },
+                    "EvaluationEngine was expected to reject a variable that is not an argument of the model.");
+
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ automaticUnpackingOfPackedValuesDisabled);
+}
+
+BOOST_AUTO_TEST_SUITE(EvaluationEngineSuite)
+
+BOOST_AUTO_TEST_CASE(EvaluationEngineWithoutBatchingInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestEvaluationEngine(3, 1, DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(EvaluationEngineWithBatchingInCPU)
+{
+    if (ShouldRunOnCpu())
+        TestEvaluationEngine(2, 8, DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(EvaluationEngineWithBatchingInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestEvaluationEngine(2, 8, DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}}
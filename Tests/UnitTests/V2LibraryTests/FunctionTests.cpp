@@ -5,7 +5,9 @@
 #include "stdafx.h"
 #include "CNTKLibrary.h"
 #include "Common.h"
+#include "TestHooks.h"
 #include <numeric>
+#include <algorithm>
 
 using namespace CNTK;
 
@@ -1200,6 +1202,75 @@ void TestMatMul(const DeviceDescriptor& device)
     }
 }
 
+// Evaluates a chain of elementwise operations with broadcasting and shared inputs, once op by op and once
+// with the chain fused into a single node (CPU only), and compares the outputs and gradients.
+template <typename ElementType>
+void TestFusedElementwiseOperations(const DeviceDescriptor& device)
+{
+    const size_t dim = 6;
+
+    auto input = InputVariable({ dim }, AsDataType<ElementType>(), /*needsGradient =*/ true, L"features");
+    auto b = Parameter(NDArrayView::RandomUniform<ElementType>({ dim }, -0.5, 0.5, 1, device), L"b");
+    auto c = Parameter(NDArrayView::RandomUniform<ElementType>({ 1 }, 0.5, 1.5, 2, device), L"c");
+    auto gate = Sigmoid(Plus(input, b));
+    auto result = ElementTimes(Tanh(ElementTimes(gate, Exp(Minus(b, input)))), Sqrt(Plus(Abs(input), c)), L"result");
+
+    auto sequenceLengths = GenerateSequenceLengths(5, 11);
+    auto inputValue = GenerateSequences<ElementType>(sequenceLengths, { dim }, device, false);
+    auto rootGradientValue = GenerateSequences<ElementType>(sequenceLengths, { dim }, device, false);
+
+    auto copyToVector = [](const NDArrayViewPtr& view)
+    {
+        auto cpuView = MakeSharedObject<NDArrayView>(AsDataType<ElementType>(), view->Shape(), DeviceDescriptor::CPUDevice());
+        cpuView->CopyFrom(*view);
+        auto buffer = cpuView->template DataBuffer<ElementType>();
+        return std::vector<ElementType>(buffer, buffer + view->Shape().TotalSize());
+    };
+
+    std::vector<std::vector<ElementType>> outputs[2];
+    std::vector<std::vector<ElementType>> inputGradients[2];
+    std::vector<ElementType> gradientsOfB[2], gradientsOfC[2];
+    std::vector<std::wstring> operationNames[2];
+
+    // Temporarily enable the unpacking of packed value objects for result verification
+    auto automaticUnpackingOfPackedValuesDisabled = Internal::IsAutomaticUnpackingOfPackedValuesDisabled();
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ false);
+    for (size_t fuse = 0; fuse < 2; fuse++)
+    {
+        // the setting applies to networks created afterwards, hence the clone
+        Internal::FuseElementwiseOperations(fuse != 0);
+        auto model = result->Clone(ParameterCloningMethod::Share);
+        auto modelInput = model->Arguments()[0];
+
+        std::unordered_map<Variable, ValuePtr> forwardOutputs = { { model->Output(), nullptr } };
+        auto backpropState = model->Forward({ { modelInput, inputValue } }, forwardOutputs, device, { model->Output() });
+        forwardOutputs[model->Output()]->CopyVariableValueTo(model->Output(), outputs[fuse]);
+
+        std::unordered_map<Variable, ValuePtr> gradients = { { modelInput, nullptr }, { b, nullptr }, { c, nullptr } };
+        model->Backward(backpropState, { { model->Output(), rootGradientValue } }, gradients);
+        gradients[modelInput]->CopyVariableValueTo(modelInput, inputGradients[fuse]);
+        gradientsOfB[fuse] = copyToVector(gradients[b]->Data());
+        gradientsOfC[fuse] = copyToVector(gradients[c]->Data());
+        operationNames[fuse] = Internal::ComputationNodeOperationNames(model);
+    }
+    Internal::FuseElementwiseOperations(false);
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ automaticUnpackingOfPackedValuesDisabled);
+
+    auto numFusedNodes = [](const std::vector<std::wstring>& names) { return std::count(names.begin(), names.end(), L"FusedElementwise"); };
+    BOOST_TEST(numFusedNodes(operationNames[0]) == 0);
+    BOOST_TEST(numFusedNodes(operationNames[1]) > 0);
+    BOOST_TEST(operationNames[1].size() < operationNames[0].size());
+
+    BOOST_TEST(outputs[1].size() == sequenceLengths.size());
+    for (size_t i = 0; i < sequenceLengths.size(); i++)
+    {
+        FloatingPointVectorCompare(outputs[1][i], outputs[0][i], "Fused elementwise operations: forward prop results do not match");
+        FloatingPointVectorCompare(inputGradients[1][i], inputGradients[0][i], "Fused elementwise operations: input gradients do not match");
+    }
+    FloatingPointVectorCompare(gradientsOfB[1], gradientsOfB[0], "Fused elementwise operations: gradients of b do not match");
+    FloatingPointVectorCompare(gradientsOfC[1], gradientsOfC[0], "Fused elementwise operations: gradients of c do not match");
+}
+
 BOOST_AUTO_TEST_SUITE(FunctionSuite)
 
 BOOST_AUTO_TEST_CASE(FindNameInCPU)
@@ -1334,6 +1405,15 @@ BOOST_AUTO_TEST_CASE(MatMul)
         TestMatMul(DeviceDescriptor::GPUDevice(0));
 }
 
+BOOST_AUTO_TEST_CASE(FusedElementwiseOperationsInCPU)
+{
+    if (ShouldRunOnCpu())
+    {
+        TestFusedElementwiseOperations<float>(DeviceDescriptor::CPUDevice());
+        TestFusedElementwiseOperations<double>(DeviceDescriptor::CPUDevice());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
@@ -350,6 +350,277 @@ void TestSweepBasedSchedule()
     }
 }
 
+template <typename ElementType>
+vector<ElementType> ParameterValues(const Parameter& parameter)
+{
+    auto value = parameter.Value()->DeepClone(DeviceDescriptor::CPUDevice());
+    return vector<ElementType>(value->DataBuffer<ElementType>(), value->DataBuffer<ElementType>() + value->Shape().TotalSize());
+}
+
+// Trains W in W * x against labels with the squared error, for the loss scaling tests.
+struct LossScalingTestModel
+{
+    Variable input, labels;
+    Parameter weights;
+    LearnerPtr learner;
+    TrainerPtr trainer;
+
+    LossScalingTestModel(const function<LearnerPtr(const vector<Parameter>&)>& createLearner, const DeviceDescriptor& device)
+        : input(InputVariable({ 3 }, DataType::Float, L"features")),
+          labels(InputVariable({ 2 }, DataType::Float, L"labels")),
+          weights(NDArrayView::RandomUniform<float>({ 2, 3 }, -1.0, 1.0, 1, device), L"W")
+    {
+        auto output = Times(weights, input);
+        auto trainingLoss = SquaredError(output, labels, L"lossFunction");
+        learner = createLearner({ weights });
+        trainer = CreateTrainer(output, trainingLoss, trainingLoss, { learner });
+    }
+
+    // trains on 4 samples with the given label value added to the labels
+    void TrainMinibatch(float labelOffset, const DeviceDescriptor& device)
+    {
+        vector<float> inputData(3 * 4), labelData(2 * 4);
+        for (size_t k = 0; k < inputData.size(); k++)
+            inputData[k] = (float)((k * 7) % 11) / 11 - 0.5f;
+        for (size_t k = 0; k < labelData.size(); k++)
+            labelData[k] = (float)((k * 5) % 3) - 1 + labelOffset;
+        trainer->TrainMinibatch({ { input, Value::CreateBatch(input.Shape(), inputData, device) }, { labels, Value::CreateBatch(labels.Shape(), labelData, device) } }, device);
+    }
+
+    vector<float> Weights() const
+    {
+        auto value = weights.Value()->DeepClone(DeviceDescriptor::CPUDevice());
+        return vector<float>(value->DataBuffer<float>(), value->DataBuffer<float>() + value->Shape().TotalSize());
+    }
+};
+
+void CheckWeightsClose(const vector<float>& actual, const vector<float>& expected, float tolerance)
+{
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); i++)
+        BOOST_CHECK_SMALL(actual[i] - expected[i], tolerance);
+}
+
+vector<function<LearnerPtr(const vector<Parameter>&)>> LossScalingTestLearners()
+{
+    return {
+        [](const vector<Parameter>& parameters) { return SGDLearner(parameters, TrainingParameterPerSampleSchedule(0.05)); },
+        [](const vector<Parameter>& parameters) { return MomentumSGDLearner(parameters, TrainingParameterPerSampleSchedule(0.05), MomentumAsTimeConstantSchedule(10)); },
+        [](const vector<Parameter>& parameters) { return AdamLearner(parameters, TrainingParameterPerSampleSchedule(0.05), MomentumAsTimeConstantSchedule(10)); },
+        // the universal learner does not support loss scaling, so the Trainer undoes it
+        [](const vector<Parameter>& parameters)
+        {
+            return UniversalLearner(parameters, [](Parameter p, Variable g) { return Assign(p, Minus(p, ElementTimes(Constant::Scalar(0.05f), g))); });
+        },
+    };
+}
+
+// With a static loss scale, the gradients are unscaled before the update, so training does not change.
+void TestTrainerLossScaling(const DeviceDescriptor& device)
+{
+    for (const auto& createLearner : LossScalingTestLearners())
+    {
+        LossScalingTestModel reference(createLearner, device);
+        LossScalingTestModel scaled(createLearner, device);
+        scaled.trainer->SetLossScaling(1024, /*dynamic=*/false);
+        BOOST_REQUIRE(reference.Weights() == scaled.Weights());
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            reference.TrainMinibatch(0, device);
+            scaled.TrainMinibatch(0, device);
+            CheckWeightsClose(scaled.Weights(), reference.Weights(), 1e-6f);
+        }
+        BOOST_CHECK_EQUAL(scaled.trainer->LossScale(), 1024);
+    }
+}
+
+// With dynamic loss scaling, a minibatch with overflowing gradients is skipped and the loss scale halved;
+// after growthInterval minibatches without overflow the loss scale doubles again.
+void TestTrainerDynamicLossScaling(const DeviceDescriptor& device)
+{
+    // The overflowing gradients below contain NaNs, which the checked mode that the test fixture turns on would reject
+    SetCheckedMode(false);
+
+    LossScalingTestModel model([](const vector<Parameter>& parameters) { return SGDLearner(parameters, TrainingParameterPerSampleSchedule(0.05)); }, device);
+    BOOST_REQUIRE(model.learner->SupportsLossScaling());
+    model.trainer->SetLossScaling(1e38, /*dynamic=*/true, /*growthInterval=*/2);
+
+    // the squared error gradient is 2 * (output - labels) times the loss scale, which overflows
+    auto weights = model.Weights();
+    model.TrainMinibatch(100, device);
+    BOOST_CHECK(model.Weights() == weights);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 5e37);
+    BOOST_CHECK_EQUAL(model.trainer->TotalNumberOfSamplesSeen(), 4);
+
+    model.trainer->SetLossScaling(4, /*dynamic=*/true, /*growthInterval=*/2);
+    model.TrainMinibatch(0, device);
+    BOOST_CHECK(model.Weights() != weights);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 4);
+    model.TrainMinibatch(0, device);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 8);
+
+    // overflowing gradients are detected again after a change of the loss scale
+    weights = model.Weights();
+    model.trainer->SetLossScaling(1e38, /*dynamic=*/true, /*growthInterval=*/2);
+    model.TrainMinibatch(100, device);
+    BOOST_CHECK(model.Weights() == weights);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 5e37);
+
+    // the loss scale, its settings and the minibatches since its last change are restored from a checkpoint
+    model.trainer->SetLossScaling(4, /*dynamic=*/true, /*growthInterval=*/3);
+    model.TrainMinibatch(0, device);
+    model.TrainMinibatch(0, device);
+    const std::wstring checkpoint = L"lossScaling.checkpoint";
+    model.trainer->SaveCheckpoint(checkpoint);
+    model.trainer->SetLossScaling(1, /*dynamic=*/false);
+    model.trainer->RestoreFromCheckpoint(checkpoint);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 4);
+    model.TrainMinibatch(0, device);
+    BOOST_CHECK_EQUAL(model.trainer->LossScale(), 8); // the third minibatch since the change, as before the checkpoint
+
+    // a learner that cannot skip an update does not allow dynamic loss scaling
+    LossScalingTestModel universal(LossScalingTestLearners().back(), device);
+    BOOST_REQUIRE(!universal.learner->SupportsLossScaling());
+    BOOST_CHECK_THROW(universal.trainer->SetLossScaling(1024, /*dynamic=*/true), std::invalid_argument);
+    universal.trainer->SetLossScaling(1024, /*dynamic=*/false);
+
+    SetCheckedMode(true);
+}
+
+// With dynamic loss scaling and several learners, a minibatch whose gradients overflowed for one of them is skipped by all.
+void TestTrainerDynamicLossScalingWithTwoLearners(const DeviceDescriptor& device)
+{
+    // output = W1 * x + W2 * y with W1 = 0, so that the gradient of the output is about 2 times the loss scale,
+    // which overflows in the gradient of W1 for large x but not in that of W2 for small y
+    auto x = InputVariable({ 3 }, DataType::Float, L"x");
+    auto y = InputVariable({ 3 }, DataType::Float, L"y");
+    auto labels = InputVariable({ 2 }, DataType::Float, L"labels");
+    Parameter w1({ 2, 3 }, DataType::Float, 0.0, device, L"W1");
+    Parameter w2(NDArrayView::RandomUniform<float>({ 2, 3 }, -0.1, 0.1, 2, device), L"W2");
+    auto output = Plus(Times(w1, x), Times(w2, y));
+    auto trainingLoss = SquaredError(output, labels, L"lossFunction");
+    auto learningRate = TrainingParameterPerSampleSchedule(0.05);
+    auto trainer = CreateTrainer(output, trainingLoss, trainingLoss, { SGDLearner({ w1 }, learningRate), SGDLearner({ w2 }, learningRate) });
+
+    auto trainMinibatch = [&](float xValue)
+    {
+        vector<float> xData(3 * 4, xValue), yData(3 * 4, 0.5f), labelData(2 * 4, 1.0f);
+        trainer->TrainMinibatch({ { x, Value::CreateBatch(x.Shape(), xData, device) },
+                                  { y, Value::CreateBatch(y.Shape(), yData, device) },
+                                  { labels, Value::CreateBatch(labels.Shape(), labelData, device) } }, device);
+    };
+    auto w1Values = ParameterValues<float>(w1);
+    auto w2Values = ParameterValues<float>(w2);
+
+    trainer->SetLossScaling(1e36, /*dynamic=*/true, /*growthInterval=*/2);
+    trainMinibatch(1e3f);
+    BOOST_CHECK(ParameterValues<float>(w1) == w1Values);
+    BOOST_CHECK(ParameterValues<float>(w2) == w2Values);
+    BOOST_CHECK_EQUAL(trainer->LossScale(), 5e35);
+
+    // without overflow both learners apply the minibatch
+    trainer->SetLossScaling(4, /*dynamic=*/true, /*growthInterval=*/2);
+    trainMinibatch(1.0f);
+    BOOST_CHECK(ParameterValues<float>(w1) != w1Values);
+    BOOST_CHECK(ParameterValues<float>(w2) != w2Values);
+}
+
+// The learners with a fused update, for the fused update tests.
+vector<function<LearnerPtr(const vector<Parameter>&, const AdditionalLearningOptions&)>> FusedUpdateTestLearners()
+{
+    auto learningRate = TrainingParameterPerSampleSchedule(0.05);
+    return {
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return SGDLearner(parameters, learningRate, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return MomentumSGDLearner(parameters, learningRate, MomentumAsTimeConstantSchedule(10), true, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return MomentumSGDLearner(parameters, learningRate, MomentumAsTimeConstantSchedule(10), false, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return NesterovLearner(parameters, learningRate, MomentumAsTimeConstantSchedule(10), true, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return AdaGradLearner(parameters, learningRate, true, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return AdaGradLearner(parameters, learningRate, false, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return RMSPropLearner(parameters, learningRate, 0.95, 1.2, 0.7, 10.0, 0.001, true, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options) { return RMSPropLearner(parameters, learningRate, 0.95, 1.2, 0.7, 10.0, 0.001, false, options); },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options)
+        {
+            return AdamLearner(parameters, learningRate, MomentumAsTimeConstantSchedule(10), true, MomentumSchedule(0.99, 1), 1e-8, false, options);
+        },
+        [=](const vector<Parameter>& parameters, const AdditionalLearningOptions& options)
+        {
+            return AdamLearner(parameters, learningRate, MomentumAsTimeConstantSchedule(10), true, MomentumSchedule(0.99, 1), 1e-8, true, options);
+        },
+    };
+}
+
+// The fused update of all parameters of a learner gives the same parameters as the update of one parameter after the other,
+// with the gradient scale of both modes, loss scaling, clipping, L1 and L2 regularization. Several minibatches are run, so that
+// the Adam bias correction and the RMSProp initialization change between the updates.
+template <typename ElementType>
+void TestFusedUpdate(const DeviceDescriptor& device)
+{
+    // parameters of different sizes, so that their parts of the fused state need padding
+    const vector<NDShape> shapes = { { 3, 5 }, { 7 }, { 2, 2, 3 } };
+    auto createParameters = [&]()
+    {
+        vector<Parameter> parameters;
+        for (size_t i = 0; i < shapes.size(); i++)
+            parameters.push_back(Parameter(NDArrayView::RandomUniform<ElementType>(shapes[i], -1.0, 1.0, (unsigned long)i, device), L"parameter_" + to_wstring(i)));
+        return parameters;
+    };
+    const double lossScale = 8;
+    auto createGradients = [&](const vector<Parameter>& parameters, size_t minibatch)
+    {
+        unordered_map<Parameter, NDArrayViewPtr> gradientValues;
+        for (size_t i = 0; i < parameters.size(); i++)
+            gradientValues[parameters[i]] = NDArrayView::RandomUniform<ElementType>(shapes[i], -lossScale, lossScale, (unsigned long)(100 * minibatch + i), device);
+        return gradientValues;
+    };
+
+    AdditionalLearningOptions truncation;
+    truncation.l1RegularizationWeight = 0.001;
+    truncation.l2RegularizationWeight = 0.01;
+    truncation.gradientClippingThresholdPerSample = 0.3;
+    AdditionalLearningOptions norm = truncation;
+    norm.gradientClippingWithTruncation = false;
+
+    const ElementType tolerance = is_same<ElementType, float>::value ? (ElementType)1e-5 : (ElementType)1e-10;
+    for (const auto& createLearner : FusedUpdateTestLearners())
+    {
+        for (auto options : { truncation, norm })
+        {
+            for (bool compatibleMode : { false, true })
+            {
+                auto parameters = createParameters();
+                auto fusedParameters = createParameters();
+                options.fusedUpdate = false;
+                auto learner = createLearner(parameters, options);
+                options.fusedUpdate = true;
+                auto fusedLearner = createLearner(fusedParameters, options);
+                for (const auto& l : { learner, fusedLearner })
+                {
+                    if (compatibleMode)
+                        l->SetMinibatchSize(Learner::IgnoredMinibatchSize);
+                    l->SetLossScale(lossScale);
+                }
+
+                for (size_t minibatch = 0; minibatch < 4; minibatch++)
+                {
+                    auto gradientValues = createGradients(parameters, minibatch);
+                    auto fusedGradientValues = createGradients(fusedParameters, minibatch);
+                    learner->Update(gradientValues, 4, false);
+                    fusedLearner->Update(fusedGradientValues, 4, false);
+                    for (size_t i = 0; i < parameters.size(); i++)
+                    {
+                        auto expected = ParameterValues<ElementType>(parameters[i]);
+                        auto actual = ParameterValues<ElementType>(fusedParameters[i]);
+                        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+                        for (size_t k = 0; k < actual.size(); k++)
+                            BOOST_CHECK_SMALL(actual[k] - expected[k], tolerance * (1 + fabs(expected[k])));
+                    }
+                }
+            }
+        }
+    }
+}
+
 struct LearnerSuiteFixture
 {
     LearnerSuiteFixture()
@@ -500,6 +771,40 @@ BOOST_AUTO_TEST_CASE(TestResettingLearningRate)
     }
 }
 
+BOOST_AUTO_TEST_CASE(TrainerLossScaling)
+{
+    for (auto& device : devices)
+    {
+        TestTrainerLossScaling(device);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TrainerDynamicLossScaling)
+{
+    for (auto& device : devices)
+    {
+        TestTrainerDynamicLossScaling(device);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TrainerDynamicLossScalingWithTwoLearners)
+{
+    for (auto& device : devices)
+    {
+        TestTrainerDynamicLossScalingWithTwoLearners(device);
+    }
+}
+
+// The fused update is only done on the CPU.
+BOOST_AUTO_TEST_CASE(FusedUpdate)
+{
+    if (ShouldRunOnCpu())
+    {
+        TestFusedUpdate<float>(DeviceDescriptor::CPUDevice());
+        TestFusedUpdate<double>(DeviceDescriptor::CPUDevice());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
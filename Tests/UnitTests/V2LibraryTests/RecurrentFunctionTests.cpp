@@ -377,6 +377,75 @@ void TestSimpleRecurrence(size_t inputDim,
     }
 }
 
+// Runs a recurrence whose matrix product takes a Splice of the input and of the recurrent state, once node by node and
+// once with the loop optimizations (product with the input hoisted out of the loop, Tanh fused with Plus), and compares.
+template <typename ElementType>
+void TestRecurrentLoopOptimization(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 5;
+    const size_t hiddenDim = 7;
+
+    auto input = InputVariable({ inputDim }, AsDataType<ElementType>(), /*needsGradient =*/ true, L"features");
+    auto W = Parameter(NDArrayView::RandomUniform<ElementType>({ hiddenDim, inputDim + hiddenDim }, -0.5, 0.5, seed++, device), L"W");
+    auto b = Parameter(NDArrayView::RandomUniform<ElementType>({ hiddenDim }, -0.5, 0.5, seed++, device), L"b");
+
+    auto placeholder = PlaceholderVariable(NDShape({ hiddenDim }));
+    auto hidden = Tanh(Plus(b, Times(W, Splice({ input, PastValue(placeholder, Constant::Scalar(AsDataType<ElementType>(), 0.0))->Output() }, Axis(0)))), L"hidden");
+    hidden = hidden->ReplacePlaceholders({ { placeholder, hidden } });
+
+    auto sequenceLengths = GenerateSequenceLengths(4, 9);
+    auto inputValue = GenerateSequences<ElementType>(sequenceLengths, { inputDim }, device, false);
+    std::vector<std::vector<ElementType>> rootGradients;
+    for (auto length : sequenceLengths)
+        rootGradients.push_back(std::vector<ElementType>(length * hiddenDim, (ElementType)1));
+    auto rootGradientValue = Value::Create({ hiddenDim }, rootGradients, device, true);
+
+    auto copyToVector = [](const NDArrayViewPtr& view)
+    {
+        auto cpuView = MakeSharedObject<NDArrayView>(AsDataType<ElementType>(), view->Shape(), DeviceDescriptor::CPUDevice());
+        cpuView->CopyFrom(*view);
+        auto buffer = cpuView->template DataBuffer<ElementType>();
+        return std::vector<ElementType>(buffer, buffer + view->Shape().TotalSize());
+    };
+
+    std::vector<std::vector<ElementType>> outputs[2];
+    std::vector<std::vector<ElementType>> inputGradients[2];
+    std::vector<ElementType> gradientsOfW[2], gradientsOfB[2];
+
+    // Temporarily enable the unpacking of packed value objects for result verification
+    auto automaticUnpackingOfPackedValuesDisabled = Internal::IsAutomaticUnpackingOfPackedValuesDisabled();
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ false);
+    for (size_t optimize = 0; optimize < 2; optimize++)
+    {
+        // the setting applies to networks created afterwards, hence the clone
+        Internal::OptimizeRecurrentLoops(optimize != 0);
+        auto model = hidden->Clone(ParameterCloningMethod::Share);
+        auto modelInput = model->Arguments()[0];
+
+        std::unordered_map<Variable, ValuePtr> forwardOutputs = { { model->Output(), nullptr } };
+        auto backpropState = model->Forward({ { modelInput, inputValue } }, forwardOutputs, device, { model->Output() });
+        forwardOutputs[model->Output()]->CopyVariableValueTo(model->Output(), outputs[optimize]);
+
+        std::unordered_map<Variable, ValuePtr> gradients = { { modelInput, nullptr }, { W, nullptr }, { b, nullptr } };
+        model->Backward(backpropState, { { model->Output(), rootGradientValue } }, gradients);
+        gradients[modelInput]->CopyVariableValueTo(modelInput, inputGradients[optimize]);
+        gradientsOfW[optimize] = copyToVector(gradients[W]->Data());
+        gradientsOfB[optimize] = copyToVector(gradients[b]->Data());
+    }
+    Internal::OptimizeRecurrentLoops(false);
+    Internal::SetAutomaticUnpackingOfPackedValues(/*disable =*/ automaticUnpackingOfPackedValuesDisabled);
+
+    BOOST_TEST(outputs[0].size() == sequenceLengths.size());
+    BOOST_TEST(outputs[1].size() == sequenceLengths.size());
+    for (size_t i = 0; i < sequenceLengths.size(); i++)
+    {
+        FloatingPointVectorCompare(outputs[1][i], outputs[0][i], "Optimized recurrent loop: forward prop results do not match");
+        FloatingPointVectorCompare(inputGradients[1][i], inputGradients[0][i], "Optimized recurrent loop: input gradients do not match");
+    }
+    FloatingPointVectorCompare(gradientsOfW[1], gradientsOfW[0], "Optimized recurrent loop: gradients of W do not match");
+    FloatingPointVectorCompare(gradientsOfB[1], gradientsOfB[0], "Optimized recurrent loop: gradients of b do not match");
+}
+
 BOOST_AUTO_TEST_SUITE(RecurrentFunctionSuite)
 
 BOOST_AUTO_TEST_CASE(SimpleRecurrenceInCPU)
@@ -408,6 +477,21 @@ BOOST_AUTO_TEST_CASE(SimpleLargeRecurrenceInGPU)
     }
 }
 
+BOOST_AUTO_TEST_CASE(RecurrentLoopOptimizationInCPU)
+{
+    if (ShouldRunOnCpu())
+    {
+        TestRecurrentLoopOptimization<float>(DeviceDescriptor::CPUDevice());
+        TestRecurrentLoopOptimization<double>(DeviceDescriptor::CPUDevice());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RecurrentLoopOptimizationInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestRecurrentLoopOptimization<float>(DeviceDescriptor::GPUDevice(0));
+}
+
 BOOST_AUTO_TEST_CASE(RecurrentNetworkCreationInCPU)
 {
     if (ShouldRunOnCpu())
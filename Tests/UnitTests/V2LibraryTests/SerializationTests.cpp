@@ -357,7 +357,8 @@ void CheckEnumValuesNotModified() {
                   static_cast<size_t>(PrimitiveOpType::StraightThrough) == 94 &&
                   static_cast<size_t>(PrimitiveOpType::Tan) == 95 &&
                   static_cast<size_t>(PrimitiveOpType::Atan) == 96 &&
-                  static_cast<size_t>(PrimitiveOpType::ConvolutionSequenceShape) == 97,
+                  static_cast<size_t>(PrimitiveOpType::ConvolutionSequenceShape) == 97 &&
+                  static_cast<size_t>(PrimitiveOpType::SampledCrossEntropyWithSoftmax) == 98,
                   "PrimitiveOpType enum value was modified.");
 }
 
@@ -855,6 +856,48 @@ void TestCheckpointingWithStatefulNodes(const DeviceDescriptor& device)
     }
 }
 
+void TestAsyncCheckpointing(const DeviceDescriptor& device)
+{
+    auto featureStreamName = L"features";
+    auto labelsStreamName = L"labels";
+
+    size_t inputDim = 784;
+    size_t numOutputClasses = 10;
+    auto features = InputVariable({ inputDim }, false /*isSparse*/, DataType::Float, featureStreamName);
+    auto labels = InputVariable({ numOutputClasses }, DataType::Float, labelsStreamName);
+    auto net = BuildFFClassifierNet(features, numOutputClasses, device, 1);
+
+    auto trainer = BuildTrainer(net, labels);
+
+    const size_t minibatchSize = 50;
+    const size_t epochSize = 150;
+    auto minibatchSource = TextFormatMinibatchSource(L"Train-28x28_cntk_text.txt", { { featureStreamName, inputDim }, { labelsStreamName, numOutputClasses } },  epochSize, false);
+    auto minibatchData = minibatchSource->GetNextMinibatch(minibatchSize, device);
+    auto featureStreamInfo = minibatchSource->StreamInfo(features);
+    auto labelStreamInfo = minibatchSource->StreamInfo(labels);
+
+    // Training right after SaveCheckpointAsync() must not change what is written.
+    vector<double> expectedLoss;
+    for (int i = 0; i < 4; i++)
+    {
+        trainer->SaveCheckpointAsync(L"async.checkpoint" + std::to_wstring(i));
+        trainer->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+        expectedLoss.push_back(trainer->PreviousMinibatchLossAverage());
+    }
+    trainer->WaitForPendingCheckpoint();
+
+    for (int i = 0; i < 4; i++)
+    {
+        auto fileName = L"async.checkpoint" + std::to_wstring(i);
+        if (_wunlink((fileName + L".tmp").c_str()) == 0 || _wunlink((fileName + L".ckp.tmp").c_str()) == 0)
+            ReportFailure("Temporary files of asynchronous checkpoint %d were not renamed.", i);
+
+        trainer->RestoreFromCheckpoint(fileName);
+        trainer->TrainMinibatch({ { features, minibatchData[featureStreamInfo] }, { labels, minibatchData[labelStreamInfo] } }, device);
+        double loss = trainer->PreviousMinibatchLossAverage();
+        FloatingPointCompare(loss, expectedLoss[i], "Post asynchronous checkpoint restoration training loss does not match expectation");
+    }
+}
 
 void TestCheckpointingWithStatefulNodesAndExplicitSeeds(const DeviceDescriptor& device)
 {
@@ -962,6 +1005,125 @@ void TestLoadingModelFromMemoryBufferWithException()
     delete[] modelBuffer;
 }
 
+void TestMappedModelSaveAndLoad(const DeviceDescriptor& device)
+{
+    const size_t inputDim = 20;
+    auto inputVar = InputVariable({ inputDim }, true /*isSparse*/, DataType::Float, L"input_variable");
+
+    size_t modelIndex = 0;
+    for (auto& function : { BuildFFClassifierNet(inputVar, 5, device), BuildLSTMClassifierNet(inputVar, 5, device) })
+    {
+        // Mapped files cannot be replaced on Windows while values loaded from them are alive, so every file is written once.
+        auto mappedFile = L"TestMappedModelSaveAndLoad." + std::to_wstring(modelIndex) + L".mapped.out";
+        auto convertedFile = L"TestMappedModelSaveAndLoad." + std::to_wstring(modelIndex) + L".converted.out";
+        auto reconvertedFile = L"TestMappedModelSaveAndLoad." + std::to_wstring(modelIndex) + L".reconverted.out";
+        modelIndex++;
+
+        function->Save(mappedFile, ModelFormat::CNTKv2Mapped);
+
+        auto reloadedFunction = Function::Load(mappedFile, device);
+        if (!AreEqual(function, reloadedFunction))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: original and reloaded functions are not identical.");
+
+        auto reloadedAgain = Function::Load(mappedFile, device, ModelFormat::CNTKv2Mapped);
+        if (!AreEqual(function, reloadedAgain))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: original and reloaded functions are not identical.");
+
+        // Updating the values of one load must neither change those of another nor the file.
+        auto parameter = reloadedFunction->Parameters()[0];
+        parameter.SetValue(MakeSharedObject<NDArrayView>(0.0f, parameter.Shape(), device));
+        if (!AreEqual(function, reloadedAgain) || !AreEqual(function, Function::Load(mappedFile, device)))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: updating the values of a mapped model changed another load of it.");
+
+        Internal::ConvertModel(mappedFile, convertedFile, ModelFormat::CNTKv2);
+        if (!AreEqual(function, Function::Load(convertedFile, device, ModelFormat::CNTKv2)))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: model converted to the CNTKv2 format is not identical.");
+
+        VerifyException([&convertedFile, &device]() {
+            Function::Load(convertedFile, device, ModelFormat::CNTKv2Mapped);
+        }, "Was able to load a CNTKv2 model as a CNTKv2Mapped model.");
+
+        Internal::ConvertModel(convertedFile, reconvertedFile, ModelFormat::CNTKv2Mapped);
+        if (!AreEqual(function, Function::Load(reconvertedFile, device)))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: model converted back to the CNTKv2Mapped format is not identical.");
+
+        auto modelFileStream = GetFstream(reconvertedFile, true);
+        vector<char> modelBuffer((istreambuf_iterator<char>(*modelFileStream)), istreambuf_iterator<char>());
+        if (!AreEqual(function, Function::Load(modelBuffer.data(), modelBuffer.size(), device)))
+            BOOST_ERROR("TestMappedModelSaveAndLoad: model loaded from a memory buffer is not identical.");
+    }
+}
+
+// Returns the number of memory mappings of the file in this process, or -1 if they cannot be listed.
+int CountMappings(const std::wstring& filePath)
+{
+#ifdef _WIN32
+    (void)filePath;
+    return -1;
+#else
+    const std::string fileName = "/" + std::string(filePath.begin(), filePath.end());
+    ifstream maps("/proc/self/maps");
+    int count = 0;
+    for (std::string line; getline(maps, line);)
+    {
+        if (line.find(fileName) != std::string::npos)
+            count++;
+    }
+    return count;
+#endif
+}
+
+void TestMappedModelLoadDropAndReload()
+{
+    const auto device = DeviceDescriptor::CPUDevice();
+    const size_t inputDim = 20;
+    auto inputVar = InputVariable({ inputDim }, true /*isSparse*/, DataType::Float, L"input_variable");
+    auto function = BuildFFClassifierNet(inputVar, 5, device);
+    const std::wstring mappedFile = L"TestMappedModelLoadDropAndReload.mapped.out";
+    function->Save(mappedFile, ModelFormat::CNTKv2Mapped);
+
+    auto originalValue = [&function](const Parameter& parameter)
+    {
+        for (const auto& originalParameter : function->Parameters())
+        {
+            if (originalParameter.Uid() == parameter.Uid())
+                return originalParameter.Value();
+        }
+        BOOST_FAIL("TestMappedModelLoadDropAndReload: reloaded parameter not in the original function.");
+        return NDArrayViewPtr();
+    };
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        NDArrayViewPtr value, expectedValue;
+        {
+            auto reloadedFunction = Function::Load(mappedFile, device);
+            if (!AreEqual(function, reloadedFunction))
+                BOOST_ERROR("TestMappedModelLoadDropAndReload: original and reloaded functions are not identical.");
+
+            // an alias is another NDArrayView over the same storage
+            auto parameter = reloadedFunction->Parameters()[0];
+            value = parameter.Value()->Alias();
+            expectedValue = originalValue(parameter);
+        }
+
+        // The mapping is kept for as long as its storage is in use, and released with the last use of it.
+        if (!AreEqual(value, expectedValue))
+            BOOST_ERROR("TestMappedModelLoadDropAndReload: the value of a dropped load is not kept.");
+        if (CountMappings(mappedFile) != -1)
+            BOOST_CHECK_EQUAL(CountMappings(mappedFile), 1);
+        value = nullptr;
+        if (CountMappings(mappedFile) != -1)
+            BOOST_CHECK_EQUAL(CountMappings(mappedFile), 0);
+    }
+
+    // Without any mapping left, the file can be replaced, also on Windows.
+    auto otherFunction = BuildLSTMClassifierNet(inputVar, 5, device);
+    otherFunction->Save(mappedFile, ModelFormat::CNTKv2Mapped);
+    if (!AreEqual(otherFunction, Function::Load(mappedFile, device)))
+        BOOST_ERROR("TestMappedModelLoadDropAndReload: the replaced model does not reload.");
+}
+
 BOOST_AUTO_TEST_SUITE(SerializationSuite)
 
 BOOST_AUTO_TEST_CASE(LoadingModelFromMemoryBuffer)
@@ -1044,6 +1206,11 @@ BOOST_AUTO_TEST_CASE(CheckpointingWithStatefulNodesInCPU)
     TestCheckpointingWithStatefulNodes(DeviceDescriptor::CPUDevice());
 }
 
+BOOST_AUTO_TEST_CASE(AsyncCheckpointingInCPU)
+{
+    TestAsyncCheckpointing(DeviceDescriptor::CPUDevice());
+}
+
 BOOST_AUTO_TEST_CASE(LearnerSerializationInGPU)
 {
     if (ShouldRunOnGpu())
@@ -1116,6 +1283,22 @@ BOOST_AUTO_TEST_CASE(CheckpointingWithStatefulNodesAndExplicitSeedsOnGPU)
         TestCheckpointingWithStatefulNodesAndExplicitSeeds(DeviceDescriptor::GPUDevice(0));
 }
 
+BOOST_AUTO_TEST_CASE(MappedModelSaveAndLoadInCPU)
+{
+    TestMappedModelSaveAndLoad(DeviceDescriptor::CPUDevice());
+}
+
+BOOST_AUTO_TEST_CASE(MappedModelSaveAndLoadInGPU)
+{
+    if (ShouldRunOnGpu())
+        TestMappedModelSaveAndLoad(DeviceDescriptor::GPUDevice(0));
+}
+
+BOOST_AUTO_TEST_CASE(MappedModelLoadDropAndReload)
+{
+    TestMappedModelLoadDropAndReload();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }}
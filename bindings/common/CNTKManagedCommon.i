@@ -244,6 +244,7 @@ IGNORE_CLASS CNTK::DistributedCommunicator;
 IGNORE_CLASS CNTK::QuantizedDistributedCommunicator;
 IGNORE_FUNCTION CNTK::MPICommunicator;
 IGNORE_FUNCTION CNTK::QuantizedMPICommunicator;
+IGNORE_FUNCTION CNTK::HierarchicalMPICommunicator;
 IGNORE_STRUCT CNTK::CrossValidationConfig;
 IGNORE_STRUCT CNTK::CheckpointConfig;
 IGNORE_STRUCT CNTK::TestConfig;
@@ -294,6 +295,8 @@ IGNORE_FUNCTION CNTK::Internal::EnableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::DisableForwardValuesSharing;
 IGNORE_FUNCTION CNTK::Internal::EnableGradientAccumulationOptimization;
 IGNORE_FUNCTION CNTK::Internal::DisableGradientAccumulationOptimization;
+IGNORE_FUNCTION CNTK::Internal::EnableConvolutionAutotuning;
+IGNORE_FUNCTION CNTK::Internal::DisableConvolutionAutotuning;
 %ignore CNTK::Internal::DefaultProfilerBufferSize;
 IGNORE_FUNCTION CNTK::Internal::StartProfiler;
 IGNORE_FUNCTION CNTK::Internal::StopProfiler;
@@ -307,6 +310,7 @@ IGNORE_FUNCTION CNTK::Internal::PrintBuiltInfo;
 IGNORE_FUNCTION CNTK::Internal::PrintGpuInfo;
 IGNORE_FUNCTION CNTK::Internal::SetMPIPackThreshold;
 IGNORE_FUNCTION CNTK::Internal::GetMPIPackThreshold;
+IGNORE_FUNCTION CNTK::Internal::ConvertModel;
 IGNORE_FUNCTION CNTK::Internal::ToDictionary;
 IGNORE_CLASS CNTK::Internal::TensorBoardFileWriter;
 // suppress SWIG warning 302: Identifier redefined.
@@ -480,6 +484,7 @@ IGNORE_FUNCTION CNTK::WeightedBinaryCrossEntropy;
 IGNORE_FUNCTION CNTK::SquaredError;
 IGNORE_FUNCTION CNTK::CrossEntropyWithSoftmax;
 IGNORE_FUNCTION CNTK::LatticeSequenceWithSoftmax;
+IGNORE_FUNCTION CNTK::SampledCrossEntropyWithSoftmax;
 IGNORE_FUNCTION CNTK::EditDistanceError;
 IGNORE_FUNCTION CNTK::ForwardBackward;
 IGNORE_FUNCTION CNTK::LabelsToGraph;
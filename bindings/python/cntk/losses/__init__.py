@@ -351,6 +351,46 @@ def nce_loss(weights, biases, inputs, labels, noise_distribution, num_samples=32
     return nce_loss(weights, biases, inputs, labels, noise_distribution,
                     num_samples, allow_duplicates, seed, name)
 
+@typemap
+def sampled_cross_entropy_with_softmax(weights, inputs, labels, sampling_weights, num_samples=32, seed=auto_select, name=''):
+    '''sampled_cross_entropy_with_softmax(weights, inputs, labels, sampling_weights, num_samples=32, seed=auto_select, name='')
+    Computes the sampled softmax cross entropy loss. For each minibatch, this
+    operation draws `num_samples` random labels, with replacement, in
+    proportion to `sampling_weights`, and computes the softmax cross entropy
+    over the true label and these random labels only. The logits are
+    corrected by the log of the expected number of draws of each label, so
+    that the loss approximates the full softmax cross entropy. The random
+    labels are shared among all the examples in the minibatch, and drawing
+    each of them takes constant time. The result is the sum of the loss over
+    the minibatch. The gradient of the weights will be sparse if the labels
+    are sparse.
+
+    Use the full softmax, e.g. ``C.times_transpose(x, W)``, for predictions.
+
+    Args:
+        weights: parameter (or variable in general) containing the weights with
+         which inputs will be multiplied. Its shape must be
+         (number of classes, dimension of input)
+        inputs: vector of inputs to this layer. Multiplying by the weights gives
+         the logits.
+        labels: a one-hot vector with the ground-truth labels.
+        sampling_weights: a vector with dimension equal to the number of
+         classes. The entries must be non-negative numbers but do not have to
+         sum to 1. They are read again whenever they change.
+        num_samples: number of random labels drawn for each minibatch.
+        seed: random seed. The default value selects a unique random seed.
+        name (str, optional): the name of the Function instance in the network
+    Returns:
+        :class:`~cntk.ops.functions.Function`
+    '''
+    from cntk.cntk_py import sampled_cross_entropy_with_softmax
+    dtype = get_data_type(inputs, labels, sampling_weights)
+    inputs = sanitize_input(inputs, dtype)
+    labels = sanitize_input(labels, dtype)
+    sampling_weights = sanitize_input(sampling_weights, dtype)
+    return sampled_cross_entropy_with_softmax(weights, inputs, labels, sampling_weights,
+                                              num_samples, seed, name)
+
 @typemap
 def lattice_sequence_with_softmax(label, prediction, loglikelihood, lattice, symListPath, phonePath, stateListPath, transProbPath, latticeConfigPath="LatticeNode.config", 
                                   hSmoothingWeight = 0.95, frameDropThresh = 1e-10, doReferenceAlign = False, seqGammarUsesMBR = False, 
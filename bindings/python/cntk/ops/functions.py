@@ -44,6 +44,13 @@ class ModelFormat(Enum):
     subset of CNTK functionalities.
     '''
 
+    CNTKv2Mapped = cntk_py.ModelFormat_CNTKv2Mapped
+    '''
+    CNTK version 2 format with the parameter values stored as aligned raw blobs. When loading on
+    the CPU, the file is memory mapped and the values are used in place, so that loading is nearly
+    instant and processes loading the same file share its memory. Loading with CNTKv2 recognizes it, too.
+    '''
+
 @unique
 class CloneMethod(Enum):
     '''
@@ -1627,8 +1634,8 @@ class Function(cntk_py.Function):
                 pass
 
         if is_buffer:
-            if format != ModelFormat.CNTKv2:
-                raise ValueError('Loading from buffer only supported for CNTKv2 format.')
+            if format not in (ModelFormat.CNTKv2, ModelFormat.CNTKv2Mapped):
+                raise ValueError('Loading from buffer only supported for CNTKv2 and CNTKv2Mapped formats.')
             return cntk_py.Function.load_from_buffer(model, device)
 
         if is_file:
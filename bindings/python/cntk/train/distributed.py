@@ -202,3 +202,18 @@ def mpi_communicator():
     Creates a non quantized MPI communicator.
     '''
     return cntk_py.mpicommunicator()
+
+@typemap
+def hierarchical_mpi_communicator(ranks_per_node=0):
+    '''
+    Creates a non quantized MPI communicator that aggregates values on the CPU
+    through shared memory among the workers of each node, and in a ring among
+    one worker per node.
+
+    Args:
+        ranks_per_node (int): if not 0, the nodes are blocks of this many
+         consecutive ranks instead of the hosts of the workers, e.g. to
+         simulate several nodes on one host
+    '''
+    return cntk_py.hierarchical_mpicommunicator(
+        cntk_py.get_mpipack_threshold(), ranks_per_node)
@@ -66,9 +66,10 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
           See :class:`DataUnit` for more information on frequency data unit.
         restore (bool): flag, indicating whether to restore from available checkpoint before the start of the training
         preserve_all (bool): saves all checkpoints, using ``filename`` as prefix and checkpoint index as a suffix.
+        asynchronous (bool): writes the periodic checkpoints to disk in the background while the training continues.
     '''
     def __init__(self, filename, frequency=None,
-                 restore=True, preserve_all=False):
+                 restore=True, preserve_all=False, asynchronous=False):
         '''Sets configuration of checkpointing behavior.
 
         Args:
@@ -80,6 +81,7 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
                  :class:`DataUnit`
             restore (bool): flag, indicating whether to restore from available checkpoint before the start of the training
             preserve_all (bool): saves all checkpoints, using ``filename`` as prefix and checkpoint index as a suffix.
+            asynchronous (bool): writes the periodic checkpoints to disk in the background while the training continues.
 
         Returns:
             Reconfigured self.
@@ -96,7 +98,7 @@ class CheckpointConfig(cntk_py.CheckpointConfig):
             frequency = sys.maxsize
 
         super(CheckpointConfig, self).__init__(filename, frequency, frequency_unit,
-                                               restore, preserve_all)
+                                               restore, preserve_all, asynchronous)
 
 class CrossValidationConfig(cntk_py.CrossValidationConfig):
     '''